@@ -0,0 +1,142 @@
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "bmp280_freertos.h"
+
+/* All notifications of the driver task use this bit. The flags in the devices tell which device completed. */
+#define BMP280_FREERTOS_NOTIFY_BIT_IO_DONE 0x01UL
+
+void bmp280_freertos_ctx_init(BMP280FreeRTOSContext *const ctx)
+{
+    ctx->task = xTaskGetCurrentTaskHandle();
+    ctx->devs = NULL;
+    ctx->num_wakeups = 0;
+    ctx->num_notifications = 0;
+}
+
+void bmp280_freertos_dev_init(BMP280FreeRTOSDev *const dev, BMP280FreeRTOSContext *const ctx,
+                              BMP280FreeRTOSStartRead start_read, BMP280FreeRTOSStartWrite start_write,
+                              void *bus_user_data)
+{
+    dev->ctx = ctx;
+    dev->start_read = start_read;
+    dev->start_write = start_write;
+    dev->bus_user_data = bus_user_data;
+    dev->io_cb = NULL;
+    dev->io_cb_user_data = NULL;
+    dev->io_done = false;
+    dev->io_rc = BMP280_IO_RESULT_CODE_ERR;
+    dev->timer_running = false;
+    dev->timer_deadline = 0;
+    dev->timer_cb = NULL;
+    dev->timer_cb_user_data = NULL;
+    dev->next = ctx->devs;
+    ctx->devs = dev;
+}
+
+/**
+ * @brief Check whether a deadline has passed.
+ *
+ * Tick counts wrap around. Deadlines are never more than half of the tick range in the future, so a difference in the
+ * upper half of the range means that the deadline is still ahead.
+ */
+static bool is_deadline_passed(TickType_t now, TickType_t deadline)
+{
+    return (TickType_t)(now - deadline) < (TickType_t)(portMAX_DELAY / 2);
+}
+
+/**
+ * @brief Time to block until the nearest timer deadline, at most @p max_wait_ticks.
+ */
+static TickType_t ticks_until_next_deadline(const BMP280FreeRTOSContext *const ctx, TickType_t now,
+                                            TickType_t max_wait_ticks)
+{
+    TickType_t wait = max_wait_ticks;
+    for (const BMP280FreeRTOSDev *dev = ctx->devs; dev; dev = dev->next) {
+        if (!dev->timer_running) {
+            continue;
+        }
+        if (is_deadline_passed(now, dev->timer_deadline)) {
+            return 0;
+        }
+        TickType_t remaining = dev->timer_deadline - now;
+        if (remaining < wait) {
+            wait = remaining;
+        }
+    }
+    return wait;
+}
+
+void bmp280_freertos_process(BMP280FreeRTOSContext *const ctx, TickType_t max_wait_ticks)
+{
+    TickType_t wait = ticks_until_next_deadline(ctx, xTaskGetTickCount(), max_wait_ticks);
+    uint32_t bits = 0;
+    /* Completions that happen between the flag checks below and this wait leave the notification pending, so the wait
+     * returns immediately and they are not lost */
+    if (xTaskNotifyWait(0, BMP280_FREERTOS_NOTIFY_BIT_IO_DONE, &bits, wait) == pdTRUE) {
+        ctx->num_notifications++;
+    }
+    ctx->num_wakeups++;
+
+    TickType_t now = xTaskGetTickCount();
+    for (BMP280FreeRTOSDev *dev = ctx->devs; dev; dev = dev->next) {
+        if (dev->io_done) {
+            dev->io_done = false;
+            /* Cleared before executing the callback, because the callback can start the next transfer */
+            BMP280_IOCompleteCb cb = dev->io_cb;
+            dev->io_cb = NULL;
+            if (cb) {
+                cb(dev->io_rc, dev->io_cb_user_data);
+            }
+        }
+        if (dev->timer_running && is_deadline_passed(now, dev->timer_deadline)) {
+            dev->timer_running = false;
+            if (dev->timer_cb) {
+                dev->timer_cb(dev->timer_cb_user_data);
+            }
+        }
+    }
+}
+
+void bmp280_freertos_io_done_from_isr(BMP280FreeRTOSDev *const dev, uint8_t io_rc,
+                                      BaseType_t *const higher_priority_task_woken)
+{
+    /* rc is written first, the driver task reads it only after it sees io_done */
+    dev->io_rc = io_rc;
+    dev->io_done = true;
+    xTaskNotifyFromISR(dev->ctx->task, BMP280_FREERTOS_NOTIFY_BIT_IO_DONE, eSetBits, higher_priority_task_woken);
+}
+
+void bmp280_freertos_io_done(BMP280FreeRTOSDev *const dev, uint8_t io_rc)
+{
+    dev->io_rc = io_rc;
+    dev->io_done = true;
+    xTaskNotify(dev->ctx->task, BMP280_FREERTOS_NOTIFY_BIT_IO_DONE, eSetBits);
+}
+
+void bmp280_freertos_read_regs(uint8_t start_addr, size_t num_regs, uint8_t *data, void *user_data,
+                               BMP280_IOCompleteCb cb, void *cb_user_data)
+{
+    BMP280FreeRTOSDev *dev = (BMP280FreeRTOSDev *)user_data;
+    dev->io_cb = cb;
+    dev->io_cb_user_data = cb_user_data;
+    dev->start_read(dev->bus_user_data, dev, start_addr, num_regs, data);
+}
+
+void bmp280_freertos_write_reg(uint8_t addr, uint8_t reg_val, void *user_data, BMP280_IOCompleteCb cb,
+                               void *cb_user_data)
+{
+    BMP280FreeRTOSDev *dev = (BMP280FreeRTOSDev *)user_data;
+    dev->io_cb = cb;
+    dev->io_cb_user_data = cb_user_data;
+    dev->start_write(dev->bus_user_data, dev, addr, reg_val);
+}
+
+void bmp280_freertos_start_timer(uint32_t duration_ms, void *user_data, BMP280TimerExpiredCb cb, void *cb_user_data)
+{
+    BMP280FreeRTOSDev *dev = (BMP280FreeRTOSDev *)user_data;
+    dev->timer_deadline = xTaskGetTickCount() + pdMS_TO_TICKS(duration_ms) + 1;
+    dev->timer_cb = cb;
+    dev->timer_cb_user_data = cb_user_data;
+    dev->timer_running = true;
+}
@@ -0,0 +1,168 @@
+#ifndef PORT_FREERTOS_BMP280_FREERTOS_H
+#define PORT_FREERTOS_BMP280_FREERTOS_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "bmp280_defs.h"
+
+/**
+ * @brief Reference FreeRTOS integration of the BMP280 driver.
+ *
+ * All BMP280 instances of a @ref BMP280FreeRTOSContext are owned by one driver task, which runs @ref
+ * bmp280_freertos_process in a loop. All driver functions and callbacks execute in that task, as required by the
+ * execution context rule in the README.
+ *
+ * - IO completion handoff uses direct-to-task notifications instead of queues. The bus backend starts an asynchronous
+ * transfer (e.g. HAL DMA), and its completion interrupt calls @ref bmp280_freertos_io_done_from_isr. That sets a flag
+ * in the device and notifies the driver task. No queue item is copied and no queue lock is taken.
+ * - start_timer is served by the driver task itself instead of one FreeRTOS software timer per instance: the task
+ * blocks on its notification with a timeout equal to the nearest timer deadline of all instances. Timer expiry
+ * therefore costs no timer daemon task switch and no timer command queue message.
+ *
+ * ctx->num_wakeups counts how often the driver task returned from its blocking wait, and ctx->num_notifications how
+ * many of those returns were caused by a notification. A wakeup is not the same as a context switch: a wait that finds
+ * a notification already pending returns without blocking, and other tasks can be switched in and out while the driver
+ * task is blocked. Context switches have to be counted in the kernel, e.g. with traceTASK_SWITCHED_IN.
+ */
+
+typedef struct BMP280FreeRTOSDev BMP280FreeRTOSDev;
+
+/**
+ * @brief Start an asynchronous register read.
+ *
+ * Must return without waiting for the transfer. Once the transfer is complete, @ref bmp280_freertos_io_done_from_isr
+ * or @ref bmp280_freertos_io_done must be called for @p dev. It can be called before this function returns.
+ *
+ * @param[in] bus_user_data bus_user_data of @p dev.
+ * @param[in] dev Device that the transfer belongs to.
+ * @param[in] start_addr Address of the first register to read.
+ * @param[in] num_regs Number of registers to read.
+ * @param[out] data Register values must be written to this buffer.
+ */
+typedef void (*BMP280FreeRTOSStartRead)(void *bus_user_data, BMP280FreeRTOSDev *dev, uint8_t start_addr,
+                                        size_t num_regs, uint8_t *data);
+
+/**
+ * @brief Start an asynchronous register write. Same rules as @ref BMP280FreeRTOSStartRead.
+ */
+typedef void (*BMP280FreeRTOSStartWrite)(void *bus_user_data, BMP280FreeRTOSDev *dev, uint8_t addr, uint8_t reg_val);
+
+/** Driver task state shared by all devices. Memory is provided by the user. */
+typedef struct {
+    /** Driver task. Set by @ref bmp280_freertos_ctx_init. */
+    TaskHandle_t task;
+    /** Registered devices. */
+    BMP280FreeRTOSDev *devs;
+    /** Number of returns from the blocking wait of the driver task. */
+    uint32_t num_wakeups;
+    /** Number of wakeups caused by a notification, as opposed to a timer deadline. */
+    uint32_t num_notifications;
+} BMP280FreeRTOSContext;
+
+/**
+ * @brief One BMP280 instance attached to a driver task. Memory is provided by the user.
+ *
+ * Pass a pointer to it as read_regs_user_data, write_reg_user_data and start_timer_user_data in BMP280InitCfg, with
+ * @ref bmp280_freertos_read_regs, @ref bmp280_freertos_write_reg and @ref bmp280_freertos_start_timer.
+ */
+struct BMP280FreeRTOSDev {
+    BMP280FreeRTOSContext *ctx;
+    BMP280FreeRTOSDev *next;
+    BMP280FreeRTOSStartRead start_read;
+    BMP280FreeRTOSStartWrite start_write;
+    void *bus_user_data;
+    BMP280_IOCompleteCb io_cb;
+    void *io_cb_user_data;
+    /** Set from the completion interrupt. */
+    volatile bool io_done;
+    volatile uint8_t io_rc;
+    bool timer_running;
+    TickType_t timer_deadline;
+    BMP280TimerExpiredCb timer_cb;
+    void *timer_cb_user_data;
+};
+
+/**
+ * @brief Initialize the driver task state.
+ *
+ * Must be called from the driver task, before any device is used.
+ *
+ * @param[out] ctx Context to initialize.
+ */
+void bmp280_freertos_ctx_init(BMP280FreeRTOSContext *const ctx);
+
+/**
+ * @brief Attach a device to the driver task.
+ *
+ * @param[out] dev Device to initialize.
+ * @param[in] ctx Context of the driver task.
+ * @param[in] start_read Function that starts an asynchronous register read.
+ * @param[in] start_write Function that starts an asynchronous register write.
+ * @param[in] bus_user_data User data to pass to @p start_read and @p start_write.
+ */
+void bmp280_freertos_dev_init(BMP280FreeRTOSDev *const dev, BMP280FreeRTOSContext *const ctx,
+                              BMP280FreeRTOSStartRead start_read, BMP280FreeRTOSStartWrite start_write,
+                              void *bus_user_data);
+
+/**
+ * @brief Wait for IO completions and timer deadlines, and execute the driver callbacks for them.
+ *
+ * Blocks the calling task, which must be the driver task, until an IO transfer completes, a timer deadline passes, or
+ * @p max_wait_ticks pass. Then executes the callbacks of all completed transfers and expired timers.
+ *
+ * @param[in] ctx Context of the driver task.
+ * @param[in] max_wait_ticks Maximum time to block. portMAX_DELAY to block until something happens.
+ */
+void bmp280_freertos_process(BMP280FreeRTOSContext *const ctx, TickType_t max_wait_ticks);
+
+/**
+ * @brief Report completion of a transfer from an interrupt.
+ *
+ * @param[in] dev Device that the transfer belongs to.
+ * @param[in] io_rc Result of the transfer, one of @ref BMP280_IOResultCode.
+ * @param[out] higher_priority_task_woken Set to pdTRUE if the driver task has a higher priority than the interrupted
+ * task. Pass it to portYIELD_FROM_ISR.
+ */
+void bmp280_freertos_io_done_from_isr(BMP280FreeRTOSDev *const dev, uint8_t io_rc,
+                                      BaseType_t *const higher_priority_task_woken);
+
+/**
+ * @brief Report completion of a transfer from a task, e.g. a blocking bus backend or a simulated bus.
+ */
+void bmp280_freertos_io_done(BMP280FreeRTOSDev *const dev, uint8_t io_rc);
+
+/**
+ * @brief Implementation of @ref BMP280ReadRegs. user_data must point to a @ref BMP280FreeRTOSDev.
+ */
+void bmp280_freertos_read_regs(uint8_t start_addr, size_t num_regs, uint8_t *data, void *user_data,
+                               BMP280_IOCompleteCb cb, void *cb_user_data);
+
+/**
+ * @brief Implementation of @ref BMP280WriteReg. user_data must point to a @ref BMP280FreeRTOSDev.
+ */
+void bmp280_freertos_write_reg(uint8_t addr, uint8_t reg_val, void *user_data, BMP280_IOCompleteCb cb,
+                               void *cb_user_data);
+
+/**
+ * @brief Implementation of @ref BMP280StartTimer. user_data must point to a @ref BMP280FreeRTOSDev.
+ *
+ * One tick is added to the duration, because the current tick can be up to one tick period old, and the wait must not
+ * be shorter than @p duration_ms.
+ */
+void bmp280_freertos_start_timer(uint32_t duration_ms, void *user_data, BMP280TimerExpiredCb cb, void *cb_user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PORT_FREERTOS_BMP280_FREERTOS_H */
@@ -0,0 +1,52 @@
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+/* Configuration of the benchmark for the FreeRTOS POSIX port (FreeRTOS-Kernel/portable/ThirdParty/GCC/Posix). */
+
+#include <stdint.h>
+
+/* Incremented on every switch into a task, see bmp280_freertos_bench.c */
+extern volatile uint32_t bench_num_task_switches;
+#define traceTASK_SWITCHED_IN() (bench_num_task_switches++)
+
+#define configUSE_PREEMPTION 1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
+#define configUSE_IDLE_HOOK 0
+#define configUSE_TICK_HOOK 0
+#define configUSE_DAEMON_TASK_STARTUP_HOOK 0
+#define configTICK_RATE_HZ ((TickType_t)1000)
+#define configMAX_PRIORITIES 5
+/* In words. The POSIX port runs each task on a pthread, whose stack must be at least PTHREAD_STACK_MIN bytes */
+#define configMINIMAL_STACK_SIZE ((unsigned short)4096)
+#define configTOTAL_HEAP_SIZE ((size_t)(1024 * 1024))
+#define configMAX_TASK_NAME_LEN 16
+#define configTICK_TYPE_WIDTH_IN_BITS TICK_TYPE_WIDTH_32_BITS
+#define configIDLE_SHOULD_YIELD 1
+#define configUSE_TASK_NOTIFICATIONS 1
+#define configUSE_MUTEXES 0
+#define configUSE_RECURSIVE_MUTEXES 0
+#define configUSE_COUNTING_SEMAPHORES 0
+#define configQUEUE_REGISTRY_SIZE 0
+#define configUSE_TRACE_FACILITY 0
+#define configUSE_STATS_FORMATTING_FUNCTIONS 0
+#define configCHECK_FOR_STACK_OVERFLOW 0
+#define configUSE_MALLOC_FAILED_HOOK 0
+#define configSUPPORT_DYNAMIC_ALLOCATION 1
+#define configSUPPORT_STATIC_ALLOCATION 0
+#define configUSE_CO_ROUTINES 0
+
+/* The driver task serves all start_timer calls itself, the timer daemon task is not needed */
+#define configUSE_TIMERS 0
+
+#define INCLUDE_vTaskDelay 1
+#define INCLUDE_vTaskDelete 1
+#define INCLUDE_xTaskGetCurrentTaskHandle 1
+#define INCLUDE_vTaskSuspend 1
+
+#define configASSERT(x)                                                                                                \
+    if (!(x)) {                                                                                                        \
+        vAssertCalled(__FILE__, __LINE__);                                                                             \
+    }
+void vAssertCalled(const char *const file, unsigned long line);
+
+#endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,198 @@
+/**
+ * @brief Benchmark of the FreeRTOS integration on the FreeRTOS POSIX port.
+ *
+ * BENCH_NUM_SENSORS sensors are sampled in forced mode back to back for BENCH_DURATION_MS. The sensors are register
+ * files in memory. A bus task with a higher priority than the driver task plays the role of the DMA controller and its
+ * completion interrupt: it performs one transfer at a time and reports it with bmp280_freertos_io_done, which wakes the
+ * driver task with a direct-to-task notification.
+ *
+ * Prints samples per second, context switches per sample (counted with traceTASK_SWITCHED_IN) and driver task wakeups
+ * per sample.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "bmp280.h"
+#include "bmp280_freertos.h"
+#include "sim_fixture.h"
+
+#define BENCH_NUM_SENSORS 8
+#define BENCH_DURATION_MS 10000
+#define BENCH_MEAS_TIME_MS 7
+#define BENCH_DRIVER_TASK_PRIORITY (tskIDLE_PRIORITY + 1)
+#define BENCH_BUS_TASK_PRIORITY (tskIDLE_PRIORITY + 2)
+
+/** Transfer started by the driver task, performed by the bus task. */
+typedef struct {
+    BMP280FreeRTOSDev *dev;
+    uint8_t *regs;
+    uint8_t addr;
+    bool is_read;
+    size_t num_regs;
+    uint8_t *data;
+    uint8_t write_val;
+} BenchTransfer;
+
+typedef struct {
+    uint8_t regs[256];
+    BMP280FreeRTOSDev dev;
+    BMP280 inst;
+    BMP280Meas meas;
+    BenchTransfer transfer;
+} BenchSensor;
+
+volatile uint32_t bench_num_task_switches;
+
+static BenchSensor sensors[BENCH_NUM_SENSORS];
+static BMP280FreeRTOSContext ctx;
+static TaskHandle_t bus_task;
+/** Transfers waiting for the bus task. Every sensor has at most one transfer in flight. */
+static BenchTransfer *volatile bus_queue[BENCH_NUM_SENSORS];
+static volatile size_t bus_queue_head;
+static volatile size_t bus_queue_tail;
+static uint32_t num_samples;
+static uint32_t num_errors;
+
+void vAssertCalled(const char *const file, unsigned long line)
+{
+    fprintf(stderr, "Assertion failed at %s:%lu\n", file, line);
+    exit(1);
+}
+
+static void bus_enqueue(BenchTransfer *transfer)
+{
+    bus_queue[bus_queue_tail % BENCH_NUM_SENSORS] = transfer;
+    bus_queue_tail++;
+    xTaskNotifyGive(bus_task);
+}
+
+static void bench_start_read(void *bus_user_data, BMP280FreeRTOSDev *dev, uint8_t start_addr, size_t num_regs,
+                             uint8_t *data)
+{
+    BenchSensor *sensor = (BenchSensor *)bus_user_data;
+    sensor->transfer = (BenchTransfer){
+        .dev = dev,
+        .regs = sensor->regs,
+        .addr = start_addr,
+        .is_read = true,
+        .num_regs = num_regs,
+        .data = data,
+    };
+    bus_enqueue(&sensor->transfer);
+}
+
+static void bench_start_write(void *bus_user_data, BMP280FreeRTOSDev *dev, uint8_t addr, uint8_t reg_val)
+{
+    BenchSensor *sensor = (BenchSensor *)bus_user_data;
+    sensor->transfer = (BenchTransfer){
+        .dev = dev,
+        .regs = sensor->regs,
+        .addr = addr,
+        .is_read = false,
+        .write_val = reg_val,
+    };
+    bus_enqueue(&sensor->transfer);
+}
+
+static void bus_task_fn(void *arg)
+{
+    (void)arg;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (bus_queue_head != bus_queue_tail) {
+            BenchTransfer *transfer = bus_queue[bus_queue_head % BENCH_NUM_SENSORS];
+            bus_queue_head++;
+            if (transfer->is_read) {
+                memcpy(transfer->data, &transfer->regs[transfer->addr], transfer->num_regs);
+            } else {
+                /* Forced mode conversion completes instantly, the sensor returns to sleep mode */
+                transfer->regs[transfer->addr] = transfer->write_val & 0xFCU;
+            }
+            bmp280_freertos_io_done(transfer->dev, BMP280_IO_RESULT_CODE_OK);
+        }
+    }
+}
+
+static void start_sample(BenchSensor *sensor);
+
+static void sample_complete_cb(uint8_t rc, void *user_data)
+{
+    BenchSensor *sensor = (BenchSensor *)user_data;
+    if (rc == BMP280_RESULT_CODE_OK) {
+        num_samples++;
+    } else {
+        num_errors++;
+    }
+    start_sample(sensor);
+}
+
+static void start_sample(BenchSensor *sensor)
+{
+    uint8_t rc = bmp280_read_meas_forced_mode(sensor->inst, BMP280_MEAS_TYPE_TEMP_AND_PRES, BENCH_MEAS_TIME_MS,
+                                              &sensor->meas, sample_complete_cb, (void *)sensor);
+    configASSERT(rc == BMP280_RESULT_CODE_OK);
+}
+
+static void init_meas_complete_cb(uint8_t rc, void *user_data)
+{
+    configASSERT(rc == BMP280_RESULT_CODE_OK);
+    start_sample((BenchSensor *)user_data);
+}
+
+static void driver_task_fn(void *arg)
+{
+    (void)arg;
+    bmp280_freertos_ctx_init(&ctx);
+    for (size_t i = 0; i < BENCH_NUM_SENSORS; i++) {
+        BenchSensor *sensor = &sensors[i];
+        memcpy(&sensor->regs[0x88], sim_fixture_calib_data, sizeof(sim_fixture_calib_data));
+        memcpy(&sensor->regs[0xF7], sim_fixture_data_regs, sizeof(sim_fixture_data_regs));
+        /* Temperature and pressure oversampling x1, sleep mode */
+        sensor->regs[0xF4] = 0x24;
+        bmp280_freertos_dev_init(&sensor->dev, &ctx, bench_start_read, bench_start_write, (void *)sensor);
+        BMP280InitCfg cfg = {
+            .get_inst_buf = sim_fixture_get_inst_buf,
+            .get_inst_buf_user_data = NULL,
+            .read_regs = bmp280_freertos_read_regs,
+            .read_regs_user_data = (void *)&sensor->dev,
+            .write_reg = bmp280_freertos_write_reg,
+            .write_reg_user_data = (void *)&sensor->dev,
+            .start_timer = bmp280_freertos_start_timer,
+            .start_timer_user_data = (void *)&sensor->dev,
+            .lazy_init_meas = false,
+        };
+        uint8_t rc = bmp280_create(&sensor->inst, &cfg);
+        configASSERT(rc == BMP280_RESULT_CODE_OK);
+        rc = bmp280_init_meas(sensor->inst, init_meas_complete_cb, (void *)sensor);
+        configASSERT(rc == BMP280_RESULT_CODE_OK);
+    }
+
+    TickType_t start = xTaskGetTickCount();
+    uint32_t start_switches = bench_num_task_switches;
+    while ((TickType_t)(xTaskGetTickCount() - start) < pdMS_TO_TICKS(BENCH_DURATION_MS)) {
+        bmp280_freertos_process(&ctx, portMAX_DELAY);
+    }
+    uint32_t switches = bench_num_task_switches - start_switches;
+    uint32_t wakeups = ctx.num_wakeups;
+
+    double samples = (num_samples > 0) ? (double)num_samples : 1.0;
+    printf("sensors: %d, duration: %d ms, samples: %lu, errors: %lu\n", BENCH_NUM_SENSORS, BENCH_DURATION_MS,
+           (unsigned long)num_samples, (unsigned long)num_errors);
+    printf("samples/s: %.1f\n", (double)num_samples * 1000.0 / BENCH_DURATION_MS);
+    printf("context switches/sample: %.2f\n", (double)switches / samples);
+    printf("driver task wakeups/sample: %.2f\n", (double)wakeups / samples);
+    exit(num_errors == 0 ? 0 : 1);
+}
+
+int main(void)
+{
+    xTaskCreate(bus_task_fn, "bus", configMINIMAL_STACK_SIZE, NULL, BENCH_BUS_TASK_PRIORITY, &bus_task);
+    xTaskCreate(driver_task_fn, "bmp280", configMINIMAL_STACK_SIZE, NULL, BENCH_DRIVER_TASK_PRIORITY, NULL);
+    vTaskStartScheduler();
+    return 1;
+}
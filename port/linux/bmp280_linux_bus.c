@@ -0,0 +1,326 @@
+#include <stdbool.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
+
+#include "bmp280_linux_bus.h"
+#include "bmp280.h"
+
+/** Bit 7 of the register address selects read (1) or write (0) in SPI mode. */
+#define BMP280_LINUX_SPI_READ_BIT 0x80U
+/** Registers read back to validate a clock speed. */
+#define BMP280_LINUX_SPI_CHIP_ID_REG_ADDR 0xD0
+#define BMP280_LINUX_SPI_CALIB_START_REG_ADDR 0x88
+#define BMP280_LINUX_SPI_CALIB_LEN 24
+/** Chip id of mass production parts. Samples read 0x56 or 0x57. */
+#define BMP280_LINUX_SPI_CHIP_ID 0x58
+#define BMP280_LINUX_SPI_SAMPLE_CHIP_ID_MIN 0x56
+
+void bmp280_linux_i2c_bus_init(BMP280LinuxI2CBus *const bus, int fd)
+{
+    memset(bus, 0, sizeof(*bus));
+    bus->fd = fd;
+}
+
+/**
+ * @brief Execute the messages prepared in bus->msgs with one ioctl, and set io_rc of transfers first...end.
+ */
+static void i2c_run(BMP280LinuxI2CBus *const bus, BMP280BusTransfer *first, const BMP280BusTransfer *end,
+                    size_t num_msgs)
+{
+    struct i2c_rdwr_ioctl_data rdwr = {
+        .msgs = bus->msgs,
+        .nmsgs = (__u32)num_msgs,
+    };
+    int rc = ioctl(bus->fd, I2C_RDWR, &rdwr);
+    bus->num_ioctls++;
+
+    uint8_t io_rc = (rc == (int)num_msgs) ? BMP280_IO_RESULT_CODE_OK : BMP280_IO_RESULT_CODE_ERR;
+    for (BMP280BusTransfer *transfer = first; transfer != end; transfer = transfer->next) {
+        transfer->io_rc = io_rc;
+    }
+}
+
+void bmp280_linux_i2c_submit(BMP280BusTransfer *transfers, size_t num_transfers, void *user_data,
+                             BMP280BusSubmitCompleteCb cb, void *cb_user_data)
+{
+    (void)num_transfers;
+    BMP280LinuxI2CBus *bus = (BMP280LinuxI2CBus *)user_data;
+    BMP280BusTransfer *chunk_first = transfers;
+    size_t num_msgs = 0;
+    /* Channel of the last mux select if it failed */
+    uint8_t failed_channel = BMP280_BUS_BATCH_NO_MUX;
+
+    for (BMP280BusTransfer *transfer = transfers; transfer; transfer = transfer->next) {
+        if (transfer->is_mux_select) {
+            failed_channel = BMP280_BUS_BATCH_NO_MUX;
+        } else if ((failed_channel != BMP280_BUS_BATCH_NO_MUX) && (transfer->mux_channel == failed_channel)) {
+            /* Would reach a device on whichever channel is still connected */
+            if (num_msgs > 0) {
+                i2c_run(bus, chunk_first, transfer, num_msgs);
+                num_msgs = 0;
+            }
+            transfer->io_rc = BMP280_IO_RESULT_CODE_ERR;
+            chunk_first = transfer->next;
+            continue;
+        }
+        size_t num_needed = (transfer->is_read && !transfer->is_mux_select) ? 2 : 1;
+        if (num_msgs + num_needed > I2C_RDWR_IOCTL_MAX_MSGS) {
+            i2c_run(bus, chunk_first, transfer, num_msgs);
+            chunk_first = transfer;
+            num_msgs = 0;
+        }
+
+        struct i2c_msg *msg = &bus->msgs[num_msgs];
+        uint8_t *tx_buf = bus->tx_bufs[num_msgs];
+        tx_buf[0] = transfer->reg_addr;
+        msg->addr = transfer->dev_addr;
+        msg->flags = 0;
+        msg->buf = tx_buf;
+        if (transfer->is_mux_select) {
+            tx_buf[0] = transfer->write_val;
+            msg->len = 1;
+        } else if (transfer->is_read) {
+            /* Register address write, followed by a repeated start and data read */
+            msg->len = 1;
+            msg[1].addr = transfer->dev_addr;
+            msg[1].flags = I2C_M_RD;
+            msg[1].len = (__u16)transfer->len;
+            msg[1].buf = transfer->data;
+        } else {
+            tx_buf[1] = transfer->write_val;
+            msg->len = 2;
+        }
+        num_msgs += num_needed;
+        if (transfer->is_mux_select) {
+            /* A TCA9548A switches channels on the stop condition, which ends the ioctl */
+            i2c_run(bus, chunk_first, transfer->next, num_msgs);
+            chunk_first = transfer->next;
+            num_msgs = 0;
+            if (transfer->io_rc != BMP280_IO_RESULT_CODE_OK) {
+                failed_channel = transfer->mux_channel;
+            }
+        }
+    }
+    if (num_msgs > 0) {
+        i2c_run(bus, chunk_first, NULL, num_msgs);
+    }
+
+    cb(cb_user_data);
+}
+
+static int spi_ioctl(int fd, unsigned long request, void *arg)
+{
+    return ioctl(fd, request, arg);
+}
+
+void bmp280_linux_spi_bus_init(BMP280LinuxSpiBus *const bus, const int *fds, size_t num_fds)
+{
+    memset(bus, 0, sizeof(*bus));
+    bus->ioctl_fn = spi_ioctl;
+    if (num_fds > BMP280_LINUX_SPI_MAX_CS) {
+        num_fds = BMP280_LINUX_SPI_MAX_CS;
+    }
+    memcpy(bus->fds, fds, num_fds * sizeof(fds[0]));
+    bus->num_fds = num_fds;
+}
+
+/**
+ * @brief Count register transactions of a tuned chip select, and lower its speed if too many of them failed.
+ */
+static void count_transactions(BMP280LinuxSpiCsClock *const clock, uint32_t num_transactions, uint32_t num_errors)
+{
+    const BMP280LinuxSpiTuneCfg *cfg = clock->tune_cfg;
+    if (!cfg) {
+        return;
+    }
+
+    clock->window_transactions += num_transactions;
+    clock->window_errors += num_errors;
+    if (clock->window_errors >= cfg->max_window_errors) {
+        if (clock->speed_idx > 0) {
+            clock->speed_idx--;
+            clock->speed_hz = cfg->speeds_hz[clock->speed_idx];
+            clock->num_backoffs++;
+        }
+        /* Errors at the previous speed do not count against the new one */
+        clock->window_transactions = 0;
+        clock->window_errors = 0;
+    } else if (clock->window_transactions >= cfg->window_transactions) {
+        clock->window_transactions = 0;
+        clock->window_errors = 0;
+    }
+}
+
+/**
+ * @brief Execute the register transactions collected in bus->group on chip select @p cs with one ioctl.
+ */
+static void spi_run(BMP280LinuxSpiBus *const bus, size_t cs, size_t group_size)
+{
+    size_t num_xfers = 0;
+    uint32_t speed_hz = bus->clocks[cs].speed_hz;
+    memset(bus->xfers, 0, sizeof(bus->xfers));
+    for (size_t i = 0; i < group_size; i++) {
+        BMP280BusTransfer *transfer = bus->group[i];
+        uint8_t *tx_buf = bus->tx_bufs[i];
+        struct spi_ioc_transfer *xfer = &bus->xfers[num_xfers];
+        if (transfer->is_read) {
+            tx_buf[0] = (uint8_t)(transfer->reg_addr | BMP280_LINUX_SPI_READ_BIT);
+            xfer[0].tx_buf = (__u64)(uintptr_t)tx_buf;
+            xfer[0].len = 1;
+            xfer[0].speed_hz = speed_hz;
+            xfer[1].rx_buf = (__u64)(uintptr_t)transfer->data;
+            xfer[1].len = (__u32)transfer->len;
+            xfer[1].speed_hz = speed_hz;
+            num_xfers += 2;
+        } else {
+            tx_buf[0] = (uint8_t)(transfer->reg_addr & ~BMP280_LINUX_SPI_READ_BIT);
+            tx_buf[1] = transfer->write_val;
+            xfer[0].tx_buf = (__u64)(uintptr_t)tx_buf;
+            xfer[0].len = 2;
+            xfer[0].speed_hz = speed_hz;
+            num_xfers += 1;
+        }
+        /* Deselect the device between register transactions. On the last transfer of the message, cs_change would
+         * keep the device selected after the ioctl, so it is not set there. */
+        if (i + 1 < group_size) {
+            bus->xfers[num_xfers - 1].cs_change = 1;
+        }
+    }
+
+    int rc = bus->ioctl_fn(bus->fds[cs], SPI_IOC_MESSAGE(num_xfers), bus->xfers);
+    bus->num_ioctls++;
+
+    uint8_t io_rc = (rc >= 0) ? BMP280_IO_RESULT_CODE_OK : BMP280_IO_RESULT_CODE_ERR;
+    for (size_t i = 0; i < group_size; i++) {
+        bus->group[i]->io_rc = io_rc;
+    }
+    count_transactions(&bus->clocks[cs], (uint32_t)group_size, (rc >= 0) ? 0 : (uint32_t)group_size);
+}
+
+void bmp280_linux_spi_submit(BMP280BusTransfer *transfers, size_t num_transfers, void *user_data,
+                             BMP280BusSubmitCompleteCb cb, void *cb_user_data)
+{
+    (void)num_transfers;
+    BMP280LinuxSpiBus *bus = (BMP280LinuxSpiBus *)user_data;
+
+    /* I2C muxes have no place on an SPI bus */
+    for (BMP280BusTransfer *transfer = transfers; transfer; transfer = transfer->next) {
+        if ((transfer->dev_addr >= bus->num_fds) || transfer->is_mux_select) {
+            transfer->io_rc = BMP280_IO_RESULT_CODE_ERR;
+        }
+    }
+    for (size_t cs = 0; cs < bus->num_fds; cs++) {
+        size_t group_size = 0;
+        for (BMP280BusTransfer *transfer = transfers; transfer; transfer = transfer->next) {
+            if ((transfer->dev_addr != cs) || transfer->is_mux_select) {
+                continue;
+            }
+            bus->group[group_size++] = transfer;
+            if (group_size == BMP280_LINUX_SPI_MAX_XFERS_PER_IOCTL) {
+                spi_run(bus, cs, group_size);
+                group_size = 0;
+            }
+        }
+        if (group_size > 0) {
+            spi_run(bus, cs, group_size);
+        }
+    }
+
+    cb(cb_user_data);
+}
+
+/**
+ * @brief Read the chip id and calibration block of chip select @p cs into @p chip_id and @p calib with one ioctl.
+ *
+ * @retval true Both reads succeeded.
+ */
+static bool read_id_and_calib(BMP280LinuxSpiBus *const bus, size_t cs, uint8_t *chip_id, uint8_t *calib)
+{
+    BMP280BusTransfer transfers[2];
+    memset(transfers, 0, sizeof(transfers));
+    transfers[0].dev_addr = (uint8_t)cs;
+    transfers[0].reg_addr = BMP280_LINUX_SPI_CHIP_ID_REG_ADDR;
+    transfers[0].is_read = true;
+    transfers[0].data = chip_id;
+    transfers[0].len = 1;
+    transfers[1].dev_addr = (uint8_t)cs;
+    transfers[1].reg_addr = BMP280_LINUX_SPI_CALIB_START_REG_ADDR;
+    transfers[1].is_read = true;
+    transfers[1].data = calib;
+    transfers[1].len = BMP280_LINUX_SPI_CALIB_LEN;
+    bus->group[0] = &transfers[0];
+    bus->group[1] = &transfers[1];
+    spi_run(bus, cs, 2);
+    return (transfers[0].io_rc == BMP280_IO_RESULT_CODE_OK) && (transfers[1].io_rc == BMP280_IO_RESULT_CODE_OK);
+}
+
+/**
+ * @brief Read the chip id and calibration block num_reads times at the current speed of @p cs, and compare them to
+ * the reference values.
+ */
+static bool validate_speed(BMP280LinuxSpiBus *const bus, size_t cs, const BMP280LinuxSpiTuneCfg *const cfg,
+                           uint8_t ref_chip_id, const uint8_t *ref_calib)
+{
+    for (uint32_t i = 0; i < cfg->num_reads; i++) {
+        uint8_t chip_id;
+        uint8_t calib[BMP280_LINUX_SPI_CALIB_LEN];
+        if (!read_id_and_calib(bus, cs, &chip_id, calib) || (chip_id != ref_chip_id) ||
+            (memcmp(calib, ref_calib, sizeof(calib)) != 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint8_t bmp280_linux_spi_tune(BMP280LinuxSpiBus *const bus, size_t cs, const BMP280LinuxSpiTuneCfg *const cfg)
+{
+    if (!bus || !cfg || (cs >= bus->num_fds) || !cfg->speeds_hz || (cfg->num_speeds == 0) || (cfg->num_reads == 0) ||
+        (cfg->window_transactions == 0) || (cfg->max_window_errors == 0)) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    BMP280LinuxSpiCsClock *clock = &bus->clocks[cs];
+    BMP280LinuxSpiCsClock prev_clock = *clock;
+    /* No back-off while the speed is being tuned */
+    clock->tune_cfg = NULL;
+
+    uint8_t ref_chip_id;
+    uint8_t ref_calib[BMP280_LINUX_SPI_CALIB_LEN];
+    clock->speed_hz = cfg->speeds_hz[0];
+    /* Errors that repeat on every read are only detected by the known chip id */
+    if (!read_id_and_calib(bus, cs, &ref_chip_id, ref_calib) || (ref_chip_id < BMP280_LINUX_SPI_SAMPLE_CHIP_ID_MIN) ||
+        (ref_chip_id > BMP280_LINUX_SPI_CHIP_ID) || !validate_speed(bus, cs, cfg, ref_chip_id, ref_calib)) {
+        *clock = prev_clock;
+        return BMP280_RESULT_CODE_IO_ERR;
+    }
+
+    size_t num_passed = 1;
+    while (num_passed < cfg->num_speeds) {
+        clock->speed_hz = cfg->speeds_hz[num_passed];
+        if (!validate_speed(bus, cs, cfg, ref_chip_id, ref_calib)) {
+            break;
+        }
+        num_passed++;
+    }
+
+    size_t speed_idx = num_passed - 1;
+    /* Without a failure, the fastest speed is within the tested range and needs no margin */
+    if (num_passed < cfg->num_speeds) {
+        speed_idx = (speed_idx > cfg->margin_steps) ? (speed_idx - cfg->margin_steps) : 0;
+    }
+    clock->speed_idx = speed_idx;
+    clock->speed_hz = cfg->speeds_hz[speed_idx];
+    clock->tune_cfg = cfg;
+    clock->window_transactions = 0;
+    clock->window_errors = 0;
+    return BMP280_RESULT_CODE_OK;
+}
+
+void bmp280_linux_spi_report_errors(BMP280LinuxSpiBus *const bus, size_t cs, uint32_t num_errors)
+{
+    if (!bus || (cs >= bus->num_fds)) {
+        return;
+    }
+    count_transactions(&bus->clocks[cs], 0, num_errors);
+}
@@ -0,0 +1,165 @@
+#ifndef PORT_LINUX_BMP280_LINUX_BUS_H
+#define PORT_LINUX_BMP280_LINUX_BUS_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <linux/spi/spidev.h>
+
+#include "bmp280_bus_batch.h"
+
+/**
+ * @brief Linux implementations of @ref BMP280BusSubmit.
+ *
+ * I2C: all transfers of a batch are executed with one I2C_RDWR ioctl on an i2c-dev file descriptor (/dev/i2c-N), as one
+ * combined transaction with repeated starts. dev_addr of a transfer is the 7-bit I2C address of the device. A register
+ * read is two messages (register address write, data read), a register write is one message. Batches with more than
+ * I2C_RDWR_IOCTL_MAX_MSGS messages are split into several ioctls. If an ioctl fails, every transfer in it fails. A mux
+ * select is one message, and ends its ioctl, because the mux only switches channels on the stop condition.
+ *
+ * SPI: spidev has one file descriptor per chip select, and one SPI_IOC_MESSAGE ioctl can only address the chip select
+ * of its file descriptor. Transfers are therefore grouped by chip select: all transfers of a batch for the same chip
+ * select are executed with one SPI_IOC_MESSAGE ioctl, with cs_change set between register transactions. dev_addr of a
+ * transfer is an index into the fds array.
+ *
+ * Both execute the batch synchronously and call the submit complete callback before returning, so
+ * bmp280_bus_batch_flush blocks for the duration of the bus transactions.
+ *
+ * SPI clock tuning: @ref bmp280_linux_spi_tune steps the clock of one chip select up through a list of speeds. At
+ * every speed it reads the chip id register (0xD0) and the calibration block (0x88...0x9F) num_reads times, and
+ * compares them to the values read at the lowest speed, where the chip id must be that of a BMP280. The sweep stops at
+ * the first speed with a mismatch or IO error, and the chip select then runs margin_steps speeds below the fastest
+ * speed that passed. Once tuned, the chip select backs off by one speed whenever at least max_window_errors of
+ * window_transactions register transactions fail. SPI has no acknowledge, so corrupted data only shows up in
+ * plausibility checks above the bus, which can be reported with @ref bmp280_linux_spi_report_errors.
+ */
+
+/** Maximum number of SPI chip selects of one @ref BMP280LinuxSpiBus. */
+#define BMP280_LINUX_SPI_MAX_CS 8
+/** Maximum number of register transactions in one SPI_IOC_MESSAGE ioctl. Larger groups are split. */
+#define BMP280_LINUX_SPI_MAX_XFERS_PER_IOCTL 32
+
+typedef struct {
+    /** File descriptor of an opened i2c-dev device, e.g. /dev/i2c-1. */
+    int fd;
+    /** Scratch memory for one ioctl. */
+    struct i2c_msg msgs[I2C_RDWR_IOCTL_MAX_MSGS];
+    uint8_t tx_bufs[I2C_RDWR_IOCTL_MAX_MSGS][2];
+    /** Number of executed ioctls. */
+    uint64_t num_ioctls;
+} BMP280LinuxI2CBus;
+
+/**
+ * @brief Executes SPI_IOC_MESSAGE. Same parameters and return value as ioctl.
+ */
+typedef int (*BMP280LinuxSpiIoctl)(int fd, unsigned long request, void *arg);
+
+/** SPI clock tuning configuration. */
+typedef struct {
+    /** Candidate clock speeds in Hz, ascending. speeds_hz[0] must be known to work. BMP280 supports up to 10 MHz. */
+    const uint32_t *speeds_hz;
+    size_t num_speeds;
+    /** Number of chip id and calibration block reads at every speed. At least 1. */
+    uint32_t num_reads;
+    /** Number of speeds below the fastest speed that passed to run at, if a faster speed failed. */
+    uint8_t margin_steps;
+    /** Number of register transactions over which errors are counted. At least 1. */
+    uint32_t window_transactions;
+    /** Number of failed register transactions in a window that lowers the speed by one step. At least 1. */
+    uint32_t max_window_errors;
+} BMP280LinuxSpiTuneCfg;
+
+/** Clock state of one chip select. */
+typedef struct {
+    /** Current clock speed in Hz. 0 uses max_speed_hz of the spidev device. */
+    uint32_t speed_hz;
+    /** Index of speed_hz in the speeds of tune_cfg. */
+    size_t speed_idx;
+    /** Configuration of the latest successful tuning, NULL if the chip select has not been tuned. */
+    const BMP280LinuxSpiTuneCfg *tune_cfg;
+    uint32_t window_transactions;
+    uint32_t window_errors;
+    /** Number of times the speed was lowered because of errors. */
+    uint32_t num_backoffs;
+} BMP280LinuxSpiCsClock;
+
+typedef struct {
+    /** File descriptors of opened spidev devices, index is the chip select index used as dev_addr. */
+    int fds[BMP280_LINUX_SPI_MAX_CS];
+    size_t num_fds;
+    /** Scratch memory for one ioctl. Every register transaction uses two spi_ioc_transfers: address and data. */
+    struct spi_ioc_transfer xfers[2 * BMP280_LINUX_SPI_MAX_XFERS_PER_IOCTL];
+    uint8_t tx_bufs[BMP280_LINUX_SPI_MAX_XFERS_PER_IOCTL][2];
+    BMP280BusTransfer *group[BMP280_LINUX_SPI_MAX_XFERS_PER_IOCTL];
+    /** Number of executed ioctls. */
+    uint64_t num_ioctls;
+    BMP280LinuxSpiCsClock clocks[BMP280_LINUX_SPI_MAX_CS];
+    /** Set to ioctl by @ref bmp280_linux_spi_bus_init. Can be replaced, e.g. to run on a simulated device. */
+    BMP280LinuxSpiIoctl ioctl_fn;
+} BMP280LinuxSpiBus;
+
+/**
+ * @brief Initialize an I2C bus.
+ *
+ * @param[out] bus Bus to initialize.
+ * @param[in] fd File descriptor of an opened i2c-dev device.
+ */
+void bmp280_linux_i2c_bus_init(BMP280LinuxI2CBus *const bus, int fd);
+
+/**
+ * @brief Implementation of @ref BMP280BusSubmit. user_data must point to a @ref BMP280LinuxI2CBus.
+ */
+void bmp280_linux_i2c_submit(BMP280BusTransfer *transfers, size_t num_transfers, void *user_data,
+                             BMP280BusSubmitCompleteCb cb, void *cb_user_data);
+
+/**
+ * @brief Initialize an SPI bus.
+ *
+ * @param[out] bus Bus to initialize.
+ * @param[in] fds File descriptors of opened spidev devices, one per chip select.
+ * @param[in] num_fds Number of elements in @p fds. At most BMP280_LINUX_SPI_MAX_CS.
+ */
+void bmp280_linux_spi_bus_init(BMP280LinuxSpiBus *const bus, const int *fds, size_t num_fds);
+
+/**
+ * @brief Implementation of @ref BMP280BusSubmit. user_data must point to a @ref BMP280LinuxSpiBus.
+ */
+void bmp280_linux_spi_submit(BMP280BusTransfer *transfers, size_t num_transfers, void *user_data,
+                             BMP280BusSubmitCompleteCb cb, void *cb_user_data);
+
+/**
+ * @brief Find the fastest stable clock speed of a chip select, and keep adjusting it to the error rate afterwards.
+ *
+ * Executes the validation reads synchronously. Must not be called while a batch is being submitted on @p bus.
+ *
+ * @param[in] bus SPI bus.
+ * @param[in] cs Chip select index.
+ * @param[in] cfg Tuning configuration. Must stay valid while @p bus is used.
+ *
+ * @retval BMP280_RESULT_CODE_OK The chip select runs at the selected speed.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p bus or @p cfg is NULL, @p cs is not a chip select of @p bus, or a value in
+ * @p cfg is outside of its range.
+ * @retval BMP280_RESULT_CODE_IO_ERR Reads at speeds_hz[0] failed, returned different values or a chip id other than
+ * that of a BMP280. The speed of the chip select is unchanged.
+ */
+uint8_t bmp280_linux_spi_tune(BMP280LinuxSpiBus *const bus, size_t cs, const BMP280LinuxSpiTuneCfg *const cfg);
+
+/**
+ * @brief Count failed register transactions that were detected above the bus, e.g. implausible measurements.
+ *
+ * They count towards the back-off of a tuned chip select like failed ioctls. Does nothing if @p cs has not been tuned.
+ */
+void bmp280_linux_spi_report_errors(BMP280LinuxSpiBus *const bus, size_t cs, uint32_t num_errors);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PORT_LINUX_BMP280_LINUX_BUS_H */
@@ -0,0 +1,153 @@
+#define _GNU_SOURCE
+#include <poll.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+
+#include "bmp280_linux_metrics_http.h"
+
+/** Maximum size of a request head. Scrapers send a few hundred bytes. */
+#define BMP280_LINUX_METRICS_HTTP_MAX_REQUEST 2048
+
+static const char http_ok_head[] = "HTTP/1.1 200 OK\r\n"
+                                   "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+                                   "Connection: close\r\n"
+                                   "\r\n";
+static const char http_not_found[] = "HTTP/1.1 404 Not Found\r\n"
+                                     "Content-Length: 0\r\n"
+                                     "Connection: close\r\n"
+                                     "\r\n";
+
+int bmp280_linux_metrics_http_listen(uint16_t port, uint32_t timeout_ms)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    /* Bounds accept on the listening socket, and is copied to every accepted socket to bound recv and send */
+    struct timeval timeout;
+    timeout.tv_sec = (time_t)(timeout_ms / 1000U);
+    timeout.tv_usec = (suseconds_t)((timeout_ms % 1000U) * 1000U);
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0) {
+        close(fd);
+        return -1;
+    }
+    if (bind(fd, (const struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 4) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool send_all(int fd, const char *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t sent = send(fd, data, len, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        len -= (size_t)sent;
+    }
+    return true;
+}
+
+static int64_t monotonic_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/**
+ * Read the request head, up to the empty line, before @p deadline_ms of @ref monotonic_ms, or without a deadline if it
+ * is negative. @return bool false on error, timeout or if the head is too large.
+ */
+static bool recv_request_head(int fd, char *buf, size_t size, int64_t deadline_ms)
+{
+    size_t len = 0;
+    while (len < size - 1) {
+        /* The socket timeout bounds each recv only, so a client trickling bytes is cut off here */
+        int wait_ms = -1;
+        if (deadline_ms >= 0) {
+            int64_t remaining_ms = deadline_ms - monotonic_ms();
+            if (remaining_ms <= 0) {
+                return false;
+            }
+            wait_ms = (int)remaining_ms;
+        }
+        struct pollfd pfd = {.fd = fd, .events = POLLIN, .revents = 0};
+        if (poll(&pfd, 1, wait_ms) <= 0) {
+            return false;
+        }
+        ssize_t num = recv(fd, &buf[len], size - 1 - len, 0);
+        if (num <= 0) {
+            return false;
+        }
+        len += (size_t)num;
+        buf[len] = '\0';
+        if (strstr(buf, "\r\n\r\n")) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool is_metrics_request(const char *request)
+{
+    static const char prefix[] = "GET /metrics";
+    if (strncmp(request, prefix, sizeof(prefix) - 1) != 0) {
+        return false;
+    }
+    /* Allow a query string, but not e.g. /metricsfoo */
+    char next = request[sizeof(prefix) - 1];
+    return next == ' ' || next == '?';
+}
+
+uint8_t bmp280_linux_metrics_http_serve_one(int listen_fd, const BMP280StatsRegistry *const registry)
+{
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return BMP280_RESULT_CODE_IO_ERR;
+    }
+    struct timeval timeout;
+    socklen_t timeout_len = sizeof(timeout);
+    if (getsockopt(listen_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, &timeout_len) != 0 ||
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0 ||
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) != 0) {
+        close(fd);
+        return BMP280_RESULT_CODE_IO_ERR;
+    }
+
+    int64_t timeout_ms = (int64_t)timeout.tv_sec * 1000 + timeout.tv_usec / 1000;
+    int64_t deadline_ms = timeout_ms > 0 ? monotonic_ms() + timeout_ms : -1;
+
+    char request[BMP280_LINUX_METRICS_HTTP_MAX_REQUEST];
+    bool ok = recv_request_head(fd, request, sizeof(request), deadline_ms);
+    if (ok && !is_metrics_request(request)) {
+        ok = send_all(fd, http_not_found, sizeof(http_not_found) - 1);
+    } else if (ok) {
+        ok = send_all(fd, http_ok_head, sizeof(http_ok_head) - 1);
+        char chunk[BMP280_LINUX_METRICS_HTTP_CHUNK_SIZE];
+        BMP280StatsWriter writer;
+        bmp280_stats_writer_init(&writer, registry);
+        size_t len;
+        while (ok && (len = bmp280_stats_serialize(&writer, chunk, sizeof(chunk))) > 0) {
+            ok = send_all(fd, chunk, len);
+        }
+    }
+    close(fd);
+    return ok ? BMP280_RESULT_CODE_OK : BMP280_RESULT_CODE_IO_ERR;
+}
@@ -0,0 +1,59 @@
+#ifndef PORT_LINUX_BMP280_LINUX_METRICS_HTTP_H
+#define PORT_LINUX_BMP280_LINUX_METRICS_HTTP_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#include "bmp280_stats.h"
+
+/**
+ * @brief Minimal HTTP exporter of @ref BMP280StatsRegistry for Prometheus and other OpenMetrics scrapers.
+ *
+ * Serves GET /metrics, one connection at a time, with a close-delimited body that is streamed in chunks of
+ * BMP280_LINUX_METRICS_HTTP_CHUNK_SIZE bytes while it is serialized. Run @ref bmp280_linux_metrics_http_serve_one in a
+ * loop in an exporter thread. Counters are read with @ref bmp280_stats_serialize, so the acquisition thread is never
+ * paused.
+ *
+ * Every accept and send is bounded by the timeout passed to @ref bmp280_linux_metrics_http_listen, and the whole
+ * request head must arrive within one timeout of the accept. A client that stops sending or trickles its request
+ * therefore holds the exporter for at most one timeout, and a client that stops reading for at most one timeout per
+ * send. The chunk buffer is on the stack of the calling thread, so several exporter threads can serve the same
+ * listening socket at the same time, each with its own registry because the snapshots of a registry are used by one
+ * serialization at a time.
+ */
+
+/** Size of the buffer on the stack that the body is serialized into before it is sent. */
+#define BMP280_LINUX_METRICS_HTTP_CHUNK_SIZE 16384
+
+/**
+ * @brief Open a TCP socket listening on @p port of all local addresses.
+ *
+ * @param[in] port Port to listen on. 0 picks a free port.
+ * @param[in] timeout_ms Timeout of every accept and send, and of receiving the whole request head. 0 waits
+ * forever.
+ *
+ * @return int Socket file descriptor, or -1 on error.
+ */
+int bmp280_linux_metrics_http_listen(uint16_t port, uint32_t timeout_ms);
+
+/**
+ * @brief Accept one connection, answer one request and close the connection. Waits for a client for at most the
+ * timeout of @p listen_fd.
+ *
+ * @param[in] listen_fd Socket returned by @ref bmp280_linux_metrics_http_listen.
+ * @param[in] registry Statistics to serve.
+ *
+ * @retval BMP280_RESULT_CODE_OK Served the metrics, or answered a request for another path with 404.
+ * @retval BMP280_RESULT_CODE_IO_ERR accept, recv or send failed or timed out, or the request was malformed.
+ */
+uint8_t bmp280_linux_metrics_http_serve_one(int listen_fd, const BMP280StatsRegistry *const registry);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PORT_LINUX_BMP280_LINUX_METRICS_HTTP_H */
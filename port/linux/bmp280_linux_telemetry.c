@@ -0,0 +1,154 @@
+#define _GNU_SOURCE
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "bmp280_linux_telemetry.h"
+
+int bmp280_linux_telemetry_udp_sender_open(const char *ipv4_addr, uint16_t port)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, ipv4_addr, &addr.sin_addr) != 1) {
+        return -1;
+    }
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, (const struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int bmp280_linux_telemetry_udp_collector_open(uint16_t port)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (bind(fd, (const struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/** @return bool false if @p path does not fit into sun_path. */
+static bool fill_uds_addr(struct sockaddr_un *addr, const char *path)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path)) {
+        return false;
+    }
+    strcpy(addr->sun_path, path);
+    return true;
+}
+
+int bmp280_linux_telemetry_uds_sender_open(const char *path)
+{
+    struct sockaddr_un addr;
+    if (!fill_uds_addr(&addr, path)) {
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, (const struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int bmp280_linux_telemetry_uds_collector_open(const char *path)
+{
+    struct sockaddr_un addr;
+    if (!fill_uds_addr(&addr, path)) {
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    unlink(path);
+    if (bind(fd, (const struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+uint8_t bmp280_linux_telemetry_send(int fd, BMP280TelemetryEncoder *const enc)
+{
+    uint8_t frame[BMP280_TELEMETRY_MAX_FRAME_SIZE];
+    size_t len = bmp280_telemetry_encoder_finish(enc, frame, sizeof(frame));
+    if (len == 0) {
+        return BMP280_RESULT_CODE_OK;
+    }
+    return (send(fd, frame, len, 0) == (ssize_t)len) ? BMP280_RESULT_CODE_OK : BMP280_RESULT_CODE_IO_ERR;
+}
+
+uint8_t bmp280_linux_telemetry_add(int fd, BMP280TelemetryEncoder *const enc, uint32_t sensor_id,
+                                   uint32_t timestamp_ms, const BMP280Meas *const meas)
+{
+    uint8_t rc = bmp280_telemetry_encoder_add(enc, sensor_id, timestamp_ms, meas);
+    if (rc != BMP280_RESULT_CODE_NO_MEM) {
+        return rc;
+    }
+
+    /* The encoder is empty after sending, even if sending failed, so adding the record again always succeeds */
+    uint8_t send_rc = bmp280_linux_telemetry_send(fd, enc);
+    rc = bmp280_telemetry_encoder_add(enc, sensor_id, timestamp_ms, meas);
+    return (rc == BMP280_RESULT_CODE_OK) ? send_rc : rc;
+}
+
+size_t bmp280_linux_telemetry_receive(int fd, BMP280TelemetryCollector *const coll,
+                                      BMP280LinuxTelemetryRecvBufs *const bufs)
+{
+    struct mmsghdr msgs[BMP280_LINUX_TELEMETRY_RECV_BATCH];
+    struct iovec iovs[BMP280_LINUX_TELEMETRY_RECV_BATCH];
+    memset(msgs, 0, sizeof(msgs));
+    for (size_t i = 0; i < BMP280_LINUX_TELEMETRY_RECV_BATCH; i++) {
+        iovs[i].iov_base = bufs->bufs[i];
+        iovs[i].iov_len = BMP280_TELEMETRY_MAX_FRAME_SIZE;
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    size_t num_received = 0;
+    for (;;) {
+        int num = recvmmsg(fd, msgs, BMP280_LINUX_TELEMETRY_RECV_BATCH, MSG_DONTWAIT, NULL);
+        if (num <= 0) {
+            return num_received;
+        }
+        for (int i = 0; i < num; i++) {
+            /* Truncated datagrams are larger than any valid frame */
+            size_t len = (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) ? 0 : msgs[i].msg_len;
+            bmp280_telemetry_collector_push_frame(coll, bufs->bufs[i], len);
+        }
+        num_received += (size_t)num;
+        if (num < BMP280_LINUX_TELEMETRY_RECV_BATCH) {
+            return num_received;
+        }
+    }
+}
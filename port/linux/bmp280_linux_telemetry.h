@@ -0,0 +1,97 @@
+#ifndef PORT_LINUX_BMP280_LINUX_TELEMETRY_H
+#define PORT_LINUX_BMP280_LINUX_TELEMETRY_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "bmp280_telemetry.h"
+
+/**
+ * @brief Linux transport of telemetry frames over UDP and Unix domain datagram sockets.
+ *
+ * Every frame is one datagram. Senders use connected sockets, so sending a frame is one send() call. The collector
+ * receives up to BMP280_LINUX_TELEMETRY_RECV_BATCH datagrams with one recvmmsg() call.
+ */
+
+/** Maximum number of datagrams received with one recvmmsg() call. */
+#define BMP280_LINUX_TELEMETRY_RECV_BATCH 32
+
+/** Receive buffers of a collector. */
+typedef struct {
+    uint8_t bufs[BMP280_LINUX_TELEMETRY_RECV_BATCH][BMP280_TELEMETRY_MAX_FRAME_SIZE];
+} BMP280LinuxTelemetryRecvBufs;
+
+/**
+ * @brief Open a UDP socket connected to a collector.
+ *
+ * @param[in] ipv4_addr Dotted IPv4 address of the collector, e.g. "127.0.0.1".
+ * @param[in] port UDP port of the collector.
+ *
+ * @return int Socket file descriptor, or -1 on error.
+ */
+int bmp280_linux_telemetry_udp_sender_open(const char *ipv4_addr, uint16_t port);
+
+/**
+ * @brief Open a UDP socket that receives frames on @p port of all local addresses.
+ *
+ * @return int Socket file descriptor, or -1 on error.
+ */
+int bmp280_linux_telemetry_udp_collector_open(uint16_t port);
+
+/**
+ * @brief Open a Unix domain datagram socket connected to a collector bound to @p path.
+ *
+ * @return int Socket file descriptor, or -1 on error.
+ */
+int bmp280_linux_telemetry_uds_sender_open(const char *path);
+
+/**
+ * @brief Open a Unix domain datagram socket bound to @p path. An existing socket file at @p path is removed first.
+ *
+ * @return int Socket file descriptor, or -1 on error.
+ */
+int bmp280_linux_telemetry_uds_collector_open(const char *path);
+
+/**
+ * @brief Finish the current frame of @p enc and send it.
+ *
+ * @param[in] fd Connected sender socket.
+ * @param[in] enc Encoder. Nothing is sent if it has no records.
+ *
+ * @retval BMP280_RESULT_CODE_OK Sent the frame, or there was nothing to send.
+ * @retval BMP280_RESULT_CODE_IO_ERR send() failed. The frame is lost, which the collector detects from the sequence
+ * number of the next frame.
+ */
+uint8_t bmp280_linux_telemetry_send(int fd, BMP280TelemetryEncoder *const enc);
+
+/**
+ * @brief Add a record, and send the current frame first if it is full.
+ *
+ * @retval BMP280_RESULT_CODE_OK Added the record.
+ * @retval BMP280_RESULT_CODE_IO_ERR The full frame could not be sent. The record is added to the next frame.
+ */
+uint8_t bmp280_linux_telemetry_add(int fd, BMP280TelemetryEncoder *const enc, uint32_t sensor_id,
+                                   uint32_t timestamp_ms, const BMP280Meas *const meas);
+
+/**
+ * @brief Receive all frames that are waiting on @p fd without blocking, and push them to @p coll.
+ *
+ * @param[in] fd Collector socket.
+ * @param[in] coll Collector.
+ * @param[in] bufs Receive buffers.
+ *
+ * @return size_t Number of received datagrams, including malformed ones.
+ */
+size_t bmp280_linux_telemetry_receive(int fd, BMP280TelemetryCollector *const coll,
+                                      BMP280LinuxTelemetryRecvBufs *const bufs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PORT_LINUX_BMP280_LINUX_TELEMETRY_H */
@@ -3,6 +3,7 @@
 
 #include "bmp280.h"
 #include "bmp280_private.h"
+#include "bmp280_compensate.h"
 
 #define BMP280_CALIB_DATA_START_REG_ADDR 0x88
 #define BMP280_CHIP_ID_REG_ADDR 0xD0
@@ -59,6 +60,18 @@
 /** Value to write to reset register to perform a reset. */
 #define BMP280_RESET_REG_VALUE 0xB6
 
+/** Number of bits in a raw temperature value. */
+#define BMP280_RAW_VAL_NUM_BITS 20
+/** Largest raw temperature value. */
+#define BMP280_RAW_VAL_MAX 0xFFFFF
+
+/** Constant part of the maximum measurement time from the datasheet, section 3.8.1, in microseconds. */
+#define BMP280_MEAS_TIME_BASE_US 1250
+/** Maximum time per temperature or pressure oversampling sample, in microseconds. */
+#define BMP280_MEAS_TIME_PER_SAMPLE_US 2300
+/** Additional maximum measurement time when pressure measurement is enabled, in microseconds. */
+#define BMP280_MEAS_TIME_PRES_US 575
+
 /** The duration of power on reset procedure. This procedure is executed when the device is powered on, or a reset is
  * performed using the reset register. */
 #define BMP280_POWER_ON_RESET_DURATION_MS 2
@@ -159,6 +172,39 @@ static bool is_valid_spi_3_wire(uint8_t spi_3_wire)
     return (spi_3_wire == BMP280_SPI_3_WIRE_DIS) || (spi_3_wire == BMP280_SPI_3_WIRE_EN);
 }
 
+/**
+ * @brief Get the number of samples that an oversampling option averages.
+ *
+ * @param oversampling Oversampling option. Must be one of @ref BMP280Oversampling.
+ *
+ * @return uint32_t Number of samples, 0 for BMP280_OVERSAMPLING_SKIPPED.
+ */
+static uint32_t oversampling_num_samples(uint8_t oversampling)
+{
+    return (oversampling == BMP280_OVERSAMPLING_SKIPPED) ? 0 : ((uint32_t)1 << (oversampling - 1));
+}
+
+/**
+ * @brief Get maximum forced mode measurement time for oversampling options, rounded up to whole ms.
+ *
+ * Follows the formula from the datasheet, section 3.8.1.
+ *
+ * @param temp_oversampling Temperature oversampling option. Must be one of @ref BMP280Oversampling.
+ * @param pres_oversampling Pressure oversampling option. Must be one of @ref BMP280Oversampling.
+ *
+ * @return uint32_t Measurement time in ms.
+ */
+static uint32_t max_meas_time_ms(uint8_t temp_oversampling, uint8_t pres_oversampling)
+{
+    uint32_t time_us =
+        BMP280_MEAS_TIME_BASE_US + BMP280_MEAS_TIME_PER_SAMPLE_US * oversampling_num_samples(temp_oversampling);
+    if (pres_oversampling != BMP280_OVERSAMPLING_SKIPPED) {
+        time_us += BMP280_MEAS_TIME_PER_SAMPLE_US * oversampling_num_samples(pres_oversampling) +
+                   BMP280_MEAS_TIME_PRES_US;
+    }
+    return (time_us + 999) / 1000;
+}
+
 /**
  * @brief Read chip ID from the chip ID regsiter.
  *
@@ -288,75 +334,6 @@ static void execute_complete_cb(BMP280 self, uint8_t rc)
     }
 }
 
-/**
- * @brief Compensate temperature using raw temperature value and temperature calibration values.
- *
- * @param[in] calib_temp Temperature calibration values.
- * @param[in] temp_raw Raw temperature value.
- * @param[out] t_fine Fine resolution temperature value is written to this parameter, so that it can be used in pressure
- * compensation calculation.
- *
- * @return int32_t Temperature in DegC, resolution is 0.01 DegC. Output value of "5123" equals 51.23 DegC.
- */
-static int32_t compensate_temp(const CalibTemp *const calib_temp, int32_t temp_raw, int32_t *const t_fine)
-{
-    uint16_t dig_T1 = calib_temp->dig_T1;
-    int16_t dig_T2 = calib_temp->dig_T2;
-    int16_t dig_T3 = calib_temp->dig_T3;
-
-    int32_t var1 = ((((temp_raw >> 3) - ((int32_t)dig_T1 << 1))) * ((int32_t)dig_T2)) >> 11;
-    int32_t var2 =
-        (((((temp_raw >> 4) - ((int32_t)dig_T1)) * ((temp_raw >> 4) - ((int32_t)dig_T1))) >> 12) * ((int32_t)dig_T3)) >>
-        14;
-    *t_fine = var1 + var2;
-    int32_t T = (*t_fine * 5 + 128) >> 8;
-    return T;
-}
-
-/**
- * @brief Compensate pressure using raw pressure value and pressure calibration values.
- *
- * @param[in] calib Pressure calibration values.
- * @param[in] pres_raw Raw pressure value.
- * @param[in] t_fine Fine resolution temperature value from @ref compensate_temp.
- *
- * @return uint32_t Pressure in Pa in Q24.8 format (24 integer bits and 8 fractional bits). Output value of "24674867"
- * represents 24674867/256 = 96386.2 Pa = 963.862 hPa.
- */
-static uint32_t compensate_pres(const CalibPres *const calib, int32_t pres_raw, int32_t t_fine)
-{
-    int64_t var1, var2, p;
-    var1 = ((int64_t)t_fine) - 128000;
-    var2 = var1 * var1 * (int64_t)calib->dig_P6;
-    var2 = var2 + ((var1 * (int64_t)calib->dig_P5) << 17);
-    var2 = var2 + (((int64_t)calib->dig_P4) << 35);
-    var1 = ((var1 * var1 * (int64_t)calib->dig_P3) >> 8) + ((var1 * (int64_t)calib->dig_P2) << 12);
-    var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)calib->dig_P1) >> 33;
-    if (var1 == 0) {
-        return 0; // avoid exception caused by division by zero
-    }
-    p = 1048576 - pres_raw;
-    p = (((p << 31) - var2) * 3125) / var1;
-    var1 = (((int64_t)calib->dig_P9) * (p >> 13) * (p >> 13)) >> 25;
-    var2 = (((int64_t)calib->dig_P8) * p) >> 19;
-    p = ((p + var1 + var2) >> 8) + (((int64_t)calib->dig_P7) << 4);
-    return (uint32_t)p;
-}
-
-/**
- * @brief Convert temperature/pressure bytes from BMP280 registers to raw value.
- *
- * @param[in] data Must point to a buffer of 3 bytes that contains register values of temp/press_msb, temp/press_lsb,
- * temp/press_xlsb (in that order).
- *
- * @return int32_t Raw value.
- */
-static int32_t temp_pres_bytes_to_raw_val(const uint8_t *const data)
-{
-    uint32_t t = (((uint32_t)data[0]) << 12) | (((uint32_t)data[1]) << 4) | (((uint32_t)(data[2] & 0xF0)) >> 4);
-    return (int32_t)t;
-}
-
 /**
  * @brief Interpret two bytes in little endian as an unsigned 16-bit integer.
  *
@@ -389,7 +366,7 @@ int16_t two_little_endian_bytes_to_int16(const uint8_t *const bytes)
  * @param[in] data Must point to 6 bytes that contain the contents of registers 0x88...0x8D.
  * @param[out] calib_temp Temperature calibration values are written to this parameter.
  */
-static void convert_temp_calib_reg_vals_to_calib_values(const uint8_t *const data, CalibTemp *const calib_temp)
+static void convert_temp_calib_reg_vals_to_calib_values(const uint8_t *const data, BMP280CalibTemp *const calib_temp)
 {
     calib_temp->dig_T1 = two_little_endian_bytes_to_uint16(&data[0]);
     calib_temp->dig_T2 = two_little_endian_bytes_to_int16(&data[2]);
@@ -402,7 +379,7 @@ static void convert_temp_calib_reg_vals_to_calib_values(const uint8_t *const dat
  * @param[in] data Must point to 18 bytes that contain the contents of registers 0x8E...0x9F.
  * @param[out] calib_pres Pressure calibration values are written to this parameter.
  */
-static void convert_pres_calib_reg_vals_to_calib_values(const uint8_t *const data, CalibPres *const calib_pres)
+static void convert_pres_calib_reg_vals_to_calib_values(const uint8_t *const data, BMP280CalibPres *const calib_pres)
 {
     calib_pres->dig_P1 = two_little_endian_bytes_to_uint16(&data[0]);
     calib_pres->dig_P2 = two_little_endian_bytes_to_int16(&data[2]);
@@ -415,6 +392,27 @@ static void convert_pres_calib_reg_vals_to_calib_values(const uint8_t *const dat
     calib_pres->dig_P9 = two_little_endian_bytes_to_int16(&data[16]);
 }
 
+/**
+ * @brief Convert calibration register values in read_buf to calibration values and mark measurements as initialized.
+ *
+ * @pre @p self has been validated to not be NULL. read_buf contains the contents of registers 0x88...0x9F.
+ *
+ * @param self BMP280 instance.
+ */
+static void load_calib_values(BMP280 self)
+{
+    /* First 6 bytes are from temperature calibration registers */
+    convert_temp_calib_reg_vals_to_calib_values(&self->read_buf[0], &self->calib_temp);
+    /* Last 18 bytes are from pressure calibration registers */
+    convert_pres_calib_reg_vals_to_calib_values(&self->read_buf[6], &self->calib_pres);
+    if (self->temp_lut) {
+        /* Calibration values might have changed, entries have to be recalculated */
+        bmp280_temp_lut_build(self->temp_lut, &self->calib_temp, self->temp_lut->entries, self->temp_lut->num_entries,
+                              self->temp_lut->raw_min, self->temp_lut->raw_shift);
+    }
+    self->is_meas_init = true;
+}
+
 static void generic_io_complete_cb(uint8_t io_rc, void *user_data)
 {
     BMP280 self = (BMP280)user_data;
@@ -451,6 +449,46 @@ static void reset_with_delay_part_2(uint8_t io_rc, void *user_data)
                       (void *)self);
 }
 
+/**
+ * @brief Convert measurement register values in read_buf to raw values.
+ *
+ * @param[in] self BMP280 instance.
+ * @param[in] calculate_pres Whether read_buf contains pressure and temperature register values, or only temperature.
+ * @param[out] temp_raw Raw temperature value.
+ * @param[out] pres_raw Raw pressure value. Only written if @p calculate_pres is true.
+ */
+static void read_buf_to_raw_vals(BMP280 self, bool calculate_pres, int32_t *const temp_raw, int32_t *const pres_raw)
+{
+    /* If we also read out pressure, then the first three bytes in read_buf are pressure register values */
+    size_t temp_start_idx = calculate_pres ? 3 : 0;
+    *temp_raw = bmp280_raw_val_from_regs(&self->read_buf[temp_start_idx]);
+    if (calculate_pres) {
+        /* Pressure reg values always start at index 0 of read_buf */
+        *pres_raw = bmp280_raw_val_from_regs(self->read_buf);
+    }
+}
+
+/**
+ * @brief Compensate raw values and write the result to the measurement of the current sequence.
+ *
+ * @param[in] self BMP280 instance.
+ * @param[in] calculate_pres Whether to compensate pressure in addition to temperature.
+ * @param[in] temp_raw Raw temperature value.
+ * @param[in] pres_raw Raw pressure value. Not used if @p calculate_pres is false.
+ */
+static void compensate_meas(BMP280 self, bool calculate_pres, int32_t temp_raw, int32_t pres_raw)
+{
+    int32_t t_fine;
+    if (self->temp_lut) {
+        (self->meas)->temperature = bmp280_compensate_temp_lut(self->temp_lut, &self->calib_temp, temp_raw, &t_fine);
+    } else {
+        (self->meas)->temperature = bmp280_compensate_temp(&self->calib_temp, temp_raw, &t_fine);
+    }
+    if (calculate_pres) {
+        (self->meas)->pressure = bmp280_compensate_pres(&self->calib_pres, pres_raw, t_fine);
+    }
+}
+
 static void read_meas_forced_mode_part_5(uint8_t io_rc, void *user_data)
 {
     BMP280 self = (BMP280)user_data;
@@ -470,17 +508,10 @@ static void read_meas_forced_mode_part_5(uint8_t io_rc, void *user_data)
         return;
     }
 
-    /* If we also read out pressure, then the first three bytes in read_buf are pressure register values */
-    size_t temp_start_idx = calculate_pres ? 3 : 0;
-    int32_t temp_raw = temp_pres_bytes_to_raw_val(&self->read_buf[temp_start_idx]);
-    int32_t t_fine;
-    (self->meas)->temperature = compensate_temp(&self->calib_temp, temp_raw, &t_fine);
-
-    if (calculate_pres) {
-        /* Pressure reg values always start at index 0 of read_buf */
-        int32_t pres_raw = temp_pres_bytes_to_raw_val(self->read_buf);
-        (self->meas)->pressure = compensate_pres(&self->calib_pres, pres_raw, t_fine);
-    }
+    int32_t temp_raw;
+    int32_t pres_raw = 0;
+    read_buf_to_raw_vals(self, calculate_pres, &temp_raw, &pres_raw);
+    compensate_meas(self, calculate_pres, temp_raw, pres_raw);
     execute_complete_cb(self, BMP280_RESULT_CODE_OK);
 }
 
@@ -505,6 +536,43 @@ static void read_meas_forced_mode_part_4(void *user_data)
                     (void *)self);
 }
 
+/**
+ * @brief Executed when one of the events that lazy read_meas_forced_mode waits for has occurred.
+ *
+ * Reads the measurement registers once both the timer has expired and the calibration readout is complete.
+ *
+ * @param self BMP280 instance.
+ */
+static void read_meas_forced_mode_lazy_event(BMP280 self)
+{
+    self->num_pending_events--;
+    if (self->num_pending_events > 0) {
+        return;
+    }
+
+    if (self->calib_io_rc != BMP280_IO_RESULT_CODE_OK) {
+        execute_complete_cb(self, BMP280_RESULT_CODE_IO_ERR);
+        return;
+    }
+    read_meas_forced_mode_part_4((void *)self);
+}
+
+static void read_meas_forced_mode_lazy_timer_expired(void *user_data)
+{
+    BMP280 self = (BMP280)user_data;
+    read_meas_forced_mode_lazy_event(self);
+}
+
+static void read_meas_forced_mode_lazy_calib_read(uint8_t io_rc, void *user_data)
+{
+    BMP280 self = (BMP280)user_data;
+    self->calib_io_rc = io_rc;
+    if (io_rc == BMP280_IO_RESULT_CODE_OK) {
+        load_calib_values(self);
+    }
+    read_meas_forced_mode_lazy_event(self);
+}
+
 static void read_meas_forced_mode_part_3(uint8_t io_rc, void *user_data)
 {
     BMP280 self = (BMP280)user_data;
@@ -513,7 +581,18 @@ static void read_meas_forced_mode_part_3(uint8_t io_rc, void *user_data)
         return;
     }
 
-    self->start_timer(self->timer_period_ms, self->start_timer_user_data, read_meas_forced_mode_part_4, (void *)self);
+    if (self->is_meas_init) {
+        self->start_timer(self->timer_period_ms, self->start_timer_user_data, read_meas_forced_mode_part_4,
+                          (void *)self);
+        return;
+    }
+
+    /* Calibration values are read out while the device is converting. Set before starting the timer and the readout,
+     * in case either of them completes immediately. */
+    self->num_pending_events = 2;
+    self->start_timer(self->timer_period_ms, self->start_timer_user_data, read_meas_forced_mode_lazy_timer_expired,
+                      (void *)self);
+    read_calib_data(self, self->read_buf, read_meas_forced_mode_lazy_calib_read, (void *)self);
 }
 
 static void read_meas_forced_mode_part_2(uint8_t io_rc, void *user_data)
@@ -533,6 +612,107 @@ static void read_meas_forced_mode_part_2(uint8_t io_rc, void *user_data)
     write_ctrl_meas_reg(self, write_val, read_meas_forced_mode_part_3, (void *)self);
 }
 
+/**
+ * @brief End continuous forced mode.
+ *
+ * @param self BMP280 instance.
+ * @param rc BMP280_RESULT_CODE_OK if continuous forced mode ended because it was stopped, otherwise the error that
+ * ended it. The error is passed to the sample callback.
+ */
+static void continuous_forced_mode_end(BMP280 self, uint8_t rc)
+{
+    /* Cleared before executing the callbacks, so that they can start new sequences */
+    self->seq_in_progress = false;
+    self->is_continuous = false;
+    if ((rc != BMP280_RESULT_CODE_OK) && self->complete_cb) {
+        self->complete_cb(rc, self->complete_cb_user_data);
+    }
+    if (self->stop_requested && self->stop_cb) {
+        self->stop_cb(BMP280_RESULT_CODE_OK, self->stop_cb_user_data);
+    }
+}
+
+static void continuous_forced_mode_part_3(uint8_t io_rc, void *user_data);
+
+static void continuous_forced_mode_part_5(uint8_t io_rc, void *user_data)
+{
+    BMP280 self = (BMP280)user_data;
+    if (io_rc != BMP280_IO_RESULT_CODE_OK) {
+        continuous_forced_mode_end(self, BMP280_RESULT_CODE_IO_ERR);
+        return;
+    }
+
+    /* meas_type was validated when continuous forced mode was started */
+    bool calculate_pres = (self->meas_type == BMP280_MEAS_TYPE_TEMP_AND_PRES);
+    int32_t temp_raw;
+    int32_t pres_raw = 0;
+    /* Raw values are taken out of read_buf before the next conversion is triggered, read_buf is reused by the next
+     * data read */
+    read_buf_to_raw_vals(self, calculate_pres, &temp_raw, &pres_raw);
+
+    /* Trigger the next conversion before compensating this sample, so that compensation and sample callback execution
+     * overlap with the write transaction and the next conversion */
+    bool retriggered = !self->stop_requested;
+    if (retriggered) {
+        write_ctrl_meas_reg(self, self->ctrl_meas_forced, continuous_forced_mode_part_3, (void *)self);
+    }
+
+    compensate_meas(self, calculate_pres, temp_raw, pres_raw);
+    if (self->complete_cb) {
+        self->complete_cb(BMP280_RESULT_CODE_OK, self->complete_cb_user_data);
+    }
+
+    if (!retriggered) {
+        continuous_forced_mode_end(self, BMP280_RESULT_CODE_OK);
+    }
+}
+
+static void continuous_forced_mode_part_4(void *user_data)
+{
+    BMP280 self = (BMP280)user_data;
+    size_t num_regs = (self->meas_type == BMP280_MEAS_TYPE_TEMP_AND_PRES) ? 6 : 3;
+    uint8_t start_addr =
+        (self->meas_type == BMP280_MEAS_TYPE_TEMP_AND_PRES) ? BMP280_PRES_MSB_REG_ADDR : BMP280_TEMP_MSB_REG_ADDR;
+    self->read_regs(start_addr, num_regs, self->read_buf, self->read_regs_user_data, continuous_forced_mode_part_5,
+                    (void *)self);
+}
+
+static void continuous_forced_mode_part_3(uint8_t io_rc, void *user_data)
+{
+    BMP280 self = (BMP280)user_data;
+    if (io_rc != BMP280_IO_RESULT_CODE_OK) {
+        continuous_forced_mode_end(self, BMP280_RESULT_CODE_IO_ERR);
+        return;
+    }
+    if (self->stop_requested) {
+        /* Stop was requested from the sample callback after the conversion was triggered. The device goes back to
+         * sleep mode on its own once the conversion is complete. */
+        continuous_forced_mode_end(self, BMP280_RESULT_CODE_OK);
+        return;
+    }
+
+    self->start_timer(self->timer_period_ms, self->start_timer_user_data, continuous_forced_mode_part_4, (void *)self);
+}
+
+static void continuous_forced_mode_part_2(uint8_t io_rc, void *user_data)
+{
+    BMP280 self = (BMP280)user_data;
+    if (io_rc != BMP280_IO_RESULT_CODE_OK) {
+        continuous_forced_mode_end(self, BMP280_RESULT_CODE_IO_ERR);
+        return;
+    }
+
+    uint8_t write_val = self->read_buf[0];
+    /* Clear the two LSb of ctrl_meas register value */
+    write_val = write_val & ~((uint8_t)0x3U);
+    /* Set the two LSb of ctrl_meas register value to forced mode */
+    write_val = write_val | (uint8_t)BMP280_BIT_MSK_POWER_MODE_FORCED;
+    /* Every following conversion is triggered by writing this value, without reading ctrl_meas again */
+    self->ctrl_meas_forced = write_val;
+
+    write_ctrl_meas_reg(self, write_val, continuous_forced_mode_part_3, (void *)self);
+}
+
 static void set_temp_oversamlping_part_2(uint8_t io_rc, void *user_data)
 {
     BMP280 self = (BMP280)user_data;
@@ -609,12 +789,7 @@ static void init_meas_part_2(uint8_t io_rc, void *user_data)
         return;
     }
 
-    /* First 6 bytes are from temperature calibration registers */
-    convert_temp_calib_reg_vals_to_calib_values(&self->read_buf[0], &self->calib_temp);
-    /* Last 18 bytes are from pressure calibration registers */
-    convert_pres_calib_reg_vals_to_calib_values(&self->read_buf[6], &self->calib_pres);
-
-    self->is_meas_init = true;
+    load_calib_values(self);
     execute_complete_cb(self, BMP280_RESULT_CODE_OK);
 }
 
@@ -635,7 +810,10 @@ uint8_t bmp280_create(BMP280 *const inst, const BMP280InitCfg *const cfg)
     (*inst)->write_reg_user_data = cfg->write_reg_user_data;
     (*inst)->start_timer = cfg->start_timer;
     (*inst)->start_timer_user_data = cfg->start_timer_user_data;
+    (*inst)->temp_lut = NULL;
     (*inst)->is_meas_init = false;
+    (*inst)->lazy_init_meas = cfg->lazy_init_meas;
+    (*inst)->is_continuous = false;
     (*inst)->seq_in_progress = false;
 
     return BMP280_RESULT_CODE_OK;
@@ -692,7 +870,7 @@ uint8_t bmp280_read_meas_forced_mode(BMP280 self, uint8_t meas_type, uint32_t me
     if (self->seq_in_progress) {
         return BMP280_RESULT_CODE_BUSY;
     }
-    if (!self->is_meas_init) {
+    if (!self->is_meas_init && !self->lazy_init_meas) {
         return BMP280_RESULT_CODE_INVAL_USAGE;
     }
 
@@ -704,6 +882,75 @@ uint8_t bmp280_read_meas_forced_mode(BMP280 self, uint8_t meas_type, uint32_t me
     return BMP280_RESULT_CODE_OK;
 }
 
+uint8_t bmp280_read_meas_forced_mode_with_oversampling(BMP280 self, uint8_t temp_oversampling,
+                                                       uint8_t pres_oversampling, BMP280Meas *const meas,
+                                                       BMP280CompleteCb cb, void *user_data)
+{
+    /* Pressure compensation needs the temperature measurement, so temperature cannot be skipped */
+    if (!self || !meas || (temp_oversampling == BMP280_OVERSAMPLING_SKIPPED) ||
+        !is_valid_oversampling(temp_oversampling) || !is_valid_oversampling(pres_oversampling)) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    if (self->seq_in_progress) {
+        return BMP280_RESULT_CODE_BUSY;
+    }
+    if (!self->is_meas_init && !self->lazy_init_meas) {
+        return BMP280_RESULT_CODE_INVAL_USAGE;
+    }
+
+    start_sequence(self, cb, user_data);
+    self->meas = meas;
+    self->meas_type = (pres_oversampling == BMP280_OVERSAMPLING_SKIPPED) ? BMP280_MEAS_TYPE_ONLY_TEMP
+                                                                          : BMP280_MEAS_TYPE_TEMP_AND_PRES;
+    self->timer_period_ms = max_meas_time_ms(temp_oversampling, pres_oversampling);
+    /* osrs_t, osrs_p and mode are the whole ctrl_meas register, so it does not have to be read first */
+    uint8_t write_val = BMP280_BIT_MSK_CTRL_MEAS_OSRS_T_OPTION(temp_oversampling) |
+                        BMP280_BIT_MSK_CTRL_MEAS_OSRS_P_OPTION(pres_oversampling) |
+                        (uint8_t)BMP280_BIT_MSK_POWER_MODE_FORCED;
+    write_ctrl_meas_reg(self, write_val, read_meas_forced_mode_part_3, (void *)self);
+    return BMP280_RESULT_CODE_OK;
+}
+
+uint8_t bmp280_start_continuous_forced_mode(BMP280 self, uint8_t meas_type, uint32_t meas_time_ms,
+                                            BMP280Meas *const meas, BMP280CompleteCb cb, void *user_data)
+{
+    if (!self || !meas || (meas_time_ms == 0) || !is_valid_meas_type(meas_type)) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    if (self->seq_in_progress) {
+        return BMP280_RESULT_CODE_BUSY;
+    }
+    if (!self->is_meas_init) {
+        return BMP280_RESULT_CODE_INVAL_USAGE;
+    }
+
+    start_sequence(self, cb, user_data);
+    self->is_continuous = true;
+    self->stop_requested = false;
+    self->stop_cb = NULL;
+    self->stop_cb_user_data = NULL;
+    self->meas = meas;
+    self->meas_type = meas_type;
+    self->timer_period_ms = meas_time_ms;
+    read_ctrl_meas_reg(self, self->read_buf, continuous_forced_mode_part_2, (void *)self);
+    return BMP280_RESULT_CODE_OK;
+}
+
+uint8_t bmp280_stop_continuous_forced_mode(BMP280 self, BMP280CompleteCb cb, void *user_data)
+{
+    if (!self) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    if (!self->is_continuous || self->stop_requested) {
+        return BMP280_RESULT_CODE_INVAL_USAGE;
+    }
+
+    self->stop_requested = true;
+    self->stop_cb = cb;
+    self->stop_cb_user_data = user_data;
+    return BMP280_RESULT_CODE_OK;
+}
+
 uint8_t bmp280_set_temp_oversampling(BMP280 self, uint8_t oversampling, BMP280CompleteCb cb, void *user_data)
 {
     if (!self || !is_valid_oversampling(oversampling)) {
@@ -763,3 +1010,33 @@ uint8_t bmp280_set_spi_3_wire_interface(BMP280 self, uint8_t spi_3_wire, BMP280C
     read_config_reg(self, self->read_buf, set_spi_3_wire_interface_part_2, (void *)self);
     return BMP280_RESULT_CODE_OK;
 }
+
+uint8_t bmp280_enable_temp_lut(BMP280 self, BMP280TempLut *const lut, BMP280TempLutEntry *const entries,
+                               size_t num_entries, int32_t raw_min, uint8_t raw_shift)
+{
+    if (!self || !lut || !entries || (num_entries == 0) || (raw_shift >= BMP280_RAW_VAL_NUM_BITS) || (raw_min < 0) ||
+        (raw_min > BMP280_RAW_VAL_MAX)) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    /* The raw value of the last entry must not wrap around or leave the 20-bit raw range */
+    if ((uint64_t)(num_entries - 1) > ((uint64_t)(BMP280_RAW_VAL_MAX - raw_min) >> raw_shift)) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    if (!self->is_meas_init) {
+        return BMP280_RESULT_CODE_INVAL_USAGE;
+    }
+
+    bmp280_temp_lut_build(lut, &self->calib_temp, entries, num_entries, raw_min, raw_shift);
+    self->temp_lut = lut;
+    return BMP280_RESULT_CODE_OK;
+}
+
+uint8_t bmp280_disable_temp_lut(BMP280 self)
+{
+    if (!self) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    self->temp_lut = NULL;
+    return BMP280_RESULT_CODE_OK;
+}
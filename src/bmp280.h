@@ -7,8 +7,10 @@ extern "C"
 #endif
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "bmp280_defs.h"
+#include "bmp280_compensate.h"
 
 typedef struct BMP280Struct *BMP280;
 
@@ -108,6 +110,9 @@ typedef struct {
     BMP280StartTimer start_timer;
     /** User data to pass to start_timer function. */
     void *start_timer_user_data;
+    /** If true, @ref bmp280_read_meas_forced_mode can be called before @ref bmp280_init_meas. The first measurement
+     * then reads out calibration values while the device is converting. */
+    bool lazy_init_meas;
 } BMP280InitCfg;
 
 /**
@@ -191,13 +196,20 @@ uint8_t bmp280_init_meas(BMP280 self, BMP280CompleteCb cb, void *user_data);
 /**
  * @brief Perform one temperature and/or pressure measurement in forced mode.
  *
- * @pre @ref bmp280_init_meas has been called for this BMP280 instance.
+ * @pre @ref bmp280_init_meas has been called for this BMP280 instance, or the instance was created with
+ * lazy_init_meas set in its init cfg.
  *
  * This function performs the following steps:
  * 1. Set mode to forced mode in ctrl_meas register.
  * 2. Wait for @p meas_time_ms ms.
  * 3. Read temperature and/or pressure measurement from the registers and convert them to DegC/Pa units.
  *
+ * If the instance was created with lazy_init_meas and @ref bmp280_init_meas has not completed yet, calibration values
+ * are read out during step 2, while the device is converting. Step 3 starts once both the wait and the calibration
+ * readout are complete. This saves one bus transaction round before the first measurement compared to calling @ref
+ * bmp280_init_meas first. If the calibration readout fails, @p cb is executed with BMP280_RESULT_CODE_IO_ERR and the
+ * next measurement reads out calibration values again.
+ *
  * If @p meas_type is BMP280_MEAS_TYPE_ONLY_TEMP, only temperature measurement is read out (3 registers). In this case,
  * "pressure" field of @p meas has undefined value and should not be used.
  *
@@ -230,12 +242,122 @@ uint8_t bmp280_init_meas(BMP280 self, BMP280CompleteCb cb, void *user_data);
  * @retval BMP280_RESULT_CODE_OK Successfully initiated the measurement.
  * @retval BMP280_RESULT_CODE_INVAL_ARG @p self is NULL, @p meas is NULL, @p meas_type is not one of @ref
  * BMP280MeasType, or @p meas_time is 0.
- * @retval BMP280_RESULT_CODE_INVAL_USAGE @ref bmp280_init_meas has not been called for this BMP280 instance.
+ * @retval BMP280_RESULT_CODE_INVAL_USAGE @ref bmp280_init_meas has not been called for this BMP280 instance, and the
+ * instance was not created with lazy_init_meas.
  * @retval BMP280_RESULT_CODE_BUSY Another operation is already in progress, failed to start this operation.
  */
 uint8_t bmp280_read_meas_forced_mode(BMP280 self, uint8_t meas_type, uint32_t meas_time_ms, BMP280Meas *const meas,
                                      BMP280CompleteCb cb, void *user_data);
 
+/**
+ * @brief Perform one forced mode measurement with the given oversampling options.
+ *
+ * @pre Same as for @ref bmp280_read_meas_forced_mode.
+ *
+ * Same as @ref bmp280_read_meas_forced_mode, except that the oversampling options are set in the same ctrl_meas write
+ * that sets forced mode. osrs_t, osrs_p and mode make up the whole ctrl_meas register, so ctrl_meas is not read first.
+ * This way, consumers that need different precision can alternate between oversampling options without separate
+ * @ref bmp280_set_temp_oversampling and @ref bmp280_set_pres_oversampling calls, and each measurement takes one
+ * register write, the wait and one data read.
+ *
+ * The wait time is the maximum measurement time for @p temp_oversampling and @p pres_oversampling, calculated with the
+ * formula from the datasheet, section 3.8.1, and rounded up to whole milliseconds.
+ *
+ * If @p pres_oversampling is BMP280_OVERSAMPLING_SKIPPED, only temperature is read out, and "pressure" field of @p meas
+ * has undefined value. Otherwise, both temperature and pressure are read out.
+ *
+ * The oversampling options stay in ctrl_meas after the measurement, so they also apply to later calls of @ref
+ * bmp280_read_meas_forced_mode.
+ *
+ * Once measurement is complete or an error occurrs, @p cb is executed. "rc" parameter of @p cb indicates
+ * success or reason for failure:
+ * - @ref BMP280_RESULT_CODE_OK Successfully completed the measurement.
+ * - @ref BMP280_RESULT_CODE_IO_ERR One of the IO transactions failed.
+ * - @ref BMP280_RESULT_CODE_DRIVER_ERR Something went wrong in the code of this driver.
+ *
+ * @param[in] self BMP280 instance created by @ref bmp280_create.
+ * @param[in] temp_oversampling Temperature oversampling option. Must be one of @ref BMP280Oversampling, other than
+ * BMP280_OVERSAMPLING_SKIPPED.
+ * @param[in] pres_oversampling Pressure oversampling option. Must be one of @ref BMP280Oversampling.
+ * @param[out] meas Measurement result is written to this parameter. Cannot be NULL.
+ * @param[in] cb Callback to execute once measurement is complete.
+ * @param[in] user_data User data to pass to @p cb.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully initiated the measurement.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p self is NULL, @p meas is NULL, @p temp_oversampling is skipped or not one of
+ * @ref BMP280Oversampling, or @p pres_oversampling is not one of @ref BMP280Oversampling.
+ * @retval BMP280_RESULT_CODE_INVAL_USAGE Same as for @ref bmp280_read_meas_forced_mode.
+ * @retval BMP280_RESULT_CODE_BUSY Another operation is already in progress, failed to start this operation.
+ */
+uint8_t bmp280_read_meas_forced_mode_with_oversampling(BMP280 self, uint8_t temp_oversampling,
+                                                       uint8_t pres_oversampling, BMP280Meas *const meas,
+                                                       BMP280CompleteCb cb, void *user_data);
+
+/**
+ * @brief Start continuous temperature and/or pressure measurements in forced mode.
+ *
+ * @pre @ref bmp280_init_meas has been called for this BMP280 instance.
+ *
+ * Reads ctrl_meas once, then repeats the following steps until @ref bmp280_stop_continuous_forced_mode is called or
+ * an error occurs:
+ * 1. Set mode to forced mode in ctrl_meas register, using the ctrl_meas value read when continuous forced mode was
+ * started.
+ * 2. Wait for @p meas_time_ms ms.
+ * 3. Read temperature and/or pressure measurement registers.
+ * 4. Trigger the next conversion (step 1), then convert the register values of this sample to DegC/Pa units, write
+ * them to @p meas and execute @p cb.
+ *
+ * Compared to calling @ref bmp280_read_meas_forced_mode from its own complete callback, every sample saves the
+ * ctrl_meas read, and compensation and @p cb execution overlap with the next conversion. The sample period is one
+ * register write, @p meas_time_ms and one data read.
+ *
+ * @p cb is executed once per sample. "rc" parameter of @p cb indicates success or reason for failure:
+ * - @ref BMP280_RESULT_CODE_OK A new sample is available in @p meas. @p meas is only valid until @p cb returns, the
+ * next sample overwrites it.
+ * - @ref BMP280_RESULT_CODE_IO_ERR One of the IO transactions failed. Continuous forced mode has ended, and new
+ * operations can be started from @p cb.
+ *
+ * ctrl_meas is not read again while continuous forced mode is running. Stop continuous forced mode before changing
+ * oversampling settings. Other operations on this instance return BMP280_RESULT_CODE_BUSY while it is running.
+ *
+ * @param[in] self BMP280 instance created by @ref bmp280_create.
+ * @param[in] meas_type Measurement type. Must be one of @ref BMP280MeasType.
+ * @param[in] meas_time_ms Number of milliseconds to wait between setting forced mode and reading temperature/pressure
+ * registers. Cannot be 0.
+ * @param[out] meas Every sample is written to this parameter. "pressure" field is only valid if @p meas_type is
+ * BMP280_MEAS_TYPE_TEMP_AND_PRES. Cannot be NULL.
+ * @param[in] cb Callback to execute once per sample.
+ * @param[in] user_data User data to pass to @p cb.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully started continuous forced mode.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p self is NULL, @p meas is NULL, @p meas_type is not one of @ref
+ * BMP280MeasType, or @p meas_time is 0.
+ * @retval BMP280_RESULT_CODE_INVAL_USAGE @ref bmp280_init_meas has not been called for this BMP280 instance.
+ * @retval BMP280_RESULT_CODE_BUSY Another operation is already in progress, failed to start this operation.
+ */
+uint8_t bmp280_start_continuous_forced_mode(BMP280 self, uint8_t meas_type, uint32_t meas_time_ms,
+                                            BMP280Meas *const meas, BMP280CompleteCb cb, void *user_data);
+
+/**
+ * @brief Stop continuous forced mode.
+ *
+ * Continuous forced mode ends at the next step boundary. If the data registers of a sample are being read or will be
+ * read, that sample is still delivered to the sample callback and no new conversion is triggered. If the next
+ * conversion has already been triggered, it is discarded. @p cb is executed once continuous forced mode has ended, new
+ * operations can be started from it. "rc" parameter of @p cb is always BMP280_RESULT_CODE_OK.
+ *
+ * Can be called from the sample callback.
+ *
+ * @param[in] self BMP280 instance created by @ref bmp280_create.
+ * @param[in] cb Callback to execute once continuous forced mode has ended.
+ * @param[in] user_data User data to pass to @p cb.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully requested to stop continuous forced mode.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p self is NULL.
+ * @retval BMP280_RESULT_CODE_INVAL_USAGE Continuous forced mode is not running, or stop has already been requested.
+ */
+uint8_t bmp280_stop_continuous_forced_mode(BMP280 self, BMP280CompleteCb cb, void *user_data);
+
 /**
  * @brief Set temperature oversampling option.
  *
@@ -312,6 +434,53 @@ uint8_t bmp280_set_filter_coefficient(BMP280 self, uint8_t filter_coeff, BMP280C
  */
 uint8_t bmp280_set_spi_3_wire_interface(BMP280 self, uint8_t spi_3_wire, BMP280CompleteCb cb, void *user_data);
 
+/**
+ * @brief Enable temperature lookup table for this instance.
+ *
+ * @pre @ref bmp280_init_meas has been called for this BMP280 instance.
+ *
+ * Precomputes temperature compensation results for @p num_entries raw temperature values: @p raw_min, @p raw_min + (1
+ * << @p raw_shift), @p raw_min + 2 * (1 << @p raw_shift), and so on. After that, temperature compensation of a raw
+ * value that is covered by the table is a single table lookup. Raw values that are not covered by the table are
+ * compensated by calculation. Results are exactly the same in both cases.
+ *
+ * The table is built synchronously in this function, which takes @p num_entries temperature compensation calculations.
+ * If @ref bmp280_init_meas is called again later, the table is rebuilt with the new calibration values. The instance
+ * only keeps a pointer to @p lut, so instances without a table do not pay for its memory.
+ *
+ * The choice of @p raw_shift depends on the temperature oversampling setting. With oversampling x1, x2, x4, x8 and x16,
+ * the 4, 3, 2, 1 and 0 LSb of the raw temperature value are always 0, so @p raw_shift should be 4, 3, 2, 1 and 0
+ * respectively. A larger @p raw_shift covers a wider temperature range with the same memory.
+ *
+ * @param[in] self BMP280 instance created by @ref bmp280_create.
+ * @param[out] lut Memory for the table itself. Must stay valid until @ref bmp280_disable_temp_lut is called.
+ * @param[in] entries Memory for table entries. Must be a buffer of @p num_entries elements that stays valid until @ref
+ * bmp280_disable_temp_lut is called.
+ * @param[in] num_entries Number of table entries. Cannot be 0.
+ * @param[in] raw_min Raw temperature value of the first table entry. 0 to 0xFFFFF.
+ * @param[in] raw_shift Raw values of consecutive table entries are (1 << @p raw_shift) apart. Must be less than 20.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully enabled the lookup table.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p self, @p lut or @p entries is NULL, @p num_entries is 0, @p raw_shift is not
+ * less than 20, @p raw_min is not a 20-bit raw value, or the raw value of the last entry is above 0xFFFFF.
+ * @retval BMP280_RESULT_CODE_INVAL_USAGE @ref bmp280_init_meas has not been called for this BMP280 instance.
+ */
+uint8_t bmp280_enable_temp_lut(BMP280 self, BMP280TempLut *const lut, BMP280TempLutEntry *const entries,
+                               size_t num_entries, int32_t raw_min, uint8_t raw_shift);
+
+/**
+ * @brief Disable temperature lookup table for this instance.
+ *
+ * After this function returns, the driver no longer accesses the table and entries passed to @ref
+ * bmp280_enable_temp_lut.
+ *
+ * @param[in] self BMP280 instance created by @ref bmp280_create.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully disabled the lookup table.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p self is NULL.
+ */
+uint8_t bmp280_disable_temp_lut(BMP280 self);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,345 @@
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "bmp280_array.h"
+
+/** Upper bound of pres_tolerance and temp_tolerance, keeps weighted sums of deviations within 64 bits. */
+#define BMP280_ARRAY_MAX_TOLERANCE ((1UL << 24) - 1)
+/** Largest allowed offset_shift. */
+#define BMP280_ARRAY_MAX_OFFSET_SHIFT 16
+/** Number of additional fractional bits of learned offsets, so that small deviations still move them. */
+#define BMP280_ARRAY_OFFSET_FRAC_BITS 8
+/** Time constant of noise variance estimates, 2^BMP280_ARRAY_NOISE_SHIFT reads. */
+#define BMP280_ARRAY_NOISE_SHIFT 4
+/** Added to every noise variance estimate before computing weights: (0.1 Pa)^2 in (Q24.8 Pa)^2. */
+#define BMP280_ARRAY_NOISE_VAR_FLOOR 655
+/** Weight of a member is this divided by its noise variance. */
+#define BMP280_ARRAY_WEIGHT_SCALE (1ULL << 40)
+
+/* Operating range from the datasheet */
+#define BMP280_ARRAY_PRES_MIN (30000UL * 256)
+#define BMP280_ARRAY_PRES_MAX (110000UL * 256)
+#define BMP280_ARRAY_TEMP_MIN -4000
+#define BMP280_ARRAY_TEMP_MAX 8500
+
+uint8_t bmp280_array_init(BMP280Array *const array, const BMP280ArrayCfg *const cfg)
+{
+    if (!array || !cfg) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    if (cfg->pres_tolerance == 0 || cfg->pres_tolerance > BMP280_ARRAY_MAX_TOLERANCE || cfg->temp_tolerance == 0 ||
+        cfg->temp_tolerance > BMP280_ARRAY_MAX_TOLERANCE || cfg->min_members == 0 ||
+        cfg->min_members > BMP280_ARRAY_MAX_MEMBERS || cfg->offset_shift > BMP280_ARRAY_MAX_OFFSET_SHIFT ||
+        cfg->max_consecutive_failures == 0 || cfg->probe_interval == 0) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    array->cfg = *cfg;
+    array->num_members = 0;
+    array->busy = false;
+    array->num_pending = 0;
+    array->meas = NULL;
+    array->cb = NULL;
+    array->user_data = NULL;
+    array->num_reads = 0;
+    return BMP280_RESULT_CODE_OK;
+}
+
+uint8_t bmp280_array_add(BMP280Array *const array, BMP280 inst)
+{
+    if (!array || !inst) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    if (array->busy) {
+        return BMP280_RESULT_CODE_BUSY;
+    }
+    if (array->num_members == BMP280_ARRAY_MAX_MEMBERS) {
+        return BMP280_RESULT_CODE_NO_MEM;
+    }
+
+    BMP280ArrayMember *m = &array->members[array->num_members++];
+    m->inst = inst;
+    m->array = array;
+    m->rc = BMP280_RESULT_CODE_OK;
+    m->triggered = false;
+    m->offset_frac = 0;
+    m->stats.num_reads = 0;
+    m->stats.num_errors = 0;
+    m->stats.num_out_of_range = 0;
+    m->stats.num_outliers = 0;
+    m->stats.num_accepted = 0;
+    m->stats.consecutive_failures = 0;
+    m->stats.probing = false;
+    m->stats.offset = 0;
+    m->stats.weight = 0;
+    m->stats.noise_var = 0;
+    return BMP280_RESULT_CODE_OK;
+}
+
+static int64_t abs64(int64_t x)
+{
+    return (x < 0) ? -x : x;
+}
+
+static int64_t median(const int64_t *const values, size_t num)
+{
+    int64_t sorted[BMP280_ARRAY_MAX_MEMBERS];
+    for (size_t i = 0; i < num; i++) {
+        size_t j = i;
+        for (; j > 0 && sorted[j - 1] > values[i]; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = values[i];
+    }
+    return (num % 2 == 1) ? sorted[num / 2] : (sorted[num / 2 - 1] + sorted[num / 2]) / 2;
+}
+
+static void member_failed(const BMP280Array *const array, BMP280ArrayMember *const m)
+{
+    m->stats.weight = 0;
+    if (++m->stats.consecutive_failures >= array->cfg.max_consecutive_failures) {
+        m->stats.probing = true;
+    }
+}
+
+static void member_accepted(BMP280ArrayMember *const m)
+{
+    m->stats.num_accepted++;
+    m->stats.consecutive_failures = 0;
+    m->stats.probing = false;
+}
+
+/** Update learned offsets with the fused pressure, and keep them at zero mean. */
+static void update_offsets(BMP280Array *const array, const bool *const accepted, int64_t fused_pres)
+{
+    uint8_t shift = array->cfg.offset_shift;
+    int64_t sum = 0;
+    int64_t num = 0;
+    for (size_t i = 0; i < array->num_members; i++) {
+        BMP280ArrayMember *m = &array->members[i];
+        if (accepted[i]) {
+            int64_t e = ((int64_t)m->meas.pressure - fused_pres) * (1 << BMP280_ARRAY_OFFSET_FRAC_BITS);
+            m->offset_frac += (int32_t)((e - m->offset_frac) >> shift);
+        }
+        /* Members that do not contribute to this read keep their offsets, so that the others do not shift */
+        if (m->stats.num_accepted > 0) {
+            sum += m->offset_frac;
+            num++;
+        }
+    }
+    int32_t mean = (int32_t)(sum / num);
+    for (size_t i = 0; i < array->num_members; i++) {
+        BMP280ArrayMember *m = &array->members[i];
+        if (m->stats.num_accepted > 0) {
+            m->offset_frac -= mean;
+            m->stats.offset = m->offset_frac / (1 << BMP280_ARRAY_OFFSET_FRAC_BITS);
+        }
+    }
+}
+
+/** Update noise variance estimates from the deviation of every member from the mean of the others. */
+static void update_noise(BMP280Array *const array, const bool *const accepted, const int64_t *const pres,
+                         size_t num_accepted)
+{
+    if (num_accepted < 2) {
+        return;
+    }
+    int64_t sum = 0;
+    for (size_t i = 0; i < array->num_members; i++) {
+        sum += accepted[i] ? pres[i] : 0;
+    }
+    for (size_t i = 0; i < array->num_members; i++) {
+        if (!accepted[i]) {
+            continue;
+        }
+        BMP280ArrayMember *m = &array->members[i];
+        int64_t others_mean = (sum - pres[i]) / (int64_t)(num_accepted - 1);
+        int64_t r = pres[i] - others_mean;
+        int64_t var = (int64_t)m->stats.noise_var;
+        m->stats.noise_var = (uint64_t)(var + ((r * r - var) >> BMP280_ARRAY_NOISE_SHIFT));
+    }
+}
+
+static uint8_t fuse(BMP280Array *const array)
+{
+    bool with_pres = array->meas_type == BMP280_MEAS_TYPE_TEMP_AND_PRES;
+    /* Offset-corrected pressures and temperatures by member, and of valid members only for the medians */
+    int64_t pres[BMP280_ARRAY_MAX_MEMBERS];
+    int64_t temps[BMP280_ARRAY_MAX_MEMBERS];
+    int64_t valid_pres[BMP280_ARRAY_MAX_MEMBERS];
+    int64_t valid_temps[BMP280_ARRAY_MAX_MEMBERS];
+    bool valid[BMP280_ARRAY_MAX_MEMBERS];
+    bool accepted[BMP280_ARRAY_MAX_MEMBERS];
+    size_t num_valid = 0;
+
+    for (size_t i = 0; i < array->num_members; i++) {
+        BMP280ArrayMember *m = &array->members[i];
+        valid[i] = false;
+        accepted[i] = false;
+        if (!m->triggered) {
+            continue;
+        }
+        if (m->rc != BMP280_RESULT_CODE_OK) {
+            m->stats.num_errors++;
+            member_failed(array, m);
+            continue;
+        }
+        if (m->meas.temperature < BMP280_ARRAY_TEMP_MIN || m->meas.temperature > BMP280_ARRAY_TEMP_MAX ||
+            (with_pres && (m->meas.pressure < BMP280_ARRAY_PRES_MIN || m->meas.pressure > BMP280_ARRAY_PRES_MAX))) {
+            m->stats.num_out_of_range++;
+            member_failed(array, m);
+            continue;
+        }
+        valid[i] = true;
+        pres[i] = with_pres ? (int64_t)m->meas.pressure - m->offset_frac / (1 << BMP280_ARRAY_OFFSET_FRAC_BITS) : 0;
+        temps[i] = m->meas.temperature;
+        valid_pres[num_valid] = pres[i];
+        valid_temps[num_valid] = temps[i];
+        num_valid++;
+    }
+    if (num_valid == 0) {
+        return BMP280_RESULT_CODE_IO_ERR;
+    }
+
+    int64_t median_pres = median(valid_pres, num_valid);
+    int64_t median_temp = median(valid_temps, num_valid);
+    size_t num_accepted = 0;
+    for (size_t i = 0; i < array->num_members; i++) {
+        if (!valid[i]) {
+            continue;
+        }
+        if ((with_pres && abs64(pres[i] - median_pres) > (int64_t)array->cfg.pres_tolerance) ||
+            abs64(temps[i] - median_temp) > (int64_t)array->cfg.temp_tolerance) {
+            array->members[i].stats.num_outliers++;
+            member_failed(array, &array->members[i]);
+            continue;
+        }
+        accepted[i] = true;
+        num_accepted++;
+    }
+    if (num_accepted < array->cfg.min_members) {
+        for (size_t i = 0; i < array->num_members; i++) {
+            if (accepted[i]) {
+                member_failed(array, &array->members[i]);
+            }
+        }
+        return BMP280_RESULT_CODE_IO_ERR;
+    }
+
+    /* Weighted mean of deviations from the medians, which are bounded by the tolerances */
+    uint64_t weights[BMP280_ARRAY_MAX_MEMBERS];
+    uint64_t weight_sum = 0;
+    int64_t pres_dev_sum = 0;
+    int64_t temp_dev_sum = 0;
+    for (size_t i = 0; i < array->num_members; i++) {
+        if (!accepted[i]) {
+            continue;
+        }
+        weights[i] = BMP280_ARRAY_WEIGHT_SCALE / (array->members[i].stats.noise_var + BMP280_ARRAY_NOISE_VAR_FLOOR);
+        weight_sum += weights[i];
+        pres_dev_sum += (int64_t)weights[i] * (pres[i] - median_pres);
+        temp_dev_sum += (int64_t)weights[i] * (temps[i] - median_temp);
+    }
+    int64_t fused_pres = median_pres + pres_dev_sum / (int64_t)weight_sum;
+    array->meas->temperature = (int32_t)(median_temp + temp_dev_sum / (int64_t)weight_sum);
+    if (with_pres) {
+        array->meas->pressure = (uint32_t)fused_pres;
+    }
+
+    for (size_t i = 0; i < array->num_members; i++) {
+        if (accepted[i]) {
+            BMP280ArrayMember *m = &array->members[i];
+            member_accepted(m);
+            m->stats.weight = (uint32_t)((weights[i] << 16) / weight_sum);
+        }
+    }
+    if (with_pres) {
+        update_noise(array, accepted, pres, num_accepted);
+        update_offsets(array, accepted, fused_pres);
+    }
+    return BMP280_RESULT_CODE_OK;
+}
+
+static void finish(BMP280Array *const array)
+{
+    uint8_t rc = fuse(array);
+    array->busy = false;
+    if (array->cb) {
+        array->cb(rc, array->user_data);
+    }
+}
+
+static void member_complete_cb(uint8_t rc, void *user_data)
+{
+    BMP280ArrayMember *m = (BMP280ArrayMember *)user_data;
+    BMP280Array *array = m->array;
+    m->rc = rc;
+    if (--array->num_pending == 0) {
+        finish(array);
+    }
+}
+
+/** Whether a member is triggered in the current read. Probing members only on every probe_interval-th read. */
+static bool should_trigger(const BMP280Array *const array, const BMP280ArrayMember *const m, bool any_healthy)
+{
+    return !m->stats.probing || !any_healthy || array->num_reads % array->cfg.probe_interval == 0;
+}
+
+uint8_t bmp280_array_read_meas_forced_mode(BMP280Array *const array, uint8_t meas_type, uint32_t meas_time_ms,
+                                           BMP280Meas *const meas, BMP280CompleteCb cb, void *user_data)
+{
+    if (!array || !meas || meas_time_ms == 0 ||
+        (meas_type != BMP280_MEAS_TYPE_ONLY_TEMP && meas_type != BMP280_MEAS_TYPE_TEMP_AND_PRES)) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    if (array->num_members == 0) {
+        return BMP280_RESULT_CODE_INVAL_USAGE;
+    }
+    if (array->busy) {
+        return BMP280_RESULT_CODE_BUSY;
+    }
+
+    array->busy = true;
+    array->meas_type = meas_type;
+    array->meas = meas;
+    array->cb = cb;
+    array->user_data = user_data;
+    bool any_healthy = false;
+    for (size_t i = 0; i < array->num_members; i++) {
+        any_healthy = any_healthy || !array->members[i].stats.probing;
+    }
+
+    /* Held while triggering, so that members that complete synchronously do not finish the read early */
+    array->num_pending = 1;
+    uint8_t first_rc = BMP280_RESULT_CODE_OK;
+    size_t num_started = 0;
+    for (size_t i = 0; i < array->num_members; i++) {
+        BMP280ArrayMember *m = &array->members[i];
+        m->triggered = should_trigger(array, m, any_healthy);
+        if (!m->triggered) {
+            continue;
+        }
+        m->stats.num_reads++;
+        array->num_pending++;
+        uint8_t rc = bmp280_read_meas_forced_mode(m->inst, meas_type, meas_time_ms, &m->meas, member_complete_cb, m);
+        if (rc != BMP280_RESULT_CODE_OK) {
+            m->rc = rc;
+            array->num_pending--;
+            first_rc = (first_rc == BMP280_RESULT_CODE_OK) ? rc : first_rc;
+            continue;
+        }
+        num_started++;
+    }
+    array->num_reads++;
+
+    if (num_started == 0) {
+        /* Counts the failures in member statistics. The read did not start, so cb is not executed. */
+        fuse(array);
+        array->busy = false;
+        return first_rc;
+    }
+    if (--array->num_pending == 0) {
+        finish(array);
+    }
+    return BMP280_RESULT_CODE_OK;
+}
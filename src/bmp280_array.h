@@ -0,0 +1,172 @@
+#ifndef SRC_BMP280_ARRAY_H
+#define SRC_BMP280_ARRAY_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "bmp280.h"
+
+/**
+ * @brief Virtual sensor that fuses a redundant array of BMP280 instances.
+ *
+ * @ref bmp280_array_read_meas_forced_mode has the same parameters as @ref bmp280_read_meas_forced_mode. It triggers
+ * forced mode measurements of all members back to back, before any of them completes, so the conversions run at the
+ * same time and the array takes about as long as a single sensor. With @ref bmp280_bus_batch, the ctrl_meas writes of
+ * members on one bus go out in one bus transaction. Each member compensates its own measurement.
+ *
+ * Once all members have completed, their measurements are fused:
+ * - Members that failed, or returned values outside of the operating range of the BMP280 (300 to 1100 hPa, -40 to
+ * 85 degC), are faulty for this read.
+ * - Absolute pressure accuracy of the BMP280 is +-1 hPa, so units disagree by a constant offset. Every member learns
+ * its offset from the fused pressure with a moving average over 2^offset_shift reads, and its pressure is corrected by
+ * that offset before it is compared or averaged. Offsets are kept at zero mean, so the fused pressure is the average
+ * absolute level of the members. A member that drops out therefore does not shift the fused pressure.
+ * - Members that deviate from the median of all valid members by more than pres_tolerance or temp_tolerance are
+ * outliers for this read. With two members the median is their mean, so a disagreement cannot be attributed to either
+ * of them, and both are outliers.
+ * - The fused measurement is the weighted mean of the remaining members. Weights are inverse to an estimate of the
+ * noise variance of every member, so a noisy member counts less. With equally noisy members, the noise of the fused
+ * pressure falls by sqrt(N).
+ *
+ * A member that has been faulty for max_consecutive_failures reads in a row is only triggered every probe_interval
+ * reads afterwards, until it delivers a valid measurement again.
+ *
+ * Member instances must not be used for other operations while a read of the array is in progress.
+ */
+
+/** Maximum number of members of one array. */
+#ifndef BMP280_ARRAY_MAX_MEMBERS
+#define BMP280_ARRAY_MAX_MEMBERS 4
+#endif
+
+/** Array configuration. */
+typedef struct {
+    /** Largest deviation of the offset-corrected pressure of a member from the median, Q24.8 Pa. 1 to 2^24 - 1. */
+    uint32_t pres_tolerance;
+    /** Largest deviation of the temperature of a member from the median, 0.01 degC. 1 to 2^24 - 1. */
+    uint32_t temp_tolerance;
+    /** Minimum number of members that contribute to the fused measurement of a successful read. At least 1. */
+    uint8_t min_members;
+    /** Time constant of offset learning, 2^offset_shift reads. At most 16. */
+    uint8_t offset_shift;
+    /** Number of failed reads in a row after which a member is only probed. At least 1. */
+    uint32_t max_consecutive_failures;
+    /** A member that is only probed is triggered on every probe_interval-th read. At least 1. */
+    uint32_t probe_interval;
+} BMP280ArrayCfg;
+
+/** Health and weight statistics of a member. */
+typedef struct {
+    /** Number of reads in which the member was triggered. */
+    uint64_t num_reads;
+    /** Number of reads that failed to start or completed with an error. */
+    uint64_t num_errors;
+    /** Number of measurements outside of the operating range. */
+    uint64_t num_out_of_range;
+    /** Number of measurements rejected as outliers. */
+    uint64_t num_outliers;
+    /** Number of measurements that contributed to the fused measurement. */
+    uint64_t num_accepted;
+    /** Number of failed reads in a row. Errors, out of range measurements and outliers count as failures. */
+    uint32_t consecutive_failures;
+    /** true while the member is only probed. */
+    bool probing;
+    /** Learned pressure offset from the fused pressure, Q24.8 Pa. */
+    int32_t offset;
+    /** Share of the member in the latest fused measurement, Q16. 0 if it did not contribute. */
+    uint32_t weight;
+    /** Estimated noise variance of the member, (Q24.8 Pa)^2. */
+    uint64_t noise_var;
+} BMP280ArrayMemberStats;
+
+struct BMP280ArrayStruct;
+
+/** Array member. Fields other than stats are private. */
+typedef struct {
+    BMP280 inst;
+    struct BMP280ArrayStruct *array;
+    BMP280Meas meas;
+    uint8_t rc;
+    /** true if the member was triggered in the current read. */
+    bool triggered;
+    /** Offset with 8 additional fractional bits. */
+    int32_t offset_frac;
+    BMP280ArrayMemberStats stats;
+} BMP280ArrayMember;
+
+/** Array state. Memory is provided by the user. Fields other than members[i].stats are private. */
+typedef struct BMP280ArrayStruct {
+    BMP280ArrayCfg cfg;
+    BMP280ArrayMember members[BMP280_ARRAY_MAX_MEMBERS];
+    size_t num_members;
+    bool busy;
+    /** Number of triggered members that have not completed yet, plus one while members are being triggered. */
+    size_t num_pending;
+    uint8_t meas_type;
+    BMP280Meas *meas;
+    BMP280CompleteCb cb;
+    void *user_data;
+    uint32_t num_reads;
+} BMP280Array;
+
+/**
+ * @brief Initialize an array without members.
+ *
+ * @param[out] array Array to initialize.
+ * @param[in] cfg Configuration. Copied into @p array.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully initialized @p array.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p array or @p cfg is NULL, or a value in @p cfg is outside of its range.
+ */
+uint8_t bmp280_array_init(BMP280Array *const array, const BMP280ArrayCfg *const cfg);
+
+/**
+ * @brief Add a member.
+ *
+ * @param[in] array Array.
+ * @param[in] inst BMP280 instance. @ref bmp280_init_meas must have been called for it, or it must have been created
+ * with lazy_init_meas.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully added @p inst.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p array or @p inst is NULL.
+ * @retval BMP280_RESULT_CODE_NO_MEM @p array already has BMP280_ARRAY_MAX_MEMBERS members.
+ * @retval BMP280_RESULT_CODE_BUSY A read is in progress.
+ */
+uint8_t bmp280_array_add(BMP280Array *const array, BMP280 inst);
+
+/**
+ * @brief Perform one forced mode measurement with all members, and fuse the results.
+ *
+ * Once the fused measurement is ready or the read fails, @p cb is executed. "rc" parameter of @p cb indicates success
+ * or reason for failure:
+ * - @ref BMP280_RESULT_CODE_OK Successfully fused the measurements of at least min_members members.
+ * - @ref BMP280_RESULT_CODE_IO_ERR Fewer than min_members members delivered valid measurements that agree.
+ *
+ * @param[in] array Array.
+ * @param[in] meas_type Same as for @ref bmp280_read_meas_forced_mode.
+ * @param[in] meas_time_ms Same as for @ref bmp280_read_meas_forced_mode.
+ * @param[out] meas Fused measurement is written to this parameter. Cannot be NULL.
+ * @param[in] cb Callback to execute once the read is complete. Can be NULL.
+ * @param[in] user_data User data to pass to @p cb.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully triggered at least one member.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p array or @p meas is NULL, @p meas_type is not one of @ref BMP280MeasType,
+ * or @p meas_time_ms is 0.
+ * @retval BMP280_RESULT_CODE_INVAL_USAGE @p array has no members.
+ * @retval BMP280_RESULT_CODE_BUSY A read of @p array is already in progress.
+ * @retval Other The return code of the first member, if no member could be triggered.
+ */
+uint8_t bmp280_array_read_meas_forced_mode(BMP280Array *const array, uint8_t meas_type, uint32_t meas_time_ms,
+                                           BMP280Meas *const meas, BMP280CompleteCb cb, void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_BMP280_ARRAY_H */
@@ -0,0 +1,349 @@
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "bmp280_bus_batch.h"
+#include "bmp280.h"
+
+/** Transfers of one mux channel in the pending list of a flush. */
+typedef struct {
+    size_t num_transfers;
+    /** Position of the first transfer of the channel in the pending list. */
+    size_t first_pos;
+    /** Largest num_held of the transfers of the channel. */
+    uint32_t max_held;
+} MuxChannelPlan;
+
+/** Transfer list under construction. */
+typedef struct {
+    BMP280BusTransfer *head;
+    BMP280BusTransfer *tail;
+    size_t num;
+} TransferList;
+
+uint8_t bmp280_bus_batch_init(BMP280BusBatch *const batch, const BMP280BusBatchCfg *const cfg)
+{
+    if (!batch || !cfg || !cfg->submit) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    batch->submit = cfg->submit;
+    batch->submit_user_data = cfg->submit_user_data;
+    batch->mux_addr = cfg->mux_addr;
+    batch->mux_keep_order = cfg->mux_keep_order;
+    batch->mux_max_hold_flushes = cfg->mux_max_hold_flushes;
+    batch->mux_channel = BMP280_BUS_BATCH_MUX_UNKNOWN;
+    for (size_t i = 0; i < BMP280_BUS_BATCH_MUX_NUM_CHANNELS; i++) {
+        batch->mux_num_devs[i] = 0;
+    }
+    batch->pending_head = NULL;
+    batch->pending_tail = NULL;
+    batch->num_pending = 0;
+    batch->in_flight = NULL;
+    batch->num_submits = 0;
+    batch->num_transfers = 0;
+    batch->num_mux_selects = 0;
+    return BMP280_RESULT_CODE_OK;
+}
+
+uint8_t bmp280_bus_batch_dev_init(BMP280BusBatchDev *const dev, BMP280BusBatch *const batch, uint8_t dev_addr)
+{
+    if (!dev || !batch) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    dev->batch = batch;
+    dev->transfer.dev_addr = dev_addr;
+    dev->transfer.is_mux_select = false;
+    dev->transfer.next = NULL;
+    dev->transfer.mux_channel = BMP280_BUS_BATCH_NO_MUX;
+    dev->transfer.num_held = 0;
+    return BMP280_RESULT_CODE_OK;
+}
+
+/**
+ * @brief IO complete callback of mux selects.
+ *
+ * @param user_data BMP280BusBatch.
+ */
+static void mux_select_complete_cb(uint8_t io_rc, void *user_data)
+{
+    BMP280BusBatch *batch = (BMP280BusBatch *)user_data;
+    if (io_rc != BMP280_IO_RESULT_CODE_OK) {
+        /* The mux may have kept the previous channel, select again on the next flush */
+        batch->mux_channel = BMP280_BUS_BATCH_MUX_UNKNOWN;
+    }
+}
+
+uint8_t bmp280_bus_batch_mux_dev_init(BMP280BusBatchDev *const dev, BMP280BusBatch *const batch, uint8_t dev_addr,
+                                      uint8_t mux_channel)
+{
+    if (mux_channel >= BMP280_BUS_BATCH_MUX_NUM_CHANNELS) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    uint8_t rc = bmp280_bus_batch_dev_init(dev, batch, dev_addr);
+    if (rc != BMP280_RESULT_CODE_OK) {
+        return rc;
+    }
+
+    dev->transfer.mux_channel = mux_channel;
+    BMP280BusTransfer *select = &dev->mux_select;
+    select->dev_addr = batch->mux_addr;
+    select->is_mux_select = true;
+    select->reg_addr = 0;
+    select->is_read = false;
+    select->data = NULL;
+    select->len = 1;
+    /* TCA9548A control register: one enable bit per channel */
+    select->write_val = (uint8_t)(1U << mux_channel);
+    select->io_rc = BMP280_IO_RESULT_CODE_ERR;
+    select->cb = mux_select_complete_cb;
+    select->cb_user_data = (void *)batch;
+    select->next = NULL;
+    select->mux_channel = mux_channel;
+    select->num_held = 0;
+    batch->mux_num_devs[mux_channel]++;
+    return BMP280_RESULT_CODE_OK;
+}
+
+static void enqueue(BMP280BusBatch *const batch, BMP280BusTransfer *const transfer)
+{
+    transfer->next = NULL;
+    transfer->num_held = 0;
+    if (batch->pending_tail) {
+        batch->pending_tail->next = transfer;
+    } else {
+        batch->pending_head = transfer;
+    }
+    batch->pending_tail = transfer;
+    batch->num_pending++;
+}
+
+static void list_append(TransferList *const list, BMP280BusTransfer *const transfer)
+{
+    transfer->next = NULL;
+    if (list->tail) {
+        list->tail->next = transfer;
+    } else {
+        list->head = transfer;
+    }
+    list->tail = transfer;
+    list->num++;
+}
+
+/**
+ * @brief Append @p transfer to @p list, preceded by a mux select if its channel is not selected.
+ */
+static void append_with_select(BMP280BusBatch *const batch, TransferList *const list, BMP280BusTransfer *const transfer)
+{
+    if ((transfer->mux_channel != BMP280_BUS_BATCH_NO_MUX) && (transfer->mux_channel != batch->mux_channel)) {
+        /* The select transfer is part of the same device as the register transfer */
+        BMP280BusBatchDev *dev = (BMP280BusBatchDev *)((uint8_t *)transfer - offsetof(BMP280BusBatchDev, transfer));
+        list_append(list, &dev->mux_select);
+        batch->mux_channel = transfer->mux_channel;
+        batch->num_mux_selects++;
+    }
+    list_append(list, transfer);
+}
+
+/**
+ * @brief Whether the transfers of mux channel @p a are submitted before those of channel @p b. The selected channel
+ * goes first, then the channel that waited longest, then the channel queued first.
+ */
+static bool channel_goes_first(const BMP280BusBatch *const batch, const MuxChannelPlan *const plans, uint8_t a,
+                               uint8_t b)
+{
+    if ((a == batch->mux_channel) || (b == batch->mux_channel)) {
+        return a == batch->mux_channel;
+    }
+    if (plans[a].max_held != plans[b].max_held) {
+        return plans[a].max_held > plans[b].max_held;
+    }
+    return plans[a].first_pos < plans[b].first_pos;
+}
+
+/**
+ * @brief Move the pending transfers to @p submit, grouped by mux channel. Transfers held back stay pending.
+ */
+static void plan_grouped(BMP280BusBatch *const batch, TransferList *const submit)
+{
+    MuxChannelPlan plans[BMP280_BUS_BATCH_MUX_NUM_CHANNELS] = {{0}};
+    size_t pos = 0;
+    for (BMP280BusTransfer *transfer = batch->pending_head; transfer; transfer = transfer->next, pos++) {
+        if (transfer->mux_channel == BMP280_BUS_BATCH_NO_MUX) {
+            continue;
+        }
+        MuxChannelPlan *plan = &plans[transfer->mux_channel];
+        if (plan->num_transfers++ == 0) {
+            plan->first_pos = pos;
+        }
+        if (transfer->num_held > plan->max_held) {
+            plan->max_held = transfer->num_held;
+        }
+    }
+
+    /* Channels to serve in this flush, in insertion-sorted order */
+    uint8_t order[BMP280_BUS_BATCH_MUX_NUM_CHANNELS];
+    size_t num_served = 0;
+    for (uint8_t ch = 0; ch < BMP280_BUS_BATCH_MUX_NUM_CHANNELS; ch++) {
+        const MuxChannelPlan *plan = &plans[ch];
+        if ((plan->num_transfers == 0) ||
+            ((ch != batch->mux_channel) && (plan->num_transfers < batch->mux_num_devs[ch]) &&
+             (plan->max_held < batch->mux_max_hold_flushes))) {
+            continue;
+        }
+        size_t i = num_served++;
+        while ((i > 0) && channel_goes_first(batch, plans, ch, order[i - 1])) {
+            order[i] = order[i - 1];
+            i--;
+        }
+        order[i] = ch;
+    }
+
+    /* Split the pending transfers by channel, every list keeps queue order */
+    TransferList channels[BMP280_BUS_BATCH_MUX_NUM_CHANNELS] = {{NULL, NULL, 0}};
+    TransferList held = {NULL, NULL, 0};
+    BMP280BusTransfer *transfer = batch->pending_head;
+    while (transfer) {
+        /* Appending overwrites next */
+        BMP280BusTransfer *next = transfer->next;
+        if (transfer->mux_channel == BMP280_BUS_BATCH_NO_MUX) {
+            list_append(submit, transfer);
+        } else {
+            list_append(&channels[transfer->mux_channel], transfer);
+        }
+        transfer = next;
+    }
+    bool served[BMP280_BUS_BATCH_MUX_NUM_CHANNELS] = {false};
+    for (size_t i = 0; i < num_served; i++) {
+        served[order[i]] = true;
+    }
+    for (uint8_t ch = 0; ch < BMP280_BUS_BATCH_MUX_NUM_CHANNELS; ch++) {
+        if (served[ch]) {
+            continue;
+        }
+        transfer = channels[ch].head;
+        while (transfer) {
+            BMP280BusTransfer *next = transfer->next;
+            transfer->num_held++;
+            list_append(&held, transfer);
+            transfer = next;
+        }
+    }
+    for (size_t i = 0; i < num_served; i++) {
+        transfer = channels[order[i]].head;
+        while (transfer) {
+            BMP280BusTransfer *next = transfer->next;
+            append_with_select(batch, submit, transfer);
+            transfer = next;
+        }
+    }
+    batch->pending_head = held.head;
+    batch->pending_tail = held.tail;
+    batch->num_pending = held.num;
+}
+
+/**
+ * @brief Executed by the submit function when all transfers of the in-flight batch are complete.
+ *
+ * @param user_data BMP280BusBatch.
+ */
+static void submit_complete_cb(void *user_data)
+{
+    BMP280BusBatch *batch = (BMP280BusBatch *)user_data;
+    BMP280BusTransfer *transfer = batch->in_flight;
+    /* Cleared before executing the callbacks, so that they can queue transfers for the next flush, and the next flush
+     * can be executed from one of the callbacks */
+    batch->in_flight = NULL;
+
+    /* Channel of the last mux select if it failed */
+    uint8_t failed_channel = BMP280_BUS_BATCH_NO_MUX;
+    while (transfer) {
+        /* The callback can queue a new transfer of the same device, which overwrites next */
+        BMP280BusTransfer *next = transfer->next;
+        if (transfer->is_mux_select) {
+            failed_channel = (transfer->io_rc != BMP280_IO_RESULT_CODE_OK) ? transfer->mux_channel
+                                                                           : BMP280_BUS_BATCH_NO_MUX;
+        } else if ((failed_channel != BMP280_BUS_BATCH_NO_MUX) && (transfer->mux_channel == failed_channel)) {
+            /* If the submit function ran it, it ran on whichever channel was still connected */
+            transfer->io_rc = BMP280_IO_RESULT_CODE_ERR;
+        }
+        if (transfer->cb) {
+            transfer->cb(transfer->io_rc, transfer->cb_user_data);
+        }
+        transfer = next;
+    }
+}
+
+uint8_t bmp280_bus_batch_flush(BMP280BusBatch *const batch)
+{
+    if (!batch) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    if (batch->in_flight) {
+        return BMP280_RESULT_CODE_BUSY;
+    }
+    if (batch->num_pending == 0) {
+        return BMP280_RESULT_CODE_OK;
+    }
+
+    TransferList submit = {NULL, NULL, 0};
+    if (batch->mux_keep_order) {
+        BMP280BusTransfer *transfer = batch->pending_head;
+        while (transfer) {
+            BMP280BusTransfer *next = transfer->next;
+            append_with_select(batch, &submit, transfer);
+            transfer = next;
+        }
+        batch->pending_head = NULL;
+        batch->pending_tail = NULL;
+        batch->num_pending = 0;
+    } else {
+        plan_grouped(batch, &submit);
+    }
+    if (submit.num == 0) {
+        return BMP280_RESULT_CODE_OK;
+    }
+
+    batch->in_flight = submit.head;
+    batch->num_submits++;
+    batch->num_transfers += (uint32_t)submit.num;
+    batch->submit(submit.head, submit.num, batch->submit_user_data, submit_complete_cb, (void *)batch);
+    return BMP280_RESULT_CODE_OK;
+}
+
+size_t bmp280_bus_batch_num_pending(const BMP280BusBatch *const batch)
+{
+    return batch ? batch->num_pending : 0;
+}
+
+void bmp280_bus_batch_read_regs(uint8_t start_addr, size_t num_regs, uint8_t *data, void *user_data,
+                                BMP280_IOCompleteCb cb, void *cb_user_data)
+{
+    BMP280BusBatchDev *dev = (BMP280BusBatchDev *)user_data;
+    BMP280BusTransfer *transfer = &dev->transfer;
+    transfer->reg_addr = start_addr;
+    transfer->is_read = true;
+    transfer->data = data;
+    transfer->len = num_regs;
+    transfer->write_val = 0;
+    transfer->io_rc = BMP280_IO_RESULT_CODE_ERR;
+    transfer->cb = cb;
+    transfer->cb_user_data = cb_user_data;
+    enqueue(dev->batch, transfer);
+}
+
+void bmp280_bus_batch_write_reg(uint8_t addr, uint8_t reg_val, void *user_data, BMP280_IOCompleteCb cb,
+                                void *cb_user_data)
+{
+    BMP280BusBatchDev *dev = (BMP280BusBatchDev *)user_data;
+    BMP280BusTransfer *transfer = &dev->transfer;
+    transfer->reg_addr = addr;
+    transfer->is_read = false;
+    transfer->data = NULL;
+    transfer->len = 1;
+    transfer->write_val = reg_val;
+    transfer->io_rc = BMP280_IO_RESULT_CODE_ERR;
+    transfer->cb = cb;
+    transfer->cb_user_data = cb_user_data;
+    enqueue(dev->batch, transfer);
+}
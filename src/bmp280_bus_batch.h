@@ -0,0 +1,253 @@
+#ifndef SRC_BMP280_BUS_BATCH_H
+#define SRC_BMP280_BUS_BATCH_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "bmp280_defs.h"
+
+/**
+ * @brief Bus-level transaction batching for several BMP280 instances on one bus.
+ *
+ * Implements @ref BMP280ReadRegs and @ref BMP280WriteReg by queueing the transactions instead of starting them. The
+ * application calls @ref bmp280_bus_batch_flush once per event loop tick, which hands all transactions queued since the
+ * previous flush to a user-provided submit function at once. The submit function can then execute all of them with a
+ * single system call, e.g. one multi-message I2C_RDWR ioctl on Linux. Once the submit function reports completion,
+ * the IO complete callbacks of all transactions are executed in the order in which the transactions were queued.
+ *
+ * Every BMP280 instance is attached to the batch through its own @ref BMP280BusBatchDev, which is passed as
+ * read_regs_user_data and write_reg_user_data in BMP280InitCfg. The device holds the memory for its transaction. A
+ * BMP280 instance never has more than one IO transaction in progress, so no other memory is needed and the batch cannot
+ * overflow.
+ *
+ * Transactions queued from IO complete callbacks while a batch is being completed are submitted on the next flush.
+ *
+ * I2C multiplexer (TCA9548A): only two BMP280 addresses exist per bus segment, so larger setups put sensors behind the
+ * channels of a mux. Devices attached with @ref bmp280_bus_batch_mux_dev_init are on a mux channel, and the batch keeps
+ * the selected channel as state. A flush submits the transactions of devices that are not behind the mux first, then
+ * groups the rest by channel, starting with the selected channel, so that every channel is selected at most once per
+ * flush. A mux select is a transfer of its own, inserted before the first transfer of its channel. The other channels
+ * are ordered by the number of flushes that their oldest transaction has been held back, so the channel that waited
+ * longest is served first.
+ *
+ * With mux_max_hold_flushes > 0, the transactions of a channel other than the selected one are held back until every
+ * device on that channel has a transaction queued, or until the oldest of them has been held back for
+ * mux_max_hold_flushes flushes. Devices on one channel then tend to fall into step, and share one mux select.
+ */
+
+/** Number of channels of a TCA9548A. */
+#define BMP280_BUS_BATCH_MUX_NUM_CHANNELS 8
+/** Mux channel of a device that is not behind the mux. */
+#define BMP280_BUS_BATCH_NO_MUX 0xFF
+/** Selected mux channel before the first select, and after a failed select. */
+#define BMP280_BUS_BATCH_MUX_UNKNOWN 0xFE
+
+typedef struct BMP280BusTransfer BMP280BusTransfer;
+
+/**
+ * @brief One queued register read or register write.
+ *
+ * Fields are filled by the batch. The submit function reads them, performs the transaction and writes io_rc.
+ */
+struct BMP280BusTransfer {
+    /** Address of the device: 7-bit I2C address, or an index that the submit function maps to a chip select. */
+    uint8_t dev_addr;
+    /**
+     * true for a mux select: an I2C write of the single byte write_val to dev_addr, without register address. The
+     * other fields except io_rc and mux_channel are not used by the submit function.
+     */
+    bool is_mux_select;
+    /** Register address of the first register to read, or the register to write. */
+    uint8_t reg_addr;
+    /** true for register read, false for register write. */
+    bool is_read;
+    /** Register read: buffer to write the register values to. Not used for register write. */
+    uint8_t *data;
+    /** Register read: number of registers to read. Register write: always 1. */
+    size_t len;
+    /** Register write: value to write. Not used for register read. */
+    uint8_t write_val;
+    /** Result of the transaction, one of @ref BMP280_IOResultCode. Must be set by the submit function. */
+    uint8_t io_rc;
+    /** IO complete callback of the BMP280 driver. Executed by the batch. */
+    BMP280_IOCompleteCb cb;
+    void *cb_user_data;
+    /** Next transfer in the same batch, NULL for the last one. */
+    BMP280BusTransfer *next;
+    /**
+     * Mux channel of the device, BMP280_BUS_BATCH_NO_MUX if it is not behind the mux. Used by the batch, and by the
+     * submit function to skip the transfers of a channel whose select failed.
+     */
+    uint8_t mux_channel;
+    /** Number of flushes that the transfer has been held back for. Used by the batch. */
+    uint32_t num_held;
+};
+
+/**
+ * @brief Callback type that the submit function executes once all transfers of a batch are complete.
+ *
+ * Must be executed from the same execution context as all BMP280 driver functions.
+ *
+ * @param user_data The cb_user_data parameter of @ref BMP280BusSubmit.
+ */
+typedef void (*BMP280BusSubmitCompleteCb)(void *user_data);
+
+/**
+ * @brief Execute a batch of transfers.
+ *
+ * The implementation must perform every transfer in the list, in list order, set io_rc of every transfer, and then
+ * execute @p cb. It can do that synchronously, before returning, or asynchronously. The transfers must not be modified
+ * otherwise, and must not be accessed after @p cb is executed.
+ *
+ * The transfers of a mux channel that follow its mux select depend on it. If the select fails, the implementation
+ * should skip them and set their io_rc to BMP280_IO_RESULT_CODE_ERR, since they would reach a device on whichever
+ * channel is still connected. The batch reports them as failed either way.
+ *
+ * @param[in] transfers First transfer of the batch. Following transfers are linked by the next field.
+ * @param[in] num_transfers Number of transfers in the list. At least 1.
+ * @param[in] user_data submit_user_data from @ref BMP280BusBatchCfg.
+ * @param[in] cb Callback to execute when all transfers are complete.
+ * @param[in] cb_user_data User data to pass to @p cb.
+ */
+typedef void (*BMP280BusSubmit)(BMP280BusTransfer *transfers, size_t num_transfers, void *user_data,
+                                BMP280BusSubmitCompleteCb cb, void *cb_user_data);
+
+typedef struct {
+    BMP280BusSubmit submit;
+    void *submit_user_data;
+    /** 7-bit I2C address of the mux. Only used if devices are attached with @ref bmp280_bus_batch_mux_dev_init. */
+    uint8_t mux_addr;
+    /**
+     * If true, transactions are submitted in queue order, and a mux select is inserted whenever the channel changes.
+     * Nothing is held back then.
+     */
+    bool mux_keep_order;
+    /** Largest number of flushes that a transaction is held back for to share a mux select. 0 holds nothing back. */
+    uint32_t mux_max_hold_flushes;
+} BMP280BusBatchCfg;
+
+/**
+ * @brief Batch of transactions for one bus.
+ *
+ * Memory is provided by the user. Fields are private, use the functions of this module to access them.
+ */
+typedef struct {
+    BMP280BusSubmit submit;
+    void *submit_user_data;
+    uint8_t mux_addr;
+    bool mux_keep_order;
+    uint32_t mux_max_hold_flushes;
+    /** Selected mux channel, BMP280_BUS_BATCH_MUX_UNKNOWN if not known. */
+    uint8_t mux_channel;
+    /** Number of devices attached to every mux channel. */
+    uint8_t mux_num_devs[BMP280_BUS_BATCH_MUX_NUM_CHANNELS];
+    /** Transfers queued since the last flush, and transfers held back. */
+    BMP280BusTransfer *pending_head;
+    BMP280BusTransfer *pending_tail;
+    size_t num_pending;
+    /** Transfers handed to the submit function, NULL if no batch is in progress. */
+    BMP280BusTransfer *in_flight;
+    /** Number of executed submit calls. */
+    uint32_t num_submits;
+    /** Number of transfers in all executed submit calls, including mux selects. */
+    uint32_t num_transfers;
+    /** Number of mux selects in all executed submit calls. */
+    uint32_t num_mux_selects;
+} BMP280BusBatch;
+
+/**
+ * @brief Attachment of one BMP280 instance to a batch.
+ *
+ * Pass a pointer to this struct as both read_regs_user_data and write_reg_user_data in BMP280InitCfg, with @ref
+ * bmp280_bus_batch_read_regs and @ref bmp280_bus_batch_write_reg as read_regs and write_reg. Memory is provided by the
+ * user and must remain valid as long as the BMP280 instance is used.
+ */
+typedef struct {
+    BMP280BusBatch *batch;
+    /** Memory for the single transaction that a BMP280 instance can have in progress. */
+    BMP280BusTransfer transfer;
+    /** Memory for the mux select that precedes transfer, if the device is behind the mux. */
+    BMP280BusTransfer mux_select;
+} BMP280BusBatchDev;
+
+/**
+ * @brief Initialize a batch.
+ *
+ * @param[out] batch Batch to initialize.
+ * @param[in] cfg Batch configuration.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully initialized the batch.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p batch or @p cfg is NULL, or cfg->submit is NULL.
+ */
+uint8_t bmp280_bus_batch_init(BMP280BusBatch *const batch, const BMP280BusBatchCfg *const cfg);
+
+/**
+ * @brief Attach a device to a batch.
+ *
+ * @param[out] dev Device to initialize.
+ * @param[in] batch Batch of the bus that the device is on.
+ * @param[in] dev_addr Device address that is passed to the submit function in every transfer of this device.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully initialized the device.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p dev or @p batch is NULL.
+ */
+uint8_t bmp280_bus_batch_dev_init(BMP280BusBatchDev *const dev, BMP280BusBatch *const batch, uint8_t dev_addr);
+
+/**
+ * @brief Attach a device behind a channel of the mux to a batch.
+ *
+ * Must be called once per device, before the device queues transactions.
+ *
+ * @param[out] dev Device to initialize.
+ * @param[in] batch Batch of the bus that the mux is on.
+ * @param[in] dev_addr Device address that is passed to the submit function in every transfer of this device.
+ * @param[in] mux_channel Mux channel that the device is on. 0 to BMP280_BUS_BATCH_MUX_NUM_CHANNELS - 1.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully initialized the device.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p dev or @p batch is NULL, or @p mux_channel is out of range.
+ */
+uint8_t bmp280_bus_batch_mux_dev_init(BMP280BusBatchDev *const dev, BMP280BusBatch *const batch, uint8_t dev_addr,
+                                      uint8_t mux_channel);
+
+/**
+ * @brief Submit all transactions queued since the last flush.
+ *
+ * Call this once per event loop tick, from the same execution context as all BMP280 driver functions. If nothing is
+ * queued, or all queued transactions are held back to share a mux select, does nothing.
+ *
+ * @param[in] batch Batch.
+ *
+ * @retval BMP280_RESULT_CODE_OK Queued transactions were submitted, or nothing was queued.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p batch is NULL.
+ * @retval BMP280_RESULT_CODE_BUSY The previous batch is not complete yet. Queued transactions stay queued.
+ */
+uint8_t bmp280_bus_batch_flush(BMP280BusBatch *const batch);
+
+/**
+ * @brief Number of transactions queued since the last flush, including transactions held back.
+ */
+size_t bmp280_bus_batch_num_pending(const BMP280BusBatch *const batch);
+
+/**
+ * @brief Implementation of @ref BMP280ReadRegs. user_data must point to a @ref BMP280BusBatchDev.
+ */
+void bmp280_bus_batch_read_regs(uint8_t start_addr, size_t num_regs, uint8_t *data, void *user_data,
+                                BMP280_IOCompleteCb cb, void *cb_user_data);
+
+/**
+ * @brief Implementation of @ref BMP280WriteReg. user_data must point to a @ref BMP280BusBatchDev.
+ */
+void bmp280_bus_batch_write_reg(uint8_t addr, uint8_t reg_val, void *user_data, BMP280_IOCompleteCb cb,
+                                void *cb_user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_BMP280_BUS_BATCH_H */
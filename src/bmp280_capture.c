@@ -0,0 +1,122 @@
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "bmp280_capture.h"
+
+/** Largest allowed baseline_shift. Keeps baseline updates of 20-bit pressure deviations far from overflow. */
+#define BMP280_CAPTURE_MAX_BASELINE_SHIFT 16
+/** Number of additional fractional bits of the baseline, so that small deviations still move it. */
+#define BMP280_CAPTURE_BASELINE_FRAC_BITS 8
+
+uint8_t bmp280_capture_init(BMP280Capture *const capture, const BMP280CaptureCfg *const cfg)
+{
+    if (!capture || !cfg || !cfg->record || (!cfg->ring && cfg->ring_capacity > 0) ||
+        cfg->baseline_shift > BMP280_CAPTURE_MAX_BASELINE_SHIFT || cfg->cusum_threshold == 0) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    capture->cfg = *cfg;
+    capture->ring_head = 0;
+    capture->ring_num = 0;
+    capture->has_baseline = false;
+    capture->baseline = 0;
+    capture->cusum_pos = 0;
+    capture->cusum_neg = 0;
+    capture->post_left = 0;
+    capture->num_events = 0;
+    capture->num_samples = 0;
+    capture->num_recorded = 0;
+    return BMP280_RESULT_CODE_OK;
+}
+
+/**
+ * @brief Update the baseline and the CUSUM sums with @p pressure.
+ *
+ * @return bool true if @p pressure triggers an event.
+ */
+static bool detect(BMP280Capture *const capture, uint32_t pressure)
+{
+    const BMP280CaptureCfg *cfg = &capture->cfg;
+    int64_t x = (int64_t)pressure << BMP280_CAPTURE_BASELINE_FRAC_BITS;
+    if (!capture->has_baseline) {
+        capture->baseline = x;
+        capture->has_baseline = true;
+    }
+    /* Deviation from the baseline before this sample, in Q24.8 */
+    int64_t dev = (x - capture->baseline) >> BMP280_CAPTURE_BASELINE_FRAC_BITS;
+    /* Arithmetic right shift of a negative value, well defined on every compiler that the driver targets */
+    capture->baseline += (x - capture->baseline) >> cfg->baseline_shift;
+
+    int64_t pos = capture->cusum_pos + dev - (int64_t)cfg->cusum_drift;
+    int64_t neg = capture->cusum_neg - dev - (int64_t)cfg->cusum_drift;
+    capture->cusum_pos = (pos > 0) ? pos : 0;
+    capture->cusum_neg = (neg > 0) ? neg : 0;
+
+    bool jump = cfg->jump_threshold > 0 && (dev > (int64_t)cfg->jump_threshold || -dev > (int64_t)cfg->jump_threshold);
+    return jump || capture->cusum_pos > (int64_t)cfg->cusum_threshold ||
+           capture->cusum_neg > (int64_t)cfg->cusum_threshold;
+}
+
+/**
+ * @brief Restart detection from @p pressure after a trigger.
+ *
+ * The baseline jumps to the current pressure, so that a lasting step, e.g. a floor change, ends the event instead of
+ * triggering again until the moving average has caught up.
+ */
+static void restart_detector(BMP280Capture *const capture, uint32_t pressure)
+{
+    capture->baseline = (int64_t)pressure << BMP280_CAPTURE_BASELINE_FRAC_BITS;
+    capture->cusum_pos = 0;
+    capture->cusum_neg = 0;
+}
+
+static void record(BMP280Capture *const capture, uint32_t timestamp_ms, const BMP280Meas *const meas)
+{
+    /* Sequence number of the event in progress */
+    capture->cfg.record(capture->num_events - 1, timestamp_ms, meas, capture->cfg.record_user_data);
+    capture->num_recorded++;
+}
+
+bool bmp280_capture_add(BMP280Capture *const capture, uint32_t timestamp_ms, const BMP280Meas *const meas)
+{
+    const BMP280CaptureCfg *cfg = &capture->cfg;
+    capture->num_samples++;
+    bool triggered = detect(capture, meas->pressure);
+
+    if (capture->post_left > 0) {
+        record(capture, timestamp_ms, meas);
+        if (triggered) {
+            restart_detector(capture, meas->pressure);
+            capture->post_left = cfg->post_trigger_samples + 1;
+        }
+        capture->post_left--;
+        return capture->post_left > 0;
+    }
+
+    if (!triggered) {
+        if (cfg->ring_capacity == 0) {
+            return false;
+        }
+        size_t tail = (capture->ring_head + capture->ring_num) % cfg->ring_capacity;
+        cfg->ring[tail].timestamp_ms = timestamp_ms;
+        cfg->ring[tail].meas = *meas;
+        if (capture->ring_num < cfg->ring_capacity) {
+            capture->ring_num++;
+        } else {
+            capture->ring_head = (capture->ring_head + 1) % cfg->ring_capacity;
+        }
+        return false;
+    }
+
+    capture->num_events++;
+    for (size_t i = 0; i < capture->ring_num; i++) {
+        const BMP280CaptureSample *s = &cfg->ring[(capture->ring_head + i) % cfg->ring_capacity];
+        record(capture, s->timestamp_ms, &s->meas);
+    }
+    capture->ring_head = 0;
+    capture->ring_num = 0;
+    record(capture, timestamp_ms, meas);
+    restart_detector(capture, meas->pressure);
+    capture->post_left = cfg->post_trigger_samples;
+    return capture->post_left > 0;
+}
@@ -0,0 +1,124 @@
+#ifndef SRC_BMP280_CAPTURE_H
+#define SRC_BMP280_CAPTURE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "bmp280.h"
+
+/**
+ * @brief Event-triggered capture of pressure transients of one sensor.
+ *
+ * Every sample of the full-rate stream is passed to @ref bmp280_capture_add. While no event is in progress, the
+ * sample only goes into a pre-trigger ring, and into a change-point detector:
+ *
+ * - The baseline is an exponential moving average of pressure with a time constant of 2^baseline_shift samples, so
+ * that weather changes are followed and do not trigger.
+ * - A two-sided CUSUM accumulates the deviation of every sample from the baseline minus a slack (drift), and triggers
+ * once either sum exceeds cusum_threshold. This catches small steps, e.g. a floor change in a lift, after a few
+ * samples.
+ * - A sample that deviates from the baseline by more than jump_threshold triggers immediately. This catches short
+ * spikes, e.g. a door slam.
+ *
+ * Detection costs O(1) per sample. On a trigger, the contents of the pre-trigger ring and then the following
+ * post_trigger_samples samples are passed to the record callback, e.g. for writing to storage. Another trigger during
+ * the post-trigger window extends it. Samples outside events are never recorded.
+ *
+ * Pressures and thresholds are in the format of BMP280Meas.pressure: Pa in Q24.8.
+ */
+
+/**
+ * @brief Record a sample of an event.
+ *
+ * @param[in] event_seq Sequence number of the event, starting at 0 for the first event.
+ * @param[in] timestamp_ms Time of the sample.
+ * @param[in] meas Sample.
+ * @param[in] user_data User data from @ref BMP280CaptureCfg.
+ */
+typedef void (*BMP280CaptureRecordCb)(uint32_t event_seq, uint32_t timestamp_ms, const BMP280Meas *meas,
+                                      void *user_data);
+
+/** One sample in the pre-trigger ring. */
+typedef struct {
+    uint32_t timestamp_ms;
+    BMP280Meas meas;
+} BMP280CaptureSample;
+
+/** Capture configuration. */
+typedef struct {
+    /** Pre-trigger ring, provided by the user. */
+    BMP280CaptureSample *ring;
+    /** Number of samples in the ring. 0 for no pre-trigger samples, ring can be NULL then. */
+    size_t ring_capacity;
+    /** Number of samples recorded after the last trigger of an event. */
+    uint32_t post_trigger_samples;
+    /** Time constant of the baseline, 2^baseline_shift samples. At most 16. */
+    uint8_t baseline_shift;
+    /** Deviation from the baseline that CUSUM ignores, per sample. */
+    uint32_t cusum_drift;
+    /** CUSUM sum that triggers an event. */
+    uint32_t cusum_threshold;
+    /** Deviation of a single sample from the baseline that triggers an event. 0 to disable. */
+    uint32_t jump_threshold;
+    BMP280CaptureRecordCb record;
+    void *record_user_data;
+} BMP280CaptureCfg;
+
+/** Capture state. Memory is provided by the user. Statistics fields can be read directly, other fields are private. */
+typedef struct {
+    BMP280CaptureCfg cfg;
+    /** Index of the oldest sample in the ring, and number of samples in it. */
+    size_t ring_head;
+    size_t ring_num;
+    bool has_baseline;
+    /** Baseline in Q24.16 Pa: pressure with 8 additional fractional bits. */
+    int64_t baseline;
+    int64_t cusum_pos;
+    int64_t cusum_neg;
+    /** Number of samples left in the post-trigger window, 0 while no event is in progress. */
+    uint32_t post_left;
+    /** Number of detected events. */
+    uint32_t num_events;
+    /** Number of samples passed to @ref bmp280_capture_add. */
+    uint64_t num_samples;
+    /** Number of samples passed to the record callback. */
+    uint64_t num_recorded;
+} BMP280Capture;
+
+/**
+ * @brief Initialize capture state.
+ *
+ * @param[out] capture Capture state to initialize.
+ * @param[in] cfg Configuration. Copied into @p capture.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully initialized @p capture.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p capture, @p cfg or the record callback is NULL, ring is NULL with a
+ * ring_capacity other than 0, baseline_shift is larger than 16, or cusum_threshold is 0.
+ */
+uint8_t bmp280_capture_init(BMP280Capture *const capture, const BMP280CaptureCfg *const cfg);
+
+/**
+ * @brief Add the next sample of the full-rate stream.
+ *
+ * Executes the record callback for every sample that is recorded because of this sample: the pre-trigger ring and
+ * this sample on a trigger, only this sample during the post-trigger window.
+ *
+ * @param[in] capture Capture state.
+ * @param[in] timestamp_ms Time of the sample.
+ * @param[in] meas Sample.
+ *
+ * @return bool true if an event is in progress after this sample.
+ */
+bool bmp280_capture_add(BMP280Capture *const capture, uint32_t timestamp_ms, const BMP280Meas *const meas);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_BMP280_CAPTURE_H */
@@ -0,0 +1,394 @@
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "bmp280_chunk_store.h"
+#include "bmp280_varint.h"
+
+/** "BCST" in little-endian byte order. */
+#define BMP280_CHUNK_STORE_MAGIC 0x54534342U
+
+/** Index entries and chunk slots start at multiples of this. */
+#define BMP280_CHUNK_STORE_ALIGN 8U
+
+static size_t align_up(size_t size)
+{
+    return (size + BMP280_CHUNK_STORE_ALIGN - 1) & ~((size_t)BMP280_CHUNK_STORE_ALIGN - 1);
+}
+
+static size_t chunk_size(const BMP280ChunkStoreHeader *const header)
+{
+    return align_up((size_t)header->ts_col_size + header->temp_col_size + header->pres_col_size);
+}
+
+static size_t index_offset(void)
+{
+    return align_up(sizeof(BMP280ChunkStoreHeader));
+}
+
+static size_t chunks_offset(uint32_t num_chunks)
+{
+    return index_offset() + align_up((size_t)num_chunks * sizeof(BMP280ChunkStoreIndexEntry));
+}
+
+size_t bmp280_chunk_store_mem_size(const BMP280ChunkStoreCfg *const cfg)
+{
+    if (!cfg) {
+        return 0;
+    }
+    size_t size = align_up((size_t)cfg->ts_col_size + cfg->temp_col_size + cfg->pres_col_size);
+    return chunks_offset(cfg->num_chunks) + (size_t)cfg->num_chunks * size;
+}
+
+static void store_attach(BMP280ChunkStore *const store, void *mem)
+{
+    uint8_t *base = (uint8_t *)mem;
+    store->header = (BMP280ChunkStoreHeader *)mem;
+    store->index = (BMP280ChunkStoreIndexEntry *)(void *)&base[index_offset()];
+    store->chunks = &base[chunks_offset(store->header->num_chunks)];
+    store->chunk_size = chunk_size(store->header);
+}
+
+uint8_t bmp280_chunk_store_format(BMP280ChunkStore *const store, void *mem, size_t size,
+                                  const BMP280ChunkStoreCfg *const cfg)
+{
+    if (!store || !mem || !cfg || ((uintptr_t)mem % BMP280_CHUNK_STORE_ALIGN) != 0) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    if (cfg->chunk_duration_ms == 0 || cfg->num_chunks == 0 || cfg->ts_col_size < BMP280_VARINT64_MAX_LEN ||
+        cfg->temp_col_size < BMP280_VARINT32_MAX_LEN || cfg->pres_col_size < BMP280_VARINT32_MAX_LEN) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    if (size < bmp280_chunk_store_mem_size(cfg)) {
+        return BMP280_RESULT_CODE_NO_MEM;
+    }
+
+    BMP280ChunkStoreHeader *header = (BMP280ChunkStoreHeader *)mem;
+    memset(header, 0, sizeof(*header));
+    header->magic = BMP280_CHUNK_STORE_MAGIC;
+    header->version = BMP280_CHUNK_STORE_VERSION;
+    header->sensor_id = cfg->sensor_id;
+    header->chunk_duration_ms = cfg->chunk_duration_ms;
+    header->num_chunks = cfg->num_chunks;
+    header->ts_col_size = cfg->ts_col_size;
+    header->temp_col_size = cfg->temp_col_size;
+    header->pres_col_size = cfg->pres_col_size;
+    store_attach(store, mem);
+    return BMP280_RESULT_CODE_OK;
+}
+
+uint8_t bmp280_chunk_store_open(BMP280ChunkStore *const store, void *mem, size_t size)
+{
+    if (!store || !mem || ((uintptr_t)mem % BMP280_CHUNK_STORE_ALIGN) != 0 || size < sizeof(BMP280ChunkStoreHeader)) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    const BMP280ChunkStoreHeader *header = (const BMP280ChunkStoreHeader *)mem;
+    BMP280ChunkStoreCfg cfg = {
+        .sensor_id = header->sensor_id,
+        .chunk_duration_ms = header->chunk_duration_ms,
+        .num_chunks = header->num_chunks,
+        .ts_col_size = header->ts_col_size,
+        .temp_col_size = header->temp_col_size,
+        .pres_col_size = header->pres_col_size,
+    };
+    if (header->magic != BMP280_CHUNK_STORE_MAGIC || header->version != BMP280_CHUNK_STORE_VERSION ||
+        cfg.chunk_duration_ms == 0 || cfg.num_chunks == 0 || size < bmp280_chunk_store_mem_size(&cfg) ||
+        header->first_chunk >= cfg.num_chunks || header->num_used > cfg.num_chunks) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    store_attach(store, mem);
+    return BMP280_RESULT_CODE_OK;
+}
+
+/** Index entry of the chunk at position @p i, counted from the oldest chunk. */
+static BMP280ChunkStoreIndexEntry *entry_at(const BMP280ChunkStore *const store, uint32_t i)
+{
+    return &store->index[(store->header->first_chunk + i) % store->header->num_chunks];
+}
+
+static uint8_t *chunk_at(const BMP280ChunkStore *const store, const BMP280ChunkStoreIndexEntry *const entry)
+{
+    return &store->chunks[(size_t)(entry - store->index) * store->chunk_size];
+}
+
+/** Start a new chunk for a sample at @p timestamp_ms, dropping the oldest chunk if all slots are used. */
+static BMP280ChunkStoreIndexEntry *start_chunk(BMP280ChunkStore *const store, uint64_t timestamp_ms)
+{
+    BMP280ChunkStoreHeader *header = store->header;
+    if (header->num_used == header->num_chunks) {
+        header->first_chunk = (header->first_chunk + 1) % header->num_chunks;
+        header->num_used--;
+    }
+    BMP280ChunkStoreIndexEntry *entry = entry_at(store, header->num_used);
+    memset(entry, 0, sizeof(*entry));
+    entry->first_ts_ms = timestamp_ms;
+    entry->last_ts_ms = timestamp_ms;
+    header->last_ts_ms = timestamp_ms;
+    header->last_ts_delta = 0;
+    header->last_temp = 0;
+    header->last_pres = 0;
+    header->num_used++;
+    return entry;
+}
+
+/** A sample encoded for the columns of the newest chunk. */
+typedef struct {
+    uint8_t ts[BMP280_VARINT64_MAX_LEN];
+    uint8_t temp[BMP280_VARINT32_MAX_LEN];
+    uint8_t pres[BMP280_VARINT32_MAX_LEN];
+    size_t ts_len;
+    size_t temp_len;
+    size_t pres_len;
+} EncodedSample;
+
+/** @return bool false if the sample does not fit into the columns of @p entry. */
+static bool encode_sample(const BMP280ChunkStoreHeader *const header, const BMP280ChunkStoreIndexEntry *const entry,
+                          uint64_t timestamp_ms, const BMP280Meas *const meas, EncodedSample *const enc)
+{
+    enc->ts_len = 0;
+    /* The first timestamp of a chunk is in the index */
+    if (entry->num_samples > 0) {
+        uint64_t ts_delta = timestamp_ms - header->last_ts_ms;
+        enc->ts_len = bmp280_varint_put(enc->ts, bmp280_zigzag_encode_64(ts_delta - header->last_ts_delta));
+    }
+    uint32_t temp_delta = (uint32_t)meas->temperature - (uint32_t)header->last_temp;
+    enc->temp_len = bmp280_varint_put(enc->temp, bmp280_zigzag_encode_32(temp_delta));
+    enc->pres_len = bmp280_varint_put(enc->pres, bmp280_zigzag_encode_32(meas->pressure - header->last_pres));
+    return (size_t)entry->ts_len + enc->ts_len <= header->ts_col_size &&
+           (size_t)entry->temp_len + enc->temp_len <= header->temp_col_size &&
+           (size_t)entry->pres_len + enc->pres_len <= header->pres_col_size;
+}
+
+uint8_t bmp280_chunk_store_append(BMP280ChunkStore *const store, uint64_t timestamp_ms, const BMP280Meas *const meas)
+{
+    if (!store || !meas) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    BMP280ChunkStoreHeader *header = store->header;
+    if (header->num_used > 0 && timestamp_ms < header->last_ts_ms) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    EncodedSample enc;
+    BMP280ChunkStoreIndexEntry *entry = (header->num_used > 0) ? entry_at(store, header->num_used - 1) : NULL;
+    if (entry) {
+        uint64_t window_start = entry->first_ts_ms - entry->first_ts_ms % header->chunk_duration_ms;
+        if (timestamp_ms - window_start >= header->chunk_duration_ms || entry->num_samples == UINT16_MAX ||
+            !encode_sample(header, entry, timestamp_ms, meas, &enc)) {
+            entry = NULL;
+        }
+    }
+    if (!entry) {
+        entry = start_chunk(store, timestamp_ms);
+        /* Always fits, format checked that every column has room for the longest value */
+        encode_sample(header, entry, timestamp_ms, meas, &enc);
+    }
+
+    uint8_t *chunk = chunk_at(store, entry);
+    memcpy(&chunk[entry->ts_len], enc.ts, enc.ts_len);
+    memcpy(&chunk[header->ts_col_size + entry->temp_len], enc.temp, enc.temp_len);
+    memcpy(&chunk[(size_t)header->ts_col_size + header->temp_col_size + entry->pres_len], enc.pres, enc.pres_len);
+
+    if (entry->num_samples == 0 || meas->temperature < entry->temp_min) {
+        entry->temp_min = meas->temperature;
+    }
+    if (entry->num_samples == 0 || meas->temperature > entry->temp_max) {
+        entry->temp_max = meas->temperature;
+    }
+    if (entry->num_samples == 0 || meas->pressure < entry->pres_min) {
+        entry->pres_min = meas->pressure;
+    }
+    if (entry->num_samples == 0 || meas->pressure > entry->pres_max) {
+        entry->pres_max = meas->pressure;
+    }
+    entry->last_ts_ms = timestamp_ms;
+    entry->ts_len = (uint16_t)(entry->ts_len + enc.ts_len);
+    entry->temp_len = (uint16_t)(entry->temp_len + enc.temp_len);
+    entry->pres_len = (uint16_t)(entry->pres_len + enc.pres_len);
+    entry->num_samples++;
+
+    header->last_ts_delta = (entry->num_samples > 1) ? timestamp_ms - header->last_ts_ms : 0;
+    header->last_ts_ms = timestamp_ms;
+    header->last_temp = meas->temperature;
+    header->last_pres = meas->pressure;
+    return BMP280_RESULT_CODE_OK;
+}
+
+size_t bmp280_chunk_store_num_chunks(const BMP280ChunkStore *const store)
+{
+    return store->header->num_used;
+}
+
+uint32_t bmp280_chunk_store_sensor_id(const BMP280ChunkStore *const store)
+{
+    return store->header->sensor_id;
+}
+
+void bmp280_chunk_store_filter_init(BMP280ChunkStoreFilter *const filter, uint64_t from_ms, uint64_t to_ms)
+{
+    filter->from_ms = from_ms;
+    filter->to_ms = to_ms;
+    filter->temp_min = INT32_MIN;
+    filter->temp_max = INT32_MAX;
+    filter->pres_min = 0;
+    filter->pres_max = UINT32_MAX;
+}
+
+/**
+ * @brief Decode every sample of a chunk.
+ *
+ * @return size_t Number of samples decoded. Less than entry->num_samples only if the chunk is corrupt.
+ */
+static size_t decode_chunk(const BMP280ChunkStore *const store, const BMP280ChunkStoreIndexEntry *const entry,
+                           void (*fn)(uint64_t timestamp_ms, const BMP280Meas *meas, void *ctx), void *ctx)
+{
+    const BMP280ChunkStoreHeader *header = store->header;
+    const uint8_t *chunk = chunk_at(store, entry);
+    const uint8_t *ts_col = chunk;
+    const uint8_t *temp_col = &chunk[header->ts_col_size];
+    const uint8_t *pres_col = &chunk[(size_t)header->ts_col_size + header->temp_col_size];
+    size_t ts_pos = 0;
+    size_t temp_pos = 0;
+    size_t pres_pos = 0;
+    uint64_t ts = entry->first_ts_ms;
+    uint64_t ts_delta = 0;
+    BMP280Meas meas = {0, 0};
+
+    for (size_t i = 0; i < entry->num_samples; i++) {
+        uint64_t val;
+        if (i > 0) {
+            if (!bmp280_varint_get(ts_col, entry->ts_len, &ts_pos, BMP280_VARINT64_MAX_LEN, &val)) {
+                return i;
+            }
+            ts_delta += bmp280_zigzag_decode_64(val);
+            ts += ts_delta;
+        }
+        if (!bmp280_varint_get(temp_col, entry->temp_len, &temp_pos, BMP280_VARINT64_MAX_LEN, &val)) {
+            return i;
+        }
+        meas.temperature = (int32_t)((uint32_t)meas.temperature + bmp280_zigzag_decode_32((uint32_t)val));
+        if (!bmp280_varint_get(pres_col, entry->pres_len, &pres_pos, BMP280_VARINT64_MAX_LEN, &val)) {
+            return i;
+        }
+        meas.pressure += bmp280_zigzag_decode_32((uint32_t)val);
+        fn(ts, &meas, ctx);
+    }
+    return entry->num_samples;
+}
+
+typedef struct {
+    const BMP280ChunkStoreFilter *filter;
+    BMP280ChunkStoreSampleCb cb;
+    void *user_data;
+    size_t num_samples;
+} QueryCtx;
+
+static void query_sample(uint64_t timestamp_ms, const BMP280Meas *meas, void *ctx)
+{
+    QueryCtx *q = (QueryCtx *)ctx;
+    const BMP280ChunkStoreFilter *f = q->filter;
+    if (timestamp_ms < f->from_ms || timestamp_ms > f->to_ms || meas->temperature < f->temp_min ||
+        meas->temperature > f->temp_max || meas->pressure < f->pres_min || meas->pressure > f->pres_max) {
+        return;
+    }
+    q->num_samples++;
+    if (q->cb) {
+        q->cb(timestamp_ms, meas, q->user_data);
+    }
+}
+
+uint8_t bmp280_chunk_store_query(const BMP280ChunkStore *const store, const BMP280ChunkStoreFilter *const filter,
+                                 BMP280ChunkStoreSampleCb cb, void *user_data, BMP280ChunkStoreQueryStats *const stats)
+{
+    if (!store || !filter) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    BMP280ChunkStoreQueryStats s = {0, 0, 0, 0};
+    QueryCtx ctx = {filter, cb, user_data, 0};
+    uint32_t num_used = store->header->num_used;
+    for (uint32_t i = 0; i < num_used; i++) {
+        const BMP280ChunkStoreIndexEntry *e = entry_at(store, i);
+        if (e->first_ts_ms > filter->to_ms) {
+            /* Chunks are in time order, so none of the remaining ones can match either */
+            s.num_chunks_skipped += num_used - i;
+            break;
+        }
+        if (e->last_ts_ms < filter->from_ms || e->temp_max < filter->temp_min || e->temp_min > filter->temp_max ||
+            e->pres_max < filter->pres_min || e->pres_min > filter->pres_max) {
+            s.num_chunks_skipped++;
+            continue;
+        }
+        decode_chunk(store, e, query_sample, &ctx);
+        s.num_chunks_decoded++;
+    }
+    s.num_samples = ctx.num_samples;
+    if (stats) {
+        *stats = s;
+    }
+    return BMP280_RESULT_CODE_OK;
+}
+
+typedef struct {
+    uint64_t from_ms;
+    uint64_t to_ms;
+    BMP280ChunkStoreMinMax *result;
+} MinMaxCtx;
+
+static void minmax_merge(BMP280ChunkStoreMinMax *const r, int32_t temp_min, int32_t temp_max, uint32_t pres_min,
+                         uint32_t pres_max, size_t num_samples)
+{
+    if (r->num_samples == 0 || temp_min < r->temp_min) {
+        r->temp_min = temp_min;
+    }
+    if (r->num_samples == 0 || temp_max > r->temp_max) {
+        r->temp_max = temp_max;
+    }
+    if (r->num_samples == 0 || pres_min < r->pres_min) {
+        r->pres_min = pres_min;
+    }
+    if (r->num_samples == 0 || pres_max > r->pres_max) {
+        r->pres_max = pres_max;
+    }
+    r->num_samples += num_samples;
+}
+
+static void minmax_sample(uint64_t timestamp_ms, const BMP280Meas *meas, void *ctx)
+{
+    MinMaxCtx *m = (MinMaxCtx *)ctx;
+    if (timestamp_ms >= m->from_ms && timestamp_ms <= m->to_ms) {
+        minmax_merge(m->result, meas->temperature, meas->temperature, meas->pressure, meas->pressure, 1);
+    }
+}
+
+uint8_t bmp280_chunk_store_minmax(const BMP280ChunkStore *const store, uint64_t from_ms, uint64_t to_ms,
+                                  BMP280ChunkStoreMinMax *const result, BMP280ChunkStoreQueryStats *const stats)
+{
+    if (!store || !result) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    memset(result, 0, sizeof(*result));
+    BMP280ChunkStoreQueryStats s = {0, 0, 0, 0};
+    MinMaxCtx ctx = {from_ms, to_ms, result};
+    uint32_t num_used = store->header->num_used;
+    for (uint32_t i = 0; i < num_used; i++) {
+        const BMP280ChunkStoreIndexEntry *e = entry_at(store, i);
+        if (e->first_ts_ms > to_ms) {
+            s.num_chunks_skipped += num_used - i;
+            break;
+        }
+        if (e->last_ts_ms < from_ms || e->num_samples == 0) {
+            s.num_chunks_skipped++;
+        } else if (e->first_ts_ms >= from_ms && e->last_ts_ms <= to_ms) {
+            minmax_merge(result, e->temp_min, e->temp_max, e->pres_min, e->pres_max, e->num_samples);
+            s.num_chunks_from_index++;
+        } else {
+            decode_chunk(store, e, minmax_sample, &ctx);
+            s.num_chunks_decoded++;
+        }
+    }
+    s.num_samples = result->num_samples;
+    if (stats) {
+        *stats = s;
+    }
+    return BMP280_RESULT_CODE_OK;
+}
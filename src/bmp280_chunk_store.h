@@ -0,0 +1,251 @@
+#ifndef SRC_BMP280_CHUNK_STORE_H
+#define SRC_BMP280_CHUNK_STORE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "bmp280.h"
+
+/**
+ * @brief Append-only columnar store of the measurement history of one sensor, with a per-chunk index.
+ *
+ * Samples are stored in chunks that each cover at most one time window of chunk_duration_ms, aligned to multiples of
+ * chunk_duration_ms. A chunk has a separate column for timestamps, temperatures and pressures:
+ * - timestamps: delta-of-delta from the previous sample, as zigzag varints. The first timestamp of a chunk is in the
+ * index. With a fixed sample period, every timestamp after the second one takes one byte.
+ * - temperatures and pressures: delta from the previous sample of the chunk (from 0 for the first one), as zigzag
+ * varints.
+ *
+ * For every chunk the index holds the time range, the number of samples and the minimum and maximum of temperature and
+ * pressure. Queries use the index to skip chunks that cannot contain matching samples without decoding them, and
+ * @ref bmp280_chunk_store_minmax takes the extremes of chunks that are completely inside the time range straight from
+ * the index.
+ *
+ * The store lives in one contiguous memory region provided by the user, which can be a memory-mapped file. The
+ * region contains no pointers, so a store written by one process can be opened by another with
+ * @ref bmp280_chunk_store_open. Layout, all fields in host byte order:
+ * - @ref BMP280ChunkStoreHeader
+ * - num_chunks @ref BMP280ChunkStoreIndexEntry
+ * - num_chunks chunk slots, each with ts_col_size bytes of timestamp column, temp_col_size bytes of temperature column
+ * and pres_col_size bytes of pressure column
+ *
+ * Chunk slots are used as a ring. Once all slots are used, the oldest chunk is dropped to make room for a new one.
+ * @ref bmp280_chunk_store_append only writes to the newest chunk slot, its index entry and the header, in that order,
+ * so it is cheap enough for the acquisition path, and the pages of older chunks are never written again.
+ */
+
+/** Version of the memory layout. */
+#define BMP280_CHUNK_STORE_VERSION 1
+
+/** Header of the store memory. Fields are private, use the functions of this module to access them. */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved0;
+    uint32_t sensor_id;
+    uint32_t chunk_duration_ms;
+    uint32_t num_chunks;
+    uint16_t ts_col_size;
+    uint16_t temp_col_size;
+    uint16_t pres_col_size;
+    uint16_t reserved1;
+    /** Slot of the oldest chunk. */
+    uint32_t first_chunk;
+    /** Number of chunks with samples. The newest one is open for appending. */
+    uint32_t num_used;
+    /** Encoder state of the newest chunk: timestamp, timestamp delta and values of the last sample. */
+    uint64_t last_ts_ms;
+    uint64_t last_ts_delta;
+    int32_t last_temp;
+    uint32_t last_pres;
+} BMP280ChunkStoreHeader;
+
+/** Index entry of one chunk. */
+typedef struct {
+    uint64_t first_ts_ms;
+    uint64_t last_ts_ms;
+    int32_t temp_min;
+    int32_t temp_max;
+    uint32_t pres_min;
+    uint32_t pres_max;
+    uint16_t num_samples;
+    /** Number of used bytes in each column. */
+    uint16_t ts_len;
+    uint16_t temp_len;
+    uint16_t pres_len;
+} BMP280ChunkStoreIndexEntry;
+
+/** Store configuration, used by @ref bmp280_chunk_store_format. */
+typedef struct {
+    /** Id of the sensor whose samples are stored. */
+    uint32_t sensor_id;
+    /** Time window of one chunk. */
+    uint32_t chunk_duration_ms;
+    /** Number of chunk slots. */
+    uint32_t num_chunks;
+    /** Sizes of the columns of one chunk in bytes. A chunk is closed early when one of them is full. */
+    uint16_t ts_col_size;
+    uint16_t temp_col_size;
+    uint16_t pres_col_size;
+} BMP280ChunkStoreCfg;
+
+/**
+ * @brief Handle of a store.
+ *
+ * Memory is provided by the user. Fields are private, use the functions of this module to access them.
+ */
+typedef struct {
+    BMP280ChunkStoreHeader *header;
+    BMP280ChunkStoreIndexEntry *index;
+    uint8_t *chunks;
+    size_t chunk_size;
+} BMP280ChunkStore;
+
+/**
+ * @brief Sample filter of @ref bmp280_chunk_store_query. All bounds are inclusive.
+ *
+ * Initialize with @ref bmp280_chunk_store_filter_init, then narrow the value ranges for threshold queries.
+ */
+typedef struct {
+    uint64_t from_ms;
+    uint64_t to_ms;
+    int32_t temp_min;
+    int32_t temp_max;
+    uint32_t pres_min;
+    uint32_t pres_max;
+} BMP280ChunkStoreFilter;
+
+/** Number of chunks that a query visited, and how. */
+typedef struct {
+    /** Chunks that were not decoded, because the index shows that they cannot contain matching samples. */
+    size_t num_chunks_skipped;
+    /** Chunks that were answered from the index only. */
+    size_t num_chunks_from_index;
+    size_t num_chunks_decoded;
+    /** Samples that matched the query. */
+    size_t num_samples;
+} BMP280ChunkStoreQueryStats;
+
+/** Result of @ref bmp280_chunk_store_minmax. */
+typedef struct {
+    int32_t temp_min;
+    int32_t temp_max;
+    uint32_t pres_min;
+    uint32_t pres_max;
+    /** Number of samples in the time range. The other fields are only valid if it is not 0. */
+    size_t num_samples;
+} BMP280ChunkStoreMinMax;
+
+/**
+ * @brief Executed by @ref bmp280_chunk_store_query for every matching sample, oldest first.
+ */
+typedef void (*BMP280ChunkStoreSampleCb)(uint64_t timestamp_ms, const BMP280Meas *meas, void *user_data);
+
+/**
+ * @brief Size of the memory region of a store with configuration @p cfg.
+ *
+ * @return size_t Size in bytes, 0 if @p cfg is NULL.
+ */
+size_t bmp280_chunk_store_mem_size(const BMP280ChunkStoreCfg *const cfg);
+
+/**
+ * @brief Create an empty store in @p mem.
+ *
+ * @param[out] store Store handle to initialize.
+ * @param[in] mem Memory region of the store, aligned to 8 bytes.
+ * @param[in] size Size of @p mem.
+ * @param[in] cfg Store configuration.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully created the store.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG A pointer is NULL, @p mem is not aligned, chunk_duration_ms or num_chunks is 0,
+ * or a column is smaller than the longest encoded value of its kind.
+ * @retval BMP280_RESULT_CODE_NO_MEM @p size is smaller than @ref bmp280_chunk_store_mem_size.
+ */
+uint8_t bmp280_chunk_store_format(BMP280ChunkStore *const store, void *mem, size_t size,
+                                  const BMP280ChunkStoreCfg *const cfg);
+
+/**
+ * @brief Open a store that was created with @ref bmp280_chunk_store_format, e.g. in a memory-mapped file.
+ *
+ * @param[out] store Store handle to initialize.
+ * @param[in] mem Memory region of the store, aligned to 8 bytes.
+ * @param[in] size Size of @p mem.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully opened the store.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG A pointer is NULL, @p mem is not aligned, or @p mem does not contain a store
+ * of this version that fits into @p size.
+ */
+uint8_t bmp280_chunk_store_open(BMP280ChunkStore *const store, void *mem, size_t size);
+
+/**
+ * @brief Append a sample.
+ *
+ * Starts a new chunk if the sample is outside the time window of the newest chunk, or does not fit into its columns.
+ *
+ * @param[in] store Store.
+ * @param[in] timestamp_ms Time of the sample. Must not be older than the previous sample.
+ * @param[in] meas Measurement.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully appended the sample.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p store or @p meas is NULL, or @p timestamp_ms is older than the previous
+ * sample.
+ */
+uint8_t bmp280_chunk_store_append(BMP280ChunkStore *const store, uint64_t timestamp_ms, const BMP280Meas *const meas);
+
+/**
+ * @brief Number of chunks with samples.
+ */
+size_t bmp280_chunk_store_num_chunks(const BMP280ChunkStore *const store);
+
+/**
+ * @brief Sensor id from the store configuration.
+ */
+uint32_t bmp280_chunk_store_sensor_id(const BMP280ChunkStore *const store);
+
+/**
+ * @brief Initialize a filter that matches every sample between @p from_ms and @p to_ms, inclusive.
+ */
+void bmp280_chunk_store_filter_init(BMP280ChunkStoreFilter *const filter, uint64_t from_ms, uint64_t to_ms);
+
+/**
+ * @brief Execute @p cb for every sample that matches @p filter.
+ *
+ * @param[in] store Store.
+ * @param[in] filter Filter.
+ * @param[in] cb Callback to execute for every matching sample. Can be NULL to only count them.
+ * @param[in] user_data User data to pass to @p cb.
+ * @param[out] stats Statistics of the query. Can be NULL.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully executed the query.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p store or @p filter is NULL.
+ */
+uint8_t bmp280_chunk_store_query(const BMP280ChunkStore *const store, const BMP280ChunkStoreFilter *const filter,
+                                 BMP280ChunkStoreSampleCb cb, void *user_data, BMP280ChunkStoreQueryStats *const stats);
+
+/**
+ * @brief Minimum and maximum temperature and pressure between @p from_ms and @p to_ms, inclusive.
+ *
+ * Only the chunks at the ends of the time range are decoded.
+ *
+ * @param[in] store Store.
+ * @param[in] from_ms Start of the time range.
+ * @param[in] to_ms End of the time range.
+ * @param[out] result Result.
+ * @param[out] stats Statistics of the query. Can be NULL.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully executed the query.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p store or @p result is NULL.
+ */
+uint8_t bmp280_chunk_store_minmax(const BMP280ChunkStore *const store, uint64_t from_ms, uint64_t to_ms,
+                                  BMP280ChunkStoreMinMax *const result, BMP280ChunkStoreQueryStats *const stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_BMP280_CHUNK_STORE_H */
@@ -0,0 +1,462 @@
+#include <stdbool.h>
+
+#include "bmp280_compensate.h"
+
+int32_t bmp280_compensate_temp(const BMP280CalibTemp *const calib_temp, int32_t temp_raw, int32_t *const t_fine)
+{
+    uint16_t dig_T1 = calib_temp->dig_T1;
+    int16_t dig_T2 = calib_temp->dig_T2;
+    int16_t dig_T3 = calib_temp->dig_T3;
+
+    int32_t var1 = ((((temp_raw >> 3) - ((int32_t)dig_T1 << 1))) * ((int32_t)dig_T2)) >> 11;
+    int32_t var2 =
+        (((((temp_raw >> 4) - ((int32_t)dig_T1)) * ((temp_raw >> 4) - ((int32_t)dig_T1))) >> 12) * ((int32_t)dig_T3)) >>
+        14;
+    *t_fine = var1 + var2;
+    int32_t T = (*t_fine * 5 + 128) >> 8;
+    return T;
+}
+
+uint32_t bmp280_compensate_pres(const BMP280CalibPres *const calib, int32_t pres_raw, int32_t t_fine)
+{
+    int64_t var1, var2, p;
+    var1 = ((int64_t)t_fine) - 128000;
+    var2 = var1 * var1 * (int64_t)calib->dig_P6;
+    var2 = var2 + ((var1 * (int64_t)calib->dig_P5) << 17);
+    var2 = var2 + (((int64_t)calib->dig_P4) << 35);
+    var1 = ((var1 * var1 * (int64_t)calib->dig_P3) >> 8) + ((var1 * (int64_t)calib->dig_P2) << 12);
+    var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)calib->dig_P1) >> 33;
+    if (var1 == 0) {
+        return 0; // avoid exception caused by division by zero
+    }
+    p = 1048576 - pres_raw;
+    p = (((p << 31) - var2) * 3125) / var1;
+    var1 = (((int64_t)calib->dig_P9) * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (((int64_t)calib->dig_P8) * p) >> 19;
+    p = ((p + var1 + var2) >> 8) + (((int64_t)calib->dig_P7) << 4);
+    return (uint32_t)p;
+}
+
+void bmp280_compensate_pres_coeffs(const BMP280CalibPres *const calib, int32_t t_fine, BMP280PresCoeffs *const coeffs)
+{
+    /* Same steps as the first half of bmp280_compensate_pres, which does not depend on the raw pressure value */
+    int64_t var1, var2;
+    var1 = ((int64_t)t_fine) - 128000;
+    var2 = var1 * var1 * (int64_t)calib->dig_P6;
+    var2 = var2 + ((var1 * (int64_t)calib->dig_P5) << 17);
+    var2 = var2 + (((int64_t)calib->dig_P4) << 35);
+    var1 = ((var1 * var1 * (int64_t)calib->dig_P3) >> 8) + ((var1 * (int64_t)calib->dig_P2) << 12);
+    var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)calib->dig_P1) >> 33;
+
+    coeffs->var1 = var1;
+    coeffs->var2 = var2;
+    coeffs->dig_P7 = calib->dig_P7;
+    coeffs->dig_P8 = calib->dig_P8;
+    coeffs->dig_P9 = calib->dig_P9;
+}
+
+uint32_t bmp280_compensate_pres_with_coeffs(const BMP280PresCoeffs *const coeffs, int32_t pres_raw)
+{
+    if (coeffs->var1 == 0) {
+        return 0; // avoid exception caused by division by zero
+    }
+    int64_t var1, var2, p;
+    p = 1048576 - pres_raw;
+    p = (((p << 31) - coeffs->var2) * 3125) / coeffs->var1;
+    var1 = (((int64_t)coeffs->dig_P9) * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (((int64_t)coeffs->dig_P8) * p) >> 19;
+    p = ((p + var1 + var2) >> 8) + (((int64_t)coeffs->dig_P7) << 4);
+    return (uint32_t)p;
+}
+
+void bmp280_temp_lut_build(BMP280TempLut *const lut, const BMP280CalibTemp *const calib_temp,
+                           BMP280TempLutEntry *const entries, size_t num_entries, int32_t raw_min, uint8_t raw_shift)
+{
+    for (size_t i = 0; i < num_entries; i++) {
+        int32_t temp_raw = raw_min + (int32_t)(i << raw_shift);
+        entries[i].temperature = bmp280_compensate_temp(calib_temp, temp_raw, &entries[i].t_fine);
+    }
+    lut->entries = entries;
+    lut->num_entries = num_entries;
+    lut->raw_min = raw_min;
+    lut->raw_shift = raw_shift;
+}
+
+int32_t bmp280_compensate_temp_lut(const BMP280TempLut *const lut, const BMP280CalibTemp *const calib_temp,
+                                   int32_t temp_raw, int32_t *const t_fine)
+{
+    /* Unsigned, so that raw values below raw_min wrap around to large offsets and fail the range check */
+    uint32_t offset = (uint32_t)temp_raw - (uint32_t)lut->raw_min;
+    uint32_t idx = offset >> lut->raw_shift;
+    if (lut->entries && ((offset & ((1U << lut->raw_shift) - 1U)) == 0) && (idx < lut->num_entries)) {
+        *t_fine = lut->entries[idx].t_fine;
+        return lut->entries[idx].temperature;
+    }
+    return bmp280_compensate_temp(calib_temp, temp_raw, t_fine);
+}
+
+/** Largest 20-bit raw value. */
+#define BMP280_RAW_VAL_MAX 0xFFFFF
+
+/** Maximum number of secant steps when estimating the raw value in inverse compensation. */
+#define BMP280_INVERSE_MAX_SECANT_STEPS 6
+
+/**
+ * @brief Function that inverse compensation searches. Must decrease monotonically with @p raw.
+ *
+ * Temperature grows with the raw value, so temperature is searched as its negation.
+ */
+typedef int64_t (*InverseKeyFn)(const void *ctx, int32_t raw);
+
+static int64_t inverse_temp_key(const void *ctx, int32_t raw)
+{
+    int32_t t_fine;
+    return -(int64_t)bmp280_compensate_temp((const BMP280CalibTemp *)ctx, raw, &t_fine);
+}
+
+static int64_t inverse_pres_key(const void *ctx, int32_t raw)
+{
+    /* Raw values close to 0xFFFFF produce negative pressures that wrap around to large uint32_t values. Pressures of
+     * real devices fit into 31 bits, so interpreting the result as signed keeps the key monotonic. */
+    return (int64_t)(int32_t)bmp280_compensate_pres_with_coeffs((const BMP280PresCoeffs *)ctx, raw);
+}
+
+/**
+ * @brief Estimate the raw value for which key is @p target with secant steps, starting from the ends of the raw range.
+ *
+ * The compensation formulas are close to linear in the raw value, so the estimate is usually within a few raw values of
+ * the result.
+ */
+static int32_t inverse_estimate(InverseKeyFn key, const void *ctx, int64_t target, int64_t key_min, int64_t key_max)
+{
+    int64_t a = 0;
+    int64_t key_a = key_min;
+    int64_t b = BMP280_RAW_VAL_MAX;
+    int64_t key_b = key_max;
+    for (size_t i = 0; (i < BMP280_INVERSE_MAX_SECANT_STEPS) && (key_a != key_b); i++) {
+        int64_t c = b - ((key_b - target) * (b - a)) / (key_b - key_a);
+        if (c < 0) {
+            c = 0;
+        } else if (c > BMP280_RAW_VAL_MAX) {
+            c = BMP280_RAW_VAL_MAX;
+        }
+        if ((c - b <= 1) && (b - c <= 1)) {
+            b = c;
+            break;
+        }
+        a = b;
+        key_a = key_b;
+        b = c;
+        key_b = key(ctx, (int32_t)c);
+    }
+    return (int32_t)b;
+}
+
+/**
+ * @brief Find the smallest raw value for which key is at most @p target.
+ *
+ * @pre key(0) > @p target >= key(BMP280_RAW_VAL_MAX).
+ *
+ * Brackets the result with exponentially growing steps from @p guess, then bisects the bracket.
+ */
+static int32_t inverse_find_first_le(InverseKeyFn key, const void *ctx, int64_t target, int32_t guess)
+{
+    /* Invariant after bracketing: key(lo) > target >= key(hi) */
+    int32_t lo, hi;
+    int32_t step = 1;
+    if (key(ctx, guess) <= target) {
+        hi = guess;
+        while (1) {
+            lo = hi - step;
+            if (lo <= 0) {
+                lo = 0;
+                break;
+            }
+            if (key(ctx, lo) > target) {
+                break;
+            }
+            hi = lo;
+            step *= 2;
+        }
+    } else {
+        lo = guess;
+        while (1) {
+            hi = lo + step;
+            if (hi >= BMP280_RAW_VAL_MAX) {
+                hi = BMP280_RAW_VAL_MAX;
+                break;
+            }
+            if (key(ctx, hi) <= target) {
+                break;
+            }
+            lo = hi;
+            step *= 2;
+        }
+    }
+
+    while (hi - lo > 1) {
+        int32_t mid = lo + (hi - lo) / 2;
+        if (key(ctx, mid) > target) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return hi;
+}
+
+/**
+ * @brief Find the smallest raw value whose key is closest to @p target.
+ */
+static int32_t inverse_find_closest(InverseKeyFn key, const void *ctx, int64_t target)
+{
+    int64_t key_min = key(ctx, 0);
+    if (key_min <= target) {
+        return 0;
+    }
+    int64_t key_max = key(ctx, BMP280_RAW_VAL_MAX);
+    if (key_max > target) {
+        return BMP280_RAW_VAL_MAX;
+    }
+    int32_t guess = inverse_estimate(key, ctx, target, key_min, key_max);
+    int32_t raw = inverse_find_first_le(key, ctx, target, guess);
+    /* raw > 0, because key(0) > target */
+    int64_t key_below = key(ctx, raw - 1);
+    if (key_below - target <= target - key(ctx, raw)) {
+        if (key_below == key_min) {
+            /* Key is the same from 0 to raw - 1, which the search below cannot find: it needs key(0) > key_below */
+            return 0;
+        }
+        /* raw - 1 is at least as close, find the smallest raw value with the same key */
+        return inverse_find_first_le(key, ctx, key_below, raw - 1);
+    }
+    return raw;
+}
+
+int32_t bmp280_inverse_compensate_temp(const BMP280CalibTemp *const calib_temp, int32_t temperature)
+{
+    return inverse_find_closest(inverse_temp_key, calib_temp, -(int64_t)temperature);
+}
+
+int32_t bmp280_inverse_compensate_pres_with_coeffs(const BMP280PresCoeffs *const coeffs, uint32_t pressure)
+{
+    return inverse_find_closest(inverse_pres_key, coeffs, (int64_t)pressure);
+}
+
+int32_t bmp280_inverse_compensate_pres(const BMP280CalibPres *const calib, uint32_t pressure, int32_t t_fine)
+{
+    BMP280PresCoeffs coeffs;
+    bmp280_compensate_pres_coeffs(calib, t_fine, &coeffs);
+    return bmp280_inverse_compensate_pres_with_coeffs(&coeffs, pressure);
+}
+
+int32_t bmp280_raw_val_from_regs(const uint8_t *const regs)
+{
+    uint32_t t = (((uint32_t)regs[0]) << 12) | (((uint32_t)regs[1]) << 4) | (((uint32_t)(regs[2] & 0xF0)) >> 4);
+    return (int32_t)t;
+}
+
+/** Inverse of @ref bmp280_raw_val_from_regs. */
+static void raw_val_to_regs(int32_t raw, uint8_t *const regs)
+{
+    uint32_t val = (uint32_t)raw;
+    regs[0] = (uint8_t)(val >> 12);
+    regs[1] = (uint8_t)(val >> 4);
+    regs[2] = (uint8_t)((val & 0xFU) << 4);
+}
+
+void bmp280_inverse_compensate_batch(const BMP280CalibTemp *const calib_temp, const BMP280CalibPres *const calib_pres,
+                                     const BMP280Meas *const meas, uint8_t *const frames, size_t num_meas)
+{
+    BMP280PresCoeffs coeffs;
+    int32_t temp_raw = 0;
+    int32_t pres_raw = 0;
+    int32_t t_fine = 0;
+    for (size_t i = 0; i < num_meas; i++) {
+        bool is_first = (i == 0);
+        bool search_pres = is_first || (meas[i].pressure != meas[i - 1].pressure);
+        if (is_first || (meas[i].temperature != meas[i - 1].temperature)) {
+            temp_raw = bmp280_inverse_compensate_temp(calib_temp, meas[i].temperature);
+            int32_t new_t_fine;
+            bmp280_compensate_temp(calib_temp, temp_raw, &new_t_fine);
+            if (is_first || (new_t_fine != t_fine)) {
+                bmp280_compensate_pres_coeffs(calib_pres, new_t_fine, &coeffs);
+                t_fine = new_t_fine;
+                search_pres = true;
+            }
+        }
+        if (search_pres) {
+            pres_raw = bmp280_inverse_compensate_pres_with_coeffs(&coeffs, meas[i].pressure);
+        }
+        raw_val_to_regs(pres_raw, &frames[i * BMP280_RAW_FRAME_SIZE]);
+        raw_val_to_regs(temp_raw, &frames[i * BMP280_RAW_FRAME_SIZE + 3]);
+    }
+}
+
+/**
+ * @brief Whether @ref bmp280_compensate_gather divides in double precision instead of 64-bit integer arithmetic.
+ *
+ * Vector units can divide doubles, but not 64-bit integers. Defaults to 1 when targeting AVX-512DQ, which also converts
+ * between 64-bit integers and doubles in vector registers. Without such conversions, 64-bit integer division is faster
+ * than double division followed by the correction to the exact quotient.
+ */
+#ifndef BMP280_COMPENSATE_GATHER_DIV_DOUBLE
+#if defined(__AVX512DQ__)
+#define BMP280_COMPENSATE_GATHER_DIV_DOUBLE 1
+#else
+#define BMP280_COMPENSATE_GATHER_DIV_DOUBLE 0
+#endif
+#endif
+
+void bmp280_calib_soa_set(const BMP280CalibSoA *const soa, size_t idx, const BMP280CalibTemp *const calib_temp,
+                          const BMP280CalibPres *const calib_pres)
+{
+    const int32_t vals[BMP280_CALIB_SOA_NUM_COEFFS] = {
+        calib_temp->dig_T1, calib_temp->dig_T2, calib_temp->dig_T3, calib_pres->dig_P1,
+        calib_pres->dig_P2, calib_pres->dig_P3, calib_pres->dig_P4, calib_pres->dig_P5,
+        calib_pres->dig_P6, calib_pres->dig_P7, calib_pres->dig_P8, calib_pres->dig_P9,
+    };
+    for (size_t k = 0; k < BMP280_CALIB_SOA_NUM_COEFFS; k++) {
+        soa->coeffs[k * soa->capacity + idx] = vals[k];
+    }
+}
+
+/** Quotients below this magnitude are off by at most 1 when computed in double precision. */
+#define BMP280_DIV_DOUBLE_LIMIT 4503599627370496.0 /* 2^52 */
+
+/**
+ * @brief Compensate BMP280_COMPENSATE_GATHER_LANES samples, one formula step at a time for all of them.
+ *
+ * Same formulas as bmp280_compensate_temp and bmp280_compensate_pres. Every loop has a constant trip count and no
+ * branches, so that the compiler can turn it into vector instructions.
+ */
+static void compensate_gather_group(const BMP280CalibSoA *const soa, const uint32_t *const calib_idx,
+                                    const int32_t *const temp_raw, const int32_t *const pres_raw,
+                                    BMP280Meas *const meas)
+{
+    enum { L = BMP280_COMPENSATE_GATHER_LANES };
+    const int32_t *const c = soa->coeffs;
+    const size_t cap = soa->capacity;
+    int32_t k[BMP280_CALIB_SOA_NUM_COEFFS][L];
+    int32_t t_fine[L];
+    int64_t num[L];
+    int64_t div[L];
+    int64_t p[L];
+    int64_t q[L];
+
+    /* Samples of one tick usually come in sensor order. Then the calibration values of the group are consecutive
+     * elements of each array, and plain vector loads replace gathers. */
+    bool is_run = true;
+    for (size_t l = 1; l < L; l++) {
+        is_run &= (calib_idx[l] == calib_idx[0] + l);
+    }
+    if (is_run) {
+        for (size_t j = 0; j < BMP280_CALIB_SOA_NUM_COEFFS; j++) {
+            const int32_t *const src = &c[j * cap + calib_idx[0]];
+            for (size_t l = 0; l < L; l++) {
+                k[j][l] = src[l];
+            }
+        }
+    } else {
+        for (size_t j = 0; j < BMP280_CALIB_SOA_NUM_COEFFS; j++) {
+            for (size_t l = 0; l < L; l++) {
+                k[j][l] = c[j * cap + calib_idx[l]];
+            }
+        }
+    }
+
+    for (size_t l = 0; l < L; l++) {
+        int32_t raw = temp_raw[l];
+        int32_t var1 = (((raw >> 3) - (k[0][l] << 1)) * k[1][l]) >> 11;
+        int32_t var2 = (((((raw >> 4) - k[0][l]) * ((raw >> 4) - k[0][l])) >> 12) * k[2][l]) >> 14;
+        t_fine[l] = var1 + var2;
+    }
+
+    for (size_t l = 0; l < L; l++) {
+        int64_t var1 = ((int64_t)t_fine[l]) - 128000;
+        int64_t var2 = var1 * var1 * (int64_t)k[8][l];
+        var2 = var2 + ((var1 * (int64_t)k[7][l]) << 17);
+        var2 = var2 + (((int64_t)k[6][l]) << 35);
+        var1 = ((var1 * var1 * (int64_t)k[5][l]) >> 8) + ((var1 * (int64_t)k[4][l]) << 12);
+        var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)k[3][l]) >> 33;
+        int64_t p_raw = 1048576 - pres_raw[l];
+        num[l] = ((p_raw << 31) - var2) * 3125;
+        /* Division by zero is avoided the same way as in bmp280_compensate_pres, the result is replaced with 0 below */
+        div[l] = (var1 == 0) ? 1 : var1;
+        p[l] = (var1 == 0) ? 0 : 1;
+    }
+
+#if BMP280_COMPENSATE_GATHER_DIV_DOUBLE
+    /* The divisor is exact in double precision, because |div| < 2^31. The rounding error of the quotient is below 1 as
+     * long as it is below 2^52 in magnitude, so the truncated quotient is off by at most 1. */
+    bool is_exact[L];
+    for (size_t l = 0; l < L; l++) {
+        double d = (double)num[l] / (double)div[l];
+        is_exact[l] = (d < BMP280_DIV_DOUBLE_LIMIT) & (d > -BMP280_DIV_DOUBLE_LIMIT);
+        q[l] = is_exact[l] ? (int64_t)d : 0;
+    }
+    for (size_t l = 0; l < L; l++) {
+        /* Unsigned, because q * div can overflow when q is off by one. The true remainder is small. */
+        int64_t r = (int64_t)((uint64_t)num[l] - (uint64_t)q[l] * (uint64_t)div[l]);
+        int64_t step = ((num[l] ^ div[l]) < 0) ? -1 : 1;
+        int64_t abs_r = (r < 0) ? -r : r;
+        int64_t abs_div = (div[l] < 0) ? -div[l] : div[l];
+        /* q is one too far from zero if the remainder has the wrong sign, and one too close to zero if it is too
+         * large */
+        int too_far = (r != 0) & ((r ^ num[l]) < 0);
+        int too_close = !too_far & (abs_r >= abs_div);
+        q[l] = q[l] - (too_far ? step : 0) + (too_close ? step : 0);
+    }
+    for (size_t l = 0; l < L; l++) {
+        /* Only calibration values of no real device produce quotients that large */
+        if (!is_exact[l]) {
+            q[l] = num[l] / div[l];
+        }
+    }
+#else
+    for (size_t l = 0; l < L; l++) {
+        q[l] = num[l] / div[l];
+    }
+#endif
+
+    for (size_t l = 0; l < L; l++) {
+        int64_t pr = q[l];
+        int64_t var1 = (((int64_t)k[11][l]) * (pr >> 13) * (pr >> 13)) >> 25;
+        int64_t var2 = (((int64_t)k[10][l]) * pr) >> 19;
+        int64_t result = ((pr + var1 + var2) >> 8) + (((int64_t)k[9][l]) << 4);
+        p[l] = (p[l] == 0) ? 0 : result;
+    }
+
+    for (size_t l = 0; l < L; l++) {
+        meas[l].temperature = (t_fine[l] * 5 + 128) >> 8;
+        meas[l].pressure = (uint32_t)p[l];
+    }
+}
+
+void bmp280_compensate_gather(const BMP280CalibSoA *const soa, const uint32_t *const calib_idx,
+                              const int32_t *const temp_raw, const int32_t *const pres_raw, BMP280Meas *const meas,
+                              size_t num_samples)
+{
+    size_t i = 0;
+    for (; i + BMP280_COMPENSATE_GATHER_LANES <= num_samples; i += BMP280_COMPENSATE_GATHER_LANES) {
+        compensate_gather_group(soa, &calib_idx[i], &temp_raw[i], &pres_raw[i], &meas[i]);
+    }
+    if (i < num_samples) {
+        /* Pad the last group with copies of its first sample */
+        size_t n = num_samples - i;
+        uint32_t idx_pad[BMP280_COMPENSATE_GATHER_LANES];
+        int32_t temp_pad[BMP280_COMPENSATE_GATHER_LANES];
+        int32_t pres_pad[BMP280_COMPENSATE_GATHER_LANES];
+        BMP280Meas meas_pad[BMP280_COMPENSATE_GATHER_LANES];
+        for (size_t l = 0; l < BMP280_COMPENSATE_GATHER_LANES; l++) {
+            size_t src = i + ((l < n) ? l : 0);
+            idx_pad[l] = calib_idx[src];
+            temp_pad[l] = temp_raw[src];
+            pres_pad[l] = pres_raw[src];
+        }
+        compensate_gather_group(soa, idx_pad, temp_pad, pres_pad, meas_pad);
+        for (size_t l = 0; l < n; l++) {
+            meas[i + l] = meas_pad[l];
+        }
+    }
+}
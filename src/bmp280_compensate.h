@@ -0,0 +1,300 @@
+#ifndef SRC_BMP280_COMPENSATE_H
+#define SRC_BMP280_COMPENSATE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "bmp280_defs.h"
+
+/**
+ * @brief Temperature and pressure compensation.
+ *
+ * These are the integer compensation formulas from the datasheet (section 3.11.3). The driver uses them to convert raw
+ * register values into DegC and Pa. They are in a separate module so that tools and tests can use the reference
+ * implementation directly, e.g. to verify that an optimized implementation produces bit-exact results.
+ */
+
+typedef struct {
+    uint16_t dig_T1;
+    int16_t dig_T2;
+    int16_t dig_T3;
+} BMP280CalibTemp;
+
+typedef struct {
+    uint16_t dig_P1;
+    int16_t dig_P2;
+    int16_t dig_P3;
+    int16_t dig_P4;
+    int16_t dig_P5;
+    int16_t dig_P6;
+    int16_t dig_P7;
+    int16_t dig_P8;
+    int16_t dig_P9;
+} BMP280CalibPres;
+
+/**
+ * @brief Pressure compensation coefficients that depend only on the calibration values and t_fine.
+ *
+ * Computed by @ref bmp280_compensate_pres_coeffs. When several raw pressure values need to be compensated with the same
+ * t_fine, computing these once and then calling @ref bmp280_compensate_pres_with_coeffs for every raw value skips
+ * roughly half of the 64-bit multiplications of @ref bmp280_compensate_pres.
+ */
+typedef struct {
+    /** Divisor of the main pressure term. 0 if the calibration values are invalid. */
+    int64_t var1;
+    /** Temperature dependent offset of the main pressure term. */
+    int64_t var2;
+    int16_t dig_P7;
+    int16_t dig_P8;
+    int16_t dig_P9;
+} BMP280PresCoeffs;
+
+/** One precomputed temperature compensation result. */
+typedef struct {
+    /** Temperature in DegC, resolution is 0.01 DegC. */
+    int32_t temperature;
+    /** Fine resolution temperature value, used in pressure compensation. */
+    int32_t t_fine;
+} BMP280TempLutEntry;
+
+/**
+ * @brief Temperature lookup table.
+ *
+ * Holds precomputed temperature compensation results for raw values raw_min, raw_min + (1 << raw_shift), raw_min + 2 *
+ * (1 << raw_shift), ... - num_entries values in total. Raw values outside of that window, or raw values that are not on
+ * the (1 << raw_shift) grid, are compensated by calculation.
+ *
+ * raw_shift is the memory/speed tradeoff knob. With temperature oversampling x1 the device produces 16-bit results, so
+ * the 4 LSb of every raw value are 0. A table with raw_shift 4 then covers 16 times the raw range of a table with
+ * raw_shift 0 in the same memory, and every sample is still looked up. With oversampling x2, x4, x8 and x16 the
+ * resolution is 17, 18, 19 and 20 bit, so raw_shift should be 3, 2, 1 and 0 respectively.
+ */
+typedef struct {
+    /** Table entries. Memory is provided by the user. NULL if the table is not used. */
+    BMP280TempLutEntry *entries;
+    /** Number of elements in entries. */
+    size_t num_entries;
+    /** Raw value of entries[0]. */
+    int32_t raw_min;
+    /** Raw value of entries[i] is raw_min + (i << raw_shift). */
+    uint8_t raw_shift;
+} BMP280TempLut;
+
+/**
+ * @brief Compensate temperature using raw temperature value and temperature calibration values.
+ *
+ * @param[in] calib_temp Temperature calibration values.
+ * @param[in] temp_raw Raw temperature value.
+ * @param[out] t_fine Fine resolution temperature value is written to this parameter, so that it can be used in pressure
+ * compensation calculation.
+ *
+ * @return int32_t Temperature in DegC, resolution is 0.01 DegC. Output value of "5123" equals 51.23 DegC.
+ */
+int32_t bmp280_compensate_temp(const BMP280CalibTemp *const calib_temp, int32_t temp_raw, int32_t *const t_fine);
+
+/**
+ * @brief Compensate pressure using raw pressure value and pressure calibration values.
+ *
+ * @param[in] calib Pressure calibration values.
+ * @param[in] pres_raw Raw pressure value.
+ * @param[in] t_fine Fine resolution temperature value from @ref bmp280_compensate_temp.
+ *
+ * @return uint32_t Pressure in Pa in Q24.8 format (24 integer bits and 8 fractional bits). Output value of "24674867"
+ * represents 24674867/256 = 96386.2 Pa = 963.862 hPa. 0 if the calibration values would cause a division by zero.
+ */
+uint32_t bmp280_compensate_pres(const BMP280CalibPres *const calib, int32_t pres_raw, int32_t t_fine);
+
+/**
+ * @brief Compute pressure compensation coefficients for a given t_fine.
+ *
+ * @param[in] calib Pressure calibration values.
+ * @param[in] t_fine Fine resolution temperature value from @ref bmp280_compensate_temp.
+ * @param[out] coeffs Coefficients are written to this parameter.
+ */
+void bmp280_compensate_pres_coeffs(const BMP280CalibPres *const calib, int32_t t_fine, BMP280PresCoeffs *const coeffs);
+
+/**
+ * @brief Compensate pressure using coefficients from @ref bmp280_compensate_pres_coeffs.
+ *
+ * Produces exactly the same result as @ref bmp280_compensate_pres with the calibration values and t_fine that were
+ * used to compute @p coeffs.
+ *
+ * @param[in] coeffs Pressure compensation coefficients.
+ * @param[in] pres_raw Raw pressure value.
+ *
+ * @return uint32_t Pressure in Pa in Q24.8 format. 0 if the calibration values would cause a division by zero.
+ */
+uint32_t bmp280_compensate_pres_with_coeffs(const BMP280PresCoeffs *const coeffs, int32_t pres_raw);
+
+/**
+ * @brief Fill a temperature lookup table for the given calibration values.
+ *
+ * @param[out] lut Lookup table to build.
+ * @param[in] calib_temp Temperature calibration values.
+ * @param[in] entries Memory for table entries. Must be a buffer of @p num_entries elements.
+ * @param[in] num_entries Number of table entries.
+ * @param[in] raw_min Raw value of the first entry.
+ * @param[in] raw_shift Raw values of consecutive entries are (1 << @p raw_shift) apart.
+ */
+void bmp280_temp_lut_build(BMP280TempLut *const lut, const BMP280CalibTemp *const calib_temp,
+                           BMP280TempLutEntry *const entries, size_t num_entries, int32_t raw_min, uint8_t raw_shift);
+
+/**
+ * @brief Compensate temperature using a lookup table, falling back to calculation if the table does not cover
+ * @p temp_raw.
+ *
+ * Produces exactly the same result as @ref bmp280_compensate_temp, given that @p lut was built with @p calib_temp.
+ *
+ * @param[in] lut Lookup table built by @ref bmp280_temp_lut_build.
+ * @param[in] calib_temp Temperature calibration values. Used if @p temp_raw is not covered by @p lut.
+ * @param[in] temp_raw Raw temperature value.
+ * @param[out] t_fine Fine resolution temperature value is written to this parameter.
+ *
+ * @return int32_t Temperature in DegC, resolution is 0.01 DegC.
+ */
+int32_t bmp280_compensate_temp_lut(const BMP280TempLut *const lut, const BMP280CalibTemp *const calib_temp,
+                                   int32_t temp_raw, int32_t *const t_fine);
+
+/** Number of bytes in one raw measurement frame, the contents of registers 0xF7...0xFC. */
+#define BMP280_RAW_FRAME_SIZE 6
+
+/**
+ * @brief Decode a 20-bit raw value from its measurement registers.
+ *
+ * @param[in] regs Must point to 3 bytes: the values of registers press_msb, press_lsb, press_xlsb or temp_msb,
+ * temp_lsb, temp_xlsb. A raw frame holds the pressure registers at offset 0 and the temperature registers at offset 3.
+ *
+ * @return int32_t Raw value.
+ */
+int32_t bmp280_raw_val_from_regs(const uint8_t *const regs);
+
+/**
+ * @brief Find the raw temperature value that compensates to the temperature closest to @p temperature.
+ *
+ * Inverse of @ref bmp280_compensate_temp. Uses a few secant steps on the integer formula to estimate the raw value,
+ * followed by bisection around the estimate, so the result is exact: there is no raw value that compensates closer to
+ * @p temperature. If several raw values compensate to the closest temperature, the smallest one is returned. If
+ * @p temperature is outside of the range that the calibration values can produce, 0 or 0xFFFFF is returned.
+ *
+ * Assumes that compensated temperature grows monotonically with the raw value, which is true for calibration values of
+ * real devices.
+ *
+ * @param[in] calib_temp Temperature calibration values.
+ * @param[in] temperature Temperature in DegC, resolution is 0.01 DegC.
+ *
+ * @return int32_t Raw temperature value, 20 bits.
+ */
+int32_t bmp280_inverse_compensate_temp(const BMP280CalibTemp *const calib_temp, int32_t temperature);
+
+/**
+ * @brief Find the raw pressure value that compensates to the pressure closest to @p pressure at @p t_fine.
+ *
+ * Inverse of @ref bmp280_compensate_pres, same search and result rules as @ref bmp280_inverse_compensate_temp.
+ * Assumes that compensated pressure decreases monotonically with the raw value, which is true for calibration values of
+ * real devices. Raw values close to 0xFFFFF compensate to negative pressures, so pressures are compared as signed
+ * values.
+ *
+ * @param[in] calib Pressure calibration values.
+ * @param[in] pressure Pressure in Pa in Q24.8 format.
+ * @param[in] t_fine Fine resolution temperature value from @ref bmp280_compensate_temp.
+ *
+ * @return int32_t Raw pressure value, 20 bits.
+ */
+int32_t bmp280_inverse_compensate_pres(const BMP280CalibPres *const calib, uint32_t pressure, int32_t t_fine);
+
+/**
+ * @brief Same as @ref bmp280_inverse_compensate_pres, using coefficients from @ref bmp280_compensate_pres_coeffs.
+ *
+ * @param[in] coeffs Pressure compensation coefficients.
+ * @param[in] pressure Pressure in Pa in Q24.8 format.
+ *
+ * @return int32_t Raw pressure value, 20 bits.
+ */
+int32_t bmp280_inverse_compensate_pres_with_coeffs(const BMP280PresCoeffs *const coeffs, uint32_t pressure);
+
+/**
+ * @brief Generate raw register frames for a batch of measurements.
+ *
+ * For every element of @p meas, finds the raw temperature value with @ref bmp280_inverse_compensate_temp, and then the
+ * raw pressure value with @ref bmp280_inverse_compensate_pres at the t_fine of that raw temperature value. The result
+ * is written as BMP280_RAW_FRAME_SIZE bytes in the layout of registers 0xF7...0xFC: press_msb, press_lsb, press_xlsb,
+ * temp_msb, temp_lsb, temp_xlsb. Compensating a frame gives back the closest measurement that the device can produce.
+ *
+ * Pressure coefficients are reused for consecutive elements with the same t_fine, and raw values are reused for
+ * consecutive elements with the same target values, so slowly changing series are cheaper than random ones.
+ *
+ * @param[in] calib_temp Temperature calibration values.
+ * @param[in] calib_pres Pressure calibration values.
+ * @param[in] meas Target measurements.
+ * @param[out] frames Frames are written to this parameter. Must be a buffer of @p num_meas * BMP280_RAW_FRAME_SIZE
+ * bytes.
+ * @param[in] num_meas Number of elements in @p meas.
+ */
+void bmp280_inverse_compensate_batch(const BMP280CalibTemp *const calib_temp, const BMP280CalibPres *const calib_pres,
+                                     const BMP280Meas *const meas, uint8_t *const frames, size_t num_meas);
+
+/** Number of calibration values per sensor in a @ref BMP280CalibSoA: dig_T1...dig_T3 and dig_P1...dig_P9. */
+#define BMP280_CALIB_SOA_NUM_COEFFS 12
+
+/** Number of samples that @ref bmp280_compensate_gather processes side by side. */
+#define BMP280_COMPENSATE_GATHER_LANES 32
+
+/**
+ * @brief Calibration values of many sensors, transposed into one array per calibration value.
+ *
+ * Calibration value k of sensor i is coeffs[k * capacity + i], in the order dig_T1, dig_T2, dig_T3, dig_P1, ...
+ * dig_P9, widened to 32 bits. The layout is the same in every build. Memory is provided by the user: a buffer of
+ * BMP280_CALIB_SOA_NUM_COEFFS * capacity elements.
+ */
+typedef struct {
+    int32_t *coeffs;
+    size_t capacity;
+} BMP280CalibSoA;
+
+/**
+ * @brief Store the calibration values of sensor @p idx.
+ *
+ * @param[in] soa Transposed calibration values.
+ * @param[in] idx Sensor index, less than capacity of @p soa.
+ * @param[in] calib_temp Temperature calibration values of the sensor.
+ * @param[in] calib_pres Pressure calibration values of the sensor.
+ */
+void bmp280_calib_soa_set(const BMP280CalibSoA *const soa, size_t idx, const BMP280CalibTemp *const calib_temp,
+                          const BMP280CalibPres *const calib_pres);
+
+/**
+ * @brief Compensate one sample of each of many sensors with different calibration values.
+ *
+ * Sample i is compensated with the calibration values of sensor @p calib_idx[i]. Produces exactly the same results as
+ * @ref bmp280_compensate_temp followed by @ref bmp280_compensate_pres.
+ *
+ * Samples are processed in groups of BMP280_COMPENSATE_GATHER_LANES, one formula step at a time for the whole group,
+ * in portable loops without branches. A group of consecutive sensor indexes, the usual order of one tick, loads
+ * calibration values with plain vector loads instead of gathers. The pressure formula needs 64-bit multiplications in
+ * vector registers, so the compiler only vectorizes the group loops when targeting AVX2 or newer. With AVX-512DQ, the
+ * 64-bit division is done in double precision across the group and then corrected to the exact integer quotient, see
+ * BMP280_COMPENSATE_GATHER_DIV_DOUBLE in bmp280_compensate.c, and the kernel is faster than calling @ref
+ * bmp280_compensate_temp and @ref bmp280_compensate_pres per sample. With AVX2 alone, and on other targets where the
+ * loops run as scalar code, it is about 0.8 times as fast as them.
+ *
+ * @param[in] soa Transposed calibration values.
+ * @param[in] calib_idx Sensor index of each sample.
+ * @param[in] temp_raw Raw temperature values.
+ * @param[in] pres_raw Raw pressure values.
+ * @param[out] meas Results.
+ * @param[in] num_samples Number of elements in @p calib_idx, @p temp_raw, @p pres_raw and @p meas.
+ */
+void bmp280_compensate_gather(const BMP280CalibSoA *const soa, const uint32_t *const calib_idx,
+                              const int32_t *const temp_raw, const int32_t *const pres_raw, BMP280Meas *const meas,
+                              size_t num_samples);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_BMP280_COMPENSATE_H */
@@ -0,0 +1,235 @@
+#ifndef SRC_BMP280_COMPENSATE_CONSTEXPR_H
+#define SRC_BMP280_COMPENSATE_CONSTEXPR_H
+
+#ifndef __cplusplus
+#error "bmp280_compensate_constexpr.h is a C++ header"
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bmp280_compensate.h"
+
+/**
+ * @brief Compile-time temperature and pressure compensation.
+ *
+ * constexpr versions of @ref bmp280_compensate_temp and @ref bmp280_compensate_pres, bit-exact with the C
+ * implementation. They are meant for test fixtures, simulators and HIL rigs that work with calibration sets which are
+ * known at compile time: expected values and raw values for a target temperature or pressure can be generated by the
+ * compiler instead of at runtime.
+ *
+ * Requires C++14. Every function is a template parameterized on a calibration type. A calibration type is any type with
+ * static constexpr integer members dig_T1...dig_T3 and dig_P1...dig_P9, with the same types as the members of
+ * BMP280CalibTemp and BMP280CalibPres. @ref bmp280::DatasheetCalib is an example.
+ *
+ * Left shifts of values that can be negative are written as multiplications by a power of 2. Left shift of a negative
+ * value is undefined before C++20 and therefore not allowed in constant expressions, multiplication gives the same
+ * result. Right shifts are kept as they are, because they are arithmetic shifts on every supported compiler, same as in
+ * the C implementation. Inputs for which the C implementation overflows fail to compile when evaluated at compile time.
+ */
+
+namespace bmp280
+{
+
+/** Example calibration values from the datasheet p. 23. */
+struct DatasheetCalib {
+    static constexpr uint16_t dig_T1 = 27504;
+    static constexpr int16_t dig_T2 = 26435;
+    static constexpr int16_t dig_T3 = -1000;
+    static constexpr uint16_t dig_P1 = 36477;
+    static constexpr int16_t dig_P2 = -10685;
+    static constexpr int16_t dig_P3 = 3024;
+    static constexpr int16_t dig_P4 = 2855;
+    static constexpr int16_t dig_P5 = 140;
+    static constexpr int16_t dig_P6 = -7;
+    static constexpr int16_t dig_P7 = 15500;
+    static constexpr int16_t dig_P8 = -14600;
+    static constexpr int16_t dig_P9 = 6000;
+};
+
+/** Smallest and largest 20-bit raw value. */
+constexpr int32_t raw_min = 0;
+constexpr int32_t raw_max = 0xFFFFF;
+
+/** Result of temperature compensation. */
+struct TempResult {
+    /** Temperature in DegC, resolution is 0.01 DegC. */
+    int32_t temperature;
+    /** Fine resolution temperature value, used in pressure compensation. */
+    int32_t t_fine;
+};
+
+/**
+ * @brief Temperature calibration values of @p Calib as a BMP280CalibTemp, e.g. to pass them to the C implementation.
+ */
+template <typename Calib> constexpr BMP280CalibTemp calib_temp()
+{
+    return BMP280CalibTemp{Calib::dig_T1, Calib::dig_T2, Calib::dig_T3};
+}
+
+/**
+ * @brief Pressure calibration values of @p Calib as a BMP280CalibPres, e.g. to pass them to the C implementation.
+ */
+template <typename Calib> constexpr BMP280CalibPres calib_pres()
+{
+    return BMP280CalibPres{Calib::dig_P1, Calib::dig_P2, Calib::dig_P3, Calib::dig_P4, Calib::dig_P5,
+                     Calib::dig_P6, Calib::dig_P7, Calib::dig_P8, Calib::dig_P9};
+}
+
+/**
+ * @brief Compensate temperature. Same as @ref bmp280_compensate_temp.
+ *
+ * @param[in] temp_raw Raw temperature value.
+ *
+ * @return TempResult Temperature and t_fine.
+ */
+template <typename Calib> constexpr TempResult compensate_temp(int32_t temp_raw)
+{
+    int32_t dig_T1 = Calib::dig_T1;
+    int32_t dig_T2 = Calib::dig_T2;
+    int32_t dig_T3 = Calib::dig_T3;
+
+    int32_t var1 = (((temp_raw >> 3) - dig_T1 * 2) * dig_T2) >> 11;
+    int32_t var2 = ((((temp_raw >> 4) - dig_T1) * ((temp_raw >> 4) - dig_T1)) >> 12) * dig_T3 >> 14;
+    int32_t t_fine = var1 + var2;
+    return TempResult{(t_fine * 5 + 128) >> 8, t_fine};
+}
+
+/**
+ * @brief Compensate pressure. Same as @ref bmp280_compensate_pres.
+ *
+ * @param[in] pres_raw Raw pressure value.
+ * @param[in] t_fine Fine resolution temperature value from @ref compensate_temp.
+ *
+ * @return uint32_t Pressure in Pa in Q24.8 format, or 0 if the calibration values are invalid.
+ */
+template <typename Calib> constexpr uint32_t compensate_pres(int32_t pres_raw, int32_t t_fine)
+{
+    int64_t var1 = ((int64_t)t_fine) - 128000;
+    int64_t var2 = var1 * var1 * (int64_t)Calib::dig_P6;
+    var2 = var2 + var1 * (int64_t)Calib::dig_P5 * (((int64_t)1) << 17);
+    var2 = var2 + ((int64_t)Calib::dig_P4) * (((int64_t)1) << 35);
+    var1 = ((var1 * var1 * (int64_t)Calib::dig_P3) >> 8) + var1 * (int64_t)Calib::dig_P2 * (((int64_t)1) << 12);
+    var1 = ((((int64_t)1) << 47) + var1) * ((int64_t)Calib::dig_P1) >> 33;
+    if (var1 == 0) {
+        return 0;
+    }
+    int64_t p = 1048576 - pres_raw;
+    p = ((p * (((int64_t)1) << 31) - var2) * 3125) / var1;
+    var1 = (((int64_t)Calib::dig_P9) * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (((int64_t)Calib::dig_P8) * p) >> 19;
+    p = ((p + var1 + var2) >> 8) + ((int64_t)Calib::dig_P7) * 16;
+    return (uint32_t)p;
+}
+
+/**
+ * @brief Find the raw temperature value that compensates to the temperature closest to @p temperature.
+ *
+ * Compensated temperature grows monotonically with the raw value for calibration sets of real devices, so the raw
+ * value is found by bisection over the 20-bit raw range. If several raw values compensate to the same temperature, the
+ * smallest one is returned.
+ *
+ * @param[in] temperature Temperature in DegC, resolution is 0.01 DegC.
+ *
+ * @return int32_t Raw temperature value.
+ */
+template <typename Calib> constexpr int32_t temp_to_raw(int32_t temperature)
+{
+    /* Smallest raw value that compensates to at least temperature */
+    int32_t lo = raw_min;
+    int32_t hi = raw_max;
+    while (lo < hi) {
+        int32_t mid = lo + (hi - lo) / 2;
+        if (compensate_temp<Calib>(mid).temperature < temperature) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    int32_t above = compensate_temp<Calib>(lo).temperature;
+    /* If even raw_max compensates to less than temperature, raw_max is the closest raw value */
+    if ((lo > raw_min) && (above >= temperature)) {
+        int32_t below = compensate_temp<Calib>(lo - 1).temperature;
+        if (temperature - below <= above - temperature) {
+            /* Smallest raw value that compensates to the same temperature as lo - 1 */
+            return temp_to_raw<Calib>(below);
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief Find the raw pressure value that compensates to the pressure closest to @p pressure at @p t_fine.
+ *
+ * Compensated pressure decreases monotonically with the raw value for calibration sets of real devices, so the raw
+ * value is found by bisection over the 20-bit raw range. If several raw values compensate to the same pressure, the
+ * smallest one is returned. Raw values close to raw_max compensate to negative pressures, results are compared as
+ * signed values.
+ *
+ * @param[in] pressure Pressure in Pa in Q24.8 format.
+ * @param[in] t_fine Fine resolution temperature value from @ref compensate_temp.
+ *
+ * @return int32_t Raw pressure value.
+ */
+template <typename Calib> constexpr int32_t pres_to_raw(uint32_t pressure, int32_t t_fine)
+{
+    /* Raw values close to raw_max produce negative pressures that wrap around to large uint32_t values, so results are
+     * compared as signed values */
+    int64_t target = pressure;
+    /* Smallest raw value that compensates to at most pressure */
+    int32_t lo = raw_min;
+    int32_t hi = raw_max;
+    while (lo < hi) {
+        int32_t mid = lo + (hi - lo) / 2;
+        if ((int32_t)compensate_pres<Calib>(mid, t_fine) > target) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    int64_t above = (int32_t)compensate_pres<Calib>(lo, t_fine);
+    /* If even raw_max compensates to more than pressure, raw_max is the closest raw value */
+    if ((lo > raw_min) && (above <= target)) {
+        int64_t below = (int32_t)compensate_pres<Calib>(lo - 1, t_fine);
+        if (below - target <= target - above) {
+            /* Smallest raw value that compensates to the same pressure as lo - 1 */
+            return pres_to_raw<Calib>((uint32_t)below, t_fine);
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief Table of expected compensation results for @p N raw values.
+ *
+ * Built at compile time by @ref make_meas_table.
+ */
+template <size_t N> struct MeasTable {
+    int32_t temp_raw[N];
+    int32_t pres_raw[N];
+    int32_t temperature[N];
+    uint32_t pressure[N];
+};
+
+/**
+ * @brief Build a table of expected results for raw values temp_raw_first + i * temp_raw_step and pres_raw_first + i *
+ * pres_raw_step, i = 0...N - 1.
+ */
+template <typename Calib, size_t N>
+constexpr MeasTable<N> make_meas_table(int32_t temp_raw_first, int32_t temp_raw_step, int32_t pres_raw_first,
+                                       int32_t pres_raw_step)
+{
+    MeasTable<N> table{};
+    for (size_t i = 0; i < N; i++) {
+        table.temp_raw[i] = temp_raw_first + (int32_t)i * temp_raw_step;
+        table.pres_raw[i] = pres_raw_first + (int32_t)i * pres_raw_step;
+        TempResult temp = compensate_temp<Calib>(table.temp_raw[i]);
+        table.temperature[i] = temp.temperature;
+        table.pressure[i] = compensate_pres<Calib>(table.pres_raw[i], temp.t_fine);
+    }
+    return table;
+}
+
+} // namespace bmp280
+
+#endif /* SRC_BMP280_COMPENSATE_CONSTEXPR_H */
@@ -0,0 +1,97 @@
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "bmp280_cq.h"
+
+uint8_t bmp280_cq_init(BMP280CompletionRing *const ring, BMP280Completion *const entries, size_t capacity)
+{
+    /* Power of 2, so that free running indexes can be masked and wrap around correctly */
+    bool is_power_of_2 = (capacity != 0) && ((capacity & (capacity - 1)) == 0);
+    if (!ring || !entries || !is_power_of_2) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    ring->entries = entries;
+    ring->capacity = capacity;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->num_dropped = 0;
+    return BMP280_RESULT_CODE_OK;
+}
+
+void *bmp280_cq_slot_prepare(BMP280CQSlot *const slot, BMP280CompletionRing *const ring, uint64_t tag)
+{
+    /* The operation in progress, if any, keeps its tag until the driver accepts the new one */
+    slot->prepared = true;
+    slot->next_ring = ring;
+    slot->next_tag = tag;
+    return (void *)slot;
+}
+
+static void accept_staged(BMP280CQSlot *const slot)
+{
+    slot->prepared = false;
+    slot->ring = slot->next_ring;
+    slot->tag = slot->next_tag;
+}
+
+uint8_t bmp280_cq_slot_submitted(BMP280CQSlot *const slot, uint8_t rc)
+{
+    /* Unless it already completed from within the driver function */
+    if ((rc == BMP280_RESULT_CODE_OK) && slot->prepared) {
+        accept_staged(slot);
+    }
+    slot->prepared = false;
+    return rc;
+}
+
+void bmp280_cq_complete_cb(uint8_t rc, void *user_data)
+{
+    BMP280CQSlot *slot = (BMP280CQSlot *)user_data;
+    if (slot->prepared) {
+        /* Completed before the driver function returned */
+        accept_staged(slot);
+    }
+    BMP280CompletionRing *ring = slot->ring;
+    if (ring->tail - ring->head == ring->capacity) {
+        ring->num_dropped++;
+        return;
+    }
+
+    BMP280Completion *completion = &ring->entries[ring->tail & (ring->capacity - 1)];
+    completion->tag = slot->tag;
+    completion->meas = slot->meas;
+    completion->rc = rc;
+    ring->tail++;
+}
+
+uint8_t bmp280_cq_read_meas_forced_mode(BMP280 self, BMP280CQSlot *const slot, BMP280CompletionRing *const ring,
+                                        uint64_t tag, uint8_t meas_type, uint32_t meas_time_ms)
+{
+    if (!slot || !ring) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    void *user_data = bmp280_cq_slot_prepare(slot, ring, tag);
+    return bmp280_cq_slot_submitted(slot, bmp280_read_meas_forced_mode(self, meas_type, meas_time_ms, &slot->meas,
+                                                                       bmp280_cq_complete_cb, user_data));
+}
+
+size_t bmp280_cq_peek(const BMP280CompletionRing *const ring, const BMP280Completion **const completions)
+{
+    size_t num_pending = ring->tail - ring->head;
+    size_t head_idx = ring->head & (ring->capacity - 1);
+    size_t num_until_end = ring->capacity - head_idx;
+    *completions = &ring->entries[head_idx];
+    return (num_pending < num_until_end) ? num_pending : num_until_end;
+}
+
+void bmp280_cq_advance(BMP280CompletionRing *const ring, size_t num)
+{
+    ring->head += num;
+}
+
+size_t bmp280_cq_num_pending(const BMP280CompletionRing *const ring)
+{
+    return ring->tail - ring->head;
+}
@@ -0,0 +1,158 @@
+#ifndef SRC_BMP280_CQ_H
+#define SRC_BMP280_CQ_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "bmp280.h"
+
+/**
+ * @brief Completion queue submission model.
+ *
+ * An alternative to handling every operation in its own complete callback. Operations carry a 64-bit tag, and their
+ * completions (tag, rc, measurement) are appended to a user-provided completion ring. The application reaps the ring
+ * in batches, e.g. once per event loop tick, and processes completions of many sensors in a tight loop over contiguous
+ * memory instead of running its own code from inside every IO completion.
+ *
+ * Every BMP280 instance that submits operations through the completion queue needs a @ref BMP280CQSlot. The slot holds
+ * the tag and the measurement of the operation in progress. A BMP280 instance never has more than one operation in
+ * progress, so one slot per instance is enough. Several instances can share one ring.
+ *
+ * Any driver operation can be submitted this way: pass @ref bmp280_cq_complete_cb as its complete callback, the slot
+ * returned by @ref bmp280_cq_slot_prepare as its user data, and the return code of the driver function to @ref
+ * bmp280_cq_slot_submitted. @ref bmp280_cq_read_meas_forced_mode does all of that for forced mode measurements.
+ * Continuous forced mode appends one completion per sample, all with the same tag.
+ *
+ * The driver rejects a new operation with BUSY while another one is in progress, which then keeps its tag and ring: a
+ * new tag is only staged by @ref bmp280_cq_slot_prepare, and is used once the driver accepts the operation.
+ *
+ * The ring is used from the same execution context as all BMP280 driver functions and callbacks, so it does not need
+ * any synchronization.
+ */
+
+/** One completed operation. */
+typedef struct {
+    /** Tag of the operation, as passed to @ref bmp280_cq_slot_prepare. */
+    uint64_t tag;
+    /** Measurement result. Only valid for successful measurement operations. */
+    BMP280Meas meas;
+    /** Result code of the operation, one of @ref BMP280ResultCode. */
+    uint8_t rc;
+} BMP280Completion;
+
+/**
+ * @brief Ring of completions.
+ *
+ * Memory is provided by the user. Fields are private, use the functions of this module to access them.
+ */
+typedef struct {
+    BMP280Completion *entries;
+    /** Number of entries, power of 2. */
+    size_t capacity;
+    /** Free running index of the oldest unreaped completion. */
+    size_t head;
+    /** Free running index of the next completion to append. */
+    size_t tail;
+    /** Number of completions that were dropped because the ring was full. */
+    uint32_t num_dropped;
+} BMP280CompletionRing;
+
+/** Per-instance state of the operation in progress. Memory is provided by the user. */
+typedef struct {
+    BMP280CompletionRing *ring;
+    uint64_t tag;
+    /** Measurement buffer of the operation. Measurement operations must write to it, so that the result is copied to
+     * the completion. @ref bmp280_cq_read_meas_forced_mode does that. */
+    BMP280Meas meas;
+    /** Whether the last @ref bmp280_cq_slot_prepare call staged a tag that the driver has not accepted yet. */
+    bool prepared;
+    BMP280CompletionRing *next_ring;
+    uint64_t next_tag;
+} BMP280CQSlot;
+
+/**
+ * @brief Initialize a completion ring.
+ *
+ * @param[out] ring Ring to initialize.
+ * @param[in] entries Memory for @p capacity completions.
+ * @param[in] capacity Number of entries. Must be a power of 2. Should be at least the number of operations that can
+ * complete between two reaps, otherwise completions are dropped.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully initialized the ring.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p ring or @p entries is NULL, or @p capacity is not a power of 2.
+ */
+uint8_t bmp280_cq_init(BMP280CompletionRing *const ring, BMP280Completion *const entries, size_t capacity);
+
+/**
+ * @brief Stage the ring and tag of the next operation of an instance, which is about to be submitted.
+ *
+ * @param[out] slot Slot of the instance that the operation is submitted to.
+ * @param[in] ring Ring to append the completion to.
+ * @param[in] tag Tag of the operation.
+ *
+ * @return void* @p slot, to pass as user data together with @ref bmp280_cq_complete_cb.
+ */
+void *bmp280_cq_slot_prepare(BMP280CQSlot *const slot, BMP280CompletionRing *const ring, uint64_t tag);
+
+/**
+ * @brief Use the staged ring and tag if the driver accepted the operation, otherwise drop them.
+ *
+ * @param[in] slot Slot passed to @ref bmp280_cq_slot_prepare.
+ * @param[in] rc Return code of the driver function that the operation was submitted with.
+ *
+ * @return uint8_t @p rc.
+ */
+uint8_t bmp280_cq_slot_submitted(BMP280CQSlot *const slot, uint8_t rc);
+
+/**
+ * @brief Complete callback that appends a completion to the ring of the slot. user_data must point to a @ref
+ * BMP280CQSlot prepared with @ref bmp280_cq_slot_prepare.
+ */
+void bmp280_cq_complete_cb(uint8_t rc, void *user_data);
+
+/**
+ * @brief Submit a forced mode measurement. Its completion is appended to @p ring.
+ *
+ * Parameters and return values other than @p slot, @p ring and @p tag are the same as for @ref
+ * bmp280_read_meas_forced_mode. The measurement is written to slot->meas and copied to the completion.
+ */
+uint8_t bmp280_cq_read_meas_forced_mode(BMP280 self, BMP280CQSlot *const slot, BMP280CompletionRing *const ring,
+                                        uint64_t tag, uint8_t meas_type, uint32_t meas_time_ms);
+
+/**
+ * @brief Get the oldest unreaped completions.
+ *
+ * Returns completions that are contiguous in memory, starting with the oldest one. If the unreaped completions wrap
+ * around the end of the ring, call this function again after @ref bmp280_cq_advance to get the rest.
+ *
+ * @param[in] ring Ring.
+ * @param[out] completions Pointer to the oldest unreaped completion is written to this parameter.
+ *
+ * @return size_t Number of contiguous completions at @p completions. 0 if the ring is empty.
+ */
+size_t bmp280_cq_peek(const BMP280CompletionRing *const ring, const BMP280Completion **const completions);
+
+/**
+ * @brief Mark the oldest @p num completions as reaped, making room for new ones.
+ *
+ * @param[in] ring Ring.
+ * @param[in] num Number of completions to reap. Must not be greater than the number of unreaped completions.
+ */
+void bmp280_cq_advance(BMP280CompletionRing *const ring, size_t num);
+
+/**
+ * @brief Number of unreaped completions.
+ */
+size_t bmp280_cq_num_pending(const BMP280CompletionRing *const ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_BMP280_CQ_H */
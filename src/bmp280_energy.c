@@ -0,0 +1,252 @@
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "bmp280_energy.h"
+
+#define BMP280_ENERGY_RESET_REG_ADDR 0xE0
+#define BMP280_ENERGY_CTRL_MEAS_REG_ADDR 0xF4
+#define BMP280_ENERGY_CONFIG_REG_ADDR 0xF5
+#define BMP280_ENERGY_RESET_REG_VALUE 0xB6
+
+/* ctrl_meas mode field values */
+#define BMP280_ENERGY_MODE_SLEEP 0x00
+#define BMP280_ENERGY_MODE_NORMAL 0x03
+
+/* Number of data bytes of the data register read of a forced mode measurement */
+#define BMP280_ENERGY_TEMP_DATA_BYTES 3
+#define BMP280_ENERGY_TEMP_AND_PRES_DATA_BYTES 6
+
+/* Standby time of normal mode for every config t_sb value, datasheet table 11 */
+static const uint32_t standby_times_us[8] = {
+    500, 62500, 125000, 250000, 500000, 1000000, 2000000, 4000000,
+};
+
+/** Oversampling factor of an osrs_t or osrs_p field value. Values above 16x are 16x, as in the sensor. */
+static uint32_t oversampling_factor(uint8_t oversampling)
+{
+    if (oversampling == BMP280_OVERSAMPLING_SKIPPED) {
+        return 0;
+    }
+    if (oversampling > BMP280_OVERSAMPLING_16) {
+        oversampling = BMP280_OVERSAMPLING_16;
+    }
+    return 1U << (oversampling - 1);
+}
+
+static uint32_t temp_phase_us(uint8_t temp_oversampling)
+{
+    return 1000 + 2000 * oversampling_factor(temp_oversampling);
+}
+
+static uint32_t pres_phase_us(uint8_t pres_oversampling)
+{
+    uint32_t factor = oversampling_factor(pres_oversampling);
+    return factor ? (2000 * factor + 500) : 0;
+}
+
+uint64_t bmp280_energy_conversion_fc(const BMP280EnergyCurrents *const currents, uint8_t temp_oversampling,
+                                     uint8_t pres_oversampling)
+{
+    return (uint64_t)temp_phase_us(temp_oversampling) * currents->temp_meas_na +
+           (uint64_t)pres_phase_us(pres_oversampling) * currents->pres_meas_na;
+}
+
+uint8_t bmp280_energy_init(BMP280Energy *const energy, const BMP280EnergyCfg *const cfg)
+{
+    if (!energy || !cfg || !cfg->now_us || !cfg->read_regs || !cfg->write_reg) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    memset(energy, 0, sizeof(*energy));
+    energy->cfg = *cfg;
+    energy->mode = BMP280_ENERGY_MODE_SLEEP;
+    energy->last_update_us = cfg->now_us(cfg->now_us_user_data);
+    return BMP280_RESULT_CODE_OK;
+}
+
+static uint32_t now_us(const BMP280Energy *const energy)
+{
+    return energy->cfg.now_us(energy->cfg.now_us_user_data);
+}
+
+/** Add the charge of @p elapsed_us in normal mode: whole measurement cycles, then a share of a partial cycle. */
+static void accrue_normal_mode(BMP280Energy *const energy, uint32_t elapsed_us)
+{
+    uint64_t meas_fc = bmp280_energy_conversion_fc(&energy->cfg.currents, energy->osrs_t, energy->osrs_p);
+    uint32_t standby_us = standby_times_us[energy->t_sb];
+    uint64_t standby_fc = (uint64_t)standby_us * energy->cfg.currents.standby_na;
+    uint32_t cycle_us = temp_phase_us(energy->osrs_t) + pres_phase_us(energy->osrs_p) + standby_us;
+
+    uint32_t num_cycles = elapsed_us / cycle_us;
+    uint32_t partial_us = elapsed_us % cycle_us;
+    /* A partial cycle is at most 4 s, so the product fits */
+    uint64_t partial_meas_fc = meas_fc * partial_us / cycle_us;
+    uint64_t partial_standby_fc = standby_fc * partial_us / cycle_us;
+    energy->counters.conversion_fc += num_cycles * meas_fc + partial_meas_fc;
+    energy->counters.idle_fc += num_cycles * standby_fc + partial_standby_fc;
+}
+
+void bmp280_energy_update(BMP280Energy *const energy)
+{
+    uint32_t now = now_us(energy);
+    uint32_t elapsed_us = now - energy->last_update_us;
+    energy->last_update_us = now;
+
+    if (energy->mode == BMP280_ENERGY_MODE_NORMAL) {
+        accrue_normal_mode(energy, elapsed_us);
+    } else {
+        /* Also during forced mode conversions, where it is below 0.1 % of the conversion current */
+        energy->counters.idle_fc += (uint64_t)elapsed_us * energy->cfg.currents.sleep_na;
+    }
+}
+
+uint64_t bmp280_energy_total_fc(BMP280Energy *const energy)
+{
+    bmp280_energy_update(energy);
+    return energy->counters.conversion_fc + energy->counters.idle_fc + energy->counters.bus_fc;
+}
+
+/** Apply the effect of a successful register write on the sensor power mode. */
+static void apply_write(BMP280Energy *const energy, uint8_t addr, uint8_t val)
+{
+    if (addr == BMP280_ENERGY_CTRL_MEAS_REG_ADDR) {
+        energy->osrs_t = (uint8_t)(val >> 5);
+        energy->osrs_p = (uint8_t)((val >> 2) & 0x07);
+        energy->mode = (uint8_t)(val & 0x03);
+        if ((energy->mode != BMP280_ENERGY_MODE_SLEEP) && (energy->mode != BMP280_ENERGY_MODE_NORMAL)) {
+            /* The sensor returns to sleep mode once the forced mode conversion is done */
+            energy->counters.conversion_fc +=
+                bmp280_energy_conversion_fc(&energy->cfg.currents, energy->osrs_t, energy->osrs_p);
+            energy->counters.num_conversions++;
+            energy->mode = BMP280_ENERGY_MODE_SLEEP;
+        }
+    } else if (addr == BMP280_ENERGY_CONFIG_REG_ADDR) {
+        energy->t_sb = (uint8_t)(val >> 5);
+    } else if ((addr == BMP280_ENERGY_RESET_REG_ADDR) && (val == BMP280_ENERGY_RESET_REG_VALUE)) {
+        energy->mode = BMP280_ENERGY_MODE_SLEEP;
+        energy->osrs_t = BMP280_OVERSAMPLING_SKIPPED;
+        energy->osrs_p = BMP280_OVERSAMPLING_SKIPPED;
+        energy->t_sb = 0;
+    }
+}
+
+static void io_complete_cb(uint8_t io_rc, void *user_data)
+{
+    BMP280Energy *energy = (BMP280Energy *)user_data;
+    /* Charge up to now belongs to the previous mode */
+    bmp280_energy_update(energy);
+    /* The bus is used whether the transaction succeeds or not */
+    energy->counters.bus_fc += energy->cfg.bus_transaction_fc;
+    energy->counters.bus_fc += (uint64_t)energy->io_bytes * energy->cfg.bus_byte_fc;
+    if (energy->io_is_write && (io_rc == BMP280_IO_RESULT_CODE_OK)) {
+        apply_write(energy, energy->io_addr, energy->io_val);
+    }
+
+    energy->io_cb(io_rc, energy->io_cb_user_data);
+}
+
+void bmp280_energy_read_regs(uint8_t start_addr, size_t num_regs, uint8_t *data, void *user_data,
+                             BMP280_IOCompleteCb cb, void *cb_user_data)
+{
+    BMP280Energy *energy = (BMP280Energy *)user_data;
+    energy->io_cb = cb;
+    energy->io_cb_user_data = cb_user_data;
+    energy->io_bytes = num_regs;
+    energy->io_is_write = false;
+    energy->cfg.read_regs(start_addr, num_regs, data, energy->cfg.read_regs_user_data, io_complete_cb,
+                          (void *)energy);
+}
+
+void bmp280_energy_write_reg(uint8_t addr, uint8_t reg_val, void *user_data, BMP280_IOCompleteCb cb,
+                             void *cb_user_data)
+{
+    BMP280Energy *energy = (BMP280Energy *)user_data;
+    energy->io_cb = cb;
+    energy->io_cb_user_data = cb_user_data;
+    energy->io_bytes = 1;
+    energy->io_is_write = true;
+    energy->io_addr = addr;
+    energy->io_val = reg_val;
+    energy->cfg.write_reg(addr, reg_val, energy->cfg.write_reg_user_data, io_complete_cb, (void *)energy);
+}
+
+static void *op_prepare(BMP280Energy *const energy, BMP280CompleteCb cb, void *user_data, bool continuous)
+{
+    bmp280_op_track_prepare(&energy->op, cb, user_data, continuous, bmp280_energy_total_fc(energy));
+    return (void *)energy;
+}
+
+void *bmp280_energy_op_prepare(BMP280Energy *const energy, BMP280CompleteCb cb, void *user_data)
+{
+    return op_prepare(energy, cb, user_data, false);
+}
+
+uint8_t bmp280_energy_op_submitted(BMP280Energy *const energy, uint8_t rc)
+{
+    bmp280_op_track_submitted(&energy->op, rc);
+    return rc;
+}
+
+void bmp280_energy_complete_cb(uint8_t rc, void *user_data)
+{
+    BMP280Energy *energy = (BMP280Energy *)user_data;
+    uint64_t total_fc = bmp280_energy_total_fc(energy);
+    energy->counters.last_op_fc = total_fc - bmp280_op_track_complete(&energy->op, rc, total_fc);
+    bmp280_op_track_execute_cb(&energy->op, rc);
+}
+
+uint8_t bmp280_energy_read_meas_forced_mode(BMP280 self, BMP280Energy *const energy, uint8_t temp_oversampling,
+                                            uint8_t pres_oversampling, BMP280Meas *const meas, BMP280CompleteCb cb,
+                                            void *user_data)
+{
+    if (!energy) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    void *energy_user_data = bmp280_energy_op_prepare(energy, cb, user_data);
+    return bmp280_energy_op_submitted(
+        energy, bmp280_read_meas_forced_mode_with_oversampling(self, temp_oversampling, pres_oversampling, meas,
+                                                               bmp280_energy_complete_cb, energy_user_data));
+}
+
+uint8_t bmp280_energy_start_continuous_forced_mode(BMP280 self, BMP280Energy *const energy, uint8_t meas_type,
+                                                   uint32_t meas_time_ms, BMP280Meas *const meas, BMP280CompleteCb cb,
+                                                   void *user_data)
+{
+    if (!energy) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    void *energy_user_data = op_prepare(energy, cb, user_data, true);
+    return bmp280_energy_op_submitted(energy, bmp280_start_continuous_forced_mode(self, meas_type, meas_time_ms, meas,
+                                                                                  bmp280_energy_complete_cb,
+                                                                                  energy_user_data));
+}
+
+uint8_t bmp280_energy_stop_continuous_forced_mode(BMP280 self, BMP280Energy *const energy, BMP280CompleteCb cb,
+                                                  void *user_data)
+{
+    if (!energy) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    return bmp280_op_track_stop(self, &energy->op, cb, user_data);
+}
+
+uint32_t bmp280_energy_plan_current_na(const BMP280EnergyCfg *const cfg, uint8_t temp_oversampling,
+                                       uint8_t pres_oversampling, uint32_t period_ms)
+{
+    if (!cfg || !period_ms) {
+        return 0;
+    }
+
+    uint64_t period_us = (uint64_t)period_ms * 1000;
+    uint32_t data_bytes = (pres_oversampling == BMP280_OVERSAMPLING_SKIPPED) ? BMP280_ENERGY_TEMP_DATA_BYTES
+                                                                              : BMP280_ENERGY_TEMP_AND_PRES_DATA_BYTES;
+    uint64_t sample_fc = bmp280_energy_conversion_fc(&cfg->currents, temp_oversampling, pres_oversampling);
+    /* ctrl_meas write and data register read */
+    sample_fc += 2 * (uint64_t)cfg->bus_transaction_fc + (1 + (uint64_t)data_bytes) * cfg->bus_byte_fc;
+    sample_fc += period_us * cfg->currents.sleep_na;
+    return (uint32_t)((sample_fc + period_us / 2) / period_us);
+}
@@ -0,0 +1,234 @@
+#ifndef SRC_BMP280_ENERGY_H
+#define SRC_BMP280_ENERGY_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "bmp280.h"
+#include "bmp280_op_track.h"
+
+/**
+ * @brief Estimate of the charge that a sensor draws, per operation and in total.
+ *
+ * The estimate is built from the register writes and bus transactions that the driver issues, which pass through
+ * @ref bmp280_energy_read_regs and @ref bmp280_energy_write_reg:
+ * - A write of ctrl_meas with forced mode starts a conversion. Its charge is the temperature measurement current for
+ * 1 ms + 2 ms per temperature oversampling step, plus the pressure measurement current for 2 ms per pressure
+ * oversampling step + 0.5 ms. These are the typical conversion times from the datasheet, section 3.8.1.
+ * - In normal mode, set with ctrl_meas, the sensor converts continuously with the standby time from config in between.
+ * - Otherwise the sensor draws the sleep current, also during forced mode conversions. A reset command returns it to
+ * sleep mode.
+ * - Every bus transaction costs a fixed charge plus a charge per data byte, e.g. the pull-up current of I2C.
+ *
+ * Charges are in fC (1e-15 C), currents in nA, times in us: nA * us = fC. 1 uA for 1 s is 1e9 fC, or 1 uC.
+ *
+ * The per-operation charge is collected by passing @ref bmp280_energy_complete_cb as the complete callback, with the
+ * user data returned by @ref bmp280_energy_op_prepare. @ref bmp280_energy_read_meas_forced_mode does that for forced
+ * mode reads. In a session started with @ref bmp280_energy_start_continuous_forced_mode, every sample counts as one
+ * operation.
+ *
+ * @ref bmp280_energy_plan_current_na predicts the average current of sampling in forced mode with given oversampling
+ * options and period, using the same model, so a scheduler can compare plans before running them.
+ */
+
+/** Supply currents of the sensor in nA. */
+typedef struct {
+    /** Sleep mode. */
+    uint32_t sleep_na;
+    /** Standby between conversions in normal mode. */
+    uint32_t standby_na;
+    /** During temperature measurement. */
+    uint32_t temp_meas_na;
+    /** During pressure measurement. */
+    uint32_t pres_meas_na;
+} BMP280EnergyCurrents;
+
+/** Typical currents from the datasheet, section 1: I_DDSL, I_DDSB, I_DDT and I_DDP. */
+#define BMP280_ENERGY_DATASHEET_CURRENTS {100, 200, 325000, 720000}
+
+/**
+ * @brief Get current time in microseconds. Can wrap around.
+ */
+typedef uint32_t (*BMP280EnergyNowUs)(void *user_data);
+
+/** Energy model configuration of a sensor. */
+typedef struct {
+    BMP280EnergyCurrents currents;
+    /** Charge of every bus transaction (start condition, device address, register address), in fC. */
+    uint32_t bus_transaction_fc;
+    /** Charge of every data byte on the bus, in fC. */
+    uint32_t bus_byte_fc;
+    BMP280EnergyNowUs now_us;
+    void *now_us_user_data;
+    /** Register access functions that @ref bmp280_energy_read_regs and @ref bmp280_energy_write_reg forward to. */
+    BMP280ReadRegs read_regs;
+    void *read_regs_user_data;
+    BMP280WriteReg write_reg;
+    void *write_reg_user_data;
+} BMP280EnergyCfg;
+
+/** Charge counters of a sensor, in fC. */
+typedef struct {
+    /** Conversions, in forced and normal mode. */
+    uint64_t conversion_fc;
+    /** Sleep, and standby in normal mode. */
+    uint64_t idle_fc;
+    /** Bus transactions. */
+    uint64_t bus_fc;
+    /** Number of forced mode conversions. */
+    uint64_t num_conversions;
+    /** Charge of the latest completed operation that was tracked with @ref bmp280_energy_op_prepare. */
+    uint64_t last_op_fc;
+} BMP280EnergyCounters;
+
+/**
+ * @brief Energy model of one sensor. Memory is provided by the user.
+ *
+ * Fields other than counters are private. Counters are up to date as of the latest call into this module, call @ref
+ * bmp280_energy_update before reading them.
+ */
+typedef struct {
+    BMP280EnergyCounters counters;
+    BMP280EnergyCfg cfg;
+    /** Mode, osrs_t and osrs_p from the latest write of ctrl_meas, t_sb from the latest write of config. */
+    uint8_t mode;
+    uint8_t osrs_t;
+    uint8_t osrs_p;
+    uint8_t t_sb;
+    uint32_t last_update_us;
+    /** Tracked operation, with the total charge when it started as start value. */
+    BMP280OpTrack op;
+    /** Register write in progress, applied to the mode once it succeeds. */
+    uint8_t io_addr;
+    uint8_t io_val;
+    bool io_is_write;
+    size_t io_bytes;
+    BMP280_IOCompleteCb io_cb;
+    void *io_cb_user_data;
+} BMP280Energy;
+
+/**
+ * @brief Initialize the energy model of a sensor in sleep mode, with zero counters.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully initialized @p energy.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p energy or @p cfg is NULL, or a function in @p cfg is NULL.
+ */
+uint8_t bmp280_energy_init(BMP280Energy *const energy, const BMP280EnergyCfg *const cfg);
+
+/**
+ * @brief Implementation of @ref BMP280ReadRegs. user_data must point to a @ref BMP280Energy.
+ */
+void bmp280_energy_read_regs(uint8_t start_addr, size_t num_regs, uint8_t *data, void *user_data,
+                             BMP280_IOCompleteCb cb, void *cb_user_data);
+
+/**
+ * @brief Implementation of @ref BMP280WriteReg. user_data must point to a @ref BMP280Energy.
+ */
+void bmp280_energy_write_reg(uint8_t addr, uint8_t reg_val, void *user_data, BMP280_IOCompleteCb cb,
+                             void *cb_user_data);
+
+/**
+ * @brief Add the sleep or normal mode charge up to now to the counters.
+ *
+ * now_us wraps around after about 71 minutes. If the driver may be idle for longer, call this function at least that
+ * often.
+ */
+void bmp280_energy_update(BMP280Energy *const energy);
+
+/**
+ * @brief Get the total charge of the sensor up to now.
+ *
+ * @return uint64_t Sum of all counters in fC.
+ */
+uint64_t bmp280_energy_total_fc(BMP280Energy *const energy);
+
+/**
+ * @brief Start tracking the charge of an operation that is about to be submitted.
+ *
+ * If a tracked operation of this sensor is already in progress, the new one will be rejected with BUSY by the driver,
+ * and the operation in progress keeps being tracked.
+ *
+ * @param[in] energy Energy model of the sensor.
+ * @param[in] cb Complete callback of the operation, executed by @ref bmp280_energy_complete_cb.
+ * @param[in] user_data User data to pass to @p cb.
+ *
+ * @return void* @p energy, to pass as user data together with @ref bmp280_energy_complete_cb.
+ */
+void *bmp280_energy_op_prepare(BMP280Energy *const energy, BMP280CompleteCb cb, void *user_data);
+
+/**
+ * @brief Record the return code of the driver function that the operation was submitted with.
+ *
+ * @return uint8_t @p rc, so that the call can wrap the driver function call.
+ */
+uint8_t bmp280_energy_op_submitted(BMP280Energy *const energy, uint8_t rc);
+
+/**
+ * @brief Complete callback that stores the charge of the operation in last_op_fc and executes the callback passed to
+ * @ref bmp280_energy_op_prepare. user_data must point to a @ref BMP280Energy.
+ */
+void bmp280_energy_complete_cb(uint8_t rc, void *user_data);
+
+/**
+ * @brief @ref bmp280_read_meas_forced_mode_with_oversampling with charge tracking.
+ */
+uint8_t bmp280_energy_read_meas_forced_mode(BMP280 self, BMP280Energy *const energy, uint8_t temp_oversampling,
+                                            uint8_t pres_oversampling, BMP280Meas *const meas, BMP280CompleteCb cb,
+                                            void *user_data);
+
+/**
+ * @brief @ref bmp280_start_continuous_forced_mode with charge tracking of every sample.
+ *
+ * The session is tracked as one operation in progress until it ends. Stop it with @ref
+ * bmp280_energy_stop_continuous_forced_mode.
+ */
+uint8_t bmp280_energy_start_continuous_forced_mode(BMP280 self, BMP280Energy *const energy, uint8_t meas_type,
+                                                   uint32_t meas_time_ms, BMP280Meas *const meas, BMP280CompleteCb cb,
+                                                   void *user_data);
+
+/**
+ * @brief @ref bmp280_stop_continuous_forced_mode for a session started with @ref
+ * bmp280_energy_start_continuous_forced_mode. The session stops being tracked before @p cb is executed.
+ */
+uint8_t bmp280_energy_stop_continuous_forced_mode(BMP280 self, BMP280Energy *const energy, BMP280CompleteCb cb,
+                                                  void *user_data);
+
+/**
+ * @brief Charge of one forced mode conversion.
+ *
+ * @param[in] currents Sensor currents.
+ * @param[in] temp_oversampling One of @ref BMP280Oversampling.
+ * @param[in] pres_oversampling One of @ref BMP280Oversampling.
+ *
+ * @return uint64_t Charge in fC.
+ */
+uint64_t bmp280_energy_conversion_fc(const BMP280EnergyCurrents *const currents, uint8_t temp_oversampling,
+                                     uint8_t pres_oversampling);
+
+/**
+ * @brief Predict the average current of forced mode sampling.
+ *
+ * Every sample is one @ref bmp280_read_meas_forced_mode_with_oversampling: a conversion, a ctrl_meas write with one
+ * data byte and a data register read of 6 bytes (3 bytes without pressure). The sensor sleeps in between.
+ *
+ * @param[in] cfg Energy model configuration. Functions are not used.
+ * @param[in] temp_oversampling One of @ref BMP280Oversampling, other than skipped.
+ * @param[in] pres_oversampling One of @ref BMP280Oversampling.
+ * @param[in] period_ms Sampling period. Cannot be 0.
+ *
+ * @return uint32_t Average current in nA.
+ */
+uint32_t bmp280_energy_plan_current_na(const BMP280EnergyCfg *const cfg, uint8_t temp_oversampling,
+                                       uint8_t pres_oversampling, uint32_t period_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_BMP280_ENERGY_H */
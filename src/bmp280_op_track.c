@@ -0,0 +1,77 @@
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "bmp280_op_track.h"
+
+void bmp280_op_track_prepare(BMP280OpTrack *const track, BMP280CompleteCb cb, void *user_data, bool continuous,
+                             uint64_t start)
+{
+    /* The driver will reject the new operation if one is in progress, which then keeps its callback */
+    track->prepared = !track->in_progress;
+    if (track->prepared) {
+        track->next_continuous = continuous;
+        track->next_start = start;
+        track->next_cb = cb;
+        track->next_cb_user_data = user_data;
+    }
+}
+
+static void accept_staged(BMP280OpTrack *const track)
+{
+    track->prepared = false;
+    track->in_progress = true;
+    track->continuous = track->next_continuous;
+    track->start = track->next_start;
+    track->cb = track->next_cb;
+    track->cb_user_data = track->next_cb_user_data;
+}
+
+void bmp280_op_track_submitted(BMP280OpTrack *const track, uint8_t rc)
+{
+    /* Unless it already completed from within the driver function */
+    if ((rc == BMP280_RESULT_CODE_OK) && track->prepared) {
+        accept_staged(track);
+    }
+    track->prepared = false;
+}
+
+uint64_t bmp280_op_track_complete(BMP280OpTrack *const track, uint8_t rc, uint64_t now)
+{
+    if (track->prepared) {
+        /* Completed before the driver function returned */
+        accept_staged(track);
+    }
+    uint64_t start = track->start;
+    if (!track->continuous || (rc != BMP280_RESULT_CODE_OK)) {
+        track->in_progress = false;
+    }
+    track->start = now;
+    return start;
+}
+
+void bmp280_op_track_execute_cb(const BMP280OpTrack *const track, uint8_t rc)
+{
+    if (track->cb) {
+        track->cb(rc, track->cb_user_data);
+    }
+}
+
+uint8_t bmp280_op_track_stop(BMP280 self, BMP280OpTrack *const track, BMP280CompleteCb cb, void *user_data)
+{
+    uint8_t rc = bmp280_stop_continuous_forced_mode(self, bmp280_op_track_stop_complete_cb, (void *)track);
+    /* The driver executes the stop callback later, never from within this call */
+    if (rc == BMP280_RESULT_CODE_OK) {
+        track->stop_cb = cb;
+        track->stop_cb_user_data = user_data;
+    }
+    return rc;
+}
+
+void bmp280_op_track_stop_complete_cb(uint8_t rc, void *user_data)
+{
+    BMP280OpTrack *track = (BMP280OpTrack *)user_data;
+    track->in_progress = false;
+    if (track->stop_cb) {
+        track->stop_cb(rc, track->stop_cb_user_data);
+    }
+}
@@ -0,0 +1,110 @@
+#ifndef SRC_BMP280_OP_TRACK_H
+#define SRC_BMP280_OP_TRACK_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bmp280.h"
+
+/**
+ * @brief Tracking of the driver operation in progress of one sensor, shared by the modules that wrap the complete
+ * callback of driver operations, e.g. @ref bmp280_stats.h and @ref bmp280_energy.h.
+ *
+ * A wrapper calls @ref bmp280_op_track_prepare before it submits an operation, passes the return code of the driver
+ * function to @ref bmp280_op_track_submitted, and calls @ref bmp280_op_track_complete followed by @ref
+ * bmp280_op_track_execute_cb from its complete callback.
+ *
+ * The driver rejects a new operation with BUSY while another one is in progress, and in continuous forced mode the
+ * session is in progress also between two samples. The operation in progress must therefore keep its callback: a new
+ * operation is only staged by @ref bmp280_op_track_prepare, and becomes the one in progress once the driver accepts
+ * it. The driver may also complete an operation from within the function that submits it, before @ref
+ * bmp280_op_track_submitted is called.
+ *
+ * Every operation has a start value, e.g. a timestamp or a charge, which the wrapper compares with its value at
+ * completion. In continuous forced mode, the start value of the next sample is the completion value of the previous
+ * one.
+ */
+
+/** Operation tracking state. Memory is provided by the user, fields are private. */
+typedef struct {
+    bool in_progress;
+    /** Whether the operation in progress is a continuous forced mode session, which completes once per sample. */
+    bool continuous;
+    uint64_t start;
+    BMP280CompleteCb cb;
+    void *cb_user_data;
+    /** Whether the last @ref bmp280_op_track_prepare call staged an operation that the driver has not accepted yet. */
+    bool prepared;
+    bool next_continuous;
+    uint64_t next_start;
+    BMP280CompleteCb next_cb;
+    void *next_cb_user_data;
+    BMP280CompleteCb stop_cb;
+    void *stop_cb_user_data;
+} BMP280OpTrack;
+
+/**
+ * @brief Stage an operation that is about to be submitted, unless another one is in progress.
+ *
+ * @param[in] track Tracking state of the sensor.
+ * @param[in] cb Complete callback of the operation, executed by @ref bmp280_op_track_execute_cb. Can be NULL.
+ * @param[in] user_data User data to pass to @p cb.
+ * @param[in] continuous Whether the operation starts a continuous forced mode session.
+ * @param[in] start Start value of the operation.
+ */
+void bmp280_op_track_prepare(BMP280OpTrack *const track, BMP280CompleteCb cb, void *user_data, bool continuous,
+                             uint64_t start);
+
+/**
+ * @brief Make the staged operation the one in progress if the driver accepted it.
+ *
+ * @param[in] track Tracking state of the sensor.
+ * @param[in] rc Return code of the driver function that the operation was submitted with.
+ */
+void bmp280_op_track_submitted(BMP280OpTrack *const track, uint8_t rc);
+
+/**
+ * @brief Complete the operation in progress, or one sample of a continuous forced mode session.
+ *
+ * A session ends with its first error. The callback is not executed, call @ref bmp280_op_track_execute_cb for that
+ * once the wrapper has recorded the operation.
+ *
+ * @param[in] track Tracking state of the sensor.
+ * @param[in] rc Result code passed to the complete callback by the driver.
+ * @param[in] now Value at completion, which becomes the start value of the next sample of a session.
+ *
+ * @return uint64_t Start value of the completed operation or sample.
+ */
+uint64_t bmp280_op_track_complete(BMP280OpTrack *const track, uint8_t rc, uint64_t now);
+
+/**
+ * @brief Execute the callback of the operation that @ref bmp280_op_track_complete has completed, if it is not NULL.
+ *
+ * The callback can submit the next operation.
+ */
+void bmp280_op_track_execute_cb(const BMP280OpTrack *const track, uint8_t rc);
+
+/**
+ * @brief Stop a continuous forced mode session with @ref bmp280_stop_continuous_forced_mode.
+ *
+ * @p self executes @ref bmp280_op_track_stop_complete_cb once stopped, which ends the session and executes @p cb.
+ *
+ * @return uint8_t Return code of @ref bmp280_stop_continuous_forced_mode.
+ */
+uint8_t bmp280_op_track_stop(BMP280 self, BMP280OpTrack *const track, BMP280CompleteCb cb, void *user_data);
+
+/**
+ * @brief Complete callback of @ref bmp280_op_track_stop. user_data must point to a @ref BMP280OpTrack.
+ */
+void bmp280_op_track_stop_complete_cb(uint8_t rc, void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_BMP280_OP_TRACK_H */
@@ -0,0 +1,288 @@
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "bmp280_pipeline.h"
+
+/** Number of accumulators per column in the statistics stage. */
+#define BMP280_PIPELINE_STATS_LANES 16
+
+uint8_t bmp280_block_pool_init(BMP280BlockPool *const pool, const BMP280BlockPoolArrays *const arrays)
+{
+    if (!pool || !arrays) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    if (!arrays->blocks || !arrays->timestamps_ms || !arrays->sensor_ids || !arrays->temperatures ||
+        !arrays->pressures || arrays->num_blocks == 0 || arrays->block_capacity == 0) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    pool->free_list = NULL;
+    /* Pushed in reverse order, so that blocks are handed out starting from the first one */
+    for (size_t i = arrays->num_blocks; i-- > 0;) {
+        BMP280Block *block = &arrays->blocks[i];
+        size_t offset = i * arrays->block_capacity;
+        block->timestamps_ms = &arrays->timestamps_ms[offset];
+        block->sensor_ids = &arrays->sensor_ids[offset];
+        block->temperatures = &arrays->temperatures[offset];
+        block->pressures = &arrays->pressures[offset];
+        block->num = 0;
+        block->capacity = arrays->block_capacity;
+        block->refcount = 0;
+        block->pool = pool;
+        block->next_free = pool->free_list;
+        pool->free_list = block;
+    }
+    pool->num_free = arrays->num_blocks;
+    pool->num_alloc_failures = 0;
+    return BMP280_RESULT_CODE_OK;
+}
+
+BMP280Block *bmp280_block_alloc(BMP280BlockPool *const pool)
+{
+    BMP280Block *block = pool->free_list;
+    if (!block) {
+        pool->num_alloc_failures++;
+        return NULL;
+    }
+    pool->free_list = block->next_free;
+    pool->num_free--;
+    block->next_free = NULL;
+    block->num = 0;
+    block->refcount = 1;
+    return block;
+}
+
+void bmp280_block_ref(BMP280Block *const block)
+{
+    block->refcount++;
+}
+
+void bmp280_block_unref(BMP280Block *const block)
+{
+    if (--block->refcount > 0) {
+        return;
+    }
+    BMP280BlockPool *pool = block->pool;
+    block->next_free = pool->free_list;
+    pool->free_list = block;
+    pool->num_free++;
+}
+
+bool bmp280_block_append(BMP280Block *const block, uint32_t sensor_id, uint32_t timestamp_ms,
+                         const BMP280Meas *const meas)
+{
+    if (block->num == block->capacity) {
+        return false;
+    }
+    size_t i = block->num++;
+    block->timestamps_ms[i] = timestamp_ms;
+    block->sensor_ids[i] = sensor_id;
+    block->temperatures[i] = meas->temperature;
+    block->pressures[i] = meas->pressure;
+    return true;
+}
+
+uint8_t bmp280_pipeline_stage_init(BMP280PipelineStage *const stage, BMP280PipelineProcessFn process)
+{
+    if (!stage || !process) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    stage->process = process;
+    stage->num_outputs = 0;
+    return BMP280_RESULT_CODE_OK;
+}
+
+uint8_t bmp280_pipeline_connect(BMP280PipelineStage *const from, BMP280PipelineStage *const to)
+{
+    if (!from || !to) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    if (from->num_outputs == BMP280_PIPELINE_MAX_OUTPUTS) {
+        return BMP280_RESULT_CODE_NO_MEM;
+    }
+    from->outputs[from->num_outputs++] = to;
+    return BMP280_RESULT_CODE_OK;
+}
+
+void bmp280_pipeline_push(BMP280PipelineStage *const stage, BMP280Block *const block)
+{
+    stage->process(stage, block);
+}
+
+void bmp280_pipeline_emit(BMP280PipelineStage *const stage, BMP280Block *const block)
+{
+    for (size_t i = 0; i < stage->num_outputs; i++) {
+        BMP280PipelineStage *out = stage->outputs[i];
+        out->process(out, block);
+    }
+}
+
+static bool filter_keeps(const BMP280PipelineFilter *const f, const BMP280Block *const block, size_t i)
+{
+    return block->temperatures[i] >= f->temp_min && block->temperatures[i] <= f->temp_max &&
+           block->pressures[i] >= f->pres_min && block->pressures[i] <= f->pres_max;
+}
+
+static void filter_process(BMP280PipelineStage *stage, BMP280Block *block)
+{
+    BMP280PipelineFilter *f = (BMP280PipelineFilter *)stage;
+    size_t num_kept = 0;
+    for (size_t i = 0; i < block->num; i++) {
+        num_kept += filter_keeps(f, block, i) ? 1 : 0;
+    }
+    if (num_kept == block->num) {
+        bmp280_pipeline_emit(stage, block);
+        return;
+    }
+    if (num_kept == 0) {
+        f->num_dropped += block->num;
+        return;
+    }
+
+    BMP280Block *out = bmp280_block_alloc(f->pool);
+    if (!out) {
+        f->num_dropped += block->num;
+        return;
+    }
+    for (size_t i = 0; i < block->num; i++) {
+        if (filter_keeps(f, block, i)) {
+            size_t j = out->num++;
+            out->timestamps_ms[j] = block->timestamps_ms[i];
+            out->sensor_ids[j] = block->sensor_ids[i];
+            out->temperatures[j] = block->temperatures[i];
+            out->pressures[j] = block->pressures[i];
+        }
+    }
+    f->num_dropped += block->num - num_kept;
+    bmp280_pipeline_emit(stage, out);
+    bmp280_block_unref(out);
+}
+
+uint8_t bmp280_pipeline_filter_init(BMP280PipelineFilter *const filter, BMP280BlockPool *const pool)
+{
+    if (!filter || !pool) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    bmp280_pipeline_stage_init(&filter->stage, filter_process);
+    filter->pool = pool;
+    filter->temp_min = INT32_MIN;
+    filter->temp_max = INT32_MAX;
+    filter->pres_min = 0;
+    filter->pres_max = UINT32_MAX;
+    filter->num_dropped = 0;
+    return BMP280_RESULT_CODE_OK;
+}
+
+static void stats_process(BMP280PipelineStage *stage, BMP280Block *block)
+{
+    BMP280PipelineStats *s = (BMP280PipelineStats *)stage;
+    const int32_t *temps = block->temperatures;
+    const uint32_t *pres = block->pressures;
+    int32_t temp_min[BMP280_PIPELINE_STATS_LANES];
+    int32_t temp_max[BMP280_PIPELINE_STATS_LANES];
+    int64_t temp_sum[BMP280_PIPELINE_STATS_LANES];
+    uint32_t pres_min[BMP280_PIPELINE_STATS_LANES];
+    uint32_t pres_max[BMP280_PIPELINE_STATS_LANES];
+    uint64_t pres_sum[BMP280_PIPELINE_STATS_LANES];
+    for (size_t l = 0; l < BMP280_PIPELINE_STATS_LANES; l++) {
+        temp_min[l] = s->temp_min;
+        temp_max[l] = s->temp_max;
+        temp_sum[l] = 0;
+        pres_min[l] = s->pres_min;
+        pres_max[l] = s->pres_max;
+        pres_sum[l] = 0;
+    }
+
+    /* Fixed trip count inner loops with one accumulator per lane, so that the compiler vectorizes them at -O2 */
+    size_t i = 0;
+    for (; i + BMP280_PIPELINE_STATS_LANES <= block->num; i += BMP280_PIPELINE_STATS_LANES) {
+        for (size_t l = 0; l < BMP280_PIPELINE_STATS_LANES; l++) {
+            int32_t t = temps[i + l];
+            temp_min[l] = (t < temp_min[l]) ? t : temp_min[l];
+            temp_max[l] = (t > temp_max[l]) ? t : temp_max[l];
+            temp_sum[l] += t;
+        }
+        for (size_t l = 0; l < BMP280_PIPELINE_STATS_LANES; l++) {
+            uint32_t p = pres[i + l];
+            pres_min[l] = (p < pres_min[l]) ? p : pres_min[l];
+            pres_max[l] = (p > pres_max[l]) ? p : pres_max[l];
+            pres_sum[l] += p;
+        }
+    }
+    for (size_t l = 0; i < block->num; i++, l++) {
+        temp_min[l] = (temps[i] < temp_min[l]) ? temps[i] : temp_min[l];
+        temp_max[l] = (temps[i] > temp_max[l]) ? temps[i] : temp_max[l];
+        temp_sum[l] += temps[i];
+        pres_min[l] = (pres[i] < pres_min[l]) ? pres[i] : pres_min[l];
+        pres_max[l] = (pres[i] > pres_max[l]) ? pres[i] : pres_max[l];
+        pres_sum[l] += pres[i];
+    }
+
+    for (size_t l = 0; l < BMP280_PIPELINE_STATS_LANES; l++) {
+        s->temp_min = (temp_min[l] < s->temp_min) ? temp_min[l] : s->temp_min;
+        s->temp_max = (temp_max[l] > s->temp_max) ? temp_max[l] : s->temp_max;
+        s->temp_sum += temp_sum[l];
+        s->pres_min = (pres_min[l] < s->pres_min) ? pres_min[l] : s->pres_min;
+        s->pres_max = (pres_max[l] > s->pres_max) ? pres_max[l] : s->pres_max;
+        s->pres_sum += pres_sum[l];
+    }
+    s->num_samples += block->num;
+    bmp280_pipeline_emit(stage, block);
+}
+
+uint8_t bmp280_pipeline_stats_init(BMP280PipelineStats *const stats)
+{
+    if (!stats) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    bmp280_pipeline_stage_init(&stats->stage, stats_process);
+    stats->num_samples = 0;
+    /* Empty range, so that the first sample sets both bounds */
+    stats->temp_min = INT32_MAX;
+    stats->temp_max = INT32_MIN;
+    stats->pres_min = UINT32_MAX;
+    stats->pres_max = 0;
+    stats->temp_sum = 0;
+    stats->pres_sum = 0;
+    return BMP280_RESULT_CODE_OK;
+}
+
+static void telemetry_sink_send(BMP280PipelineTelemetrySink *const sink)
+{
+    size_t len = bmp280_telemetry_encoder_finish(sink->enc, sink->frame, sizeof(sink->frame));
+    if (len > 0) {
+        sink->send(sink->frame, len, sink->send_user_data);
+    }
+}
+
+static void telemetry_sink_process(BMP280PipelineStage *stage, BMP280Block *block)
+{
+    BMP280PipelineTelemetrySink *sink = (BMP280PipelineTelemetrySink *)stage;
+    for (size_t i = 0; i < block->num; i++) {
+        BMP280Meas meas = {block->temperatures[i], block->pressures[i]};
+        if (bmp280_telemetry_encoder_add(sink->enc, block->sensor_ids[i], block->timestamps_ms[i], &meas) ==
+            BMP280_RESULT_CODE_NO_MEM) {
+            telemetry_sink_send(sink);
+            bmp280_telemetry_encoder_add(sink->enc, block->sensor_ids[i], block->timestamps_ms[i], &meas);
+        }
+    }
+    bmp280_pipeline_emit(stage, block);
+}
+
+uint8_t bmp280_pipeline_telemetry_sink_init(BMP280PipelineTelemetrySink *const sink, BMP280TelemetryEncoder *const enc,
+                                            BMP280PipelineSendFn send, void *send_user_data)
+{
+    if (!sink || !enc || !send) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    bmp280_pipeline_stage_init(&sink->stage, telemetry_sink_process);
+    sink->enc = enc;
+    sink->send = send;
+    sink->send_user_data = send_user_data;
+    return BMP280_RESULT_CODE_OK;
+}
+
+void bmp280_pipeline_telemetry_sink_flush(BMP280PipelineTelemetrySink *const sink)
+{
+    telemetry_sink_send(sink);
+}
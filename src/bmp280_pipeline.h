@@ -0,0 +1,271 @@
+#ifndef SRC_BMP280_PIPELINE_H
+#define SRC_BMP280_PIPELINE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "bmp280.h"
+#include "bmp280_telemetry.h"
+
+/**
+ * @brief Processing pipeline for blocks of measurement samples.
+ *
+ * Samples travel through the pipeline in blocks. A block holds up to block_capacity samples of any number of sensors
+ * in structure-of-arrays form: timestamps, sensor ids, temperatures and pressures. Blocks come from a
+ * @ref BMP280BlockPool with a fixed number of blocks provided by the user, and are reference counted. When the last
+ * reference is dropped, the block goes back to the free list of its pool. Nothing is allocated from the heap.
+ *
+ * Stages are connected into a graph with @ref bmp280_pipeline_connect. @ref bmp280_pipeline_emit passes a block to
+ * every output of a stage, one after another, by executing their process functions. All consumers see the same block,
+ * so fan-out does not copy samples.
+ *
+ * Rules for process functions:
+ * - The block is borrowed for the duration of the call. A stage that keeps it longer, e.g. to batch several blocks,
+ * takes a reference with @ref bmp280_block_ref and drops it with @ref bmp280_block_unref later.
+ * - A block must not be modified once it has been emitted, because other consumers may still read it. A stage that
+ * produces new values allocates a block from a pool, fills it, emits it and drops its reference.
+ *
+ * Pools, blocks and stages are not thread safe. All pipeline functions must execute in the same context, e.g. the
+ * driver context.
+ *
+ * Built-in stages:
+ * - @ref BMP280PipelineFilter: keeps samples with values in a range. Emits the input block itself if every sample
+ * passes, otherwise a new block with the samples that pass.
+ * - @ref BMP280PipelineStats: count, minimum, maximum and sum of values of all samples it has seen. Emits the input
+ * block.
+ * - @ref BMP280PipelineTelemetrySink: adds every sample to a @ref BMP280TelemetryEncoder, and hands full frames to a
+ * send callback. Emits the input block. Requires bmp280_telemetry.c.
+ */
+
+/** Maximum number of outputs of one stage. */
+#ifndef BMP280_PIPELINE_MAX_OUTPUTS
+#define BMP280_PIPELINE_MAX_OUTPUTS 4
+#endif
+
+typedef struct BMP280BlockPoolStruct BMP280BlockPool;
+
+/**
+ * @brief Block of samples. Sample i consists of element i of each array.
+ *
+ * The arrays and num can be accessed directly. Other fields are private.
+ */
+typedef struct BMP280BlockStruct {
+    uint32_t *timestamps_ms;
+    uint32_t *sensor_ids;
+    int32_t *temperatures;
+    uint32_t *pressures;
+    /** Number of samples in the block. */
+    size_t num;
+    size_t capacity;
+    uint32_t refcount;
+    BMP280BlockPool *pool;
+    /** Next free block, while the block is in the free list. */
+    struct BMP280BlockStruct *next_free;
+} BMP280Block;
+
+/**
+ * @brief Memory of a @ref BMP280BlockPool. Provided by the user.
+ *
+ * blocks has num_blocks elements. Every other array has num_blocks * block_capacity elements.
+ */
+typedef struct {
+    BMP280Block *blocks;
+    uint32_t *timestamps_ms;
+    uint32_t *sensor_ids;
+    int32_t *temperatures;
+    uint32_t *pressures;
+    size_t num_blocks;
+    size_t block_capacity;
+} BMP280BlockPoolArrays;
+
+/** Block pool. Statistics fields can be read directly, other fields are private. */
+struct BMP280BlockPoolStruct {
+    BMP280Block *free_list;
+    size_t num_free;
+    /** Number of times that @ref bmp280_block_alloc found no free block. */
+    uint32_t num_alloc_failures;
+};
+
+struct BMP280PipelineStageStruct;
+
+/**
+ * @brief Process a block that was emitted by an upstream stage or pushed into the pipeline.
+ *
+ * @param[in] stage The stage that processes the block.
+ * @param[in] block Block. Borrowed for the duration of the call.
+ */
+typedef void (*BMP280PipelineProcessFn)(struct BMP280PipelineStageStruct *stage, BMP280Block *block);
+
+/**
+ * @brief Pipeline stage.
+ *
+ * Custom stages embed a stage as the first member of their own struct, so that the process function can cast the
+ * stage pointer to it. Fields are private, use the functions of this module to access them.
+ */
+typedef struct BMP280PipelineStageStruct {
+    BMP280PipelineProcessFn process;
+    struct BMP280PipelineStageStruct *outputs[BMP280_PIPELINE_MAX_OUTPUTS];
+    size_t num_outputs;
+} BMP280PipelineStage;
+
+/** Stage that keeps samples with temperature and pressure in a range. Bounds are inclusive. */
+typedef struct {
+    BMP280PipelineStage stage;
+    /** Pool to allocate output blocks from, if some samples of a block are dropped. */
+    BMP280BlockPool *pool;
+    int32_t temp_min;
+    int32_t temp_max;
+    uint32_t pres_min;
+    uint32_t pres_max;
+    /** Number of samples that were dropped, including those dropped because no output block was available. */
+    uint64_t num_dropped;
+} BMP280PipelineFilter;
+
+/** Stage that aggregates all samples it sees. Fields can be read directly. */
+typedef struct {
+    BMP280PipelineStage stage;
+    uint64_t num_samples;
+    int32_t temp_min;
+    int32_t temp_max;
+    uint32_t pres_min;
+    uint32_t pres_max;
+    int64_t temp_sum;
+    uint64_t pres_sum;
+} BMP280PipelineStats;
+
+/**
+ * @brief Send a finished telemetry frame.
+ *
+ * @param[in] frame Frame.
+ * @param[in] len Frame length.
+ * @param[in] user_data User data passed to @ref bmp280_pipeline_telemetry_sink_init.
+ */
+typedef void (*BMP280PipelineSendFn)(const uint8_t *frame, size_t len, void *user_data);
+
+/** Stage that encodes samples into telemetry frames. */
+typedef struct {
+    BMP280PipelineStage stage;
+    BMP280TelemetryEncoder *enc;
+    BMP280PipelineSendFn send;
+    void *send_user_data;
+    uint8_t frame[BMP280_TELEMETRY_MAX_FRAME_SIZE];
+} BMP280PipelineTelemetrySink;
+
+/**
+ * @brief Initialize a block pool. All blocks are free afterwards.
+ *
+ * @param[out] pool Pool to initialize.
+ * @param[in] arrays Memory of the pool.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully initialized @p pool.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p pool or @p arrays is NULL, an array is NULL, or num_blocks or block_capacity
+ * is 0.
+ */
+uint8_t bmp280_block_pool_init(BMP280BlockPool *const pool, const BMP280BlockPoolArrays *const arrays);
+
+/**
+ * @brief Take an empty block from the free list of @p pool.
+ *
+ * @return BMP280Block* Block with a reference count of 1, or NULL if no block is free.
+ */
+BMP280Block *bmp280_block_alloc(BMP280BlockPool *const pool);
+
+/**
+ * @brief Take an additional reference to @p block.
+ */
+void bmp280_block_ref(BMP280Block *const block);
+
+/**
+ * @brief Drop a reference to @p block. The block goes back to its pool when the last reference is dropped.
+ */
+void bmp280_block_unref(BMP280Block *const block);
+
+/**
+ * @brief Append a sample to a block that has not been emitted yet.
+ *
+ * @return bool false if the block is full.
+ */
+bool bmp280_block_append(BMP280Block *const block, uint32_t sensor_id, uint32_t timestamp_ms,
+                         const BMP280Meas *const meas);
+
+/**
+ * @brief Initialize a stage without outputs.
+ *
+ * @param[out] stage Stage to initialize.
+ * @param[in] process Process function of the stage.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully initialized @p stage.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p stage or @p process is NULL.
+ */
+uint8_t bmp280_pipeline_stage_init(BMP280PipelineStage *const stage, BMP280PipelineProcessFn process);
+
+/**
+ * @brief Add @p to as an output of @p from.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully connected the stages.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p from or @p to is NULL.
+ * @retval BMP280_RESULT_CODE_NO_MEM @p from already has BMP280_PIPELINE_MAX_OUTPUTS outputs.
+ */
+uint8_t bmp280_pipeline_connect(BMP280PipelineStage *const from, BMP280PipelineStage *const to);
+
+/**
+ * @brief Process @p block with @p stage. Used to feed blocks into the pipeline.
+ *
+ * The caller keeps its reference to @p block, and drops it once this function returns.
+ */
+void bmp280_pipeline_push(BMP280PipelineStage *const stage, BMP280Block *const block);
+
+/**
+ * @brief Pass @p block to every output of @p stage. Called by process functions.
+ */
+void bmp280_pipeline_emit(BMP280PipelineStage *const stage, BMP280Block *const block);
+
+/**
+ * @brief Initialize a filter stage that keeps every sample. Narrow the bounds in @p filter afterwards.
+ *
+ * @param[out] filter Filter stage to initialize.
+ * @param[in] pool Pool to allocate output blocks from.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully initialized @p filter.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p filter or @p pool is NULL.
+ */
+uint8_t bmp280_pipeline_filter_init(BMP280PipelineFilter *const filter, BMP280BlockPool *const pool);
+
+/**
+ * @brief Initialize a statistics stage with no samples.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully initialized @p stats.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p stats is NULL.
+ */
+uint8_t bmp280_pipeline_stats_init(BMP280PipelineStats *const stats);
+
+/**
+ * @brief Initialize a telemetry sink stage.
+ *
+ * @param[out] sink Sink stage to initialize.
+ * @param[in] enc Initialized telemetry encoder.
+ * @param[in] send Executed with every frame that the sink finishes.
+ * @param[in] send_user_data User data to pass to @p send.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully initialized @p sink.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p sink, @p enc or @p send is NULL.
+ */
+uint8_t bmp280_pipeline_telemetry_sink_init(BMP280PipelineTelemetrySink *const sink, BMP280TelemetryEncoder *const enc,
+                                            BMP280PipelineSendFn send, void *send_user_data);
+
+/**
+ * @brief Finish the current frame of @p sink and send it, if it has records. Call once per flush interval.
+ */
+void bmp280_pipeline_telemetry_sink_flush(BMP280PipelineTelemetrySink *const sink);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_BMP280_PIPELINE_H */
@@ -0,0 +1,147 @@
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "bmp280_poll.h"
+#include "bmp280.h"
+
+uint8_t bmp280_poll_dev_init(BMP280PollDev *const dev, uint32_t now_ms)
+{
+    if (!dev) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    dev->io_requested = false;
+    dev->io_in_progress = false;
+    dev->io_done = false;
+    dev->io_rc = BMP280_IO_RESULT_CODE_ERR;
+    dev->io_cb = NULL;
+    dev->io_cb_user_data = NULL;
+    dev->timer_running = false;
+    dev->timer_deadline_ms = 0;
+    dev->timer_cb = NULL;
+    dev->timer_cb_user_data = NULL;
+    dev->now_ms = now_ms;
+    dev->result_ready = false;
+    dev->result_rc = BMP280_RESULT_CODE_OK;
+    return BMP280_RESULT_CODE_OK;
+}
+
+/**
+ * @brief Check whether the timer deadline has passed.
+ *
+ * The difference is interpreted as signed, so that the comparison works when the ms counter wraps around.
+ */
+static bool is_deadline_passed(uint32_t now_ms, uint32_t deadline_ms)
+{
+    return (int32_t)(now_ms - deadline_ms) >= 0;
+}
+
+uint8_t bmp280_poll(BMP280PollDev *const dev, uint32_t now_ms)
+{
+    dev->now_ms = now_ms;
+
+    bool progress;
+    do {
+        progress = false;
+        if (dev->io_done) {
+            dev->io_done = false;
+            dev->io_in_progress = false;
+            /* Cleared before executing the callback, because the callback can record the next request */
+            BMP280_IOCompleteCb cb = dev->io_cb;
+            dev->io_cb = NULL;
+            if (cb) {
+                cb(dev->io_rc, dev->io_cb_user_data);
+            }
+            progress = true;
+        }
+        if (dev->timer_running && is_deadline_passed(now_ms, dev->timer_deadline_ms)) {
+            dev->timer_running = false;
+            if (dev->timer_cb) {
+                dev->timer_cb(dev->timer_cb_user_data);
+            }
+            progress = true;
+        }
+    } while (progress);
+
+    uint8_t flags = 0;
+    if (dev->io_requested) {
+        flags |= BMP280_POLL_FLAG_IO_REQUEST;
+    }
+    if (dev->io_in_progress) {
+        flags |= BMP280_POLL_FLAG_IO_IN_PROGRESS;
+    }
+    if (dev->timer_running) {
+        flags |= BMP280_POLL_FLAG_TIMER_RUNNING;
+    }
+    if (dev->result_ready) {
+        /* Reported once per completed operation */
+        dev->result_ready = false;
+        flags |= BMP280_POLL_FLAG_RESULT_READY;
+    }
+    return flags;
+}
+
+const BMP280PollIORequest *bmp280_poll_get_io_request(BMP280PollDev *const dev)
+{
+    if (!dev->io_requested) {
+        return NULL;
+    }
+    dev->io_requested = false;
+    dev->io_in_progress = true;
+    return &dev->io_request;
+}
+
+void bmp280_poll_io_done(BMP280PollDev *const dev, uint8_t io_rc)
+{
+    /* rc is written first, bmp280_poll reads it only after it sees io_done */
+    dev->io_rc = io_rc;
+    dev->io_done = true;
+}
+
+uint8_t bmp280_poll_get_result_rc(const BMP280PollDev *const dev)
+{
+    return dev->result_rc;
+}
+
+void bmp280_poll_read_regs(uint8_t start_addr, size_t num_regs, uint8_t *data, void *user_data, BMP280_IOCompleteCb cb,
+                           void *cb_user_data)
+{
+    BMP280PollDev *dev = (BMP280PollDev *)user_data;
+    dev->io_request.reg_addr = start_addr;
+    dev->io_request.is_read = true;
+    dev->io_request.data = data;
+    dev->io_request.len = num_regs;
+    dev->io_request.write_val = 0;
+    dev->io_cb = cb;
+    dev->io_cb_user_data = cb_user_data;
+    dev->io_requested = true;
+}
+
+void bmp280_poll_write_reg(uint8_t addr, uint8_t reg_val, void *user_data, BMP280_IOCompleteCb cb, void *cb_user_data)
+{
+    BMP280PollDev *dev = (BMP280PollDev *)user_data;
+    dev->io_request.reg_addr = addr;
+    dev->io_request.is_read = false;
+    dev->io_request.data = NULL;
+    dev->io_request.len = 1;
+    dev->io_request.write_val = reg_val;
+    dev->io_cb = cb;
+    dev->io_cb_user_data = cb_user_data;
+    dev->io_requested = true;
+}
+
+void bmp280_poll_start_timer(uint32_t duration_ms, void *user_data, BMP280TimerExpiredCb cb, void *cb_user_data)
+{
+    BMP280PollDev *dev = (BMP280PollDev *)user_data;
+    dev->timer_deadline_ms = dev->now_ms + duration_ms + 1;
+    dev->timer_cb = cb;
+    dev->timer_cb_user_data = cb_user_data;
+    dev->timer_running = true;
+}
+
+void bmp280_poll_complete_cb(uint8_t rc, void *user_data)
+{
+    BMP280PollDev *dev = (BMP280PollDev *)user_data;
+    dev->result_rc = rc;
+    dev->result_ready = true;
+}
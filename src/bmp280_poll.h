@@ -0,0 +1,162 @@
+#ifndef SRC_BMP280_POLL_H
+#define SRC_BMP280_POLL_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "bmp280_defs.h"
+
+/**
+ * @brief Polled execution of BMP280 driver sequences for bare-metal superloops.
+ *
+ * The callback-based driver requires IO complete and timer expired callbacks to run in the same execution context as
+ * the driver functions (see README). Without an RTOS, that usually means building an event queue. This module makes the
+ * event queue unnecessary: the driver's callbacks are only ever executed from @ref bmp280_poll, which the superloop
+ * calls on every iteration.
+ *
+ * - Pass @ref bmp280_poll_read_regs, @ref bmp280_poll_write_reg and @ref bmp280_poll_start_timer in BMP280InitCfg,
+ * with a @ref BMP280PollDev as their user data. Pass @ref bmp280_poll_complete_cb with the same @ref BMP280PollDev as
+ * the complete callback of driver operations.
+ * - The driver does not start IO transactions itself. It records them as a request, and @ref bmp280_poll returns
+ * BMP280_POLL_FLAG_IO_REQUEST. The backend takes the request with @ref bmp280_poll_get_io_request, performs it
+ * (blocking, or with DMA/interrupts) and reports completion with @ref bmp280_poll_io_done. @ref bmp280_poll_io_done
+ * only sets flags, so it can be called from an ISR.
+ * - Timers are deadlines that @ref bmp280_poll compares with the current time, no timer callbacks are needed.
+ * - Once the operation is complete, @ref bmp280_poll returns BMP280_POLL_FLAG_RESULT_READY, and @ref
+ * bmp280_poll_get_result_rc returns its result code.
+ */
+
+/** @ref bmp280_poll flag: an IO request is waiting for the backend. */
+#define BMP280_POLL_FLAG_IO_REQUEST 0x01U
+/** @ref bmp280_poll flag: an operation has completed since the previous call, see @ref bmp280_poll_get_result_rc. */
+#define BMP280_POLL_FLAG_RESULT_READY 0x02U
+/** @ref bmp280_poll flag: a timer is running. */
+#define BMP280_POLL_FLAG_TIMER_RUNNING 0x04U
+/** @ref bmp280_poll flag: an IO transaction is being performed by the backend. */
+#define BMP280_POLL_FLAG_IO_IN_PROGRESS 0x08U
+
+/** IO transaction requested by the driver. */
+typedef struct {
+    /** Register address of the first register to read, or the register to write. */
+    uint8_t reg_addr;
+    /** true for register read, false for register write. */
+    bool is_read;
+    /** Register read: buffer to write the register values to. */
+    uint8_t *data;
+    /** Register read: number of registers to read. Register write: always 1. */
+    size_t len;
+    /** Register write: value to write. */
+    uint8_t write_val;
+} BMP280PollIORequest;
+
+/**
+ * @brief Polled execution state of one BMP280 instance.
+ *
+ * Memory is provided by the user. Fields are private, use the functions of this module to access them.
+ */
+typedef struct {
+    BMP280PollIORequest io_request;
+    /** Whether io_request has been recorded, but not taken by the backend yet. */
+    bool io_requested;
+    /** Whether io_request has been taken by the backend and is not complete yet. */
+    bool io_in_progress;
+    /** Set by bmp280_poll_io_done, possibly from an ISR. */
+    volatile bool io_done;
+    volatile uint8_t io_rc;
+    BMP280_IOCompleteCb io_cb;
+    void *io_cb_user_data;
+    bool timer_running;
+    uint32_t timer_deadline_ms;
+    BMP280TimerExpiredCb timer_cb;
+    void *timer_cb_user_data;
+    /** now_ms of the last bmp280_poll call. */
+    uint32_t now_ms;
+    bool result_ready;
+    uint8_t result_rc;
+} BMP280PollDev;
+
+/**
+ * @brief Initialize polled execution state.
+ *
+ * @param[out] dev State to initialize.
+ * @param[in] now_ms Current time in ms. Timers started before the first @ref bmp280_poll call are relative to it.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully initialized @p dev.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p dev is NULL.
+ */
+uint8_t bmp280_poll_dev_init(BMP280PollDev *const dev, uint32_t now_ms);
+
+/**
+ * @brief Advance the driver sequence of @p dev.
+ *
+ * Executes the IO complete callback if the backend has reported completion, and the timer expired callback if the
+ * timer deadline has passed. Repeats until neither is possible, so one call advances the sequence as far as it can go
+ * without the backend.
+ *
+ * @param[in] dev Polled execution state.
+ * @param[in] now_ms Current time in ms, e.g. a millisecond tick counter. Can wrap around.
+ *
+ * @return uint8_t Combination of BMP280_POLL_FLAG_* flags.
+ */
+uint8_t bmp280_poll(BMP280PollDev *const dev, uint32_t now_ms);
+
+/**
+ * @brief Take the IO request of @p dev.
+ *
+ * @param[in] dev Polled execution state.
+ *
+ * @return const BMP280PollIORequest* Request to perform, or NULL if there is no request waiting. The backend must
+ * report its completion with @ref bmp280_poll_io_done.
+ */
+const BMP280PollIORequest *bmp280_poll_get_io_request(BMP280PollDev *const dev);
+
+/**
+ * @brief Report completion of the IO request. Can be called from an ISR.
+ *
+ * @param[in] dev Polled execution state.
+ * @param[in] io_rc Result of the transaction, one of @ref BMP280_IOResultCode.
+ */
+void bmp280_poll_io_done(BMP280PollDev *const dev, uint8_t io_rc);
+
+/**
+ * @brief Result code of the operation that completed last, one of @ref BMP280ResultCode.
+ *
+ * Valid once @ref bmp280_poll has returned BMP280_POLL_FLAG_RESULT_READY.
+ */
+uint8_t bmp280_poll_get_result_rc(const BMP280PollDev *const dev);
+
+/**
+ * @brief Implementation of @ref BMP280ReadRegs. user_data must point to a @ref BMP280PollDev.
+ */
+void bmp280_poll_read_regs(uint8_t start_addr, size_t num_regs, uint8_t *data, void *user_data, BMP280_IOCompleteCb cb,
+                           void *cb_user_data);
+
+/**
+ * @brief Implementation of @ref BMP280WriteReg. user_data must point to a @ref BMP280PollDev.
+ */
+void bmp280_poll_write_reg(uint8_t addr, uint8_t reg_val, void *user_data, BMP280_IOCompleteCb cb, void *cb_user_data);
+
+/**
+ * @brief Implementation of @ref BMP280StartTimer. user_data must point to a @ref BMP280PollDev.
+ *
+ * The deadline is relative to now_ms of the last @ref bmp280_poll call. One ms is added, because a millisecond tick
+ * counter can be up to 1 ms behind real time, and the wait must not be shorter than @p duration_ms.
+ */
+void bmp280_poll_start_timer(uint32_t duration_ms, void *user_data, BMP280TimerExpiredCb cb, void *cb_user_data);
+
+/**
+ * @brief Complete callback for driver operations. user_data must point to a @ref BMP280PollDev.
+ */
+void bmp280_poll_complete_cb(uint8_t rc, void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_BMP280_POLL_H */
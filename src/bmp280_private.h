@@ -9,6 +9,7 @@ extern "C"
 #include <stdint.h>
 
 #include "bmp280_defs.h"
+#include "bmp280_compensate.h"
 
 /* This header should be included only by the user module implementing the BMP280GetInstBuf callback which is a
  * part of InitCfg passed to bmp280_create. All other user modules are not allowed to include this header, because
@@ -19,24 +20,6 @@ extern "C"
  * calibration values occupy 24 registers, and they are read out in one transaction. */
 #define BMP280_READ_BUF_SIZE 24
 
-typedef struct {
-    uint16_t dig_T1;
-    int16_t dig_T2;
-    int16_t dig_T3;
-} CalibTemp;
-
-typedef struct {
-    uint16_t dig_P1;
-    int16_t dig_P2;
-    int16_t dig_P3;
-    int16_t dig_P4;
-    int16_t dig_P5;
-    int16_t dig_P6;
-    int16_t dig_P7;
-    int16_t dig_P8;
-    int16_t dig_P9;
-} CalibPres;
-
 /* Defined in a separate header, so that both bmp280.c and the user module implementing BMP280GetInstBuf callback
  * can include this header. The user module needs to know sizeof(struct BMP280Struct), so that it knows the size of
  * BMP280 instances at compile time. This way, it has an option to allocate a static array with size equal to the
@@ -73,11 +56,30 @@ struct BMP280Struct {
     /** Buffer to use for read reg operations. */
     uint8_t read_buf[BMP280_READ_BUF_SIZE];
     /** Temperature calibration values. Used for converting raw temperature values to DegC. */
-    CalibTemp calib_temp;
+    BMP280CalibTemp calib_temp;
     /** Pressure calibration values. Used for converting raw pressure values to Pa. */
-    CalibPres calib_pres;
+    BMP280CalibPres calib_pres;
+    /** Temperature lookup table, in memory provided by the user. NULL if the lookup table is disabled. */
+    BMP280TempLut *temp_lut;
     /** Whether bmp280_init_meas has been called. */
     bool is_meas_init;
+    /** Whether read_meas_forced_mode is allowed to read out calibration values if is_meas_init is false. */
+    bool lazy_init_meas;
+    /** Number of events that read_meas_forced_mode still waits for before it reads the measurement registers, when it
+     * reads out calibration values during the conversion: timer expiry and calibration readout completion. */
+    uint8_t num_pending_events;
+    /** Result of the calibration readout during the conversion. One of @ref BMP280_IOResultCode. */
+    uint8_t calib_io_rc;
+    /** Whether continuous forced mode is running. */
+    bool is_continuous;
+    /** Whether bmp280_stop_continuous_forced_mode has been called since continuous forced mode was started. */
+    bool stop_requested;
+    /** ctrl_meas value that triggers a forced mode conversion. Read once when continuous forced mode is started. */
+    uint8_t ctrl_meas_forced;
+    /** Callback to execute once continuous forced mode has ended after a stop request. */
+    BMP280CompleteCb stop_cb;
+    /** User data to pass to stop_cb. */
+    void *stop_cb_user_data;
     /** Whether there is currently a sequence in progress. This means that an IO operation or a timer has been started.
      * In that scenario, new sequences should not be started - first, the current sequence needs to finish. */
     bool seq_in_progress;
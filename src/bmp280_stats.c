@@ -0,0 +1,409 @@
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "bmp280_stats.h"
+
+/** Number of copy attempts of a block whose sequence counter changes during the copy, before giving up. */
+#define BMP280_STATS_SNAPSHOT_RETRIES 16
+
+/* Upper bounds of the finite latency buckets, in microseconds and as OpenMetrics le label values */
+static const uint32_t latency_bucket_bounds_us[BMP280_STATS_NUM_LATENCY_BUCKETS] = {
+    1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000,
+};
+static const char *const latency_bucket_labels[BMP280_STATS_NUM_LATENCY_BUCKETS + 1] = {
+    "0.001", "0.0025", "0.005", "0.01", "0.025", "0.05", "0.1", "0.25", "0.5", "1.0", "+Inf",
+};
+
+typedef enum {
+    FAMILY_OPERATIONS = 0,
+    FAMILY_REJECTIONS,
+    FAMILY_LATENCY,
+    FAMILY_BUS_TRANSACTIONS,
+    FAMILY_BUS_BYTES,
+    FAMILY_BUS_BUSY,
+    FAMILY_BUS_ERRORS,
+    FAMILY_EOF,
+    FAMILY_DONE,
+} Family;
+
+static const char *const family_headers[FAMILY_DONE] = {
+    "# TYPE bmp280_operations counter\n# HELP bmp280_operations Completed driver operations.\n",
+    "# TYPE bmp280_rejections counter\n# HELP bmp280_rejections Driver operations rejected on submission.\n",
+    "# TYPE bmp280_operation_latency_seconds histogram\n"
+    "# HELP bmp280_operation_latency_seconds Time from submission to completion of driver operations.\n",
+    "# TYPE bmp280_bus_transactions counter\n# HELP bmp280_bus_transactions Register read and write transactions.\n",
+    "# TYPE bmp280_bus_bytes counter\n# HELP bmp280_bus_bytes Register data bytes transferred.\n",
+    "# TYPE bmp280_bus_busy_seconds counter\n# HELP bmp280_bus_busy_seconds Sum of transaction durations.\n",
+    "# TYPE bmp280_bus_errors counter\n# HELP bmp280_bus_errors Failed transactions.\n",
+    "# EOF\n",
+};
+
+static void write_begin(volatile uint32_t *seq)
+{
+    *seq = *seq + 1;
+    BMP280_STATS_MEMORY_BARRIER();
+}
+
+static void write_end(volatile uint32_t *seq)
+{
+    BMP280_STATS_MEMORY_BARRIER();
+    *seq = *seq + 1;
+}
+
+static uint8_t snapshot(const volatile uint32_t *seq, const void *src, void *dst, size_t size)
+{
+    for (size_t i = 0; i < BMP280_STATS_SNAPSHOT_RETRIES; i++) {
+        uint32_t before = *seq;
+        BMP280_STATS_MEMORY_BARRIER();
+        memcpy(dst, src, size);
+        BMP280_STATS_MEMORY_BARRIER();
+        if (!(before & 1U) && (*seq == before)) {
+            return BMP280_RESULT_CODE_OK;
+        }
+    }
+    return BMP280_RESULT_CODE_BUSY;
+}
+
+uint8_t bmp280_stats_bus_init(BMP280BusStats *const bus, uint32_t bus_id)
+{
+    if (!bus) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    memset(bus, 0, sizeof(*bus));
+    bus->bus_id = bus_id;
+    return BMP280_RESULT_CODE_OK;
+}
+
+uint8_t bmp280_stats_sensor_init(BMP280SensorStats *const stats, const BMP280SensorStatsCfg *const cfg)
+{
+    if (!stats || !cfg || !cfg->bus || !cfg->now_us || !cfg->read_regs || !cfg->write_reg) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    stats->cfg = *cfg;
+    return BMP280_RESULT_CODE_OK;
+}
+
+static uint32_t now_us(const BMP280SensorStats *const stats)
+{
+    return stats->cfg.now_us(stats->cfg.now_us_user_data);
+}
+
+static void io_complete_cb(uint8_t io_rc, void *user_data)
+{
+    BMP280SensorStats *stats = (BMP280SensorStats *)user_data;
+    uint32_t duration_us = now_us(stats) - stats->io_start_us;
+    BMP280BusStats *bus = stats->cfg.bus;
+
+    write_begin(&bus->seq);
+    bus->counters.transactions++;
+    bus->counters.bytes += stats->io_bytes;
+    bus->counters.busy_us += duration_us;
+    if (io_rc != BMP280_IO_RESULT_CODE_OK) {
+        bus->counters.errors++;
+    }
+    write_end(&bus->seq);
+
+    stats->io_cb(io_rc, stats->io_cb_user_data);
+}
+
+void bmp280_stats_read_regs(uint8_t start_addr, size_t num_regs, uint8_t *data, void *user_data,
+                            BMP280_IOCompleteCb cb, void *cb_user_data)
+{
+    BMP280SensorStats *stats = (BMP280SensorStats *)user_data;
+    stats->io_cb = cb;
+    stats->io_cb_user_data = cb_user_data;
+    stats->io_bytes = num_regs;
+    stats->io_start_us = now_us(stats);
+    stats->cfg.read_regs(start_addr, num_regs, data, stats->cfg.read_regs_user_data, io_complete_cb, (void *)stats);
+}
+
+void bmp280_stats_write_reg(uint8_t addr, uint8_t reg_val, void *user_data, BMP280_IOCompleteCb cb,
+                            void *cb_user_data)
+{
+    BMP280SensorStats *stats = (BMP280SensorStats *)user_data;
+    stats->io_cb = cb;
+    stats->io_cb_user_data = cb_user_data;
+    stats->io_bytes = 1;
+    stats->io_start_us = now_us(stats);
+    stats->cfg.write_reg(addr, reg_val, stats->cfg.write_reg_user_data, io_complete_cb, (void *)stats);
+}
+
+static void *op_prepare(BMP280SensorStats *const stats, BMP280CompleteCb cb, void *user_data, bool continuous)
+{
+    bmp280_op_track_prepare(&stats->op, cb, user_data, continuous, now_us(stats));
+    return (void *)stats;
+}
+
+void *bmp280_stats_op_prepare(BMP280SensorStats *const stats, BMP280CompleteCb cb, void *user_data)
+{
+    return op_prepare(stats, cb, user_data, false);
+}
+
+uint8_t bmp280_stats_op_submitted(BMP280SensorStats *const stats, uint8_t rc)
+{
+    bmp280_op_track_submitted(&stats->op, rc);
+    if (rc != BMP280_RESULT_CODE_OK) {
+        write_begin(&stats->seq);
+        if (rc == BMP280_RESULT_CODE_BUSY) {
+            stats->counters.rejected_busy++;
+        } else {
+            stats->counters.rejected_other++;
+        }
+        write_end(&stats->seq);
+    }
+    return rc;
+}
+
+static size_t latency_bucket(uint32_t latency_us)
+{
+    size_t i = 0;
+    while (i < BMP280_STATS_NUM_LATENCY_BUCKETS && latency_us > latency_bucket_bounds_us[i]) {
+        i++;
+    }
+    return i;
+}
+
+void bmp280_stats_complete_cb(uint8_t rc, void *user_data)
+{
+    BMP280SensorStats *stats = (BMP280SensorStats *)user_data;
+    uint32_t now = now_us(stats);
+    uint32_t latency_us = now - (uint32_t)bmp280_op_track_complete(&stats->op, rc, now);
+
+    write_begin(&stats->seq);
+    if (rc == BMP280_RESULT_CODE_OK) {
+        stats->counters.ops_ok++;
+    } else if (rc == BMP280_RESULT_CODE_IO_ERR) {
+        stats->counters.ops_io_err++;
+    } else {
+        stats->counters.ops_other_err++;
+    }
+    stats->counters.latency_buckets[latency_bucket(latency_us)]++;
+    stats->counters.latency_sum_us += latency_us;
+    write_end(&stats->seq);
+
+    bmp280_op_track_execute_cb(&stats->op, rc);
+}
+
+uint8_t bmp280_stats_read_meas_forced_mode(BMP280 self, BMP280SensorStats *const stats, uint8_t meas_type,
+                                           uint32_t meas_time_ms, BMP280Meas *const meas, BMP280CompleteCb cb,
+                                           void *user_data)
+{
+    if (!stats) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    void *stats_user_data = bmp280_stats_op_prepare(stats, cb, user_data);
+    return bmp280_stats_op_submitted(stats, bmp280_read_meas_forced_mode(self, meas_type, meas_time_ms, meas,
+                                                                         bmp280_stats_complete_cb, stats_user_data));
+}
+
+uint8_t bmp280_stats_start_continuous_forced_mode(BMP280 self, BMP280SensorStats *const stats, uint8_t meas_type,
+                                                  uint32_t meas_time_ms, BMP280Meas *const meas, BMP280CompleteCb cb,
+                                                  void *user_data)
+{
+    if (!stats) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    void *stats_user_data = op_prepare(stats, cb, user_data, true);
+    return bmp280_stats_op_submitted(stats, bmp280_start_continuous_forced_mode(self, meas_type, meas_time_ms, meas,
+                                                                                bmp280_stats_complete_cb,
+                                                                                stats_user_data));
+}
+
+uint8_t bmp280_stats_stop_continuous_forced_mode(BMP280 self, BMP280SensorStats *const stats, BMP280CompleteCb cb,
+                                                 void *user_data)
+{
+    if (!stats) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    return bmp280_op_track_stop(self, &stats->op, cb, user_data);
+}
+
+uint8_t bmp280_stats_sensor_snapshot(const BMP280SensorStats *const stats, BMP280SensorCounters *const counters)
+{
+    return snapshot(&stats->seq, &stats->counters, counters, sizeof(*counters));
+}
+
+uint8_t bmp280_stats_bus_snapshot(const BMP280BusStats *const bus, BMP280BusCounters *const counters)
+{
+    return snapshot(&bus->seq, &bus->counters, counters, sizeof(*counters));
+}
+
+void bmp280_stats_writer_init(BMP280StatsWriter *const writer, const BMP280StatsRegistry *const registry)
+{
+    writer->registry = registry;
+    writer->family = FAMILY_OPERATIONS;
+    writer->idx = 0;
+    writer->num_skipped = 0;
+}
+
+static char *put_str(char *p, const char *s)
+{
+    while (*s) {
+        *p++ = *s++;
+    }
+    return p;
+}
+
+static char *put_u64(char *p, uint64_t val)
+{
+    char digits[20];
+    size_t num_digits = 0;
+    do {
+        digits[num_digits++] = (char)('0' + (val % 10));
+        val /= 10;
+    } while (val);
+    while (num_digits) {
+        *p++ = digits[--num_digits];
+    }
+    return p;
+}
+
+/** Write microseconds as seconds with 6 decimal places. */
+static char *put_seconds(char *p, uint64_t us)
+{
+    p = put_u64(p, us / 1000000U);
+    *p++ = '.';
+    uint32_t frac = (uint32_t)(us % 1000000U);
+    for (uint32_t div = 100000; div; div /= 10) {
+        *p++ = (char)('0' + (frac / div) % 10);
+    }
+    return p;
+}
+
+/** Write the metric name and labels of a sample, up to and including the space before the value. */
+static char *put_sample_start(char *p, const char *name, const char *id_label, uint32_t id, const char *label,
+                              const char *label_val)
+{
+    p = put_str(p, name);
+    *p++ = '{';
+    p = put_str(p, id_label);
+    p = put_str(p, "=\"");
+    p = put_u64(p, id);
+    *p++ = '"';
+    if (label) {
+        *p++ = ',';
+        p = put_str(p, label);
+        p = put_str(p, "=\"");
+        p = put_str(p, label_val);
+        *p++ = '"';
+    }
+    p = put_str(p, "} ");
+    return p;
+}
+
+static char *put_sensor_sample(char *p, const char *name, uint32_t sensor_id, const char *label,
+                               const char *label_val, uint64_t val)
+{
+    p = put_sample_start(p, name, "sensor", sensor_id, label, label_val);
+    p = put_u64(p, val);
+    *p++ = '\n';
+    return p;
+}
+
+static char *put_sensor(char *p, Family family, uint32_t id, const BMP280SensorCounters *const c)
+{
+    if (family == FAMILY_OPERATIONS) {
+        p = put_sensor_sample(p, "bmp280_operations_total", id, "result", "ok", c->ops_ok);
+        p = put_sensor_sample(p, "bmp280_operations_total", id, "result", "io_err", c->ops_io_err);
+        p = put_sensor_sample(p, "bmp280_operations_total", id, "result", "other_err", c->ops_other_err);
+    } else if (family == FAMILY_REJECTIONS) {
+        p = put_sensor_sample(p, "bmp280_rejections_total", id, "reason", "busy", c->rejected_busy);
+        p = put_sensor_sample(p, "bmp280_rejections_total", id, "reason", "other", c->rejected_other);
+    } else {
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i <= BMP280_STATS_NUM_LATENCY_BUCKETS; i++) {
+            cumulative += c->latency_buckets[i];
+            p = put_sensor_sample(p, "bmp280_operation_latency_seconds_bucket", id, "le", latency_bucket_labels[i],
+                                  cumulative);
+        }
+        p = put_sensor_sample(p, "bmp280_operation_latency_seconds_count", id, NULL, NULL, cumulative);
+        p = put_sample_start(p, "bmp280_operation_latency_seconds_sum", "sensor", id, NULL, NULL);
+        p = put_seconds(p, c->latency_sum_us);
+        *p++ = '\n';
+    }
+    return p;
+}
+
+static char *put_bus(char *p, Family family, uint32_t id, const BMP280BusCounters *const c)
+{
+    if (family == FAMILY_BUS_BUSY) {
+        p = put_sample_start(p, "bmp280_bus_busy_seconds_total", "bus", id, NULL, NULL);
+        p = put_seconds(p, c->busy_us);
+        *p++ = '\n';
+        return p;
+    }
+    const char *name = "bmp280_bus_errors_total";
+    uint64_t val = c->errors;
+    if (family == FAMILY_BUS_TRANSACTIONS) {
+        name = "bmp280_bus_transactions_total";
+        val = c->transactions;
+    } else if (family == FAMILY_BUS_BYTES) {
+        name = "bmp280_bus_bytes_total";
+        val = c->bytes;
+    }
+    p = put_sample_start(p, name, "bus", id, NULL, NULL);
+    p = put_u64(p, val);
+    *p++ = '\n';
+    return p;
+}
+
+size_t bmp280_stats_serialize(BMP280StatsWriter *const writer, char *const buf, size_t size)
+{
+    const BMP280StatsRegistry *reg = writer->registry;
+    char *p = buf;
+    char *const end = buf + size;
+
+    while (writer->family != FAMILY_DONE && (size_t)(end - p) >= BMP280_STATS_MAX_ITEM_LEN) {
+        Family family = (Family)writer->family;
+        /* idx 0 is the family header, idx i > 0 is sensor or bus i - 1 */
+        if (writer->idx == 0) {
+            p = put_str(p, family_headers[family]);
+            writer->idx++;
+            if (family == FAMILY_EOF) {
+                writer->family = FAMILY_DONE;
+            }
+            continue;
+        }
+
+        bool is_sensor_family = (family <= FAMILY_LATENCY);
+        size_t num_items = is_sensor_family ? reg->num_sensors : reg->num_buses;
+        if (writer->idx > num_items) {
+            writer->family++;
+            writer->idx = 0;
+            continue;
+        }
+        size_t i = writer->idx - 1;
+        /* Copy every sensor and bus in its first family, the other families are written from the same copy. A sensor
+         * or bus that is updated too often to copy is left out of all families, rather than written from a torn
+         * copy. */
+        if (is_sensor_family) {
+            BMP280SensorSnapshot *snap = &reg->sensor_snapshots[i];
+            if (family == FAMILY_OPERATIONS) {
+                snap->valid = (bmp280_stats_sensor_snapshot(&reg->sensors[i], &snap->counters) ==
+                               BMP280_RESULT_CODE_OK);
+                writer->num_skipped += snap->valid ? 0 : 1;
+            }
+            if (snap->valid) {
+                p = put_sensor(p, family, reg->sensors[i].cfg.sensor_id, &snap->counters);
+            }
+        } else {
+            BMP280BusSnapshot *snap = &reg->bus_snapshots[i];
+            if (family == FAMILY_BUS_TRANSACTIONS) {
+                snap->valid = (bmp280_stats_bus_snapshot(&reg->buses[i], &snap->counters) == BMP280_RESULT_CODE_OK);
+                writer->num_skipped += snap->valid ? 0 : 1;
+            }
+            if (snap->valid) {
+                p = put_bus(p, family, reg->buses[i].bus_id, &snap->counters);
+            }
+        }
+        writer->idx++;
+    }
+    return (size_t)(p - buf);
+}
@@ -0,0 +1,277 @@
+#ifndef SRC_BMP280_STATS_H
+#define SRC_BMP280_STATS_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "bmp280.h"
+#include "bmp280_op_track.h"
+
+/**
+ * @brief Runtime statistics of driver operations and bus transactions, serialized in the OpenMetrics text format.
+ *
+ * Per sensor: completed operations by result, rejected operations (BUSY and other), operation latency histogram.
+ * Per bus: transactions, data bytes, bus busy time (sum of transaction durations) and failed transactions.
+ *
+ * - Bus statistics are collected by interposing @ref bmp280_stats_read_regs and @ref bmp280_stats_write_reg between the
+ * driver and the real register access functions.
+ * - Operation statistics are collected by passing @ref bmp280_stats_complete_cb as the complete callback, with the
+ * user data returned by @ref bmp280_stats_op_prepare, and passing the return code of the driver function to @ref
+ * bmp280_stats_op_submitted. @ref bmp280_stats_read_meas_forced_mode does all of that. In continuous forced mode,
+ * started with @ref bmp280_stats_start_continuous_forced_mode, every sample counts as one operation, with the time
+ * since the previous sample as latency.
+ *
+ * Counters are written only from the acquisition context (the execution context of the driver), and never wait for
+ * the exporter. Each @ref BMP280SensorStats and @ref BMP280BusStats is protected by a sequence counter: the writer
+ * makes it odd while updating, and @ref bmp280_stats_serialize, which may run in another thread, retries its copy of a
+ * block whose sequence counter changed. Serialization therefore costs the acquisition context nothing but the two
+ * sequence counter increments per update.
+ */
+
+/** Number of finite latency histogram buckets. */
+#define BMP280_STATS_NUM_LATENCY_BUCKETS 10
+
+/** Maximum length of the serialized lines of one sensor or bus in one metric family. */
+#define BMP280_STATS_MAX_ITEM_LEN 1536
+
+/**
+ * @brief Memory barrier between sequence counter updates and counter updates.
+ *
+ * Defaults to a full barrier of GCC and Clang. On a single-core MCU, a compiler barrier is enough.
+ */
+#ifndef BMP280_STATS_MEMORY_BARRIER
+#define BMP280_STATS_MEMORY_BARRIER() __sync_synchronize()
+#endif
+
+/**
+ * @brief Get current time in microseconds. Can wrap around.
+ */
+typedef uint32_t (*BMP280StatsNowUs)(void *user_data);
+
+typedef struct {
+    uint64_t ops_ok;
+    uint64_t ops_io_err;
+    /** Completed with a result code other than OK and IO_ERR. */
+    uint64_t ops_other_err;
+    uint64_t rejected_busy;
+    uint64_t rejected_other;
+    /** Operations per latency bucket, not cumulative. The last bucket is +Inf. */
+    uint64_t latency_buckets[BMP280_STATS_NUM_LATENCY_BUCKETS + 1];
+    uint64_t latency_sum_us;
+} BMP280SensorCounters;
+
+typedef struct {
+    uint64_t transactions;
+    uint64_t bytes;
+    uint64_t busy_us;
+    uint64_t errors;
+} BMP280BusCounters;
+
+/** Statistics of one bus. Memory is provided by the user. */
+typedef struct {
+    volatile uint32_t seq;
+    BMP280BusCounters counters;
+    /** Value of the bus label. */
+    uint32_t bus_id;
+} BMP280BusStats;
+
+/** Configuration of a @ref BMP280SensorStats. */
+typedef struct {
+    /** Value of the sensor label. */
+    uint32_t sensor_id;
+    /** Bus that the sensor is on. */
+    BMP280BusStats *bus;
+    BMP280StatsNowUs now_us;
+    void *now_us_user_data;
+    /** Register access functions that @ref bmp280_stats_read_regs and @ref bmp280_stats_write_reg forward to. */
+    BMP280ReadRegs read_regs;
+    void *read_regs_user_data;
+    BMP280WriteReg write_reg;
+    void *write_reg_user_data;
+} BMP280SensorStatsCfg;
+
+/**
+ * @brief Statistics of one sensor. Memory is provided by the user.
+ *
+ * Fields other than seq and counters are private.
+ */
+typedef struct {
+    volatile uint32_t seq;
+    BMP280SensorCounters counters;
+    BMP280SensorStatsCfg cfg;
+    BMP280OpTrack op;
+    uint32_t io_start_us;
+    size_t io_bytes;
+    BMP280_IOCompleteCb io_cb;
+    void *io_cb_user_data;
+} BMP280SensorStats;
+
+/** Counters of one sensor, copied once per serialization. */
+typedef struct {
+    BMP280SensorCounters counters;
+    /** false if the counters could not be copied consistently. */
+    bool valid;
+} BMP280SensorSnapshot;
+
+/** Counters of one bus, copied once per serialization. */
+typedef struct {
+    BMP280BusCounters counters;
+    /** false if the counters could not be copied consistently. */
+    bool valid;
+} BMP280BusSnapshot;
+
+/**
+ * @brief Statistics to serialize.
+ *
+ * Every sensor and bus is copied once per serialization, and all its metric families are written from that copy, so
+ * that e.g. the operations total and the latency histogram count of a sensor agree. The copies are kept in
+ * sensor_snapshots and bus_snapshots, which are provided by the user. Only one serialization of a registry can be in
+ * progress at a time.
+ */
+typedef struct {
+    const BMP280SensorStats *sensors;
+    size_t num_sensors;
+    const BMP280BusStats *buses;
+    size_t num_buses;
+    /** Memory for num_sensors copies. */
+    BMP280SensorSnapshot *sensor_snapshots;
+    /** Memory for num_buses copies. */
+    BMP280BusSnapshot *bus_snapshots;
+} BMP280StatsRegistry;
+
+/** State of an incremental serialization. Fields other than num_skipped are private. */
+typedef struct {
+    const BMP280StatsRegistry *registry;
+    size_t family;
+    size_t idx;
+    /** Number of sensors and buses left out because their counters could not be copied consistently. */
+    size_t num_skipped;
+} BMP280StatsWriter;
+
+/**
+ * @brief Initialize statistics of a bus.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully initialized @p bus.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p bus is NULL.
+ */
+uint8_t bmp280_stats_bus_init(BMP280BusStats *const bus, uint32_t bus_id);
+
+/**
+ * @brief Initialize statistics of a sensor.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully initialized @p stats.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p stats or @p cfg is NULL, or a function or the bus in @p cfg is NULL.
+ */
+uint8_t bmp280_stats_sensor_init(BMP280SensorStats *const stats, const BMP280SensorStatsCfg *const cfg);
+
+/**
+ * @brief Implementation of @ref BMP280ReadRegs. user_data must point to a @ref BMP280SensorStats.
+ */
+void bmp280_stats_read_regs(uint8_t start_addr, size_t num_regs, uint8_t *data, void *user_data,
+                            BMP280_IOCompleteCb cb, void *cb_user_data);
+
+/**
+ * @brief Implementation of @ref BMP280WriteReg. user_data must point to a @ref BMP280SensorStats.
+ */
+void bmp280_stats_write_reg(uint8_t addr, uint8_t reg_val, void *user_data, BMP280_IOCompleteCb cb,
+                            void *cb_user_data);
+
+/**
+ * @brief Start tracking an operation that is about to be submitted.
+ *
+ * @p cb is only stored once @ref bmp280_stats_op_submitted sees that the driver accepted the operation. If an
+ * operation of this sensor is already in progress, the new one will be rejected with BUSY by the driver, and the
+ * operation in progress keeps its callback.
+ *
+ * @param[in] stats Statistics of the sensor.
+ * @param[in] cb Complete callback of the operation, executed by @ref bmp280_stats_complete_cb.
+ * @param[in] user_data User data to pass to @p cb.
+ *
+ * @return void* @p stats, to pass as user data together with @ref bmp280_stats_complete_cb.
+ */
+void *bmp280_stats_op_prepare(BMP280SensorStats *const stats, BMP280CompleteCb cb, void *user_data);
+
+/**
+ * @brief Record the return code of the driver function that the operation was submitted with.
+ *
+ * @return uint8_t @p rc, so that the call can wrap the driver function call.
+ */
+uint8_t bmp280_stats_op_submitted(BMP280SensorStats *const stats, uint8_t rc);
+
+/**
+ * @brief Complete callback that records the operation and executes the callback passed to @ref
+ * bmp280_stats_op_prepare. user_data must point to a @ref BMP280SensorStats.
+ */
+void bmp280_stats_complete_cb(uint8_t rc, void *user_data);
+
+/**
+ * @brief @ref bmp280_read_meas_forced_mode with operation statistics.
+ */
+uint8_t bmp280_stats_read_meas_forced_mode(BMP280 self, BMP280SensorStats *const stats, uint8_t meas_type,
+                                           uint32_t meas_time_ms, BMP280Meas *const meas, BMP280CompleteCb cb,
+                                           void *user_data);
+
+/**
+ * @brief @ref bmp280_start_continuous_forced_mode with operation statistics.
+ *
+ * The session is tracked as one operation in progress until it ends, with every sample counted as a completed
+ * operation. Stop it with @ref bmp280_stats_stop_continuous_forced_mode.
+ */
+uint8_t bmp280_stats_start_continuous_forced_mode(BMP280 self, BMP280SensorStats *const stats, uint8_t meas_type,
+                                                  uint32_t meas_time_ms, BMP280Meas *const meas, BMP280CompleteCb cb,
+                                                  void *user_data);
+
+/**
+ * @brief @ref bmp280_stop_continuous_forced_mode for a session started with @ref
+ * bmp280_stats_start_continuous_forced_mode. The session stops being tracked before @p cb is executed.
+ */
+uint8_t bmp280_stats_stop_continuous_forced_mode(BMP280 self, BMP280SensorStats *const stats, BMP280CompleteCb cb,
+                                                 void *user_data);
+
+/**
+ * @brief Copy consistent counters of a sensor. Can be called from any thread.
+ *
+ * @retval BMP280_RESULT_CODE_OK @p counters holds a consistent copy.
+ * @retval BMP280_RESULT_CODE_BUSY Every copy raced with an update. The contents of @p counters are undefined.
+ */
+uint8_t bmp280_stats_sensor_snapshot(const BMP280SensorStats *const stats, BMP280SensorCounters *const counters);
+
+/**
+ * @brief Copy consistent counters of a bus. Can be called from any thread.
+ *
+ * @retval BMP280_RESULT_CODE_OK @p counters holds a consistent copy.
+ * @retval BMP280_RESULT_CODE_BUSY Every copy raced with an update. The contents of @p counters are undefined.
+ */
+uint8_t bmp280_stats_bus_snapshot(const BMP280BusStats *const bus, BMP280BusCounters *const counters);
+
+/**
+ * @brief Start serializing @p registry.
+ */
+void bmp280_stats_writer_init(BMP280StatsWriter *const writer, const BMP280StatsRegistry *const registry);
+
+/**
+ * @brief Serialize the next part of the OpenMetrics exposition.
+ *
+ * Writes the lines of as many sensors and buses as fit into @p buf. Call repeatedly until it returns 0. The output ends
+ * with "# EOF\n". Output is not NUL-terminated. The samples of a sensor or bus whose counters can not be copied
+ * consistently are left out of every family, and counted once in num_skipped of @p writer.
+ *
+ * @param[in] writer Serialization state.
+ * @param[out] buf Buffer to write to.
+ * @param[in] size Size of @p buf, at least BMP280_STATS_MAX_ITEM_LEN.
+ *
+ * @return size_t Number of bytes written. 0 once the whole exposition has been written.
+ */
+size_t bmp280_stats_serialize(BMP280StatsWriter *const writer, char *const buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_BMP280_STATS_H */
@@ -0,0 +1,123 @@
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "bmp280_table.h"
+/* The table copies calibration values out of instances */
+#include "bmp280_private.h"
+
+uint8_t bmp280_table_init(BMP280Table *const table, const BMP280TableArrays *const arrays)
+{
+    if (!table || !arrays) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    if (!arrays->insts || !arrays->state || !arrays->next_due_ms || !arrays->period_ms || !arrays->calib_temp ||
+        !arrays->calib_pres || !arrays->temp_raw || !arrays->pres_raw || arrays->capacity == 0) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    table->arrays = *arrays;
+    table->num = 0;
+    return BMP280_RESULT_CODE_OK;
+}
+
+uint8_t bmp280_table_add(BMP280Table *const table, BMP280 inst, uint32_t period_ms, uint32_t now_ms,
+                         size_t *const idx)
+{
+    if (!table || !inst || period_ms == 0) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    if (!inst->is_meas_init) {
+        return BMP280_RESULT_CODE_INVAL_USAGE;
+    }
+    if (table->num == table->arrays.capacity) {
+        return BMP280_RESULT_CODE_NO_MEM;
+    }
+
+    size_t i = table->num;
+    BMP280TableArrays *a = &table->arrays;
+    a->insts[i] = inst;
+    a->state[i] = 0;
+    a->next_due_ms[i] = now_ms;
+    a->period_ms[i] = period_ms;
+    a->calib_temp[i] = inst->calib_temp;
+    a->calib_pres[i] = inst->calib_pres;
+    a->temp_raw[i] = 0;
+    a->pres_raw[i] = 0;
+    table->num++;
+    if (idx) {
+        *idx = i;
+    }
+    return BMP280_RESULT_CODE_OK;
+}
+
+size_t bmp280_table_num(const BMP280Table *const table)
+{
+    return table->num;
+}
+
+BMP280 bmp280_table_inst(const BMP280Table *const table, size_t idx)
+{
+    return table->arrays.insts[idx];
+}
+
+size_t bmp280_table_collect_due(BMP280Table *const table, uint32_t now_ms, size_t *const idxs, size_t max_idxs)
+{
+    const size_t num = table->num;
+    uint8_t *const state = table->arrays.state;
+    uint32_t *const next_due_ms = table->arrays.next_due_ms;
+    size_t num_due = 0;
+
+    for (size_t i = 0; i < num && num_due < max_idxs; i++) {
+        /* The difference is interpreted as signed, so that the comparison works when the ms counter wraps around */
+        if ((state[i] & BMP280_TABLE_FLAG_BUSY) || (int32_t)(now_ms - next_due_ms[i]) < 0) {
+            continue;
+        }
+        uint32_t period_ms = table->arrays.period_ms[i];
+        uint32_t next = next_due_ms[i] + period_ms;
+        next_due_ms[i] = ((int32_t)(now_ms - next) >= 0) ? now_ms + period_ms : next;
+        state[i] |= BMP280_TABLE_FLAG_BUSY;
+        idxs[num_due++] = i;
+    }
+    return num_due;
+}
+
+void bmp280_table_set_frame(BMP280Table *const table, size_t idx, const uint8_t *const frame)
+{
+    /* Frame layout is press_msb, press_lsb, press_xlsb, temp_msb, temp_lsb, temp_xlsb */
+    table->arrays.pres_raw[idx] = bmp280_raw_val_from_regs(&frame[0]);
+    table->arrays.temp_raw[idx] = bmp280_raw_val_from_regs(&frame[3]);
+    table->arrays.state[idx] = (uint8_t)((table->arrays.state[idx] & ~BMP280_TABLE_FLAG_BUSY) |
+                                         BMP280_TABLE_FLAG_NEW_FRAME);
+}
+
+void bmp280_table_read_done(BMP280Table *const table, size_t idx, uint8_t rc)
+{
+    uint8_t state = (uint8_t)(table->arrays.state[idx] & ~BMP280_TABLE_FLAG_BUSY);
+    if (rc == BMP280_RESULT_CODE_OK) {
+        /* The driver has already compensated the measurement */
+        state |= BMP280_TABLE_FLAG_NEW_MEAS;
+    }
+    table->arrays.state[idx] = state;
+}
+
+size_t bmp280_table_compensate(BMP280Table *const table, BMP280Meas *const meas)
+{
+    const size_t num = table->num;
+    const BMP280TableArrays *const a = &table->arrays;
+    size_t num_new = 0;
+
+    for (size_t i = 0; i < num; i++) {
+        uint8_t state = a->state[i];
+        if (!(state & (BMP280_TABLE_FLAG_NEW_FRAME | BMP280_TABLE_FLAG_NEW_MEAS))) {
+            continue;
+        }
+        if (state & BMP280_TABLE_FLAG_NEW_FRAME) {
+            int32_t t_fine;
+            meas[i].temperature = bmp280_compensate_temp(&a->calib_temp[i], a->temp_raw[i], &t_fine);
+            meas[i].pressure = bmp280_compensate_pres(&a->calib_pres[i], a->pres_raw[i], t_fine);
+        }
+        a->state[i] = (uint8_t)(state & ~(BMP280_TABLE_FLAG_NEW_FRAME | BMP280_TABLE_FLAG_NEW_MEAS));
+        num_new++;
+    }
+    return num_new;
+}
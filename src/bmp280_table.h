@@ -0,0 +1,160 @@
+#ifndef SRC_BMP280_TABLE_H
+#define SRC_BMP280_TABLE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "bmp280.h"
+#include "bmp280_compensate.h"
+
+/**
+ * @brief Instance table for schedulers that drive thousands of BMP280 instances.
+ *
+ * Instances are opaque and live wherever get_inst_buf put them, so a scheduler that asks every instance whether it is
+ * due touches at least one cache line per sensor. The table keeps the data that schedulers and compensation sweep over
+ * in structure-of-arrays form, one packed array per field:
+ *
+ * - state: BMP280_TABLE_FLAG_* flags, 1 byte per sensor.
+ * - next_due_ms and period_ms: sampling schedule.
+ * - calib_temp and calib_pres: calibration values, copied from the instance when it is added.
+ * - temp_raw and pres_raw: the last raw frame reported with @ref bmp280_table_set_frame.
+ *
+ * @ref bmp280_table_collect_due is a linear sweep over state and next_due_ms, and @ref bmp280_table_compensate is a
+ * linear sweep over state, the calibration values and the raw frames. The instance itself is only touched when a
+ * measurement is started.
+ *
+ * Usage: add instances with @ref bmp280_table_add after @ref bmp280_init_meas has completed. In every scheduler tick,
+ * call @ref bmp280_table_collect_due and start a @ref bmp280_read_meas_forced_mode for every returned index idx, with
+ * element idx of the measurement array that is later passed to @ref bmp280_table_compensate. From the complete
+ * callback, call @ref bmp280_table_read_done. Then call @ref bmp280_table_compensate once per tick to collect all new
+ * measurements. The driver has already compensated those. A backend that reads the data registers itself reports
+ * frames with @ref bmp280_table_set_frame instead, and @ref bmp280_table_compensate compensates them in one sweep.
+ */
+
+/** State flag: a measurement has been started and has not been reported as done yet. */
+#define BMP280_TABLE_FLAG_BUSY 0x01U
+/** State flag: a raw frame has been stored and has not been compensated yet. */
+#define BMP280_TABLE_FLAG_NEW_FRAME 0x02U
+/** State flag: the driver has completed a measurement that has not been collected yet. */
+#define BMP280_TABLE_FLAG_NEW_MEAS 0x04U
+
+/** Packed arrays of a @ref BMP280Table. Memory is provided by the user, every array has capacity elements. */
+typedef struct {
+    BMP280 *insts;
+    uint8_t *state;
+    uint32_t *next_due_ms;
+    uint32_t *period_ms;
+    BMP280CalibTemp *calib_temp;
+    BMP280CalibPres *calib_pres;
+    int32_t *temp_raw;
+    int32_t *pres_raw;
+    size_t capacity;
+} BMP280TableArrays;
+
+/** Instance table. Fields are private, use the functions of this module to access them. */
+typedef struct {
+    BMP280TableArrays arrays;
+    /** Number of instances in the table. They occupy indexes 0...num - 1. */
+    size_t num;
+} BMP280Table;
+
+/**
+ * @brief Initialize an empty instance table.
+ *
+ * @param[out] table Table to initialize.
+ * @param[in] arrays Arrays to store the instance data in. Copied into @p table.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully initialized @p table.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p table or @p arrays is NULL, an array is NULL, or capacity is 0.
+ */
+uint8_t bmp280_table_init(BMP280Table *const table, const BMP280TableArrays *const arrays);
+
+/**
+ * @brief Add an instance to the table.
+ *
+ * Calibration values are copied from @p inst, so @ref bmp280_init_meas must have completed. The instance is due for
+ * the first time at @p now_ms, and then every @p period_ms.
+ *
+ * @param[in] table Instance table.
+ * @param[in] inst Instance to add.
+ * @param[in] period_ms Sampling period in ms. Must be greater than 0.
+ * @param[in] now_ms Current time in ms. Can wrap around.
+ * @param[out] idx Index of the instance in the table is written to this parameter. Can be NULL.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully added @p inst.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p table or @p inst is NULL, or @p period_ms is 0.
+ * @retval BMP280_RESULT_CODE_INVAL_USAGE Calibration values of @p inst have not been read out yet.
+ * @retval BMP280_RESULT_CODE_NO_MEM The table is full.
+ */
+uint8_t bmp280_table_add(BMP280Table *const table, BMP280 inst, uint32_t period_ms, uint32_t now_ms,
+                         size_t *const idx);
+
+/**
+ * @brief Number of instances in the table.
+ */
+size_t bmp280_table_num(const BMP280Table *const table);
+
+/**
+ * @brief Instance at @p idx.
+ */
+BMP280 bmp280_table_inst(const BMP280Table *const table, size_t idx);
+
+/**
+ * @brief Collect the indexes of instances that are due at @p now_ms.
+ *
+ * An instance is due if it is not busy and its next due time has passed. Collected instances are marked busy, and
+ * their next due time is advanced by their period. If an instance has fallen behind by more than one period, its next
+ * due time is restarted from @p now_ms instead of collecting it several times in a row.
+ *
+ * @param[in] table Instance table.
+ * @param[in] now_ms Current time in ms. Can wrap around.
+ * @param[out] idxs Indexes of due instances are written to this parameter, in ascending order.
+ * @param[in] max_idxs Number of elements in @p idxs. Instances that do not fit stay due until the next call.
+ *
+ * @return size_t Number of indexes written to @p idxs.
+ */
+size_t bmp280_table_collect_due(BMP280Table *const table, uint32_t now_ms, size_t *const idxs, size_t max_idxs);
+
+/**
+ * @brief Report completion of the measurement of the instance at @p idx.
+ *
+ * The busy flag is cleared regardless of @p rc. If @p rc is BMP280_RESULT_CODE_OK, the instance gets a new
+ * measurement, which the driver has written to the measurement passed to @ref bmp280_read_meas_forced_mode.
+ *
+ * @param[in] table Instance table.
+ * @param[in] idx Index of the instance.
+ * @param[in] rc Result code that the complete callback of the measurement received.
+ */
+void bmp280_table_read_done(BMP280Table *const table, size_t idx, uint8_t rc);
+
+/**
+ * @brief Store a raw frame read out by the backend, and clear the busy flag of the instance at @p idx.
+ *
+ * @param[in] table Instance table.
+ * @param[in] idx Index of the instance.
+ * @param[in] frame BMP280_RAW_FRAME_SIZE bytes, contents of registers 0xF7...0xFC.
+ */
+void bmp280_table_set_frame(BMP280Table *const table, size_t idx, const uint8_t *const frame);
+
+/**
+ * @brief Compensate all new raw frames in one sweep, and collect the new measurements of the driver.
+ *
+ * @param[in] table Instance table.
+ * @param[out] meas Measurement of the instance at index i is written to meas[i], for every instance with a new frame.
+ * Instances with a new measurement from @ref bmp280_table_read_done are counted but not written, the driver has already
+ * written their measurement there. Other elements are not modified. Must have at least @ref bmp280_table_num elements.
+ *
+ * @return size_t Number of new frames and measurements.
+ */
+size_t bmp280_table_compensate(BMP280Table *const table, BMP280Meas *const meas);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_BMP280_TABLE_H */
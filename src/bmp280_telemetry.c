@@ -0,0 +1,369 @@
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "bmp280_telemetry.h"
+#include "bmp280_varint.h"
+
+#define BMP280_TELEMETRY_MAGIC_0 0x42U
+#define BMP280_TELEMETRY_MAGIC_1 0x54U
+#define BMP280_TELEMETRY_VERSION 1U
+
+/** Maximum length of an encoded record: dictionary index and three varints. */
+#define BMP280_TELEMETRY_MAX_RECORD_LEN (1 + 3 * BMP280_VARINT32_MAX_LEN)
+/** Size of a sensor id in the dictionary. */
+#define BMP280_TELEMETRY_DICT_ENTRY_SIZE 4
+/** Dictionary indexes are one byte. */
+#define BMP280_TELEMETRY_MAX_DICT_LEN 255
+
+/** Multiplier of Fibonacci hashing, 2^32 divided by the golden ratio. */
+#define BMP280_TELEMETRY_HASH_MULTIPLIER 2654435761U
+
+static void put_u16(uint8_t *buf, uint16_t val)
+{
+    buf[0] = (uint8_t)val;
+    buf[1] = (uint8_t)(val >> 8);
+}
+
+static void put_u32(uint8_t *buf, uint32_t val)
+{
+    buf[0] = (uint8_t)val;
+    buf[1] = (uint8_t)(val >> 8);
+    buf[2] = (uint8_t)(val >> 16);
+    buf[3] = (uint8_t)(val >> 24);
+}
+
+static uint16_t get_u16(const uint8_t *buf)
+{
+    return (uint16_t)(buf[0] | (buf[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *buf)
+{
+    return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+static void encoder_reset_frame(BMP280TelemetryEncoder *const enc)
+{
+    enc->num_sensors = 0;
+    enc->last_idx = 0;
+    enc->num_records = 0;
+    enc->records_len = 0;
+}
+
+uint8_t bmp280_telemetry_encoder_init(BMP280TelemetryEncoder *const enc, uint16_t source_id, uint32_t first_seq)
+{
+    if (!enc) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    enc->source_id = source_id;
+    enc->seq = first_seq;
+    encoder_reset_frame(enc);
+    return BMP280_RESULT_CODE_OK;
+}
+
+/**
+ * @brief Find the dictionary index of @p sensor_id in the current frame.
+ *
+ * @return int Index, or -1 if the sensor has no records in the current frame yet.
+ */
+static int encoder_find_sensor(const BMP280TelemetryEncoder *const enc, uint32_t sensor_id)
+{
+    /* Gateways usually add the records of one sensor in a row */
+    if (enc->num_sensors > 0 && enc->sensor_ids[enc->last_idx] == sensor_id) {
+        return enc->last_idx;
+    }
+    for (uint8_t i = 0; i < enc->num_sensors; i++) {
+        if (enc->sensor_ids[i] == sensor_id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+uint8_t bmp280_telemetry_encoder_add(BMP280TelemetryEncoder *const enc, uint32_t sensor_id, uint32_t timestamp_ms,
+                                     const BMP280Meas *const meas)
+{
+    if (!enc || !meas) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    int idx = encoder_find_sensor(enc, sensor_id);
+    size_t num_sensors_after = (size_t)enc->num_sensors + ((idx < 0) ? 1U : 0U);
+    size_t worst_case_len = BMP280_TELEMETRY_HEADER_SIZE + num_sensors_after * BMP280_TELEMETRY_DICT_ENTRY_SIZE +
+                            enc->records_len + BMP280_TELEMETRY_MAX_RECORD_LEN;
+    if ((num_sensors_after > BMP280_TELEMETRY_MAX_SENSORS_PER_FRAME) ||
+        (worst_case_len > BMP280_TELEMETRY_MAX_FRAME_SIZE) || (enc->num_records == UINT16_MAX)) {
+        return BMP280_RESULT_CODE_NO_MEM;
+    }
+
+    if (idx < 0) {
+        idx = enc->num_sensors++;
+        enc->sensor_ids[idx] = sensor_id;
+        enc->last_temps[idx] = 0;
+        enc->last_press[idx] = 0;
+    }
+    if (enc->num_records == 0) {
+        enc->base_ts_ms = timestamp_ms;
+        enc->last_ts_ms = timestamp_ms;
+    }
+
+    uint8_t *record = &enc->records[enc->records_len];
+    size_t len = 0;
+    record[len++] = (uint8_t)idx;
+    len += bmp280_varint_put(&record[len], bmp280_zigzag_encode_32(timestamp_ms - enc->last_ts_ms));
+    len += bmp280_varint_put(&record[len],
+                             bmp280_zigzag_encode_32((uint32_t)meas->temperature - (uint32_t)enc->last_temps[idx]));
+    len += bmp280_varint_put(&record[len], bmp280_zigzag_encode_32(meas->pressure - enc->last_press[idx]));
+
+    enc->records_len += len;
+    enc->num_records++;
+    enc->last_idx = (uint8_t)idx;
+    enc->last_ts_ms = timestamp_ms;
+    enc->last_temps[idx] = meas->temperature;
+    enc->last_press[idx] = meas->pressure;
+    return BMP280_RESULT_CODE_OK;
+}
+
+size_t bmp280_telemetry_encoder_num_records(const BMP280TelemetryEncoder *const enc)
+{
+    return enc->num_records;
+}
+
+size_t bmp280_telemetry_encoder_finish(BMP280TelemetryEncoder *const enc, uint8_t *const frame, size_t frame_size)
+{
+    size_t dict_size = (size_t)enc->num_sensors * BMP280_TELEMETRY_DICT_ENTRY_SIZE;
+    size_t frame_len = BMP280_TELEMETRY_HEADER_SIZE + dict_size + enc->records_len;
+    if (enc->num_records == 0 || !frame || frame_size < frame_len) {
+        return 0;
+    }
+
+    frame[0] = BMP280_TELEMETRY_MAGIC_0;
+    frame[1] = BMP280_TELEMETRY_MAGIC_1;
+    frame[2] = BMP280_TELEMETRY_VERSION;
+    frame[3] = enc->num_sensors;
+    put_u16(&frame[4], enc->num_records);
+    put_u16(&frame[6], enc->source_id);
+    put_u32(&frame[8], enc->seq);
+    put_u32(&frame[12], enc->base_ts_ms);
+    for (uint8_t i = 0; i < enc->num_sensors; i++) {
+        put_u32(&frame[BMP280_TELEMETRY_HEADER_SIZE + i * BMP280_TELEMETRY_DICT_ENTRY_SIZE], enc->sensor_ids[i]);
+    }
+    memcpy(&frame[BMP280_TELEMETRY_HEADER_SIZE + dict_size], enc->records, enc->records_len);
+
+    enc->seq++;
+    encoder_reset_frame(enc);
+    return frame_len;
+}
+
+/**
+ * @brief Decode the records of a frame whose header has been validated.
+ *
+ * @param[in] cb Callback to execute for every record. NULL to only validate the records.
+ *
+ * @return bool false if the records are malformed.
+ */
+static bool decode_records(const uint8_t *const frame, size_t len, BMP280TelemetryRecordCb cb, void *user_data)
+{
+    uint8_t dict_len = frame[3];
+    uint16_t num_records = get_u16(&frame[4]);
+    uint32_t ts_ms = get_u32(&frame[12]);
+    const uint8_t *dict = &frame[BMP280_TELEMETRY_HEADER_SIZE];
+    int32_t last_temps[BMP280_TELEMETRY_MAX_DICT_LEN];
+    uint32_t last_press[BMP280_TELEMETRY_MAX_DICT_LEN];
+    memset(last_temps, 0, dict_len * sizeof(last_temps[0]));
+    memset(last_press, 0, dict_len * sizeof(last_press[0]));
+
+    size_t pos = BMP280_TELEMETRY_HEADER_SIZE + (size_t)dict_len * BMP280_TELEMETRY_DICT_ENTRY_SIZE;
+    for (uint16_t i = 0; i < num_records; i++) {
+        if (pos >= len) {
+            return false;
+        }
+        uint8_t idx = frame[pos++];
+        uint64_t ts_delta, temp_delta, pres_delta;
+        if (idx >= dict_len || !bmp280_varint_get(frame, len, &pos, BMP280_VARINT32_MAX_LEN, &ts_delta) ||
+            !bmp280_varint_get(frame, len, &pos, BMP280_VARINT32_MAX_LEN, &temp_delta) ||
+            !bmp280_varint_get(frame, len, &pos, BMP280_VARINT32_MAX_LEN, &pres_delta)) {
+            return false;
+        }
+        ts_ms += bmp280_zigzag_decode_32((uint32_t)ts_delta);
+        last_temps[idx] = (int32_t)((uint32_t)last_temps[idx] + bmp280_zigzag_decode_32((uint32_t)temp_delta));
+        last_press[idx] += bmp280_zigzag_decode_32((uint32_t)pres_delta);
+        if (cb) {
+            BMP280Meas meas = {.temperature = last_temps[idx], .pressure = last_press[idx]};
+            cb(get_u32(&dict[idx * BMP280_TELEMETRY_DICT_ENTRY_SIZE]), ts_ms, &meas, user_data);
+        }
+    }
+    return pos == len;
+}
+
+uint8_t bmp280_telemetry_decode(const uint8_t *const frame, size_t len, BMP280TelemetryFrameInfo *const info,
+                                BMP280TelemetryRecordCb cb, void *user_data)
+{
+    if (!frame || len < BMP280_TELEMETRY_HEADER_SIZE || frame[0] != BMP280_TELEMETRY_MAGIC_0 ||
+        frame[1] != BMP280_TELEMETRY_MAGIC_1 || frame[2] != BMP280_TELEMETRY_VERSION) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    if (len < BMP280_TELEMETRY_HEADER_SIZE + (size_t)frame[3] * BMP280_TELEMETRY_DICT_ENTRY_SIZE) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    if (!decode_records(frame, len, NULL, NULL)) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    if (info) {
+        info->num_records = get_u16(&frame[4]);
+        info->source_id = get_u16(&frame[6]);
+        info->seq = get_u32(&frame[8]);
+    }
+    if (cb) {
+        decode_records(frame, len, cb, user_data);
+    }
+    return BMP280_RESULT_CODE_OK;
+}
+
+static bool is_power_of_2(size_t val)
+{
+    return (val != 0) && ((val & (val - 1)) == 0);
+}
+
+uint8_t bmp280_telemetry_collector_init(BMP280TelemetryCollector *const coll, BMP280TelemetrySensorRing *const rings,
+                                        size_t num_rings, BMP280TelemetrySample *const samples, size_t ring_capacity)
+{
+    if (!coll || !rings || !samples || !is_power_of_2(num_rings) || !is_power_of_2(ring_capacity)) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    memset(coll, 0, sizeof(*coll));
+    coll->rings = rings;
+    coll->num_rings = num_rings;
+    coll->ring_capacity = ring_capacity;
+    for (size_t i = 0; i < num_rings; i++) {
+        rings[i].sensor_id = 0;
+        rings[i].used = false;
+        rings[i].samples = &samples[i * ring_capacity];
+        rings[i].num_written = 0;
+    }
+    return BMP280_RESULT_CODE_OK;
+}
+
+/**
+ * @brief Find the ring of @p sensor_id, or the free slot where it would be inserted.
+ *
+ * @return BMP280TelemetrySensorRing* Ring, free slot, or NULL if all rings are used by other sensors.
+ */
+static BMP280TelemetrySensorRing *collector_lookup(const BMP280TelemetryCollector *const coll, uint32_t sensor_id)
+{
+    size_t mask = coll->num_rings - 1;
+    size_t idx = (size_t)(sensor_id * BMP280_TELEMETRY_HASH_MULTIPLIER) & mask;
+    for (size_t i = 0; i < coll->num_rings; i++) {
+        BMP280TelemetrySensorRing *ring = &coll->rings[(idx + i) & mask];
+        if (!ring->used || ring->sensor_id == sensor_id) {
+            return ring;
+        }
+    }
+    return NULL;
+}
+
+static void collector_record_cb(uint32_t sensor_id, uint32_t timestamp_ms, const BMP280Meas *meas, void *user_data)
+{
+    BMP280TelemetryCollector *coll = (BMP280TelemetryCollector *)user_data;
+    BMP280TelemetrySensorRing *ring = coll->last_ring;
+    if (!ring || ring->sensor_id != sensor_id) {
+        ring = collector_lookup(coll, sensor_id);
+        if (!ring) {
+            coll->num_dropped_samples++;
+            return;
+        }
+        if (!ring->used) {
+            ring->used = true;
+            ring->sensor_id = sensor_id;
+            coll->num_sensors++;
+        }
+        coll->last_ring = ring;
+    }
+
+    BMP280TelemetrySample *sample = &ring->samples[ring->num_written & (coll->ring_capacity - 1)];
+    sample->timestamp_ms = timestamp_ms;
+    sample->meas = *meas;
+    ring->num_written++;
+    coll->num_samples++;
+}
+
+static void collector_track_seq(BMP280TelemetryCollector *const coll, uint16_t source_id, uint32_t seq)
+{
+    BMP280TelemetrySource *source = NULL;
+    for (size_t i = 0; i < BMP280_TELEMETRY_MAX_SOURCES; i++) {
+        if (!coll->sources[i].used || coll->sources[i].source_id == source_id) {
+            source = &coll->sources[i];
+            break;
+        }
+    }
+    if (!source) {
+        /* Source table is full, frames of this source are accepted without loss detection */
+        return;
+    }
+    if (!source->used) {
+        source->used = true;
+        source->source_id = source_id;
+        source->expected_seq = seq + 1;
+        return;
+    }
+
+    int32_t gap = (int32_t)(seq - source->expected_seq);
+    if (gap < 0) {
+        /* Number of frames between this frame and the newest frame of the source */
+        uint32_t behind = source->expected_seq - 1U - seq;
+        if (behind > BMP280_TELEMETRY_REORDER_WINDOW) {
+            /* The source restarted, without resync every later frame would count as late */
+            coll->num_resyncs++;
+            source->expected_seq = seq + 1;
+        } else {
+            coll->num_late_frames++;
+        }
+        return;
+    }
+    coll->num_lost_frames += (uint32_t)gap;
+    source->expected_seq = seq + 1;
+}
+
+uint8_t bmp280_telemetry_collector_push_frame(BMP280TelemetryCollector *const coll, const uint8_t *const frame,
+                                              size_t len)
+{
+    BMP280TelemetryFrameInfo info;
+    uint8_t rc = bmp280_telemetry_decode(frame, len, &info, collector_record_cb, (void *)coll);
+    if (rc != BMP280_RESULT_CODE_OK) {
+        coll->num_bad_frames++;
+        return rc;
+    }
+
+    coll->num_frames++;
+    collector_track_seq(coll, info.source_id, info.seq);
+    return BMP280_RESULT_CODE_OK;
+}
+
+const BMP280TelemetrySensorRing *bmp280_telemetry_collector_find(const BMP280TelemetryCollector *const coll,
+                                                                 uint32_t sensor_id)
+{
+    const BMP280TelemetrySensorRing *ring = collector_lookup(coll, sensor_id);
+    return (ring && ring->used) ? ring : NULL;
+}
+
+size_t bmp280_telemetry_ring_num_samples(const BMP280TelemetryCollector *const coll,
+                                         const BMP280TelemetrySensorRing *const ring)
+{
+    return (ring->num_written < coll->ring_capacity) ? ring->num_written : coll->ring_capacity;
+}
+
+uint8_t bmp280_telemetry_ring_get(const BMP280TelemetryCollector *const coll,
+                                  const BMP280TelemetrySensorRing *const ring, size_t age,
+                                  BMP280TelemetrySample *const sample)
+{
+    if (age >= bmp280_telemetry_ring_num_samples(coll, ring)) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    *sample = ring->samples[(ring->num_written - 1 - age) & (coll->ring_capacity - 1)];
+    return BMP280_RESULT_CODE_OK;
+}
@@ -0,0 +1,272 @@
+#ifndef SRC_BMP280_TELEMETRY_H
+#define SRC_BMP280_TELEMETRY_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "bmp280.h"
+
+/**
+ * @brief Batched binary telemetry frames for forwarding measurements of many sensors to a collector.
+ *
+ * A gateway adds measurement records of its sensors to a @ref BMP280TelemetryEncoder, and sends a frame once the
+ * encoder is full or a flush interval has passed. A collector decodes frames into per-sensor rings of the latest
+ * samples with @ref bmp280_telemetry_collector_push_frame. Transport is up to the user, see port/linux for UDP and Unix
+ * domain sockets.
+ *
+ * Frame layout, all multi-byte fields little-endian:
+ * - header (16 bytes): magic "BT", version, number of dictionary entries, number of records (u16), source id (u16),
+ * sequence number (u32), timestamp of the first record in ms (u32)
+ * - sensor id dictionary: one u32 per sensor that has records in the frame
+ * - records: dictionary index (u8), then three zigzag varints: timestamp delta from the previous record, temperature
+ * delta and pressure delta from the previous record of the same sensor in the frame (from 0 for its first record)
+ *
+ * Consecutive samples of one sensor differ little, so a record is typically 6-8 bytes instead of 12 bytes of raw
+ * values plus a sensor id and a timestamp.
+ *
+ * Sequence numbers increment by one per frame of a source. The collector counts gaps as lost frames.
+ */
+
+/** Maximum size of a frame. Default fits into one UDP datagram on Ethernet without IP fragmentation. */
+#ifndef BMP280_TELEMETRY_MAX_FRAME_SIZE
+#define BMP280_TELEMETRY_MAX_FRAME_SIZE 1472
+#endif
+
+/** Maximum number of different sensors in one frame. At most 255. */
+#ifndef BMP280_TELEMETRY_MAX_SENSORS_PER_FRAME
+#define BMP280_TELEMETRY_MAX_SENSORS_PER_FRAME 64
+#endif
+
+/** Maximum number of sources whose sequence numbers a collector tracks. */
+#ifndef BMP280_TELEMETRY_MAX_SOURCES
+#define BMP280_TELEMETRY_MAX_SOURCES 16
+#endif
+
+/**
+ * Number of frames that a frame can arrive behind the newest frame of its source and still be counted as late. A frame
+ * further behind means that the source restarted with a lower sequence number, e.g. after a reboot, and the collector
+ * resynchronizes to it.
+ */
+#ifndef BMP280_TELEMETRY_REORDER_WINDOW
+#define BMP280_TELEMETRY_REORDER_WINDOW 64
+#endif
+
+/** Size of the frame header in bytes. */
+#define BMP280_TELEMETRY_HEADER_SIZE 16
+
+/**
+ * @brief Frame encoder of one source.
+ *
+ * Memory is provided by the user. Fields are private, use the functions of this module to access them.
+ */
+typedef struct {
+    uint16_t source_id;
+    /** Sequence number of the next frame. */
+    uint32_t seq;
+    uint32_t sensor_ids[BMP280_TELEMETRY_MAX_SENSORS_PER_FRAME];
+    int32_t last_temps[BMP280_TELEMETRY_MAX_SENSORS_PER_FRAME];
+    uint32_t last_press[BMP280_TELEMETRY_MAX_SENSORS_PER_FRAME];
+    uint8_t num_sensors;
+    /** Dictionary index of the sensor of the previous record, checked first when looking up the next one. */
+    uint8_t last_idx;
+    uint16_t num_records;
+    uint32_t base_ts_ms;
+    uint32_t last_ts_ms;
+    /** Encoded records. The dictionary is only known once the frame is finished, so it is prepended then. */
+    uint8_t records[BMP280_TELEMETRY_MAX_FRAME_SIZE];
+    size_t records_len;
+} BMP280TelemetryEncoder;
+
+/** Header fields of a decoded frame. */
+typedef struct {
+    uint16_t source_id;
+    uint32_t seq;
+    uint16_t num_records;
+} BMP280TelemetryFrameInfo;
+
+/**
+ * @brief Called by @ref bmp280_telemetry_decode for every record of a frame, in the order in which they were added.
+ */
+typedef void (*BMP280TelemetryRecordCb)(uint32_t sensor_id, uint32_t timestamp_ms, const BMP280Meas *meas,
+                                        void *user_data);
+
+/** One sample stored by the collector. */
+typedef struct {
+    uint32_t timestamp_ms;
+    BMP280Meas meas;
+} BMP280TelemetrySample;
+
+/** Ring of the latest samples of one sensor. Fields are private, use the functions of this module to access them. */
+typedef struct {
+    uint32_t sensor_id;
+    bool used;
+    BMP280TelemetrySample *samples;
+    /** Free running number of samples written to the ring. */
+    size_t num_written;
+} BMP280TelemetrySensorRing;
+
+/** Sequence number tracking of one source. */
+typedef struct {
+    uint16_t source_id;
+    bool used;
+    uint32_t expected_seq;
+} BMP280TelemetrySource;
+
+/**
+ * @brief Collector state.
+ *
+ * Memory is provided by the user. Statistics fields can be read directly, other fields are private.
+ */
+typedef struct {
+    /** Open addressing hash table of sensor rings, indexed by sensor id. */
+    BMP280TelemetrySensorRing *rings;
+    size_t num_rings;
+    /** Number of samples per ring, power of 2. */
+    size_t ring_capacity;
+    size_t num_sensors;
+    BMP280TelemetrySensorRing *last_ring;
+    BMP280TelemetrySource sources[BMP280_TELEMETRY_MAX_SOURCES];
+    /** Number of accepted frames. */
+    uint32_t num_frames;
+    /** Number of frames that were never received, according to gaps in sequence numbers. */
+    uint32_t num_lost_frames;
+    /** Number of frames received with a sequence number older than expected, within the reorder window: duplicated or
+     * reordered. */
+    uint32_t num_late_frames;
+    /** Number of times a source went back by more than @ref BMP280_TELEMETRY_REORDER_WINDOW frames and was
+     * resynchronized. */
+    uint32_t num_resyncs;
+    /** Number of malformed frames. */
+    uint32_t num_bad_frames;
+    /** Number of samples stored in rings. */
+    uint64_t num_samples;
+    /** Number of samples discarded because all rings are taken by other sensors. */
+    uint32_t num_dropped_samples;
+} BMP280TelemetryCollector;
+
+/**
+ * @brief Initialize a frame encoder.
+ *
+ * @param[out] enc Encoder to initialize.
+ * @param[in] source_id Id of the sending gateway, included in every frame.
+ * @param[in] first_seq Sequence number of the first frame.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully initialized @p enc.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p enc is NULL.
+ */
+uint8_t bmp280_telemetry_encoder_init(BMP280TelemetryEncoder *const enc, uint16_t source_id, uint32_t first_seq);
+
+/**
+ * @brief Add a measurement record to the current frame.
+ *
+ * @param[in] enc Encoder.
+ * @param[in] sensor_id Id of the sensor.
+ * @param[in] timestamp_ms Time of the measurement in ms. Can wrap around.
+ * @param[in] meas Measurement.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully added the record.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p enc or @p meas is NULL.
+ * @retval BMP280_RESULT_CODE_NO_MEM The frame is full. Finish it with @ref bmp280_telemetry_encoder_finish and add the
+ * record again.
+ */
+uint8_t bmp280_telemetry_encoder_add(BMP280TelemetryEncoder *const enc, uint32_t sensor_id, uint32_t timestamp_ms,
+                                     const BMP280Meas *const meas);
+
+/**
+ * @brief Number of records in the current frame.
+ */
+size_t bmp280_telemetry_encoder_num_records(const BMP280TelemetryEncoder *const enc);
+
+/**
+ * @brief Write the current frame to @p frame and start the next one.
+ *
+ * @param[in] enc Encoder.
+ * @param[out] frame Buffer to write the frame to.
+ * @param[in] frame_size Size of @p frame. BMP280_TELEMETRY_MAX_FRAME_SIZE is always enough.
+ *
+ * @return size_t Frame length. 0 if the frame has no records or does not fit into @p frame, in which case the current
+ * frame is kept.
+ */
+size_t bmp280_telemetry_encoder_finish(BMP280TelemetryEncoder *const enc, uint8_t *const frame, size_t frame_size);
+
+/**
+ * @brief Decode a frame.
+ *
+ * The whole frame is validated before @p cb is executed for any record, so a malformed frame executes no callbacks.
+ *
+ * @param[in] frame Frame.
+ * @param[in] len Frame length.
+ * @param[out] info Header fields are written to this parameter. Can be NULL.
+ * @param[in] cb Callback to execute for every record. Can be NULL to only validate the frame.
+ * @param[in] user_data User data to pass to @p cb.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully decoded the frame.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p frame is NULL or malformed.
+ */
+uint8_t bmp280_telemetry_decode(const uint8_t *const frame, size_t len, BMP280TelemetryFrameInfo *const info,
+                                BMP280TelemetryRecordCb cb, void *user_data);
+
+/**
+ * @brief Initialize a collector.
+ *
+ * @param[out] coll Collector to initialize.
+ * @param[in] rings Memory for @p num_rings sensor rings.
+ * @param[in] num_rings Maximum number of sensors, power of 2. Lookups are fastest with at most 3/4 of them used.
+ * @param[in] samples Memory for @p num_rings * @p ring_capacity samples.
+ * @param[in] ring_capacity Number of latest samples kept per sensor, power of 2.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully initialized @p coll.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG A pointer is NULL, or @p num_rings or @p ring_capacity is not a power of 2.
+ */
+uint8_t bmp280_telemetry_collector_init(BMP280TelemetryCollector *const coll, BMP280TelemetrySensorRing *const rings,
+                                        size_t num_rings, BMP280TelemetrySample *const samples, size_t ring_capacity);
+
+/**
+ * @brief Decode a received frame into the rings of its sensors, and track its sequence number.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully decoded the frame.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG The frame is malformed. It is counted in num_bad_frames.
+ */
+uint8_t bmp280_telemetry_collector_push_frame(BMP280TelemetryCollector *const coll, const uint8_t *const frame,
+                                              size_t len);
+
+/**
+ * @brief Find the ring of a sensor.
+ *
+ * @return const BMP280TelemetrySensorRing* Ring, or NULL if no samples of @p sensor_id have been received.
+ */
+const BMP280TelemetrySensorRing *bmp280_telemetry_collector_find(const BMP280TelemetryCollector *const coll,
+                                                                 uint32_t sensor_id);
+
+/**
+ * @brief Number of samples available in @p ring, at most ring_capacity of the collector.
+ */
+size_t bmp280_telemetry_ring_num_samples(const BMP280TelemetryCollector *const coll,
+                                         const BMP280TelemetrySensorRing *const ring);
+
+/**
+ * @brief Get a sample from @p ring.
+ *
+ * @param[in] coll Collector that @p ring belongs to.
+ * @param[in] ring Ring.
+ * @param[in] age 0 for the latest sample, 1 for the one before it, and so on.
+ * @param[out] sample Sample is written to this parameter.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully got the sample.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p age is not less than @ref bmp280_telemetry_ring_num_samples.
+ */
+uint8_t bmp280_telemetry_ring_get(const BMP280TelemetryCollector *const coll,
+                                  const BMP280TelemetrySensorRing *const ring, size_t age,
+                                  BMP280TelemetrySample *const sample);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_BMP280_TELEMETRY_H */
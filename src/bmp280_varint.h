@@ -0,0 +1,91 @@
+#ifndef SRC_BMP280_VARINT_H
+#define SRC_BMP280_VARINT_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Zigzag and varint coding of deltas, shared by the modules that store measurements compactly, e.g.
+ * bmp280_telemetry.c and bmp280_chunk_store.c. Not a part of the public API. */
+
+/** Maximum length of a varint of a 32-bit value. */
+#define BMP280_VARINT32_MAX_LEN 5
+/** Maximum length of a varint of a 64-bit value. */
+#define BMP280_VARINT64_MAX_LEN 10
+
+/**
+ * @brief Map a signed delta to an unsigned value with small magnitudes first: 0, -1, 1, -2, 2, ...
+ *
+ * @p delta is passed as uint32_t holding the two's complement bit pattern, so that computing it never overflows.
+ */
+static inline uint32_t bmp280_zigzag_encode_32(uint32_t delta)
+{
+    return (delta << 1) ^ (0U - (delta >> 31));
+}
+
+static inline uint32_t bmp280_zigzag_decode_32(uint32_t val)
+{
+    return (val >> 1) ^ (0U - (val & 1U));
+}
+
+/** @brief 64-bit variant of @ref bmp280_zigzag_encode_32. */
+static inline uint64_t bmp280_zigzag_encode_64(uint64_t delta)
+{
+    return (delta << 1) ^ (0U - (delta >> 63));
+}
+
+static inline uint64_t bmp280_zigzag_decode_64(uint64_t val)
+{
+    return (val >> 1) ^ (0U - (val & 1U));
+}
+
+/**
+ * @brief Write @p val as a varint: seven bits per byte, least significant first, top bit set on all but the last.
+ *
+ * @return size_t Number of bytes written, at most BMP280_VARINT64_MAX_LEN.
+ */
+static inline size_t bmp280_varint_put(uint8_t *buf, uint64_t val)
+{
+    size_t len = 0;
+    while (val >= 0x80U) {
+        buf[len++] = (uint8_t)(val | 0x80U);
+        val >>= 7;
+    }
+    buf[len++] = (uint8_t)val;
+    return len;
+}
+
+/**
+ * @brief Read a varint at *pos, and advance *pos past it.
+ *
+ * @param[in] max_len Maximum length of the varint, BMP280_VARINT32_MAX_LEN or BMP280_VARINT64_MAX_LEN.
+ *
+ * @return bool false if the varint is truncated or longer than @p max_len.
+ */
+static inline bool bmp280_varint_get(const uint8_t *buf, size_t len, size_t *pos, size_t max_len, uint64_t *val)
+{
+    uint64_t result = 0;
+    for (size_t i = 0; i < max_len; i++) {
+        if (*pos >= len) {
+            return false;
+        }
+        uint8_t byte = buf[(*pos)++];
+        result |= (uint64_t)(byte & 0x7FU) << (7 * i);
+        if (!(byte & 0x80U)) {
+            *val = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_BMP280_VARINT_H */
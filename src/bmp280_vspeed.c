@@ -0,0 +1,99 @@
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "bmp280_vspeed.h"
+
+/** 1.0 in Q16. */
+#define BMP280_VSPEED_Q16_ONE 65536
+/** Shift from Q24.8 pressure to the filter state format. */
+#define BMP280_VSPEED_PRES_SHIFT (BMP280_VSPEED_FRAC_BITS - 8)
+/** Gas constant of dry air divided by standard gravity, in mm/K. Scale height is this times temperature. */
+#define BMP280_VSPEED_R_OVER_G_MM_PER_K 29271
+/** 0 degC in 0.01 K. */
+#define BMP280_VSPEED_ZERO_DEGC 27315
+
+uint8_t bmp280_vspeed_init(BMP280VSpeed *const est, const BMP280VSpeedCfg *const cfg)
+{
+    if (!est || !cfg || cfg->alpha == 0 || cfg->alpha > BMP280_VSPEED_Q16_ONE || cfg->beta == 0 ||
+        cfg->beta >= 4 * BMP280_VSPEED_Q16_ONE - 2 * cfg->alpha || cfg->max_gap_ms == 0) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    est->cfg = *cfg;
+    est->has_sample = false;
+    est->p_ref = 0;
+    est->x = 0;
+    est->v = 0;
+    est->temperature = 0;
+    est->last_timestamp_ms = 0;
+    est->dt_ms = 0;
+    est->dt_q16 = 0;
+    est->beta_dt_q16 = 0;
+    return BMP280_RESULT_CODE_OK;
+}
+
+void bmp280_vspeed_update(BMP280VSpeed *const est, uint32_t timestamp_ms, const BMP280Meas *const meas)
+{
+    est->temperature = meas->temperature;
+    if (!est->has_sample) {
+        est->p_ref = meas->pressure;
+        est->x = 0;
+        est->v = 0;
+        est->last_timestamp_ms = timestamp_ms;
+        est->has_sample = true;
+        return;
+    }
+
+    int32_t z = (int32_t)(meas->pressure - est->p_ref) * (1 << BMP280_VSPEED_PRES_SHIFT);
+    uint32_t dt_ms = timestamp_ms - est->last_timestamp_ms;
+    est->last_timestamp_ms = timestamp_ms;
+    if (dt_ms > est->cfg.max_gap_ms) {
+        /* The speed estimate is stale after a long gap, start over at this sample */
+        est->x = z;
+        est->v = 0;
+        return;
+    }
+    if (dt_ms == 0) {
+        est->x += (int32_t)(((int64_t)est->cfg.alpha * (z - est->x)) >> 16);
+        return;
+    }
+
+    if (dt_ms != est->dt_ms) {
+        /* Sampling is usually periodic, so these divisions only execute when the interval changes */
+        est->dt_ms = dt_ms;
+        est->dt_q16 = (int32_t)(((uint64_t)dt_ms << 16) / 1000);
+        est->beta_dt_q16 = (int32_t)(((uint64_t)est->cfg.beta * 1000) / dt_ms);
+    }
+
+    int32_t x_pred = est->x + (int32_t)(((int64_t)est->v * est->dt_q16) >> 16);
+    int32_t residual = z - x_pred;
+    est->x = x_pred + (int32_t)(((int64_t)est->cfg.alpha * residual) >> 16);
+    est->v += (int32_t)(((int64_t)est->beta_dt_q16 * residual) >> 16);
+}
+
+/** Scale height at the temperature of the latest sample, in mm. */
+static int64_t scale_height_mm(const BMP280VSpeed *const est)
+{
+    return (int64_t)BMP280_VSPEED_R_OVER_G_MM_PER_K * (est->temperature + BMP280_VSPEED_ZERO_DEGC) / 100;
+}
+
+int32_t bmp280_vspeed_altitude_mm(const BMP280VSpeed *const est)
+{
+    if (!est->has_sample) {
+        return 0;
+    }
+    int64_t p_ref = (int64_t)est->p_ref << BMP280_VSPEED_PRES_SHIFT;
+    /* u = (p0 - p) / (p0 + p) in Q30, |u| < 0.6 for any two pressures the sensor can measure */
+    int64_t u = (-(int64_t)est->x * (1LL << 30)) / (2 * p_ref + est->x);
+    int64_t u3 = (((u * u) >> 30) * u) >> 30;
+    return (int32_t)((2 * scale_height_mm(est) * (u + u3 / 3)) >> 30);
+}
+
+int32_t bmp280_vspeed_speed_mm_s(const BMP280VSpeed *const est)
+{
+    if (!est->has_sample) {
+        return 0;
+    }
+    int64_t p = ((int64_t)est->p_ref << BMP280_VSPEED_PRES_SHIFT) + est->x;
+    return (int32_t)(-scale_height_mm(est) * est->v / p);
+}
@@ -0,0 +1,115 @@
+#ifndef SRC_BMP280_VSPEED_H
+#define SRC_BMP280_VSPEED_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bmp280.h"
+
+/**
+ * @brief Fixed-point estimator of altitude and vertical speed from the pressure stream of one sensor.
+ *
+ * An alpha-beta filter, which is the steady-state form of a 2-state Kalman filter with a constant velocity model,
+ * tracks pressure and its rate of change. The sample interval of every update is taken from the measurement
+ * timestamps, so jittered or irregular sampling is handled.
+ *
+ * Filtering happens in the pressure domain, relative to the pressure of the first sample. Altitude and vertical speed
+ * are derived from the filter state only when read, using the hypsometric equation with the scale height at the
+ * temperature of the latest sample:
+ * - altitude relative to the first sample: H * ln(p0 / p), evaluated as 2 * H * (u + u^3 / 3) with
+ * u = (p0 - p) / (p0 + p), which is off by 3 mm at 1000 m and 7 m at 5000 m;
+ * - vertical speed: -H / p * dp/dt.
+ *
+ * @ref bmp280_vspeed_update only uses 32x32-bit multiplications with 64-bit products, and no division unless the
+ * sample interval differs from the previous one. Each getter performs one 64-bit division.
+ *
+ * Choosing gains: for a sample period T, a standard deviation of pressure noise of sigma_p and a standard deviation of
+ * the vertical acceleration of the pressure signal of sigma_a, the Kalman gains follow from the tracking index
+ * lambda = sigma_a * T^2 / sigma_p:
+ * - r = (4 + lambda - sqrt(8 * lambda + lambda^2)) / 4
+ * - alpha = 1 - r^2
+ * - beta = 2 * (2 - alpha) - 4 * sqrt(1 - alpha)
+ * Smaller gains suppress more noise and add more lag.
+ */
+
+/** Number of fractional bits of the filter state. */
+#define BMP280_VSPEED_FRAC_BITS 12
+
+/** Estimator configuration. */
+typedef struct {
+    /** Position gain in Q16, 1 to 65536. */
+    uint32_t alpha;
+    /** Rate gain in Q16, larger than 0 and smaller than 4 - 2 * alpha for a stable filter. */
+    uint32_t beta;
+    /** A sample more than max_gap_ms after the previous one restarts the filter at that sample, with zero speed. */
+    uint32_t max_gap_ms;
+} BMP280VSpeedCfg;
+
+/** Estimator state. Memory is provided by the user. Fields are private. */
+typedef struct {
+    BMP280VSpeedCfg cfg;
+    bool has_sample;
+    /** Pressure of the first sample, Q24.8 Pa. Altitude 0. */
+    uint32_t p_ref;
+    /** Pressure relative to p_ref, and its rate of change in Pa/s, with BMP280_VSPEED_FRAC_BITS fractional bits. */
+    int32_t x;
+    int32_t v;
+    /** Temperature of the latest sample, 0.01 degC. */
+    int32_t temperature;
+    uint32_t last_timestamp_ms;
+    /** Sample interval of the latest update, and values derived from it. */
+    uint32_t dt_ms;
+    /** dt in Q16 s. */
+    int32_t dt_q16;
+    /** beta / dt in Q16 1/s. */
+    int32_t beta_dt_q16;
+} BMP280VSpeed;
+
+/**
+ * @brief Initialize an estimator without samples.
+ *
+ * @param[out] est Estimator to initialize.
+ * @param[in] cfg Configuration. Copied into @p est.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully initialized @p est.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p est or @p cfg is NULL, alpha is 0 or larger than 65536, beta is 0 or not
+ * smaller than 4 - 2 * alpha, or max_gap_ms is 0.
+ */
+uint8_t bmp280_vspeed_init(BMP280VSpeed *const est, const BMP280VSpeedCfg *const cfg);
+
+/**
+ * @brief Update the estimate with the next sample.
+ *
+ * The first sample sets the altitude reference. A sample with the same timestamp as the previous one only corrects
+ * the pressure estimate.
+ *
+ * @param[in] est Estimator.
+ * @param[in] timestamp_ms Time of the sample. Can wrap around.
+ * @param[in] meas Sample.
+ */
+void bmp280_vspeed_update(BMP280VSpeed *const est, uint32_t timestamp_ms, const BMP280Meas *const meas);
+
+/**
+ * @brief Get the estimated altitude relative to the first sample.
+ *
+ * @return int32_t Altitude in mm. 0 before the first sample.
+ */
+int32_t bmp280_vspeed_altitude_mm(const BMP280VSpeed *const est);
+
+/**
+ * @brief Get the estimated vertical speed. Positive when climbing.
+ *
+ * @return int32_t Vertical speed in mm/s. 0 before the second sample.
+ */
+int32_t bmp280_vspeed_speed_mm_s(const BMP280VSpeed *const est);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_BMP280_VSPEED_H */
@@ -0,0 +1,141 @@
+#include <math.h>
+#include <stdio.h>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280.h"
+#include "bmp280_array.h"
+#include "sim.h"
+#include "sim_bmp280.h"
+#include "sim_fixture.h"
+
+#define ARRAY_TEMP_RAW 519888
+#define ARRAY_PRES_RAW 415148
+/* Forced mode wait with oversampling 1 */
+#define ARRAY_MEAS_TIME_MS 7
+
+#define ARRAY_NUM_SENSORS 4
+
+static SimBus array_bus;
+static SimBMP280 array_devs[ARRAY_NUM_SENSORS];
+static BMP280 array_insts[ARRAY_NUM_SENSORS];
+
+static void array_complete_cb(uint8_t rc, void *user_data)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    *(bool *)user_data = true;
+}
+
+/* Pseudo-random noise in [-amplitude, amplitude], reproducible across runs */
+static int32_t noise(uint32_t *state, int32_t amplitude)
+{
+    *state = *state * 1664525U + 1013904223U;
+    return (int32_t)((*state >> 8) % (uint32_t)(2 * amplitude + 1)) - amplitude;
+}
+
+// clang-format off
+TEST_GROUP(BMP280ArrayBench)
+{
+    BMP280Array array;
+    BMP280Meas meas;
+    bool complete;
+
+    void setup()
+    {
+        sim_reset();
+        sim_fixture_reset_inst_bufs();
+        /* 400 kHz I2C */
+        sim_bus_init(&array_bus, 70, 23);
+        for (size_t i = 0; i < ARRAY_NUM_SENSORS; i++) {
+            sim_bmp280_init(&array_devs[i], &array_bus, sim_fixture_calib_data);
+            array_devs[i].temp_raw = ARRAY_TEMP_RAW;
+            array_devs[i].pres_raw = ARRAY_PRES_RAW;
+            BMP280InitCfg init_cfg = {
+                .get_inst_buf = sim_fixture_get_inst_buf,
+                .get_inst_buf_user_data = NULL,
+                .read_regs = sim_bmp280_read_regs,
+                .read_regs_user_data = (void *)&array_devs[i],
+                .write_reg = sim_bmp280_write_reg,
+                .write_reg_user_data = (void *)&array_devs[i],
+                .start_timer = sim_start_timer,
+                .start_timer_user_data = NULL,
+                .lazy_init_meas = false,
+            };
+            CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_create(&array_insts[i], &init_cfg));
+            run(bmp280_set_temp_oversampling(array_insts[i], BMP280_OVERSAMPLING_1, array_complete_cb, &complete));
+            run(bmp280_set_pres_oversampling(array_insts[i], BMP280_OVERSAMPLING_1, array_complete_cb, &complete));
+            run(bmp280_init_meas(array_insts[i], array_complete_cb, &complete));
+        }
+
+        BMP280ArrayCfg cfg;
+        cfg.pres_tolerance = 100 * 256;
+        cfg.temp_tolerance = 200;
+        cfg.min_members = 1;
+        cfg.offset_shift = 4;
+        cfg.max_consecutive_failures = 3;
+        cfg.probe_interval = 10;
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_array_init(&array, &cfg));
+        for (size_t i = 0; i < ARRAY_NUM_SENSORS; i++) {
+            CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_array_add(&array, array_insts[i]));
+        }
+    }
+
+    void teardown()
+    {
+        /* Releases the memory of the event heap, so that it is not reported as a leak */
+        sim_reset();
+    }
+
+    /* Run the simulation until the operation that start_rc belongs to completes */
+    void run(uint8_t start_rc)
+    {
+        complete = false;
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, start_rc);
+        sim_run();
+        CHECK_TRUE(complete);
+    }
+};
+// clang-format on
+
+TEST(BMP280ArrayBench, ConversionsOverlap)
+{
+    uint64_t start_us = sim_now_us();
+    run(bmp280_read_meas_forced_mode(array_insts[0], BMP280_MEAS_TYPE_TEMP_AND_PRES, ARRAY_MEAS_TIME_MS, &meas,
+                                     array_complete_cb, &complete));
+    uint64_t single_us = sim_now_us() - start_us;
+
+    start_us = sim_now_us();
+    run(bmp280_array_read_meas_forced_mode(&array, BMP280_MEAS_TYPE_TEMP_AND_PRES, ARRAY_MEAS_TIME_MS, &meas,
+                                           array_complete_cb, &complete));
+    uint64_t array_us = sim_now_us() - start_us;
+
+    printf("\narray: single read %llu us, read of %d members %llu us\n", (unsigned long long)single_us,
+           ARRAY_NUM_SENSORS, (unsigned long long)array_us);
+}
+
+TEST(BMP280ArrayBench, NoiseFallsWithSqrtOfMembers)
+{
+    uint32_t state = 1;
+    double sum_member = 0;
+    double sq_sum_member = 0;
+    double sum_fused = 0;
+    double sq_sum_fused = 0;
+    const int num_reads = 2000;
+    for (int r = 0; r < num_reads; r++) {
+        for (size_t i = 0; i < ARRAY_NUM_SENSORS; i++) {
+            array_devs[i].pres_raw = ARRAY_PRES_RAW + noise(&state, 32);
+        }
+        run(bmp280_array_read_meas_forced_mode(&array, BMP280_MEAS_TYPE_TEMP_AND_PRES, ARRAY_MEAS_TIME_MS, &meas,
+                                               array_complete_cb, &complete));
+        double member = array.members[0].meas.pressure / 256.0;
+        double fused = meas.pressure / 256.0;
+        sum_member += member;
+        sq_sum_member += member * member;
+        sum_fused += fused;
+        sq_sum_fused += fused * fused;
+    }
+    double sd_member = sqrt(sq_sum_member / num_reads - (sum_member / num_reads) * (sum_member / num_reads));
+    double sd_fused = sqrt(sq_sum_fused / num_reads - (sum_fused / num_reads) * (sum_fused / num_reads));
+    printf("\narray: pressure noise %.3f Pa for one member, %.3f Pa fused from %d\n", sd_member, sd_fused,
+           ARRAY_NUM_SENSORS);
+}
@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280.h"
+#include "bmp280_bus_batch.h"
+#include "sim.h"
+#include "sim_bmp280.h"
+#include "sim_fixture.h"
+#include "sim_mux.h"
+
+#define MUX_ADDR 0x70
+
+/* 16 sensors in continuous forced mode behind a simulated TCA9548A, flushed every 1 ms */
+
+#define MUX_SIM_NUM_SENSORS 16
+#define MUX_SIM_FLUSH_PERIOD_US 1000
+#define MUX_SIM_MEAS_TIME_MS 7
+#define MUX_SIM_DURATION_US 2000000
+
+static SimBus mux_sim_bus;
+static SimMux mux_sim_mux;
+static SimBMP280 mux_sim_devs[MUX_SIM_NUM_SENSORS];
+static BMP280BusBatch mux_sim_batch;
+static BMP280BusBatchDev mux_sim_batch_devs[MUX_SIM_NUM_SENSORS];
+
+static struct {
+    BMP280 inst;
+    BMP280Meas meas;
+    uint32_t num_samples;
+    uint32_t num_errors;
+    bool init_done;
+} mux_sim_sensors[MUX_SIM_NUM_SENSORS];
+
+static void mux_sim_flush_tick(void *user_data)
+{
+    (void)user_data;
+    bmp280_bus_batch_flush(&mux_sim_batch);
+    sim_schedule_us(MUX_SIM_FLUSH_PERIOD_US, mux_sim_flush_tick, NULL);
+}
+
+static void mux_sim_init_done_cb(uint8_t rc, void *user_data)
+{
+    size_t i = (size_t)(uintptr_t)user_data;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    mux_sim_sensors[i].init_done = true;
+}
+
+static void mux_sim_sample_cb(uint8_t rc, void *user_data)
+{
+    size_t i = (size_t)(uintptr_t)user_data;
+    if (rc == BMP280_RESULT_CODE_OK) {
+        mux_sim_sensors[i].num_samples++;
+    } else {
+        mux_sim_sensors[i].num_errors++;
+    }
+}
+
+static void mux_sim_start_sensor(void *user_data)
+{
+    size_t i = (size_t)(uintptr_t)user_data;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK,
+                bmp280_start_continuous_forced_mode(mux_sim_sensors[i].inst, BMP280_MEAS_TYPE_TEMP_AND_PRES,
+                                                    MUX_SIM_MEAS_TIME_MS, &mux_sim_sensors[i].meas, mux_sim_sample_cb,
+                                                    user_data));
+}
+
+typedef struct {
+    uint64_t num_samples;
+    uint64_t num_selects;
+    uint64_t num_dev_transfers;
+    uint64_t bus_time_us;
+    uint32_t min_sensor_samples;
+} MuxSimResult;
+
+// clang-format off
+TEST_GROUP(BMP280BusBatchMuxBench){
+    void teardown() {
+        /* Releases the memory of the event heap, so that it is not reported as a leak */
+        sim_reset();
+    }
+
+    MuxSimResult run(bool keep_order, uint32_t max_hold_flushes) {
+        sim_reset();
+        memset(mux_sim_sensors, 0, sizeof(mux_sim_sensors));
+        sim_fixture_reset_inst_bufs();
+        /* 400 kHz I2C */
+        sim_bus_init(&mux_sim_bus, 70, 23);
+        sim_mux_init(&mux_sim_mux, &mux_sim_bus, MUX_ADDR);
+        BMP280BusBatchCfg cfg = {
+            .submit = sim_mux_submit,
+            .submit_user_data = (void *)&mux_sim_mux,
+            .mux_addr = MUX_ADDR,
+            .mux_keep_order = keep_order,
+            .mux_max_hold_flushes = max_hold_flushes,
+        };
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_init(&mux_sim_batch, &cfg));
+
+        for (size_t i = 0; i < MUX_SIM_NUM_SENSORS; i++) {
+            /* Neighbouring sensors sit on different channels, both addresses are used on every channel */
+            uint8_t channel = (uint8_t)(i % BMP280_BUS_BATCH_MUX_NUM_CHANNELS);
+            uint8_t dev_addr = (uint8_t)(0x76 + i / BMP280_BUS_BATCH_MUX_NUM_CHANNELS);
+            sim_bmp280_init(&mux_sim_devs[i], &mux_sim_bus, sim_fixture_calib_data);
+            /* Oversampling 1 for temperature and pressure */
+            mux_sim_devs[i].regs[0xF4] = 0x24;
+            sim_mux_attach(&mux_sim_mux, &mux_sim_devs[i], channel, dev_addr);
+            CHECK_EQUAL(BMP280_RESULT_CODE_OK,
+                        bmp280_bus_batch_mux_dev_init(&mux_sim_batch_devs[i], &mux_sim_batch, dev_addr, channel));
+            BMP280InitCfg init_cfg = {
+                .get_inst_buf = sim_fixture_get_inst_buf,
+                .get_inst_buf_user_data = NULL,
+                .read_regs = bmp280_bus_batch_read_regs,
+                .read_regs_user_data = (void *)&mux_sim_batch_devs[i],
+                .write_reg = bmp280_bus_batch_write_reg,
+                .write_reg_user_data = (void *)&mux_sim_batch_devs[i],
+                .start_timer = sim_start_timer,
+                .start_timer_user_data = NULL,
+                .lazy_init_meas = false,
+            };
+            CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_create(&mux_sim_sensors[i].inst, &init_cfg));
+            CHECK_EQUAL(BMP280_RESULT_CODE_OK,
+                        bmp280_init_meas(mux_sim_sensors[i].inst, mux_sim_init_done_cb, (void *)(uintptr_t)i));
+        }
+        sim_schedule_us(0, mux_sim_flush_tick, NULL);
+        sim_run_until_us(sim_now_us() + 100000);
+        for (size_t i = 0; i < MUX_SIM_NUM_SENSORS; i++) {
+            CHECK_TRUE(mux_sim_sensors[i].init_done);
+        }
+
+        /* Staggered starts, so that the sensors of a channel do not fall into the same flush by construction */
+        for (size_t i = 0; i < MUX_SIM_NUM_SENSORS; i++) {
+            sim_schedule_us((i * 5 % MUX_SIM_MEAS_TIME_MS) * 1000 + i * 100, mux_sim_start_sensor,
+                            (void *)(uintptr_t)i);
+        }
+        uint64_t start_transactions = mux_sim_bus.num_transactions;
+        uint64_t start_bytes = mux_sim_bus.num_bytes;
+        uint64_t start_selects = mux_sim_mux.num_selects;
+        sim_run_until_us(sim_now_us() + MUX_SIM_DURATION_US);
+
+        MuxSimResult result = {0, 0, 0, 0, UINT32_MAX};
+        for (size_t i = 0; i < MUX_SIM_NUM_SENSORS; i++) {
+            CHECK_EQUAL(0, mux_sim_sensors[i].num_errors);
+            result.num_samples += mux_sim_sensors[i].num_samples;
+            if (mux_sim_sensors[i].num_samples < result.min_sensor_samples) {
+                result.min_sensor_samples = mux_sim_sensors[i].num_samples;
+            }
+        }
+        CHECK_EQUAL(0, mux_sim_mux.num_errors);
+        uint64_t num_transactions = mux_sim_bus.num_transactions - start_transactions;
+        result.num_selects = mux_sim_mux.num_selects - start_selects;
+        result.num_dev_transfers = num_transactions - result.num_selects;
+        result.bus_time_us = num_transactions * mux_sim_bus.overhead_us +
+                             (mux_sim_bus.num_bytes - start_bytes) * mux_sim_bus.byte_time_us;
+        return result;
+    }
+
+    void print(const char *name, const MuxSimResult *r) {
+        printf("mux: %-22s %6llu samples, %.2f selects/sample, bus %.1f%% busy, min %u samples/sensor\n", name,
+               (unsigned long long)r->num_samples, (double)r->num_selects / (double)r->num_samples,
+               100.0 * (double)r->bus_time_us / MUX_SIM_DURATION_US, r->min_sensor_samples);
+    }
+};
+// clang-format on
+
+TEST(BMP280BusBatchMuxBench, SelectsPerSample)
+{
+    MuxSimResult in_order = run(true, 0);
+    MuxSimResult grouped = run(false, 0);
+    MuxSimResult held = run(false, 2);
+
+    /* A layer that does not track the mux state selects the channel before every device transfer */
+    printf("\nmux: %-22s %6llu samples, %.2f selects/sample\n", "select every transfer",
+           (unsigned long long)in_order.num_samples,
+           (double)in_order.num_dev_transfers / (double)in_order.num_samples);
+    print("queue order", &in_order);
+    print("grouped", &grouped);
+    print("grouped, hold 2", &held);
+}
@@ -0,0 +1,72 @@
+#include <stdio.h>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280_capture.h"
+
+/* 1013.25 hPa in Q24.8 Pa */
+#define CAPTURE_SEA_LEVEL_PRES (101325U * 256U)
+/* 1 Pa in Q24.8 */
+#define CAPTURE_PA 256U
+
+static void record_sample(uint32_t event_seq, uint32_t timestamp_ms, const BMP280Meas *meas, void *user_data)
+{
+    (void)event_seq;
+    (void)timestamp_ms;
+    (void)meas;
+    (void)user_data;
+}
+
+/* Pseudo-random noise in [-amplitude, amplitude], reproducible across runs */
+static int32_t noise(uint32_t *state, uint32_t amplitude)
+{
+    *state = *state * 1664525U + 1013904223U;
+    return (int32_t)((*state >> 8) % (2 * amplitude + 1)) - (int32_t)amplitude;
+}
+
+// clang-format off
+TEST_GROUP(BMP280CaptureBench)
+{
+};
+// clang-format on
+
+TEST(BMP280CaptureBench, HourWithFewEventsRecordsSmallFraction)
+{
+    BMP280CaptureSample ring[25];
+    BMP280CaptureCfg cfg;
+    cfg.ring = ring;
+    cfg.ring_capacity = 25;
+    cfg.post_trigger_samples = 50;
+    cfg.baseline_shift = 8;
+    cfg.cusum_drift = 4 * CAPTURE_PA;
+    cfg.cusum_threshold = 32 * CAPTURE_PA;
+    cfg.jump_threshold = 50 * CAPTURE_PA;
+    cfg.record = record_sample;
+    cfg.record_user_data = NULL;
+    BMP280Capture capture;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_capture_init(&capture, &cfg));
+
+    /* One hour at 25 Hz with slow weather drift and noise, and three lift rides of five floors, 2 s per floor */
+    const uint32_t num_samples = 3600 * 25;
+    const uint32_t ride_starts[] = {20000, 50000, 80000};
+    const uint32_t ride_len = 5 * 50;
+    uint32_t state = 3;
+    int64_t level = 0;
+    for (uint32_t i = 0; i < num_samples; i++) {
+        for (size_t r = 0; r < 3; r++) {
+            if (i >= ride_starts[r] && i < ride_starts[r] + ride_len) {
+                /* Up for the first and third ride, down for the second */
+                int64_t step = (int64_t)36 * CAPTURE_PA / 50;
+                level += (r == 1) ? step : -step;
+            }
+        }
+        int64_t drift = (int64_t)200 * CAPTURE_PA * i / num_samples;
+        BMP280Meas meas = {2508, (uint32_t)((int64_t)CAPTURE_SEA_LEVEL_PRES - drift + level +
+                                            noise(&state, 3 * CAPTURE_PA))};
+        bmp280_capture_add(&capture, 40 * (i + 1), &meas);
+    }
+
+    double fraction = (double)capture.num_recorded / (double)capture.num_samples;
+    printf("\ncapture: %u events, %llu of %llu samples recorded (%.2f%%)\n", (unsigned)capture.num_events,
+           (unsigned long long)capture.num_recorded, (unsigned long long)capture.num_samples, 100.0 * fraction);
+}
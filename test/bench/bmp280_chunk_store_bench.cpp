@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <vector>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280_chunk_store.h"
+
+/* Slowly varying values around the datasheet example, so that deltas are small */
+static BMP280Meas sample_meas(size_t i)
+{
+    BMP280Meas meas;
+    meas.temperature = 2508 + (int32_t)(i % 50) - 25;
+    meas.pressure = 25767233 + (uint32_t)((i * 97) % 2000);
+    return meas;
+}
+
+static double elapsed_ms(const struct timespec *start, const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) * 1e3 + (double)(end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+// clang-format off
+TEST_GROUP(BMP280ChunkStoreBench)
+{
+};
+// clang-format on
+
+TEST(BMP280ChunkStoreBench, DayQueryOverYearOfHistory)
+{
+    /* One sample per 10 s for a year, one chunk per hour */
+    BMP280ChunkStoreCfg cfg;
+    cfg.sensor_id = 42;
+    cfg.chunk_duration_ms = 3600000;
+    cfg.num_chunks = 366 * 24;
+    cfg.ts_col_size = 512;
+    cfg.temp_col_size = 512;
+    cfg.pres_col_size = 1024;
+    size_t size = bmp280_chunk_store_mem_size(&cfg);
+    std::vector<uint64_t> mem((size + 7) / 8, 0);
+    BMP280ChunkStore store;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_chunk_store_format(&store, mem.data(), size, &cfg));
+    const size_t num_samples = 366 * 24 * 360;
+    for (size_t i = 0; i < num_samples; i++) {
+        BMP280Meas meas = sample_meas(i);
+        bmp280_chunk_store_append(&store, (uint64_t)i * 10000, &meas);
+    }
+    printf("\nChunk store: %zu samples in %zu bytes, %.2f bytes per sample\n", num_samples, mem.size() * 8,
+           (double)(mem.size() * 8) / (double)num_samples);
+
+    struct timespec t0, t1, t2;
+    BMP280ChunkStoreFilter filter;
+    BMP280ChunkStoreQueryStats day_stats, all_stats;
+    uint64_t day_start = 200ULL * 24 * 3600000;
+    bmp280_chunk_store_filter_init(&filter, day_start, day_start + 24 * 3600000 - 1);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    bmp280_chunk_store_query(&store, &filter, NULL, NULL, &day_stats);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    bmp280_chunk_store_filter_init(&filter, 0, UINT64_MAX);
+    bmp280_chunk_store_query(&store, &filter, NULL, NULL, &all_stats);
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+    printf("Chunk store: one day in %.3f ms (%zu chunks skipped), full scan in %.3f ms\n", elapsed_ms(&t0, &t1),
+           day_stats.num_chunks_skipped, elapsed_ms(&t1, &t2));
+}
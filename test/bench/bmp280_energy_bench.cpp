@@ -0,0 +1,115 @@
+#include <stdio.h>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280.h"
+#include "bmp280_energy.h"
+#include "sim.h"
+#include "sim_bmp280.h"
+#include "sim_fixture.h"
+
+/* 0.35 mA of pull-up current for the 70 us overhead and 23 us per byte of the simulated bus */
+#define ENERGY_BUS_TRANSACTION_FC (70ULL * 350000)
+#define ENERGY_BUS_BYTE_FC (23ULL * 350000)
+
+static BMP280 bmp280;
+static SimBus sim_bus;
+static SimBMP280 sim_dev;
+static BMP280Energy energy;
+static BMP280Meas meas;
+
+static uint32_t energy_now_us(void *user_data)
+{
+    (void)user_data;
+    return (uint32_t)sim_now_us();
+}
+
+static void energy_complete_cb(uint8_t rc, void *user_data)
+{
+    (void)user_data;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+}
+
+// clang-format off
+TEST_GROUP(BMP280EnergyBench){
+    void setup() {
+        sim_reset();
+        sim_fixture_reset_inst_bufs();
+        sim_bus_init(&sim_bus, 70, 23);
+        sim_bmp280_init(&sim_dev, &sim_bus, sim_fixture_calib_data);
+        sim_dev.temp_raw = 519888;
+        sim_dev.pres_raw = 415148;
+
+        BMP280EnergyCfg energy_cfg = {
+            .currents = BMP280_ENERGY_DATASHEET_CURRENTS,
+            .bus_transaction_fc = ENERGY_BUS_TRANSACTION_FC,
+            .bus_byte_fc = ENERGY_BUS_BYTE_FC,
+            .now_us = energy_now_us,
+            .now_us_user_data = NULL,
+            .read_regs = sim_bmp280_read_regs,
+            .read_regs_user_data = (void *)&sim_dev,
+            .write_reg = sim_bmp280_write_reg,
+            .write_reg_user_data = (void *)&sim_dev,
+        };
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_energy_init(&energy, &energy_cfg));
+
+        BMP280InitCfg cfg = {
+            .get_inst_buf = sim_fixture_get_inst_buf,
+            .get_inst_buf_user_data = NULL,
+            .read_regs = bmp280_energy_read_regs,
+            .read_regs_user_data = (void *)&energy,
+            .write_reg = bmp280_energy_write_reg,
+            .write_reg_user_data = (void *)&energy,
+            .start_timer = sim_start_timer,
+            .start_timer_user_data = NULL,
+            .lazy_init_meas = false,
+        };
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_create(&bmp280, &cfg));
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_init_meas(bmp280, energy_complete_cb, NULL));
+        sim_run();
+    }
+
+    void teardown() {
+        /* Releases the memory of the event heap, so that it is not reported as a leak */
+        sim_reset();
+    }
+};
+// clang-format on
+
+TEST(BMP280EnergyBench, ForcedModeRead)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK,
+                bmp280_energy_read_meas_forced_mode(bmp280, &energy, BMP280_OVERSAMPLING_1, BMP280_OVERSAMPLING_1,
+                                                    &meas, energy_complete_cb, NULL));
+    sim_run();
+    printf("\nenergy: forced mode read at 1x oversampling %.3f uC\n", energy.counters.last_op_fc / 1e9);
+}
+
+TEST(BMP280EnergyBench, PlannedAndMeasuredCurrent)
+{
+    uint64_t total_before = bmp280_energy_total_fc(&energy);
+    uint64_t start_us = sim_now_us();
+
+    /* 1 Hz for 60 s */
+    for (int i = 0; i < 60; i++) {
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK,
+                    bmp280_energy_read_meas_forced_mode(bmp280, &energy, BMP280_OVERSAMPLING_1,
+                                                        BMP280_OVERSAMPLING_1, &meas, energy_complete_cb, NULL));
+        sim_run_until_us(start_us + (uint64_t)(i + 1) * 1000000);
+    }
+
+    uint64_t measured_na = (bmp280_energy_total_fc(&energy) - total_before) / 60000000;
+    uint32_t planned_na =
+        bmp280_energy_plan_current_na(&energy.cfg, BMP280_OVERSAMPLING_1, BMP280_OVERSAMPLING_1, 1000);
+    printf("\nenergy: 1 Hz at 1x oversampling %.3f uA planned, %.3f uA measured, datasheet 2.74 uA\n",
+           planned_na / 1000.0, measured_na / 1000.0);
+}
+
+TEST(BMP280EnergyBench, OversamplingAgainstSoftwareAveraging)
+{
+    /* Same noise reduction: one 16x pressure sample per second, or 16 samples at 1x averaged, one every 62 ms */
+    uint32_t hw_na = bmp280_energy_plan_current_na(&energy.cfg, BMP280_OVERSAMPLING_2, BMP280_OVERSAMPLING_16, 1000);
+    uint32_t sw_na = bmp280_energy_plan_current_na(&energy.cfg, BMP280_OVERSAMPLING_1, BMP280_OVERSAMPLING_1, 62);
+    printf("\nenergy: 1 Hz at 16x oversampling %.3f uA, 16 Hz at 1x oversampling %.3f uA\n", hw_na / 1000.0,
+           sw_na / 1000.0);
+}
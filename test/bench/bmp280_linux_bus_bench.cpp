@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280.h"
+#include "bmp280_linux_bus.h"
+#include "sim_fixture.h"
+
+static const uint32_t linux_bus_speeds_hz[] = {1000000, 2000000, 4000000, 5000000, 8000000, 10000000};
+
+#define LINUX_BUS_NUM_SPEEDS (sizeof(linux_bus_speeds_hz) / sizeof(linux_bus_speeds_hz[0]))
+/* File descriptor of the simulated device, it has chip select index 0 */
+#define LINUX_BUS_FAKE_FD 42
+
+/* Simulated BMP280 on a line that is stable at every speed */
+static struct {
+    uint8_t regs[256];
+    /* Sum of clock cycle durations */
+    uint64_t bus_time_ns;
+} fake;
+
+static int fake_spi_ioctl(int fd, unsigned long request, void *arg)
+{
+    (void)fd;
+    size_t num_xfers = _IOC_SIZE(request) / sizeof(struct spi_ioc_transfer);
+    struct spi_ioc_transfer *xfers = (struct spi_ioc_transfer *)arg;
+    for (size_t i = 0; i < num_xfers; i++) {
+        struct spi_ioc_transfer *xfer = &xfers[i];
+        fake.bus_time_ns += (uint64_t)xfer->len * 8 * 1000000000ULL / xfer->speed_hz;
+        if (!xfer->tx_buf) {
+            continue;
+        }
+        const uint8_t *tx = (const uint8_t *)(uintptr_t)xfer->tx_buf;
+        if (xfer->len == 2) {
+            fake.regs[tx[0] | 0x80] = tx[1];
+            continue;
+        }
+        /* Register address, followed by the data read */
+        struct spi_ioc_transfer *data_xfer = &xfers[++i];
+        uint8_t *rx = (uint8_t *)(uintptr_t)data_xfer->rx_buf;
+        for (size_t j = 0; j < data_xfer->len; j++) {
+            rx[j] = fake.regs[((tx[0] & 0x7F) | 0x80) + j];
+        }
+        fake.bus_time_ns += (uint64_t)data_xfer->len * 8 * 1000000000ULL / data_xfer->speed_hz;
+    }
+    return 0;
+}
+
+static void linux_bus_submit_complete_cb(void *user_data)
+{
+    (void)user_data;
+}
+
+/* One forced mode sample through the batch submit function: ctrl_meas write and 6 byte data read */
+static void submit_sample(BMP280LinuxSpiBus *bus)
+{
+    uint8_t data[6];
+    BMP280BusTransfer transfers[2];
+    memset(transfers, 0, sizeof(transfers));
+    transfers[0].reg_addr = 0xF4;
+    transfers[0].write_val = 0x25;
+    transfers[0].next = &transfers[1];
+    transfers[1].reg_addr = 0xF7;
+    transfers[1].is_read = true;
+    transfers[1].data = data;
+    transfers[1].len = sizeof(data);
+    bmp280_linux_spi_submit(transfers, 2, (void *)bus, linux_bus_submit_complete_cb, NULL);
+}
+
+// clang-format off
+TEST_GROUP(BMP280LinuxBusBench)
+{
+};
+// clang-format on
+
+TEST(BMP280LinuxBusBench, ClockTimePerSample)
+{
+    memset(&fake, 0, sizeof(fake));
+    fake.regs[0xD0] = 0x58;
+    memcpy(&fake.regs[0x88], sim_fixture_calib_data, sizeof(sim_fixture_calib_data));
+    BMP280LinuxSpiBus bus;
+    int fds[1] = {LINUX_BUS_FAKE_FD};
+    bmp280_linux_spi_bus_init(&bus, fds, 1);
+    bus.ioctl_fn = fake_spi_ioctl;
+    BMP280LinuxSpiTuneCfg cfg;
+    cfg.speeds_hz = linux_bus_speeds_hz;
+    cfg.num_speeds = LINUX_BUS_NUM_SPEEDS;
+    cfg.num_reads = 8;
+    cfg.margin_steps = 1;
+    cfg.window_transactions = 100;
+    cfg.max_window_errors = 5;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_linux_spi_tune(&bus, 0, &cfg));
+
+    fake.bus_time_ns = 0;
+    submit_sample(&bus);
+    uint64_t tuned_ns = fake.bus_time_ns;
+    bus.clocks[0].speed_hz = linux_bus_speeds_hz[0];
+    fake.bus_time_ns = 0;
+    submit_sample(&bus);
+    uint64_t base_ns = fake.bus_time_ns;
+    printf("\nlinux bus: SPI clock time per sample %.1f us at 1 MHz, %.1f us tuned\n", base_ns / 1000.0,
+           tuned_ns / 1000.0);
+}
@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <time.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280_stats.h"
+#include "sim_bmp280.h"
+
+#define STATS_NUM_SENSORS 10000
+#define STATS_NUM_BUSES 100
+
+static BMP280SensorStats many_sensors[STATS_NUM_SENSORS];
+static BMP280BusStats many_buses[STATS_NUM_BUSES];
+static BMP280SensorSnapshot many_sensor_snapshots[STATS_NUM_SENSORS];
+static BMP280BusSnapshot many_bus_snapshots[STATS_NUM_BUSES];
+static uint32_t fake_now_us;
+
+static uint32_t fake_now(void *user_data)
+{
+    (void)user_data;
+    return fake_now_us;
+}
+
+static double now_s()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static std::string serialize_all(const BMP280StatsRegistry *reg, size_t chunk_size)
+{
+    std::vector<char> buf(chunk_size);
+    std::string out;
+    BMP280StatsWriter writer;
+    bmp280_stats_writer_init(&writer, reg);
+    size_t len;
+    while ((len = bmp280_stats_serialize(&writer, buf.data(), buf.size())) > 0) {
+        out.append(buf.data(), len);
+    }
+    return out;
+}
+
+// clang-format off
+TEST_GROUP(BMP280StatsBench){
+    void setup() {
+        for (size_t i = 0; i < STATS_NUM_BUSES; i++) {
+            bmp280_stats_bus_init(&many_buses[i], (uint32_t)i);
+        }
+        for (size_t i = 0; i < STATS_NUM_SENSORS; i++) {
+            /* The register functions are never called, operations are recorded directly */
+            BMP280SensorStatsCfg cfg = {
+                .sensor_id = (uint32_t)(100000 + i),
+                .bus = &many_buses[i % STATS_NUM_BUSES],
+                .now_us = fake_now,
+                .now_us_user_data = NULL,
+                .read_regs = sim_bmp280_read_regs,
+                .read_regs_user_data = NULL,
+                .write_reg = sim_bmp280_write_reg,
+                .write_reg_user_data = NULL,
+            };
+            CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_stats_sensor_init(&many_sensors[i], &cfg));
+        }
+    }
+};
+// clang-format on
+
+/**
+ * @brief Scrape 10000 sensors while the acquisition thread keeps completing operations, then measure the cost of one
+ * recorded operation on the acquisition thread.
+ */
+TEST(BMP280StatsBench, ScrapeDuringAcquisition)
+{
+    BMP280StatsRegistry reg = {many_sensors,          STATS_NUM_SENSORS,    many_buses,
+                               STATS_NUM_BUSES,       many_sensor_snapshots, many_bus_snapshots};
+    std::atomic<bool> stop(false);
+
+    std::thread acquisition([&]() {
+        uint64_t n = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            BMP280SensorStats *s = &many_sensors[n % 16];
+            bmp280_stats_op_prepare(s, NULL, NULL);
+            bmp280_stats_op_submitted(s, BMP280_RESULT_CODE_OK);
+            fake_now_us += 3000;
+            bmp280_stats_complete_cb(BMP280_RESULT_CODE_OK, (void *)s);
+            n++;
+        }
+    });
+
+    double scrape_start = now_s();
+    std::string out = serialize_all(&reg, 65536);
+    double scrape_s = now_s() - scrape_start;
+    stop = true;
+    acquisition.join();
+
+    BMP280SensorStats *s = &many_sensors[0];
+    const size_t num_bench_ops = 1000000;
+    double op_start = now_s();
+    for (size_t i = 0; i < num_bench_ops; i++) {
+        bmp280_stats_op_prepare(s, NULL, NULL);
+        bmp280_stats_op_submitted(s, BMP280_RESULT_CODE_OK);
+        bmp280_stats_complete_cb(BMP280_RESULT_CODE_OK, (void *)s);
+    }
+    double op_ns = (now_s() - op_start) * 1e9 / (double)num_bench_ops;
+    printf("\nScrape of %d sensors: %zu bytes in %.2f ms on the exporter thread, %.1f ns per recorded operation on "
+           "the acquisition thread\n",
+           STATS_NUM_SENSORS, out.size(), scrape_s * 1e3, op_ns);
+}
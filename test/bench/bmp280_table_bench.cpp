@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280.h"
+#include "bmp280_table.h"
+#include "sim.h"
+#include "sim_bmp280.h"
+#include "sim_fixture.h"
+/* To include the definition of struct BMP280Struct, so that AosSensor can embed an instance. */
+#include "bmp280_private.h"
+
+static BMP280 inst;
+static SimBus sim_bus;
+static SimBMP280 sim_dev;
+
+static void table_init_complete_cb(uint8_t rc, void *user_data)
+{
+    (void)user_data;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+}
+
+// clang-format off
+TEST_GROUP(BMP280TableBench){
+    void setup() {
+        sim_reset();
+        sim_fixture_reset_inst_bufs();
+        sim_bus_init(&sim_bus, 70, 23);
+        sim_bmp280_init(&sim_dev, &sim_bus, sim_fixture_calib_data);
+        BMP280InitCfg cfg = {
+            .get_inst_buf = sim_fixture_get_inst_buf,
+            .get_inst_buf_user_data = NULL,
+            .read_regs = sim_bmp280_read_regs,
+            .read_regs_user_data = (void *)&sim_dev,
+            .write_reg = sim_bmp280_write_reg,
+            .write_reg_user_data = (void *)&sim_dev,
+            .start_timer = sim_start_timer,
+            .start_timer_user_data = NULL,
+            .lazy_init_meas = false,
+        };
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_create(&inst, &cfg));
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_init_meas(inst, table_init_complete_cb, NULL));
+        sim_run();
+    }
+
+    void teardown() {
+        /* Releases the memory of the event heap, so that it is not reported as a leak */
+        sim_reset();
+    }
+};
+// clang-format on
+
+static double elapsed_ms(const struct timespec *start, const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) * 1e3 + (double)(end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+/** What a scheduler without the table keeps per sensor: the instance and its schedule, side by side. */
+struct AosSensor {
+    struct BMP280Struct inst;
+    uint32_t next_due_ms;
+    uint32_t period_ms;
+    int32_t temp_raw;
+    int32_t pres_raw;
+};
+
+TEST(BMP280TableBench, ScanOf100kSensors)
+{
+    const size_t num_sensors = 100000;
+    const uint32_t num_ticks = 1000;
+
+    std::vector<BMP280> big_insts(num_sensors);
+    std::vector<uint8_t> big_state(num_sensors);
+    std::vector<uint32_t> big_next_due_ms(num_sensors);
+    std::vector<uint32_t> big_period_ms(num_sensors);
+    std::vector<BMP280CalibTemp> big_calib_temp(num_sensors);
+    std::vector<BMP280CalibPres> big_calib_pres(num_sensors);
+    std::vector<int32_t> big_temp_raw(num_sensors);
+    std::vector<int32_t> big_pres_raw(num_sensors);
+    std::vector<BMP280Meas> big_meas(num_sensors);
+    std::vector<size_t> idxs(num_sensors);
+    BMP280TableArrays big_arrays = {
+        .insts = big_insts.data(),
+        .state = big_state.data(),
+        .next_due_ms = big_next_due_ms.data(),
+        .period_ms = big_period_ms.data(),
+        .calib_temp = big_calib_temp.data(),
+        .calib_pres = big_calib_pres.data(),
+        .temp_raw = big_temp_raw.data(),
+        .pres_raw = big_pres_raw.data(),
+        .capacity = num_sensors,
+    };
+    BMP280Table big_table;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_table_init(&big_table, &big_arrays));
+    std::vector<AosSensor> aos(num_sensors);
+    for (size_t i = 0; i < num_sensors; i++) {
+        /* Periods of 100 ms, phases spread evenly: 1% of the sensors is due every ms */
+        uint32_t first_due_ms = (uint32_t)(i % 100);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_table_add(&big_table, inst, 100,
+                                                            first_due_ms, NULL));
+        aos[i].inst = *inst;
+        aos[i].next_due_ms = first_due_ms;
+        aos[i].period_ms = 100;
+    }
+
+    struct timespec start, end;
+    size_t total_table = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t now_ms = 0; now_ms < num_ticks; now_ms++) {
+        size_t num_due = bmp280_table_collect_due(&big_table, now_ms, idxs.data(), num_sensors);
+        for (size_t i = 0; i < num_due; i++) {
+            bmp280_table_set_frame(&big_table, idxs[i], sim_fixture_data_regs);
+        }
+        total_table += num_due;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double table_ms = elapsed_ms(&start, &end);
+
+    size_t total_aos = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t now_ms = 0; now_ms < num_ticks; now_ms++) {
+        size_t num_due = 0;
+        for (size_t i = 0; i < num_sensors; i++) {
+            AosSensor *s = &aos[i];
+            if (s->inst.seq_in_progress || (int32_t)(now_ms - s->next_due_ms) < 0) {
+                continue;
+            }
+            s->next_due_ms += s->period_ms;
+            idxs[num_due++] = i;
+        }
+        for (size_t i = 0; i < num_due; i++) {
+            aos[idxs[i]].temp_raw = 519888;
+            aos[idxs[i]].pres_raw = 415148;
+        }
+        total_aos += num_due;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double aos_ms = elapsed_ms(&start, &end);
+
+    /* Both scans found the same sensors due, and the totals are used so that the compiler keeps the work */
+    CHECK_EQUAL(total_table, total_aos);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    size_t num_compensated = bmp280_table_compensate(&big_table, big_meas.data());
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double compensate_ms = elapsed_ms(&start, &end);
+    CHECK_EQUAL(num_sensors, num_compensated);
+
+    printf("\nDue scan of %zu sensors: %.3f ms per tick with the table, %.3f ms per tick scanning instances; "
+           "compensation sweep: %.1f ns per sensor\n",
+           num_sensors, table_ms / num_ticks, aos_ms / num_ticks, compensate_ms * 1e6 / (double)num_sensors);
+}
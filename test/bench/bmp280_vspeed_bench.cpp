@@ -0,0 +1,103 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280_vspeed.h"
+
+/* 15 degC */
+#define VSPEED_TEMPERATURE 1500
+/* Scale height at VSPEED_TEMPERATURE in m */
+#define VSPEED_SCALE_HEIGHT_M (29.271 * 288.15)
+#define VSPEED_SEA_LEVEL_PA 101325.0
+/* 25 Hz */
+#define VSPEED_PERIOD_MS 40
+
+/* Q24.8 pressure at altitude_m above sea level */
+static uint32_t pressure_at(double altitude_m)
+{
+    return (uint32_t)lround(VSPEED_SEA_LEVEL_PA * exp(-altitude_m / VSPEED_SCALE_HEIGHT_M) * 256.0);
+}
+
+/* Pseudo-random noise in [-amplitude, amplitude] Q24.8 Pa, reproducible across runs */
+static int32_t noise(uint32_t *state, double amplitude_pa)
+{
+    *state = *state * 1664525U + 1013904223U;
+    int32_t amplitude = (int32_t)(amplitude_pa * 256);
+    return (int32_t)((*state >> 8) % (uint32_t)(2 * amplitude + 1)) - amplitude;
+}
+
+/* Steady-state Kalman gains in Q16 for the tracking index lambda */
+static void kalman_gains(double lambda, uint32_t *alpha, uint32_t *beta)
+{
+    double r = (4 + lambda - sqrt(8 * lambda + lambda * lambda)) / 4;
+    double a = 1 - r * r;
+    double b = 2 * (2 - a) - 4 * sqrt(1 - a);
+    *alpha = (uint32_t)lround(a * 65536);
+    *beta = (uint32_t)lround(b * 65536);
+}
+
+// clang-format off
+TEST_GROUP(BMP280VSpeedBench)
+{
+    BMP280VSpeedCfg cfg;
+    BMP280VSpeed est;
+    uint32_t timestamp_ms;
+
+    void setup()
+    {
+        /* Pressure noise of about 1.2 Pa RMS, vertical acceleration of about 1 m/s^2 */
+        kalman_gains(12.0 * 0.04 * 0.04 / 1.2, &cfg.alpha, &cfg.beta);
+        cfg.max_gap_ms = 1000;
+        timestamp_ms = 0;
+    }
+
+    void add(uint32_t pressure, uint32_t dt_ms = VSPEED_PERIOD_MS)
+    {
+        BMP280Meas meas = {VSPEED_TEMPERATURE, pressure};
+        timestamp_ms += dt_ms;
+        bmp280_vspeed_update(&est, timestamp_ms, &meas);
+    }
+};
+// clang-format on
+
+TEST(BMP280VSpeedBench, ClimbSpeedError)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_vspeed_init(&est, &cfg));
+    uint32_t state = 1;
+    double altitude_m = 0;
+    uint32_t prev_pressure = 0;
+    double sq_err_filter = 0;
+    double sq_err_naive = 0;
+    int num_err = 0;
+    int settle_samples = -1;
+
+    /* 20 s at rest, then a lift ride of 2 m/s for 60 s */
+    for (int i = 0; i < 80 * 25; i++) {
+        double speed_m_s = (i < 20 * 25) ? 0.0 : 2.0;
+        altitude_m += speed_m_s * VSPEED_PERIOD_MS / 1000.0;
+        uint32_t pressure = (uint32_t)((int32_t)pressure_at(altitude_m) + noise(&state, 2.0));
+        add(pressure);
+
+        int32_t speed_mm_s = bmp280_vspeed_speed_mm_s(&est);
+        if (speed_m_s > 0 && settle_samples < 0 && abs(speed_mm_s - 2000) < 200) {
+            settle_samples = i - 20 * 25;
+        }
+        if (i > 0 && (i < 20 * 25 - 1 || i >= 25 * 25)) {
+            /* Naive differencing of successive samples, converted with the local scale height */
+            double dp_pa = ((double)pressure - (double)prev_pressure) / 256.0;
+            double naive_m_s = -dp_pa / (VSPEED_PERIOD_MS / 1000.0) * VSPEED_SCALE_HEIGHT_M / (pressure / 256.0);
+            sq_err_naive += (naive_m_s - speed_m_s) * (naive_m_s - speed_m_s);
+            double err_m_s = speed_mm_s / 1000.0 - speed_m_s;
+            sq_err_filter += err_m_s * err_m_s;
+            num_err++;
+        }
+        prev_pressure = pressure;
+    }
+
+    double rms_filter = sqrt(sq_err_filter / num_err);
+    double rms_naive = sqrt(sq_err_naive / num_err);
+    printf("\nvspeed: RMS speed error %.3f m/s filtered, %.3f m/s differencing, within 10%% after %d samples\n",
+           rms_filter, rms_naive, settle_samples);
+}
@@ -75,6 +75,7 @@ static void populate_default_init_cfg(BMP280InitCfg *const cfg)
     cfg->write_reg_user_data = write_reg_user_data;
     cfg->start_timer = mock_bmp280_start_timer;
     cfg->start_timer_user_data = start_timer_user_data;
+    cfg->lazy_init_meas = false;
 }
 
 // clang-format off
@@ -302,8 +303,18 @@ typedef struct {
     int32_t *temperature;
     /** Expected pressure measurement value. If NULL, check is not performed - useful when testing error scenarios. */
     uint32_t *pressure;
+    /** If true, temperature lookup table is enabled after bmp280_init_meas. The table covers the raw temperature value
+     * from the datasheet example, and its entry for that value holds TEMP_LUT_MARKER_TEMPERATURE. */
+    bool use_temp_lut;
 } ReadMeasForcedModeTestCfg;
 
+/** Entries of the temperature lookup table that is enabled if use_temp_lut is true. */
+static BMP280TempLutEntry temp_lut_entries[64];
+static BMP280TempLut temp_lut;
+/** Temperature that the lookup table returns for the datasheet raw value. Differs from the calculated 2508, so that
+ * a test can tell whether the table was used. t_fine of the entry is kept, so pressure is unaffected. */
+#define TEMP_LUT_MARKER_TEMPERATURE 2599
+
 static void call_init_meas(const uint8_t *const calib_data)
 {
     void *complete_cb_user_data = (void *)0xA3;
@@ -335,6 +346,14 @@ static void test_read_meas_forced_mode(const ReadMeasForcedModeTestCfg *const cf
     uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
     CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
     call_init_meas(cfg->calib_data);
+    if (cfg->use_temp_lut) {
+        /* Raw temperature value 519888 from datasheet example is in the middle of the table */
+        uint8_t rc_enable_temp_lut =
+            bmp280_enable_temp_lut(bmp280, &temp_lut, temp_lut_entries, 64, 519888 - 32 * 16, 4);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_enable_temp_lut);
+        CHECK_EQUAL(2508, temp_lut_entries[32].temperature);
+        temp_lut_entries[32].temperature = TEMP_LUT_MARKER_TEMPERATURE;
+    }
 
     /* Called from bmp280_read_meas_forced_mode */
     mock()
@@ -566,6 +585,36 @@ TEST(BMP280, ReadMeasForcedModeTempAndPres)
     test_read_meas_forced_mode(&cfg);
 }
 
+TEST(BMP280, ReadMeasForcedModeTempAndPresTempLut)
+{
+    /* Pres 415148, temp 519888, example from datasheet p.23 */
+    uint8_t read_3_data[] = {0x65, 0x5A, 0xC0, 0x7E, 0xED, 0x0};
+    /* Served from the seeded table entry instead of the calculated 2508 */
+    int32_t temperature = TEMP_LUT_MARKER_TEMPERATURE;
+    /* Should be 25767236 according to the example, but a small difference is expected due to integer calculation
+     * rounding errors. */
+    uint32_t pressure = 25767233;
+    ReadMeasForcedModeTestCfg cfg = {
+        .calib_data = default_calib_data,
+        .meas_type = BMP280_MEAS_TYPE_TEMP_AND_PRES,
+        .read_1_data = 0x01,
+        .read_1_io_rc = BMP280_IO_RESULT_CODE_OK,
+        /* Keeps the 6 MSb the same as read_1_data, and sets the 2 LSb to 01 (forced mode) */
+        .write_2_data = 0x01,
+        .write_2_io_rc = BMP280_IO_RESULT_CODE_OK,
+        .meas_time_ms = 5,
+        .read_3_data = read_3_data,
+        .read_3_data_size = 6,
+        .read_3_io_rc = BMP280_IO_RESULT_CODE_OK,
+        .complete_cb = mock_bmp280_complete_cb,
+        .complete_cb_rc = BMP280_RESULT_CODE_OK,
+        .temperature = &temperature,
+        .pressure = &pressure,
+        .use_temp_lut = true,
+    };
+    test_read_meas_forced_mode(&cfg);
+}
+
 TEST(BMP280, ReadMeasForcedModeOnlyTemp2)
 {
     /* Temp 500000 */
@@ -771,6 +820,592 @@ TEST(BMP280, ReadMeasForcedModeCalledAfterInitMeasFailed)
     CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_USAGE, rc);
 }
 
+/* Pres 415148, temp 519888, example from datasheet p.23 */
+static uint8_t lazy_init_meas_data_regs[] = {0x65, 0x5A, 0xC0, 0x7E, 0xED, 0x0};
+/* ctrl_meas value: temperature and pressure oversampling x1, sleep mode */
+static uint8_t lazy_init_meas_ctrl_meas = 0x24;
+
+/**
+ * @brief Expect the calls of a lazy read_meas_forced_mode up to the calibration readout.
+ *
+ * Read ctrl_meas, write forced mode to ctrl_meas, then start the timer and read out calibration values in the same
+ * write complete callback. Measurement time is 5 ms.
+ */
+static void expect_lazy_init_meas_read_meas_start()
+{
+    mock()
+        .expectOneCall("mock_bmp280_read_regs")
+        .withParameter("start_addr", 0xF4)
+        .withParameter("num_regs", 1)
+        .withOutputParameterReturning("data", &lazy_init_meas_ctrl_meas, 1)
+        .withParameter("user_data", read_regs_user_data)
+        .ignoreOtherParameters();
+    mock()
+        .expectOneCall("mock_bmp280_write_reg")
+        .withParameter("addr", 0xF4)
+        .withParameter("reg_val", 0x25)
+        .withParameter("user_data", write_reg_user_data)
+        .ignoreOtherParameters();
+    mock()
+        .expectOneCall("mock_bmp280_start_timer")
+        .withParameter("duration_ms", (uint32_t)5)
+        .withParameter("user_data", start_timer_user_data)
+        .ignoreOtherParameters();
+    mock()
+        .expectOneCall("mock_bmp280_read_regs")
+        .withParameter("start_addr", 0x88)
+        .withParameter("num_regs", 24)
+        .withOutputParameterReturning("data", default_calib_data, 24)
+        .withParameter("user_data", read_regs_user_data)
+        .ignoreOtherParameters();
+}
+
+static void expect_lazy_init_meas_read_data_regs()
+{
+    mock()
+        .expectOneCall("mock_bmp280_read_regs")
+        .withParameter("start_addr", 0xF7)
+        .withParameter("num_regs", 6)
+        .withOutputParameterReturning("data", lazy_init_meas_data_regs, 6)
+        .withParameter("user_data", read_regs_user_data)
+        .ignoreOtherParameters();
+}
+
+/**
+ * @brief Run a lazy read_meas_forced_mode until the calibration readout has been started.
+ */
+static void start_lazy_init_meas_read_meas(BMP280Meas *meas, void *complete_cb_user_data)
+{
+    uint8_t rc = bmp280_read_meas_forced_mode(bmp280, BMP280_MEAS_TYPE_TEMP_AND_PRES, 5, meas, mock_bmp280_complete_cb,
+                                              complete_cb_user_data);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    read_regs_complete_cb(BMP280_IO_RESULT_CODE_OK, read_regs_complete_cb_user_data);
+    write_reg_complete_cb(BMP280_IO_RESULT_CODE_OK, write_reg_complete_cb_user_data);
+}
+
+TEST(BMP280, ReadMeasForcedModeLazyInitMeasCalibReadBeforeTimerExpires)
+{
+    init_cfg.lazy_init_meas = true;
+    uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
+
+    void *complete_cb_user_data = (void *)0xA7;
+    expect_lazy_init_meas_read_meas_start();
+    expect_lazy_init_meas_read_data_regs();
+    mock()
+        .expectOneCall("mock_bmp280_complete_cb")
+        .withParameter("rc", BMP280_RESULT_CODE_OK)
+        .withParameter("user_data", complete_cb_user_data);
+
+    BMP280Meas meas;
+    start_lazy_init_meas_read_meas(&meas, complete_cb_user_data);
+    /* Calibration readout complete. Data registers are not read before the conversion is complete. */
+    read_regs_complete_cb(BMP280_IO_RESULT_CODE_OK, read_regs_complete_cb_user_data);
+    timer_expired_cb(timer_expired_cb_user_data);
+    read_regs_complete_cb(BMP280_IO_RESULT_CODE_OK, read_regs_complete_cb_user_data);
+
+    CHECK_EQUAL(2508, meas.temperature);
+    CHECK_EQUAL(25767233, meas.pressure);
+}
+
+TEST(BMP280, ReadMeasForcedModeLazyInitMeasTimerExpiresBeforeCalibRead)
+{
+    init_cfg.lazy_init_meas = true;
+    uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
+
+    void *complete_cb_user_data = (void *)0xA8;
+    expect_lazy_init_meas_read_meas_start();
+    expect_lazy_init_meas_read_data_regs();
+    mock()
+        .expectOneCall("mock_bmp280_complete_cb")
+        .withParameter("rc", BMP280_RESULT_CODE_OK)
+        .withParameter("user_data", complete_cb_user_data);
+
+    BMP280Meas meas;
+    start_lazy_init_meas_read_meas(&meas, complete_cb_user_data);
+    /* Data registers are not read before calibration readout is complete */
+    timer_expired_cb(timer_expired_cb_user_data);
+    read_regs_complete_cb(BMP280_IO_RESULT_CODE_OK, read_regs_complete_cb_user_data);
+    read_regs_complete_cb(BMP280_IO_RESULT_CODE_OK, read_regs_complete_cb_user_data);
+
+    CHECK_EQUAL(2508, meas.temperature);
+    CHECK_EQUAL(25767233, meas.pressure);
+}
+
+TEST(BMP280, ReadMeasForcedModeLazyInitMeasCalibReadFail)
+{
+    init_cfg.lazy_init_meas = true;
+    uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
+
+    void *complete_cb_user_data = (void *)0xA9;
+    expect_lazy_init_meas_read_meas_start();
+    /* Executed only after the timer expires, so that the timer does not fire into the next sequence */
+    mock()
+        .expectOneCall("mock_bmp280_complete_cb")
+        .withParameter("rc", BMP280_RESULT_CODE_IO_ERR)
+        .withParameter("user_data", complete_cb_user_data);
+    /* Calibration values were not loaded, so the next measurement reads them out again */
+    expect_lazy_init_meas_read_meas_start();
+    expect_lazy_init_meas_read_data_regs();
+    mock()
+        .expectOneCall("mock_bmp280_complete_cb")
+        .withParameter("rc", BMP280_RESULT_CODE_OK)
+        .withParameter("user_data", complete_cb_user_data);
+
+    BMP280Meas meas;
+    start_lazy_init_meas_read_meas(&meas, complete_cb_user_data);
+    read_regs_complete_cb(BMP280_IO_RESULT_CODE_ERR, read_regs_complete_cb_user_data);
+    timer_expired_cb(timer_expired_cb_user_data);
+
+    start_lazy_init_meas_read_meas(&meas, complete_cb_user_data);
+    read_regs_complete_cb(BMP280_IO_RESULT_CODE_OK, read_regs_complete_cb_user_data);
+    timer_expired_cb(timer_expired_cb_user_data);
+    read_regs_complete_cb(BMP280_IO_RESULT_CODE_OK, read_regs_complete_cb_user_data);
+
+    CHECK_EQUAL(2508, meas.temperature);
+    CHECK_EQUAL(25767233, meas.pressure);
+}
+
+TEST(BMP280, ReadMeasForcedModeLazyInitMeasSecondMeasDoesNotReadCalib)
+{
+    init_cfg.lazy_init_meas = true;
+    uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
+
+    void *complete_cb_user_data = (void *)0xAA;
+    expect_lazy_init_meas_read_meas_start();
+    expect_lazy_init_meas_read_data_regs();
+    mock()
+        .expectOneCall("mock_bmp280_complete_cb")
+        .withParameter("rc", BMP280_RESULT_CODE_OK)
+        .withParameter("user_data", complete_cb_user_data);
+
+    BMP280Meas meas;
+    start_lazy_init_meas_read_meas(&meas, complete_cb_user_data);
+    read_regs_complete_cb(BMP280_IO_RESULT_CODE_OK, read_regs_complete_cb_user_data);
+    timer_expired_cb(timer_expired_cb_user_data);
+    read_regs_complete_cb(BMP280_IO_RESULT_CODE_OK, read_regs_complete_cb_user_data);
+
+    /* Second measurement: same sequence as after bmp280_init_meas */
+    mock()
+        .expectOneCall("mock_bmp280_read_regs")
+        .withParameter("start_addr", 0xF4)
+        .withParameter("num_regs", 1)
+        .withOutputParameterReturning("data", &lazy_init_meas_ctrl_meas, 1)
+        .withParameter("user_data", read_regs_user_data)
+        .ignoreOtherParameters();
+    mock()
+        .expectOneCall("mock_bmp280_write_reg")
+        .withParameter("addr", 0xF4)
+        .withParameter("reg_val", 0x25)
+        .withParameter("user_data", write_reg_user_data)
+        .ignoreOtherParameters();
+    mock()
+        .expectOneCall("mock_bmp280_start_timer")
+        .withParameter("duration_ms", (uint32_t)5)
+        .withParameter("user_data", start_timer_user_data)
+        .ignoreOtherParameters();
+    expect_lazy_init_meas_read_data_regs();
+    mock()
+        .expectOneCall("mock_bmp280_complete_cb")
+        .withParameter("rc", BMP280_RESULT_CODE_OK)
+        .withParameter("user_data", complete_cb_user_data);
+
+    meas.temperature = 0;
+    meas.pressure = 0;
+    start_lazy_init_meas_read_meas(&meas, complete_cb_user_data);
+    timer_expired_cb(timer_expired_cb_user_data);
+    read_regs_complete_cb(BMP280_IO_RESULT_CODE_OK, read_regs_complete_cb_user_data);
+
+    CHECK_EQUAL(2508, meas.temperature);
+    CHECK_EQUAL(25767233, meas.pressure);
+}
+
+static void test_read_meas_forced_mode_with_oversampling(uint8_t temp_oversampling, uint8_t pres_oversampling,
+                                                         uint8_t ctrl_meas_val, uint32_t meas_time_ms)
+{
+    uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
+    call_init_meas(default_calib_data);
+
+    bool read_pres = (pres_oversampling != BMP280_OVERSAMPLING_SKIPPED);
+    void *complete_cb_user_data = (void *)0xB2;
+    /* No ctrl_meas read, oversampling options and forced mode are written at once */
+    mock()
+        .expectOneCall("mock_bmp280_write_reg")
+        .withParameter("addr", 0xF4)
+        .withParameter("reg_val", ctrl_meas_val)
+        .withParameter("user_data", write_reg_user_data)
+        .ignoreOtherParameters();
+    mock()
+        .expectOneCall("mock_bmp280_start_timer")
+        .withParameter("duration_ms", meas_time_ms)
+        .withParameter("user_data", start_timer_user_data)
+        .ignoreOtherParameters();
+    mock()
+        .expectOneCall("mock_bmp280_read_regs")
+        .withParameter("start_addr", read_pres ? 0xF7 : 0xFA)
+        .withParameter("num_regs", read_pres ? 6 : 3)
+        .withOutputParameterReturning("data", read_pres ? &lazy_init_meas_data_regs[0] : &lazy_init_meas_data_regs[3],
+                                      read_pres ? 6 : 3)
+        .withParameter("user_data", read_regs_user_data)
+        .ignoreOtherParameters();
+    mock()
+        .expectOneCall("mock_bmp280_complete_cb")
+        .withParameter("rc", BMP280_RESULT_CODE_OK)
+        .withParameter("user_data", complete_cb_user_data);
+
+    BMP280Meas meas;
+    uint8_t rc = bmp280_read_meas_forced_mode_with_oversampling(bmp280, temp_oversampling, pres_oversampling, &meas,
+                                                                mock_bmp280_complete_cb, complete_cb_user_data);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    write_reg_complete_cb(BMP280_IO_RESULT_CODE_OK, write_reg_complete_cb_user_data);
+    timer_expired_cb(timer_expired_cb_user_data);
+    read_regs_complete_cb(BMP280_IO_RESULT_CODE_OK, read_regs_complete_cb_user_data);
+
+    CHECK_EQUAL(2508, meas.temperature);
+    if (read_pres) {
+        CHECK_EQUAL(25767233, meas.pressure);
+    }
+}
+
+TEST(BMP280, ReadMeasForcedModeWithOversamplingX1X1)
+{
+    /* 1.25 + 2.3 + 2.3 + 0.575 = 6.425 ms */
+    test_read_meas_forced_mode_with_oversampling(BMP280_OVERSAMPLING_1, BMP280_OVERSAMPLING_1, 0x25, 7);
+}
+
+TEST(BMP280, ReadMeasForcedModeWithOversamplingX2X16)
+{
+    /* 1.25 + 2.3 * 2 + 2.3 * 16 + 0.575 = 43.225 ms */
+    test_read_meas_forced_mode_with_oversampling(BMP280_OVERSAMPLING_2, BMP280_OVERSAMPLING_16, 0x55, 44);
+}
+
+TEST(BMP280, ReadMeasForcedModeWithOversamplingX16PresSkipped)
+{
+    /* 1.25 + 2.3 * 16 = 38.05 ms */
+    test_read_meas_forced_mode_with_oversampling(BMP280_OVERSAMPLING_16, BMP280_OVERSAMPLING_SKIPPED, 0xA1, 39);
+}
+
+TEST(BMP280, ReadMeasForcedModeWithOversamplingTempSkipped)
+{
+    uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
+    call_init_meas(default_calib_data);
+
+    BMP280Meas meas;
+    uint8_t rc = bmp280_read_meas_forced_mode_with_oversampling(bmp280, BMP280_OVERSAMPLING_SKIPPED,
+                                                                BMP280_OVERSAMPLING_1, &meas, NULL, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, rc);
+}
+
+TEST(BMP280, ReadMeasForcedModeWithOversamplingInvalidPresOversampling)
+{
+    uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
+    call_init_meas(default_calib_data);
+
+    BMP280Meas meas;
+    uint8_t rc = bmp280_read_meas_forced_mode_with_oversampling(bmp280, BMP280_OVERSAMPLING_1, 6, &meas, NULL, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, rc);
+}
+
+TEST(BMP280, ReadMeasForcedModeWithOversamplingCalledBeforeInitMeas)
+{
+    uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
+
+    BMP280Meas meas;
+    uint8_t rc = bmp280_read_meas_forced_mode_with_oversampling(bmp280, BMP280_OVERSAMPLING_1, BMP280_OVERSAMPLING_1,
+                                                                &meas, NULL, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_USAGE, rc);
+}
+
+/* Sample and stop callbacks are told apart by user data */
+static void *continuous_sample_cb_user_data = (void *)0xB0;
+static void *continuous_stop_cb_user_data = (void *)0xB1;
+
+static void expect_continuous_write_forced()
+{
+    mock()
+        .expectOneCall("mock_bmp280_write_reg")
+        .withParameter("addr", 0xF4)
+        .withParameter("reg_val", 0x25)
+        .withParameter("user_data", write_reg_user_data)
+        .ignoreOtherParameters();
+}
+
+static void expect_continuous_start_timer()
+{
+    mock()
+        .expectOneCall("mock_bmp280_start_timer")
+        .withParameter("duration_ms", (uint32_t)5)
+        .withParameter("user_data", start_timer_user_data)
+        .ignoreOtherParameters();
+}
+
+static void expect_continuous_cb(void *user_data, uint8_t rc)
+{
+    mock().expectOneCall("mock_bmp280_complete_cb").withParameter("rc", rc).withParameter("user_data", user_data);
+}
+
+/**
+ * @brief Create an instance, init meas and start continuous forced mode up to the first forced mode write.
+ */
+static void start_continuous_forced_mode(BMP280Meas *meas)
+{
+    uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
+    call_init_meas(default_calib_data);
+
+    mock()
+        .expectOneCall("mock_bmp280_read_regs")
+        .withParameter("start_addr", 0xF4)
+        .withParameter("num_regs", 1)
+        .withOutputParameterReturning("data", &lazy_init_meas_ctrl_meas, 1)
+        .withParameter("user_data", read_regs_user_data)
+        .ignoreOtherParameters();
+    expect_continuous_write_forced();
+
+    uint8_t rc = bmp280_start_continuous_forced_mode(bmp280, BMP280_MEAS_TYPE_TEMP_AND_PRES, 5, meas,
+                                                     mock_bmp280_complete_cb, continuous_sample_cb_user_data);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    read_regs_complete_cb(BMP280_IO_RESULT_CODE_OK, read_regs_complete_cb_user_data);
+}
+
+TEST(BMP280, ContinuousForcedModeRetriggersBeforeSampleCb)
+{
+    BMP280Meas meas;
+    start_continuous_forced_mode(&meas);
+    /* ctrl_meas is read only once, every sample is one write, timer, and one data read. The next conversion is
+     * triggered before the sample callback. */
+    for (int i = 0; i < 3; i++) {
+        expect_continuous_start_timer();
+        expect_lazy_init_meas_read_data_regs();
+        expect_continuous_write_forced();
+        expect_continuous_cb(continuous_sample_cb_user_data, BMP280_RESULT_CODE_OK);
+    }
+
+    for (int i = 0; i < 3; i++) {
+        meas.temperature = 0;
+        meas.pressure = 0;
+        write_reg_complete_cb(BMP280_IO_RESULT_CODE_OK, write_reg_complete_cb_user_data);
+        timer_expired_cb(timer_expired_cb_user_data);
+        read_regs_complete_cb(BMP280_IO_RESULT_CODE_OK, read_regs_complete_cb_user_data);
+        CHECK_EQUAL(2508, meas.temperature);
+        CHECK_EQUAL(25767233, meas.pressure);
+    }
+}
+
+TEST(BMP280, ContinuousForcedModeStopAfterRetrigger)
+{
+    BMP280Meas meas;
+    start_continuous_forced_mode(&meas);
+    expect_continuous_start_timer();
+    expect_lazy_init_meas_read_data_regs();
+    expect_continuous_write_forced();
+    expect_continuous_cb(continuous_sample_cb_user_data, BMP280_RESULT_CODE_OK);
+    /* Executed when the write of the retrigger completes, no timer is started */
+    expect_continuous_cb(continuous_stop_cb_user_data, BMP280_RESULT_CODE_OK);
+
+    write_reg_complete_cb(BMP280_IO_RESULT_CODE_OK, write_reg_complete_cb_user_data);
+    timer_expired_cb(timer_expired_cb_user_data);
+    read_regs_complete_cb(BMP280_IO_RESULT_CODE_OK, read_regs_complete_cb_user_data);
+    uint8_t rc_stop = bmp280_stop_continuous_forced_mode(bmp280, mock_bmp280_complete_cb, continuous_stop_cb_user_data);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_stop);
+    write_reg_complete_cb(BMP280_IO_RESULT_CODE_OK, write_reg_complete_cb_user_data);
+}
+
+TEST(BMP280, ContinuousForcedModeStopDuringConversionDeliversSample)
+{
+    BMP280Meas meas;
+    start_continuous_forced_mode(&meas);
+    expect_continuous_start_timer();
+    expect_lazy_init_meas_read_data_regs();
+    /* No retrigger */
+    expect_continuous_cb(continuous_sample_cb_user_data, BMP280_RESULT_CODE_OK);
+    expect_continuous_cb(continuous_stop_cb_user_data, BMP280_RESULT_CODE_OK);
+
+    write_reg_complete_cb(BMP280_IO_RESULT_CODE_OK, write_reg_complete_cb_user_data);
+    uint8_t rc_stop = bmp280_stop_continuous_forced_mode(bmp280, mock_bmp280_complete_cb, continuous_stop_cb_user_data);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_stop);
+    timer_expired_cb(timer_expired_cb_user_data);
+    read_regs_complete_cb(BMP280_IO_RESULT_CODE_OK, read_regs_complete_cb_user_data);
+
+    CHECK_EQUAL(2508, meas.temperature);
+    CHECK_EQUAL(25767233, meas.pressure);
+    /* Continuous forced mode has ended, other operations can be started */
+    rc_stop = bmp280_stop_continuous_forced_mode(bmp280, mock_bmp280_complete_cb, continuous_stop_cb_user_data);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_USAGE, rc_stop);
+}
+
+TEST(BMP280, ContinuousForcedModeDataReadFailEndsContinuousMode)
+{
+    BMP280Meas meas;
+    start_continuous_forced_mode(&meas);
+    expect_continuous_start_timer();
+    expect_lazy_init_meas_read_data_regs();
+    expect_continuous_cb(continuous_sample_cb_user_data, BMP280_RESULT_CODE_IO_ERR);
+
+    write_reg_complete_cb(BMP280_IO_RESULT_CODE_OK, write_reg_complete_cb_user_data);
+    timer_expired_cb(timer_expired_cb_user_data);
+    read_regs_complete_cb(BMP280_IO_RESULT_CODE_ERR, read_regs_complete_cb_user_data);
+
+    mock()
+        .expectOneCall("mock_bmp280_read_regs")
+        .withParameter("start_addr", 0xD0)
+        .withParameter("num_regs", 1)
+        .withParameter("user_data", read_regs_user_data)
+        .ignoreOtherParameters();
+    uint8_t chip_id;
+    uint8_t rc = bmp280_get_chip_id(bmp280, &chip_id, NULL, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+}
+
+TEST(BMP280, ContinuousForcedModeBusy)
+{
+    BMP280Meas meas;
+    start_continuous_forced_mode(&meas);
+
+    uint8_t rc = bmp280_read_meas_forced_mode(bmp280, BMP280_MEAS_TYPE_TEMP_AND_PRES, 5, &meas, NULL, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_BUSY, rc);
+    rc = bmp280_start_continuous_forced_mode(bmp280, BMP280_MEAS_TYPE_TEMP_AND_PRES, 5, &meas, NULL, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_BUSY, rc);
+}
+
+TEST(BMP280, StartContinuousForcedModeCalledBeforeInitMeas)
+{
+    uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
+
+    BMP280Meas meas;
+    uint8_t rc = bmp280_start_continuous_forced_mode(bmp280, BMP280_MEAS_TYPE_TEMP_AND_PRES, 5, &meas, NULL, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_USAGE, rc);
+}
+
+TEST(BMP280, StartContinuousForcedModeMeasTimeZero)
+{
+    uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
+    call_init_meas(default_calib_data);
+
+    BMP280Meas meas;
+    uint8_t rc = bmp280_start_continuous_forced_mode(bmp280, BMP280_MEAS_TYPE_TEMP_AND_PRES, 0, &meas, NULL, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, rc);
+}
+
+TEST(BMP280, StopContinuousForcedModeNotRunning)
+{
+    uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
+
+    uint8_t rc = bmp280_stop_continuous_forced_mode(bmp280, NULL, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_USAGE, rc);
+}
+
+TEST(BMP280, StopContinuousForcedModeSelfNull)
+{
+    uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
+
+    uint8_t rc = bmp280_stop_continuous_forced_mode(NULL, NULL, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, rc);
+}
+
+TEST(BMP280, EnableTempLutSelfNull)
+{
+    uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
+
+    uint8_t rc = bmp280_enable_temp_lut(NULL, &temp_lut, temp_lut_entries, 64, 519888, 4);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, rc);
+}
+
+TEST(BMP280, EnableTempLutEntriesNull)
+{
+    uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
+    call_init_meas(default_calib_data);
+
+    uint8_t rc = bmp280_enable_temp_lut(bmp280, &temp_lut, NULL, 64, 519888, 4);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, rc);
+}
+
+TEST(BMP280, EnableTempLutNumEntriesZero)
+{
+    uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
+    call_init_meas(default_calib_data);
+
+    uint8_t rc = bmp280_enable_temp_lut(bmp280, &temp_lut, temp_lut_entries, 0, 519888, 4);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, rc);
+}
+
+TEST(BMP280, EnableTempLutRawShiftTooLarge)
+{
+    uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
+    call_init_meas(default_calib_data);
+
+    uint8_t rc = bmp280_enable_temp_lut(bmp280, &temp_lut, temp_lut_entries, 64, 519888, 20);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, rc);
+}
+
+TEST(BMP280, EnableTempLutTableNull)
+{
+    uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
+    call_init_meas(default_calib_data);
+
+    uint8_t rc = bmp280_enable_temp_lut(bmp280, NULL, temp_lut_entries, 64, 519888, 4);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, rc);
+}
+
+TEST(BMP280, EnableTempLutRawMinOutOfRange)
+{
+    uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
+    call_init_meas(default_calib_data);
+
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_enable_temp_lut(bmp280, &temp_lut, temp_lut_entries, 64, -16, 4));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG,
+                bmp280_enable_temp_lut(bmp280, &temp_lut, temp_lut_entries, 1, 0xFFFFF + 1, 0));
+}
+
+TEST(BMP280, EnableTempLutWindowPastRawRange)
+{
+    uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
+    call_init_meas(default_calib_data);
+
+    /* The last entry would be raw value 0xFFFFF + 1 */
+    uint8_t rc = bmp280_enable_temp_lut(bmp280, &temp_lut, temp_lut_entries, 64, 0xFFFFF + 1 - 63 * 16, 4);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, rc);
+    /* The last entry is raw value 0xFFFFF */
+    rc = bmp280_enable_temp_lut(bmp280, &temp_lut, temp_lut_entries, 64, 0xFFFFF - 63 * 16, 4);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+}
+
+TEST(BMP280, EnableTempLutCalledBeforeInitMeas)
+{
+    uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
+
+    uint8_t rc = bmp280_enable_temp_lut(bmp280, &temp_lut, temp_lut_entries, 64, 519888, 4);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_USAGE, rc);
+}
+
+TEST(BMP280, DisableTempLutSelfNull)
+{
+    uint8_t rc_create = bmp280_create(&bmp280, &init_cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc_create);
+
+    uint8_t rc = bmp280_disable_temp_lut(NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, rc);
+}
+
 static void test_init_meas(uint8_t complete_cb_rc, const uint8_t *const calib_data, uint8_t read_io_rc,
                            BMP280CompleteCb complete_cb)
 {
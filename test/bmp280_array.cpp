@@ -0,0 +1,389 @@
+#include <math.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280.h"
+#include "bmp280_array.h"
+#include "sim.h"
+#include "sim_bmp280.h"
+#include "sim_fixture.h"
+
+/* Raw values from the datasheet example, which compensate to 25.08 degC and 25767233 / 256 Pa */
+#define ARRAY_TEMP_RAW 519888
+#define ARRAY_PRES_RAW 415148
+#define ARRAY_EXPECTED_TEMP 2508
+#define ARRAY_EXPECTED_PRES 25767233U
+/* Forced mode wait with oversampling 1 */
+#define ARRAY_MEAS_TIME_MS 7
+
+#define ARRAY_NUM_SENSORS 4
+
+static SimBus array_bus;
+static SimBMP280 array_devs[ARRAY_NUM_SENSORS];
+static BMP280 array_insts[ARRAY_NUM_SENSORS];
+
+typedef struct {
+    bool complete;
+    uint8_t rc;
+} ArrayCompletion;
+
+static void array_complete_cb(uint8_t rc, void *user_data)
+{
+    ArrayCompletion *c = (ArrayCompletion *)user_data;
+    c->complete = true;
+    c->rc = rc;
+}
+
+/* Pseudo-random noise in [-amplitude, amplitude], reproducible across runs */
+static int32_t noise(uint32_t *state, int32_t amplitude)
+{
+    *state = *state * 1664525U + 1013904223U;
+    return (int32_t)((*state >> 8) % (uint32_t)(2 * amplitude + 1)) - amplitude;
+}
+
+// clang-format off
+TEST_GROUP(BMP280Array)
+{
+    BMP280ArrayCfg cfg;
+    BMP280Array array;
+    BMP280Meas meas;
+    ArrayCompletion completion;
+
+    void setup()
+    {
+        sim_reset();
+        sim_fixture_reset_inst_bufs();
+        /* 400 kHz I2C */
+        sim_bus_init(&array_bus, 70, 23);
+        for (size_t i = 0; i < ARRAY_NUM_SENSORS; i++) {
+            create_sensor(i);
+        }
+        cfg.pres_tolerance = 100 * 256;
+        cfg.temp_tolerance = 200;
+        cfg.min_members = 1;
+        cfg.offset_shift = 4;
+        cfg.max_consecutive_failures = 3;
+        cfg.probe_interval = 10;
+    }
+
+    void teardown()
+    {
+        /* Releases the memory of the event heap, so that it is not reported as a leak */
+        sim_reset();
+    }
+
+    void create_sensor(size_t i)
+    {
+        sim_bmp280_init(&array_devs[i], &array_bus, sim_fixture_calib_data);
+        array_devs[i].temp_raw = ARRAY_TEMP_RAW;
+        array_devs[i].pres_raw = ARRAY_PRES_RAW;
+        BMP280InitCfg init_cfg = {
+            .get_inst_buf = sim_fixture_get_inst_buf,
+            .get_inst_buf_user_data = NULL,
+            .read_regs = sim_bmp280_read_regs,
+            .read_regs_user_data = (void *)&array_devs[i],
+            .write_reg = sim_bmp280_write_reg,
+            .write_reg_user_data = (void *)&array_devs[i],
+            .start_timer = sim_start_timer,
+            .start_timer_user_data = NULL,
+            .lazy_init_meas = false,
+        };
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_create(&array_insts[i], &init_cfg));
+        run(bmp280_set_temp_oversampling(array_insts[i], BMP280_OVERSAMPLING_1, array_complete_cb, &completion));
+        run(bmp280_set_pres_oversampling(array_insts[i], BMP280_OVERSAMPLING_1, array_complete_cb, &completion));
+        run(bmp280_init_meas(array_insts[i], array_complete_cb, &completion));
+    }
+
+    /* Run the simulation until the operation that start_rc belongs to completes, check that it succeeded */
+    void run(uint8_t start_rc)
+    {
+        completion.complete = false;
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, start_rc);
+        sim_run();
+        CHECK_TRUE(completion.complete);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, completion.rc);
+    }
+
+    void init_array(size_t num_members)
+    {
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_array_init(&array, &cfg));
+        for (size_t i = 0; i < num_members; i++) {
+            CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_array_add(&array, array_insts[i]));
+        }
+    }
+
+    /* Read the array and run the simulation until the read completes. Returns the rc passed to the callback. */
+    uint8_t read_array()
+    {
+        completion.complete = false;
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_array_read_meas_forced_mode(&array,
+            BMP280_MEAS_TYPE_TEMP_AND_PRES, ARRAY_MEAS_TIME_MS, &meas, array_complete_cb, &completion));
+        sim_run();
+        CHECK_TRUE(completion.complete);
+        return completion.rc;
+    }
+};
+// clang-format on
+
+TEST(BMP280Array, InitRejectsInvalidCfg)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_array_init(NULL, &cfg));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_array_init(&array, NULL));
+
+    BMP280ArrayCfg bad = cfg;
+    bad.pres_tolerance = 0;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_array_init(&array, &bad));
+    bad = cfg;
+    bad.temp_tolerance = 1UL << 24;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_array_init(&array, &bad));
+    bad = cfg;
+    bad.min_members = 0;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_array_init(&array, &bad));
+    bad.min_members = BMP280_ARRAY_MAX_MEMBERS + 1;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_array_init(&array, &bad));
+    bad = cfg;
+    bad.offset_shift = 17;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_array_init(&array, &bad));
+    bad = cfg;
+    bad.max_consecutive_failures = 0;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_array_init(&array, &bad));
+    bad = cfg;
+    bad.probe_interval = 0;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_array_init(&array, &bad));
+}
+
+TEST(BMP280Array, AddChecksCapacityAndArgs)
+{
+    init_array(0);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_array_add(NULL, array_insts[0]));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_array_add(&array, NULL));
+    for (size_t i = 0; i < BMP280_ARRAY_MAX_MEMBERS; i++) {
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_array_add(&array, array_insts[i % ARRAY_NUM_SENSORS]));
+    }
+    CHECK_EQUAL(BMP280_RESULT_CODE_NO_MEM, bmp280_array_add(&array, array_insts[0]));
+}
+
+TEST(BMP280Array, ReadRejectsInvalidArgsAndUsage)
+{
+    init_array(0);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_USAGE,
+                bmp280_array_read_meas_forced_mode(&array, BMP280_MEAS_TYPE_TEMP_AND_PRES, ARRAY_MEAS_TIME_MS, &meas,
+                                                   array_complete_cb, &completion));
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_array_add(&array, array_insts[0]));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG,
+                bmp280_array_read_meas_forced_mode(&array, BMP280_MEAS_TYPE_TEMP_AND_PRES, ARRAY_MEAS_TIME_MS, NULL,
+                                                   array_complete_cb, &completion));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG,
+                bmp280_array_read_meas_forced_mode(&array, 2, ARRAY_MEAS_TIME_MS, &meas, array_complete_cb,
+                                                   &completion));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG,
+                bmp280_array_read_meas_forced_mode(&array, BMP280_MEAS_TYPE_TEMP_AND_PRES, 0, &meas,
+                                                   array_complete_cb, &completion));
+
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK,
+                bmp280_array_read_meas_forced_mode(&array, BMP280_MEAS_TYPE_TEMP_AND_PRES, ARRAY_MEAS_TIME_MS, &meas,
+                                                   array_complete_cb, &completion));
+    CHECK_EQUAL(BMP280_RESULT_CODE_BUSY,
+                bmp280_array_read_meas_forced_mode(&array, BMP280_MEAS_TYPE_TEMP_AND_PRES, ARRAY_MEAS_TIME_MS, &meas,
+                                                   array_complete_cb, &completion));
+    CHECK_EQUAL(BMP280_RESULT_CODE_BUSY, bmp280_array_add(&array, array_insts[1]));
+    sim_run();
+    CHECK_TRUE(completion.complete);
+}
+
+TEST(BMP280Array, ReadWithoutCallback)
+{
+    init_array(ARRAY_NUM_SENSORS);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_array_read_meas_forced_mode(&array, BMP280_MEAS_TYPE_TEMP_AND_PRES,
+                                                                          ARRAY_MEAS_TIME_MS, &meas, NULL, NULL));
+    sim_run();
+    CHECK_EQUAL(ARRAY_EXPECTED_TEMP, meas.temperature);
+    CHECK_EQUAL(ARRAY_EXPECTED_PRES, meas.pressure);
+    /* The read is complete, so the next one can start */
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, read_array());
+}
+
+TEST(BMP280Array, ConversionsOverlap)
+{
+    /* One sensor on its own */
+    completion.complete = false;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_read_meas_forced_mode(array_insts[0], BMP280_MEAS_TYPE_TEMP_AND_PRES,
+                                                                    ARRAY_MEAS_TIME_MS, &meas, array_complete_cb,
+                                                                    &completion));
+    uint64_t start_us = sim_now_us();
+    sim_run();
+    uint64_t single_us = sim_now_us() - start_us;
+
+    init_array(ARRAY_NUM_SENSORS);
+    start_us = sim_now_us();
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, read_array());
+    uint64_t array_us = sim_now_us() - start_us;
+
+    CHECK_EQUAL(ARRAY_EXPECTED_TEMP, meas.temperature);
+    CHECK_EQUAL(ARRAY_EXPECTED_PRES, meas.pressure);
+    for (size_t i = 0; i < ARRAY_NUM_SENSORS; i++) {
+        CHECK_EQUAL(1, array.members[i].stats.num_accepted);
+        CHECK_EQUAL(65536 / ARRAY_NUM_SENSORS, array.members[i].stats.weight);
+    }
+    /* The conversions overlap, only the bus transactions of the other members add to a single read */
+    CHECK_TRUE(array_us < single_us + single_us / 2);
+}
+
+TEST(BMP280Array, NoiseFallsWithSqrtOfMembers)
+{
+    init_array(ARRAY_NUM_SENSORS);
+    uint32_t state = 1;
+    double sum_member = 0;
+    double sq_sum_member = 0;
+    double sum_fused = 0;
+    double sq_sum_fused = 0;
+    const int num_reads = 2000;
+    for (int r = 0; r < num_reads; r++) {
+        for (size_t i = 0; i < ARRAY_NUM_SENSORS; i++) {
+            array_devs[i].pres_raw = ARRAY_PRES_RAW + noise(&state, 32);
+        }
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, read_array());
+        double member = array.members[0].meas.pressure / 256.0;
+        double fused = meas.pressure / 256.0;
+        sum_member += member;
+        sq_sum_member += member * member;
+        sum_fused += fused;
+        sq_sum_fused += fused * fused;
+    }
+    double sd_member = sqrt(sq_sum_member / num_reads - (sum_member / num_reads) * (sum_member / num_reads));
+    double sd_fused = sqrt(sq_sum_fused / num_reads - (sum_fused / num_reads) * (sum_fused / num_reads));
+    /* sqrt(4) = 2 */
+    CHECK_TRUE(sd_fused < sd_member / 1.7);
+    CHECK_TRUE(sd_fused > sd_member / 2.3);
+}
+
+TEST(BMP280Array, NoisyMemberGetsLessWeight)
+{
+    init_array(ARRAY_NUM_SENSORS);
+    uint32_t state = 2;
+    for (int r = 0; r < 200; r++) {
+        for (size_t i = 0; i < ARRAY_NUM_SENSORS; i++) {
+            array_devs[i].pres_raw = ARRAY_PRES_RAW + noise(&state, (i == 3) ? 128 : 16);
+        }
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, read_array());
+    }
+    for (size_t i = 0; i < 3; i++) {
+        CHECK_TRUE(array.members[i].stats.weight > 4 * array.members[3].stats.weight);
+        CHECK_TRUE(array.members[i].stats.noise_var < array.members[3].stats.noise_var);
+    }
+}
+
+TEST(BMP280Array, LearnsOffsetsAndDropoutDoesNotShift)
+{
+    /* About -26, -13, +8 and +31 Pa. The fused pressure is their mean. */
+    const int32_t bias_raw[ARRAY_NUM_SENSORS] = {160, 80, -50, -190};
+    for (size_t i = 0; i < ARRAY_NUM_SENSORS; i++) {
+        array_devs[i].pres_raw = ARRAY_PRES_RAW + bias_raw[i];
+    }
+    init_array(ARRAY_NUM_SENSORS);
+    for (int r = 0; r < 300; r++) {
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, read_array());
+    }
+    uint32_t fused_all = meas.pressure;
+    for (size_t i = 0; i < ARRAY_NUM_SENSORS; i++) {
+        int32_t expected = (int32_t)array.members[i].meas.pressure - (int32_t)fused_all;
+        CHECK_TRUE(abs(array.members[i].stats.offset - expected) <= 256);
+    }
+    CHECK_TRUE(array.members[3].stats.offset > 20 * 256);
+
+    /* The member with the largest offset fails. Without offsets, the fused pressure would drop by about 10 Pa. */
+    array_devs[3].io_fail = true;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, read_array());
+    CHECK_TRUE(abs((int32_t)meas.pressure - (int32_t)fused_all) <= 256);
+    CHECK_EQUAL(1, array.members[3].stats.num_errors);
+    CHECK_EQUAL(0, array.members[3].stats.weight);
+    /* Rounding of the offset correction leaves a tiny noise variance estimate */
+    CHECK_TRUE(abs((int32_t)array.members[0].stats.weight - 65536 / 3) < 100);
+}
+
+TEST(BMP280Array, FailingMemberIsOnlyProbedUntilItRecovers)
+{
+    init_array(ARRAY_NUM_SENSORS);
+    array_devs[2].io_fail = true;
+    for (int r = 0; r < 3; r++) {
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, read_array());
+    }
+    CHECK_TRUE(array.members[2].stats.probing);
+    CHECK_EQUAL(3, array.members[2].stats.num_reads);
+    CHECK_EQUAL(3, array.members[2].stats.consecutive_failures);
+
+    /* Reads 3 to 29: the member is only triggered on reads 10 and 20 */
+    for (int r = 3; r < 30; r++) {
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, read_array());
+        CHECK_EQUAL(ARRAY_EXPECTED_PRES, meas.pressure);
+    }
+    CHECK_EQUAL(5, array.members[2].stats.num_reads);
+    CHECK_EQUAL(5, array.members[2].stats.num_errors);
+    CHECK_EQUAL(30, array.members[0].stats.num_reads);
+
+    array_devs[2].io_fail = false;
+    /* Read 30 probes it again */
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, read_array());
+    CHECK_FALSE(array.members[2].stats.probing);
+    CHECK_EQUAL(0, array.members[2].stats.consecutive_failures);
+    CHECK_EQUAL(1, array.members[2].stats.num_accepted);
+    CHECK_EQUAL(65536 / ARRAY_NUM_SENSORS, array.members[2].stats.weight);
+}
+
+TEST(BMP280Array, OutlierIsRejected)
+{
+    init_array(ARRAY_NUM_SENSORS);
+    /* About 800 Pa off, but still in the operating range */
+    array_devs[1].pres_raw = ARRAY_PRES_RAW + 5000;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, read_array());
+    CHECK_EQUAL(ARRAY_EXPECTED_PRES, meas.pressure);
+    CHECK_EQUAL(1, array.members[1].stats.num_outliers);
+    CHECK_EQUAL(0, array.members[1].stats.num_out_of_range);
+    CHECK_EQUAL(0, array.members[1].stats.weight);
+    CHECK_EQUAL(65536 / 3, array.members[0].stats.weight);
+}
+
+TEST(BMP280Array, OutOfRangeMemberIsRejected)
+{
+    init_array(ARRAY_NUM_SENSORS);
+    /* Far below -40 degC */
+    array_devs[0].temp_raw = 100000;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, read_array());
+    CHECK_EQUAL(ARRAY_EXPECTED_TEMP, meas.temperature);
+    CHECK_EQUAL(1, array.members[0].stats.num_out_of_range);
+    CHECK_EQUAL(3, array.members[1].stats.num_accepted + array.members[2].stats.num_accepted +
+                       array.members[3].stats.num_accepted);
+}
+
+TEST(BMP280Array, TwoMembersThatDisagreeFail)
+{
+    init_array(2);
+    array_devs[1].pres_raw = ARRAY_PRES_RAW + 5000;
+    CHECK_EQUAL(BMP280_RESULT_CODE_IO_ERR, read_array());
+    CHECK_EQUAL(1, array.members[0].stats.num_outliers);
+    CHECK_EQUAL(1, array.members[1].stats.num_outliers);
+}
+
+TEST(BMP280Array, MinMembersNotReachedFails)
+{
+    cfg.min_members = 3;
+    init_array(3);
+    array_devs[0].io_fail = true;
+    CHECK_EQUAL(BMP280_RESULT_CODE_IO_ERR, read_array());
+    CHECK_EQUAL(1, array.members[0].stats.num_errors);
+    CHECK_EQUAL(0, array.members[1].stats.num_accepted);
+}
+
+TEST(BMP280Array, OnlyTemperature)
+{
+    init_array(ARRAY_NUM_SENSORS);
+    completion.complete = false;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_array_read_meas_forced_mode(&array, BMP280_MEAS_TYPE_ONLY_TEMP,
+                                                                          ARRAY_MEAS_TIME_MS, &meas,
+                                                                          array_complete_cb, &completion));
+    sim_run();
+    CHECK_TRUE(completion.complete);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, completion.rc);
+    CHECK_EQUAL(ARRAY_EXPECTED_TEMP, meas.temperature);
+}
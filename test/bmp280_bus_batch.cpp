@@ -0,0 +1,606 @@
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+
+#include "bmp280.h"
+#include "bmp280_bus_batch.h"
+#include "mock_complete_cb.h"
+#include "sim.h"
+#include "sim_bmp280.h"
+#include "sim_fixture.h"
+#include "sim_mux.h"
+
+#define FAKE_SUBMIT_MAX_TRANSFERS 8
+
+/** Transfers passed to the last fake_submit call, copied so that the test can inspect them after completion. */
+static BMP280BusTransfer *submitted[FAKE_SUBMIT_MAX_TRANSFERS];
+static size_t num_submitted;
+static size_t num_submit_calls;
+static BMP280BusSubmitCompleteCb submit_complete_cb;
+static void *submit_complete_cb_user_data;
+static void *submit_user_data = (void *)0xB1;
+
+static void fake_submit(BMP280BusTransfer *transfers, size_t num_transfers, void *user_data,
+                        BMP280BusSubmitCompleteCb cb, void *cb_user_data)
+{
+    POINTERS_EQUAL(submit_user_data, user_data);
+    num_submit_calls++;
+    num_submitted = 0;
+    for (BMP280BusTransfer *transfer = transfers; transfer; transfer = transfer->next) {
+        CHECK(num_submitted < FAKE_SUBMIT_MAX_TRANSFERS);
+        submitted[num_submitted++] = transfer;
+    }
+    CHECK_EQUAL(num_transfers, num_submitted);
+    submit_complete_cb = cb;
+    submit_complete_cb_user_data = cb_user_data;
+}
+
+/** Complete the last submitted batch, every transfer with @p io_rc. */
+static void complete_submitted(uint8_t io_rc)
+{
+    for (size_t i = 0; i < num_submitted; i++) {
+        submitted[i]->io_rc = io_rc;
+    }
+    submit_complete_cb(submit_complete_cb_user_data);
+}
+
+typedef struct {
+    uint8_t io_rc;
+    size_t num_calls;
+} IOCompleteRecord;
+
+static void record_io_complete_cb(uint8_t io_rc, void *user_data)
+{
+    IOCompleteRecord *record = (IOCompleteRecord *)user_data;
+    record->io_rc = io_rc;
+    record->num_calls++;
+}
+
+static BMP280BusBatch batch;
+static BMP280BusBatchDev devs[2];
+
+// clang-format off
+TEST_GROUP(BMP280BusBatch){
+    void setup() {
+        num_submitted = 0;
+        num_submit_calls = 0;
+        submit_complete_cb = NULL;
+        submit_complete_cb_user_data = NULL;
+        BMP280BusBatchCfg cfg = {
+            .submit = fake_submit,
+            .submit_user_data = submit_user_data,
+        };
+        uint8_t rc = bmp280_bus_batch_init(&batch, &cfg);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+        /* Two sensors on one I2C bus, with SDO low and high */
+        rc = bmp280_bus_batch_dev_init(&devs[0], &batch, 0x76);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+        rc = bmp280_bus_batch_dev_init(&devs[1], &batch, 0x77);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    }
+};
+// clang-format on
+
+TEST(BMP280BusBatch, InitInvalArgs)
+{
+    BMP280BusBatchCfg cfg = {
+        .submit = NULL,
+        .submit_user_data = NULL,
+    };
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_bus_batch_init(&batch, &cfg));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_bus_batch_init(&batch, NULL));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_bus_batch_init(NULL, &cfg));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_bus_batch_dev_init(NULL, &batch, 0x76));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_bus_batch_dev_init(&devs[0], NULL, 0x76));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_bus_batch_flush(NULL));
+}
+
+TEST(BMP280BusBatch, FlushWithNothingQueuedDoesNotSubmit)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_flush(&batch));
+    CHECK_EQUAL(0, num_submit_calls);
+}
+
+TEST(BMP280BusBatch, TransfersOfSeveralDevicesAreSubmittedTogether)
+{
+    uint8_t read_data[6];
+    IOCompleteRecord records[2] = {};
+    bmp280_bus_batch_read_regs(0xF7, 6, read_data, (void *)&devs[0], record_io_complete_cb, (void *)&records[0]);
+    bmp280_bus_batch_write_reg(0xF4, 0x25, (void *)&devs[1], record_io_complete_cb, (void *)&records[1]);
+    CHECK_EQUAL(2, bmp280_bus_batch_num_pending(&batch));
+    /* Nothing is submitted until flush */
+    CHECK_EQUAL(0, num_submit_calls);
+
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_flush(&batch));
+    CHECK_EQUAL(1, num_submit_calls);
+    CHECK_EQUAL(2, num_submitted);
+    CHECK_EQUAL(0, bmp280_bus_batch_num_pending(&batch));
+
+    /* Submitted in the order in which they were queued */
+    CHECK_EQUAL(0x76, submitted[0]->dev_addr);
+    CHECK_EQUAL(0xF7, submitted[0]->reg_addr);
+    CHECK_TRUE(submitted[0]->is_read);
+    POINTERS_EQUAL(read_data, submitted[0]->data);
+    CHECK_EQUAL(6, submitted[0]->len);
+    CHECK_EQUAL(0x77, submitted[1]->dev_addr);
+    CHECK_EQUAL(0xF4, submitted[1]->reg_addr);
+    CHECK_FALSE(submitted[1]->is_read);
+    CHECK_EQUAL(1, submitted[1]->len);
+    CHECK_EQUAL(0x25, submitted[1]->write_val);
+
+    /* Completion is fanned out with per-transfer results */
+    submitted[0]->io_rc = BMP280_IO_RESULT_CODE_OK;
+    submitted[1]->io_rc = BMP280_IO_RESULT_CODE_ERR;
+    submit_complete_cb(submit_complete_cb_user_data);
+    CHECK_EQUAL(1, records[0].num_calls);
+    CHECK_EQUAL(BMP280_IO_RESULT_CODE_OK, records[0].io_rc);
+    CHECK_EQUAL(1, records[1].num_calls);
+    CHECK_EQUAL(BMP280_IO_RESULT_CODE_ERR, records[1].io_rc);
+}
+
+TEST(BMP280BusBatch, FlushWhileInFlightIsBusy)
+{
+    uint8_t read_data;
+    IOCompleteRecord records[2] = {};
+    bmp280_bus_batch_read_regs(0xD0, 1, &read_data, (void *)&devs[0], record_io_complete_cb, (void *)&records[0]);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_flush(&batch));
+
+    bmp280_bus_batch_read_regs(0xD0, 1, &read_data, (void *)&devs[1], record_io_complete_cb, (void *)&records[1]);
+    CHECK_EQUAL(BMP280_RESULT_CODE_BUSY, bmp280_bus_batch_flush(&batch));
+    CHECK_EQUAL(1, num_submit_calls);
+    CHECK_EQUAL(1, bmp280_bus_batch_num_pending(&batch));
+
+    complete_submitted(BMP280_IO_RESULT_CODE_OK);
+    CHECK_EQUAL(1, records[0].num_calls);
+    CHECK_EQUAL(0, records[1].num_calls);
+
+    /* Queued transfer is submitted on the next flush */
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_flush(&batch));
+    CHECK_EQUAL(2, num_submit_calls);
+    CHECK_EQUAL(1, num_submitted);
+    CHECK_EQUAL(0x77, submitted[0]->dev_addr);
+    complete_submitted(BMP280_IO_RESULT_CODE_OK);
+    CHECK_EQUAL(1, records[1].num_calls);
+}
+
+static void requeue_io_complete_cb(uint8_t io_rc, void *user_data)
+{
+    (void)io_rc;
+    BMP280BusBatchDev *dev = (BMP280BusBatchDev *)user_data;
+    static uint8_t data;
+    bmp280_bus_batch_read_regs(0xF3, 1, &data, (void *)dev, NULL, NULL);
+}
+
+TEST(BMP280BusBatch, TransfersQueuedFromCompletionAreSubmittedOnNextFlush)
+{
+    uint8_t read_data[2];
+    bmp280_bus_batch_read_regs(0xD0, 1, &read_data[0], (void *)&devs[0], requeue_io_complete_cb, (void *)&devs[0]);
+    bmp280_bus_batch_read_regs(0xD0, 1, &read_data[1], (void *)&devs[1], requeue_io_complete_cb, (void *)&devs[1]);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_flush(&batch));
+
+    /* Every callback queues the next transfer of the same device, which reuses the memory of the completed one */
+    complete_submitted(BMP280_IO_RESULT_CODE_OK);
+    CHECK_EQUAL(2, bmp280_bus_batch_num_pending(&batch));
+
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_flush(&batch));
+    CHECK_EQUAL(2, num_submitted);
+    CHECK_EQUAL(0xF3, submitted[0]->reg_addr);
+    CHECK_EQUAL(0x76, submitted[0]->dev_addr);
+    CHECK_EQUAL(0x77, submitted[1]->dev_addr);
+}
+
+static void unused_start_timer(uint32_t duration_ms, void *user_data, BMP280TimerExpiredCb cb, void *cb_user_data)
+{
+    (void)duration_ms;
+    (void)user_data;
+    (void)cb;
+    (void)cb_user_data;
+    FAIL("Timer is not used in this test");
+}
+
+TEST(BMP280BusBatch, ChipIdOfTwoInstancesInOneSubmit)
+{
+    sim_fixture_reset_inst_bufs();
+    BMP280 bmp280[2];
+    for (size_t i = 0; i < 2; i++) {
+        BMP280InitCfg cfg = {
+            .get_inst_buf = sim_fixture_get_inst_buf,
+            .get_inst_buf_user_data = NULL,
+            .read_regs = bmp280_bus_batch_read_regs,
+            .read_regs_user_data = (void *)&devs[i],
+            .write_reg = bmp280_bus_batch_write_reg,
+            .write_reg_user_data = (void *)&devs[i],
+            .start_timer = unused_start_timer,
+            .start_timer_user_data = NULL,
+        };
+        uint8_t rc = bmp280_create(&bmp280[i], &cfg);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    }
+
+    uint8_t chip_ids[2];
+    void *complete_cb_user_data[2] = {(void *)0xB2, (void *)0xB3};
+    for (size_t i = 0; i < 2; i++) {
+        uint8_t rc = bmp280_get_chip_id(bmp280[i], &chip_ids[i], mock_bmp280_complete_cb, complete_cb_user_data[i]);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    }
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_flush(&batch));
+    CHECK_EQUAL(1, num_submit_calls);
+    CHECK_EQUAL(2, num_submitted);
+
+    for (size_t i = 0; i < 2; i++) {
+        CHECK_EQUAL(0xD0, submitted[i]->reg_addr);
+        submitted[i]->data[0] = 0x58;
+        mock()
+            .expectOneCall("mock_bmp280_complete_cb")
+            .withParameter("rc", BMP280_RESULT_CODE_OK)
+            .withParameter("user_data", complete_cb_user_data[i]);
+    }
+    complete_submitted(BMP280_IO_RESULT_CODE_OK);
+    CHECK_EQUAL(0x58, chip_ids[0]);
+    CHECK_EQUAL(0x58, chip_ids[1]);
+}
+
+/* Mux scheduling */
+
+#define MUX_ADDR 0x70
+
+/* Two devices on each of mux channels 0 and 1, and one device next to the mux */
+static BMP280BusBatchDev mux_devs[5];
+
+static void init_mux_batch(bool keep_order, uint32_t max_hold_flushes)
+{
+    BMP280BusBatchCfg cfg = {
+        .submit = fake_submit,
+        .submit_user_data = submit_user_data,
+        .mux_addr = MUX_ADDR,
+        .mux_keep_order = keep_order,
+        .mux_max_hold_flushes = max_hold_flushes,
+    };
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_init(&batch, &cfg));
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_mux_dev_init(&mux_devs[0], &batch, 0x76, 0));
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_mux_dev_init(&mux_devs[1], &batch, 0x77, 0));
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_mux_dev_init(&mux_devs[2], &batch, 0x76, 1));
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_mux_dev_init(&mux_devs[3], &batch, 0x77, 1));
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_dev_init(&mux_devs[4], &batch, 0x40));
+}
+
+static void queue_read(size_t dev_idx)
+{
+    static uint8_t data[6];
+    bmp280_bus_batch_read_regs(0xF7, 6, data, (void *)&mux_devs[dev_idx], NULL, NULL);
+}
+
+static void check_select(size_t idx, uint8_t channel)
+{
+    CHECK_TRUE(submitted[idx]->is_mux_select);
+    CHECK_EQUAL(MUX_ADDR, submitted[idx]->dev_addr);
+    CHECK_EQUAL(1U << channel, submitted[idx]->write_val);
+}
+
+static void check_dev(size_t idx, size_t dev_idx)
+{
+    POINTERS_EQUAL(&mux_devs[dev_idx].transfer, submitted[idx]);
+}
+
+TEST(BMP280BusBatch, MuxDevInitInvalArgs)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_bus_batch_mux_dev_init(&mux_devs[0], &batch, 0x76, 8));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_bus_batch_mux_dev_init(NULL, &batch, 0x76, 0));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_bus_batch_mux_dev_init(&mux_devs[0], NULL, 0x76, 0));
+}
+
+TEST(BMP280BusBatch, MuxTransfersAreGroupedByChannel)
+{
+    init_mux_batch(false, 0);
+    queue_read(0);
+    queue_read(2);
+    queue_read(1);
+    queue_read(4);
+    queue_read(3);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_flush(&batch));
+
+    /* The device next to the mux first, then one select per channel, channels in order of their first transfer */
+    CHECK_EQUAL(7, num_submitted);
+    check_dev(0, 4);
+    check_select(1, 0);
+    check_dev(2, 0);
+    check_dev(3, 1);
+    check_select(4, 1);
+    check_dev(5, 2);
+    check_dev(6, 3);
+    CHECK_EQUAL(2, batch.num_mux_selects);
+    complete_submitted(BMP280_IO_RESULT_CODE_OK);
+
+    /* Channel 1 is still selected, so it goes first and without a select */
+    queue_read(0);
+    queue_read(2);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_flush(&batch));
+    CHECK_EQUAL(3, num_submitted);
+    check_dev(0, 2);
+    check_select(1, 0);
+    check_dev(2, 0);
+    CHECK_EQUAL(3, batch.num_mux_selects);
+}
+
+TEST(BMP280BusBatch, MuxKeepOrderSelectsOnEveryChannelChange)
+{
+    init_mux_batch(true, 0);
+    queue_read(0);
+    queue_read(2);
+    queue_read(1);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_flush(&batch));
+
+    CHECK_EQUAL(6, num_submitted);
+    check_select(0, 0);
+    check_dev(1, 0);
+    check_select(2, 1);
+    check_dev(3, 2);
+    check_select(4, 0);
+    check_dev(5, 1);
+    CHECK_EQUAL(3, batch.num_mux_selects);
+}
+
+TEST(BMP280BusBatch, MuxHoldsChannelUntilFullOrDeadline)
+{
+    init_mux_batch(false, 2);
+    queue_read(0);
+    /* The other device of channel 0 has nothing queued yet */
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_flush(&batch));
+    CHECK_EQUAL(0, num_submit_calls);
+    CHECK_EQUAL(1, bmp280_bus_batch_num_pending(&batch));
+
+    queue_read(1);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_flush(&batch));
+    CHECK_EQUAL(1, num_submit_calls);
+    CHECK_EQUAL(3, num_submitted);
+    check_select(0, 0);
+    check_dev(1, 0);
+    check_dev(2, 1);
+    complete_submitted(BMP280_IO_RESULT_CODE_OK);
+
+    /* The selected channel is never held back */
+    queue_read(0);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_flush(&batch));
+    CHECK_EQUAL(2, num_submit_calls);
+    CHECK_EQUAL(1, num_submitted);
+    complete_submitted(BMP280_IO_RESULT_CODE_OK);
+
+    /* A lone transfer of channel 1 is held back for 2 flushes */
+    queue_read(2);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_flush(&batch));
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_flush(&batch));
+    CHECK_EQUAL(2, num_submit_calls);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_flush(&batch));
+    CHECK_EQUAL(3, num_submit_calls);
+    check_select(0, 1);
+    check_dev(1, 2);
+}
+
+TEST(BMP280BusBatch, MuxFailedSelectIsRepeated)
+{
+    init_mux_batch(false, 0);
+    queue_read(0);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_flush(&batch));
+    complete_submitted(BMP280_IO_RESULT_CODE_ERR);
+
+    queue_read(0);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_flush(&batch));
+    CHECK_EQUAL(2, num_submitted);
+    check_select(0, 0);
+    check_dev(1, 0);
+}
+
+TEST(BMP280BusBatch, MuxFailedSelectFailsTransfersOfItsChannel)
+{
+    init_mux_batch(false, 0);
+    IOCompleteRecord records[5];
+    memset(records, 0, sizeof(records));
+    static uint8_t data[6];
+    for (size_t i = 0; i < 5; i++) {
+        bmp280_bus_batch_read_regs(0xF7, 6, data, (void *)&mux_devs[i], record_io_complete_cb, (void *)&records[i]);
+    }
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_flush(&batch));
+    CHECK_EQUAL(7, num_submitted);
+    check_select(1, 0);
+    check_select(4, 1);
+
+    /* Only the select of channel 0 fails, the submit function reports the transfers behind it as done */
+    for (size_t i = 0; i < num_submitted; i++) {
+        submitted[i]->io_rc = BMP280_IO_RESULT_CODE_OK;
+    }
+    submitted[1]->io_rc = BMP280_IO_RESULT_CODE_ERR;
+    submit_complete_cb(submit_complete_cb_user_data);
+
+    CHECK_EQUAL(BMP280_IO_RESULT_CODE_ERR, records[0].io_rc);
+    CHECK_EQUAL(BMP280_IO_RESULT_CODE_ERR, records[1].io_rc);
+    CHECK_EQUAL(BMP280_IO_RESULT_CODE_OK, records[2].io_rc);
+    CHECK_EQUAL(BMP280_IO_RESULT_CODE_OK, records[3].io_rc);
+    CHECK_EQUAL(BMP280_IO_RESULT_CODE_OK, records[4].io_rc);
+    for (size_t i = 0; i < 5; i++) {
+        CHECK_EQUAL(1, records[i].num_calls);
+    }
+}
+
+TEST(BMP280BusBatch, MuxFailedSelectFailsTransfersAfterOtherDevices)
+{
+    init_mux_batch(true, 0);
+    IOCompleteRecord records[2];
+    memset(records, 0, sizeof(records));
+    static uint8_t data[6];
+    queue_read(0);
+    queue_read(4);
+    bmp280_bus_batch_read_regs(0xF7, 6, data, (void *)&mux_devs[1], record_io_complete_cb, (void *)&records[0]);
+    bmp280_bus_batch_read_regs(0xF7, 6, data, (void *)&mux_devs[2], record_io_complete_cb, (void *)&records[1]);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_flush(&batch));
+
+    /* The device next to the mux does not change the selected channel, so device 1 shares the first select */
+    CHECK_EQUAL(6, num_submitted);
+    check_select(0, 0);
+    check_dev(3, 1);
+    check_select(4, 1);
+    for (size_t i = 1; i < num_submitted; i++) {
+        submitted[i]->io_rc = BMP280_IO_RESULT_CODE_OK;
+    }
+    submitted[0]->io_rc = BMP280_IO_RESULT_CODE_ERR;
+    submit_complete_cb(submit_complete_cb_user_data);
+
+    CHECK_EQUAL(BMP280_IO_RESULT_CODE_ERR, records[0].io_rc);
+    CHECK_EQUAL(BMP280_IO_RESULT_CODE_OK, records[1].io_rc);
+}
+
+/* Mux simulation: 16 sensors in continuous forced mode behind a simulated TCA9548A, flushed every 1 ms */
+
+#define MUX_SIM_NUM_SENSORS 16
+#define MUX_SIM_FLUSH_PERIOD_US 1000
+#define MUX_SIM_MEAS_TIME_MS 7
+#define MUX_SIM_DURATION_US 2000000
+
+static SimBus mux_sim_bus;
+static SimMux mux_sim_mux;
+static SimBMP280 mux_sim_devs[MUX_SIM_NUM_SENSORS];
+static BMP280BusBatch mux_sim_batch;
+static BMP280BusBatchDev mux_sim_batch_devs[MUX_SIM_NUM_SENSORS];
+
+static struct {
+    BMP280 inst;
+    BMP280Meas meas;
+    uint32_t num_samples;
+    uint32_t num_errors;
+    bool init_done;
+} mux_sim_sensors[MUX_SIM_NUM_SENSORS];
+
+static void mux_sim_flush_tick(void *user_data)
+{
+    (void)user_data;
+    bmp280_bus_batch_flush(&mux_sim_batch);
+    sim_schedule_us(MUX_SIM_FLUSH_PERIOD_US, mux_sim_flush_tick, NULL);
+}
+
+static void mux_sim_init_done_cb(uint8_t rc, void *user_data)
+{
+    size_t i = (size_t)(uintptr_t)user_data;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    mux_sim_sensors[i].init_done = true;
+}
+
+static void mux_sim_sample_cb(uint8_t rc, void *user_data)
+{
+    size_t i = (size_t)(uintptr_t)user_data;
+    if (rc == BMP280_RESULT_CODE_OK) {
+        mux_sim_sensors[i].num_samples++;
+    } else {
+        mux_sim_sensors[i].num_errors++;
+    }
+}
+
+static void mux_sim_start_sensor(void *user_data)
+{
+    size_t i = (size_t)(uintptr_t)user_data;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK,
+                bmp280_start_continuous_forced_mode(mux_sim_sensors[i].inst, BMP280_MEAS_TYPE_TEMP_AND_PRES,
+                                                    MUX_SIM_MEAS_TIME_MS, &mux_sim_sensors[i].meas, mux_sim_sample_cb,
+                                                    user_data));
+}
+
+typedef struct {
+    uint64_t num_samples;
+    uint64_t num_selects;
+    uint64_t num_dev_transfers;
+    uint32_t min_sensor_samples;
+} MuxSimResult;
+
+// clang-format off
+TEST_GROUP(BMP280BusBatchMuxSim){
+    void teardown() {
+        /* Releases the memory of the event heap, so that it is not reported as a leak */
+        sim_reset();
+    }
+
+    MuxSimResult run(bool keep_order, uint32_t max_hold_flushes) {
+        sim_reset();
+        memset(mux_sim_sensors, 0, sizeof(mux_sim_sensors));
+        sim_fixture_reset_inst_bufs();
+        /* 400 kHz I2C */
+        sim_bus_init(&mux_sim_bus, 70, 23);
+        sim_mux_init(&mux_sim_mux, &mux_sim_bus, MUX_ADDR);
+        BMP280BusBatchCfg cfg = {
+            .submit = sim_mux_submit,
+            .submit_user_data = (void *)&mux_sim_mux,
+            .mux_addr = MUX_ADDR,
+            .mux_keep_order = keep_order,
+            .mux_max_hold_flushes = max_hold_flushes,
+        };
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_bus_batch_init(&mux_sim_batch, &cfg));
+
+        for (size_t i = 0; i < MUX_SIM_NUM_SENSORS; i++) {
+            /* Neighbouring sensors sit on different channels, both addresses are used on every channel */
+            uint8_t channel = (uint8_t)(i % BMP280_BUS_BATCH_MUX_NUM_CHANNELS);
+            uint8_t dev_addr = (uint8_t)(0x76 + i / BMP280_BUS_BATCH_MUX_NUM_CHANNELS);
+            sim_bmp280_init(&mux_sim_devs[i], &mux_sim_bus, sim_fixture_calib_data);
+            /* Oversampling 1 for temperature and pressure */
+            mux_sim_devs[i].regs[0xF4] = 0x24;
+            sim_mux_attach(&mux_sim_mux, &mux_sim_devs[i], channel, dev_addr);
+            CHECK_EQUAL(BMP280_RESULT_CODE_OK,
+                        bmp280_bus_batch_mux_dev_init(&mux_sim_batch_devs[i], &mux_sim_batch, dev_addr, channel));
+            BMP280InitCfg init_cfg = {
+                .get_inst_buf = sim_fixture_get_inst_buf,
+                .get_inst_buf_user_data = NULL,
+                .read_regs = bmp280_bus_batch_read_regs,
+                .read_regs_user_data = (void *)&mux_sim_batch_devs[i],
+                .write_reg = bmp280_bus_batch_write_reg,
+                .write_reg_user_data = (void *)&mux_sim_batch_devs[i],
+                .start_timer = sim_start_timer,
+                .start_timer_user_data = NULL,
+                .lazy_init_meas = false,
+            };
+            CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_create(&mux_sim_sensors[i].inst, &init_cfg));
+            CHECK_EQUAL(BMP280_RESULT_CODE_OK,
+                        bmp280_init_meas(mux_sim_sensors[i].inst, mux_sim_init_done_cb, (void *)(uintptr_t)i));
+        }
+        sim_schedule_us(0, mux_sim_flush_tick, NULL);
+        sim_run_until_us(sim_now_us() + 100000);
+        for (size_t i = 0; i < MUX_SIM_NUM_SENSORS; i++) {
+            CHECK_TRUE(mux_sim_sensors[i].init_done);
+        }
+
+        /* Staggered starts, so that the sensors of a channel do not fall into the same flush by construction */
+        for (size_t i = 0; i < MUX_SIM_NUM_SENSORS; i++) {
+            sim_schedule_us((i * 5 % MUX_SIM_MEAS_TIME_MS) * 1000 + i * 100, mux_sim_start_sensor,
+                            (void *)(uintptr_t)i);
+        }
+        uint64_t start_transactions = mux_sim_bus.num_transactions;
+        uint64_t start_selects = mux_sim_mux.num_selects;
+        sim_run_until_us(sim_now_us() + MUX_SIM_DURATION_US);
+
+        MuxSimResult result = {0, 0, 0, UINT32_MAX};
+        for (size_t i = 0; i < MUX_SIM_NUM_SENSORS; i++) {
+            CHECK_EQUAL(0, mux_sim_sensors[i].num_errors);
+            result.num_samples += mux_sim_sensors[i].num_samples;
+            if (mux_sim_sensors[i].num_samples < result.min_sensor_samples) {
+                result.min_sensor_samples = mux_sim_sensors[i].num_samples;
+            }
+        }
+        CHECK_EQUAL(0, mux_sim_mux.num_errors);
+        uint64_t num_transactions = mux_sim_bus.num_transactions - start_transactions;
+        result.num_selects = mux_sim_mux.num_selects - start_selects;
+        result.num_dev_transfers = num_transactions - result.num_selects;
+        return result;
+    }
+};
+// clang-format on
+
+TEST(BMP280BusBatchMuxSim, GroupingByChannelSavesSelects)
+{
+    MuxSimResult in_order = run(true, 0);
+    MuxSimResult grouped = run(false, 0);
+    MuxSimResult held = run(false, 2);
+
+    /* A layer that does not track the mux state selects the channel before every device transfer */
+    CHECK_TRUE(in_order.num_selects < in_order.num_dev_transfers);
+    CHECK_TRUE(grouped.num_selects < in_order.num_selects);
+    CHECK_TRUE(held.num_selects < grouped.num_selects);
+    /* Holding back delays samples by at most 2 flush periods, throughput stays within 5% */
+    CHECK_TRUE(held.num_samples * 20 >= grouped.num_samples * 19);
+    CHECK_TRUE(held.min_sensor_samples * 20 >= grouped.min_sensor_samples * 19);
+}
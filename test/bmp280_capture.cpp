@@ -0,0 +1,292 @@
+#include <stdlib.h>
+#include <vector>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280_capture.h"
+
+#define CAPTURE_RING_CAPACITY 8
+#define CAPTURE_POST_TRIGGER_SAMPLES 5
+/* 1013.25 hPa in Q24.8 Pa */
+#define CAPTURE_SEA_LEVEL_PRES (101325U * 256U)
+/* 1 Pa in Q24.8 */
+#define CAPTURE_PA 256U
+
+typedef struct {
+    uint32_t event_seq;
+    uint32_t timestamp_ms;
+    uint32_t pressure;
+} RecordedSample;
+
+static void record_sample(uint32_t event_seq, uint32_t timestamp_ms, const BMP280Meas *meas, void *user_data)
+{
+    std::vector<RecordedSample> *recorded = (std::vector<RecordedSample> *)user_data;
+    RecordedSample s = {event_seq, timestamp_ms, meas->pressure};
+    recorded->push_back(s);
+}
+
+/* Pseudo-random noise in [-amplitude, amplitude], reproducible across runs */
+static int32_t noise(uint32_t *state, uint32_t amplitude)
+{
+    *state = *state * 1664525U + 1013904223U;
+    return (int32_t)((*state >> 8) % (2 * amplitude + 1)) - (int32_t)amplitude;
+}
+
+// clang-format off
+TEST_GROUP(BMP280Capture)
+{
+    BMP280CaptureSample ring[CAPTURE_RING_CAPACITY];
+    BMP280CaptureCfg cfg;
+    BMP280Capture capture;
+    std::vector<RecordedSample> recorded;
+    uint32_t timestamp_ms;
+
+    void setup()
+    {
+        cfg.ring = ring;
+        cfg.ring_capacity = CAPTURE_RING_CAPACITY;
+        cfg.post_trigger_samples = CAPTURE_POST_TRIGGER_SAMPLES;
+        cfg.baseline_shift = 8;
+        cfg.cusum_drift = 4 * CAPTURE_PA;
+        cfg.cusum_threshold = 32 * CAPTURE_PA;
+        cfg.jump_threshold = 50 * CAPTURE_PA;
+        cfg.record = record_sample;
+        cfg.record_user_data = &recorded;
+        timestamp_ms = 0;
+    }
+
+    /* Add a sample 40 ms after the previous one */
+    bool add(uint32_t pressure)
+    {
+        BMP280Meas meas = {2508, pressure};
+        timestamp_ms += 40;
+        return bmp280_capture_add(&capture, timestamp_ms, &meas);
+    }
+};
+// clang-format on
+
+TEST(BMP280Capture, InitRejectsInvalidCfg)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_capture_init(NULL, &cfg));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_capture_init(&capture, NULL));
+
+    BMP280CaptureCfg bad = cfg;
+    bad.record = NULL;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_capture_init(&capture, &bad));
+    bad = cfg;
+    bad.ring = NULL;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_capture_init(&capture, &bad));
+    bad = cfg;
+    bad.baseline_shift = 17;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_capture_init(&capture, &bad));
+    bad = cfg;
+    bad.cusum_threshold = 0;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_capture_init(&capture, &bad));
+}
+
+TEST(BMP280Capture, InitAcceptsNoRing)
+{
+    cfg.ring = NULL;
+    cfg.ring_capacity = 0;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_capture_init(&capture, &cfg));
+
+    for (int i = 0; i < 20; i++) {
+        add(CAPTURE_SEA_LEVEL_PRES);
+    }
+    CHECK_TRUE(add(CAPTURE_SEA_LEVEL_PRES + 100 * CAPTURE_PA));
+    /* Only the triggering sample, nothing from before it */
+    CHECK_EQUAL(1, recorded.size());
+    CHECK_EQUAL(CAPTURE_SEA_LEVEL_PRES + 100 * CAPTURE_PA, recorded[0].pressure);
+}
+
+TEST(BMP280Capture, NoisySteadyPressureDoesNotTrigger)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_capture_init(&capture, &cfg));
+    uint32_t state = 1;
+    for (int i = 0; i < 10000; i++) {
+        CHECK_FALSE(add((uint32_t)((int32_t)CAPTURE_SEA_LEVEL_PRES + noise(&state, 3 * CAPTURE_PA))));
+    }
+    CHECK_EQUAL(0, capture.num_events);
+    CHECK_EQUAL(0, recorded.size());
+    CHECK_EQUAL(10000, capture.num_samples);
+}
+
+TEST(BMP280Capture, WeatherDriftDoesNotTrigger)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_capture_init(&capture, &cfg));
+    uint32_t state = 2;
+    /* A falling front of 5 hPa within an hour at 25 Hz */
+    const int num_samples = 3600 * 25;
+    for (int i = 0; i < num_samples; i++) {
+        int64_t drop = (int64_t)500 * CAPTURE_PA * i / num_samples;
+        add((uint32_t)((int64_t)CAPTURE_SEA_LEVEL_PRES - drop + noise(&state, 3 * CAPTURE_PA)));
+    }
+    CHECK_EQUAL(0, capture.num_events);
+    CHECK_EQUAL(0, recorded.size());
+}
+
+TEST(BMP280Capture, StepFlushesRingInOrderAndRecordsPostTrigger)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_capture_init(&capture, &cfg));
+    for (int i = 0; i < 100; i++) {
+        add(CAPTURE_SEA_LEVEL_PRES);
+    }
+    uint32_t first_ring_timestamp_ms = timestamp_ms - (CAPTURE_RING_CAPACITY - 1) * 40;
+
+    /* One floor down in a lift: about 36 Pa more. Too small for the jump threshold, CUSUM needs two samples. */
+    uint32_t floor_pres = CAPTURE_SEA_LEVEL_PRES + 36 * CAPTURE_PA;
+    CHECK_FALSE(add(floor_pres));
+    CHECK_TRUE(add(floor_pres));
+    CHECK_EQUAL(1, capture.num_events);
+    /* Pre-trigger ring, including the first sample of the step, and the triggering sample */
+    CHECK_EQUAL(CAPTURE_RING_CAPACITY + 1, recorded.size());
+    for (size_t i = 0; i < recorded.size(); i++) {
+        CHECK_EQUAL(0, recorded[i].event_seq);
+        CHECK_EQUAL(first_ring_timestamp_ms + 40 * (1 + i), recorded[i].timestamp_ms);
+    }
+    CHECK_EQUAL(floor_pres, recorded[CAPTURE_RING_CAPACITY - 1].pressure);
+
+    for (int i = 0; i < CAPTURE_POST_TRIGGER_SAMPLES - 1; i++) {
+        CHECK_TRUE(add(floor_pres));
+    }
+    CHECK_FALSE(add(floor_pres));
+    CHECK_EQUAL(CAPTURE_RING_CAPACITY + 1 + CAPTURE_POST_TRIGGER_SAMPLES, recorded.size());
+
+    /* The baseline restarted at the new level, so staying on the new floor does not trigger again */
+    for (int i = 0; i < 1000; i++) {
+        CHECK_FALSE(add(floor_pres));
+    }
+    CHECK_EQUAL(1, capture.num_events);
+    CHECK_EQUAL(CAPTURE_RING_CAPACITY + 1 + CAPTURE_POST_TRIGGER_SAMPLES, capture.num_recorded);
+}
+
+TEST(BMP280Capture, NegativeStepTriggers)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_capture_init(&capture, &cfg));
+    for (int i = 0; i < 100; i++) {
+        add(CAPTURE_SEA_LEVEL_PRES);
+    }
+    uint32_t floor_pres = CAPTURE_SEA_LEVEL_PRES - 36 * CAPTURE_PA;
+    CHECK_FALSE(add(floor_pres));
+    CHECK_TRUE(add(floor_pres));
+    CHECK_EQUAL(1, capture.num_events);
+}
+
+TEST(BMP280Capture, SpikeTriggersImmediately)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_capture_init(&capture, &cfg));
+    for (int i = 0; i < 3; i++) {
+        add(CAPTURE_SEA_LEVEL_PRES);
+    }
+    /* Door slam */
+    CHECK_TRUE(add(CAPTURE_SEA_LEVEL_PRES + 80 * CAPTURE_PA));
+    CHECK_EQUAL(1, capture.num_events);
+    /* Ring was not full yet */
+    CHECK_EQUAL(4, recorded.size());
+}
+
+TEST(BMP280Capture, SpikeWithoutJumpThresholdNeedsCusum)
+{
+    cfg.jump_threshold = 0;
+    cfg.cusum_threshold = 200 * CAPTURE_PA;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_capture_init(&capture, &cfg));
+    for (int i = 0; i < 100; i++) {
+        add(CAPTURE_SEA_LEVEL_PRES);
+    }
+    CHECK_FALSE(add(CAPTURE_SEA_LEVEL_PRES + 80 * CAPTURE_PA));
+    CHECK_FALSE(add(CAPTURE_SEA_LEVEL_PRES));
+    CHECK_EQUAL(0, capture.num_events);
+}
+
+TEST(BMP280Capture, RetriggerExtendsPostTriggerWindow)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_capture_init(&capture, &cfg));
+    for (int i = 0; i < 100; i++) {
+        add(CAPTURE_SEA_LEVEL_PRES);
+    }
+    uint32_t spike_pres = CAPTURE_SEA_LEVEL_PRES + 80 * CAPTURE_PA;
+    CHECK_TRUE(add(spike_pres));
+    size_t num_after_trigger = recorded.size();
+    CHECK_TRUE(add(spike_pres));
+    CHECK_TRUE(add(spike_pres));
+    /* Back to the old level, relative to the restarted baseline this is a jump again */
+    CHECK_TRUE(add(CAPTURE_SEA_LEVEL_PRES));
+    for (int i = 0; i < CAPTURE_POST_TRIGGER_SAMPLES - 1; i++) {
+        CHECK_TRUE(add(CAPTURE_SEA_LEVEL_PRES));
+    }
+    CHECK_FALSE(add(CAPTURE_SEA_LEVEL_PRES));
+
+    /* Still a single event */
+    CHECK_EQUAL(1, capture.num_events);
+    CHECK_EQUAL(num_after_trigger + 3 + CAPTURE_POST_TRIGGER_SAMPLES, recorded.size());
+    for (size_t i = 0; i < recorded.size(); i++) {
+        CHECK_EQUAL(0, recorded[i].event_seq);
+    }
+}
+
+TEST(BMP280Capture, SecondEventGetsNextSequenceNumber)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_capture_init(&capture, &cfg));
+    for (int i = 0; i < 100; i++) {
+        add(CAPTURE_SEA_LEVEL_PRES);
+    }
+    add(CAPTURE_SEA_LEVEL_PRES + 80 * CAPTURE_PA);
+    for (int i = 0; i < 100; i++) {
+        add(CAPTURE_SEA_LEVEL_PRES + 80 * CAPTURE_PA);
+    }
+    size_t num_first_event = recorded.size();
+    CHECK_TRUE(add(CAPTURE_SEA_LEVEL_PRES));
+
+    CHECK_EQUAL(2, capture.num_events);
+    CHECK_EQUAL(num_first_event + CAPTURE_RING_CAPACITY + 1, recorded.size());
+    CHECK_EQUAL(0, recorded[num_first_event - 1].event_seq);
+    for (size_t i = num_first_event; i < recorded.size(); i++) {
+        CHECK_EQUAL(1, recorded[i].event_seq);
+    }
+    /* The ring only holds samples from after the first event */
+    CHECK_TRUE(recorded[num_first_event].timestamp_ms > recorded[num_first_event - 1].timestamp_ms);
+}
+
+TEST(BMP280Capture, HourWithFewEventsRecordsSmallFraction)
+{
+    BMP280CaptureSample big_ring[25];
+    cfg.ring = big_ring;
+    cfg.ring_capacity = 25;
+    cfg.post_trigger_samples = 50;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_capture_init(&capture, &cfg));
+
+    /* One hour at 25 Hz with slow weather drift and noise, and three lift rides of five floors, 2 s per floor */
+    const uint32_t num_samples = 3600 * 25;
+    const uint32_t ride_starts[] = {20000, 50000, 80000};
+    const uint32_t ride_len = 5 * 50;
+    uint32_t state = 3;
+    int64_t level = 0;
+    for (uint32_t i = 0; i < num_samples; i++) {
+        for (size_t r = 0; r < 3; r++) {
+            if (i >= ride_starts[r] && i < ride_starts[r] + ride_len) {
+                /* Up for the first and third ride, down for the second */
+                int64_t step = (int64_t)36 * CAPTURE_PA / 50;
+                level += (r == 1) ? step : -step;
+            }
+        }
+        int64_t drift = (int64_t)200 * CAPTURE_PA * i / num_samples;
+        add((uint32_t)((int64_t)CAPTURE_SEA_LEVEL_PRES - drift + level + noise(&state, 3 * CAPTURE_PA)));
+    }
+
+    CHECK_EQUAL(num_samples, capture.num_samples);
+    CHECK_TRUE(capture.num_events >= 3);
+    /* Every ride is recorded in full */
+    for (size_t r = 0; r < 3; r++) {
+        uint32_t first_ms = 40 * (ride_starts[r] + 1);
+        uint32_t last_ms = 40 * (ride_starts[r] + ride_len);
+        size_t num_in_ride = 0;
+        for (size_t i = 0; i < recorded.size(); i++) {
+            if (recorded[i].timestamp_ms >= first_ms && recorded[i].timestamp_ms <= last_ms) {
+                num_in_ride++;
+            }
+        }
+        CHECK_EQUAL(ride_len, num_in_ride);
+    }
+    double fraction = (double)capture.num_recorded / (double)capture.num_samples;
+    CHECK_TRUE(fraction < 0.02);
+}
@@ -0,0 +1,321 @@
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280_chunk_store.h"
+
+#define CHUNK_STORE_SENSOR_ID 42
+#define CHUNK_STORE_DURATION_MS 60000
+#define CHUNK_STORE_NUM_CHUNKS 8
+#define CHUNK_STORE_PERIOD_MS 1000
+
+typedef struct {
+    uint64_t timestamp_ms;
+    BMP280Meas meas;
+} StoredSample;
+
+static void collect_sample(uint64_t timestamp_ms, const BMP280Meas *meas, void *user_data)
+{
+    std::vector<StoredSample> *samples = (std::vector<StoredSample> *)user_data;
+    StoredSample s = {timestamp_ms, *meas};
+    samples->push_back(s);
+}
+
+/* Slowly varying values around the datasheet example, so that deltas are small */
+static BMP280Meas sample_meas(size_t i)
+{
+    BMP280Meas meas;
+    meas.temperature = 2508 + (int32_t)(i % 50) - 25;
+    meas.pressure = 25767233 + (uint32_t)((i * 97) % 2000);
+    return meas;
+}
+
+// clang-format off
+TEST_GROUP(BMP280ChunkStore)
+{
+    BMP280ChunkStoreCfg cfg;
+    std::vector<uint64_t> mem;
+    BMP280ChunkStore store;
+
+    void setup()
+    {
+        cfg.sensor_id = CHUNK_STORE_SENSOR_ID;
+        cfg.chunk_duration_ms = CHUNK_STORE_DURATION_MS;
+        cfg.num_chunks = CHUNK_STORE_NUM_CHUNKS;
+        cfg.ts_col_size = 128;
+        cfg.temp_col_size = 128;
+        cfg.pres_col_size = 256;
+    }
+
+    void format()
+    {
+        size_t size = bmp280_chunk_store_mem_size(&cfg);
+        mem.assign((size + 7) / 8, 0);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_chunk_store_format(&store, mem.data(), size, &cfg));
+    }
+
+    /* Sample i at i * CHUNK_STORE_PERIOD_MS */
+    void append_regular(size_t first, size_t num)
+    {
+        for (size_t i = first; i < first + num; i++) {
+            BMP280Meas meas = sample_meas(i);
+            CHECK_EQUAL(BMP280_RESULT_CODE_OK,
+                        bmp280_chunk_store_append(&store, (uint64_t)i * CHUNK_STORE_PERIOD_MS, &meas));
+        }
+    }
+};
+// clang-format on
+
+TEST(BMP280ChunkStore, FormatFailsIfMemoryTooSmall)
+{
+    size_t size = bmp280_chunk_store_mem_size(&cfg);
+    mem.assign(size / 8, 0);
+    CHECK_EQUAL(BMP280_RESULT_CODE_NO_MEM, bmp280_chunk_store_format(&store, mem.data(), size - 8, &cfg));
+}
+
+TEST(BMP280ChunkStore, FormatFailsIfColumnTooSmall)
+{
+    cfg.ts_col_size = 9;
+    size_t size = bmp280_chunk_store_mem_size(&cfg);
+    mem.assign((size + 7) / 8, 0);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_chunk_store_format(&store, mem.data(), size, &cfg));
+}
+
+TEST(BMP280ChunkStore, QueryReturnsAllSamples)
+{
+    format();
+    /* Three chunks of 60 samples */
+    append_regular(0, 180);
+    CHECK_EQUAL(3, bmp280_chunk_store_num_chunks(&store));
+    CHECK_EQUAL(CHUNK_STORE_SENSOR_ID, bmp280_chunk_store_sensor_id(&store));
+
+    BMP280ChunkStoreFilter filter;
+    bmp280_chunk_store_filter_init(&filter, 0, UINT64_MAX);
+    std::vector<StoredSample> samples;
+    BMP280ChunkStoreQueryStats stats;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_chunk_store_query(&store, &filter, collect_sample, &samples, &stats));
+    CHECK_EQUAL(180, samples.size());
+    CHECK_EQUAL(180, stats.num_samples);
+    CHECK_EQUAL(3, stats.num_chunks_decoded);
+    for (size_t i = 0; i < samples.size(); i++) {
+        BMP280Meas expected = sample_meas(i);
+        CHECK_EQUAL((uint64_t)i * CHUNK_STORE_PERIOD_MS, samples[i].timestamp_ms);
+        CHECK_EQUAL(expected.temperature, samples[i].meas.temperature);
+        CHECK_EQUAL(expected.pressure, samples[i].meas.pressure);
+    }
+}
+
+TEST(BMP280ChunkStore, RegularTimestampsTakeOneByte)
+{
+    format();
+    append_regular(0, 60);
+    const BMP280ChunkStoreIndexEntry *e = &store.index[0];
+    CHECK_EQUAL(60, e->num_samples);
+    /* No bytes for the first timestamp, two for the first delta, one for every delta-of-delta of 0 */
+    CHECK_EQUAL(2 + 58, e->ts_len);
+    CHECK_EQUAL(0, e->first_ts_ms);
+    CHECK_EQUAL(59000, e->last_ts_ms);
+}
+
+TEST(BMP280ChunkStore, IrregularTimestampsAndLargeStepsRoundTrip)
+{
+    format();
+    std::vector<StoredSample> expected;
+    uint64_t ts = 1700000000000ULL;
+    uint32_t rng = 12345;
+    for (size_t i = 0; i < 500; i++) {
+        rng = rng * 1103515245U + 12345U;
+        /* Jitter, repeated timestamps and occasional gaps of many chunk windows */
+        ts += (i % 97 == 0) ? 10ULL * CHUNK_STORE_DURATION_MS : (rng >> 20) % 1500;
+        BMP280Meas meas;
+        meas.temperature = (i % 13 == 0) ? INT32_MIN + (int32_t)i : (int32_t)(rng >> 8) - 8000000;
+        meas.pressure = (i % 11 == 0) ? UINT32_MAX - (uint32_t)i : rng;
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_chunk_store_append(&store, ts, &meas));
+        StoredSample s = {ts, meas};
+        expected.push_back(s);
+    }
+
+    /* Only the newest chunks are kept, compare with the tail of the appended samples */
+    BMP280ChunkStoreFilter filter;
+    bmp280_chunk_store_filter_init(&filter, 0, UINT64_MAX);
+    std::vector<StoredSample> samples;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_chunk_store_query(&store, &filter, collect_sample, &samples, NULL));
+    CHECK(samples.size() > 0);
+    size_t offset = expected.size() - samples.size();
+    for (size_t i = 0; i < samples.size(); i++) {
+        CHECK_EQUAL(expected[offset + i].timestamp_ms, samples[i].timestamp_ms);
+        CHECK_EQUAL(expected[offset + i].meas.temperature, samples[i].meas.temperature);
+        CHECK_EQUAL(expected[offset + i].meas.pressure, samples[i].meas.pressure);
+    }
+}
+
+TEST(BMP280ChunkStore, AppendFailsForOlderTimestamp)
+{
+    format();
+    append_regular(10, 1);
+    BMP280Meas meas = sample_meas(0);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_chunk_store_append(&store, 9999, &meas));
+    /* Same timestamp as the previous sample is allowed */
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_chunk_store_append(&store, 10000, &meas));
+}
+
+TEST(BMP280ChunkStore, FullColumnStartsNewChunk)
+{
+    cfg.pres_col_size = 16;
+    format();
+    /* First pressure takes 4 bytes, then up to 2 bytes per delta */
+    append_regular(0, 20);
+    CHECK(bmp280_chunk_store_num_chunks(&store) > 1);
+
+    BMP280ChunkStoreFilter filter;
+    bmp280_chunk_store_filter_init(&filter, 0, UINT64_MAX);
+    std::vector<StoredSample> samples;
+    bmp280_chunk_store_query(&store, &filter, collect_sample, &samples, NULL);
+    CHECK_EQUAL(20, samples.size());
+    for (size_t i = 0; i < samples.size(); i++) {
+        CHECK_EQUAL(sample_meas(i).pressure, samples[i].meas.pressure);
+    }
+}
+
+TEST(BMP280ChunkStore, OldestChunkIsDroppedWhenFull)
+{
+    format();
+    append_regular(0, (CHUNK_STORE_NUM_CHUNKS + 2) * 60);
+    CHECK_EQUAL(CHUNK_STORE_NUM_CHUNKS, bmp280_chunk_store_num_chunks(&store));
+
+    BMP280ChunkStoreFilter filter;
+    bmp280_chunk_store_filter_init(&filter, 0, UINT64_MAX);
+    std::vector<StoredSample> samples;
+    bmp280_chunk_store_query(&store, &filter, collect_sample, &samples, NULL);
+    CHECK_EQUAL(CHUNK_STORE_NUM_CHUNKS * 60, samples.size());
+    CHECK_EQUAL(2 * 60 * CHUNK_STORE_PERIOD_MS, samples[0].timestamp_ms);
+}
+
+TEST(BMP280ChunkStore, RangeQuerySkipsChunksOutsideRange)
+{
+    format();
+    append_regular(0, CHUNK_STORE_NUM_CHUNKS * 60);
+
+    /* Samples 100...130: end of chunk 1 and start of chunk 2 */
+    BMP280ChunkStoreFilter filter;
+    bmp280_chunk_store_filter_init(&filter, 100000, 130000);
+    std::vector<StoredSample> samples;
+    BMP280ChunkStoreQueryStats stats;
+    bmp280_chunk_store_query(&store, &filter, collect_sample, &samples, &stats);
+    CHECK_EQUAL(31, samples.size());
+    CHECK_EQUAL(100000, samples.front().timestamp_ms);
+    CHECK_EQUAL(130000, samples.back().timestamp_ms);
+    CHECK_EQUAL(2, stats.num_chunks_decoded);
+    CHECK_EQUAL(CHUNK_STORE_NUM_CHUNKS - 2, stats.num_chunks_skipped);
+}
+
+TEST(BMP280ChunkStore, ThresholdQuerySkipsChunksBelowThreshold)
+{
+    format();
+    append_regular(0, 4 * 60);
+    /* A pressure spike in chunk 2 only */
+    BMP280Meas spike = sample_meas(0);
+    spike.pressure = 26000000;
+    bmp280_chunk_store_append(&store, 4 * 60 * CHUNK_STORE_PERIOD_MS, &spike);
+    append_regular(4 * 60 + 1, 2 * 60 - 1);
+
+    BMP280ChunkStoreFilter filter;
+    bmp280_chunk_store_filter_init(&filter, 0, UINT64_MAX);
+    filter.pres_min = 25900000;
+    std::vector<StoredSample> samples;
+    BMP280ChunkStoreQueryStats stats;
+    bmp280_chunk_store_query(&store, &filter, collect_sample, &samples, &stats);
+    CHECK_EQUAL(1, samples.size());
+    CHECK_EQUAL(240000, samples[0].timestamp_ms);
+    CHECK_EQUAL(1, stats.num_chunks_decoded);
+    CHECK_EQUAL(5, stats.num_chunks_skipped);
+}
+
+TEST(BMP280ChunkStore, MinMaxDecodesOnlyPartialChunks)
+{
+    format();
+    append_regular(0, CHUNK_STORE_NUM_CHUNKS * 60);
+
+    BMP280ChunkStoreMinMax result;
+    BMP280ChunkStoreQueryStats stats;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_chunk_store_minmax(&store, 30000, 400000, &result, &stats));
+    CHECK_EQUAL(1, stats.num_chunks_skipped);
+    CHECK_EQUAL(5, stats.num_chunks_from_index);
+    CHECK_EQUAL(2, stats.num_chunks_decoded);
+
+    /* Compare with a scan of all samples */
+    BMP280ChunkStoreMinMax expected = {INT32_MAX, INT32_MIN, UINT32_MAX, 0, 0};
+    for (size_t i = 30; i <= 400; i++) {
+        BMP280Meas m = sample_meas(i);
+        expected.temp_min = (m.temperature < expected.temp_min) ? m.temperature : expected.temp_min;
+        expected.temp_max = (m.temperature > expected.temp_max) ? m.temperature : expected.temp_max;
+        expected.pres_min = (m.pressure < expected.pres_min) ? m.pressure : expected.pres_min;
+        expected.pres_max = (m.pressure > expected.pres_max) ? m.pressure : expected.pres_max;
+        expected.num_samples++;
+    }
+    CHECK_EQUAL(expected.num_samples, result.num_samples);
+    CHECK_EQUAL(expected.temp_min, result.temp_min);
+    CHECK_EQUAL(expected.temp_max, result.temp_max);
+    CHECK_EQUAL(expected.pres_min, result.pres_min);
+    CHECK_EQUAL(expected.pres_max, result.pres_max);
+}
+
+TEST(BMP280ChunkStore, OpenContinuesExistingStore)
+{
+    format();
+    append_regular(0, 90);
+
+    /* Another handle on the same memory, as after remapping the file in another process */
+    BMP280ChunkStore reopened;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_chunk_store_open(&reopened, mem.data(), mem.size() * 8));
+    for (size_t i = 90; i < 150; i++) {
+        BMP280Meas meas = sample_meas(i);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_chunk_store_append(&reopened, i * CHUNK_STORE_PERIOD_MS, &meas));
+    }
+
+    BMP280ChunkStoreFilter filter;
+    bmp280_chunk_store_filter_init(&filter, 0, UINT64_MAX);
+    std::vector<StoredSample> samples;
+    bmp280_chunk_store_query(&store, &filter, collect_sample, &samples, NULL);
+    CHECK_EQUAL(150, samples.size());
+    for (size_t i = 0; i < samples.size(); i++) {
+        CHECK_EQUAL((uint64_t)i * CHUNK_STORE_PERIOD_MS, samples[i].timestamp_ms);
+        CHECK_EQUAL(sample_meas(i).temperature, samples[i].meas.temperature);
+    }
+}
+
+TEST(BMP280ChunkStore, OpenFailsWithoutStore)
+{
+    mem.assign(64, 0);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_chunk_store_open(&store, mem.data(), mem.size() * 8));
+}
+
+TEST(BMP280ChunkStore, DayQueryOverYearOfHistory)
+{
+    /* One sample per 10 s for a year, one chunk per hour */
+    cfg.chunk_duration_ms = 3600000;
+    cfg.num_chunks = 366 * 24;
+    cfg.ts_col_size = 512;
+    cfg.temp_col_size = 512;
+    cfg.pres_col_size = 1024;
+    format();
+    const size_t num_samples = 366 * 24 * 360;
+    for (size_t i = 0; i < num_samples; i++) {
+        BMP280Meas meas = sample_meas(i);
+        bmp280_chunk_store_append(&store, (uint64_t)i * 10000, &meas);
+    }
+    CHECK_EQUAL(366 * 24, bmp280_chunk_store_num_chunks(&store));
+
+    BMP280ChunkStoreFilter filter;
+    BMP280ChunkStoreQueryStats day_stats, all_stats;
+    uint64_t day_start = 200ULL * 24 * 3600000;
+    bmp280_chunk_store_filter_init(&filter, day_start, day_start + 24 * 3600000 - 1);
+    bmp280_chunk_store_query(&store, &filter, NULL, NULL, &day_stats);
+    bmp280_chunk_store_filter_init(&filter, 0, UINT64_MAX);
+    bmp280_chunk_store_query(&store, &filter, NULL, NULL, &all_stats);
+    CHECK_EQUAL(24 * 360, day_stats.num_samples);
+    CHECK_EQUAL(24, day_stats.num_chunks_decoded);
+    CHECK_EQUAL(num_samples, all_stats.num_samples);
+}
@@ -0,0 +1,359 @@
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280_compensate.h"
+#include "bmp280_compensate_constexpr.h"
+
+/* Example calib values from the datasheet p. 23. */
+static const BMP280CalibTemp default_calib_temp = {
+    .dig_T1 = 27504,
+    .dig_T2 = 26435,
+    .dig_T3 = -1000,
+};
+
+static const BMP280CalibPres default_calib_pres = {
+    .dig_P1 = 36477,
+    .dig_P2 = -10685,
+    .dig_P3 = 3024,
+    .dig_P4 = 2855,
+    .dig_P5 = 140,
+    .dig_P6 = -7,
+    .dig_P7 = 15500,
+    .dig_P8 = -14600,
+    .dig_P9 = 6000,
+};
+
+// clang-format off
+TEST_GROUP(BMP280Compensate){
+};
+// clang-format on
+
+TEST(BMP280Compensate, TempDatasheetExample)
+{
+    int32_t t_fine;
+    int32_t temperature = bmp280_compensate_temp(&default_calib_temp, 519888, &t_fine);
+    CHECK_EQUAL(2508, temperature);
+    CHECK_EQUAL(128422, t_fine);
+}
+
+TEST(BMP280Compensate, PresDatasheetExample)
+{
+    /* Should be 25767236 according to the example, but a small difference is expected due to integer calculation
+     * rounding errors. */
+    uint32_t pressure = bmp280_compensate_pres(&default_calib_pres, 415148, 128422);
+    CHECK_EQUAL(25767233, pressure);
+}
+
+TEST(BMP280Compensate, PresDivisionByZeroReturnsZero)
+{
+    BMP280CalibPres calib_pres = default_calib_pres;
+    /* Makes the divisor of the main pressure term 0 */
+    calib_pres.dig_P1 = 0;
+    CHECK_EQUAL(0, bmp280_compensate_pres(&calib_pres, 415148, 128422));
+
+    BMP280PresCoeffs coeffs;
+    bmp280_compensate_pres_coeffs(&calib_pres, 128422, &coeffs);
+    CHECK_EQUAL(0, bmp280_compensate_pres_with_coeffs(&coeffs, 415148));
+}
+
+TEST(BMP280Compensate, PresWithCoeffsMatchesReference)
+{
+    static const int32_t t_fine_vals[] = {-204800, 0, 100000, 128422, 200000, 256000};
+    for (size_t i = 0; i < sizeof(t_fine_vals) / sizeof(t_fine_vals[0]); i++) {
+        BMP280PresCoeffs coeffs;
+        bmp280_compensate_pres_coeffs(&default_calib_pres, t_fine_vals[i], &coeffs);
+        for (int32_t pres_raw = 0; pres_raw <= 0xFFFFF; pres_raw += 997) {
+            CHECK_EQUAL(bmp280_compensate_pres(&default_calib_pres, pres_raw, t_fine_vals[i]),
+                        bmp280_compensate_pres_with_coeffs(&coeffs, pres_raw));
+        }
+    }
+}
+
+static void check_temp_lut_matches_reference(const BMP280TempLut *lut, int32_t temp_raw)
+{
+    int32_t expected_t_fine;
+    int32_t expected_temperature = bmp280_compensate_temp(&default_calib_temp, temp_raw, &expected_t_fine);
+    int32_t t_fine;
+    int32_t temperature = bmp280_compensate_temp_lut(lut, &default_calib_temp, temp_raw, &t_fine);
+    CHECK_EQUAL(expected_temperature, temperature);
+    CHECK_EQUAL(expected_t_fine, t_fine);
+}
+
+TEST(BMP280Compensate, TempLutMatchesReference)
+{
+    static BMP280TempLutEntry entries[256];
+    BMP280TempLut lut;
+    int32_t raw_min = 519888 - 128 * 16;
+    bmp280_temp_lut_build(&lut, &default_calib_temp, entries, 256, raw_min, 4);
+
+    /* Every raw value inside the window, on the grid and between grid points, and some values outside the window */
+    for (int32_t temp_raw = raw_min - 64; temp_raw < raw_min + 256 * 16 + 64; temp_raw++) {
+        check_temp_lut_matches_reference(&lut, temp_raw);
+    }
+    check_temp_lut_matches_reference(&lut, 0);
+    check_temp_lut_matches_reference(&lut, 0xFFFFF);
+}
+
+TEST(BMP280Compensate, TempLutUsesTableEntries)
+{
+    static BMP280TempLutEntry entries[4];
+    BMP280TempLut lut;
+    bmp280_temp_lut_build(&lut, &default_calib_temp, entries, 4, 519888, 0);
+    /* Overwrite an entry to check that the lookup really comes from the table */
+    entries[0].temperature = 1234;
+    entries[0].t_fine = 5678;
+
+    int32_t t_fine;
+    CHECK_EQUAL(1234, bmp280_compensate_temp_lut(&lut, &default_calib_temp, 519888, &t_fine));
+    CHECK_EQUAL(5678, t_fine);
+    /* Outside of the window, must be calculated */
+    CHECK_EQUAL(2508, bmp280_compensate_temp_lut(&lut, &default_calib_temp, 519888 + 4, &t_fine));
+    int32_t expected_t_fine;
+    bmp280_compensate_temp(&default_calib_temp, 519888 + 4, &expected_t_fine);
+    CHECK_EQUAL(expected_t_fine, t_fine);
+}
+
+TEST(BMP280Compensate, TempLutNoEntriesFallsBackToCalculation)
+{
+    BMP280TempLut lut = {
+        .entries = NULL,
+        .num_entries = 0,
+        .raw_min = 0,
+        .raw_shift = 0,
+    };
+    int32_t t_fine;
+    CHECK_EQUAL(2508, bmp280_compensate_temp_lut(&lut, &default_calib_temp, 519888, &t_fine));
+    CHECK_EQUAL(128422, t_fine);
+}
+
+/* Datasheet example p. 23, evaluated by the compiler */
+static_assert(bmp280::compensate_temp<bmp280::DatasheetCalib>(519888).temperature == 2508, "");
+static_assert(bmp280::compensate_temp<bmp280::DatasheetCalib>(519888).t_fine == 128422, "");
+static_assert(bmp280::compensate_pres<bmp280::DatasheetCalib>(415148, 128422) == 25767233, "");
+static_assert(bmp280::temp_to_raw<bmp280::DatasheetCalib>(2508) <= 519888, "");
+static_assert(bmp280::compensate_temp<bmp280::DatasheetCalib>(bmp280::temp_to_raw<bmp280::DatasheetCalib>(2508))
+                      .temperature == 2508,
+              "");
+static_assert(bmp280::pres_to_raw<bmp280::DatasheetCalib>(25767233, 128422) == 415148, "");
+
+TEST(BMP280Compensate, ConstexprMatchesReference)
+{
+    constexpr BMP280CalibTemp calib_temp = bmp280::calib_temp<bmp280::DatasheetCalib>();
+    constexpr BMP280CalibPres calib_pres = bmp280::calib_pres<bmp280::DatasheetCalib>();
+    MEMCMP_EQUAL(&default_calib_temp, &calib_temp, sizeof(calib_temp));
+    MEMCMP_EQUAL(&default_calib_pres, &calib_pres, sizeof(calib_pres));
+
+    for (int32_t raw = bmp280::raw_min; raw <= bmp280::raw_max; raw += 331) {
+        int32_t t_fine;
+        int32_t temperature = bmp280_compensate_temp(&calib_temp, raw, &t_fine);
+        bmp280::TempResult temp = bmp280::compensate_temp<bmp280::DatasheetCalib>(raw);
+        CHECK_EQUAL(temperature, temp.temperature);
+        CHECK_EQUAL(t_fine, temp.t_fine);
+        CHECK_EQUAL(bmp280_compensate_pres(&calib_pres, raw, t_fine),
+                    bmp280::compensate_pres<bmp280::DatasheetCalib>(raw, t_fine));
+    }
+}
+
+TEST(BMP280Compensate, ConstexprMeasTable)
+{
+    /* 16 expected measurements around the datasheet example, generated at compile time */
+    constexpr bmp280::MeasTable<16> table =
+        bmp280::make_meas_table<bmp280::DatasheetCalib, 16>(519888 - 8 * 16, 16, 415148 - 8 * 64, 64);
+    static_assert(table.temperature[8] == 2508, "");
+    static_assert(table.pressure[8] == 25767233, "");
+
+    for (size_t i = 0; i < 16; i++) {
+        int32_t t_fine;
+        CHECK_EQUAL(bmp280_compensate_temp(&default_calib_temp, table.temp_raw[i], &t_fine), table.temperature[i]);
+        CHECK_EQUAL(bmp280_compensate_pres(&default_calib_pres, table.pres_raw[i], t_fine), table.pressure[i]);
+    }
+}
+
+TEST(BMP280Compensate, ConstexprInverseReturnsClosestSmallestRaw)
+{
+    int32_t t_fine = 128422;
+    /* 950 hPa ... 1050 hPa in 10 hPa steps, Q24.8 */
+    for (uint32_t pa = 95000; pa <= 105000; pa += 1000) {
+        uint32_t pressure = pa * 256;
+        int32_t raw = bmp280::pres_to_raw<bmp280::DatasheetCalib>(pressure, t_fine);
+        uint32_t result = bmp280_compensate_pres(&default_calib_pres, raw, t_fine);
+        uint32_t err = (result > pressure) ? result - pressure : pressure - result;
+        /* Neighbouring raw values are not closer */
+        uint32_t prev = bmp280_compensate_pres(&default_calib_pres, raw - 1, t_fine);
+        uint32_t next = bmp280_compensate_pres(&default_calib_pres, raw + 1, t_fine);
+        CHECK(prev - pressure > err);
+        CHECK(pressure - next >= err);
+    }
+
+    for (int32_t temperature = -4000; temperature <= 8500; temperature += 500) {
+        int32_t raw = bmp280::temp_to_raw<bmp280::DatasheetCalib>(temperature);
+        int32_t t_fine_unused;
+        int32_t result = bmp280_compensate_temp(&default_calib_temp, raw, &t_fine_unused);
+        int32_t err = (result > temperature) ? result - temperature : temperature - result;
+        CHECK(temperature - bmp280_compensate_temp(&default_calib_temp, raw - 1, &t_fine_unused) > err);
+        CHECK(bmp280_compensate_temp(&default_calib_temp, raw + 1, &t_fine_unused) - temperature >= err);
+    }
+
+    /* Pressures above the range of the calibration values map to the smallest raw value */
+    CHECK_EQUAL(bmp280::raw_min, bmp280::pres_to_raw<bmp280::DatasheetCalib>(UINT32_MAX, t_fine));
+    /* Raw values close to raw_max produce negative pressures, so 0 Pa is inside the range */
+    int32_t raw_0_pa = bmp280::pres_to_raw<bmp280::DatasheetCalib>(0, t_fine);
+    CHECK((int32_t)bmp280_compensate_pres(&default_calib_pres, raw_0_pa, t_fine) <= 0);
+    CHECK((int32_t)bmp280_compensate_pres(&default_calib_pres, raw_0_pa - 1, t_fine) > 0);
+}
+
+TEST(BMP280Compensate, InverseTempMatchesConstexprInverse)
+{
+    for (int32_t temperature = -6000; temperature <= 12000; temperature += 37) {
+        CHECK_EQUAL(bmp280::temp_to_raw<bmp280::DatasheetCalib>(temperature),
+                    bmp280_inverse_compensate_temp(&default_calib_temp, temperature));
+    }
+    /* Outside of the range of the calibration values */
+    CHECK_EQUAL(0, bmp280_inverse_compensate_temp(&default_calib_temp, INT32_MIN));
+    CHECK_EQUAL(0xFFFFF, bmp280_inverse_compensate_temp(&default_calib_temp, INT32_MAX));
+}
+
+TEST(BMP280Compensate, InversePresMatchesConstexprInverse)
+{
+    static const int32_t t_fine_vals[] = {-100000, 0, 128422, 200000};
+    for (size_t i = 0; i < sizeof(t_fine_vals) / sizeof(t_fine_vals[0]); i++) {
+        for (uint32_t pressure = 30000 * 256; pressure <= 110000 * 256; pressure += 99991) {
+            CHECK_EQUAL(bmp280::pres_to_raw<bmp280::DatasheetCalib>(pressure, t_fine_vals[i]),
+                        bmp280_inverse_compensate_pres(&default_calib_pres, pressure, t_fine_vals[i]));
+        }
+        CHECK_EQUAL(bmp280::pres_to_raw<bmp280::DatasheetCalib>(0, t_fine_vals[i]),
+                    bmp280_inverse_compensate_pres(&default_calib_pres, 0, t_fine_vals[i]));
+        CHECK_EQUAL(0, bmp280_inverse_compensate_pres(&default_calib_pres, UINT32_MAX, t_fine_vals[i]));
+    }
+}
+
+TEST(BMP280Compensate, InverseTargetEqualsFirstKey)
+{
+    /* The temperature of raw value 0 is shared by raw values 1...7, the smallest one is returned */
+    int32_t t_fine;
+    int32_t temperature = bmp280_compensate_temp(&default_calib_temp, 0, &t_fine);
+    CHECK_EQUAL(temperature, bmp280_compensate_temp(&default_calib_temp, 7, &t_fine));
+    CHECK_EQUAL(0, bmp280_inverse_compensate_temp(&default_calib_temp, temperature));
+
+    BMP280PresCoeffs coeffs;
+    bmp280_compensate_pres_coeffs(&default_calib_pres, 128422, &coeffs);
+    uint32_t pressure = bmp280_compensate_pres_with_coeffs(&coeffs, 0);
+    CHECK_EQUAL(0, bmp280_inverse_compensate_pres_with_coeffs(&coeffs, pressure));
+}
+
+TEST(BMP280Compensate, InverseTieWithFirstKey)
+{
+    /* Raw values 0 and 1 compensate to 2035301, raw value 2 to 2035299. Target 2035300 is equally close to both, the
+     * smallest raw value wins. */
+    const BMP280PresCoeffs coeffs = {22880090409LL, -542251962667828LL, 30959, 19881, -28726};
+    CHECK_EQUAL(2035301, bmp280_compensate_pres_with_coeffs(&coeffs, 1));
+    CHECK_EQUAL(2035299, bmp280_compensate_pres_with_coeffs(&coeffs, 2));
+    CHECK_EQUAL(0, bmp280_inverse_compensate_pres_with_coeffs(&coeffs, 2035300));
+}
+
+TEST(BMP280Compensate, InversePresInvalidCalibReturnsZero)
+{
+    BMP280CalibPres calib_pres = default_calib_pres;
+    calib_pres.dig_P1 = 0;
+    CHECK_EQUAL(0, bmp280_inverse_compensate_pres(&calib_pres, 101325 * 256, 128422));
+}
+
+TEST(BMP280Compensate, RawValFromRegsDatasheetExample)
+{
+    /* Registers 0xF7...0xFC, the lower 4 bits of xlsb are not part of the value */
+    static const uint8_t frame[BMP280_RAW_FRAME_SIZE] = {0x65, 0x5A, 0xCF, 0x7E, 0xED, 0x0F};
+    CHECK_EQUAL(415148, bmp280_raw_val_from_regs(&frame[0]));
+    CHECK_EQUAL(519888, bmp280_raw_val_from_regs(&frame[3]));
+}
+
+TEST(BMP280Compensate, InverseBatchFramesCompensateToTargets)
+{
+    /* Repeated temperatures and pressures exercise reuse of previous results */
+    static const BMP280Meas meas[] = {
+        {2508, 25767233}, {2508, 25767233}, {2508, 101325 * 256}, {-1000, 101325 * 256},
+        {-1000, 80000 * 256}, {4000, 80000 * 256}, {4000, 80000 * 256}, {2000, 95000 * 256},
+    };
+    const size_t num_meas = sizeof(meas) / sizeof(meas[0]);
+    uint8_t frames[sizeof(meas) / sizeof(meas[0]) * BMP280_RAW_FRAME_SIZE];
+    bmp280_inverse_compensate_batch(&default_calib_temp, &default_calib_pres, meas, frames, num_meas);
+
+    for (size_t i = 0; i < num_meas; i++) {
+        int32_t pres_raw = bmp280_raw_val_from_regs(&frames[i * BMP280_RAW_FRAME_SIZE]);
+        int32_t temp_raw = bmp280_raw_val_from_regs(&frames[i * BMP280_RAW_FRAME_SIZE + 3]);
+        int32_t t_fine;
+        CHECK_EQUAL(meas[i].temperature, bmp280_compensate_temp(&default_calib_temp, temp_raw, &t_fine));
+        CHECK_EQUAL(bmp280_inverse_compensate_pres(&default_calib_pres, meas[i].pressure, t_fine), pres_raw);
+        /* One raw LSb is less than 1/256 Pa * 64 around these pressures */
+        uint32_t pressure = bmp280_compensate_pres(&default_calib_pres, pres_raw, t_fine);
+        uint32_t err = (pressure > meas[i].pressure) ? pressure - meas[i].pressure : meas[i].pressure - pressure;
+        CHECK(err < 64);
+    }
+}
+
+TEST(BMP280Compensate, GatherMatchesReference)
+{
+    /* Sensor 2 has a zero divisor, sensor 3 has extreme temperature calibration values */
+    const size_t num_sensors = 5;
+    BMP280CalibTemp calib_temp[num_sensors];
+    BMP280CalibPres calib_pres[num_sensors];
+    static int32_t coeffs[BMP280_CALIB_SOA_NUM_COEFFS * 5];
+    BMP280CalibSoA soa = {coeffs, num_sensors};
+    for (size_t s = 0; s < num_sensors; s++) {
+        calib_temp[s] = default_calib_temp;
+        calib_pres[s] = default_calib_pres;
+        calib_temp[s].dig_T1 = (uint16_t)(calib_temp[s].dig_T1 + s * 100);
+        calib_pres[s].dig_P1 = (uint16_t)(calib_pres[s].dig_P1 - s * 300);
+        calib_pres[s].dig_P8 = (int16_t)(calib_pres[s].dig_P8 + s * 50);
+    }
+    calib_pres[2].dig_P1 = 0;
+    calib_temp[3].dig_T2 = INT16_MAX;
+    calib_temp[3].dig_T3 = INT16_MIN;
+    for (size_t s = 0; s < num_sensors; s++) {
+        bmp280_calib_soa_set(&soa, s, &calib_temp[s], &calib_pres[s]);
+    }
+
+    /* Sensor order, then shuffled order, and a count that is not a multiple of the lane count */
+    const size_t num_samples = 4 * BMP280_COMPENSATE_GATHER_LANES + 3;
+    uint32_t calib_idx[num_samples];
+    int32_t temp_raw[num_samples];
+    int32_t pres_raw[num_samples];
+    BMP280Meas meas[num_samples];
+    for (size_t i = 0; i < num_samples; i++) {
+        calib_idx[i] = (uint32_t)((i < num_samples / 2) ? (i % num_sensors) : ((i * 3) % num_sensors));
+        temp_raw[i] = 519888 + (int32_t)(i * 1031) - 40000;
+        pres_raw[i] = 415148 + (int32_t)(i * 4099) - 100000;
+    }
+    bmp280_compensate_gather(&soa, calib_idx, temp_raw, pres_raw, meas, num_samples);
+
+    for (size_t i = 0; i < num_samples; i++) {
+        int32_t t_fine;
+        CHECK_EQUAL(bmp280_compensate_temp(&calib_temp[calib_idx[i]], temp_raw[i], &t_fine), meas[i].temperature);
+        CHECK_EQUAL(bmp280_compensate_pres(&calib_pres[calib_idx[i]], pres_raw[i], t_fine), meas[i].pressure);
+    }
+}
+
+TEST(BMP280Compensate, CalibSoaIsTransposed)
+{
+    int32_t coeffs[BMP280_CALIB_SOA_NUM_COEFFS * 3] = {0};
+    BMP280CalibSoA soa = {coeffs, 3};
+    bmp280_calib_soa_set(&soa, 1, &default_calib_temp, &default_calib_pres);
+    CHECK_EQUAL(default_calib_temp.dig_T1, coeffs[0 * 3 + 1]);
+    CHECK_EQUAL(default_calib_temp.dig_T3, coeffs[2 * 3 + 1]);
+    CHECK_EQUAL(default_calib_pres.dig_P1, coeffs[3 * 3 + 1]);
+    CHECK_EQUAL(default_calib_pres.dig_P9, coeffs[11 * 3 + 1]);
+    CHECK_EQUAL(0, coeffs[0]);
+    CHECK_EQUAL(0, coeffs[2]);
+}
+
+TEST(BMP280Compensate, GatherDatasheetExample)
+{
+    int32_t coeffs[BMP280_CALIB_SOA_NUM_COEFFS];
+    BMP280CalibSoA soa = {coeffs, 1};
+    bmp280_calib_soa_set(&soa, 0, &default_calib_temp, &default_calib_pres);
+    const uint32_t calib_idx = 0;
+    const int32_t temp_raw = 519888;
+    const int32_t pres_raw = 415148;
+    BMP280Meas meas;
+    bmp280_compensate_gather(&soa, &calib_idx, &temp_raw, &pres_raw, &meas, 1);
+    CHECK_EQUAL(2508, meas.temperature);
+    CHECK_EQUAL(25767233, meas.pressure);
+}
@@ -0,0 +1,290 @@
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280.h"
+#include "bmp280_cq.h"
+#include "sim.h"
+#include "sim_bmp280.h"
+#include "sim_fixture.h"
+
+#define CQ_RING_CAPACITY 8
+#define CQ_NUM_SENSORS 200
+#define CQ_NUM_BUSES 8
+/* Large enough for all sensors completing within one tick */
+#define CQ_SIM_RING_CAPACITY 256
+#define CQ_TICK_US 1000
+
+static BMP280Completion entries[CQ_SIM_RING_CAPACITY];
+static BMP280CompletionRing ring;
+static BMP280CQSlot slots[CQ_NUM_SENSORS];
+
+static SimBMP280 cq_devs[CQ_NUM_SENSORS];
+static BMP280 cq_insts[CQ_NUM_SENSORS];
+static SimBus cq_buses[CQ_NUM_BUSES];
+
+// clang-format off
+TEST_GROUP(BMP280CQ){
+    void setup() {
+        memset(entries, 0, sizeof(entries));
+        memset(slots, 0, sizeof(slots));
+        uint8_t rc = bmp280_cq_init(&ring, entries, CQ_RING_CAPACITY);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    }
+    void teardown() {
+        /* Releases the memory of the event heap, so that it is not reported as a leak */
+        sim_reset();
+    }
+};
+// clang-format on
+
+/** Append a completion as if an operation with @p tag completed with @p rc. */
+static void complete_with_tag(uint64_t tag, uint8_t rc, int32_t temperature)
+{
+    BMP280CQSlot *slot = &slots[0];
+    void *user_data = bmp280_cq_slot_prepare(slot, &ring, tag);
+    slot->meas.temperature = temperature;
+    slot->meas.pressure = 0;
+    bmp280_cq_complete_cb(rc, user_data);
+}
+
+TEST(BMP280CQ, InitCapacityNotPowerOf2)
+{
+    uint8_t rc = bmp280_cq_init(&ring, entries, 6);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, rc);
+    rc = bmp280_cq_init(&ring, entries, 0);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, rc);
+}
+
+TEST(BMP280CQ, InitNull)
+{
+    uint8_t rc = bmp280_cq_init(NULL, entries, CQ_RING_CAPACITY);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, rc);
+    rc = bmp280_cq_init(&ring, NULL, CQ_RING_CAPACITY);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, rc);
+}
+
+TEST(BMP280CQ, PeekEmpty)
+{
+    const BMP280Completion *completions;
+    CHECK_EQUAL(0, bmp280_cq_peek(&ring, &completions));
+    CHECK_EQUAL(0, bmp280_cq_num_pending(&ring));
+}
+
+TEST(BMP280CQ, CompletionsAreReapedInOrder)
+{
+    complete_with_tag(0x1122334455667788ULL, BMP280_RESULT_CODE_OK, 2508);
+    complete_with_tag(2, BMP280_RESULT_CODE_IO_ERR, 0);
+    CHECK_EQUAL(2, bmp280_cq_num_pending(&ring));
+
+    const BMP280Completion *completions;
+    size_t num = bmp280_cq_peek(&ring, &completions);
+    CHECK_EQUAL(2, num);
+    CHECK(completions[0].tag == 0x1122334455667788ULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, completions[0].rc);
+    CHECK_EQUAL(2508, completions[0].meas.temperature);
+    CHECK(completions[1].tag == 2);
+    CHECK_EQUAL(BMP280_RESULT_CODE_IO_ERR, completions[1].rc);
+    bmp280_cq_advance(&ring, num);
+    CHECK_EQUAL(0, bmp280_cq_num_pending(&ring));
+}
+
+TEST(BMP280CQ, PeekStopsAtEndOfRing)
+{
+    for (uint64_t tag = 0; tag < 6; tag++) {
+        complete_with_tag(tag, BMP280_RESULT_CODE_OK, 0);
+    }
+    bmp280_cq_advance(&ring, 6);
+    /* Tags 6 and 7 are at the end of the ring, 8...10 wrap around to the start */
+    for (uint64_t tag = 6; tag < 11; tag++) {
+        complete_with_tag(tag, BMP280_RESULT_CODE_OK, 0);
+    }
+
+    const BMP280Completion *completions;
+    size_t num = bmp280_cq_peek(&ring, &completions);
+    CHECK_EQUAL(2, num);
+    CHECK(completions[0].tag == 6);
+    CHECK(completions[1].tag == 7);
+    bmp280_cq_advance(&ring, num);
+
+    num = bmp280_cq_peek(&ring, &completions);
+    CHECK_EQUAL(3, num);
+    POINTERS_EQUAL(&entries[0], completions);
+    CHECK(completions[0].tag == 8);
+    CHECK(completions[2].tag == 10);
+    bmp280_cq_advance(&ring, num);
+    CHECK_EQUAL(0, bmp280_cq_num_pending(&ring));
+}
+
+TEST(BMP280CQ, FullRingDropsCompletions)
+{
+    for (uint64_t tag = 0; tag < CQ_RING_CAPACITY + 3; tag++) {
+        complete_with_tag(tag, BMP280_RESULT_CODE_OK, 0);
+    }
+    CHECK_EQUAL(CQ_RING_CAPACITY, bmp280_cq_num_pending(&ring));
+    CHECK_EQUAL(3, ring.num_dropped);
+
+    /* The oldest completions are kept */
+    const BMP280Completion *completions;
+    size_t num = bmp280_cq_peek(&ring, &completions);
+    CHECK_EQUAL(CQ_RING_CAPACITY, num);
+    CHECK(completions[0].tag == 0);
+    CHECK(completions[CQ_RING_CAPACITY - 1].tag == CQ_RING_CAPACITY - 1);
+}
+
+TEST(BMP280CQ, ReadMeasForcedModeSlotNull)
+{
+    uint8_t rc = bmp280_cq_read_meas_forced_mode((BMP280)sim_fixture_get_inst_buf(NULL), NULL, &ring, 1,
+                                                 BMP280_MEAS_TYPE_TEMP_AND_PRES, 7);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, rc);
+}
+
+TEST(BMP280CQ, BusySubmitKeepsTagOfOperationInProgress)
+{
+    sim_reset();
+    sim_fixture_reset_inst_bufs();
+    sim_bus_init(&cq_buses[0], 70, 23);
+    sim_bmp280_init(&cq_devs[0], &cq_buses[0], sim_fixture_calib_data);
+    cq_devs[0].temp_raw = 519888;
+    cq_devs[0].pres_raw = 415148;
+    BMP280InitCfg cfg = {
+        .get_inst_buf = sim_fixture_get_inst_buf,
+        .get_inst_buf_user_data = NULL,
+        .read_regs = sim_bmp280_read_regs,
+        .read_regs_user_data = (void *)&cq_devs[0],
+        .write_reg = sim_bmp280_write_reg,
+        .write_reg_user_data = (void *)&cq_devs[0],
+        .start_timer = sim_start_timer,
+        .start_timer_user_data = NULL,
+        .lazy_init_meas = true,
+    };
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_create(&cq_insts[0], &cfg));
+
+    uint8_t rc = bmp280_cq_read_meas_forced_mode(cq_insts[0], &slots[0], &ring, 7, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    BMP280Completion other_entries[CQ_RING_CAPACITY];
+    BMP280CompletionRing other_ring;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_cq_init(&other_ring, other_entries, CQ_RING_CAPACITY));
+    rc = bmp280_cq_read_meas_forced_mode(cq_insts[0], &slots[0], &other_ring, 8, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7);
+    CHECK_EQUAL(BMP280_RESULT_CODE_BUSY, rc);
+    rc = bmp280_cq_slot_submitted(&slots[0],
+                                  bmp280_init_meas(cq_insts[0], bmp280_cq_complete_cb,
+                                                   bmp280_cq_slot_prepare(&slots[0], &other_ring, 9)));
+    CHECK_EQUAL(BMP280_RESULT_CODE_BUSY, rc);
+    sim_run();
+
+    CHECK_EQUAL(0, bmp280_cq_num_pending(&other_ring));
+    const BMP280Completion *completions;
+    CHECK_EQUAL(1, bmp280_cq_peek(&ring, &completions));
+    CHECK(completions[0].tag == 7);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, completions[0].rc);
+}
+
+typedef struct {
+    uint32_t num_samples[CQ_NUM_SENSORS];
+    uint32_t num_errors;
+    uint32_t num_reaps;
+} CQReapStats;
+
+static CQReapStats reap_stats;
+static uint32_t cq_samples_per_sensor;
+
+/** Event loop tick: reap all completions, and submit the next measurement of every sensor that completed. */
+static void cq_tick(void *user_data)
+{
+    (void)user_data;
+    const BMP280Completion *completions;
+    size_t num;
+    bool any_active = false;
+    while ((num = bmp280_cq_peek(&ring, &completions)) > 0) {
+        reap_stats.num_reaps++;
+        for (size_t i = 0; i < num; i++) {
+            size_t sensor_idx = (size_t)completions[i].tag;
+            if ((completions[i].rc != BMP280_RESULT_CODE_OK) || (completions[i].meas.temperature != 2508)) {
+                reap_stats.num_errors++;
+                continue;
+            }
+            reap_stats.num_samples[sensor_idx]++;
+            if (reap_stats.num_samples[sensor_idx] < cq_samples_per_sensor) {
+                uint8_t rc = bmp280_cq_read_meas_forced_mode(cq_insts[sensor_idx], &slots[sensor_idx], &ring,
+                                                             sensor_idx, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7);
+                if (rc != BMP280_RESULT_CODE_OK) {
+                    reap_stats.num_errors++;
+                }
+            }
+        }
+        bmp280_cq_advance(&ring, num);
+    }
+
+    for (size_t i = 0; i < CQ_NUM_SENSORS; i++) {
+        if (reap_stats.num_samples[i] < cq_samples_per_sensor) {
+            any_active = true;
+            break;
+        }
+    }
+    if (any_active && (reap_stats.num_errors == 0)) {
+        sim_schedule_us(CQ_TICK_US, cq_tick, NULL);
+    }
+}
+
+TEST(BMP280CQ, ThousandsOfSamplesReapedInBatches)
+{
+    sim_reset();
+    uint8_t rc = bmp280_cq_init(&ring, entries, CQ_SIM_RING_CAPACITY);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    memset(&reap_stats, 0, sizeof(reap_stats));
+    sim_fixture_reset_inst_bufs();
+    cq_samples_per_sensor = 20;
+    for (size_t i = 0; i < CQ_NUM_BUSES; i++) {
+        sim_bus_init(&cq_buses[i], 70, 23);
+    }
+
+    for (size_t i = 0; i < CQ_NUM_SENSORS; i++) {
+        sim_bmp280_init(&cq_devs[i], &cq_buses[i % CQ_NUM_BUSES], sim_fixture_calib_data);
+        cq_devs[i].temp_raw = 519888;
+        cq_devs[i].pres_raw = 415148;
+        BMP280InitCfg cfg = {
+            .get_inst_buf = sim_fixture_get_inst_buf,
+            .get_inst_buf_user_data = NULL,
+            .read_regs = sim_bmp280_read_regs,
+            .read_regs_user_data = (void *)&cq_devs[i],
+            .write_reg = sim_bmp280_write_reg,
+            .write_reg_user_data = (void *)&cq_devs[i],
+            .start_timer = sim_start_timer,
+            .start_timer_user_data = NULL,
+            .lazy_init_meas = true,
+        };
+        rc = bmp280_create(&cq_insts[i], &cfg);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+        rc = bmp280_set_pres_oversampling(cq_insts[i], BMP280_OVERSAMPLING_1, bmp280_cq_complete_cb,
+                                          bmp280_cq_slot_prepare(&slots[i], &ring, i));
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    }
+    /* Completions of set oversampling */
+    sim_run();
+    CHECK_EQUAL(CQ_NUM_SENSORS, bmp280_cq_num_pending(&ring));
+    bmp280_cq_advance(&ring, CQ_NUM_SENSORS);
+    for (size_t i = 0; i < CQ_NUM_SENSORS; i++) {
+        rc = bmp280_set_temp_oversampling(cq_insts[i], BMP280_OVERSAMPLING_1, bmp280_cq_complete_cb,
+                                          bmp280_cq_slot_prepare(&slots[i], &ring, i));
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    }
+    sim_run();
+    bmp280_cq_advance(&ring, CQ_NUM_SENSORS);
+
+    /* First measurement of every sensor, the rest are submitted from the reap loop */
+    for (size_t i = 0; i < CQ_NUM_SENSORS; i++) {
+        rc = bmp280_cq_read_meas_forced_mode(cq_insts[i], &slots[i], &ring, i, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    }
+    sim_schedule_us(CQ_TICK_US, cq_tick, NULL);
+    sim_run();
+
+    CHECK_EQUAL(0, reap_stats.num_errors);
+    CHECK_EQUAL(0, ring.num_dropped);
+    for (size_t i = 0; i < CQ_NUM_SENSORS; i++) {
+        CHECK_EQUAL(cq_samples_per_sensor, reap_stats.num_samples[i]);
+    }
+    /* Completions are processed in batches, not one by one */
+    CHECK(reap_stats.num_reaps * 4 < CQ_NUM_SENSORS * cq_samples_per_sensor);
+}
@@ -0,0 +1,298 @@
+#include <stdlib.h>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280.h"
+#include "bmp280_energy.h"
+#include "sim.h"
+#include "sim_bmp280.h"
+#include "sim_fixture.h"
+
+/* 0.35 mA of pull-up current for the 70 us overhead and 23 us per byte of the simulated bus */
+#define ENERGY_BUS_TRANSACTION_FC (70ULL * 350000)
+#define ENERGY_BUS_BYTE_FC (23ULL * 350000)
+/* Temperature and pressure conversion at 1x oversampling: 3 ms at 325 uA, 2.5 ms at 720 uA */
+#define ENERGY_ULP_CONVERSION_FC (3000ULL * 325000 + 2500ULL * 720000)
+
+static BMP280 bmp280;
+static SimBus sim_bus;
+static SimBMP280 sim_dev;
+static BMP280Energy energy;
+static BMP280Meas meas;
+static uint32_t num_complete_cb_calls;
+static uint8_t complete_cb_rc;
+
+static uint32_t energy_now_us(void *user_data)
+{
+    (void)user_data;
+    return (uint32_t)sim_now_us();
+}
+
+static void energy_complete_cb(uint8_t rc, void *user_data)
+{
+    (void)user_data;
+    num_complete_cb_calls++;
+    complete_cb_rc = rc;
+}
+
+static void energy_io_complete_cb(uint8_t io_rc, void *user_data)
+{
+    (void)user_data;
+    num_complete_cb_calls++;
+    complete_cb_rc = io_rc;
+}
+
+static uint64_t bus_fc(uint64_t num_transactions, uint64_t num_bytes)
+{
+    return num_transactions * ENERGY_BUS_TRANSACTION_FC + num_bytes * ENERGY_BUS_BYTE_FC;
+}
+
+// clang-format off
+TEST_GROUP(BMP280Energy){
+    void setup() {
+        sim_reset();
+        sim_fixture_reset_inst_bufs();
+        sim_bus_init(&sim_bus, 70, 23);
+        sim_bmp280_init(&sim_dev, &sim_bus, sim_fixture_calib_data);
+        sim_dev.temp_raw = 519888;
+        sim_dev.pres_raw = 415148;
+        num_complete_cb_calls = 0;
+        complete_cb_rc = 0xFF;
+
+        BMP280EnergyCfg energy_cfg = {
+            .currents = BMP280_ENERGY_DATASHEET_CURRENTS,
+            .bus_transaction_fc = ENERGY_BUS_TRANSACTION_FC,
+            .bus_byte_fc = ENERGY_BUS_BYTE_FC,
+            .now_us = energy_now_us,
+            .now_us_user_data = NULL,
+            .read_regs = sim_bmp280_read_regs,
+            .read_regs_user_data = (void *)&sim_dev,
+            .write_reg = sim_bmp280_write_reg,
+            .write_reg_user_data = (void *)&sim_dev,
+        };
+        uint8_t rc = bmp280_energy_init(&energy, &energy_cfg);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+
+        BMP280InitCfg cfg = {
+            .get_inst_buf = sim_fixture_get_inst_buf,
+            .get_inst_buf_user_data = NULL,
+            .read_regs = bmp280_energy_read_regs,
+            .read_regs_user_data = (void *)&energy,
+            .write_reg = bmp280_energy_write_reg,
+            .write_reg_user_data = (void *)&energy,
+            .start_timer = sim_start_timer,
+            .start_timer_user_data = NULL,
+            .lazy_init_meas = false,
+        };
+        rc = bmp280_create(&bmp280, &cfg);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    }
+};
+// clang-format on
+
+static void init_sensor()
+{
+    uint8_t rc = bmp280_init_meas(bmp280, energy_complete_cb, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    sim_run();
+    num_complete_cb_calls = 0;
+}
+
+static void write_reg(uint8_t addr, uint8_t val)
+{
+    bmp280_energy_write_reg(addr, val, (void *)&energy, energy_io_complete_cb, NULL);
+    sim_run();
+}
+
+TEST(BMP280Energy, InitInvalArg)
+{
+    BMP280EnergyCfg cfg = energy.cfg;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_energy_init(NULL, &cfg));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_energy_init(&energy, NULL));
+    cfg.now_us = NULL;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_energy_init(&energy, &cfg));
+    cfg = energy.cfg;
+    cfg.write_reg = NULL;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_energy_init(&energy, &cfg));
+}
+
+TEST(BMP280Energy, ConversionChargeFollowsOversampling)
+{
+    BMP280EnergyCurrents currents = BMP280_ENERGY_DATASHEET_CURRENTS;
+    CHECK_EQUAL(ENERGY_ULP_CONVERSION_FC,
+                bmp280_energy_conversion_fc(&currents, BMP280_OVERSAMPLING_1, BMP280_OVERSAMPLING_1));
+    /* Only the temperature phase */
+    CHECK_EQUAL(3000ULL * 325000,
+                bmp280_energy_conversion_fc(&currents, BMP280_OVERSAMPLING_1, BMP280_OVERSAMPLING_SKIPPED));
+    /* Ultra high resolution: 5 ms temperature, 32.5 ms pressure */
+    CHECK_EQUAL(5000ULL * 325000 + 32500ULL * 720000,
+                bmp280_energy_conversion_fc(&currents, BMP280_OVERSAMPLING_2, BMP280_OVERSAMPLING_16));
+    /* Field values above 16x are 16x */
+    CHECK_EQUAL(bmp280_energy_conversion_fc(&currents, BMP280_OVERSAMPLING_16, BMP280_OVERSAMPLING_16),
+                bmp280_energy_conversion_fc(&currents, 7, 6));
+}
+
+TEST(BMP280Energy, ForcedModeReadChargedPerOperation)
+{
+    init_sensor();
+    bmp280_energy_update(&energy);
+    BMP280EnergyCounters before = energy.counters;
+    uint64_t transactions_before = sim_bus.num_transactions;
+    uint64_t bytes_before = sim_bus.num_bytes;
+    uint64_t start_us = sim_now_us();
+
+    uint8_t rc = bmp280_energy_read_meas_forced_mode(bmp280, &energy, BMP280_OVERSAMPLING_1, BMP280_OVERSAMPLING_1,
+                                                     &meas, energy_complete_cb, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    sim_run();
+
+    CHECK_EQUAL(1, num_complete_cb_calls);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, complete_cb_rc);
+    CHECK_EQUAL(25767233, meas.pressure);
+    CHECK_EQUAL(before.num_conversions + 1, energy.counters.num_conversions);
+    CHECK_EQUAL(before.conversion_fc + ENERGY_ULP_CONVERSION_FC, energy.counters.conversion_fc);
+    /* ctrl_meas write and data read */
+    CHECK_EQUAL(2, sim_bus.num_transactions - transactions_before);
+    uint64_t op_bus_fc = bus_fc(sim_bus.num_transactions - transactions_before, sim_bus.num_bytes - bytes_before);
+    CHECK_EQUAL(before.bus_fc + op_bus_fc, energy.counters.bus_fc);
+    uint64_t op_sleep_fc = (sim_now_us() - start_us) * 100;
+    CHECK_EQUAL(ENERGY_ULP_CONVERSION_FC + op_bus_fc + op_sleep_fc, energy.counters.last_op_fc);
+}
+
+TEST(BMP280Energy, DriverSequencesWithForcedModeWriteCounted)
+{
+    init_sensor();
+    /* bmp280_read_meas_forced_mode writes ctrl_meas with the oversampling options read back from the sensor */
+    uint8_t rc = bmp280_set_pres_oversampling(bmp280, BMP280_OVERSAMPLING_4, energy_complete_cb, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    sim_run();
+    rc = bmp280_set_temp_oversampling(bmp280, BMP280_OVERSAMPLING_1, energy_complete_cb, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    sim_run();
+    uint64_t conversions_before = energy.counters.num_conversions;
+    uint64_t conversion_fc_before = energy.counters.conversion_fc;
+
+    rc = bmp280_read_meas_forced_mode(bmp280, BMP280_MEAS_TYPE_TEMP_AND_PRES, 20, &meas, energy_complete_cb, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    sim_run();
+
+    CHECK_EQUAL(sim_dev.num_conversions, energy.counters.num_conversions);
+    CHECK_EQUAL(conversions_before + 1, energy.counters.num_conversions);
+    CHECK_EQUAL(conversion_fc_before + 3000ULL * 325000 + 8500ULL * 720000, energy.counters.conversion_fc);
+}
+
+TEST(BMP280Energy, SleepCurrentAccruesOverTime)
+{
+    bmp280_energy_update(&energy);
+    uint64_t idle_before = energy.counters.idle_fc;
+    sim_run_until_us(sim_now_us() + 1000000);
+    bmp280_energy_update(&energy);
+    /* 0.1 uA for 1 s */
+    CHECK_EQUAL(idle_before + 100000000ULL, energy.counters.idle_fc);
+    CHECK_EQUAL(0, energy.counters.conversion_fc);
+}
+
+TEST(BMP280Energy, NormalModeAverageCurrent)
+{
+    /* t_sb 1000 ms, then osrs_t 1x, osrs_p 1x, normal mode */
+    write_reg(0xF5, 0xA0);
+    write_reg(0xF4, 0x27);
+    bmp280_energy_update(&energy);
+    BMP280EnergyCounters before = energy.counters;
+
+    sim_run_until_us(sim_now_us() + 100000000);
+    uint64_t total_before = before.conversion_fc + before.idle_fc + before.bus_fc;
+    uint64_t avg_na = (bmp280_energy_total_fc(&energy) - total_before) / 100000000;
+    /* (2775 nC + 1000 ms * 0.2 uA) per 1005.5 ms cycle */
+    CHECK_EQUAL((ENERGY_ULP_CONVERSION_FC + 1000000ULL * 200) / 1005500, avg_na);
+    /* Normal mode conversions are not forced mode conversions */
+    CHECK_EQUAL(before.num_conversions, energy.counters.num_conversions);
+
+    /* Back to sleep */
+    write_reg(0xF4, 0x24);
+    uint64_t conversion_fc = energy.counters.conversion_fc;
+    uint64_t idle_fc = energy.counters.idle_fc;
+    sim_run_until_us(sim_now_us() + 1000000);
+    bmp280_energy_update(&energy);
+    CHECK_EQUAL(conversion_fc, energy.counters.conversion_fc);
+    CHECK_EQUAL(idle_fc + 100000000ULL, energy.counters.idle_fc);
+}
+
+TEST(BMP280Energy, ResetReturnsToSleep)
+{
+    write_reg(0xF5, 0x00);
+    write_reg(0xF4, 0x27);
+    write_reg(0xE0, 0xB6);
+    uint64_t conversion_fc = energy.counters.conversion_fc;
+    sim_run_until_us(sim_now_us() + 1000000);
+    bmp280_energy_update(&energy);
+    CHECK_EQUAL(conversion_fc, energy.counters.conversion_fc);
+}
+
+TEST(BMP280Energy, FailedWriteChargesBusOnly)
+{
+    sim_dev.io_fail = true;
+    write_reg(0xF4, 0x25);
+    CHECK_EQUAL(BMP280_IO_RESULT_CODE_ERR, complete_cb_rc);
+    CHECK_EQUAL(0, energy.counters.num_conversions);
+    CHECK_EQUAL(0, energy.counters.conversion_fc);
+    CHECK_EQUAL(bus_fc(1, 1), energy.counters.bus_fc);
+}
+
+TEST(BMP280Energy, BusyRejectionKeepsOperationInProgress)
+{
+    init_sensor();
+    uint8_t rc = bmp280_energy_read_meas_forced_mode(bmp280, &energy, BMP280_OVERSAMPLING_1, BMP280_OVERSAMPLING_1,
+                                                     &meas, energy_complete_cb, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    BMP280Meas other_meas;
+    rc = bmp280_energy_read_meas_forced_mode(bmp280, &energy, BMP280_OVERSAMPLING_1, BMP280_OVERSAMPLING_1,
+                                             &other_meas, NULL, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_BUSY, rc);
+    rc = bmp280_energy_read_meas_forced_mode(bmp280, NULL, BMP280_OVERSAMPLING_1, BMP280_OVERSAMPLING_1, &other_meas,
+                                             NULL, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, rc);
+    sim_run();
+
+    CHECK_EQUAL(1, num_complete_cb_calls);
+    CHECK_EQUAL(1, energy.counters.num_conversions);
+    CHECK_TRUE(energy.counters.last_op_fc >= ENERGY_ULP_CONVERSION_FC);
+}
+
+TEST(BMP280Energy, PlanMatchesMeasuredSampling)
+{
+    init_sensor();
+    uint64_t total_before = bmp280_energy_total_fc(&energy);
+    uint64_t start_us = sim_now_us();
+
+    /* 1 Hz for 60 s */
+    for (int i = 0; i < 60; i++) {
+        uint8_t rc = bmp280_energy_read_meas_forced_mode(bmp280, &energy, BMP280_OVERSAMPLING_1,
+                                                         BMP280_OVERSAMPLING_1, &meas, energy_complete_cb, NULL);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+        sim_run_until_us(start_us + (uint64_t)(i + 1) * 1000000);
+    }
+    CHECK_EQUAL(60, num_complete_cb_calls);
+
+    uint64_t measured_na = (bmp280_energy_total_fc(&energy) - total_before) / 60000000;
+    uint32_t planned_na =
+        bmp280_energy_plan_current_na(&energy.cfg, BMP280_OVERSAMPLING_1, BMP280_OVERSAMPLING_1, 1000);
+    CHECK_TRUE(abs((int)measured_na - (int)planned_na) <= 1);
+    /* Datasheet table 4: 2.74 uA in ultra low power mode at 1 Hz */
+    CHECK_TRUE(abs((int)planned_na - 2740) < 300);
+}
+
+TEST(BMP280Energy, PlanComparesOversamplingWithSoftwareAveraging)
+{
+    BMP280EnergyCfg cfg = energy.cfg;
+    /* Same noise reduction: one 16x pressure sample per second, or 16 samples at 1x averaged, one every 62 ms */
+    uint32_t hw_na = bmp280_energy_plan_current_na(&cfg, BMP280_OVERSAMPLING_2, BMP280_OVERSAMPLING_16, 1000);
+    uint32_t sw_na = bmp280_energy_plan_current_na(&cfg, BMP280_OVERSAMPLING_1, BMP280_OVERSAMPLING_1, 62);
+    /* Oversampling in the sensor saves the temperature phase and bus transactions of 15 samples */
+    CHECK_TRUE(hw_na < sw_na);
+
+    /* Halving the rate halves the active current */
+    uint32_t half_rate_na = bmp280_energy_plan_current_na(&cfg, BMP280_OVERSAMPLING_2, BMP280_OVERSAMPLING_16, 2000);
+    CHECK_TRUE(abs((int)(hw_na - 100) - 2 * (int)(half_rate_na - 100)) <= 2);
+    CHECK_EQUAL(0, bmp280_energy_plan_current_na(&cfg, BMP280_OVERSAMPLING_1, BMP280_OVERSAMPLING_1, 0));
+}
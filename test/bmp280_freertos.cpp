@@ -0,0 +1,253 @@
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280.h"
+#include "bmp280_freertos.h"
+#include "sim_fixture.h"
+#include "task.h"
+
+/* Fake asynchronous bus: a transfer completes from the "interrupt" that the block hook simulates */
+static struct {
+    uint8_t regs[256];
+    uint32_t num_started;
+    /* Device of the transfer in progress, NULL if none */
+    BMP280FreeRTOSDev *pending;
+    /* If true, the transfer completes before its start function returns */
+    bool complete_immediately;
+    /* Ticks from the start of the block until the completion interrupt */
+    TickType_t completion_ticks;
+} bus;
+
+static void complete_transfer(BMP280FreeRTOSDev *dev)
+{
+    BaseType_t woken = pdFALSE;
+    bmp280_freertos_io_done_from_isr(dev, BMP280_IO_RESULT_CODE_OK, &woken);
+    CHECK_EQUAL(pdTRUE, woken);
+}
+
+static void fake_start_read(void *bus_user_data, BMP280FreeRTOSDev *dev, uint8_t start_addr, size_t num_regs,
+                            uint8_t *data)
+{
+    (void)bus_user_data;
+    memcpy(data, &bus.regs[start_addr], num_regs);
+    bus.num_started++;
+    if (bus.complete_immediately) {
+        bmp280_freertos_io_done(dev, BMP280_IO_RESULT_CODE_OK);
+    } else {
+        bus.pending = dev;
+    }
+}
+
+static void fake_start_write(void *bus_user_data, BMP280FreeRTOSDev *dev, uint8_t addr, uint8_t reg_val)
+{
+    (void)bus_user_data;
+    bus.regs[addr] = reg_val;
+    bus.num_started++;
+    if (bus.complete_immediately) {
+        bmp280_freertos_io_done(dev, BMP280_IO_RESULT_CODE_OK);
+    } else {
+        bus.pending = dev;
+    }
+}
+
+static TickType_t fake_bus_block_hook(TickType_t ticks_to_wait, void *user_data)
+{
+    (void)user_data;
+    if (!bus.pending || (bus.completion_ticks > ticks_to_wait)) {
+        return ticks_to_wait;
+    }
+    BMP280FreeRTOSDev *dev = bus.pending;
+    bus.pending = NULL;
+    complete_transfer(dev);
+    return bus.completion_ticks;
+}
+
+typedef struct {
+    uint32_t num_calls;
+    uint8_t rc;
+    TickType_t tick;
+} FreeRTOSCbRecord;
+
+static void record_io_cb(uint8_t io_rc, void *user_data)
+{
+    FreeRTOSCbRecord *rec = (FreeRTOSCbRecord *)user_data;
+    rec->num_calls++;
+    rec->rc = io_rc;
+    rec->tick = xTaskGetTickCount();
+}
+
+static void record_timer_cb(void *user_data)
+{
+    record_io_cb(BMP280_IO_RESULT_CODE_OK, user_data);
+}
+
+static void record_complete_cb(uint8_t rc, void *user_data)
+{
+    record_io_cb(rc, user_data);
+}
+
+// clang-format off
+TEST_GROUP(BMP280FreeRTOS){
+    BMP280FreeRTOSContext ctx;
+    BMP280FreeRTOSDev devs[2];
+    FreeRTOSCbRecord recs[2];
+    uint8_t data[6];
+
+    void setup() {
+        stub_freertos_reset();
+        sim_fixture_reset_inst_bufs();
+        memset(&bus, 0, sizeof(bus));
+        memset(recs, 0, sizeof(recs));
+        stub_freertos_set_block_hook(fake_bus_block_hook, NULL);
+        bmp280_freertos_ctx_init(&ctx);
+        bmp280_freertos_dev_init(&devs[0], &ctx, fake_start_read, fake_start_write, NULL);
+        bmp280_freertos_dev_init(&devs[1], &ctx, fake_start_read, fake_start_write, NULL);
+    }
+};
+// clang-format on
+
+TEST(BMP280FreeRTOS, CompletionFromIsrRunsCallbackInDriverTask)
+{
+    bus.completion_ticks = 2;
+    bmp280_freertos_read_regs(0xD0, 1, data, (void *)&devs[0], record_io_cb, &recs[0]);
+    CHECK_EQUAL(1, bus.num_started);
+    /* The callback is never executed from the start function or the interrupt */
+    CHECK_EQUAL(0, recs[0].num_calls);
+
+    bmp280_freertos_process(&ctx, portMAX_DELAY);
+    CHECK_EQUAL(1, recs[0].num_calls);
+    CHECK_EQUAL(BMP280_IO_RESULT_CODE_OK, recs[0].rc);
+    CHECK_EQUAL(2, recs[0].tick);
+    CHECK_EQUAL(0, recs[1].num_calls);
+    CHECK_EQUAL(1, ctx.num_wakeups);
+    CHECK_EQUAL(1, ctx.num_notifications);
+    CHECK_EQUAL(portMAX_DELAY, stub_freertos_last_wait_ticks());
+}
+
+TEST(BMP280FreeRTOS, CompletionBeforeWaitIsNotLost)
+{
+    bus.complete_immediately = true;
+    bmp280_freertos_write_reg(0xF4, 0x25, (void *)&devs[1], record_io_cb, &recs[1]);
+    CHECK_EQUAL(0, recs[1].num_calls);
+
+    /* The notification is pending, the wait returns without blocking */
+    bmp280_freertos_process(&ctx, portMAX_DELAY);
+    CHECK_EQUAL(0, stub_freertos_num_blocks());
+    CHECK_EQUAL(1, recs[1].num_calls);
+    CHECK_EQUAL(0x25, bus.regs[0xF4]);
+    CHECK_EQUAL(0, recs[0].num_calls);
+}
+
+TEST(BMP280FreeRTOS, CompletionsOfSeveralDevicesInOneWakeup)
+{
+    bus.complete_immediately = true;
+    bmp280_freertos_read_regs(0xD0, 1, data, (void *)&devs[0], record_io_cb, &recs[0]);
+    bmp280_freertos_read_regs(0xD0, 1, data, (void *)&devs[1], record_io_cb, &recs[1]);
+    bmp280_freertos_process(&ctx, portMAX_DELAY);
+    CHECK_EQUAL(1, recs[0].num_calls);
+    CHECK_EQUAL(1, recs[1].num_calls);
+    CHECK_EQUAL(1, ctx.num_wakeups);
+}
+
+TEST(BMP280FreeRTOS, TimeoutIsNearestDeadline)
+{
+    stub_freertos_set_tick_count(100);
+    bmp280_freertos_start_timer(10, (void *)&devs[0], record_timer_cb, &recs[0]);
+    bmp280_freertos_start_timer(5, (void *)&devs[1], record_timer_cb, &recs[1]);
+
+    /* 5 ms plus one tick, because the current tick can be up to one tick period old */
+    bmp280_freertos_process(&ctx, portMAX_DELAY);
+    CHECK_EQUAL(6, stub_freertos_last_wait_ticks());
+    CHECK_EQUAL(0, recs[0].num_calls);
+    CHECK_EQUAL(1, recs[1].num_calls);
+    CHECK_EQUAL(106, recs[1].tick);
+    CHECK_EQUAL(0, ctx.num_notifications);
+
+    bmp280_freertos_process(&ctx, portMAX_DELAY);
+    CHECK_EQUAL(5, stub_freertos_last_wait_ticks());
+    CHECK_EQUAL(1, recs[0].num_calls);
+    CHECK_EQUAL(111, recs[0].tick);
+    CHECK_EQUAL(1, recs[1].num_calls);
+    CHECK_EQUAL(2, ctx.num_wakeups);
+}
+
+TEST(BMP280FreeRTOS, MaxWaitTicksLimitsTheWait)
+{
+    bmp280_freertos_start_timer(50, (void *)&devs[0], record_timer_cb, &recs[0]);
+    bmp280_freertos_process(&ctx, 20);
+    CHECK_EQUAL(20, stub_freertos_last_wait_ticks());
+    CHECK_EQUAL(0, recs[0].num_calls);
+
+    bmp280_freertos_process(&ctx, 20);
+    bmp280_freertos_process(&ctx, 20);
+    CHECK_EQUAL(11, stub_freertos_last_wait_ticks());
+    CHECK_EQUAL(1, recs[0].num_calls);
+
+    /* No timer running */
+    bmp280_freertos_process(&ctx, 20);
+    CHECK_EQUAL(20, stub_freertos_last_wait_ticks());
+    CHECK_EQUAL(1, recs[0].num_calls);
+    CHECK_EQUAL(4, ctx.num_wakeups);
+}
+
+TEST(BMP280FreeRTOS, PassedDeadlineDoesNotBlock)
+{
+    bmp280_freertos_start_timer(5, (void *)&devs[0], record_timer_cb, &recs[0]);
+    stub_freertos_set_tick_count(10);
+    bmp280_freertos_process(&ctx, portMAX_DELAY);
+    CHECK_EQUAL(0, stub_freertos_last_wait_ticks());
+    CHECK_EQUAL(1, recs[0].num_calls);
+}
+
+TEST(BMP280FreeRTOS, DeadlineAcrossTickCountWrap)
+{
+    stub_freertos_set_tick_count(0xFFFFFFF0UL);
+    bmp280_freertos_start_timer(32, (void *)&devs[0], record_timer_cb, &recs[0]);
+    bmp280_freertos_process(&ctx, portMAX_DELAY);
+    CHECK_EQUAL(33, stub_freertos_last_wait_ticks());
+    CHECK_EQUAL(1, recs[0].num_calls);
+    CHECK_EQUAL(0x11, recs[0].tick);
+}
+
+TEST(BMP280FreeRTOS, ForcedModeReadThroughDriverTask)
+{
+    memcpy(&bus.regs[0x88], sim_fixture_calib_data, sizeof(sim_fixture_calib_data));
+    memcpy(&bus.regs[0xF7], sim_fixture_data_regs, sizeof(sim_fixture_data_regs));
+    /* Temperature and pressure oversampling x1, sleep mode */
+    bus.regs[0xF4] = 0x24;
+    bus.completion_ticks = 1;
+
+    BMP280 inst;
+    BMP280InitCfg init_cfg = {
+        .get_inst_buf = sim_fixture_get_inst_buf,
+        .get_inst_buf_user_data = NULL,
+        .read_regs = bmp280_freertos_read_regs,
+        .read_regs_user_data = (void *)&devs[0],
+        .write_reg = bmp280_freertos_write_reg,
+        .write_reg_user_data = (void *)&devs[0],
+        .start_timer = bmp280_freertos_start_timer,
+        .start_timer_user_data = (void *)&devs[0],
+        .lazy_init_meas = false,
+    };
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_create(&inst, &init_cfg));
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_init_meas(inst, record_complete_cb, &recs[0]));
+    while (recs[0].num_calls == 0) {
+        bmp280_freertos_process(&ctx, portMAX_DELAY);
+    }
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, recs[0].rc);
+
+    BMP280Meas meas;
+    uint32_t start_wakeups = ctx.num_wakeups;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK,
+                bmp280_read_meas_forced_mode(inst, BMP280_MEAS_TYPE_TEMP_AND_PRES, 5, &meas, record_complete_cb,
+                                             &recs[1]));
+    while (recs[1].num_calls == 0) {
+        bmp280_freertos_process(&ctx, portMAX_DELAY);
+    }
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, recs[1].rc);
+    CHECK_EQUAL(2508, meas.temperature);
+    CHECK_EQUAL(25767233U, meas.pressure);
+    /* ctrl_meas read, forced mode write, conversion wait and data read: one wakeup each */
+    CHECK_EQUAL(4, ctx.num_wakeups - start_wakeups);
+}
@@ -0,0 +1,224 @@
+#include <string.h>
+#include <sys/ioctl.h>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280.h"
+#include "bmp280_linux_bus.h"
+#include "sim_fixture.h"
+
+static const uint32_t linux_bus_speeds_hz[] = {1000000, 2000000, 4000000, 5000000, 8000000, 10000000};
+
+#define LINUX_BUS_NUM_SPEEDS (sizeof(linux_bus_speeds_hz) / sizeof(linux_bus_speeds_hz[0]))
+/* File descriptor of the simulated device, it has chip select index 0 */
+#define LINUX_BUS_FAKE_FD 42
+
+/* Simulated BMP280 on a line of limited quality */
+static struct {
+    uint8_t regs[256];
+    /* Reads above this clock speed return corrupted data */
+    uint32_t max_stable_hz;
+    /* Reads at this clock speed return corrupted data on every corrupt_every-th ioctl only */
+    uint32_t marginal_hz;
+    uint32_t corrupt_every;
+    /* If true, every ioctl fails */
+    bool fail;
+    uint64_t num_ioctls;
+    /* Speed of the latest transfer, and sum of clock cycle durations */
+    uint32_t last_speed_hz;
+    uint64_t bus_time_ns;
+} fake;
+
+static int fake_spi_ioctl(int fd, unsigned long request, void *arg)
+{
+    CHECK_EQUAL(LINUX_BUS_FAKE_FD, fd);
+    fake.num_ioctls++;
+    if (fake.fail) {
+        return -1;
+    }
+
+    size_t num_xfers = _IOC_SIZE(request) / sizeof(struct spi_ioc_transfer);
+    struct spi_ioc_transfer *xfers = (struct spi_ioc_transfer *)arg;
+    for (size_t i = 0; i < num_xfers; i++) {
+        struct spi_ioc_transfer *xfer = &xfers[i];
+        fake.last_speed_hz = xfer->speed_hz;
+        fake.bus_time_ns += (uint64_t)xfer->len * 8 * 1000000000ULL / xfer->speed_hz;
+        if (!xfer->tx_buf) {
+            continue;
+        }
+        const uint8_t *tx = (const uint8_t *)(uintptr_t)xfer->tx_buf;
+        if (xfer->len == 2) {
+            fake.regs[tx[0] | 0x80] = tx[1];
+            continue;
+        }
+        /* Register address, followed by the data read */
+        struct spi_ioc_transfer *data_xfer = &xfers[++i];
+        uint8_t *rx = (uint8_t *)(uintptr_t)data_xfer->rx_buf;
+        bool corrupt = (data_xfer->speed_hz > fake.max_stable_hz) ||
+                       ((data_xfer->speed_hz == fake.marginal_hz) && (fake.num_ioctls % fake.corrupt_every == 0));
+        for (size_t j = 0; j < data_xfer->len; j++) {
+            rx[j] = fake.regs[((tx[0] & 0x7F) | 0x80) + j];
+        }
+        if (corrupt) {
+            /* A bit sampled too early on the last byte */
+            rx[data_xfer->len - 1] ^= 0x01;
+        }
+        fake.bus_time_ns += (uint64_t)data_xfer->len * 8 * 1000000000ULL / data_xfer->speed_hz;
+    }
+    return 0;
+}
+
+static void linux_bus_submit_complete_cb(void *user_data)
+{
+    (void)user_data;
+}
+
+// clang-format off
+TEST_GROUP(BMP280LinuxBus){
+    BMP280LinuxSpiBus bus;
+    BMP280LinuxSpiTuneCfg cfg;
+
+    void setup() {
+        memset(&fake, 0, sizeof(fake));
+        fake.regs[0xD0] = 0x58;
+        memcpy(&fake.regs[0x88], sim_fixture_calib_data, sizeof(sim_fixture_calib_data));
+        fake.max_stable_hz = 6000000;
+        fake.corrupt_every = 1;
+
+        int fds[1] = {LINUX_BUS_FAKE_FD};
+        bmp280_linux_spi_bus_init(&bus, fds, 1);
+        bus.ioctl_fn = fake_spi_ioctl;
+        cfg.speeds_hz = linux_bus_speeds_hz;
+        cfg.num_speeds = LINUX_BUS_NUM_SPEEDS;
+        cfg.num_reads = 8;
+        cfg.margin_steps = 1;
+        cfg.window_transactions = 100;
+        cfg.max_window_errors = 5;
+    }
+};
+// clang-format on
+
+/* One forced mode sample through the batch submit function: ctrl_meas write and 6 byte data read */
+static void submit_sample(BMP280LinuxSpiBus *bus)
+{
+    uint8_t data[6];
+    BMP280BusTransfer transfers[2];
+    memset(transfers, 0, sizeof(transfers));
+    transfers[0].reg_addr = 0xF4;
+    transfers[0].write_val = 0x25;
+    transfers[0].next = &transfers[1];
+    transfers[1].reg_addr = 0xF7;
+    transfers[1].is_read = true;
+    transfers[1].data = data;
+    transfers[1].len = sizeof(data);
+    bmp280_linux_spi_submit(transfers, 2, (void *)bus, linux_bus_submit_complete_cb, NULL);
+}
+
+TEST(BMP280LinuxBus, TuneInvalArg)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_linux_spi_tune(NULL, 0, &cfg));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_linux_spi_tune(&bus, 0, NULL));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_linux_spi_tune(&bus, 1, &cfg));
+    BMP280LinuxSpiTuneCfg bad = cfg;
+    bad.num_speeds = 0;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_linux_spi_tune(&bus, 0, &bad));
+    bad = cfg;
+    bad.num_reads = 0;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_linux_spi_tune(&bus, 0, &bad));
+    bad = cfg;
+    bad.max_window_errors = 0;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_linux_spi_tune(&bus, 0, &bad));
+    CHECK_EQUAL(0, fake.num_ioctls);
+}
+
+TEST(BMP280LinuxBus, TunePicksFastestStableSpeedWithMargin)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_linux_spi_tune(&bus, 0, &cfg));
+    /* 5 MHz is the fastest stable speed, 8 MHz fails, one step of margin */
+    CHECK_EQUAL(4000000, bus.clocks[0].speed_hz);
+    CHECK_EQUAL(2, bus.clocks[0].speed_idx);
+
+    submit_sample(&bus);
+    CHECK_EQUAL(4000000, fake.last_speed_hz);
+}
+
+TEST(BMP280LinuxBus, IntermittentCorruptionFailsSpeed)
+{
+    /* 5 MHz corrupts one read in three */
+    fake.marginal_hz = 5000000;
+    fake.corrupt_every = 3;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_linux_spi_tune(&bus, 0, &cfg));
+    CHECK_EQUAL(2000000, bus.clocks[0].speed_hz);
+}
+
+TEST(BMP280LinuxBus, AllSpeedsStableRunsFastestWithoutMargin)
+{
+    fake.max_stable_hz = 20000000;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_linux_spi_tune(&bus, 0, &cfg));
+    CHECK_EQUAL(10000000, bus.clocks[0].speed_hz);
+
+    fake.bus_time_ns = 0;
+    submit_sample(&bus);
+    uint64_t tuned_ns = fake.bus_time_ns;
+    bus.clocks[0].speed_hz = 1000000;
+    fake.bus_time_ns = 0;
+    submit_sample(&bus);
+    uint64_t base_ns = fake.bus_time_ns;
+    CHECK_EQUAL(10 * tuned_ns, base_ns);
+}
+
+TEST(BMP280LinuxBus, BaseSpeedFailureKeepsSpeed)
+{
+    fake.max_stable_hz = 500000;
+    CHECK_EQUAL(BMP280_RESULT_CODE_IO_ERR, bmp280_linux_spi_tune(&bus, 0, &cfg));
+    CHECK_EQUAL(0, bus.clocks[0].speed_hz);
+    POINTERS_EQUAL(NULL, bus.clocks[0].tune_cfg);
+
+    fake.max_stable_hz = 6000000;
+    fake.fail = true;
+    CHECK_EQUAL(BMP280_RESULT_CODE_IO_ERR, bmp280_linux_spi_tune(&bus, 0, &cfg));
+    CHECK_EQUAL(0, bus.clocks[0].speed_hz);
+}
+
+TEST(BMP280LinuxBus, BacksOffWhenIoErrorsRise)
+{
+    fake.max_stable_hz = 20000000;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_linux_spi_tune(&bus, 0, &cfg));
+
+    /* 2 failed transactions per window of 100 are tolerated */
+    for (int i = 0; i < 500; i++) {
+        fake.fail = (i % 50 == 0);
+        submit_sample(&bus);
+    }
+    CHECK_EQUAL(10000000, bus.clocks[0].speed_hz);
+    CHECK_EQUAL(0, bus.clocks[0].num_backoffs);
+
+    /* 3 failed ioctls of 2 transactions each */
+    fake.fail = true;
+    for (int i = 0; i < 3; i++) {
+        submit_sample(&bus);
+    }
+    CHECK_EQUAL(8000000, bus.clocks[0].speed_hz);
+    CHECK_EQUAL(1, bus.clocks[0].num_backoffs);
+
+    /* Never below the lowest speed */
+    for (int i = 0; i < 100; i++) {
+        submit_sample(&bus);
+    }
+    CHECK_EQUAL(1000000, bus.clocks[0].speed_hz);
+    CHECK_EQUAL(LINUX_BUS_NUM_SPEEDS - 1, bus.clocks[0].num_backoffs);
+}
+
+TEST(BMP280LinuxBus, ReportedErrorsBackOff)
+{
+    /* Not tuned */
+    bmp280_linux_spi_report_errors(&bus, 0, 100);
+    CHECK_EQUAL(0, bus.clocks[0].speed_hz);
+
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_linux_spi_tune(&bus, 0, &cfg));
+    bmp280_linux_spi_report_errors(&bus, 0, 4);
+    CHECK_EQUAL(4000000, bus.clocks[0].speed_hz);
+    bmp280_linux_spi_report_errors(&bus, 0, 1);
+    CHECK_EQUAL(2000000, bus.clocks[0].speed_hz);
+    bmp280_linux_spi_report_errors(&bus, 1, 100);
+}
@@ -0,0 +1,145 @@
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280_stats.h"
+#include "bmp280_linux_metrics_http.h"
+
+static BMP280BusStats http_bus_stats;
+static BMP280BusSnapshot http_bus_snapshot;
+
+// clang-format off
+TEST_GROUP(BMP280LinuxMetricsHttp){
+    void setup() {
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_stats_bus_init(&http_bus_stats, 3));
+    }
+};
+// clang-format on
+
+TEST(BMP280LinuxMetricsHttp, ServesMetrics)
+{
+    BMP280StatsRegistry reg = {NULL, 0, &http_bus_stats, 1, NULL, &http_bus_snapshot};
+    int listen_fd = bmp280_linux_metrics_http_listen(0, 2000);
+    CHECK(listen_fd >= 0);
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    CHECK_EQUAL(0, getsockname(listen_fd, (struct sockaddr *)&addr, &addr_len));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    std::vector<uint8_t> serve_rcs;
+    std::thread exporter([&]() {
+        serve_rcs.push_back(bmp280_linux_metrics_http_serve_one(listen_fd, &reg));
+        serve_rcs.push_back(bmp280_linux_metrics_http_serve_one(listen_fd, &reg));
+    });
+
+    const char *requests[2] = {"GET /metrics HTTP/1.1\r\nHost: x\r\n\r\n", "GET / HTTP/1.1\r\nHost: x\r\n\r\n"};
+    std::string responses[2];
+    for (size_t i = 0; i < 2; i++) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        CHECK_EQUAL(0, connect(fd, (struct sockaddr *)&addr, sizeof(addr)));
+        CHECK_EQUAL((ssize_t)strlen(requests[i]), send(fd, requests[i], strlen(requests[i]), 0));
+        char buf[4096];
+        ssize_t num;
+        while ((num = recv(fd, buf, sizeof(buf), 0)) > 0) {
+            responses[i].append(buf, (size_t)num);
+        }
+        close(fd);
+    }
+    exporter.join();
+    close(listen_fd);
+
+    CHECK_EQUAL(2, serve_rcs.size());
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, serve_rcs[0]);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, serve_rcs[1]);
+    CHECK(responses[0].rfind("HTTP/1.1 200 OK\r\n", 0) == 0);
+    CHECK(responses[0].find("application/openmetrics-text") != std::string::npos);
+    CHECK(responses[0].find("bmp280_bus_transactions_total{bus=\"3\"} 0\n") != std::string::npos);
+    CHECK(responses[0].size() > 6 && responses[0].compare(responses[0].size() - 6, 6, "# EOF\n") == 0);
+    CHECK(responses[1].rfind("HTTP/1.1 404 Not Found\r\n", 0) == 0);
+}
+
+TEST(BMP280LinuxMetricsHttp, SilentClientDoesNotStallExporter)
+{
+    BMP280StatsRegistry reg = {NULL, 0, &http_bus_stats, 1, NULL, &http_bus_snapshot};
+    int listen_fd = bmp280_linux_metrics_http_listen(0, 100);
+    CHECK(listen_fd >= 0);
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    CHECK_EQUAL(0, getsockname(listen_fd, (struct sockaddr *)&addr, &addr_len));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    /* Connects first and never sends a request */
+    int silent_fd = socket(AF_INET, SOCK_STREAM, 0);
+    CHECK_EQUAL(0, connect(silent_fd, (struct sockaddr *)&addr, sizeof(addr)));
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    CHECK_EQUAL(0, connect(fd, (struct sockaddr *)&addr, sizeof(addr)));
+    const char *request = "GET /metrics HTTP/1.1\r\nHost: x\r\n\r\n";
+    CHECK_EQUAL((ssize_t)strlen(request), send(fd, request, strlen(request), 0));
+
+    std::vector<uint8_t> serve_rcs;
+    std::thread exporter([&]() {
+        for (size_t i = 0; i < 3; i++) {
+            serve_rcs.push_back(bmp280_linux_metrics_http_serve_one(listen_fd, &reg));
+        }
+    });
+    std::string response;
+    char buf[4096];
+    ssize_t num;
+    while ((num = recv(fd, buf, sizeof(buf), 0)) > 0) {
+        response.append(buf, (size_t)num);
+    }
+    close(fd);
+    exporter.join();
+    close(silent_fd);
+    close(listen_fd);
+
+    /* The silent client times out, the next one is served, and accept times out without clients */
+    CHECK_EQUAL(3, serve_rcs.size());
+    CHECK_EQUAL(BMP280_RESULT_CODE_IO_ERR, serve_rcs[0]);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, serve_rcs[1]);
+    CHECK_EQUAL(BMP280_RESULT_CODE_IO_ERR, serve_rcs[2]);
+    CHECK(response.rfind("HTTP/1.1 200 OK\r\n", 0) == 0);
+}
+
+TEST(BMP280LinuxMetricsHttp, TricklingClientIsCutOffAtRequestDeadline)
+{
+    BMP280StatsRegistry reg = {NULL, 0, &http_bus_stats, 1, NULL, &http_bus_snapshot};
+    int listen_fd = bmp280_linux_metrics_http_listen(0, 200);
+    CHECK(listen_fd >= 0);
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    CHECK_EQUAL(0, getsockname(listen_fd, (struct sockaddr *)&addr, &addr_len));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    uint8_t serve_rc = BMP280_RESULT_CODE_OK;
+    std::chrono::steady_clock::time_point served;
+    std::thread exporter([&]() {
+        serve_rc = bmp280_linux_metrics_http_serve_one(listen_fd, &reg);
+        served = std::chrono::steady_clock::now();
+    });
+
+    /* Every byte arrives well within the timeout of one recv, but the request never completes */
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    CHECK_EQUAL(0, connect(fd, (struct sockaddr *)&addr, sizeof(addr)));
+    std::chrono::steady_clock::time_point connected = std::chrono::steady_clock::now();
+    const char *request = "GET /metrics HTTP/1.1\r\nHost: x\r\n";
+    for (size_t i = 0; i < strlen(request) && std::chrono::steady_clock::now() - connected < std::chrono::seconds(2);
+         i++) {
+        send(fd, &request[i], 1, MSG_NOSIGNAL);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    exporter.join();
+    close(fd);
+    close(listen_fd);
+
+    CHECK_EQUAL(BMP280_RESULT_CODE_IO_ERR, serve_rc);
+    CHECK(served - connected < std::chrono::milliseconds(1000));
+}
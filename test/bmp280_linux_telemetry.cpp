@@ -0,0 +1,92 @@
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280_telemetry.h"
+#include "bmp280_linux_telemetry.h"
+
+static BMP280TelemetryEncoder enc;
+
+// clang-format off
+TEST_GROUP(BMP280LinuxTelemetry){
+    void setup() {
+        uint8_t rc = bmp280_telemetry_encoder_init(&enc, 7, 100);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    }
+};
+// clang-format on
+
+#define LOOPBACK_NUM_SENSORS 200
+#define LOOPBACK_SAMPLES_PER_SENSOR 500
+
+static BMP280TelemetrySensorRing loopback_rings[256];
+static BMP280TelemetrySample loopback_samples[256 * 4];
+static BMP280LinuxTelemetryRecvBufs recv_bufs;
+
+/**
+ * @brief Send samples of LOOPBACK_NUM_SENSORS sensors from @p tx_fd and collect them from @p rx_fd on one thread.
+ *
+ * Receiving after every sent frame keeps the socket buffer from overflowing, so no frame may be lost.
+ */
+static void run_loopback(int tx_fd, int rx_fd)
+{
+    CHECK(tx_fd >= 0);
+    CHECK(rx_fd >= 0);
+    BMP280TelemetryCollector loopback_coll;
+    uint8_t rc = bmp280_telemetry_collector_init(&loopback_coll, loopback_rings, 256, loopback_samples, 4);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+
+    for (uint32_t t = 0; t < LOOPBACK_SAMPLES_PER_SENSOR; t++) {
+        for (uint32_t s = 0; s < LOOPBACK_NUM_SENSORS; s++) {
+            BMP280Meas meas = {.temperature = 2500 + (int32_t)((s + t) % 7), .pressure = 25767233 + 64 * (t % 5)};
+            size_t records_before = bmp280_telemetry_encoder_num_records(&enc);
+            rc = bmp280_linux_telemetry_add(tx_fd, &enc, 0x10000 + s, 1000 * t + s, &meas);
+            CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+            if (bmp280_telemetry_encoder_num_records(&enc) < records_before) {
+                bmp280_linux_telemetry_receive(rx_fd, &loopback_coll, &recv_bufs);
+            }
+        }
+    }
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_linux_telemetry_send(tx_fd, &enc));
+    bmp280_linux_telemetry_receive(rx_fd, &loopback_coll, &recv_bufs);
+
+    const uint64_t num_samples = (uint64_t)LOOPBACK_NUM_SENSORS * LOOPBACK_SAMPLES_PER_SENSOR;
+    CHECK_EQUAL(num_samples, loopback_coll.num_samples);
+    CHECK_EQUAL(LOOPBACK_NUM_SENSORS, loopback_coll.num_sensors);
+    CHECK_EQUAL(0, loopback_coll.num_lost_frames);
+    CHECK_EQUAL(0, loopback_coll.num_bad_frames);
+    BMP280TelemetrySample sample;
+    const BMP280TelemetrySensorRing *ring = bmp280_telemetry_collector_find(&loopback_coll, 0x10000 + 3);
+    CHECK(ring != NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_telemetry_ring_get(&loopback_coll, ring, 0, &sample));
+    CHECK_EQUAL(1000 * (LOOPBACK_SAMPLES_PER_SENSOR - 1) + 3, sample.timestamp_ms);
+
+    close(tx_fd);
+    close(rx_fd);
+}
+
+TEST(BMP280LinuxTelemetry, UnixDomainSocketLoopback)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/bmp280_telemetry_test_%d.sock", (int)getpid());
+    int rx_fd = bmp280_linux_telemetry_uds_collector_open(path);
+    int tx_fd = bmp280_linux_telemetry_uds_sender_open(path);
+    run_loopback(tx_fd, rx_fd);
+    unlink(path);
+}
+
+TEST(BMP280LinuxTelemetry, UdpLoopback)
+{
+    /* Port 0 lets the kernel pick a free port */
+    int rx_fd = bmp280_linux_telemetry_udp_collector_open(0);
+    CHECK(rx_fd >= 0);
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    CHECK_EQUAL(0, getsockname(rx_fd, (struct sockaddr *)&addr, &addr_len));
+    int tx_fd = bmp280_linux_telemetry_udp_sender_open("127.0.0.1", ntohs(addr.sin_port));
+    run_loopback(tx_fd, rx_fd);
+}
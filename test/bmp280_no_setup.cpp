@@ -36,6 +36,7 @@ static void populate_default_init_cfg(BMP280InitCfg *const cfg)
     cfg->write_reg_user_data = write_reg_user_data;
     cfg->start_timer = mock_bmp280_start_timer;
     cfg->start_timer_user_data = start_timer_user_data;
+    cfg->lazy_init_meas = false;
 }
 
 TEST(BMP280NoSetup, CreateReturnsBufReturnedFromGetInstBuf)
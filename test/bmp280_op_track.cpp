@@ -0,0 +1,152 @@
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280_op_track.h"
+
+static BMP280OpTrack track;
+
+/* Callback of operation a or b: user_data points to its number of calls */
+static size_t num_a_cb_calls;
+static size_t num_b_cb_calls;
+static uint8_t last_cb_rc;
+
+static void op_cb(uint8_t rc, void *user_data)
+{
+    (*(size_t *)user_data)++;
+    last_cb_rc = rc;
+}
+
+// clang-format off
+TEST_GROUP(BMP280OpTrack){
+    void setup() {
+        memset(&track, 0, sizeof(track));
+        num_a_cb_calls = 0;
+        num_b_cb_calls = 0;
+        last_cb_rc = 0xFF;
+    }
+};
+// clang-format on
+
+/** Complete the operation in progress as the driver would, and return its start value. */
+static uint64_t complete(uint8_t rc, uint64_t now)
+{
+    uint64_t start = bmp280_op_track_complete(&track, rc, now);
+    bmp280_op_track_execute_cb(&track, rc);
+    return start;
+}
+
+TEST(BMP280OpTrack, CompletesAcceptedOperation)
+{
+    bmp280_op_track_prepare(&track, op_cb, &num_a_cb_calls, false, 100);
+    bmp280_op_track_submitted(&track, BMP280_RESULT_CODE_OK);
+    CHECK_EQUAL(100, complete(BMP280_RESULT_CODE_IO_ERR, 250));
+    CHECK_EQUAL(1, num_a_cb_calls);
+    CHECK_EQUAL(BMP280_RESULT_CODE_IO_ERR, last_cb_rc);
+}
+
+TEST(BMP280OpTrack, RejectedSubmissionKeepsCallbackOfOperationInProgress)
+{
+    bmp280_op_track_prepare(&track, op_cb, &num_a_cb_calls, false, 100);
+    bmp280_op_track_submitted(&track, BMP280_RESULT_CODE_OK);
+    bmp280_op_track_prepare(&track, op_cb, &num_b_cb_calls, false, 150);
+    bmp280_op_track_submitted(&track, BMP280_RESULT_CODE_BUSY);
+
+    CHECK_EQUAL(100, complete(BMP280_RESULT_CODE_OK, 250));
+    CHECK_EQUAL(1, num_a_cb_calls);
+    CHECK_EQUAL(0, num_b_cb_calls);
+}
+
+TEST(BMP280OpTrack, RejectedSubmissionIsNotInProgress)
+{
+    bmp280_op_track_prepare(&track, op_cb, &num_a_cb_calls, false, 100);
+    bmp280_op_track_submitted(&track, BMP280_RESULT_CODE_INVAL_ARG);
+    bmp280_op_track_prepare(&track, op_cb, &num_b_cb_calls, false, 150);
+    bmp280_op_track_submitted(&track, BMP280_RESULT_CODE_OK);
+
+    CHECK_EQUAL(150, complete(BMP280_RESULT_CODE_OK, 250));
+    CHECK_EQUAL(0, num_a_cb_calls);
+    CHECK_EQUAL(1, num_b_cb_calls);
+}
+
+TEST(BMP280OpTrack, CompletionFromWithinDriverFunction)
+{
+    bmp280_op_track_prepare(&track, op_cb, &num_a_cb_calls, false, 100);
+    CHECK_EQUAL(100, complete(BMP280_RESULT_CODE_OK, 100));
+    bmp280_op_track_submitted(&track, BMP280_RESULT_CODE_OK);
+    CHECK_EQUAL(1, num_a_cb_calls);
+
+    /* The completed operation is not in progress anymore, so the next one is accepted */
+    bmp280_op_track_prepare(&track, op_cb, &num_b_cb_calls, false, 200);
+    bmp280_op_track_submitted(&track, BMP280_RESULT_CODE_OK);
+    CHECK_EQUAL(200, complete(BMP280_RESULT_CODE_OK, 300));
+    CHECK_EQUAL(1, num_b_cb_calls);
+}
+
+TEST(BMP280OpTrack, ContinuousSessionKeepsCallbackUntilItEnds)
+{
+    bmp280_op_track_prepare(&track, op_cb, &num_a_cb_calls, true, 100);
+    bmp280_op_track_submitted(&track, BMP280_RESULT_CODE_OK);
+    CHECK_EQUAL(100, complete(BMP280_RESULT_CODE_OK, 200));
+
+    /* Between two samples, the driver rejects other operations */
+    bmp280_op_track_prepare(&track, op_cb, &num_b_cb_calls, false, 250);
+    bmp280_op_track_submitted(&track, BMP280_RESULT_CODE_BUSY);
+    /* Every sample starts when the previous one completed */
+    CHECK_EQUAL(200, complete(BMP280_RESULT_CODE_OK, 300));
+    CHECK_EQUAL(2, num_a_cb_calls);
+    CHECK_EQUAL(0, num_b_cb_calls);
+
+    /* The session ends with its first error */
+    CHECK_EQUAL(300, complete(BMP280_RESULT_CODE_IO_ERR, 400));
+    CHECK_EQUAL(3, num_a_cb_calls);
+    bmp280_op_track_prepare(&track, op_cb, &num_b_cb_calls, false, 450);
+    bmp280_op_track_submitted(&track, BMP280_RESULT_CODE_OK);
+    CHECK_EQUAL(450, complete(BMP280_RESULT_CODE_OK, 500));
+    CHECK_EQUAL(3, num_a_cb_calls);
+    CHECK_EQUAL(1, num_b_cb_calls);
+}
+
+/** Callback of operation a that submits operation b. */
+static void submitting_cb(uint8_t rc, void *user_data)
+{
+    op_cb(rc, user_data);
+    bmp280_op_track_prepare(&track, op_cb, &num_b_cb_calls, false, 200);
+    bmp280_op_track_submitted(&track, BMP280_RESULT_CODE_OK);
+}
+
+TEST(BMP280OpTrack, CallbackCanSubmitNextOperation)
+{
+    bmp280_op_track_prepare(&track, submitting_cb, &num_a_cb_calls, false, 100);
+    bmp280_op_track_submitted(&track, BMP280_RESULT_CODE_OK);
+    CHECK_EQUAL(100, complete(BMP280_RESULT_CODE_OK, 200));
+    CHECK_EQUAL(1, num_a_cb_calls);
+    CHECK_EQUAL(0, num_b_cb_calls);
+
+    CHECK_EQUAL(200, complete(BMP280_RESULT_CODE_OK, 300));
+    CHECK_EQUAL(1, num_a_cb_calls);
+    CHECK_EQUAL(1, num_b_cb_calls);
+}
+
+TEST(BMP280OpTrack, NullCallback)
+{
+    bmp280_op_track_prepare(&track, NULL, NULL, false, 100);
+    bmp280_op_track_submitted(&track, BMP280_RESULT_CODE_OK);
+    CHECK_EQUAL(100, complete(BMP280_RESULT_CODE_OK, 200));
+}
+
+TEST(BMP280OpTrack, StopCompleteEndsSession)
+{
+    bmp280_op_track_prepare(&track, op_cb, &num_a_cb_calls, true, 100);
+    bmp280_op_track_submitted(&track, BMP280_RESULT_CODE_OK);
+    track.stop_cb = op_cb;
+    track.stop_cb_user_data = &num_b_cb_calls;
+    bmp280_op_track_stop_complete_cb(BMP280_RESULT_CODE_OK, (void *)&track);
+    CHECK_EQUAL(1, num_b_cb_calls);
+
+    bmp280_op_track_prepare(&track, op_cb, &num_b_cb_calls, false, 200);
+    bmp280_op_track_submitted(&track, BMP280_RESULT_CODE_OK);
+    CHECK_EQUAL(200, complete(BMP280_RESULT_CODE_OK, 300));
+    CHECK_EQUAL(2, num_b_cb_calls);
+    CHECK_EQUAL(0, num_a_cb_calls);
+}
@@ -0,0 +1,360 @@
+#include <string.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280_pipeline.h"
+
+#define PIPELINE_NUM_BLOCKS 4
+#define PIPELINE_BLOCK_CAPACITY 16
+
+static BMP280Block blocks[PIPELINE_NUM_BLOCKS];
+static uint32_t block_timestamps_ms[PIPELINE_NUM_BLOCKS * PIPELINE_BLOCK_CAPACITY];
+static uint32_t block_sensor_ids[PIPELINE_NUM_BLOCKS * PIPELINE_BLOCK_CAPACITY];
+static int32_t block_temperatures[PIPELINE_NUM_BLOCKS * PIPELINE_BLOCK_CAPACITY];
+static uint32_t block_pressures[PIPELINE_NUM_BLOCKS * PIPELINE_BLOCK_CAPACITY];
+
+/* Stage that records the blocks it sees, and optionally keeps a reference to the last one */
+typedef struct {
+    BMP280PipelineStage stage;
+    std::vector<BMP280Block *> *seen;
+    std::vector<uint32_t> *pressures;
+    bool retain;
+    BMP280Block *retained;
+} RecorderStage;
+
+static void recorder_process(BMP280PipelineStage *stage, BMP280Block *block)
+{
+    RecorderStage *r = (RecorderStage *)stage;
+    r->seen->push_back(block);
+    for (size_t i = 0; i < block->num; i++) {
+        r->pressures->push_back(block->pressures[i]);
+    }
+    if (r->retain) {
+        bmp280_block_ref(block);
+        r->retained = block;
+    }
+    bmp280_pipeline_emit(stage, block);
+}
+
+static void fill_block(BMP280Block *block, size_t num, uint32_t first_pres)
+{
+    for (size_t i = 0; i < num; i++) {
+        BMP280Meas meas = {2508 + (int32_t)i, first_pres + (uint32_t)i};
+        CHECK_TRUE(bmp280_block_append(block, (uint32_t)(i % 3), 1000 * (uint32_t)i, &meas));
+    }
+}
+
+static void count_records(uint32_t sensor_id, uint32_t timestamp_ms, const BMP280Meas *meas, void *user_data)
+{
+    (void)sensor_id;
+    (void)timestamp_ms;
+    (void)meas;
+    (*(size_t *)user_data)++;
+}
+
+static void decode_frame(const uint8_t *frame, size_t len, void *user_data)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_telemetry_decode(frame, len, NULL, count_records, user_data));
+}
+
+// clang-format off
+TEST_GROUP(BMP280Pipeline)
+{
+    BMP280BlockPool pool;
+    std::vector<BMP280Block *> seen_a;
+    std::vector<BMP280Block *> seen_b;
+    std::vector<uint32_t> pressures_a;
+    std::vector<uint32_t> pressures_b;
+    RecorderStage rec_a;
+    RecorderStage rec_b;
+
+    void setup()
+    {
+        BMP280BlockPoolArrays arrays = {
+            blocks, block_timestamps_ms, block_sensor_ids, block_temperatures, block_pressures,
+            PIPELINE_NUM_BLOCKS, PIPELINE_BLOCK_CAPACITY,
+        };
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_block_pool_init(&pool, &arrays));
+        init_recorder(&rec_a, &seen_a, &pressures_a);
+        init_recorder(&rec_b, &seen_b, &pressures_b);
+    }
+
+    void init_recorder(RecorderStage *r, std::vector<BMP280Block *> *seen, std::vector<uint32_t> *pressures)
+    {
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_pipeline_stage_init(&r->stage, recorder_process));
+        r->seen = seen;
+        r->pressures = pressures;
+        r->retain = false;
+        r->retained = NULL;
+    }
+};
+// clang-format on
+
+TEST(BMP280Pipeline, PoolInitFailsForZeroCapacity)
+{
+    BMP280BlockPoolArrays arrays = {
+        blocks, block_timestamps_ms, block_sensor_ids, block_temperatures, block_pressures, PIPELINE_NUM_BLOCKS, 0,
+    };
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_block_pool_init(&pool, &arrays));
+}
+
+TEST(BMP280Pipeline, AllocFailsWhenPoolEmptyAndUnrefRecyclesBlock)
+{
+    BMP280Block *taken[PIPELINE_NUM_BLOCKS];
+    for (size_t i = 0; i < PIPELINE_NUM_BLOCKS; i++) {
+        taken[i] = bmp280_block_alloc(&pool);
+        CHECK(taken[i] != NULL);
+        CHECK_EQUAL(1, taken[i]->refcount);
+    }
+    POINTERS_EQUAL(NULL, bmp280_block_alloc(&pool));
+    CHECK_EQUAL(1, pool.num_alloc_failures);
+
+    fill_block(taken[2], 3, 0);
+    bmp280_block_unref(taken[2]);
+    CHECK_EQUAL(1, pool.num_free);
+    BMP280Block *again = bmp280_block_alloc(&pool);
+    POINTERS_EQUAL(taken[2], again);
+    CHECK_EQUAL(0, again->num);
+}
+
+TEST(BMP280Pipeline, BlockStaysAllocatedUntilLastReferenceIsDropped)
+{
+    BMP280Block *block = bmp280_block_alloc(&pool);
+    bmp280_block_ref(block);
+    bmp280_block_unref(block);
+    CHECK_EQUAL(PIPELINE_NUM_BLOCKS - 1, pool.num_free);
+    bmp280_block_unref(block);
+    CHECK_EQUAL(PIPELINE_NUM_BLOCKS, pool.num_free);
+}
+
+TEST(BMP280Pipeline, AppendFailsWhenBlockFull)
+{
+    BMP280Block *block = bmp280_block_alloc(&pool);
+    fill_block(block, PIPELINE_BLOCK_CAPACITY, 0);
+    BMP280Meas meas = {0, 0};
+    CHECK_FALSE(bmp280_block_append(block, 0, 0, &meas));
+    bmp280_block_unref(block);
+}
+
+TEST(BMP280Pipeline, ConnectFailsBeyondMaxOutputs)
+{
+    for (size_t i = 0; i < BMP280_PIPELINE_MAX_OUTPUTS; i++) {
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_pipeline_connect(&rec_a.stage, &rec_b.stage));
+    }
+    CHECK_EQUAL(BMP280_RESULT_CODE_NO_MEM, bmp280_pipeline_connect(&rec_a.stage, &rec_b.stage));
+}
+
+TEST(BMP280Pipeline, FanOutPassesSameBlockToEveryConsumer)
+{
+    BMP280PipelineStats stats;
+    bmp280_pipeline_stats_init(&stats);
+    bmp280_pipeline_connect(&stats.stage, &rec_a.stage);
+    bmp280_pipeline_connect(&stats.stage, &rec_b.stage);
+
+    BMP280Block *block = bmp280_block_alloc(&pool);
+    fill_block(block, 5, 100);
+    bmp280_pipeline_push(&stats.stage, block);
+    bmp280_block_unref(block);
+
+    CHECK_EQUAL(1, seen_a.size());
+    CHECK_EQUAL(1, seen_b.size());
+    POINTERS_EQUAL(block, seen_a[0]);
+    POINTERS_EQUAL(block, seen_b[0]);
+    CHECK_EQUAL(PIPELINE_NUM_BLOCKS, pool.num_free);
+}
+
+TEST(BMP280Pipeline, RetainingConsumerKeepsBlockAlive)
+{
+    rec_a.retain = true;
+    BMP280Block *block = bmp280_block_alloc(&pool);
+    fill_block(block, 5, 100);
+    bmp280_pipeline_push(&rec_a.stage, block);
+    bmp280_block_unref(block);
+    CHECK_EQUAL(PIPELINE_NUM_BLOCKS - 1, pool.num_free);
+    CHECK_EQUAL(104, rec_a.retained->pressures[4]);
+    bmp280_block_unref(rec_a.retained);
+    CHECK_EQUAL(PIPELINE_NUM_BLOCKS, pool.num_free);
+}
+
+TEST(BMP280Pipeline, FilterPassesBlockWithoutCopyIfAllSamplesPass)
+{
+    BMP280PipelineFilter filter;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_pipeline_filter_init(&filter, &pool));
+    filter.pres_min = 100;
+    bmp280_pipeline_connect(&filter.stage, &rec_a.stage);
+
+    BMP280Block *block = bmp280_block_alloc(&pool);
+    fill_block(block, 5, 100);
+    bmp280_pipeline_push(&filter.stage, block);
+    bmp280_block_unref(block);
+
+    CHECK_EQUAL(1, seen_a.size());
+    POINTERS_EQUAL(block, seen_a[0]);
+    CHECK_EQUAL(0, filter.num_dropped);
+}
+
+TEST(BMP280Pipeline, FilterEmitsNewBlockWithPassingSamples)
+{
+    BMP280PipelineFilter filter;
+    bmp280_pipeline_filter_init(&filter, &pool);
+    filter.pres_min = 102;
+    filter.pres_max = 103;
+    bmp280_pipeline_connect(&filter.stage, &rec_a.stage);
+
+    BMP280Block *block = bmp280_block_alloc(&pool);
+    fill_block(block, 5, 100);
+    bmp280_pipeline_push(&filter.stage, block);
+    bmp280_block_unref(block);
+
+    CHECK_EQUAL(1, seen_a.size());
+    CHECK(seen_a[0] != block);
+    CHECK_EQUAL(2, pressures_a.size());
+    CHECK_EQUAL(102, pressures_a[0]);
+    CHECK_EQUAL(103, pressures_a[1]);
+    CHECK_EQUAL(3, filter.num_dropped);
+    /* The filter dropped its reference to its output block */
+    CHECK_EQUAL(PIPELINE_NUM_BLOCKS, pool.num_free);
+}
+
+TEST(BMP280Pipeline, FilterDropsSamplesWhenPoolEmpty)
+{
+    BMP280PipelineFilter filter;
+    bmp280_pipeline_filter_init(&filter, &pool);
+    filter.pres_min = 102;
+    bmp280_pipeline_connect(&filter.stage, &rec_a.stage);
+
+    BMP280Block *taken[PIPELINE_NUM_BLOCKS];
+    for (size_t i = 0; i < PIPELINE_NUM_BLOCKS; i++) {
+        taken[i] = bmp280_block_alloc(&pool);
+    }
+    fill_block(taken[0], 5, 100);
+    bmp280_pipeline_push(&filter.stage, taken[0]);
+    CHECK_EQUAL(0, seen_a.size());
+    CHECK_EQUAL(5, filter.num_dropped);
+    for (size_t i = 0; i < PIPELINE_NUM_BLOCKS; i++) {
+        bmp280_block_unref(taken[i]);
+    }
+}
+
+TEST(BMP280Pipeline, StatsAggregateAcrossBlocks)
+{
+    BMP280PipelineStats stats;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_pipeline_stats_init(&stats));
+    for (int b = 0; b < 2; b++) {
+        BMP280Block *block = bmp280_block_alloc(&pool);
+        fill_block(block, 4, 100 + 10 * (uint32_t)b);
+        bmp280_pipeline_push(&stats.stage, block);
+        bmp280_block_unref(block);
+    }
+    CHECK_EQUAL(8, stats.num_samples);
+    CHECK_EQUAL(2508, stats.temp_min);
+    CHECK_EQUAL(2511, stats.temp_max);
+    CHECK_EQUAL(100, stats.pres_min);
+    CHECK_EQUAL(113, stats.pres_max);
+    CHECK_EQUAL(2 * (2508 + 2509 + 2510 + 2511), stats.temp_sum);
+    CHECK_EQUAL(100 + 101 + 102 + 103 + 110 + 111 + 112 + 113, stats.pres_sum);
+}
+
+TEST(BMP280Pipeline, TelemetrySinkEncodesEverySample)
+{
+    BMP280TelemetryEncoder enc;
+    bmp280_telemetry_encoder_init(&enc, 1, 0);
+    size_t num_decoded = 0;
+    BMP280PipelineTelemetrySink sink;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_pipeline_telemetry_sink_init(&sink, &enc, decode_frame, &num_decoded));
+
+    /* Enough samples for several frames */
+    for (int b = 0; b < 200; b++) {
+        BMP280Block *block = bmp280_block_alloc(&pool);
+        fill_block(block, PIPELINE_BLOCK_CAPACITY, 25767233 + 1000 * (uint32_t)b);
+        bmp280_pipeline_push(&sink.stage, block);
+        bmp280_block_unref(block);
+    }
+    bmp280_pipeline_telemetry_sink_flush(&sink);
+    CHECK_EQUAL(200 * PIPELINE_BLOCK_CAPACITY, num_decoded);
+}
+
+#define PIPELINE_FANOUT_BLOCK_CAPACITY 1024
+#define PIPELINE_FANOUT_NUM_BLOCKS 8
+#define PIPELINE_FANOUT_NUM_SAMPLES (1u << 16)
+
+/* Reference: every consumer gets its own copy of the samples, as with hand-wired stages that copy BMP280Meas arrays */
+static void copying_consumer(const BMP280Meas *meas, size_t num, BMP280PipelineStats *stats)
+{
+    BMP280Meas *copy = (BMP280Meas *)malloc(num * sizeof(BMP280Meas));
+    memcpy(copy, meas, num * sizeof(BMP280Meas));
+    for (size_t i = 0; i < num; i++) {
+        stats->temp_min = (copy[i].temperature < stats->temp_min) ? copy[i].temperature : stats->temp_min;
+        stats->temp_max = (copy[i].temperature > stats->temp_max) ? copy[i].temperature : stats->temp_max;
+        stats->temp_sum += copy[i].temperature;
+        stats->pres_min = (copy[i].pressure < stats->pres_min) ? copy[i].pressure : stats->pres_min;
+        stats->pres_max = (copy[i].pressure > stats->pres_max) ? copy[i].pressure : stats->pres_max;
+        stats->pres_sum += copy[i].pressure;
+    }
+    stats->num_samples += num;
+    free(copy);
+}
+
+static void pass_through_process(BMP280PipelineStage *stage, BMP280Block *block)
+{
+    bmp280_pipeline_emit(stage, block);
+}
+
+TEST(BMP280Pipeline, FanOutMatchesCopies)
+{
+    std::vector<BMP280Block> fanout_blocks(PIPELINE_FANOUT_NUM_BLOCKS);
+    size_t n = PIPELINE_FANOUT_NUM_BLOCKS * PIPELINE_FANOUT_BLOCK_CAPACITY;
+    std::vector<uint32_t> ts(n), ids(n), pres(n);
+    std::vector<int32_t> temps(n);
+    BMP280BlockPoolArrays arrays = {
+        fanout_blocks.data(), ts.data(), ids.data(), temps.data(), pres.data(),
+        PIPELINE_FANOUT_NUM_BLOCKS, PIPELINE_FANOUT_BLOCK_CAPACITY,
+    };
+    BMP280BlockPool fanout_pool;
+    bmp280_block_pool_init(&fanout_pool, &arrays);
+
+    /* Source -> four statistics consumers */
+    BMP280PipelineStage source;
+    bmp280_pipeline_stage_init(&source, pass_through_process);
+    BMP280PipelineStats consumers[4];
+    for (size_t i = 0; i < 4; i++) {
+        bmp280_pipeline_stats_init(&consumers[i]);
+        bmp280_pipeline_connect(&source, &consumers[i].stage);
+    }
+
+    for (size_t s = 0; s < PIPELINE_FANOUT_NUM_SAMPLES; s += PIPELINE_FANOUT_BLOCK_CAPACITY) {
+        BMP280Block *block = bmp280_block_alloc(&fanout_pool);
+        /* Same samples as the copies below */
+        for (size_t i = 0; i < PIPELINE_FANOUT_BLOCK_CAPACITY; i++) {
+            block->temperatures[i] = 2508 + (int32_t)(i & 63);
+            block->pressures[i] = 25767233 + (uint32_t)(s + i);
+        }
+        block->num = PIPELINE_FANOUT_BLOCK_CAPACITY;
+        bmp280_pipeline_push(&source, block);
+        bmp280_block_unref(block);
+    }
+
+    BMP280PipelineStats copy_consumers[4];
+    std::vector<BMP280Meas> meas(PIPELINE_FANOUT_BLOCK_CAPACITY);
+    for (size_t i = 0; i < 4; i++) {
+        bmp280_pipeline_stats_init(&copy_consumers[i]);
+    }
+    for (size_t s = 0; s < PIPELINE_FANOUT_NUM_SAMPLES; s += PIPELINE_FANOUT_BLOCK_CAPACITY) {
+        for (size_t i = 0; i < PIPELINE_FANOUT_BLOCK_CAPACITY; i++) {
+            meas[i].temperature = 2508 + (int32_t)(i & 63);
+            meas[i].pressure = 25767233 + (uint32_t)(s + i);
+        }
+        for (size_t i = 0; i < 4; i++) {
+            copying_consumer(meas.data(), PIPELINE_FANOUT_BLOCK_CAPACITY, &copy_consumers[i]);
+        }
+    }
+
+    for (size_t i = 0; i < 4; i++) {
+        CHECK_EQUAL(PIPELINE_FANOUT_NUM_SAMPLES, consumers[i].num_samples);
+        CHECK_EQUAL(copy_consumers[i].pres_sum, consumers[i].pres_sum);
+        CHECK_EQUAL(copy_consumers[i].temp_sum, consumers[i].temp_sum);
+    }
+    CHECK_EQUAL(PIPELINE_FANOUT_NUM_BLOCKS, fanout_pool.num_free);
+}
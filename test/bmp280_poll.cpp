@@ -0,0 +1,184 @@
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280.h"
+#include "bmp280_poll.h"
+#include "sim_fixture.h"
+
+static BMP280 bmp280;
+static BMP280PollDev dev;
+/** Register file of the fake device that the blocking backend of the tests reads and writes. */
+static uint8_t regs[256];
+/** Time at which the backend performed the last data register read. */
+static uint32_t data_read_ms;
+/** Time at which the backend performed the last ctrl_meas write. */
+static uint32_t ctrl_meas_write_ms;
+
+// clang-format off
+TEST_GROUP(BMP280Poll){
+    void setup() {
+        memset(regs, 0, sizeof(regs));
+        sim_fixture_reset_inst_bufs();
+        memcpy(&regs[0x88], sim_fixture_calib_data, sizeof(sim_fixture_calib_data));
+        memcpy(&regs[0xF7], sim_fixture_data_regs, sizeof(sim_fixture_data_regs));
+        /* Temperature and pressure oversampling x1, sleep mode */
+        regs[0xF4] = 0x24;
+        data_read_ms = 0;
+        ctrl_meas_write_ms = 0;
+
+        uint8_t rc = bmp280_poll_dev_init(&dev, 0);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+        BMP280InitCfg cfg = {
+            .get_inst_buf = sim_fixture_get_inst_buf,
+            .get_inst_buf_user_data = NULL,
+            .read_regs = bmp280_poll_read_regs,
+            .read_regs_user_data = (void *)&dev,
+            .write_reg = bmp280_poll_write_reg,
+            .write_reg_user_data = (void *)&dev,
+            .start_timer = bmp280_poll_start_timer,
+            .start_timer_user_data = (void *)&dev,
+            .lazy_init_meas = false,
+        };
+        rc = bmp280_create(&bmp280, &cfg);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    }
+};
+// clang-format on
+
+/** Blocking backend: perform the IO request of dev immediately on the fake register file. */
+static void perform_io_request(uint32_t now_ms, uint8_t io_rc)
+{
+    const BMP280PollIORequest *request = bmp280_poll_get_io_request(&dev);
+    CHECK(request != NULL);
+    if (request->is_read) {
+        memcpy(request->data, &regs[request->reg_addr], request->len);
+        if (request->reg_addr == 0xF7) {
+            data_read_ms = now_ms;
+        }
+    } else {
+        regs[request->reg_addr] = request->write_val;
+        if (request->reg_addr == 0xF4) {
+            ctrl_meas_write_ms = now_ms;
+        }
+    }
+    bmp280_poll_io_done(&dev, io_rc);
+}
+
+/**
+ * @brief Superloop: poll every ms starting at @p start_ms, perform IO requests right away, until a result is ready.
+ *
+ * @return uint32_t Time at which the result became ready.
+ */
+static uint32_t run_superloop(uint32_t start_ms)
+{
+    uint32_t now_ms = start_ms;
+    for (uint32_t i = 0; i < 1000; i++, now_ms++) {
+        uint8_t flags;
+        while ((flags = bmp280_poll(&dev, now_ms)) & BMP280_POLL_FLAG_IO_REQUEST) {
+            perform_io_request(now_ms, BMP280_IO_RESULT_CODE_OK);
+        }
+        if (flags & BMP280_POLL_FLAG_RESULT_READY) {
+            return now_ms;
+        }
+    }
+    FAIL_TEST("No result within 1000 ms");
+    return now_ms;
+}
+
+TEST(BMP280Poll, InitNull)
+{
+    uint8_t rc = bmp280_poll_dev_init(NULL, 0);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, rc);
+}
+
+TEST(BMP280Poll, NothingToDoWhenIdle)
+{
+    CHECK_EQUAL(0, bmp280_poll(&dev, 5));
+    POINTERS_EQUAL(NULL, bmp280_poll_get_io_request(&dev));
+}
+
+TEST(BMP280Poll, ForcedModeMeasurementInSuperloop)
+{
+    uint8_t rc = bmp280_init_meas(bmp280, bmp280_poll_complete_cb, (void *)&dev);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    run_superloop(0);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_poll_get_result_rc(&dev));
+
+    BMP280Meas meas;
+    rc = bmp280_read_meas_forced_mode(bmp280, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7, &meas, bmp280_poll_complete_cb,
+                                      (void *)&dev);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    uint32_t ready_ms = run_superloop(10);
+
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_poll_get_result_rc(&dev));
+    CHECK_EQUAL(2508, meas.temperature);
+    CHECK_EQUAL(25767233, meas.pressure);
+    CHECK_EQUAL(0x25, regs[0xF4]);
+    /* Data is read once at least 7 full ms have passed after the forced mode write */
+    CHECK_EQUAL(ctrl_meas_write_ms + 8, data_read_ms);
+    CHECK_EQUAL(data_read_ms, ready_ms);
+}
+
+TEST(BMP280Poll, TimerDeadlineNotReached)
+{
+    BMP280Meas meas;
+    uint8_t rc = bmp280_init_meas(bmp280, bmp280_poll_complete_cb, (void *)&dev);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    run_superloop(0);
+    rc = bmp280_read_meas_forced_mode(bmp280, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7, &meas, bmp280_poll_complete_cb,
+                                      (void *)&dev);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+
+    /* Read ctrl_meas, write ctrl_meas, both at 100 ms */
+    CHECK_EQUAL(BMP280_POLL_FLAG_IO_REQUEST, bmp280_poll(&dev, 100));
+    perform_io_request(100, BMP280_IO_RESULT_CODE_OK);
+    CHECK_EQUAL(BMP280_POLL_FLAG_IO_REQUEST, bmp280_poll(&dev, 100));
+    perform_io_request(100, BMP280_IO_RESULT_CODE_OK);
+    CHECK_EQUAL(BMP280_POLL_FLAG_TIMER_RUNNING, bmp280_poll(&dev, 100));
+    CHECK_EQUAL(BMP280_POLL_FLAG_TIMER_RUNNING, bmp280_poll(&dev, 107));
+    CHECK_EQUAL(BMP280_POLL_FLAG_IO_REQUEST, bmp280_poll(&dev, 108));
+}
+
+TEST(BMP280Poll, TimerDeadlineAcrossMsCounterWraparound)
+{
+    uint8_t rc = bmp280_poll_dev_init(&dev, 0xFFFFFFF0U);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    rc = bmp280_init_meas(bmp280, bmp280_poll_complete_cb, (void *)&dev);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    run_superloop(0xFFFFFFF0U);
+
+    BMP280Meas meas;
+    rc = bmp280_read_meas_forced_mode(bmp280, BMP280_MEAS_TYPE_TEMP_AND_PRES, 20, &meas, bmp280_poll_complete_cb,
+                                      (void *)&dev);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    uint32_t ready_ms = run_superloop(0xFFFFFFF8U);
+
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_poll_get_result_rc(&dev));
+    CHECK_EQUAL(2508, meas.temperature);
+    CHECK_EQUAL(0xFFFFFFF8U, ctrl_meas_write_ms);
+    /* 0xFFFFFFF8 + 21 wraps around to 13 */
+    CHECK_EQUAL(13, data_read_ms);
+    CHECK_EQUAL(13, ready_ms);
+}
+
+TEST(BMP280Poll, IoErrIsReportedAsResult)
+{
+    uint8_t rc = bmp280_init_meas(bmp280, bmp280_poll_complete_cb, (void *)&dev);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+
+    CHECK_EQUAL(BMP280_POLL_FLAG_IO_REQUEST, bmp280_poll(&dev, 1));
+    const BMP280PollIORequest *request = bmp280_poll_get_io_request(&dev);
+    CHECK(request != NULL);
+    CHECK_EQUAL(0x88, request->reg_addr);
+    CHECK_EQUAL(24, request->len);
+    CHECK(request->is_read);
+    /* The backend performs the transaction asynchronously */
+    CHECK_EQUAL(BMP280_POLL_FLAG_IO_IN_PROGRESS, bmp280_poll(&dev, 2));
+    bmp280_poll_io_done(&dev, BMP280_IO_RESULT_CODE_ERR);
+
+    CHECK_EQUAL(BMP280_POLL_FLAG_RESULT_READY, bmp280_poll(&dev, 3));
+    CHECK_EQUAL(BMP280_RESULT_CODE_IO_ERR, bmp280_poll_get_result_rc(&dev));
+    /* Reported only once */
+    CHECK_EQUAL(0, bmp280_poll(&dev, 4));
+}
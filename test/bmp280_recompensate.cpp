@@ -0,0 +1,277 @@
+#include <string.h>
+#include <stdio.h>
+#include <vector>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280_recompensate.h"
+#include "sim_fixture.h"
+
+#define RECOMP_NUM_SENSORS 5
+/* Id that is not in the calibration file */
+#define RECOMP_UNKNOWN_SENSOR_ID 99
+#define RECOMP_NUM_RECORDS 1000
+
+static const char *const calib_path = "/tmp/bmp280_recompensate_test_calib.txt";
+static const char *const archive_path = "/tmp/bmp280_recompensate_test_raw.bin";
+static const char *const columns_path = "/tmp/bmp280_recompensate_test_out.col";
+
+static void put_le(uint8_t *p, uint64_t v, size_t num_bytes)
+{
+    for (size_t i = 0; i < num_bytes; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static void put_raw_val(uint8_t *p, uint32_t raw)
+{
+    p[0] = (uint8_t)(raw >> 12);
+    p[1] = (uint8_t)(raw >> 4);
+    p[2] = (uint8_t)((raw & 0xF) << 4);
+}
+
+/* Calibration values of sensor id: the datasheet example with dig_T1 and dig_P1 varied by the id */
+static void sensor_calib_regs(uint32_t id, uint8_t *regs)
+{
+    memcpy(regs, sim_fixture_calib_data, sizeof(sim_fixture_calib_data));
+    regs[0] = (uint8_t)(regs[0] + 3 * id);
+    regs[6] = (uint8_t)(regs[6] + 5 * id);
+}
+
+static void write_calib_file(void)
+{
+    FILE *f = fopen(calib_path, "w");
+    CHECK(f != NULL);
+    fprintf(f, "# sensor id, registers 0x88...0x9F\n\n");
+    for (uint32_t id = 0; id < RECOMP_NUM_SENSORS; id++) {
+        uint8_t regs[24];
+        sensor_calib_regs(id, regs);
+        /* Sensor ids are sparse, as in a real fleet */
+        fprintf(f, "%u ", 1000 + 7 * id);
+        for (size_t i = 0; i < sizeof(regs); i++) {
+            fprintf(f, "%02x", regs[i]);
+        }
+        fprintf(f, "\n");
+    }
+    fclose(f);
+}
+
+static uint32_t record_sensor_id(size_t i)
+{
+    return (i % (RECOMP_NUM_SENSORS + 1) == RECOMP_NUM_SENSORS) ? RECOMP_UNKNOWN_SENSOR_ID :
+                                                                 1000 + 7 * (uint32_t)(i % (RECOMP_NUM_SENSORS + 1));
+}
+
+static uint32_t record_temp_raw(size_t i)
+{
+    return 519888 + (uint32_t)((i * 37) % 4000);
+}
+
+static uint32_t record_pres_raw(size_t i)
+{
+    return 415148 - (uint32_t)((i * 53) % 4000);
+}
+
+static void write_archive(const uint8_t *header, size_t num_records)
+{
+    FILE *f = fopen(archive_path, "wb");
+    CHECK(f != NULL);
+    fwrite(header, 1, BMP280_RAW_ARCHIVE_HEADER_SIZE, f);
+    for (size_t i = 0; i < num_records; i++) {
+        uint8_t rec[BMP280_RAW_ARCHIVE_RECORD_SIZE] = {0};
+        put_le(&rec[0], 1700000000000ULL + i, 8);
+        put_le(&rec[8], record_sensor_id(i), 4);
+        put_raw_val(&rec[12], record_pres_raw(i));
+        put_raw_val(&rec[15], record_temp_raw(i));
+        fwrite(rec, 1, sizeof(rec), f);
+    }
+    fclose(f);
+}
+
+static const uint8_t valid_archive_header[BMP280_RAW_ARCHIVE_HEADER_SIZE] = {'B', 'R', 'A', 'W', 1, 0, 20, 0};
+
+// clang-format off
+TEST_GROUP(BMP280Recompensate)
+{
+    BMP280RecompCalib calib;
+    BMP280RawArchive archive;
+    BMP280Columns columns;
+
+    void setup()
+    {
+        memset(&calib, 0, sizeof(calib));
+        memset(&archive, 0, sizeof(archive));
+        memset(&columns, 0, sizeof(columns));
+    }
+
+    void teardown()
+    {
+        bmp280_columns_close(&columns);
+        bmp280_raw_archive_close(&archive);
+        if (calib.soa.coeffs) {
+            bmp280_recomp_calib_deinit(&calib);
+        }
+        remove(calib_path);
+        remove(archive_path);
+        remove(columns_path);
+    }
+
+    void check_columns_match_reference()
+    {
+        for (size_t i = 0; i < RECOMP_NUM_RECORDS; i++) {
+            uint32_t id = record_sensor_id(i);
+            CHECK_EQUAL(1700000000000ULL + i, columns.timestamps_ms[i]);
+            CHECK_EQUAL(id, columns.sensor_ids[i]);
+            if (id == RECOMP_UNKNOWN_SENSOR_ID) {
+                CHECK_EQUAL(BMP280_RECOMP_STATUS_NO_CALIB, columns.statuses[i]);
+                CHECK_EQUAL(0, columns.temperatures[i]);
+                CHECK_EQUAL(0, columns.pressures[i]);
+                continue;
+            }
+            uint8_t regs[24];
+            sensor_calib_regs((id - 1000) / 7, regs);
+            BMP280CalibTemp ct = {(uint16_t)(regs[0] | (regs[1] << 8)), (int16_t)(regs[2] | (regs[3] << 8)),
+                            (int16_t)(regs[4] | (regs[5] << 8))};
+            BMP280CalibPres cp;
+            cp.dig_P1 = (uint16_t)(regs[6] | (regs[7] << 8));
+            int16_t *p_rest[8] = {&cp.dig_P2, &cp.dig_P3, &cp.dig_P4, &cp.dig_P5,
+                                  &cp.dig_P6, &cp.dig_P7, &cp.dig_P8, &cp.dig_P9};
+            for (size_t k = 0; k < 8; k++) {
+                *p_rest[k] = (int16_t)(regs[8 + 2 * k] | (regs[9 + 2 * k] << 8));
+            }
+            int32_t t_fine;
+            int32_t temperature = bmp280_compensate_temp(&ct, (int32_t)record_temp_raw(i), &t_fine);
+            uint32_t pressure = bmp280_compensate_pres(&cp, (int32_t)record_pres_raw(i), t_fine);
+            CHECK_EQUAL(BMP280_RECOMP_STATUS_OK, columns.statuses[i]);
+            CHECK_EQUAL(temperature, columns.temperatures[i]);
+            CHECK_EQUAL(pressure, columns.pressures[i]);
+        }
+    }
+};
+// clang-format on
+
+TEST(BMP280Recompensate, CalibLoadSkipsCommentsAndFindsSensors)
+{
+    write_calib_file();
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_recomp_calib_load(&calib, calib_path));
+    CHECK_EQUAL(RECOMP_NUM_SENSORS, calib.num_sensors);
+    for (uint32_t id = 0; id < RECOMP_NUM_SENSORS; id++) {
+        CHECK_EQUAL((int32_t)id, bmp280_recomp_calib_find(&calib, 1000 + 7 * id));
+    }
+    CHECK_EQUAL(-1, bmp280_recomp_calib_find(&calib, RECOMP_UNKNOWN_SENSOR_ID));
+}
+
+TEST(BMP280Recompensate, CalibLoadFailsOnMalformedLine)
+{
+    FILE *f = fopen(calib_path, "w");
+    CHECK(f != NULL);
+    fprintf(f, "1 706B4367\n");
+    fclose(f);
+    CHECK_EQUAL(BMP280_RESULT_CODE_IO_ERR, bmp280_recomp_calib_load(&calib, calib_path));
+}
+
+TEST(BMP280Recompensate, CalibAddFailsWhenFull)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_recomp_calib_init(&calib, 1));
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_recomp_calib_add(&calib, 1, sim_fixture_calib_data));
+    /* Replacing the values of a known sensor does not need a new entry */
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_recomp_calib_add(&calib, 1, sim_fixture_calib_data));
+    CHECK_EQUAL(BMP280_RESULT_CODE_NO_MEM, bmp280_recomp_calib_add(&calib, 2, sim_fixture_calib_data));
+}
+
+TEST(BMP280Recompensate, ArchiveOpenFailsOnBadMagic)
+{
+    uint8_t header[BMP280_RAW_ARCHIVE_HEADER_SIZE];
+    memcpy(header, valid_archive_header, sizeof(header));
+    header[0] = 'X';
+    write_archive(header, 10);
+    CHECK_EQUAL(BMP280_RESULT_CODE_IO_ERR, bmp280_raw_archive_open(&archive, archive_path));
+}
+
+TEST(BMP280Recompensate, ArchiveOpenFailsOnTruncatedRecord)
+{
+    write_archive(valid_archive_header, 10);
+    FILE *f = fopen(archive_path, "ab");
+    CHECK(f != NULL);
+    fputc(0, f);
+    fclose(f);
+    CHECK_EQUAL(BMP280_RESULT_CODE_IO_ERR, bmp280_raw_archive_open(&archive, archive_path));
+}
+
+TEST(BMP280Recompensate, RunFailsWhenRecordCountsDiffer)
+{
+    write_calib_file();
+    write_archive(valid_archive_header, 10);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_recomp_calib_load(&calib, calib_path));
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_raw_archive_open(&archive, archive_path));
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_columns_create(&columns, columns_path, 9));
+    BMP280RecompStats stats;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_recomp_run(&archive, &calib, &columns, 1, 4, &stats));
+}
+
+TEST(BMP280Recompensate, SingleThreadMatchesReference)
+{
+    write_calib_file();
+    write_archive(valid_archive_header, RECOMP_NUM_RECORDS);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_recomp_calib_load(&calib, calib_path));
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_raw_archive_open(&archive, archive_path));
+    CHECK_EQUAL(RECOMP_NUM_RECORDS, archive.num_records);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_columns_create(&columns, columns_path, archive.num_records));
+
+    BMP280RecompStats stats;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_recomp_run(&archive, &calib, &columns, 1, 64, &stats));
+    CHECK_EQUAL(RECOMP_NUM_RECORDS, stats.num_records);
+    CHECK_EQUAL(RECOMP_NUM_RECORDS / (RECOMP_NUM_SENSORS + 1), stats.num_no_calib);
+    CHECK_EQUAL((RECOMP_NUM_RECORDS + 63) / 64, stats.num_chunks);
+    CHECK_EQUAL(0, stats.num_steals);
+    check_columns_match_reference();
+}
+
+TEST(BMP280Recompensate, WorkStealingMatchesReference)
+{
+    write_calib_file();
+    write_archive(valid_archive_header, RECOMP_NUM_RECORDS);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_recomp_calib_load(&calib, calib_path));
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_raw_archive_open(&archive, archive_path));
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_columns_create(&columns, columns_path, archive.num_records));
+
+    /* More threads than chunks in some ranges, and a partial last chunk */
+    BMP280RecompStats stats;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_recomp_run(&archive, &calib, &columns, 8, 7, &stats));
+    CHECK_EQUAL((RECOMP_NUM_RECORDS + 6) / 7, stats.num_chunks);
+    check_columns_match_reference();
+}
+
+TEST(BMP280Recompensate, OutputFileHasHeaderAndColumns)
+{
+    write_calib_file();
+    write_archive(valid_archive_header, RECOMP_NUM_RECORDS);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_recomp_calib_load(&calib, calib_path));
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_raw_archive_open(&archive, archive_path));
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_columns_create(&columns, columns_path, archive.num_records));
+    BMP280RecompStats stats;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_recomp_run(&archive, &calib, &columns, 2, 100, &stats));
+    int32_t temperature_0 = columns.temperatures[0];
+    bmp280_columns_close(&columns);
+
+    FILE *f = fopen(columns_path, "rb");
+    CHECK(f != NULL);
+    std::vector<uint8_t> file(BMP280_COLUMNS_HEADER_SIZE + RECOMP_NUM_RECORDS * 21);
+    CHECK_EQUAL(file.size(), fread(file.data(), 1, file.size() + 1, f));
+    fclose(f);
+    MEMCMP_EQUAL("BCOL", file.data(), 4);
+    CHECK_EQUAL(BMP280_COLUMNS_VERSION, file[4]);
+    CHECK_EQUAL(BMP280_COLUMNS_NUM_COLUMNS, file[6]);
+    CHECK_EQUAL(RECOMP_NUM_RECORDS, file[8] | (file[9] << 8));
+    /* Column offsets: timestamps, sensor ids, temperatures, pressures, statuses */
+    const size_t expected_offsets[BMP280_COLUMNS_NUM_COLUMNS] = {
+        64, 64 + 8 * RECOMP_NUM_RECORDS, 64 + 12 * RECOMP_NUM_RECORDS, 64 + 16 * RECOMP_NUM_RECORDS,
+        64 + 20 * RECOMP_NUM_RECORDS,
+    };
+    for (size_t c = 0; c < BMP280_COLUMNS_NUM_COLUMNS; c++) {
+        CHECK_EQUAL(expected_offsets[c], (size_t)(file[16 + 8 * c] | (file[17 + 8 * c] << 8)));
+    }
+    int32_t file_temperature_0;
+    memcpy(&file_temperature_0, &file[expected_offsets[2]], sizeof(file_temperature_0));
+    CHECK_EQUAL(temperature_0, file_temperature_0);
+}
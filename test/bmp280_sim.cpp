@@ -0,0 +1,391 @@
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280.h"
+#include "bmp280_compensate_constexpr.h"
+#include "sim.h"
+#include "sim_bmp280.h"
+#include "sim_fixture.h"
+
+#define SIM_MAX_NUM_SENSORS 1000
+#define SIM_NUM_BUSES 10
+/* 400 kHz I2C: ~22.5 us per byte, ~70 us for start condition, device address and register address */
+#define SIM_BUS_OVERHEAD_US 70
+#define SIM_BUS_BYTE_TIME_US 23
+
+typedef struct {
+    SimBMP280 dev;
+    BMP280 inst;
+    BMP280Meas meas;
+    /** Virtual time at which sampling stops. */
+    uint64_t end_us;
+    /** Period between the end of one sample and the start of the next one. */
+    uint64_t period_us;
+    uint32_t num_samples;
+    uint32_t num_errors;
+    /** Sum of all measurements, used to compare two runs of the same simulation. */
+    uint64_t checksum;
+    uint8_t last_rc;
+    bool complete;
+} SimSensor;
+
+static SimSensor sim_sensors[SIM_MAX_NUM_SENSORS];
+static SimBus sim_buses[SIM_NUM_BUSES];
+
+// clang-format off
+TEST_GROUP(BMP280Sim){
+    void setup() {
+        sim_reset();
+        sim_fixture_reset_inst_bufs();
+        memset(sim_sensors, 0, sizeof(sim_sensors));
+        for (size_t i = 0; i < SIM_NUM_BUSES; i++) {
+            sim_bus_init(&sim_buses[i], SIM_BUS_OVERHEAD_US, SIM_BUS_BYTE_TIME_US);
+        }
+    }
+    void teardown() {
+        /* Releases the memory of the event heap, so that it is not reported as a leak */
+        sim_reset();
+    }
+};
+// clang-format on
+
+static void create_sim_sensor_with_lazy_init_meas(SimSensor *sensor, SimBus *bus, bool lazy_init_meas)
+{
+    sim_bmp280_init(&sensor->dev, bus, sim_fixture_calib_data);
+    BMP280InitCfg cfg = {
+        .get_inst_buf = sim_fixture_get_inst_buf,
+        .get_inst_buf_user_data = NULL,
+        .read_regs = sim_bmp280_read_regs,
+        .read_regs_user_data = (void *)&sensor->dev,
+        .write_reg = sim_bmp280_write_reg,
+        .write_reg_user_data = (void *)&sensor->dev,
+        .start_timer = sim_start_timer,
+        .start_timer_user_data = NULL,
+        .lazy_init_meas = lazy_init_meas,
+    };
+    uint8_t rc = bmp280_create(&sensor->inst, &cfg);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+}
+
+static void create_sim_sensor(SimSensor *sensor, SimBus *bus)
+{
+    create_sim_sensor_with_lazy_init_meas(sensor, bus, false);
+}
+
+static void sim_complete_cb(uint8_t rc, void *user_data)
+{
+    SimSensor *sensor = (SimSensor *)user_data;
+    sensor->last_rc = rc;
+    sensor->complete = true;
+}
+
+/** Start an operation and run the simulation until it completes. */
+#define RUN_SIM_OPERATION(sensor, call)                                                                                \
+    do {                                                                                                               \
+        (sensor)->complete = false;                                                                                    \
+        uint8_t start_rc = (call);                                                                                     \
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, start_rc);                                                                  \
+        sim_run();                                                                                                     \
+        CHECK((sensor)->complete);                                                                                     \
+    } while (0)
+
+static void set_sim_sensor_oversampling_1(SimSensor *sensor)
+{
+    RUN_SIM_OPERATION(sensor, bmp280_set_temp_oversampling(sensor->inst, BMP280_OVERSAMPLING_1, sim_complete_cb,
+                                                           (void *)sensor));
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, sensor->last_rc);
+    RUN_SIM_OPERATION(sensor, bmp280_set_pres_oversampling(sensor->inst, BMP280_OVERSAMPLING_1, sim_complete_cb,
+                                                           (void *)sensor));
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, sensor->last_rc);
+}
+
+static void setup_sim_sensor_for_meas(SimSensor *sensor)
+{
+    set_sim_sensor_oversampling_1(sensor);
+    RUN_SIM_OPERATION(sensor, bmp280_init_meas(sensor->inst, sim_complete_cb, (void *)sensor));
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, sensor->last_rc);
+}
+
+TEST(BMP280Sim, ResetWithDelayTakesPowerOnResetDuration)
+{
+    SimSensor *sensor = &sim_sensors[0];
+    create_sim_sensor(sensor, &sim_buses[0]);
+
+    RUN_SIM_OPERATION(sensor, bmp280_reset_with_delay(sensor->inst, sim_complete_cb, (void *)sensor));
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, sensor->last_rc);
+    /* One register write, followed by 2 ms of waiting */
+    CHECK_EQUAL(SIM_BUS_OVERHEAD_US + SIM_BUS_BYTE_TIME_US + 2000, sim_now_us());
+}
+
+TEST(BMP280Sim, ReadMeasForcedModeDatasheetExample)
+{
+    SimSensor *sensor = &sim_sensors[0];
+    create_sim_sensor(sensor, &sim_buses[0]);
+    setup_sim_sensor_for_meas(sensor);
+
+    /* Example from datasheet p.23 */
+    sensor->dev.temp_raw = 519888;
+    sensor->dev.pres_raw = 415148;
+    uint64_t start_us = sim_now_us();
+    RUN_SIM_OPERATION(sensor, bmp280_read_meas_forced_mode(sensor->inst, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7,
+                                                           &sensor->meas, sim_complete_cb, (void *)sensor));
+
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, sensor->last_rc);
+    CHECK_EQUAL(2508, sensor->meas.temperature);
+    CHECK_EQUAL(25767233, sensor->meas.pressure);
+    CHECK_EQUAL(1, sensor->dev.num_conversions);
+    /* Read ctrl_meas, write ctrl_meas, 7 ms wait, read 6 data registers */
+    uint64_t expected_duration_us = (SIM_BUS_OVERHEAD_US + SIM_BUS_BYTE_TIME_US) * 2 + 7000 +
+                                    (SIM_BUS_OVERHEAD_US + 6 * SIM_BUS_BYTE_TIME_US);
+    CHECK_EQUAL(expected_duration_us, sim_now_us() - start_us);
+}
+
+TEST(BMP280Sim, LazyInitMeasSavesCalibReadFromFirstSampleLatency)
+{
+    SimSensor *eager = &sim_sensors[0];
+    SimSensor *lazy = &sim_sensors[1];
+    /* Separate buses, so that the two sensors do not delay each other */
+    create_sim_sensor(eager, &sim_buses[0]);
+    create_sim_sensor_with_lazy_init_meas(lazy, &sim_buses[1], true);
+    set_sim_sensor_oversampling_1(eager);
+    set_sim_sensor_oversampling_1(lazy);
+    eager->dev.temp_raw = lazy->dev.temp_raw = 519888;
+    eager->dev.pres_raw = lazy->dev.pres_raw = 415148;
+
+    uint64_t start_us = sim_now_us();
+    RUN_SIM_OPERATION(eager, bmp280_init_meas(eager->inst, sim_complete_cb, (void *)eager));
+    RUN_SIM_OPERATION(eager, bmp280_read_meas_forced_mode(eager->inst, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7,
+                                                          &eager->meas, sim_complete_cb, (void *)eager));
+    uint64_t eager_latency_us = sim_now_us() - start_us;
+
+    start_us = sim_now_us();
+    RUN_SIM_OPERATION(lazy, bmp280_read_meas_forced_mode(lazy->inst, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7, &lazy->meas,
+                                                         sim_complete_cb, (void *)lazy));
+    uint64_t lazy_latency_us = sim_now_us() - start_us;
+
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, eager->last_rc);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, lazy->last_rc);
+    CHECK_EQUAL(eager->meas.temperature, lazy->meas.temperature);
+    CHECK_EQUAL(eager->meas.pressure, lazy->meas.pressure);
+    CHECK_EQUAL(2508, lazy->meas.temperature);
+    /* Calibration readout of the lazy sensor is hidden behind the 7 ms conversion */
+    uint64_t calib_read_us = SIM_BUS_OVERHEAD_US + 24 * SIM_BUS_BYTE_TIME_US;
+    CHECK_EQUAL(eager_latency_us - calib_read_us, lazy_latency_us);
+}
+
+TEST(BMP280Sim, ReadMeasForcedModeWithOversamplingAlternatesPrecision)
+{
+    SimSensor *sensor = &sim_sensors[0];
+    create_sim_sensor(sensor, &sim_buses[0]);
+    /* No set oversampling sequences */
+    RUN_SIM_OPERATION(sensor, bmp280_init_meas(sensor->inst, sim_complete_cb, (void *)sensor));
+    sensor->dev.temp_raw = 519888;
+    sensor->dev.pres_raw = 415148;
+
+    uint8_t oversampling[] = {BMP280_OVERSAMPLING_1, BMP280_OVERSAMPLING_16, BMP280_OVERSAMPLING_1};
+    /* Datasheet maximum measurement times, rounded up: 6.425 ms and 75.425 ms */
+    uint64_t meas_time_us[] = {7000, 76000, 7000};
+    for (size_t i = 0; i < 3; i++) {
+        uint64_t start_us = sim_now_us();
+        uint64_t start_num_transactions = sim_buses[0].num_transactions;
+        RUN_SIM_OPERATION(sensor, bmp280_read_meas_forced_mode_with_oversampling(sensor->inst, oversampling[i],
+                                                                                 oversampling[i], &sensor->meas,
+                                                                                 sim_complete_cb, (void *)sensor));
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, sensor->last_rc);
+        CHECK_EQUAL(2508, sensor->meas.temperature);
+        CHECK_EQUAL(25767233, sensor->meas.pressure);
+        /* The wait covers the conversion time of the simulated device */
+        CHECK(meas_time_us[i] >= sim_bmp280_conversion_time_us(&sensor->dev));
+        /* Write ctrl_meas, wait, read 6 data registers */
+        CHECK_EQUAL(2, sim_buses[0].num_transactions - start_num_transactions);
+        uint64_t expected_duration_us = (SIM_BUS_OVERHEAD_US + SIM_BUS_BYTE_TIME_US) + meas_time_us[i] +
+                                        (SIM_BUS_OVERHEAD_US + 6 * SIM_BUS_BYTE_TIME_US);
+        CHECK_EQUAL(expected_duration_us, sim_now_us() - start_us);
+    }
+    CHECK_EQUAL(3, sensor->dev.num_conversions);
+}
+
+#define SIM_CONTINUOUS_NUM_SAMPLES 100
+
+static uint64_t sim_continuous_first_sample_us;
+static uint64_t sim_continuous_last_sample_us;
+
+static void continuous_sample_cb(uint8_t rc, void *user_data)
+{
+    SimSensor *sensor = (SimSensor *)user_data;
+    if (rc != BMP280_RESULT_CODE_OK) {
+        sensor->num_errors++;
+        return;
+    }
+    if (sensor->num_samples == 0) {
+        sim_continuous_first_sample_us = sim_now_us();
+    }
+    sim_continuous_last_sample_us = sim_now_us();
+    sensor->num_samples++;
+    sensor->checksum += (uint64_t)(uint32_t)sensor->meas.temperature + sensor->meas.pressure;
+    if (sensor->num_samples == SIM_CONTINUOUS_NUM_SAMPLES) {
+        uint8_t stop_rc = bmp280_stop_continuous_forced_mode(sensor->inst, sim_complete_cb, user_data);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, stop_rc);
+    }
+}
+
+TEST(BMP280Sim, ContinuousForcedModeSamplePeriodIsWriteConversionRead)
+{
+    SimSensor *sensor = &sim_sensors[0];
+    create_sim_sensor(sensor, &sim_buses[0]);
+    setup_sim_sensor_for_meas(sensor);
+    sensor->dev.temp_raw = 519888;
+    sensor->dev.pres_raw = 415148;
+
+    RUN_SIM_OPERATION(sensor, bmp280_start_continuous_forced_mode(sensor->inst, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7,
+                                                                  &sensor->meas, continuous_sample_cb,
+                                                                  (void *)sensor));
+
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, sensor->last_rc);
+    CHECK_EQUAL(0, sensor->num_errors);
+    CHECK_EQUAL(SIM_CONTINUOUS_NUM_SAMPLES, sensor->num_samples);
+    /* Stop was requested from the sample callback after the next conversion had been triggered */
+    CHECK_EQUAL(SIM_CONTINUOUS_NUM_SAMPLES + 1, sensor->dev.num_conversions);
+    CHECK_EQUAL(2508, sensor->meas.temperature);
+    CHECK_EQUAL(25767233, sensor->meas.pressure);
+    /* Write ctrl_meas, 7 ms wait, read 6 data registers. One register read less than back-to-back
+     * bmp280_read_meas_forced_mode calls. */
+    uint64_t sample_period_us = (SIM_BUS_OVERHEAD_US + SIM_BUS_BYTE_TIME_US) + 7000 +
+                                (SIM_BUS_OVERHEAD_US + 6 * SIM_BUS_BYTE_TIME_US);
+    CHECK_EQUAL(sample_period_us * (SIM_CONTINUOUS_NUM_SAMPLES - 1),
+                sim_continuous_last_sample_us - sim_continuous_first_sample_us);
+
+    /* Continuous forced mode has ended, the instance accepts new operations */
+    RUN_SIM_OPERATION(sensor, bmp280_read_meas_forced_mode(sensor->inst, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7,
+                                                           &sensor->meas, sim_complete_cb, (void *)sensor));
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, sensor->last_rc);
+}
+
+/* Ground truth for 20.00 DegC and 1013.25 hPa, computed by the compiler */
+static constexpr int32_t sim_temp_raw_20_deg = bmp280::temp_to_raw<bmp280::DatasheetCalib>(2000);
+static constexpr bmp280::TempResult sim_temp_20_deg =
+    bmp280::compensate_temp<bmp280::DatasheetCalib>(sim_temp_raw_20_deg);
+static constexpr int32_t sim_pres_raw_sea_level =
+    bmp280::pres_to_raw<bmp280::DatasheetCalib>(101325 * 256, sim_temp_20_deg.t_fine);
+static constexpr uint32_t sim_pres_sea_level =
+    bmp280::compensate_pres<bmp280::DatasheetCalib>(sim_pres_raw_sea_level, sim_temp_20_deg.t_fine);
+
+TEST(BMP280Sim, ReadMeasForcedModeCompileTimeGroundTruth)
+{
+    SimSensor *sensor = &sim_sensors[0];
+    create_sim_sensor(sensor, &sim_buses[0]);
+    setup_sim_sensor_for_meas(sensor);
+
+    sensor->dev.temp_raw = sim_temp_raw_20_deg;
+    sensor->dev.pres_raw = sim_pres_raw_sea_level;
+    RUN_SIM_OPERATION(sensor, bmp280_read_meas_forced_mode(sensor->inst, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7,
+                                                           &sensor->meas, sim_complete_cb, (void *)sensor));
+
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, sensor->last_rc);
+    CHECK_EQUAL(2000, sensor->meas.temperature);
+    CHECK_EQUAL(sim_pres_sea_level, sensor->meas.pressure);
+    /* Closest raw value is within one raw LSb, which is less than 0.2 Pa */
+    CHECK(sensor->meas.pressure / 256 >= 101324);
+    CHECK(sensor->meas.pressure / 256 <= 101325);
+}
+
+TEST(BMP280Sim, ReadMeasForcedModeIoErr)
+{
+    SimSensor *sensor = &sim_sensors[0];
+    create_sim_sensor(sensor, &sim_buses[0]);
+    setup_sim_sensor_for_meas(sensor);
+
+    sensor->dev.io_fail = true;
+    RUN_SIM_OPERATION(sensor, bmp280_read_meas_forced_mode(sensor->inst, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7,
+                                                           &sensor->meas, sim_complete_cb, (void *)sensor));
+    CHECK_EQUAL(BMP280_RESULT_CODE_IO_ERR, sensor->last_rc);
+    CHECK_EQUAL(0, sensor->dev.num_conversions);
+}
+
+static void start_periodic_sample(void *user_data);
+
+static void periodic_sample_complete_cb(uint8_t rc, void *user_data)
+{
+    SimSensor *sensor = (SimSensor *)user_data;
+    if (rc == BMP280_RESULT_CODE_OK) {
+        sensor->num_samples++;
+        sensor->checksum += (uint64_t)(uint32_t)sensor->meas.temperature + sensor->meas.pressure + sim_now_us();
+    } else {
+        sensor->num_errors++;
+    }
+    if (sim_now_us() + sensor->period_us < sensor->end_us) {
+        sim_schedule_us(sensor->period_us, start_periodic_sample, (void *)sensor);
+    }
+}
+
+static void start_periodic_sample(void *user_data)
+{
+    SimSensor *sensor = (SimSensor *)user_data;
+    /* Slowly varying raw values, so that every sample is different */
+    sensor->dev.temp_raw = 519888 + (int32_t)(sensor->num_samples % 64);
+    sensor->dev.pres_raw = 415148 - (int32_t)(sensor->num_samples % 128);
+    uint8_t rc = bmp280_read_meas_forced_mode(sensor->inst, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7, &sensor->meas,
+                                              periodic_sample_complete_cb, (void *)sensor);
+    if (rc != BMP280_RESULT_CODE_OK) {
+        sensor->num_errors++;
+    }
+}
+
+/**
+ * @brief Sample @p num_sensors sensors every @p period_us for @p duration_us of virtual time.
+ *
+ * @return uint64_t Checksum of all samples of all sensors.
+ */
+static uint64_t run_periodic_acquisition(size_t num_sensors, uint64_t period_us, uint64_t duration_us)
+{
+    sim_reset();
+    sim_fixture_reset_inst_bufs();
+    memset(sim_sensors, 0, sizeof(sim_sensors));
+    for (size_t i = 0; i < SIM_NUM_BUSES; i++) {
+        sim_bus_init(&sim_buses[i], SIM_BUS_OVERHEAD_US, SIM_BUS_BYTE_TIME_US);
+    }
+
+    for (size_t i = 0; i < num_sensors; i++) {
+        SimSensor *sensor = &sim_sensors[i];
+        create_sim_sensor(sensor, &sim_buses[i % SIM_NUM_BUSES]);
+        setup_sim_sensor_for_meas(sensor);
+    }
+
+    uint64_t start_us = sim_now_us();
+    for (size_t i = 0; i < num_sensors; i++) {
+        SimSensor *sensor = &sim_sensors[i];
+        sensor->period_us = period_us;
+        sensor->end_us = start_us + duration_us;
+        /* Spread the start of sampling across one period */
+        sim_schedule_us((i * 7919) % period_us, start_periodic_sample, (void *)sensor);
+    }
+    sim_run();
+
+    uint64_t checksum = 0;
+    for (size_t i = 0; i < num_sensors; i++) {
+        CHECK_EQUAL(0, sim_sensors[i].num_errors);
+        checksum = checksum * 31 + sim_sensors[i].checksum;
+    }
+    return checksum;
+}
+
+TEST(BMP280Sim, HourOfAcquisitionAcrossThousandSensorsIsDeterministic)
+{
+    size_t num_sensors = SIM_MAX_NUM_SENSORS;
+    /* One sample every 10 s from every sensor for one hour */
+    uint64_t period_us = 10ULL * 1000 * 1000;
+    uint64_t duration_us = 3600ULL * 1000 * 1000;
+
+    uint64_t checksum_1 = run_periodic_acquisition(num_sensors, period_us, duration_us);
+    uint64_t end_us_1 = sim_now_us();
+    uint64_t num_events_1 = sim_num_executed_events();
+    uint32_t num_samples_sensor_0 = sim_sensors[0].num_samples;
+
+    uint64_t checksum_2 = run_periodic_acquisition(num_sensors, period_us, duration_us);
+
+    CHECK(num_samples_sensor_0 >= 350);
+    CHECK_EQUAL(checksum_1, checksum_2);
+    CHECK_EQUAL(end_us_1, sim_now_us());
+    CHECK_EQUAL(num_events_1, sim_num_executed_events());
+}
@@ -0,0 +1,469 @@
+#include <string.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280.h"
+#include "bmp280_stats.h"
+#include "sim.h"
+#include "sim_bmp280.h"
+#include "sim_fixture.h"
+
+static BMP280 bmp280;
+static SimBus sim_bus;
+static SimBMP280 sim_dev;
+static BMP280BusStats bus_stats;
+static BMP280SensorStats sensor_stats;
+static BMP280SensorSnapshot sensor_snapshot;
+static BMP280BusSnapshot bus_snapshot;
+static BMP280Meas meas;
+static uint32_t num_complete_cb_calls;
+static uint8_t complete_cb_rc;
+
+static uint32_t stats_now_us(void *user_data)
+{
+    (void)user_data;
+    return (uint32_t)sim_now_us();
+}
+
+static void stats_complete_cb(uint8_t rc, void *user_data)
+{
+    (void)user_data;
+    num_complete_cb_calls++;
+    complete_cb_rc = rc;
+}
+
+// clang-format off
+TEST_GROUP(BMP280Stats){
+    void setup() {
+        sim_reset();
+        sim_fixture_reset_inst_bufs();
+        sim_bus_init(&sim_bus, 70, 23);
+        sim_bmp280_init(&sim_dev, &sim_bus, sim_fixture_calib_data);
+        sim_dev.temp_raw = 519888;
+        sim_dev.pres_raw = 415148;
+        num_complete_cb_calls = 0;
+        complete_cb_rc = 0xFF;
+
+        uint8_t rc = bmp280_stats_bus_init(&bus_stats, 3);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+        BMP280SensorStatsCfg stats_cfg = {
+            .sensor_id = 17,
+            .bus = &bus_stats,
+            .now_us = stats_now_us,
+            .now_us_user_data = NULL,
+            .read_regs = sim_bmp280_read_regs,
+            .read_regs_user_data = (void *)&sim_dev,
+            .write_reg = sim_bmp280_write_reg,
+            .write_reg_user_data = (void *)&sim_dev,
+        };
+        rc = bmp280_stats_sensor_init(&sensor_stats, &stats_cfg);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+
+        BMP280InitCfg cfg = {
+            .get_inst_buf = sim_fixture_get_inst_buf,
+            .get_inst_buf_user_data = NULL,
+            .read_regs = bmp280_stats_read_regs,
+            .read_regs_user_data = (void *)&sensor_stats,
+            .write_reg = bmp280_stats_write_reg,
+            .write_reg_user_data = (void *)&sensor_stats,
+            .start_timer = sim_start_timer,
+            .start_timer_user_data = NULL,
+            .lazy_init_meas = false,
+        };
+        rc = bmp280_create(&bmp280, &cfg);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    }
+};
+// clang-format on
+
+static void init_sensor()
+{
+    uint8_t rc = bmp280_init_meas(bmp280, stats_complete_cb, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    sim_run();
+    rc = bmp280_set_pres_oversampling(bmp280, BMP280_OVERSAMPLING_1, stats_complete_cb, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    sim_run();
+    rc = bmp280_set_temp_oversampling(bmp280, BMP280_OVERSAMPLING_1, stats_complete_cb, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    sim_run();
+    num_complete_cb_calls = 0;
+}
+
+TEST(BMP280Stats, SensorInitInvalArg)
+{
+    BMP280SensorStatsCfg cfg = sensor_stats.cfg;
+    cfg.bus = NULL;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_stats_sensor_init(&sensor_stats, &cfg));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_stats_sensor_init(&sensor_stats, NULL));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_stats_bus_init(NULL, 0));
+}
+
+TEST(BMP280Stats, BusCountersMatchSimulatedBus)
+{
+    init_sensor();
+    uint8_t rc = bmp280_stats_read_meas_forced_mode(bmp280, &sensor_stats, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7, &meas,
+                                                    stats_complete_cb, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    sim_run();
+
+    BMP280BusCounters c;
+    bmp280_stats_bus_snapshot(&bus_stats, &c);
+    CHECK_EQUAL(sim_bus.num_transactions, c.transactions);
+    CHECK_EQUAL(sim_bus.num_bytes, c.bytes);
+    /* A single sensor never waits for the bus, so every transaction lasts exactly its transfer time */
+    CHECK_EQUAL(70 * sim_bus.num_transactions + 23 * sim_bus.num_bytes, c.busy_us);
+    CHECK_EQUAL(0, c.errors);
+}
+
+TEST(BMP280Stats, ForcedModeMeasurementRecorded)
+{
+    init_sensor();
+    uint8_t rc = bmp280_stats_read_meas_forced_mode(bmp280, &sensor_stats, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7, &meas,
+                                                    stats_complete_cb, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    uint64_t start_us = sim_now_us();
+    sim_run();
+
+    CHECK_EQUAL(1, num_complete_cb_calls);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, complete_cb_rc);
+    CHECK_EQUAL(2508, meas.temperature);
+    BMP280SensorCounters c;
+    bmp280_stats_sensor_snapshot(&sensor_stats, &c);
+    CHECK_EQUAL(1, c.ops_ok);
+    CHECK_EQUAL(0, c.ops_io_err);
+    CHECK_EQUAL(sim_now_us() - start_us, c.latency_sum_us);
+    /* 7 ms timer plus transactions: 5 ms < latency <= 10 ms */
+    CHECK_EQUAL(1, c.latency_buckets[3]);
+}
+
+TEST(BMP280Stats, BusyRejectionKeepsOperationInProgress)
+{
+    init_sensor();
+    uint8_t rc = bmp280_stats_read_meas_forced_mode(bmp280, &sensor_stats, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7, &meas,
+                                                    stats_complete_cb, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    BMP280Meas other_meas;
+    rc = bmp280_stats_read_meas_forced_mode(bmp280, &sensor_stats, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7, &other_meas,
+                                            NULL, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_BUSY, rc);
+    sim_run();
+
+    /* The callback of the operation in progress was not replaced */
+    CHECK_EQUAL(1, num_complete_cb_calls);
+    BMP280SensorCounters c;
+    bmp280_stats_sensor_snapshot(&sensor_stats, &c);
+    CHECK_EQUAL(1, c.ops_ok);
+    CHECK_EQUAL(1, c.rejected_busy);
+    CHECK_EQUAL(0, c.rejected_other);
+}
+
+static uint32_t num_other_cb_calls;
+
+static void stats_other_cb(uint8_t rc, void *user_data)
+{
+    (void)rc;
+    (void)user_data;
+    num_other_cb_calls++;
+}
+
+TEST(BMP280Stats, SubmissionDuringContinuousModeKeepsSession)
+{
+    init_sensor();
+    num_other_cb_calls = 0;
+    uint8_t rc = bmp280_stats_start_continuous_forced_mode(bmp280, &sensor_stats, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7,
+                                                           &meas, stats_complete_cb, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    sim_run_until_us(sim_now_us() + 20000);
+    CHECK(num_complete_cb_calls >= 2);
+
+    /* Between two samples, no operation of the driver is running, but the session is */
+    BMP280Meas other_meas;
+    rc = bmp280_stats_read_meas_forced_mode(bmp280, &sensor_stats, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7, &other_meas,
+                                            stats_other_cb, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_BUSY, rc);
+    uint32_t num_samples = num_complete_cb_calls;
+    sim_run_until_us(sim_now_us() + 20000);
+
+    /* Later samples still go to the callback of the session */
+    CHECK(num_complete_cb_calls > num_samples);
+    CHECK_EQUAL(0, num_other_cb_calls);
+    BMP280SensorCounters c;
+    bmp280_stats_sensor_snapshot(&sensor_stats, &c);
+    CHECK_EQUAL(num_complete_cb_calls, c.ops_ok);
+    CHECK_EQUAL(1, c.rejected_busy);
+
+    /* Once the session has stopped, the next operation is tracked with its own callback */
+    rc = bmp280_stats_stop_continuous_forced_mode(bmp280, &sensor_stats, stats_other_cb, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    sim_run();
+    CHECK_EQUAL(1, num_other_cb_calls);
+    CHECK_FALSE(sensor_stats.op.in_progress);
+    rc = bmp280_stats_read_meas_forced_mode(bmp280, &sensor_stats, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7, &other_meas,
+                                            stats_other_cb, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    sim_run();
+    CHECK_EQUAL(2, num_other_cb_calls);
+    CHECK_EQUAL(2508, other_meas.temperature);
+}
+
+TEST(BMP280Stats, InvalidSubmissionCountedAsOtherRejection)
+{
+    init_sensor();
+    uint8_t rc = bmp280_stats_read_meas_forced_mode(bmp280, &sensor_stats, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7, NULL,
+                                                    stats_complete_cb, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, rc);
+    /* The rejected operation is not in progress, the next one is tracked */
+    rc = bmp280_stats_read_meas_forced_mode(bmp280, &sensor_stats, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7, &meas,
+                                            stats_complete_cb, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    sim_run();
+
+    BMP280SensorCounters c;
+    bmp280_stats_sensor_snapshot(&sensor_stats, &c);
+    CHECK_EQUAL(1, c.rejected_other);
+    CHECK_EQUAL(1, c.ops_ok);
+    CHECK_EQUAL(1, num_complete_cb_calls);
+}
+
+TEST(BMP280Stats, IoErrCountedPerSensorAndBus)
+{
+    init_sensor();
+    sim_dev.io_fail = true;
+    uint8_t rc = bmp280_stats_read_meas_forced_mode(bmp280, &sensor_stats, BMP280_MEAS_TYPE_TEMP_AND_PRES, 7, &meas,
+                                                    stats_complete_cb, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    sim_run();
+
+    CHECK_EQUAL(BMP280_RESULT_CODE_IO_ERR, complete_cb_rc);
+    BMP280SensorCounters c;
+    bmp280_stats_sensor_snapshot(&sensor_stats, &c);
+    CHECK_EQUAL(1, c.ops_io_err);
+    BMP280BusCounters bc;
+    bmp280_stats_bus_snapshot(&bus_stats, &bc);
+    CHECK_EQUAL(1, bc.errors);
+}
+
+static std::string serialize_all(const BMP280StatsRegistry *reg, size_t chunk_size)
+{
+    std::vector<char> buf(chunk_size);
+    std::string out;
+    BMP280StatsWriter writer;
+    bmp280_stats_writer_init(&writer, reg);
+    size_t len;
+    while ((len = bmp280_stats_serialize(&writer, buf.data(), buf.size())) > 0) {
+        out.append(buf.data(), len);
+    }
+    return out;
+}
+
+TEST(BMP280Stats, SerializeOpenMetrics)
+{
+    sensor_stats.counters.ops_ok = 12;
+    sensor_stats.counters.ops_io_err = 1;
+    sensor_stats.counters.rejected_busy = 2;
+    sensor_stats.counters.latency_buckets[3] = 12;
+    sensor_stats.counters.latency_buckets[BMP280_STATS_NUM_LATENCY_BUCKETS] = 1;
+    sensor_stats.counters.latency_sum_us = 1234567;
+    bus_stats.counters.transactions = 40;
+    bus_stats.counters.bytes = 104;
+    bus_stats.counters.busy_us = 5192;
+    BMP280StatsRegistry reg = {&sensor_stats, 1, &bus_stats, 1, &sensor_snapshot, &bus_snapshot};
+
+    std::string expected = "# TYPE bmp280_operations counter\n"
+                           "# HELP bmp280_operations Completed driver operations.\n"
+                           "bmp280_operations_total{sensor=\"17\",result=\"ok\"} 12\n"
+                           "bmp280_operations_total{sensor=\"17\",result=\"io_err\"} 1\n"
+                           "bmp280_operations_total{sensor=\"17\",result=\"other_err\"} 0\n"
+                           "# TYPE bmp280_rejections counter\n"
+                           "# HELP bmp280_rejections Driver operations rejected on submission.\n"
+                           "bmp280_rejections_total{sensor=\"17\",reason=\"busy\"} 2\n"
+                           "bmp280_rejections_total{sensor=\"17\",reason=\"other\"} 0\n"
+                           "# TYPE bmp280_operation_latency_seconds histogram\n"
+                           "# HELP bmp280_operation_latency_seconds Time from submission to completion of driver "
+                           "operations.\n"
+                           "bmp280_operation_latency_seconds_bucket{sensor=\"17\",le=\"0.001\"} 0\n"
+                           "bmp280_operation_latency_seconds_bucket{sensor=\"17\",le=\"0.0025\"} 0\n"
+                           "bmp280_operation_latency_seconds_bucket{sensor=\"17\",le=\"0.005\"} 0\n"
+                           "bmp280_operation_latency_seconds_bucket{sensor=\"17\",le=\"0.01\"} 12\n"
+                           "bmp280_operation_latency_seconds_bucket{sensor=\"17\",le=\"0.025\"} 12\n"
+                           "bmp280_operation_latency_seconds_bucket{sensor=\"17\",le=\"0.05\"} 12\n"
+                           "bmp280_operation_latency_seconds_bucket{sensor=\"17\",le=\"0.1\"} 12\n"
+                           "bmp280_operation_latency_seconds_bucket{sensor=\"17\",le=\"0.25\"} 12\n"
+                           "bmp280_operation_latency_seconds_bucket{sensor=\"17\",le=\"0.5\"} 12\n"
+                           "bmp280_operation_latency_seconds_bucket{sensor=\"17\",le=\"1.0\"} 12\n"
+                           "bmp280_operation_latency_seconds_bucket{sensor=\"17\",le=\"+Inf\"} 13\n"
+                           "bmp280_operation_latency_seconds_count{sensor=\"17\"} 13\n"
+                           "bmp280_operation_latency_seconds_sum{sensor=\"17\"} 1.234567\n"
+                           "# TYPE bmp280_bus_transactions counter\n"
+                           "# HELP bmp280_bus_transactions Register read and write transactions.\n"
+                           "bmp280_bus_transactions_total{bus=\"3\"} 40\n"
+                           "# TYPE bmp280_bus_bytes counter\n"
+                           "# HELP bmp280_bus_bytes Register data bytes transferred.\n"
+                           "bmp280_bus_bytes_total{bus=\"3\"} 104\n"
+                           "# TYPE bmp280_bus_busy_seconds counter\n"
+                           "# HELP bmp280_bus_busy_seconds Sum of transaction durations.\n"
+                           "bmp280_bus_busy_seconds_total{bus=\"3\"} 0.005192\n"
+                           "# TYPE bmp280_bus_errors counter\n"
+                           "# HELP bmp280_bus_errors Failed transactions.\n"
+                           "bmp280_bus_errors_total{bus=\"3\"} 0\n"
+                           "# EOF\n";
+    STRCMP_EQUAL(expected.c_str(), serialize_all(&reg, 65536).c_str());
+}
+
+TEST(BMP280Stats, SnapshotDuringUpdateFailsInsteadOfTearing)
+{
+    BMP280StatsRegistry reg = {&sensor_stats, 1, &bus_stats, 1, &sensor_snapshot, &bus_snapshot};
+    /* An odd sequence counter means that the acquisition context is in the middle of an update */
+    sensor_stats.seq++;
+
+    BMP280SensorCounters c;
+    CHECK_EQUAL(BMP280_RESULT_CODE_BUSY, bmp280_stats_sensor_snapshot(&sensor_stats, &c));
+    BMP280BusCounters bc;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_stats_bus_snapshot(&bus_stats, &bc));
+
+    std::vector<char> buf(65536);
+    BMP280StatsWriter writer;
+    bmp280_stats_writer_init(&writer, &reg);
+    std::string out;
+    size_t len;
+    while ((len = bmp280_stats_serialize(&writer, buf.data(), buf.size())) > 0) {
+        out.append(buf.data(), len);
+    }
+    /* The sensor is counted once and has no samples in any family, the headers and the bus samples are still there */
+    CHECK_EQUAL(1, writer.num_skipped);
+    CHECK(out.find("sensor=") == std::string::npos);
+    CHECK(out.find("# TYPE bmp280_operations counter\n") != std::string::npos);
+    CHECK(out.find("bmp280_bus_transactions_total{bus=\"3\"} 0\n") != std::string::npos);
+    CHECK(out.size() > 6 && out.compare(out.size() - 6, 6, "# EOF\n") == 0);
+
+    sensor_stats.seq++;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_stats_sensor_snapshot(&sensor_stats, &c));
+}
+
+TEST(BMP280Stats, FamiliesOfOneSensorAreWrittenFromOneSnapshot)
+{
+    sensor_stats.counters.ops_ok = 5;
+    sensor_stats.counters.latency_buckets[2] = 5;
+    BMP280StatsRegistry reg = {&sensor_stats, 1, &bus_stats, 1, &sensor_snapshot, &bus_snapshot};
+
+    std::vector<char> buf(BMP280_STATS_MAX_ITEM_LEN);
+    BMP280StatsWriter writer;
+    bmp280_stats_writer_init(&writer, &reg);
+    std::string out;
+    size_t len;
+    while (out.find("result=\"ok\"} 5\n") == std::string::npos &&
+           (len = bmp280_stats_serialize(&writer, buf.data(), buf.size())) > 0) {
+        out.append(buf.data(), len);
+    }
+    /* An operation completes after the operations family is written, but before the latency family */
+    sensor_stats.counters.ops_ok++;
+    sensor_stats.counters.latency_buckets[2]++;
+    while ((len = bmp280_stats_serialize(&writer, buf.data(), buf.size())) > 0) {
+        out.append(buf.data(), len);
+    }
+
+    CHECK_EQUAL(0, writer.num_skipped);
+    CHECK(out.find("bmp280_operations_total{sensor=\"17\",result=\"ok\"} 5\n") != std::string::npos);
+    CHECK(out.find("bmp280_operation_latency_seconds_count{sensor=\"17\"} 5\n") != std::string::npos);
+}
+
+#define STATS_NUM_SENSORS 10000
+#define STATS_NUM_BUSES 100
+
+static BMP280SensorStats many_sensors[STATS_NUM_SENSORS];
+static BMP280BusStats many_buses[STATS_NUM_BUSES];
+static BMP280SensorSnapshot many_sensor_snapshots[STATS_NUM_SENSORS];
+static BMP280BusSnapshot many_bus_snapshots[STATS_NUM_BUSES];
+
+static void init_many(void)
+{
+    for (size_t i = 0; i < STATS_NUM_BUSES; i++) {
+        bmp280_stats_bus_init(&many_buses[i], (uint32_t)i);
+        many_buses[i].counters.transactions = i * 1000;
+    }
+    for (size_t i = 0; i < STATS_NUM_SENSORS; i++) {
+        BMP280SensorStatsCfg cfg = sensor_stats.cfg;
+        cfg.sensor_id = (uint32_t)(100000 + i);
+        cfg.bus = &many_buses[i % STATS_NUM_BUSES];
+        bmp280_stats_sensor_init(&many_sensors[i], &cfg);
+        many_sensors[i].counters.ops_ok = 1000000 + i;
+        many_sensors[i].counters.latency_buckets[i % 11] = i;
+        many_sensors[i].counters.latency_sum_us = 8000ULL * i;
+    }
+}
+
+TEST(BMP280Stats, SerializeInChunksMatchesSerializeAtOnce)
+{
+    init_many();
+    BMP280StatsRegistry reg = {many_sensors,          500,
+                               many_buses,            STATS_NUM_BUSES,
+                               many_sensor_snapshots, many_bus_snapshots};
+    std::string at_once = serialize_all(&reg, 4 * 1024 * 1024);
+    std::string in_chunks = serialize_all(&reg, BMP280_STATS_MAX_ITEM_LEN);
+    CHECK(at_once.size() > 500 * 1000);
+    CHECK(at_once == in_chunks);
+}
+
+static uint32_t fake_now_us;
+
+static uint32_t fake_now(void *user_data)
+{
+    (void)user_data;
+    return fake_now_us;
+}
+
+/**
+ * @brief The acquisition thread keeps completing operations while another thread scrapes 10000 sensors.
+ *
+ * Every snapshot must be consistent: ops_ok is incremented together with one latency bucket, so their sums must match.
+ */
+TEST(BMP280Stats, ScrapeDoesNotPauseAcquisitionAndSeesConsistentCounters)
+{
+    init_many();
+    for (size_t i = 0; i < STATS_NUM_SENSORS; i++) {
+        memset(&many_sensors[i].counters, 0, sizeof(many_sensors[i].counters));
+        many_sensors[i].cfg.now_us = fake_now;
+    }
+    BMP280StatsRegistry reg = {many_sensors,          STATS_NUM_SENSORS,    many_buses,
+                               STATS_NUM_BUSES,       many_sensor_snapshots, many_bus_snapshots};
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> num_ops(0);
+
+    std::thread acquisition([&]() {
+        uint64_t n = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            BMP280SensorStats *s = &many_sensors[n % 16];
+            bmp280_stats_op_prepare(s, NULL, NULL);
+            bmp280_stats_op_submitted(s, BMP280_RESULT_CODE_OK);
+            fake_now_us += 3000;
+            bmp280_stats_complete_cb(BMP280_RESULT_CODE_OK, (void *)s);
+            n++;
+        }
+        num_ops = n;
+    });
+
+    size_t num_inconsistent = 0;
+    std::string out = serialize_all(&reg, 65536);
+    for (size_t round = 0; round < 20000; round++) {
+        BMP280SensorCounters c;
+        if (bmp280_stats_sensor_snapshot(&many_sensors[round % 16], &c) != BMP280_RESULT_CODE_OK) {
+            continue;
+        }
+        uint64_t sum = 0;
+        for (size_t b = 0; b <= BMP280_STATS_NUM_LATENCY_BUCKETS; b++) {
+            sum += c.latency_buckets[b];
+        }
+        num_inconsistent += (sum != c.ops_ok) ? 1 : 0;
+    }
+    stop = true;
+    acquisition.join();
+
+    CHECK(!out.empty());
+    CHECK_EQUAL(0, num_inconsistent);
+    CHECK(num_ops.load() > 0);
+}
@@ -0,0 +1,344 @@
+#include <string.h>
+#include <vector>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280.h"
+#include "bmp280_table.h"
+#include "sim.h"
+#include "sim_bmp280.h"
+#include "sim_fixture.h"
+/* To include the definition of struct BMP280Struct, so that AosSensor can embed an instance. */
+#include "bmp280_private.h"
+
+#define TABLE_NUM_SENSORS 4
+#define TABLE_CAPACITY 8
+
+static BMP280 insts[TABLE_NUM_SENSORS];
+static SimBus sim_bus;
+static SimBMP280 sim_devs[TABLE_NUM_SENSORS];
+static BMP280Meas driver_meas[TABLE_NUM_SENSORS];
+static BMP280Meas table_meas[TABLE_CAPACITY];
+
+static BMP280 arr_insts[TABLE_CAPACITY];
+static uint8_t arr_state[TABLE_CAPACITY];
+static uint32_t arr_next_due_ms[TABLE_CAPACITY];
+static uint32_t arr_period_ms[TABLE_CAPACITY];
+static BMP280CalibTemp arr_calib_temp[TABLE_CAPACITY];
+static BMP280CalibPres arr_calib_pres[TABLE_CAPACITY];
+static int32_t arr_temp_raw[TABLE_CAPACITY];
+static int32_t arr_pres_raw[TABLE_CAPACITY];
+static BMP280TableArrays arrays;
+static BMP280Table table;
+
+static void table_init_complete_cb(uint8_t rc, void *user_data)
+{
+    (void)user_data;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+}
+
+static void table_read_complete_cb(uint8_t rc, void *user_data)
+{
+    bmp280_table_read_done(&table, (size_t)(uintptr_t)user_data, rc);
+}
+
+// clang-format off
+TEST_GROUP(BMP280Table){
+    void setup() {
+        sim_reset();
+        sim_fixture_reset_inst_bufs();
+        sim_bus_init(&sim_bus, 70, 23);
+        for (size_t i = 0; i < TABLE_NUM_SENSORS; i++) {
+            sim_bmp280_init(&sim_devs[i], &sim_bus, sim_fixture_calib_data);
+            sim_devs[i].temp_raw = 519888;
+            sim_devs[i].pres_raw = 415148;
+            BMP280InitCfg cfg = {
+                .get_inst_buf = sim_fixture_get_inst_buf,
+                .get_inst_buf_user_data = NULL,
+                .read_regs = sim_bmp280_read_regs,
+                .read_regs_user_data = (void *)&sim_devs[i],
+                .write_reg = sim_bmp280_write_reg,
+                .write_reg_user_data = (void *)&sim_devs[i],
+                .start_timer = sim_start_timer,
+                .start_timer_user_data = NULL,
+                .lazy_init_meas = false,
+            };
+            uint8_t rc = bmp280_create(&insts[i], &cfg);
+            CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+        }
+        memset(table_meas, 0, sizeof(table_meas));
+
+        arrays.insts = arr_insts;
+        arrays.state = arr_state;
+        arrays.next_due_ms = arr_next_due_ms;
+        arrays.period_ms = arr_period_ms;
+        arrays.calib_temp = arr_calib_temp;
+        arrays.calib_pres = arr_calib_pres;
+        arrays.temp_raw = arr_temp_raw;
+        arrays.pres_raw = arr_pres_raw;
+        arrays.capacity = TABLE_CAPACITY;
+        uint8_t rc = bmp280_table_init(&table, &arrays);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    }
+};
+// clang-format on
+
+static void init_sensors()
+{
+    for (size_t i = 0; i < TABLE_NUM_SENSORS; i++) {
+        uint8_t rc = bmp280_init_meas(insts[i], table_init_complete_cb, NULL);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+        sim_run();
+        rc = bmp280_set_pres_oversampling(insts[i], BMP280_OVERSAMPLING_1, table_init_complete_cb, NULL);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+        sim_run();
+        rc = bmp280_set_temp_oversampling(insts[i], BMP280_OVERSAMPLING_1, table_init_complete_cb, NULL);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+        sim_run();
+    }
+}
+
+TEST(BMP280Table, InitInvalArg)
+{
+    BMP280TableArrays bad = arrays;
+    bad.calib_pres = NULL;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_table_init(&table, &bad));
+    bad = arrays;
+    bad.capacity = 0;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_table_init(&table, &bad));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_table_init(&table, NULL));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_table_init(NULL, &arrays));
+}
+
+TEST(BMP280Table, AddRequiresCalibration)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_USAGE, bmp280_table_add(&table, insts[0], 10, 0, NULL));
+    CHECK_EQUAL(0, bmp280_table_num(&table));
+
+    init_sensors();
+    size_t idx = 0xFF;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_table_add(&table, insts[0], 10, 0, &idx));
+    CHECK_EQUAL(0, idx);
+    CHECK_EQUAL(1, bmp280_table_num(&table));
+    POINTERS_EQUAL(insts[0], bmp280_table_inst(&table, 0));
+    CHECK_EQUAL(27504, arr_calib_temp[0].dig_T1);
+    CHECK_EQUAL(36477, arr_calib_pres[0].dig_P1);
+    CHECK_EQUAL(6000, arr_calib_pres[0].dig_P9);
+}
+
+TEST(BMP280Table, AddInvalArgAndFull)
+{
+    init_sensors();
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_table_add(&table, NULL, 10, 0, NULL));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_table_add(&table, insts[0], 0, 0, NULL));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_table_add(NULL, insts[0], 10, 0, NULL));
+    for (size_t i = 0; i < TABLE_CAPACITY; i++) {
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_table_add(&table, insts[i % TABLE_NUM_SENSORS], 10, 0, NULL));
+    }
+    CHECK_EQUAL(BMP280_RESULT_CODE_NO_MEM, bmp280_table_add(&table, insts[0], 10, 0, NULL));
+    CHECK_EQUAL(TABLE_CAPACITY, bmp280_table_num(&table));
+}
+
+TEST(BMP280Table, CollectDueFollowsPeriodsAndSkipsBusy)
+{
+    init_sensors();
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_table_add(&table, insts[0], 10, 100, NULL));
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_table_add(&table, insts[1], 25, 105, NULL));
+
+    size_t idxs[TABLE_CAPACITY];
+    CHECK_EQUAL(1, bmp280_table_collect_due(&table, 100, idxs, TABLE_CAPACITY));
+    CHECK_EQUAL(0, idxs[0]);
+    /* Busy until the measurement is reported as done */
+    CHECK_EQUAL(1, bmp280_table_collect_due(&table, 110, idxs, TABLE_CAPACITY));
+    CHECK_EQUAL(1, idxs[0]);
+    bmp280_table_read_done(&table, 0, BMP280_RESULT_CODE_IO_ERR);
+    CHECK_EQUAL(1, bmp280_table_collect_due(&table, 110, idxs, TABLE_CAPACITY));
+    CHECK_EQUAL(0, idxs[0]);
+    CHECK_EQUAL(0, bmp280_table_collect_due(&table, 119, idxs, TABLE_CAPACITY));
+    /* A failed measurement has no new frame */
+    CHECK_EQUAL(0, bmp280_table_compensate(&table, table_meas));
+}
+
+TEST(BMP280Table, CollectDueRestartsScheduleWhenBehind)
+{
+    init_sensors();
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_table_add(&table, insts[0], 10, 0, NULL));
+    size_t idx;
+
+    CHECK_EQUAL(1, bmp280_table_collect_due(&table, 35, &idx, 1));
+    bmp280_table_read_done(&table, 0, BMP280_RESULT_CODE_IO_ERR);
+    /* Next due at 45, not 10, 20 and 30 in a row */
+    CHECK_EQUAL(0, bmp280_table_collect_due(&table, 44, &idx, 1));
+    CHECK_EQUAL(1, bmp280_table_collect_due(&table, 45, &idx, 1));
+}
+
+TEST(BMP280Table, CollectDueAcrossMsCounterWraparound)
+{
+    init_sensors();
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_table_add(&table, insts[0], 10, UINT32_MAX - 4, NULL));
+    size_t idx;
+
+    CHECK_EQUAL(1, bmp280_table_collect_due(&table, UINT32_MAX - 4, &idx, 1));
+    bmp280_table_read_done(&table, 0, BMP280_RESULT_CODE_IO_ERR);
+    CHECK_EQUAL(0, bmp280_table_collect_due(&table, UINT32_MAX, &idx, 1));
+    CHECK_EQUAL(0, bmp280_table_collect_due(&table, 4, &idx, 1));
+    CHECK_EQUAL(1, bmp280_table_collect_due(&table, 5, &idx, 1));
+}
+
+TEST(BMP280Table, CollectDueLeavesOverflowDue)
+{
+    init_sensors();
+    for (size_t i = 0; i < TABLE_NUM_SENSORS; i++) {
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_table_add(&table, insts[i], 10, 0, NULL));
+    }
+    size_t idxs[2];
+
+    CHECK_EQUAL(2, bmp280_table_collect_due(&table, 0, idxs, 2));
+    CHECK_EQUAL(0, idxs[0]);
+    CHECK_EQUAL(1, idxs[1]);
+    CHECK_EQUAL(2, bmp280_table_collect_due(&table, 1, idxs, 2));
+    CHECK_EQUAL(2, idxs[0]);
+    CHECK_EQUAL(3, idxs[1]);
+}
+
+TEST(BMP280Table, DriverMeasurementsAreCollectedWithoutCompensatingAgain)
+{
+    init_sensors();
+    for (size_t i = 0; i < TABLE_NUM_SENSORS; i++) {
+        sim_devs[i].temp_raw = 519888 + (int32_t)i * 1000;
+        sim_devs[i].pres_raw = 415148 - (int32_t)i * 2000;
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_table_add(&table, insts[i], 50, 0, NULL));
+    }
+
+    size_t idxs[TABLE_CAPACITY];
+    size_t num_due = bmp280_table_collect_due(&table, 0, idxs, TABLE_CAPACITY);
+    CHECK_EQUAL(TABLE_NUM_SENSORS, num_due);
+    for (size_t i = 0; i < num_due; i++) {
+        uint8_t rc = bmp280_read_meas_forced_mode(bmp280_table_inst(&table, idxs[i]), BMP280_MEAS_TYPE_TEMP_AND_PRES,
+                                                  10, &table_meas[idxs[i]], table_read_complete_cb,
+                                                  (void *)(uintptr_t)idxs[i]);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    }
+    sim_run();
+    for (size_t i = 0; i < TABLE_NUM_SENSORS; i++) {
+        int32_t t_fine;
+        driver_meas[i].temperature = bmp280_compensate_temp(&arr_calib_temp[i], sim_devs[i].temp_raw, &t_fine);
+        driver_meas[i].pressure = bmp280_compensate_pres(&arr_calib_pres[i], sim_devs[i].pres_raw, t_fine);
+    }
+    /* The sweep must not compensate what the driver already has, so it cannot depend on the calibration values */
+    memset(arr_calib_temp, 0, sizeof(arr_calib_temp));
+    memset(arr_calib_pres, 0, sizeof(arr_calib_pres));
+
+    CHECK_EQUAL(TABLE_NUM_SENSORS, bmp280_table_compensate(&table, table_meas));
+    CHECK_EQUAL(2508, table_meas[0].temperature);
+    CHECK_EQUAL(25767233, table_meas[0].pressure);
+    for (size_t i = 0; i < TABLE_NUM_SENSORS; i++) {
+        CHECK_EQUAL(driver_meas[i].temperature, table_meas[i].temperature);
+        CHECK_EQUAL(driver_meas[i].pressure, table_meas[i].pressure);
+    }
+    /* Measurements are collected once */
+    CHECK_EQUAL(0, bmp280_table_compensate(&table, table_meas));
+    /* No longer busy */
+    CHECK_EQUAL(TABLE_NUM_SENSORS, bmp280_table_collect_due(&table, 50, idxs, TABLE_CAPACITY));
+}
+
+TEST(BMP280Table, SetFrameFromBackend)
+{
+    init_sensors();
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_table_add(&table, insts[0], 10, 0, NULL));
+    size_t idx;
+    CHECK_EQUAL(1, bmp280_table_collect_due(&table, 0, &idx, 1));
+
+    bmp280_table_set_frame(&table, idx, sim_fixture_data_regs);
+    CHECK_EQUAL(519888, arr_temp_raw[0]);
+    CHECK_EQUAL(415148, arr_pres_raw[0]);
+    CHECK_EQUAL(1, bmp280_table_compensate(&table, table_meas));
+    CHECK_EQUAL(2508, table_meas[0].temperature);
+    CHECK_EQUAL(25767233, table_meas[0].pressure);
+}
+
+/** What a scheduler without the table keeps per sensor: the instance and its schedule, side by side. */
+struct AosSensor {
+    struct BMP280Struct inst;
+    uint32_t next_due_ms;
+    uint32_t period_ms;
+    int32_t temp_raw;
+    int32_t pres_raw;
+};
+
+TEST(BMP280Table, DueScanMatchesScanningInstances)
+{
+    const size_t num_sensors = 1000;
+    const uint32_t num_ticks = 1000;
+    init_sensors();
+
+    std::vector<BMP280> big_insts(num_sensors);
+    std::vector<uint8_t> big_state(num_sensors);
+    std::vector<uint32_t> big_next_due_ms(num_sensors);
+    std::vector<uint32_t> big_period_ms(num_sensors);
+    std::vector<BMP280CalibTemp> big_calib_temp(num_sensors);
+    std::vector<BMP280CalibPres> big_calib_pres(num_sensors);
+    std::vector<int32_t> big_temp_raw(num_sensors);
+    std::vector<int32_t> big_pres_raw(num_sensors);
+    std::vector<BMP280Meas> big_meas(num_sensors);
+    std::vector<size_t> idxs(num_sensors);
+    BMP280TableArrays big_arrays = {
+        .insts = big_insts.data(),
+        .state = big_state.data(),
+        .next_due_ms = big_next_due_ms.data(),
+        .period_ms = big_period_ms.data(),
+        .calib_temp = big_calib_temp.data(),
+        .calib_pres = big_calib_pres.data(),
+        .temp_raw = big_temp_raw.data(),
+        .pres_raw = big_pres_raw.data(),
+        .capacity = num_sensors,
+    };
+    BMP280Table big_table;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_table_init(&big_table, &big_arrays));
+    std::vector<AosSensor> aos(num_sensors);
+    for (size_t i = 0; i < num_sensors; i++) {
+        /* Periods of 100 ms, phases spread evenly: 1% of the sensors is due every ms */
+        uint32_t first_due_ms = (uint32_t)(i % 100);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_table_add(&big_table, insts[i % TABLE_NUM_SENSORS], 100,
+                                                            first_due_ms, NULL));
+        aos[i].inst = *insts[i % TABLE_NUM_SENSORS];
+        aos[i].next_due_ms = first_due_ms;
+        aos[i].period_ms = 100;
+    }
+
+    size_t total_table = 0;
+    for (uint32_t now_ms = 0; now_ms < num_ticks; now_ms++) {
+        size_t num_due = bmp280_table_collect_due(&big_table, now_ms, idxs.data(), num_sensors);
+        for (size_t i = 0; i < num_due; i++) {
+            bmp280_table_set_frame(&big_table, idxs[i], sim_fixture_data_regs);
+        }
+        total_table += num_due;
+    }
+
+    size_t total_aos = 0;
+    for (uint32_t now_ms = 0; now_ms < num_ticks; now_ms++) {
+        size_t num_due = 0;
+        for (size_t i = 0; i < num_sensors; i++) {
+            AosSensor *s = &aos[i];
+            if (s->inst.seq_in_progress || (int32_t)(now_ms - s->next_due_ms) < 0) {
+                continue;
+            }
+            s->next_due_ms += s->period_ms;
+            idxs[num_due++] = i;
+        }
+        for (size_t i = 0; i < num_due; i++) {
+            aos[idxs[i]].temp_raw = 519888;
+            aos[idxs[i]].pres_raw = 415148;
+        }
+        total_aos += num_due;
+    }
+
+    /* Every sensor is due once every 100 ticks */
+    CHECK_EQUAL(num_sensors * num_ticks / 100, total_table);
+    CHECK_EQUAL(total_table, total_aos);
+
+    size_t num_compensated = bmp280_table_compensate(&big_table, big_meas.data());
+    CHECK_EQUAL(num_sensors, num_compensated);
+    CHECK_EQUAL(2508, big_meas[num_sensors - 1].temperature);
+    CHECK_EQUAL(25767233, big_meas[num_sensors - 1].pressure);
+}
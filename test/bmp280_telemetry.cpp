@@ -0,0 +1,279 @@
+#include <string.h>
+#include <vector>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280_telemetry.h"
+
+typedef struct {
+    uint32_t sensor_id;
+    uint32_t timestamp_ms;
+    BMP280Meas meas;
+} TelemetryRecord;
+
+static std::vector<TelemetryRecord> decoded;
+static BMP280TelemetryEncoder enc;
+static uint8_t frame[BMP280_TELEMETRY_MAX_FRAME_SIZE];
+
+#define TELEMETRY_NUM_RINGS 8
+#define TELEMETRY_RING_CAPACITY 4
+static BMP280TelemetrySensorRing rings[TELEMETRY_NUM_RINGS];
+static BMP280TelemetrySample samples[TELEMETRY_NUM_RINGS * TELEMETRY_RING_CAPACITY];
+static BMP280TelemetryCollector coll;
+
+static void record_cb(uint32_t sensor_id, uint32_t timestamp_ms, const BMP280Meas *meas, void *user_data)
+{
+    (void)user_data;
+    TelemetryRecord record = {sensor_id, timestamp_ms, *meas};
+    decoded.push_back(record);
+}
+
+// clang-format off
+TEST_GROUP(BMP280Telemetry){
+    void setup() {
+        decoded.clear();
+        uint8_t rc = bmp280_telemetry_encoder_init(&enc, 7, 100);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+        rc = bmp280_telemetry_collector_init(&coll, rings, TELEMETRY_NUM_RINGS, samples, TELEMETRY_RING_CAPACITY);
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    }
+};
+// clang-format on
+
+static void add_record(uint32_t sensor_id, uint32_t timestamp_ms, int32_t temperature, uint32_t pressure)
+{
+    BMP280Meas meas = {.temperature = temperature, .pressure = pressure};
+    uint8_t rc = bmp280_telemetry_encoder_add(&enc, sensor_id, timestamp_ms, &meas);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+}
+
+static size_t finish_frame()
+{
+    size_t len = bmp280_telemetry_encoder_finish(&enc, frame, sizeof(frame));
+    CHECK(len > 0);
+    return len;
+}
+
+TEST(BMP280Telemetry, InitNull)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_telemetry_encoder_init(NULL, 7, 100));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG,
+                bmp280_telemetry_collector_init(&coll, rings, TELEMETRY_NUM_RINGS, samples, 3));
+}
+
+TEST(BMP280Telemetry, RoundTripPreservesRecordsInOrder)
+{
+    /* Negative temperatures, pressure wraparound, timestamps going backwards and wrapping around */
+    add_record(0xDEADBEEF, 0xFFFFFFF0U, 2508, 25767233);
+    add_record(42, 0xFFFFFFF5U, -4012, 0xFFFFFFFFU);
+    add_record(0xDEADBEEF, 0xFFFFFFF2U, 2510, 25767100);
+    add_record(42, 5, -4013, 3);
+    size_t len = finish_frame();
+
+    BMP280TelemetryFrameInfo info;
+    uint8_t rc = bmp280_telemetry_decode(frame, len, &info, record_cb, NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, rc);
+    CHECK_EQUAL(7, info.source_id);
+    CHECK_EQUAL(100, info.seq);
+    CHECK_EQUAL(4, info.num_records);
+    CHECK_EQUAL(4, decoded.size());
+    CHECK_EQUAL(0xDEADBEEF, decoded[0].sensor_id);
+    CHECK_EQUAL(0xFFFFFFF0U, decoded[0].timestamp_ms);
+    CHECK_EQUAL(2508, decoded[0].meas.temperature);
+    CHECK_EQUAL(25767233, decoded[0].meas.pressure);
+    CHECK_EQUAL(42, decoded[1].sensor_id);
+    CHECK_EQUAL(-4012, decoded[1].meas.temperature);
+    CHECK_EQUAL(0xFFFFFFFFU, decoded[1].meas.pressure);
+    CHECK_EQUAL(0xFFFFFFF2U, decoded[2].timestamp_ms);
+    CHECK_EQUAL(25767100, decoded[2].meas.pressure);
+    CHECK_EQUAL(5, decoded[3].timestamp_ms);
+    CHECK_EQUAL(-4013, decoded[3].meas.temperature);
+    CHECK_EQUAL(3, decoded[3].meas.pressure);
+}
+
+TEST(BMP280Telemetry, SlowlyChangingRecordsAreCompact)
+{
+    for (uint32_t i = 0; i < 100; i++) {
+        add_record(1000 + (i % 4), 20 * i, 2500 + (int32_t)(i % 3), 25767233 + 100 * (i % 2));
+    }
+    size_t len = finish_frame();
+
+    /* Dictionary with 4 sensor ids */
+    CHECK_EQUAL(4, frame[3]);
+    /* Dictionary index, 1-byte timestamp delta, 1-byte temperature delta, 2-byte pressure delta. The first record of
+     * every sensor has full values. */
+    CHECK(len <= BMP280_TELEMETRY_HEADER_SIZE + 4 * 4 + 4 * 12 + 96 * 5);
+}
+
+TEST(BMP280Telemetry, AddReturnsNoMemWhenFrameIsFull)
+{
+    uint32_t num_added = 0;
+    uint8_t rc;
+    BMP280Meas meas = {.temperature = 2508, .pressure = 25767233};
+    while ((rc = bmp280_telemetry_encoder_add(&enc, 1, num_added, &meas)) == BMP280_RESULT_CODE_OK) {
+        num_added++;
+    }
+    CHECK_EQUAL(BMP280_RESULT_CODE_NO_MEM, rc);
+    CHECK_EQUAL(num_added, bmp280_telemetry_encoder_num_records(&enc));
+    size_t len = finish_frame();
+    CHECK(len <= BMP280_TELEMETRY_MAX_FRAME_SIZE);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_telemetry_decode(frame, len, NULL, record_cb, NULL));
+    CHECK_EQUAL(num_added, decoded.size());
+
+    /* The next frame starts empty, with the next sequence number */
+    add_record(1, num_added, 2508, 25767233);
+    len = finish_frame();
+    BMP280TelemetryFrameInfo info;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_telemetry_decode(frame, len, &info, NULL, NULL));
+    CHECK_EQUAL(1, info.num_records);
+    CHECK_EQUAL(101, info.seq);
+}
+
+TEST(BMP280Telemetry, AddReturnsNoMemWhenDictionaryIsFull)
+{
+    for (uint32_t i = 0; i < BMP280_TELEMETRY_MAX_SENSORS_PER_FRAME; i++) {
+        add_record(i, 0, 2508, 25767233);
+    }
+    BMP280Meas meas = {.temperature = 2508, .pressure = 25767233};
+    CHECK_EQUAL(BMP280_RESULT_CODE_NO_MEM,
+                bmp280_telemetry_encoder_add(&enc, BMP280_TELEMETRY_MAX_SENSORS_PER_FRAME, 0, &meas));
+    /* Sensors that are already in the dictionary can still be added */
+    add_record(3, 1, 2509, 25767233);
+}
+
+TEST(BMP280Telemetry, FinishWithoutRecordsReturnsZero)
+{
+    CHECK_EQUAL(0, bmp280_telemetry_encoder_finish(&enc, frame, sizeof(frame)));
+    add_record(1, 0, 2508, 25767233);
+    /* Too small buffer keeps the frame */
+    CHECK_EQUAL(0, bmp280_telemetry_encoder_finish(&enc, frame, BMP280_TELEMETRY_HEADER_SIZE));
+    CHECK_EQUAL(1, bmp280_telemetry_encoder_num_records(&enc));
+}
+
+TEST(BMP280Telemetry, DecodeRejectsMalformedFrames)
+{
+    add_record(1, 0, 2508, 25767233);
+    add_record(2, 10, 2508, 25767233);
+    size_t len = finish_frame();
+
+    /* Every truncation */
+    for (size_t i = 0; i < len; i++) {
+        CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_telemetry_decode(frame, i, NULL, record_cb, NULL));
+    }
+    /* Trailing garbage */
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_telemetry_decode(frame, len + 1, NULL, record_cb, NULL));
+    /* Dictionary index out of range */
+    uint8_t bad[BMP280_TELEMETRY_MAX_FRAME_SIZE];
+    memcpy(bad, frame, len);
+    bad[BMP280_TELEMETRY_HEADER_SIZE + 2 * 4] = 2;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_telemetry_decode(bad, len, NULL, record_cb, NULL));
+    /* Wrong magic */
+    memcpy(bad, frame, len);
+    bad[0] = 0;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_telemetry_decode(bad, len, NULL, record_cb, NULL));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_telemetry_decode(NULL, len, NULL, record_cb, NULL));
+
+    CHECK_EQUAL(0, decoded.size());
+}
+
+TEST(BMP280Telemetry, CollectorKeepsLatestSamplesPerSensor)
+{
+    for (uint32_t i = 0; i < 6; i++) {
+        add_record(11, i, 2500 + (int32_t)i, 25767233);
+        add_record(22, i, -100 - (int32_t)i, 25767233);
+    }
+    size_t len = finish_frame();
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_telemetry_collector_push_frame(&coll, frame, len));
+
+    CHECK_EQUAL(2, coll.num_sensors);
+    CHECK_EQUAL(12, coll.num_samples);
+    const BMP280TelemetrySensorRing *ring = bmp280_telemetry_collector_find(&coll, 11);
+    CHECK(ring != NULL);
+    CHECK_EQUAL(TELEMETRY_RING_CAPACITY, bmp280_telemetry_ring_num_samples(&coll, ring));
+    BMP280TelemetrySample sample;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_telemetry_ring_get(&coll, ring, 0, &sample));
+    CHECK_EQUAL(5, sample.timestamp_ms);
+    CHECK_EQUAL(2505, sample.meas.temperature);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_telemetry_ring_get(&coll, ring, 3, &sample));
+    CHECK_EQUAL(2, sample.timestamp_ms);
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_telemetry_ring_get(&coll, ring, 4, &sample));
+
+    ring = bmp280_telemetry_collector_find(&coll, 22);
+    CHECK(ring != NULL);
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_telemetry_ring_get(&coll, ring, 0, &sample));
+    CHECK_EQUAL(-105, sample.meas.temperature);
+    POINTERS_EQUAL(NULL, bmp280_telemetry_collector_find(&coll, 33));
+}
+
+TEST(BMP280Telemetry, CollectorCountsLostAndLateFrames)
+{
+    std::vector<std::vector<uint8_t>> frames;
+    for (uint32_t i = 0; i < 5; i++) {
+        add_record(1, i, 2508, 25767233);
+        size_t len = finish_frame();
+        frames.push_back(std::vector<uint8_t>(frame, frame + len));
+    }
+
+    /* Frames 0, 3 and 4 arrive, then frame 1 arrives late, frame 2 never arrives */
+    const size_t order[] = {0, 3, 4, 1};
+    for (size_t i = 0; i < 4; i++) {
+        const std::vector<uint8_t> &f = frames[order[i]];
+        CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_telemetry_collector_push_frame(&coll, f.data(), f.size()));
+    }
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_telemetry_collector_push_frame(&coll, frames[2].data(), 3));
+
+    CHECK_EQUAL(4, coll.num_frames);
+    CHECK_EQUAL(2, coll.num_lost_frames);
+    CHECK_EQUAL(1, coll.num_late_frames);
+    CHECK_EQUAL(1, coll.num_bad_frames);
+}
+
+static void push_frame()
+{
+    add_record(1, 0, 2508, 25767233);
+    size_t len = finish_frame();
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_telemetry_collector_push_frame(&coll, frame, len));
+}
+
+TEST(BMP280Telemetry, CollectorResyncsToRestartedSource)
+{
+    /* Frames 100 to 199 */
+    for (uint32_t i = 0; i < 100; i++) {
+        push_frame();
+    }
+
+    /* Within the reorder window */
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_telemetry_encoder_init(&enc, 7, 199 - BMP280_TELEMETRY_REORDER_WINDOW));
+    push_frame();
+    CHECK_EQUAL(1, coll.num_late_frames);
+    CHECK_EQUAL(0, coll.num_resyncs);
+
+    /* The source reboots and starts from 0 again, then frame 2 gets lost */
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_telemetry_encoder_init(&enc, 7, 0));
+    push_frame();
+    push_frame();
+    add_record(1, 0, 2508, 25767233);
+    finish_frame();
+    push_frame();
+    push_frame();
+
+    CHECK_EQUAL(1, coll.num_resyncs);
+    CHECK_EQUAL(1, coll.num_late_frames);
+    CHECK_EQUAL(1, coll.num_lost_frames);
+    CHECK_EQUAL(105, coll.num_frames);
+}
+
+TEST(BMP280Telemetry, CollectorDropsSamplesOfNewSensorsWhenRingsAreUsed)
+{
+    for (uint32_t i = 0; i < TELEMETRY_NUM_RINGS + 2; i++) {
+        add_record(i * 977, 0, 2508, 25767233);
+    }
+    size_t len = finish_frame();
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_telemetry_collector_push_frame(&coll, frame, len));
+
+    CHECK_EQUAL(TELEMETRY_NUM_RINGS, coll.num_sensors);
+    CHECK_EQUAL(2, coll.num_dropped_samples);
+    for (uint32_t i = 0; i < TELEMETRY_NUM_RINGS; i++) {
+        CHECK(bmp280_telemetry_collector_find(&coll, i * 977) != NULL);
+    }
+}
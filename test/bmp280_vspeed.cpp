@@ -0,0 +1,233 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include "CppUTest/TestHarness.h"
+
+#include "bmp280_vspeed.h"
+
+/* 15 degC */
+#define VSPEED_TEMPERATURE 1500
+/* Scale height at VSPEED_TEMPERATURE in m */
+#define VSPEED_SCALE_HEIGHT_M (29.271 * 288.15)
+#define VSPEED_SEA_LEVEL_PA 101325.0
+/* 25 Hz */
+#define VSPEED_PERIOD_MS 40
+
+/* Q24.8 pressure at altitude_m above sea level */
+static uint32_t pressure_at(double altitude_m)
+{
+    return (uint32_t)lround(VSPEED_SEA_LEVEL_PA * exp(-altitude_m / VSPEED_SCALE_HEIGHT_M) * 256.0);
+}
+
+/* Pseudo-random noise in [-amplitude, amplitude] Q24.8 Pa, reproducible across runs */
+static int32_t noise(uint32_t *state, double amplitude_pa)
+{
+    *state = *state * 1664525U + 1013904223U;
+    int32_t amplitude = (int32_t)(amplitude_pa * 256);
+    return (int32_t)((*state >> 8) % (uint32_t)(2 * amplitude + 1)) - amplitude;
+}
+
+/* Steady-state Kalman gains in Q16 for the tracking index lambda */
+static void kalman_gains(double lambda, uint32_t *alpha, uint32_t *beta)
+{
+    double r = (4 + lambda - sqrt(8 * lambda + lambda * lambda)) / 4;
+    double a = 1 - r * r;
+    double b = 2 * (2 - a) - 4 * sqrt(1 - a);
+    *alpha = (uint32_t)lround(a * 65536);
+    *beta = (uint32_t)lround(b * 65536);
+}
+
+// clang-format off
+TEST_GROUP(BMP280VSpeed)
+{
+    BMP280VSpeedCfg cfg;
+    BMP280VSpeed est;
+    uint32_t timestamp_ms;
+
+    void setup()
+    {
+        /* Pressure noise of about 1.2 Pa RMS, vertical acceleration of about 1 m/s^2 */
+        kalman_gains(12.0 * 0.04 * 0.04 / 1.2, &cfg.alpha, &cfg.beta);
+        cfg.max_gap_ms = 1000;
+        timestamp_ms = 0;
+    }
+
+    void add(uint32_t pressure, uint32_t dt_ms = VSPEED_PERIOD_MS)
+    {
+        BMP280Meas meas = {VSPEED_TEMPERATURE, pressure};
+        timestamp_ms += dt_ms;
+        bmp280_vspeed_update(&est, timestamp_ms, &meas);
+    }
+};
+// clang-format on
+
+TEST(BMP280VSpeed, InitRejectsInvalidCfg)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_vspeed_init(NULL, &cfg));
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_vspeed_init(&est, NULL));
+
+    BMP280VSpeedCfg bad = cfg;
+    bad.alpha = 0;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_vspeed_init(&est, &bad));
+    bad.alpha = 65537;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_vspeed_init(&est, &bad));
+    bad = cfg;
+    bad.beta = 0;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_vspeed_init(&est, &bad));
+    /* Unstable: 4 - 2 * alpha - beta = 0 */
+    bad.alpha = 65536;
+    bad.beta = 2 * 65536;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_vspeed_init(&est, &bad));
+    bad = cfg;
+    bad.max_gap_ms = 0;
+    CHECK_EQUAL(BMP280_RESULT_CODE_INVAL_ARG, bmp280_vspeed_init(&est, &bad));
+}
+
+TEST(BMP280VSpeed, ZeroBeforeSamples)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_vspeed_init(&est, &cfg));
+    CHECK_EQUAL(0, bmp280_vspeed_altitude_mm(&est));
+    CHECK_EQUAL(0, bmp280_vspeed_speed_mm_s(&est));
+}
+
+TEST(BMP280VSpeed, ConstantPressureStaysAtZero)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_vspeed_init(&est, &cfg));
+    for (int i = 0; i < 1000; i++) {
+        add(pressure_at(250));
+    }
+    CHECK_EQUAL(0, bmp280_vspeed_altitude_mm(&est));
+    CHECK_EQUAL(0, bmp280_vspeed_speed_mm_s(&est));
+}
+
+TEST(BMP280VSpeed, AltitudeMatchesHypsometricEquation)
+{
+    /* Unfiltered, so that the altitude is that of the latest sample */
+    cfg.alpha = 65536;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_vspeed_init(&est, &cfg));
+    add(pressure_at(0));
+
+    const double altitudes_m[] = {0.5, 3.0, 100.0, 1000.0, -400.0};
+    for (size_t i = 0; i < sizeof(altitudes_m) / sizeof(altitudes_m[0]); i++) {
+        add(pressure_at(altitudes_m[i]), 2000);
+        /* Series truncation error is 3 mm at 1000 m, quantization of Q24.8 pressure 0.3 mm */
+        CHECK_TRUE(labs((long)bmp280_vspeed_altitude_mm(&est) - lround(altitudes_m[i] * 1000)) <= 3);
+    }
+
+    /* Truncation error grows with the fifth power of the altitude difference */
+    add(pressure_at(5000), 2000);
+    CHECK_TRUE(labs((long)bmp280_vspeed_altitude_mm(&est) - 5000000) < 10000);
+}
+
+TEST(BMP280VSpeed, AltitudeIsRelativeToFirstSample)
+{
+    cfg.alpha = 65536;
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_vspeed_init(&est, &cfg));
+    add(pressure_at(1500));
+    add(pressure_at(1510), 2000);
+    /* Within 1 mm of the exact difference */
+    CHECK_TRUE(labs((long)bmp280_vspeed_altitude_mm(&est) - 10000) <= 1);
+}
+
+TEST(BMP280VSpeed, TracksClimbWithLessNoiseThanDifferencing)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_vspeed_init(&est, &cfg));
+    uint32_t state = 1;
+    double altitude_m = 0;
+    uint32_t prev_pressure = 0;
+    double sq_err_filter = 0;
+    double sq_err_naive = 0;
+    int num_err = 0;
+    int settle_samples = -1;
+
+    /* 20 s at rest, then a lift ride of 2 m/s for 60 s */
+    for (int i = 0; i < 80 * 25; i++) {
+        double speed_m_s = (i < 20 * 25) ? 0.0 : 2.0;
+        altitude_m += speed_m_s * VSPEED_PERIOD_MS / 1000.0;
+        uint32_t pressure = (uint32_t)((int32_t)pressure_at(altitude_m) + noise(&state, 2.0));
+        add(pressure);
+
+        int32_t speed_mm_s = bmp280_vspeed_speed_mm_s(&est);
+        if (speed_m_s > 0 && settle_samples < 0 && abs(speed_mm_s - 2000) < 200) {
+            settle_samples = i - 20 * 25;
+        }
+        if (i > 0 && (i < 20 * 25 - 1 || i >= 25 * 25)) {
+            /* Naive differencing of successive samples, converted with the local scale height */
+            double dp_pa = ((double)pressure - (double)prev_pressure) / 256.0;
+            double naive_m_s = -dp_pa / (VSPEED_PERIOD_MS / 1000.0) * VSPEED_SCALE_HEIGHT_M / (pressure / 256.0);
+            sq_err_naive += (naive_m_s - speed_m_s) * (naive_m_s - speed_m_s);
+            double err_m_s = speed_mm_s / 1000.0 - speed_m_s;
+            sq_err_filter += err_m_s * err_m_s;
+            num_err++;
+        }
+        prev_pressure = pressure;
+    }
+
+    double rms_filter = sqrt(sq_err_filter / num_err);
+    double rms_naive = sqrt(sq_err_naive / num_err);
+    CHECK_TRUE(rms_filter < rms_naive / 10);
+    CHECK_TRUE(rms_filter < 0.25);
+    CHECK_TRUE(settle_samples >= 0 && settle_samples < 5 * 25);
+    /* 120 m climbed */
+    CHECK_TRUE(labs((long)bmp280_vspeed_altitude_mm(&est) - 120000) < 500);
+}
+
+TEST(BMP280VSpeed, IrregularTimestamps)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_vspeed_init(&est, &cfg));
+    uint32_t state = 2;
+    double altitude_m = 0;
+    double t_s = 0;
+    /* Descent of 1 m/s, samples between 20 ms and 80 ms apart */
+    for (int i = 0; i < 2000; i++) {
+        state = state * 1664525U + 1013904223U;
+        uint32_t dt_ms = 20 + (state >> 8) % 61;
+        t_s += dt_ms / 1000.0;
+        altitude_m = -1.0 * t_s;
+        add(pressure_at(altitude_m), dt_ms);
+    }
+    CHECK_TRUE(abs(bmp280_vspeed_speed_mm_s(&est) + 1000) < 50);
+    CHECK_TRUE(labs((long)bmp280_vspeed_altitude_mm(&est) - lround(altitude_m * 1000)) < 100);
+}
+
+TEST(BMP280VSpeed, TimestampWraparound)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_vspeed_init(&est, &cfg));
+    timestamp_ms = UINT32_MAX - 100 * VSPEED_PERIOD_MS;
+    double altitude_m = 0;
+    for (int i = 0; i < 500; i++) {
+        altitude_m += 0.5 * VSPEED_PERIOD_MS / 1000.0;
+        add(pressure_at(altitude_m));
+    }
+    CHECK_TRUE(abs(bmp280_vspeed_speed_mm_s(&est) - 500) < 20);
+}
+
+TEST(BMP280VSpeed, GapRestartsWithZeroSpeed)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_vspeed_init(&est, &cfg));
+    add(pressure_at(0));
+    double altitude_m = 0;
+    for (int i = 0; i < 500; i++) {
+        altitude_m += 1.0 * VSPEED_PERIOD_MS / 1000.0;
+        add(pressure_at(altitude_m));
+    }
+    CHECK_TRUE(bmp280_vspeed_speed_mm_s(&est) > 900);
+
+    add(pressure_at(50), 5000);
+    CHECK_EQUAL(0, bmp280_vspeed_speed_mm_s(&est));
+    CHECK_TRUE(labs((long)bmp280_vspeed_altitude_mm(&est) - 50000) <= 1);
+}
+
+TEST(BMP280VSpeed, SameTimestampKeepsSpeed)
+{
+    CHECK_EQUAL(BMP280_RESULT_CODE_OK, bmp280_vspeed_init(&est, &cfg));
+    double altitude_m = 0;
+    for (int i = 0; i < 500; i++) {
+        altitude_m += 1.0 * VSPEED_PERIOD_MS / 1000.0;
+        add(pressure_at(altitude_m));
+    }
+    int32_t speed_mm_s = bmp280_vspeed_speed_mm_s(&est);
+    add(pressure_at(altitude_m + 5), 0);
+    /* Only the conversion to mm/s changes slightly with the corrected pressure */
+    CHECK_TRUE(abs(bmp280_vspeed_speed_mm_s(&est) - speed_mm_s) <= 1);
+}
@@ -0,0 +1,21 @@
+#ifndef TEST_FREERTOS_STUB_FREERTOS_H
+#define TEST_FREERTOS_STUB_FREERTOS_H
+
+#include <stdint.h>
+
+/**
+ * @brief Single-threaded stand-in for the FreeRTOS kernel headers, with the subset of the API that
+ * port/freertos/bmp280_freertos.c uses. See task.h.
+ */
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef void *TaskHandle_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFUL)
+#define configTICK_RATE_HZ ((TickType_t)1000)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((uint64_t)(ms) * (uint64_t)configTICK_RATE_HZ) / 1000U))
+
+#endif /* TEST_FREERTOS_STUB_FREERTOS_H */
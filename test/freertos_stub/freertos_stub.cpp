@@ -0,0 +1,102 @@
+#include "CppUTest/TestHarness.h"
+
+#include "task.h"
+
+/* Address of this variable is the handle of the only task */
+static int task;
+
+static TickType_t tick_count;
+static uint32_t notification_value;
+static bool notification_pending;
+static StubFreeRTOSBlockHook block_hook;
+static void *block_hook_user_data;
+static TickType_t last_wait_ticks;
+static uint32_t num_blocks;
+
+void stub_freertos_reset(void)
+{
+    tick_count = 0;
+    notification_value = 0;
+    notification_pending = false;
+    block_hook = NULL;
+    block_hook_user_data = NULL;
+    last_wait_ticks = 0;
+    num_blocks = 0;
+}
+
+void stub_freertos_set_tick_count(TickType_t ticks)
+{
+    tick_count = ticks;
+}
+
+void stub_freertos_set_block_hook(StubFreeRTOSBlockHook hook, void *user_data)
+{
+    block_hook = hook;
+    block_hook_user_data = user_data;
+}
+
+TickType_t stub_freertos_last_wait_ticks(void)
+{
+    return last_wait_ticks;
+}
+
+uint32_t stub_freertos_num_blocks(void)
+{
+    return num_blocks;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return (TaskHandle_t)&task;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return tick_count;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t bits_to_clear_on_entry, uint32_t bits_to_clear_on_exit, uint32_t *value,
+                           TickType_t ticks_to_wait)
+{
+    last_wait_ticks = ticks_to_wait;
+    if (!notification_pending) {
+        notification_value &= ~bits_to_clear_on_entry;
+        num_blocks++;
+        TickType_t elapsed = ticks_to_wait;
+        if (block_hook) {
+            elapsed = block_hook(ticks_to_wait, block_hook_user_data);
+        }
+        if (!notification_pending) {
+            /* Nothing would ever wake the only task */
+            CHECK_TRUE(ticks_to_wait != portMAX_DELAY);
+            tick_count += ticks_to_wait;
+            return pdFALSE;
+        }
+        tick_count += elapsed;
+    }
+    if (value) {
+        *value = notification_value;
+    }
+    notification_value &= ~bits_to_clear_on_exit;
+    notification_pending = false;
+    return pdTRUE;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task_to_notify, uint32_t value, eNotifyAction action)
+{
+    POINTERS_EQUAL(&task, task_to_notify);
+    CHECK_EQUAL(eSetBits, action);
+    notification_value |= value;
+    notification_pending = true;
+    return pdTRUE;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task_to_notify, uint32_t value, eNotifyAction action,
+                              BaseType_t *higher_priority_task_woken)
+{
+    /* The interrupted task is never the driver task, so the driver task always has to run next */
+    if (higher_priority_task_woken) {
+        *higher_priority_task_woken = pdTRUE;
+    }
+    return xTaskNotify(task_to_notify, value, action);
+}
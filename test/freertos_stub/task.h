@@ -0,0 +1,62 @@
+#ifndef TEST_FREERTOS_STUB_TASK_H
+#define TEST_FREERTOS_STUB_TASK_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+
+/**
+ * @brief Task API of the stub kernel.
+ *
+ * There is one task, the driver task that runs the test. The tick count only moves when the test advances it, or when
+ * the task blocks in @ref xTaskNotifyWait: a wait without a pending notification returns after its full timeout, with
+ * the tick count advanced by that timeout. A notification that arrives while the task is blocked is simulated with
+ * @ref stub_freertos_set_block_hook.
+ */
+
+typedef enum {
+    eNoAction = 0,
+    eSetBits,
+    eIncrement,
+    eSetValueWithOverwrite,
+    eSetValueWithoutOverwrite,
+} eNotifyAction;
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+TickType_t xTaskGetTickCount(void);
+BaseType_t xTaskNotifyWait(uint32_t bits_to_clear_on_entry, uint32_t bits_to_clear_on_exit, uint32_t *value,
+                           TickType_t ticks_to_wait);
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action);
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action,
+                              BaseType_t *higher_priority_task_woken);
+
+/**
+ * @brief Executed when the task blocks without a pending notification.
+ *
+ * @param[in] ticks_to_wait Timeout of the wait.
+ * @param[in] user_data User data passed to @ref stub_freertos_set_block_hook.
+ *
+ * @return Number of ticks after which the hook "fires", at most @p ticks_to_wait. If the hook sent a notification, the
+ * wait returns after that many ticks, otherwise after its full timeout.
+ */
+typedef TickType_t (*StubFreeRTOSBlockHook)(TickType_t ticks_to_wait, void *user_data);
+
+/** Tick count 0, no pending notification, no block hook, statistics cleared. */
+void stub_freertos_reset(void);
+void stub_freertos_set_tick_count(TickType_t ticks);
+void stub_freertos_set_block_hook(StubFreeRTOSBlockHook hook, void *user_data);
+/** Timeout passed to the latest @ref xTaskNotifyWait. */
+TickType_t stub_freertos_last_wait_ticks(void);
+/** Number of @ref xTaskNotifyWait calls that had to block, because no notification was pending. */
+uint32_t stub_freertos_num_blocks(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEST_FREERTOS_STUB_TASK_H */
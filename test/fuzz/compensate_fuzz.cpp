@@ -0,0 +1,680 @@
+/**
+ * @brief Differential fuzzing harness for compensation backends.
+ *
+ * Every backend listed in the backends table must produce results that are bit-exact with the reference
+ * implementation (bmp280_compensate_temp and bmp280_compensate_pres). The harness compares all backends against the
+ * reference over a corpus of edge-case and random calibration sets with 20-bit raw values, then measures the speed of
+ * every backend over the same corpus.
+ *
+ * Standalone mode (default): ./compensate_fuzz [num_random_calib_sets] [seed]
+ * libFuzzer mode (BMP280_LIBFUZZER defined): every input is 24 bytes of calibration registers 0x88...0x9F followed by
+ * 3 bytes of raw pressure and 3 bytes of raw temperature registers, in the same format as the device registers.
+ *
+ * The reference implementation uses 32-bit and 64-bit signed arithmetic that overflows for some combinations of
+ * calibration values and raw values that do not occur on real devices. Such inputs are detected with 128-bit shadow
+ * arithmetic and skipped, because the result of the reference implementation is undefined for them.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "bmp280_defs.h"
+#include "bmp280_compensate.h"
+#include "sim_fixture.h"
+
+/** Number of raw samples compensated with each calibration set. */
+#define FUZZ_SAMPLES_PER_CALIB 256
+/** Number of times the corpus is compensated by each backend when measuring speed. */
+#define FUZZ_NUM_BENCH_ROUNDS 20
+/** Number of frames generated when checking and measuring inverse compensation. */
+#define FUZZ_NUM_INVERSE_FRAMES 1000000
+
+/**
+ * @brief Compensate @p num_samples samples that share the same calibration values.
+ *
+ * @param[in] calib_temp Temperature calibration values.
+ * @param[in] calib_pres Pressure calibration values.
+ * @param[in] temp_raw Raw temperature values.
+ * @param[in] pres_raw Raw pressure values.
+ * @param[out] meas Results.
+ * @param[in] num_samples Number of elements in @p temp_raw, @p pres_raw and @p meas.
+ */
+typedef void (*CompensateBackendFn)(const BMP280CalibTemp *calib_temp, const BMP280CalibPres *calib_pres,
+                                    const int32_t *temp_raw, const int32_t *pres_raw, BMP280Meas *meas,
+                                    size_t num_samples);
+
+/**
+ * @brief Prepare backend state that depends only on the calibration values, e.g. lookup tables.
+ *
+ * Called once per calibration set before the backend function is called for that set. Not included in the measured
+ * time, the same way a driver instance prepares such state once in bmp280_init_meas.
+ */
+typedef void (*CompensateBackendPrepareFn)(const BMP280CalibTemp *calib_temp, const BMP280CalibPres *calib_pres);
+
+typedef struct {
+    const char *name;
+    /** Can be NULL if the backend does not need any preparation. */
+    CompensateBackendPrepareFn prepare;
+    CompensateBackendFn fn;
+} CompensateBackend;
+
+typedef struct {
+    BMP280CalibTemp calib_temp;
+    BMP280CalibPres calib_pres;
+    std::vector<int32_t> temp_raw;
+    std::vector<int32_t> pres_raw;
+} CalibCorpus;
+
+static void compensate_reference(const BMP280CalibTemp *calib_temp, const BMP280CalibPres *calib_pres,
+
+                                 const int32_t *temp_raw, const int32_t *pres_raw, BMP280Meas *meas, size_t num_samples)
+{
+    for (size_t i = 0; i < num_samples; i++) {
+        int32_t t_fine;
+        meas[i].temperature = bmp280_compensate_temp(calib_temp, temp_raw[i], &t_fine);
+        meas[i].pressure = bmp280_compensate_pres(calib_pres, pres_raw[i], t_fine);
+    }
+}
+
+static void compensate_pres_coeffs(const BMP280CalibTemp *calib_temp, const BMP280CalibPres *calib_pres,
+                                   const int32_t *temp_raw, const int32_t *pres_raw, BMP280Meas *meas,
+                                   size_t num_samples)
+{
+    BMP280PresCoeffs coeffs;
+    bool have_coeffs = false;
+    int32_t coeffs_t_fine = 0;
+    for (size_t i = 0; i < num_samples; i++) {
+        int32_t t_fine;
+        meas[i].temperature = bmp280_compensate_temp(calib_temp, temp_raw[i], &t_fine);
+        /* Consecutive samples usually have the same t_fine, reuse the coefficients in that case */
+        if (!have_coeffs || (t_fine != coeffs_t_fine)) {
+            bmp280_compensate_pres_coeffs(calib_pres, t_fine, &coeffs);
+            coeffs_t_fine = t_fine;
+            have_coeffs = true;
+        }
+        meas[i].pressure = bmp280_compensate_pres_with_coeffs(&coeffs, pres_raw[i]);
+    }
+}
+
+/** Temperature lookup table with raw_shift 4 covering T1 * 16 +- 32768, i.e. about +-40 DegC around T1. */
+#define FUZZ_TEMP_LUT_RAW_SHIFT 4
+#define FUZZ_TEMP_LUT_NUM_ENTRIES 4096
+
+static BMP280TempLutEntry temp_lut_entries[FUZZ_TEMP_LUT_NUM_ENTRIES];
+static BMP280TempLut temp_lut;
+
+static bool is_temp_reference_defined(const BMP280CalibTemp *calib_temp, int32_t temp_raw, __int128 *t_fine);
+
+static void prepare_temp_lut(const BMP280CalibTemp *calib_temp, const BMP280CalibPres *calib_pres)
+{
+    (void)calib_pres;
+    int32_t raw_min = (((int32_t)calib_temp->dig_T1) << 4) - (FUZZ_TEMP_LUT_NUM_ENTRIES << FUZZ_TEMP_LUT_RAW_SHIFT) / 2;
+    /* Only build the table if the reference is defined for every entry. Otherwise every sample is calculated. */
+    temp_lut.entries = NULL;
+    for (size_t i = 0; i < FUZZ_TEMP_LUT_NUM_ENTRIES; i++) {
+        __int128 t_fine;
+        if (!is_temp_reference_defined(calib_temp, raw_min + (int32_t)(i << FUZZ_TEMP_LUT_RAW_SHIFT), &t_fine)) {
+            return;
+        }
+    }
+    bmp280_temp_lut_build(&temp_lut, calib_temp, temp_lut_entries, FUZZ_TEMP_LUT_NUM_ENTRIES, raw_min,
+                          FUZZ_TEMP_LUT_RAW_SHIFT);
+}
+
+static void compensate_temp_lut(const BMP280CalibTemp *calib_temp, const BMP280CalibPres *calib_pres,
+
+                                const int32_t *temp_raw, const int32_t *pres_raw, BMP280Meas *meas, size_t num_samples)
+{
+    for (size_t i = 0; i < num_samples; i++) {
+        int32_t t_fine;
+        meas[i].temperature = bmp280_compensate_temp_lut(&temp_lut, calib_temp, temp_raw[i], &t_fine);
+        meas[i].pressure = bmp280_compensate_pres(calib_pres, pres_raw[i], t_fine);
+    }
+}
+
+/** Gather kernel with a single sensor. Across sensors it is checked and measured by check_and_bench_gather. */
+#define FUZZ_GATHER_BATCH 64
+
+static int32_t gather_coeffs[BMP280_CALIB_SOA_NUM_COEFFS];
+static const BMP280CalibSoA gather_soa = {gather_coeffs, 1};
+static const uint32_t gather_idx[FUZZ_GATHER_BATCH] = {0};
+
+static void prepare_gather(const BMP280CalibTemp *calib_temp, const BMP280CalibPres *calib_pres)
+{
+    bmp280_calib_soa_set(&gather_soa, 0, calib_temp, calib_pres);
+}
+
+static void compensate_gather(const BMP280CalibTemp *calib_temp, const BMP280CalibPres *calib_pres,
+
+                              const int32_t *temp_raw, const int32_t *pres_raw, BMP280Meas *meas, size_t num_samples)
+{
+    (void)calib_temp;
+    (void)calib_pres;
+    for (size_t i = 0; i < num_samples; i += FUZZ_GATHER_BATCH) {
+        size_t n = (num_samples - i < FUZZ_GATHER_BATCH) ? num_samples - i : FUZZ_GATHER_BATCH;
+        bmp280_compensate_gather(&gather_soa, gather_idx, &temp_raw[i], &pres_raw[i], &meas[i], n);
+    }
+}
+
+/** All backends that are compared against the reference. The reference itself must be the first entry. */
+static const CompensateBackend backends[] = {
+    {"reference", NULL, compensate_reference},
+    {"pres_coeffs", NULL, compensate_pres_coeffs},
+    {"temp_lut", prepare_temp_lut, compensate_temp_lut},
+    {"gather", prepare_gather, compensate_gather},
+};
+
+#define NUM_BACKENDS (sizeof(backends) / sizeof(backends[0]))
+
+static bool fits_int32(__int128 v)
+{
+    return (v >= INT32_MIN) && (v <= INT32_MAX);
+}
+
+static bool fits_int64(__int128 v)
+{
+    return (v >= INT64_MIN) && (v <= INT64_MAX);
+}
+
+/**
+ * @brief Temperature part of @ref is_reference_defined.
+ *
+ * @param[out] t_fine t_fine of the reference implementation, if it is defined.
+ */
+static bool is_temp_reference_defined(const BMP280CalibTemp *calib_temp, int32_t temp_raw, __int128 *t_fine)
+{
+    __int128 t1 = calib_temp->dig_T1;
+    __int128 d1 = (__int128)(temp_raw >> 3) - (t1 << 1);
+    __int128 prod1 = d1 * calib_temp->dig_T2;
+    __int128 d2 = (__int128)(temp_raw >> 4) - t1;
+    __int128 sq = d2 * d2;
+    if (!fits_int32(prod1) || !fits_int32(sq)) {
+        return false;
+    }
+    __int128 prod2 = (sq >> 12) * calib_temp->dig_T3;
+    if (!fits_int32(prod2)) {
+        return false;
+    }
+    *t_fine = (prod1 >> 11) + (prod2 >> 14);
+    return fits_int32(*t_fine) && fits_int32(*t_fine * 5 + 128);
+}
+
+/**
+ * @brief Check whether the reference implementation stays within its integer types for the given input.
+ *
+ * Repeats every step of bmp280_compensate_temp and bmp280_compensate_pres in 128-bit arithmetic and checks that every
+ * intermediate value fits into the type that the reference implementation uses for it.
+ */
+static bool is_reference_defined(const BMP280CalibTemp *calib_temp, const BMP280CalibPres *calib_pres, int32_t temp_raw,
+                                 int32_t pres_raw)
+{
+    __int128 t_fine;
+    if (!is_temp_reference_defined(calib_temp, temp_raw, &t_fine)) {
+        return false;
+    }
+
+    __int128 var1 = t_fine - 128000;
+    __int128 var2 = var1 * var1 * calib_pres->dig_P6;
+    __int128 p5_term = var1 * calib_pres->dig_P5;
+    if (!fits_int64(var2) || !fits_int64(p5_term) || !fits_int64(p5_term * ((__int128)1 << 17))) {
+        return false;
+    }
+    var2 = var2 + p5_term * ((__int128)1 << 17) + (__int128)calib_pres->dig_P4 * ((__int128)1 << 35);
+    __int128 p3_term = var1 * var1 * calib_pres->dig_P3;
+    __int128 p2_term = var1 * calib_pres->dig_P2 * ((__int128)1 << 12);
+    if (!fits_int64(var2) || !fits_int64(p3_term) || !fits_int64(p2_term)) {
+        return false;
+    }
+    var1 = (p3_term >> 8) + p2_term;
+    __int128 sum = ((__int128)1 << 47) + var1;
+    if (!fits_int64(var1) || !fits_int64(sum) || !fits_int64(sum * calib_pres->dig_P1)) {
+        return false;
+    }
+    var1 = (sum * calib_pres->dig_P1) >> 33;
+    if (var1 == 0) {
+        return true;
+    }
+    __int128 p = 1048576 - (__int128)pres_raw;
+    __int128 num = (p * ((__int128)1 << 31)) - var2;
+    if (!fits_int64(num) || !fits_int64(num * 3125)) {
+        return false;
+    }
+    /* C division truncates towards zero, same as __int128 division */
+    p = (num * 3125) / var1;
+    __int128 p9_term = (__int128)calib_pres->dig_P9 * (p >> 13) * (p >> 13);
+    __int128 p8_term = (__int128)calib_pres->dig_P8 * p;
+    if (!fits_int64(p) || !fits_int64(calib_pres->dig_P9 * (p >> 13)) || !fits_int64(p9_term) ||
+        !fits_int64(p8_term)) {
+        return false;
+    }
+    return fits_int64(p + (p9_term >> 25) + (p8_term >> 19));
+}
+
+static uint16_t le_u16(const uint8_t *bytes)
+{
+    return (uint16_t)((((uint16_t)bytes[1]) << 8) | bytes[0]);
+}
+
+static int16_t le_s16(const uint8_t *bytes)
+{
+    return (int16_t)le_u16(bytes);
+}
+
+/** Convert calibration registers 0x88...0x9F into calibration values, the same way the driver does. */
+static void calib_regs_to_calib(const uint8_t *regs, BMP280CalibTemp *calib_temp, BMP280CalibPres *calib_pres)
+{
+    calib_temp->dig_T1 = le_u16(&regs[0]);
+    calib_temp->dig_T2 = le_s16(&regs[2]);
+    calib_temp->dig_T3 = le_s16(&regs[4]);
+    calib_pres->dig_P1 = le_u16(&regs[6]);
+    calib_pres->dig_P2 = le_s16(&regs[8]);
+    calib_pres->dig_P3 = le_s16(&regs[10]);
+    calib_pres->dig_P4 = le_s16(&regs[12]);
+    calib_pres->dig_P5 = le_s16(&regs[14]);
+    calib_pres->dig_P6 = le_s16(&regs[16]);
+    calib_pres->dig_P7 = le_s16(&regs[18]);
+    calib_pres->dig_P8 = le_s16(&regs[20]);
+    calib_pres->dig_P9 = le_s16(&regs[22]);
+}
+
+static void print_calib(const BMP280CalibTemp *t, const BMP280CalibPres *p)
+{
+    fprintf(stderr, "T1=%u T2=%d T3=%d P1=%u P2=%d P3=%d P4=%d P5=%d P6=%d P7=%d P8=%d P9=%d\n", t->dig_T1, t->dig_T2,
+            t->dig_T3, p->dig_P1, p->dig_P2, p->dig_P3, p->dig_P4, p->dig_P5, p->dig_P6, p->dig_P7, p->dig_P8,
+            p->dig_P9);
+}
+
+/**
+ * @brief Compare all backends against the reference for one calibration set.
+ *
+ * @return size_t Number of mismatching samples.
+ */
+static size_t compare_backends(const CalibCorpus *corpus)
+{
+    size_t n = corpus->temp_raw.size();
+    std::vector<BMP280Meas> expected(n);
+    std::vector<BMP280Meas> actual(n);
+    if (backends[0].prepare) {
+        backends[0].prepare(&corpus->calib_temp, &corpus->calib_pres);
+    }
+    backends[0].fn(&corpus->calib_temp, &corpus->calib_pres, corpus->temp_raw.data(), corpus->pres_raw.data(),
+                   expected.data(), n);
+
+    size_t num_mismatches = 0;
+    for (size_t b = 1; b < NUM_BACKENDS; b++) {
+        if (backends[b].prepare) {
+            backends[b].prepare(&corpus->calib_temp, &corpus->calib_pres);
+        }
+        backends[b].fn(&corpus->calib_temp, &corpus->calib_pres, corpus->temp_raw.data(), corpus->pres_raw.data(),
+                       actual.data(), n);
+        for (size_t i = 0; i < n; i++) {
+            if ((expected[i].temperature != actual[i].temperature) || (expected[i].pressure != actual[i].pressure)) {
+                if (num_mismatches == 0) {
+                    fprintf(stderr, "Backend %s mismatch: temp_raw=%d pres_raw=%d expected %d/%u, got %d/%u\n",
+                            backends[b].name, (int)corpus->temp_raw[i], (int)corpus->pres_raw[i],
+                            (int)expected[i].temperature, (unsigned)expected[i].pressure, (int)actual[i].temperature,
+                            (unsigned)actual[i].pressure);
+                    print_calib(&corpus->calib_temp, &corpus->calib_pres);
+                }
+                num_mismatches++;
+            }
+        }
+    }
+    return num_mismatches;
+}
+
+#ifdef BMP280_LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size < 30) {
+        return 0;
+    }
+    CalibCorpus corpus;
+    calib_regs_to_calib(data, &corpus.calib_temp, &corpus.calib_pres);
+    int32_t pres_raw = bmp280_raw_val_from_regs(&data[24]);
+    int32_t temp_raw = bmp280_raw_val_from_regs(&data[27]);
+    if (!is_reference_defined(&corpus.calib_temp, &corpus.calib_pres, temp_raw, pres_raw)) {
+        return 0;
+    }
+    corpus.temp_raw.push_back(temp_raw);
+    corpus.pres_raw.push_back(pres_raw);
+    if (compare_backends(&corpus) != 0) {
+        abort();
+    }
+    return 0;
+}
+
+#else
+
+static uint64_t rng_state;
+
+static uint64_t rng_next(void)
+{
+    /* xorshift64* */
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+static int32_t rng_raw_20_bit(void)
+{
+    return (int32_t)(rng_next() & 0xFFFFFU);
+}
+
+/**
+ * @brief Fill the corpus of one calibration set with raw values.
+ *
+ * Half of the raw values are spread over the whole 20-bit range, the other half are close to the values that the
+ * calibration set produces around room temperature and sea level pressure. Every other typical raw temperature value
+ * has its 4 LSb cleared, like the results of a device with temperature oversampling x1. The raw limits 0, 0x80000
+ * (skipped measurement) and 0xFFFFF are always included. Inputs for which the reference is undefined are skipped.
+ */
+static void fill_raw_vals(CalibCorpus *corpus)
+{
+    static const int32_t edge_raw_vals[] = {0, 1, 0x7FFFF, 0x80000, 0xFFFFE, 0xFFFFF};
+    for (size_t i = 0; i < sizeof(edge_raw_vals) / sizeof(edge_raw_vals[0]); i++) {
+        for (size_t j = 0; j < sizeof(edge_raw_vals) / sizeof(edge_raw_vals[0]); j++) {
+            if (is_reference_defined(&corpus->calib_temp, &corpus->calib_pres, edge_raw_vals[i], edge_raw_vals[j])) {
+                corpus->temp_raw.push_back(edge_raw_vals[i]);
+                corpus->pres_raw.push_back(edge_raw_vals[j]);
+            }
+        }
+    }
+
+    int32_t typical_temp_raw = ((int32_t)corpus->calib_temp.dig_T1) << 4;
+    size_t max_attempts = 4 * FUZZ_SAMPLES_PER_CALIB;
+    for (size_t attempt = 0; (corpus->temp_raw.size() < FUZZ_SAMPLES_PER_CALIB) && (attempt < max_attempts);
+         attempt++) {
+        int32_t temp_raw, pres_raw;
+        if (attempt % 2) {
+            temp_raw = rng_raw_20_bit();
+            pres_raw = rng_raw_20_bit();
+        } else {
+            temp_raw = (typical_temp_raw + (int32_t)(rng_next() % 65536) - 32768) & 0xFFFFF;
+            if (attempt % 4 == 0) {
+                temp_raw &= ~0xF;
+            }
+            pres_raw = (415148 + (int32_t)(rng_next() % 131072) - 65536) & 0xFFFFF;
+        }
+        if (is_reference_defined(&corpus->calib_temp, &corpus->calib_pres, temp_raw, pres_raw)) {
+            corpus->temp_raw.push_back(temp_raw);
+            corpus->pres_raw.push_back(pres_raw);
+        }
+    }
+}
+
+static void build_corpus(std::vector<CalibCorpus> *corpus, size_t num_random_calib_sets)
+{
+    /* Edge case calibration sets, derived from the datasheet example */
+    const size_t num_edge_cases = 8;
+    for (size_t i = 0; i < num_edge_cases; i++) {
+        CalibCorpus calib;
+        calib_regs_to_calib(sim_fixture_calib_data, &calib.calib_temp, &calib.calib_pres);
+        switch (i) {
+        case 1:
+            /* var1 == 0 in pressure compensation, must return 0 instead of dividing by zero */
+            calib.calib_pres.dig_P1 = 0;
+            break;
+        case 2:
+            calib.calib_pres.dig_P1 = 1;
+            break;
+        case 3:
+            calib.calib_pres.dig_P1 = UINT16_MAX;
+            break;
+        case 4:
+            calib.calib_temp.dig_T2 = INT16_MAX;
+            calib.calib_temp.dig_T3 = INT16_MIN;
+            break;
+        case 5:
+            calib.calib_pres.dig_P7 = INT16_MIN;
+            calib.calib_pres.dig_P8 = INT16_MAX;
+            calib.calib_pres.dig_P9 = INT16_MIN;
+            break;
+        case 6:
+            calib.calib_pres.dig_P4 = INT16_MAX;
+            calib.calib_pres.dig_P6 = INT16_MIN;
+            break;
+        case 7:
+            calib.calib_temp.dig_T1 = 0;
+            break;
+        default:
+            break;
+        }
+        fill_raw_vals(&calib);
+        corpus->push_back(calib);
+    }
+
+    for (size_t i = 0; i < num_random_calib_sets; i++) {
+        CalibCorpus calib;
+        uint8_t regs[24];
+        if (i % 2) {
+            /* Fully random registers */
+            for (size_t j = 0; j < sizeof(regs); j++) {
+                regs[j] = (uint8_t)rng_next();
+            }
+        } else {
+            /* Datasheet registers with random bit flips in the low bytes */
+            memcpy(regs, sim_fixture_calib_data, sizeof(regs));
+            for (size_t j = 0; j < sizeof(regs); j += 2) {
+                regs[j] ^= (uint8_t)rng_next();
+            }
+        }
+        calib_regs_to_calib(regs, &calib.calib_temp, &calib.calib_pres);
+        fill_raw_vals(&calib);
+        if (!calib.temp_raw.empty()) {
+            corpus->push_back(calib);
+        }
+    }
+}
+
+/**
+ * @brief Measure compensation speed of one backend over the whole corpus.
+ *
+ * Every calibration set is prepared once and then compensated FUZZ_NUM_BENCH_ROUNDS times. Only compensation is
+ * measured.
+ *
+ * @return double Nanoseconds per sample.
+ */
+static double bench_backend(const CompensateBackend *backend, const std::vector<CalibCorpus> &corpus,
+                            size_t num_samples)
+{
+    std::vector<BMP280Meas> out(FUZZ_SAMPLES_PER_CALIB + 64);
+    volatile uint32_t sink = 0;
+    std::chrono::nanoseconds elapsed(0);
+    for (const CalibCorpus &calib : corpus) {
+        size_t n = calib.temp_raw.size();
+        if (out.size() < n) {
+            out.resize(n);
+        }
+        if (backend->prepare) {
+            backend->prepare(&calib.calib_temp, &calib.calib_pres);
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round < FUZZ_NUM_BENCH_ROUNDS; round++) {
+            backend->fn(&calib.calib_temp, &calib.calib_pres, calib.temp_raw.data(), calib.pres_raw.data(), out.data(),
+                        n);
+            sink = sink + out[n - 1].pressure;
+        }
+        elapsed += std::chrono::steady_clock::now() - start;
+    }
+    (void)sink;
+    return (double)elapsed.count() / ((double)num_samples * FUZZ_NUM_BENCH_ROUNDS);
+}
+
+static int64_t abs_diff(int64_t a, int64_t b)
+{
+    return (a > b) ? a - b : b - a;
+}
+
+/**
+ * @brief Check and measure bmp280_inverse_compensate_batch with the datasheet calibration values.
+ *
+ * Targets are random temperatures and pressures within the operating range of the device (-40...85 DegC, 300...1100
+ * hPa). Every generated frame must compensate to exactly the target temperature, and to the pressure closest to the
+ * target pressure that any raw value can produce at that t_fine.
+ *
+ * @return size_t Number of frames that do not meet the requirements.
+ */
+static size_t check_and_bench_inverse(size_t num_frames)
+{
+    BMP280CalibTemp calib_temp;
+    BMP280CalibPres calib_pres;
+    calib_regs_to_calib(sim_fixture_calib_data, &calib_temp, &calib_pres);
+
+    std::vector<BMP280Meas> targets(num_frames);
+    for (size_t i = 0; i < num_frames; i++) {
+        targets[i].temperature = -4000 + (int32_t)(rng_next() % 12501);
+        targets[i].pressure = 30000 * 256 + (uint32_t)(rng_next() % (80000 * 256 + 1));
+    }
+    std::vector<uint8_t> frames(num_frames * BMP280_RAW_FRAME_SIZE);
+
+    auto start = std::chrono::steady_clock::now();
+    bmp280_inverse_compensate_batch(&calib_temp, &calib_pres, targets.data(), frames.data(), num_frames);
+    auto end = std::chrono::steady_clock::now();
+
+    size_t num_errors = 0;
+    for (size_t i = 0; i < num_frames; i++) {
+        int32_t pres_raw = bmp280_raw_val_from_regs(&frames[i * BMP280_RAW_FRAME_SIZE]);
+        int32_t temp_raw = bmp280_raw_val_from_regs(&frames[i * BMP280_RAW_FRAME_SIZE + 3]);
+        int32_t t_fine;
+        int32_t temperature = bmp280_compensate_temp(&calib_temp, temp_raw, &t_fine);
+        int64_t target = targets[i].pressure;
+        int64_t err = abs_diff(bmp280_compensate_pres(&calib_pres, pres_raw, t_fine), target);
+        /* Ties go to the smaller raw value */
+        bool closest = (abs_diff(bmp280_compensate_pres(&calib_pres, pres_raw - 1, t_fine), target) > err) &&
+                       (abs_diff(bmp280_compensate_pres(&calib_pres, pres_raw + 1, t_fine), target) >= err);
+        if ((temperature != targets[i].temperature) || !closest) {
+            if (num_errors == 0) {
+                fprintf(stderr, "Inverse mismatch: target %d/%u, temp_raw=%d pres_raw=%d\n",
+                        (int)targets[i].temperature, (unsigned)targets[i].pressure, (int)temp_raw, (int)pres_raw);
+            }
+            num_errors++;
+        }
+    }
+
+    double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    printf("Inverse compensation: %zu frames, %zu errors, %.2f ns/frame, %.2f M frames/s\n", num_frames, num_errors,
+           ns / (double)num_frames, (double)num_frames * 1e3 / ns);
+    return num_errors;
+}
+
+/**
+ * @brief Check and measure bmp280_compensate_gather in live acquisition order.
+ *
+ * Every calibration set of the corpus is one sensor. Tick t holds sample t of every sensor that has one, so
+ * consecutive samples use different calibration values. The reference compensates each tick sample by sample with the
+ * calibration values of the sample's sensor.
+ *
+ * @return size_t Number of samples that differ from the reference.
+ */
+static size_t check_and_bench_gather(const std::vector<CalibCorpus> &corpus)
+{
+    size_t num_sensors = corpus.size();
+    std::vector<int32_t> coeffs(BMP280_CALIB_SOA_NUM_COEFFS * num_sensors);
+    BMP280CalibSoA soa = {coeffs.data(), num_sensors};
+    for (size_t i = 0; i < num_sensors; i++) {
+        bmp280_calib_soa_set(&soa, i, &corpus[i].calib_temp, &corpus[i].calib_pres);
+    }
+
+    std::vector<uint32_t> calib_idx;
+    std::vector<int32_t> temp_raw;
+    std::vector<int32_t> pres_raw;
+    std::vector<size_t> tick_start;
+    for (size_t t = 0; t < FUZZ_SAMPLES_PER_CALIB; t++) {
+        tick_start.push_back(calib_idx.size());
+        for (size_t i = 0; i < num_sensors; i++) {
+            if (t < corpus[i].temp_raw.size()) {
+                calib_idx.push_back((uint32_t)i);
+                temp_raw.push_back(corpus[i].temp_raw[t]);
+                pres_raw.push_back(corpus[i].pres_raw[t]);
+            }
+        }
+    }
+    tick_start.push_back(calib_idx.size());
+    size_t num_samples = calib_idx.size();
+    std::vector<BMP280Meas> expected(num_samples);
+    std::vector<BMP280Meas> actual(num_samples);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < FUZZ_NUM_BENCH_ROUNDS; round++) {
+        for (size_t i = 0; i < num_samples; i++) {
+            const CalibCorpus &sensor = corpus[calib_idx[i]];
+            int32_t t_fine;
+            expected[i].temperature = bmp280_compensate_temp(&sensor.calib_temp, temp_raw[i], &t_fine);
+            expected[i].pressure = bmp280_compensate_pres(&sensor.calib_pres, pres_raw[i], t_fine);
+        }
+    }
+    auto reference_end = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < FUZZ_NUM_BENCH_ROUNDS; round++) {
+        for (size_t t = 0; t + 1 < tick_start.size(); t++) {
+            size_t first = tick_start[t];
+            bmp280_compensate_gather(&soa, &calib_idx[first], &temp_raw[first], &pres_raw[first], &actual[first],
+                                     tick_start[t + 1] - first);
+        }
+    }
+    auto gather_end = std::chrono::steady_clock::now();
+
+    size_t num_mismatches = 0;
+    for (size_t i = 0; i < num_samples; i++) {
+        if ((expected[i].temperature != actual[i].temperature) || (expected[i].pressure != actual[i].pressure)) {
+            if (num_mismatches == 0) {
+                fprintf(stderr, "Gather mismatch: sensor %u temp_raw=%d pres_raw=%d expected %d/%u, got %d/%u\n",
+                        (unsigned)calib_idx[i], (int)temp_raw[i], (int)pres_raw[i], (int)expected[i].temperature,
+                        (unsigned)expected[i].pressure, (int)actual[i].temperature, (unsigned)actual[i].pressure);
+            }
+            num_mismatches++;
+        }
+    }
+
+    double reference_ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(reference_end - start).count();
+    double gather_ns =
+        (double)std::chrono::duration_cast<std::chrono::nanoseconds>(gather_end - reference_end).count();
+    double per_sample = (double)num_samples * FUZZ_NUM_BENCH_ROUNDS;
+    printf("Gather across %zu sensors: %zu samples, %zu mismatches, reference %.2f ns/sample, gather %.2f ns/sample "
+           "%.2fx\n",
+           num_sensors, num_samples, num_mismatches, reference_ns / per_sample, gather_ns / per_sample,
+           reference_ns / gather_ns);
+    return num_mismatches;
+}
+
+int main(int argc, char **argv)
+{
+    size_t num_random_calib_sets = (argc > 1) ? strtoul(argv[1], NULL, 0) : 2000;
+    rng_state = (argc > 2) ? strtoull(argv[2], NULL, 0) : 0x5EED5EED5EEDULL;
+    if (rng_state == 0) {
+        rng_state = 1;
+    }
+
+    std::vector<CalibCorpus> corpus;
+    build_corpus(&corpus, num_random_calib_sets);
+
+    size_t num_samples = 0;
+    size_t num_mismatches = 0;
+    for (const CalibCorpus &calib : corpus) {
+        num_samples += calib.temp_raw.size();
+        num_mismatches += compare_backends(&calib);
+    }
+    printf("Compared %zu backends against reference: %zu calibration sets, %zu samples, %zu mismatches\n",
+           NUM_BACKENDS - 1, corpus.size(), num_samples, num_mismatches);
+
+    double reference_ns = bench_backend(&backends[0], corpus, num_samples);
+    for (size_t b = 0; b < NUM_BACKENDS; b++) {
+        double ns = (b == 0) ? reference_ns : bench_backend(&backends[b], corpus, num_samples);
+        printf("%-16s %8.2f ns/sample %6.2fx\n", backends[b].name, ns, reference_ns / ns);
+    }
+
+    num_mismatches += check_and_bench_gather(corpus);
+
+    size_t num_inverse_errors = check_and_bench_inverse(FUZZ_NUM_INVERSE_FRAMES);
+
+    return ((num_mismatches == 0) && (num_inverse_errors == 0)) ? 0 : 1;
+}
+
+#endif /* BMP280_LIBFUZZER */
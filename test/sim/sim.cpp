@@ -0,0 +1,101 @@
+#include <queue>
+#include <vector>
+
+#include "sim.h"
+
+typedef struct {
+    /** Virtual time at which the event is executed. */
+    uint64_t time_us;
+    /** Monotonically increasing scheduling counter. Breaks ties between events scheduled for the same time. */
+    uint64_t seq;
+    SimEventCb cb;
+    void *user_data;
+} SimEvent;
+
+struct SimEventLater {
+    bool operator()(const SimEvent &a, const SimEvent &b) const
+    {
+        if (a.time_us != b.time_us) {
+            return a.time_us > b.time_us;
+        }
+        return a.seq > b.seq;
+    }
+};
+
+static std::priority_queue<SimEvent, std::vector<SimEvent>, SimEventLater> events;
+static uint64_t now_us;
+static uint64_t next_seq;
+static uint64_t num_executed_events;
+
+void sim_reset(void)
+{
+    events = std::priority_queue<SimEvent, std::vector<SimEvent>, SimEventLater>();
+    now_us = 0;
+    next_seq = 0;
+    num_executed_events = 0;
+}
+
+uint64_t sim_now_us(void)
+{
+    return now_us;
+}
+
+void sim_schedule_us(uint64_t delay_us, SimEventCb cb, void *user_data)
+{
+    SimEvent event = {
+        .time_us = now_us + delay_us,
+        .seq = next_seq++,
+        .cb = cb,
+        .user_data = user_data,
+    };
+    events.push(event);
+}
+
+bool sim_step(void)
+{
+    if (events.empty()) {
+        return false;
+    }
+
+    SimEvent event = events.top();
+    events.pop();
+    now_us = event.time_us;
+    num_executed_events++;
+    if (event.cb) {
+        event.cb(event.user_data);
+    }
+    return true;
+}
+
+size_t sim_run(void)
+{
+    size_t num_events = 0;
+    while (sim_step()) {
+        num_events++;
+    }
+    return num_events;
+}
+
+size_t sim_run_until_us(uint64_t end_us)
+{
+    size_t num_events = 0;
+    while (!events.empty() && (events.top().time_us <= end_us)) {
+        sim_step();
+        num_events++;
+    }
+    if (now_us < end_us) {
+        now_us = end_us;
+    }
+    return num_events;
+}
+
+uint64_t sim_num_executed_events(void)
+{
+    return num_executed_events;
+}
+
+void sim_start_timer(uint32_t duration_ms, void *user_data, BMP280TimerExpiredCb cb, void *cb_user_data)
+{
+    (void)user_data;
+    sim_schedule_us((uint64_t)duration_ms * 1000, cb, cb_user_data);
+}
@@ -0,0 +1,95 @@
+#ifndef TEST_SIM_SIM_H
+#define TEST_SIM_SIM_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "bmp280_defs.h"
+
+/**
+ * @brief Discrete-event simulation kernel.
+ *
+ * Keeps a virtual clock and a heap of pending events. Running the simulation pops the earliest event, advances the
+ * virtual clock to its time and executes its callback. No real time passes, so sequences that wait for milliseconds
+ * (reset, forced mode conversions) complete instantly.
+ *
+ * Events scheduled for the same virtual time are executed in the order in which they were scheduled, so every run of a
+ * simulation with the same inputs produces exactly the same sequence of events.
+ *
+ * There is a single global kernel, the same way the mock objects use a single global mock().
+ */
+
+/** Callback type of a simulation event. */
+typedef void (*SimEventCb)(void *user_data);
+
+/**
+ * @brief Remove all pending events and set virtual time to 0.
+ *
+ * Must be called at the start of every test that uses the simulation.
+ */
+void sim_reset(void);
+
+/**
+ * @brief Get current virtual time.
+ *
+ * @return uint64_t Virtual time in microseconds since the last @ref sim_reset.
+ */
+uint64_t sim_now_us(void);
+
+/**
+ * @brief Schedule @p cb to be executed @p delay_us microseconds after the current virtual time.
+ *
+ * @param[in] delay_us Delay in microseconds. Can be 0, in which case @p cb is executed after all events that are
+ * already scheduled for the current virtual time.
+ * @param[in] cb Callback to execute.
+ * @param[in] user_data User data to pass to @p cb.
+ */
+void sim_schedule_us(uint64_t delay_us, SimEventCb cb, void *user_data);
+
+/**
+ * @brief Execute the earliest pending event.
+ *
+ * @retval true An event was executed.
+ * @retval false There are no pending events.
+ */
+bool sim_step(void);
+
+/**
+ * @brief Execute events until there are no pending events left.
+ *
+ * @return size_t Number of executed events.
+ */
+size_t sim_run(void);
+
+/**
+ * @brief Execute all events scheduled up to and including @p end_us, then set virtual time to @p end_us.
+ *
+ * @param[in] end_us Virtual time in microseconds to run the simulation until.
+ *
+ * @return size_t Number of executed events.
+ */
+size_t sim_run_until_us(uint64_t end_us);
+
+/**
+ * @brief Get the number of events executed since the last @ref sim_reset.
+ */
+uint64_t sim_num_executed_events(void);
+
+/**
+ * @brief Implementation of @ref BMP280StartTimer driven by the virtual clock.
+ *
+ * Pass as start_timer in the init cfg. start_timer_user_data is not used.
+ */
+void sim_start_timer(uint32_t duration_ms, void *user_data, BMP280TimerExpiredCb cb, void *cb_user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEST_SIM_SIM_H */
@@ -0,0 +1,190 @@
+#include <string.h>
+
+#include "sim.h"
+#include "sim_bmp280.h"
+
+#define SIM_BMP280_CALIB_DATA_START_REG_ADDR 0x88
+#define SIM_BMP280_CHIP_ID_REG_ADDR 0xD0
+#define SIM_BMP280_RESET_REG_ADDR 0xE0
+#define SIM_BMP280_STATUS_REG_ADDR 0xF3
+#define SIM_BMP280_CTRL_MEAS_REG_ADDR 0xF4
+#define SIM_BMP280_CONFIG_REG_ADDR 0xF5
+#define SIM_BMP280_PRES_MSB_REG_ADDR 0xF7
+#define SIM_BMP280_TEMP_MSB_REG_ADDR 0xFA
+
+#define SIM_BMP280_CHIP_ID 0x58
+#define SIM_BMP280_RESET_REG_VALUE 0xB6
+/** Value of the temperature and pressure registers after reset, and when a measurement is skipped. */
+#define SIM_BMP280_SKIPPED_RAW_VAL 0x80000
+/** "measuring" bit of the status register. */
+#define SIM_BMP280_STATUS_MEASURING 0x08U
+
+typedef struct {
+    SimBMP280 *dev;
+    bool is_read;
+    uint8_t addr;
+    size_t num_regs;
+    uint8_t *data;
+    uint8_t reg_val;
+    BMP280_IOCompleteCb cb;
+    void *cb_user_data;
+} SimTransaction;
+
+/**
+ * @brief Convert osrs_t/osrs_p register field value to the number of samples.
+ */
+static uint32_t oversampling_factor(uint8_t osrs)
+{
+    return (osrs == 0) ? 0 : (1U << ((osrs > 5 ? 5 : osrs) - 1));
+}
+
+static void write_raw_val(uint8_t *const regs, int32_t raw)
+{
+    uint32_t val = (uint32_t)raw & 0xFFFFFU;
+    regs[0] = (uint8_t)(val >> 12);
+    regs[1] = (uint8_t)(val >> 4);
+    regs[2] = (uint8_t)((val & 0xFU) << 4);
+}
+
+static void power_on_reset(SimBMP280 *dev)
+{
+    uint8_t calib[24];
+    memcpy(calib, &dev->regs[SIM_BMP280_CALIB_DATA_START_REG_ADDR], sizeof(calib));
+    memset(dev->regs, 0, sizeof(dev->regs));
+    /* Calibration values are stored in NVM, they survive the reset */
+    memcpy(&dev->regs[SIM_BMP280_CALIB_DATA_START_REG_ADDR], calib, sizeof(calib));
+    dev->regs[SIM_BMP280_CHIP_ID_REG_ADDR] = SIM_BMP280_CHIP_ID;
+    write_raw_val(&dev->regs[SIM_BMP280_PRES_MSB_REG_ADDR], SIM_BMP280_SKIPPED_RAW_VAL);
+    write_raw_val(&dev->regs[SIM_BMP280_TEMP_MSB_REG_ADDR], SIM_BMP280_SKIPPED_RAW_VAL);
+}
+
+static void conversion_complete(void *user_data)
+{
+    SimBMP280 *dev = (SimBMP280 *)user_data;
+    uint8_t ctrl_meas = dev->regs[SIM_BMP280_CTRL_MEAS_REG_ADDR];
+    uint8_t osrs_t = (ctrl_meas >> 5) & 0x7U;
+    uint8_t osrs_p = (ctrl_meas >> 2) & 0x7U;
+
+    write_raw_val(&dev->regs[SIM_BMP280_TEMP_MSB_REG_ADDR], osrs_t ? dev->temp_raw : SIM_BMP280_SKIPPED_RAW_VAL);
+    write_raw_val(&dev->regs[SIM_BMP280_PRES_MSB_REG_ADDR], osrs_p ? dev->pres_raw : SIM_BMP280_SKIPPED_RAW_VAL);
+    dev->regs[SIM_BMP280_STATUS_REG_ADDR] &= (uint8_t)~SIM_BMP280_STATUS_MEASURING;
+    /* Device goes back to sleep mode after a forced mode conversion */
+    dev->regs[SIM_BMP280_CTRL_MEAS_REG_ADDR] &= (uint8_t)~0x3U;
+    dev->num_conversions++;
+}
+
+static void apply_write(SimBMP280 *dev, uint8_t addr, uint8_t reg_val)
+{
+    if (addr == SIM_BMP280_RESET_REG_ADDR) {
+        if (reg_val == SIM_BMP280_RESET_REG_VALUE) {
+            power_on_reset(dev);
+        }
+        return;
+    }
+    if ((addr != SIM_BMP280_CTRL_MEAS_REG_ADDR) && (addr != SIM_BMP280_CONFIG_REG_ADDR)) {
+        /* Read-only register */
+        return;
+    }
+
+    dev->regs[addr] = reg_val;
+    if ((addr == SIM_BMP280_CTRL_MEAS_REG_ADDR) && ((reg_val & 0x3U) == 0x1U)) {
+        dev->regs[SIM_BMP280_STATUS_REG_ADDR] |= SIM_BMP280_STATUS_MEASURING;
+        sim_schedule_us(sim_bmp280_conversion_time_us(dev), conversion_complete, (void *)dev);
+    }
+}
+
+static void transaction_complete(void *user_data)
+{
+    SimTransaction *xfer = (SimTransaction *)user_data;
+    SimBMP280 *dev = xfer->dev;
+    uint8_t io_rc = dev->io_fail ? BMP280_IO_RESULT_CODE_ERR : BMP280_IO_RESULT_CODE_OK;
+
+    if (!dev->io_fail) {
+        if (xfer->is_read) {
+            for (size_t i = 0; i < xfer->num_regs; i++) {
+                xfer->data[i] = dev->regs[(uint8_t)(xfer->addr + i)];
+            }
+        } else {
+            apply_write(dev, xfer->addr, xfer->reg_val);
+        }
+    }
+
+    BMP280_IOCompleteCb cb = xfer->cb;
+    void *cb_user_data = xfer->cb_user_data;
+    delete xfer;
+    cb(io_rc, cb_user_data);
+}
+
+static void start_transaction(SimTransaction *xfer, size_t num_bytes)
+{
+    SimBus *bus = xfer->dev->bus;
+    uint64_t now = sim_now_us();
+    uint64_t start = (bus->busy_until_us > now) ? bus->busy_until_us : now;
+    bus->busy_until_us = start + bus->overhead_us + (uint64_t)num_bytes * bus->byte_time_us;
+    bus->num_transactions++;
+    bus->num_bytes += num_bytes;
+    sim_schedule_us(bus->busy_until_us - now, transaction_complete, (void *)xfer);
+}
+
+void sim_bus_init(SimBus *bus, uint32_t overhead_us, uint32_t byte_time_us)
+{
+    bus->overhead_us = overhead_us;
+    bus->byte_time_us = byte_time_us;
+    bus->busy_until_us = 0;
+    bus->num_transactions = 0;
+    bus->num_bytes = 0;
+}
+
+void sim_bmp280_init(SimBMP280 *dev, SimBus *bus, const uint8_t *calib_data)
+{
+    dev->bus = bus;
+    memcpy(&dev->regs[SIM_BMP280_CALIB_DATA_START_REG_ADDR], calib_data, 24);
+    power_on_reset(dev);
+    dev->temp_raw = SIM_BMP280_SKIPPED_RAW_VAL;
+    dev->pres_raw = SIM_BMP280_SKIPPED_RAW_VAL;
+    dev->io_fail = false;
+    dev->num_conversions = 0;
+}
+
+uint32_t sim_bmp280_conversion_time_us(const SimBMP280 *dev)
+{
+    uint8_t ctrl_meas = dev->regs[SIM_BMP280_CTRL_MEAS_REG_ADDR];
+    uint32_t t_factor = oversampling_factor((ctrl_meas >> 5) & 0x7U);
+    uint32_t p_factor = oversampling_factor((ctrl_meas >> 2) & 0x7U);
+
+    /* t_meas,max = 1.25 ms + 2.3 ms * osrs_t + (2.3 ms * osrs_p + 0.575 ms) */
+    uint32_t time_us = 1250 + 2300 * t_factor;
+    if (p_factor) {
+        time_us += 2300 * p_factor + 575;
+    }
+    return time_us;
+}
+
+void sim_bmp280_read_regs(uint8_t start_addr, size_t num_regs, uint8_t *data, void *user_data, BMP280_IOCompleteCb cb,
+                          void *cb_user_data)
+{
+    SimTransaction *xfer = new SimTransaction;
+    xfer->dev = (SimBMP280 *)user_data;
+    xfer->is_read = true;
+    xfer->addr = start_addr;
+    xfer->num_regs = num_regs;
+    xfer->data = data;
+    xfer->reg_val = 0;
+    xfer->cb = cb;
+    xfer->cb_user_data = cb_user_data;
+    start_transaction(xfer, num_regs);
+}
+
+void sim_bmp280_write_reg(uint8_t addr, uint8_t reg_val, void *user_data, BMP280_IOCompleteCb cb, void *cb_user_data)
+{
+    SimTransaction *xfer = new SimTransaction;
+    xfer->dev = (SimBMP280 *)user_data;
+    xfer->is_read = false;
+    xfer->addr = addr;
+    xfer->num_regs = 0;
+    xfer->data = NULL;
+    xfer->reg_val = reg_val;
+    xfer->cb = cb;
+    xfer->cb_user_data = cb_user_data;
+    start_transaction(xfer, 1);
+}
@@ -0,0 +1,102 @@
+#ifndef TEST_SIM_SIM_BMP280_H
+#define TEST_SIM_SIM_BMP280_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "bmp280_defs.h"
+
+/**
+ * @brief Simulated I2C/SPI bus.
+ *
+ * Transactions on one bus are serialized: a transaction that is issued while the bus is busy starts once all previously
+ * issued transactions are finished. Transaction duration is overhead_us + (number of data bytes) * byte_time_us.
+ */
+typedef struct {
+    /** Fixed cost of every transaction (start condition, device address, register address), in microseconds. */
+    uint32_t overhead_us;
+    /** Time to transfer one data byte, in microseconds. */
+    uint32_t byte_time_us;
+    /** Virtual time until which the bus is occupied by previously issued transactions. */
+    uint64_t busy_until_us;
+    /** Number of transactions issued on this bus. */
+    uint64_t num_transactions;
+    /** Number of data bytes transferred on this bus. */
+    uint64_t num_bytes;
+} SimBus;
+
+/**
+ * @brief Simulated BMP280 device.
+ *
+ * Models the register map, forced mode conversions with datasheet conversion times, and the reset command. Normal mode
+ * is not modeled.
+ *
+ * When a forced mode conversion finishes, temp_raw and pres_raw are written to the data registers, unless the
+ * corresponding oversampling option in ctrl_meas is "skipped", in which case the reset value 0x80000 is written.
+ */
+typedef struct {
+    /** Bus that the device is attached to. */
+    SimBus *bus;
+    /** Register values. Index is the register address. */
+    uint8_t regs[256];
+    /** Raw temperature value that the next conversion produces. 20 bits. */
+    int32_t temp_raw;
+    /** Raw pressure value that the next conversion produces. 20 bits. */
+    int32_t pres_raw;
+    /** If true, every IO transaction with this device completes with BMP280_IO_RESULT_CODE_ERR. */
+    bool io_fail;
+    /** Number of finished conversions. */
+    uint64_t num_conversions;
+} SimBMP280;
+
+/**
+ * @brief Initialize a simulated bus.
+ *
+ * @param[out] bus Bus to initialize.
+ * @param[in] overhead_us Fixed cost of every transaction in microseconds.
+ * @param[in] byte_time_us Time to transfer one data byte in microseconds.
+ */
+void sim_bus_init(SimBus *bus, uint32_t overhead_us, uint32_t byte_time_us);
+
+/**
+ * @brief Initialize a simulated BMP280 device in its power on state.
+ *
+ * @param[out] dev Device to initialize.
+ * @param[in] bus Bus that the device is attached to.
+ * @param[in] calib_data Must point to 24 bytes - contents of calibration registers 0x88...0x9F.
+ */
+void sim_bmp280_init(SimBMP280 *dev, SimBus *bus, const uint8_t *calib_data);
+
+/**
+ * @brief Maximum forced mode conversion time for the oversampling options currently set in ctrl_meas.
+ *
+ * Follows the formula from the datasheet, section 3.8.1.
+ *
+ * @param[in] dev Device.
+ *
+ * @return uint32_t Conversion time in microseconds.
+ */
+uint32_t sim_bmp280_conversion_time_us(const SimBMP280 *dev);
+
+/**
+ * @brief Implementation of @ref BMP280ReadRegs. read_regs_user_data must point to a SimBMP280.
+ */
+void sim_bmp280_read_regs(uint8_t start_addr, size_t num_regs, uint8_t *data, void *user_data, BMP280_IOCompleteCb cb,
+                          void *cb_user_data);
+
+/**
+ * @brief Implementation of @ref BMP280WriteReg. write_reg_user_data must point to a SimBMP280.
+ */
+void sim_bmp280_write_reg(uint8_t addr, uint8_t reg_val, void *user_data, BMP280_IOCompleteCb cb, void *cb_user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEST_SIM_SIM_BMP280_H */
@@ -0,0 +1,25 @@
+#include "bmp280.h"
+#include "sim_fixture.h"
+/* To include the definition of struct BMP280Struct, so that we can define instances to return from get_inst_buf. */
+#include "bmp280_private.h"
+
+const uint8_t sim_fixture_calib_data[24] = {
+    0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC, 0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B,
+    0x27, 0x0B, 0x8C, 0x00, 0xF9, 0xFF, 0x8C, 0x3C, 0xF8, 0xC6, 0x70, 0x17,
+};
+
+const uint8_t sim_fixture_data_regs[6] = {0x65, 0x5A, 0xC0, 0x7E, 0xED, 0x0};
+
+static struct BMP280Struct inst_bufs[SIM_FIXTURE_MAX_NUM_INSTS];
+static size_t num_inst_bufs_used;
+
+void sim_fixture_reset_inst_bufs(void)
+{
+    num_inst_bufs_used = 0;
+}
+
+void *sim_fixture_get_inst_buf(void *user_data)
+{
+    (void)user_data;
+    return (num_inst_bufs_used < SIM_FIXTURE_MAX_NUM_INSTS) ? &inst_bufs[num_inst_bufs_used++] : NULL;
+}
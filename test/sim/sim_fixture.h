@@ -0,0 +1,49 @@
+#ifndef TEST_SIM_SIM_FIXTURE_H
+#define TEST_SIM_SIM_FIXTURE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Register contents and driver instance memory shared by the test suites and the benchmarks.
+ *
+ * Written in C, so that the benchmarks of the ports that are built without a C++ compiler can use it too.
+ */
+
+/** Maximum number of instances that @ref sim_fixture_get_inst_buf hands out between two resets. */
+#define SIM_FIXTURE_MAX_NUM_INSTS 1000
+
+/** Example contents of calibration registers 0x88...0x9F, from the datasheet p. 23. */
+extern const uint8_t sim_fixture_calib_data[24];
+
+/**
+ * @brief Example contents of data registers 0xF7...0xFC, from the datasheet p. 23: raw pressure 415148, raw temperature
+ * 519888.
+ */
+extern const uint8_t sim_fixture_data_regs[6];
+
+/**
+ * @brief Make all instance buffers available again.
+ *
+ * Must be called at the start of every test that creates instances with @ref sim_fixture_get_inst_buf.
+ */
+void sim_fixture_reset_inst_bufs(void);
+
+/**
+ * @brief Implementation of @ref BMP280GetInstBuf. user_data is not used.
+ *
+ * @return void* The next unused instance buffer, or NULL if SIM_FIXTURE_MAX_NUM_INSTS have been handed out since the
+ * last @ref sim_fixture_reset_inst_bufs.
+ */
+void *sim_fixture_get_inst_buf(void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEST_SIM_SIM_FIXTURE_H */
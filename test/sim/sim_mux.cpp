@@ -0,0 +1,128 @@
+#include <string.h>
+
+#include "sim.h"
+#include "sim_mux.h"
+
+#define SIM_MUX_FIRST_DEV_ADDR 0x76
+
+static void run_next(SimMux *mux);
+
+/**
+ * @brief Occupy the bus for a transaction of @p num_bytes that the devices do not see, and schedule @p cb at its end.
+ */
+static void occupy_bus(SimMux *mux, size_t num_bytes, SimEventCb cb)
+{
+    SimBus *bus = mux->bus;
+    uint64_t now = sim_now_us();
+    uint64_t start = (bus->busy_until_us > now) ? bus->busy_until_us : now;
+    bus->busy_until_us = start + bus->overhead_us + (uint64_t)num_bytes * bus->byte_time_us;
+    bus->num_transactions++;
+    bus->num_bytes += num_bytes;
+    sim_schedule_us(bus->busy_until_us - now, cb, (void *)mux);
+}
+
+static void transfer_done(SimMux *mux, uint8_t io_rc)
+{
+    mux->cur->io_rc = io_rc;
+    if (io_rc != BMP280_IO_RESULT_CODE_OK) {
+        mux->num_errors++;
+    }
+    mux->cur = mux->cur->next;
+    run_next(mux);
+}
+
+static void select_done(void *user_data)
+{
+    SimMux *mux = (SimMux *)user_data;
+    /* The new channels are connected on the stop condition */
+    mux->control = mux->cur->write_val;
+    mux->num_selects++;
+    transfer_done(mux, BMP280_IO_RESULT_CODE_OK);
+}
+
+static void nack_done(void *user_data)
+{
+    transfer_done((SimMux *)user_data, BMP280_IO_RESULT_CODE_ERR);
+}
+
+static void dev_io_complete_cb(uint8_t io_rc, void *user_data)
+{
+    transfer_done((SimMux *)user_data, io_rc);
+}
+
+/**
+ * @brief Device with @p dev_addr on the enabled channels. NULL if there is none, or more than one.
+ */
+static SimBMP280 *find_dev(const SimMux *mux, uint8_t dev_addr)
+{
+    if ((dev_addr < SIM_MUX_FIRST_DEV_ADDR) || (dev_addr >= SIM_MUX_FIRST_DEV_ADDR + SIM_MUX_DEVS_PER_CHANNEL)) {
+        return NULL;
+    }
+    SimBMP280 *found = NULL;
+    for (size_t ch = 0; ch < BMP280_BUS_BATCH_MUX_NUM_CHANNELS; ch++) {
+        SimBMP280 *dev = mux->devs[ch][dev_addr - SIM_MUX_FIRST_DEV_ADDR];
+        if (!(mux->control & (1U << ch)) || !dev) {
+            continue;
+        }
+        if (found) {
+            return NULL;
+        }
+        found = dev;
+    }
+    return found;
+}
+
+static void run_next(SimMux *mux)
+{
+    BMP280BusTransfer *transfer = mux->cur;
+    if (!transfer) {
+        BMP280BusSubmitCompleteCb cb = mux->cb;
+        mux->cb = NULL;
+        cb(mux->cb_user_data);
+        return;
+    }
+
+    if (transfer->is_mux_select) {
+        mux->failed_channel = (transfer->dev_addr == mux->addr) ? BMP280_BUS_BATCH_NO_MUX : transfer->mux_channel;
+        occupy_bus(mux, 1, (transfer->dev_addr == mux->addr) ? select_done : nack_done);
+        return;
+    }
+    if ((mux->failed_channel != BMP280_BUS_BATCH_NO_MUX) && (transfer->mux_channel == mux->failed_channel)) {
+        /* Skipped, the channel of the device may not be connected */
+        transfer_done(mux, BMP280_IO_RESULT_CODE_ERR);
+        return;
+    }
+    SimBMP280 *dev = find_dev(mux, transfer->dev_addr);
+    if (!dev) {
+        occupy_bus(mux, 0, nack_done);
+    } else if (transfer->is_read) {
+        sim_bmp280_read_regs(transfer->reg_addr, transfer->len, transfer->data, (void *)dev, dev_io_complete_cb,
+                             (void *)mux);
+    } else {
+        sim_bmp280_write_reg(transfer->reg_addr, transfer->write_val, (void *)dev, dev_io_complete_cb, (void *)mux);
+    }
+}
+
+void sim_mux_init(SimMux *mux, SimBus *bus, uint8_t addr)
+{
+    memset(mux, 0, sizeof(*mux));
+    mux->bus = bus;
+    mux->addr = addr;
+}
+
+void sim_mux_attach(SimMux *mux, SimBMP280 *dev, uint8_t channel, uint8_t dev_addr)
+{
+    mux->devs[channel][dev_addr - SIM_MUX_FIRST_DEV_ADDR] = dev;
+}
+
+void sim_mux_submit(BMP280BusTransfer *transfers, size_t num_transfers, void *user_data, BMP280BusSubmitCompleteCb cb,
+                    void *cb_user_data)
+{
+    (void)num_transfers;
+    SimMux *mux = (SimMux *)user_data;
+    mux->cur = transfers;
+    mux->failed_channel = BMP280_BUS_BATCH_NO_MUX;
+    mux->cb = cb;
+    mux->cb_user_data = cb_user_data;
+    run_next(mux);
+}
@@ -0,0 +1,70 @@
+#ifndef TEST_SIM_SIM_MUX_H
+#define TEST_SIM_SIM_MUX_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "bmp280_bus_batch.h"
+#include "sim_bmp280.h"
+
+/** Number of devices per mux channel: BMP280 addresses 0x76 and 0x77. */
+#define SIM_MUX_DEVS_PER_CHANNEL 2
+
+/**
+ * @brief Simulated TCA9548A I2C multiplexer with BMP280 devices on its channels.
+ *
+ * @ref sim_mux_submit executes the transfers of a batch one after the other on the bus of the mux. A mux select is a
+ * one byte write to the address of the mux, and enables the channels in its control byte. A register transfer reaches
+ * the device with its address on the enabled channel. If no device answers, or devices on several enabled channels
+ * answer at once, the transfer costs the transaction overhead and fails, like a NACK or a collision on a real bus.
+ * The transfers of a channel whose select failed are skipped without using the bus, and fail.
+ */
+typedef struct {
+    SimBus *bus;
+    /** 7-bit I2C address of the mux. */
+    uint8_t addr;
+    /** Control register: one enable bit per channel. 0 after power on. */
+    uint8_t control;
+    /** Devices on every channel, index is the device address - 0x76. */
+    SimBMP280 *devs[BMP280_BUS_BATCH_MUX_NUM_CHANNELS][SIM_MUX_DEVS_PER_CHANNEL];
+    /** Number of select writes to the mux. */
+    uint64_t num_selects;
+    /** Number of failed transfers. */
+    uint64_t num_errors;
+    /** Batch in progress. */
+    BMP280BusTransfer *cur;
+    /** Channel of the last select of the batch if it failed, BMP280_BUS_BATCH_NO_MUX otherwise. */
+    uint8_t failed_channel;
+    BMP280BusSubmitCompleteCb cb;
+    void *cb_user_data;
+} SimMux;
+
+/**
+ * @brief Initialize a mux without devices, with all channels disabled.
+ */
+void sim_mux_init(SimMux *mux, SimBus *bus, uint8_t addr);
+
+/**
+ * @brief Put a device on a mux channel. The device must have been initialized on the bus of the mux.
+ *
+ * @param[in] dev_addr 0x76 or 0x77.
+ */
+void sim_mux_attach(SimMux *mux, SimBMP280 *dev, uint8_t channel, uint8_t dev_addr);
+
+/**
+ * @brief Implementation of @ref BMP280BusSubmit. user_data must point to a SimMux.
+ */
+void sim_mux_submit(BMP280BusTransfer *transfers, size_t num_transfers, void *user_data, BMP280BusSubmitCompleteCb cb,
+                    void *cb_user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEST_SIM_SIM_MUX_H */
@@ -0,0 +1,519 @@
+#define _GNU_SOURCE
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "bmp280_recompensate.h"
+
+static uint16_t le_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t le_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t le_u64(const uint8_t *p)
+{
+    return (uint64_t)le_u32(p) | ((uint64_t)le_u32(&p[4]) << 32);
+}
+
+static void put_le_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_le_u64(uint8_t *p, uint64_t v)
+{
+    for (size_t i = 0; i < 8; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+/** Hash of a sensor id for the open addressing table. */
+static size_t sensor_id_hash(uint32_t sensor_id)
+{
+    return (size_t)(sensor_id * 2654435761U);
+}
+
+uint8_t bmp280_recomp_calib_init(BMP280RecompCalib *const calib, size_t max_sensors)
+{
+    if (!calib || max_sensors == 0) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    memset(calib, 0, sizeof(*calib));
+    /* At most half of the slots are used, so probe sequences stay short */
+    size_t num_slots = 2;
+    while (num_slots < 2 * max_sensors) {
+        num_slots *= 2;
+    }
+    calib->soa.coeffs = malloc(BMP280_CALIB_SOA_NUM_COEFFS * max_sensors * sizeof(int32_t));
+    calib->soa.capacity = max_sensors;
+    calib->slot_ids = malloc(num_slots * sizeof(uint32_t));
+    calib->slot_idxs = malloc(num_slots * sizeof(int32_t));
+    calib->num_slots = num_slots;
+    if (!calib->soa.coeffs || !calib->slot_ids || !calib->slot_idxs) {
+        bmp280_recomp_calib_deinit(calib);
+        return BMP280_RESULT_CODE_NO_MEM;
+    }
+    for (size_t i = 0; i < num_slots; i++) {
+        calib->slot_idxs[i] = -1;
+    }
+    return BMP280_RESULT_CODE_OK;
+}
+
+void bmp280_recomp_calib_deinit(BMP280RecompCalib *const calib)
+{
+    free(calib->soa.coeffs);
+    free(calib->slot_ids);
+    free(calib->slot_idxs);
+    memset(calib, 0, sizeof(*calib));
+}
+
+/** Slot of @p sensor_id, or the empty slot where it would be inserted. */
+static size_t find_slot(const BMP280RecompCalib *const calib, uint32_t sensor_id)
+{
+    size_t mask = calib->num_slots - 1;
+    size_t slot = sensor_id_hash(sensor_id) & mask;
+    while (calib->slot_idxs[slot] >= 0 && calib->slot_ids[slot] != sensor_id) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+uint8_t bmp280_recomp_calib_add(BMP280RecompCalib *const calib, uint32_t sensor_id, const uint8_t *const regs)
+{
+    size_t slot = find_slot(calib, sensor_id);
+    if (calib->slot_idxs[slot] < 0) {
+        if (calib->num_sensors == calib->soa.capacity) {
+            return BMP280_RESULT_CODE_NO_MEM;
+        }
+        calib->slot_ids[slot] = sensor_id;
+        calib->slot_idxs[slot] = (int32_t)calib->num_sensors++;
+    }
+
+    /* Register layout from the datasheet, table 17 */
+    BMP280CalibTemp calib_temp = {le_u16(&regs[0]), (int16_t)le_u16(&regs[2]), (int16_t)le_u16(&regs[4])};
+    BMP280CalibPres calib_pres = {
+        le_u16(&regs[6]),
+        (int16_t)le_u16(&regs[8]),
+        (int16_t)le_u16(&regs[10]),
+        (int16_t)le_u16(&regs[12]),
+        (int16_t)le_u16(&regs[14]),
+        (int16_t)le_u16(&regs[16]),
+        (int16_t)le_u16(&regs[18]),
+        (int16_t)le_u16(&regs[20]),
+        (int16_t)le_u16(&regs[22]),
+    };
+    bmp280_calib_soa_set(&calib->soa, (size_t)calib->slot_idxs[slot], &calib_temp, &calib_pres);
+    return BMP280_RESULT_CODE_OK;
+}
+
+int32_t bmp280_recomp_calib_find(const BMP280RecompCalib *const calib, uint32_t sensor_id)
+{
+    return calib->slot_idxs[find_slot(calib, sensor_id)];
+}
+
+static int hex_digit(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/** Parse "<sensor id> <48 hex digits>". @return bool false if the line is malformed. */
+static bool parse_calib_line(const char *line, uint32_t *sensor_id, uint8_t *regs)
+{
+    char *end;
+    unsigned long id = strtoul(line, &end, 0);
+    if (end == line || id > UINT32_MAX) {
+        return false;
+    }
+    while (*end == ' ' || *end == '\t') {
+        end++;
+    }
+    for (size_t i = 0; i < 24; i++) {
+        int hi = hex_digit(end[2 * i]);
+        int lo = (hi < 0) ? -1 : hex_digit(end[2 * i + 1]);
+        if (lo < 0) {
+            return false;
+        }
+        regs[i] = (uint8_t)((hi << 4) | lo);
+    }
+    char next = end[48];
+    *sensor_id = (uint32_t)id;
+    return next == '\0' || next == '\n' || next == '\r' || next == ' ' || next == '\t';
+}
+
+static bool is_blank_or_comment(const char *line)
+{
+    while (*line == ' ' || *line == '\t') {
+        line++;
+    }
+    return *line == '#' || *line == '\n' || *line == '\r' || *line == '\0';
+}
+
+uint8_t bmp280_recomp_calib_load(BMP280RecompCalib *const calib, const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        return BMP280_RESULT_CODE_IO_ERR;
+    }
+    /* First pass counts the sensors, so that the table is allocated once */
+    char line[256];
+    size_t num_lines = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (!is_blank_or_comment(line)) {
+            num_lines++;
+        }
+    }
+    uint8_t rc = bmp280_recomp_calib_init(calib, (num_lines > 0) ? num_lines : 1);
+    rewind(f);
+    while (rc == BMP280_RESULT_CODE_OK && fgets(line, sizeof(line), f)) {
+        if (is_blank_or_comment(line)) {
+            continue;
+        }
+        uint32_t sensor_id;
+        uint8_t regs[24];
+        if (!parse_calib_line(line, &sensor_id, regs)) {
+            fprintf(stderr, "Malformed calibration line: %s", line);
+            rc = BMP280_RESULT_CODE_IO_ERR;
+            break;
+        }
+        rc = bmp280_recomp_calib_add(calib, sensor_id, regs);
+    }
+    fclose(f);
+    if (rc != BMP280_RESULT_CODE_OK && calib->soa.coeffs) {
+        bmp280_recomp_calib_deinit(calib);
+    }
+    return rc;
+}
+
+uint8_t bmp280_raw_archive_open(BMP280RawArchive *const archive, const char *path)
+{
+    memset(archive, 0, sizeof(*archive));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return BMP280_RESULT_CODE_IO_ERR;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < BMP280_RAW_ARCHIVE_HEADER_SIZE) {
+        close(fd);
+        return BMP280_RESULT_CODE_IO_ERR;
+    }
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return BMP280_RESULT_CODE_IO_ERR;
+    }
+    /* Every record is read exactly once, front to back within a chunk */
+    madvise(map, size, MADV_SEQUENTIAL);
+
+    const uint8_t *header = (const uint8_t *)map;
+    size_t records_size = size - BMP280_RAW_ARCHIVE_HEADER_SIZE;
+    if (memcmp(header, "BRAW", 4) != 0 || le_u16(&header[4]) != BMP280_RAW_ARCHIVE_VERSION ||
+        le_u16(&header[6]) != BMP280_RAW_ARCHIVE_RECORD_SIZE || (records_size % BMP280_RAW_ARCHIVE_RECORD_SIZE) != 0) {
+        munmap(map, size);
+        return BMP280_RESULT_CODE_IO_ERR;
+    }
+    archive->map = (const uint8_t *)map;
+    archive->map_size = size;
+    archive->records = &header[BMP280_RAW_ARCHIVE_HEADER_SIZE];
+    archive->num_records = records_size / BMP280_RAW_ARCHIVE_RECORD_SIZE;
+    return BMP280_RESULT_CODE_OK;
+}
+
+void bmp280_raw_archive_close(BMP280RawArchive *const archive)
+{
+    if (archive->map) {
+        munmap((void *)archive->map, archive->map_size);
+    }
+    memset(archive, 0, sizeof(*archive));
+}
+
+uint8_t bmp280_columns_create(BMP280Columns *const columns, const char *path, size_t num_records)
+{
+    memset(columns, 0, sizeof(*columns));
+    static const size_t column_sizes[BMP280_COLUMNS_NUM_COLUMNS] = {8, 4, 4, 4, 1};
+    uint64_t offsets[BMP280_COLUMNS_NUM_COLUMNS];
+    size_t size = BMP280_COLUMNS_HEADER_SIZE;
+    for (size_t c = 0; c < BMP280_COLUMNS_NUM_COLUMNS; c++) {
+        offsets[c] = size;
+        size += column_sizes[c] * num_records;
+    }
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return BMP280_RESULT_CODE_IO_ERR;
+    }
+    if (ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        return BMP280_RESULT_CODE_IO_ERR;
+    }
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return BMP280_RESULT_CODE_IO_ERR;
+    }
+
+    uint8_t *header = (uint8_t *)map;
+    memcpy(header, "BCOL", 4);
+    put_le_u16(&header[4], BMP280_COLUMNS_VERSION);
+    put_le_u16(&header[6], BMP280_COLUMNS_NUM_COLUMNS);
+    put_le_u64(&header[8], num_records);
+    for (size_t c = 0; c < BMP280_COLUMNS_NUM_COLUMNS; c++) {
+        put_le_u64(&header[16 + 8 * c], offsets[c]);
+    }
+    columns->map = header;
+    columns->map_size = size;
+    /* Columns are accessed in host byte order, which the format requires to be little-endian */
+    columns->timestamps_ms = (uint64_t *)(void *)&header[offsets[0]];
+    columns->sensor_ids = (uint32_t *)(void *)&header[offsets[1]];
+    columns->temperatures = (int32_t *)(void *)&header[offsets[2]];
+    columns->pressures = (uint32_t *)(void *)&header[offsets[3]];
+    columns->statuses = &header[offsets[4]];
+    columns->num_records = num_records;
+    return BMP280_RESULT_CODE_OK;
+}
+
+void bmp280_columns_close(BMP280Columns *const columns)
+{
+    if (columns->map) {
+        munmap(columns->map, columns->map_size);
+    }
+    memset(columns, 0, sizeof(*columns));
+}
+
+/**
+ * @brief Remaining chunk range of one worker, on its own cache line.
+ *
+ * Head in the low 32 bits, tail in the high 32 bits. The owner takes chunks from the head, thieves take chunks from the
+ * tail. Both update the whole word with compare-and-swap, so a chunk is never taken twice.
+ */
+typedef struct {
+    uint64_t range;
+    uint8_t padding[56];
+} WorkerRange;
+
+typedef struct {
+    const BMP280RawArchive *archive;
+    const BMP280RecompCalib *calib;
+    const BMP280Columns *columns;
+    size_t chunk_records;
+    size_t num_chunks;
+    size_t num_threads;
+    WorkerRange *ranges;
+} RunShared;
+
+typedef struct {
+    RunShared *shared;
+    size_t id;
+    uint32_t *calib_idx;
+    int32_t *temp_raw;
+    int32_t *pres_raw;
+    BMP280Meas *meas;
+    size_t num_no_calib;
+    size_t num_chunks;
+    size_t num_steals;
+} Worker;
+
+static uint64_t pack_range(uint32_t head, uint32_t tail)
+{
+    return (uint64_t)head | ((uint64_t)tail << 32);
+}
+
+/** Take a chunk from the head (@p from_tail false) or the tail of @p range. @return bool false if it is empty. */
+static bool take_chunk(WorkerRange *range, bool from_tail, uint32_t *chunk)
+{
+    uint64_t cur = __atomic_load_n(&range->range, __ATOMIC_ACQUIRE);
+    for (;;) {
+        uint32_t head = (uint32_t)cur;
+        uint32_t tail = (uint32_t)(cur >> 32);
+        if (head >= tail) {
+            return false;
+        }
+        uint64_t next = from_tail ? pack_range(head, tail - 1) : pack_range(head + 1, tail);
+        if (__atomic_compare_exchange_n(&range->range, &cur, next, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            *chunk = from_tail ? tail - 1 : head;
+            return true;
+        }
+    }
+}
+
+static void compensate_chunk(Worker *w, uint32_t chunk)
+{
+    const RunShared *s = w->shared;
+    size_t first = (size_t)chunk * s->chunk_records;
+    size_t n = s->archive->num_records - first;
+    if (n > s->chunk_records) {
+        n = s->chunk_records;
+    }
+    const uint8_t *rec = &s->archive->records[first * BMP280_RAW_ARCHIVE_RECORD_SIZE];
+    const BMP280Columns *out = s->columns;
+
+    /* Decode into arrays for the gather kernel, and write the pass-through columns on the way */
+    size_t num_no_calib = 0;
+    for (size_t i = 0; i < n; i++, rec += BMP280_RAW_ARCHIVE_RECORD_SIZE) {
+        uint32_t sensor_id = le_u32(&rec[8]);
+        int32_t idx = bmp280_recomp_calib_find(s->calib, sensor_id);
+        out->timestamps_ms[first + i] = le_u64(rec);
+        out->sensor_ids[first + i] = sensor_id;
+        out->statuses[first + i] = (uint8_t)((idx < 0) ? BMP280_RECOMP_STATUS_NO_CALIB : BMP280_RECOMP_STATUS_OK);
+        num_no_calib += (idx < 0) ? 1 : 0;
+        /* Samples without calibration values are compensated with those of sensor 0 and overwritten below */
+        w->calib_idx[i] = (idx < 0) ? 0 : (uint32_t)idx;
+        w->pres_raw[i] = bmp280_raw_val_from_regs(&rec[12]);
+        w->temp_raw[i] = bmp280_raw_val_from_regs(&rec[15]);
+    }
+
+    if (s->calib->num_sensors > 0) {
+        bmp280_compensate_gather(&s->calib->soa, w->calib_idx, w->temp_raw, w->pres_raw, w->meas, n);
+    }
+    bool has_calib = s->calib->num_sensors > 0;
+    for (size_t i = 0; i < n; i++) {
+        bool ok = has_calib && out->statuses[first + i] == BMP280_RECOMP_STATUS_OK;
+        out->temperatures[first + i] = ok ? w->meas[i].temperature : 0;
+        out->pressures[first + i] = ok ? w->meas[i].pressure : 0;
+    }
+    w->num_no_calib += num_no_calib;
+}
+
+static void *worker_main(void *arg)
+{
+    Worker *w = (Worker *)arg;
+    RunShared *s = w->shared;
+    uint32_t chunk;
+    while (take_chunk(&s->ranges[w->id], false, &chunk)) {
+        compensate_chunk(w, chunk);
+        w->num_chunks++;
+    }
+    /* Own range is empty. Steal from the others until all ranges are empty. Chunks are never added, so one pass over
+     * the other workers without a successful steal means that there is no work left. */
+    bool stole;
+    do {
+        stole = false;
+        for (size_t i = 1; i < s->num_threads; i++) {
+            size_t victim = (w->id + i) % s->num_threads;
+            if (take_chunk(&s->ranges[victim], true, &chunk)) {
+                compensate_chunk(w, chunk);
+                w->num_chunks++;
+                w->num_steals++;
+                stole = true;
+                break;
+            }
+        }
+    } while (stole);
+    return NULL;
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static bool worker_alloc(Worker *w, size_t chunk_records)
+{
+    w->calib_idx = malloc(chunk_records * sizeof(uint32_t));
+    w->temp_raw = malloc(chunk_records * sizeof(int32_t));
+    w->pres_raw = malloc(chunk_records * sizeof(int32_t));
+    w->meas = malloc(chunk_records * sizeof(BMP280Meas));
+    return w->calib_idx && w->temp_raw && w->pres_raw && w->meas;
+}
+
+static void worker_free(Worker *w)
+{
+    free(w->calib_idx);
+    free(w->temp_raw);
+    free(w->pres_raw);
+    free(w->meas);
+}
+
+uint8_t bmp280_recomp_run(const BMP280RawArchive *const archive, const BMP280RecompCalib *const calib,
+                          const BMP280Columns *const columns, size_t num_threads, size_t chunk_records,
+                          BMP280RecompStats *const stats)
+{
+    if (!archive || !calib || !columns || !stats || num_threads == 0 || num_threads > BMP280_RECOMP_MAX_THREADS ||
+        chunk_records == 0 || archive->num_records != columns->num_records) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+    size_t num_chunks = (archive->num_records + chunk_records - 1) / chunk_records;
+    if (num_chunks > UINT32_MAX) {
+        return BMP280_RESULT_CODE_INVAL_ARG;
+    }
+
+    RunShared shared = {
+        .archive = archive,
+        .calib = calib,
+        .columns = columns,
+        .chunk_records = chunk_records,
+        .num_chunks = num_chunks,
+        .num_threads = num_threads,
+        .ranges = NULL,
+    };
+    Worker *workers = calloc(num_threads, sizeof(Worker));
+    pthread_t *threads = calloc(num_threads, sizeof(pthread_t));
+    void *ranges_mem = NULL;
+    bool ok = workers && threads && posix_memalign(&ranges_mem, 64, num_threads * sizeof(WorkerRange)) == 0;
+    shared.ranges = (WorkerRange *)ranges_mem;
+    for (size_t i = 0; ok && i < num_threads; i++) {
+        /* Equal contiguous ranges, so that without stealing every worker reads its own part of the archive */
+        shared.ranges[i].range = pack_range((uint32_t)(num_chunks * i / num_threads),
+                                            (uint32_t)(num_chunks * (i + 1) / num_threads));
+        workers[i].shared = &shared;
+        workers[i].id = i;
+        ok = worker_alloc(&workers[i], chunk_records);
+    }
+
+    size_t num_started = 0;
+    double start = now_seconds();
+    if (ok) {
+        /* Worker 0 runs on the calling thread */
+        for (size_t i = 1; i < num_threads; i++) {
+            if (pthread_create(&threads[i], NULL, worker_main, &workers[i]) != 0) {
+                ok = false;
+                break;
+            }
+            num_started++;
+        }
+        worker_main(&workers[0]);
+        for (size_t i = 1; i <= num_started; i++) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+    double end = now_seconds();
+
+    memset(stats, 0, sizeof(*stats));
+    stats->num_records = archive->num_records;
+    stats->seconds = end - start;
+    for (size_t i = 0; workers && i < num_threads; i++) {
+        stats->num_no_calib += workers[i].num_no_calib;
+        stats->num_chunks += workers[i].num_chunks;
+        stats->num_steals += workers[i].num_steals;
+        worker_free(&workers[i]);
+    }
+    free(ranges_mem);
+    free(threads);
+    free(workers);
+    return ok ? BMP280_RESULT_CODE_OK : BMP280_RESULT_CODE_NO_MEM;
+}
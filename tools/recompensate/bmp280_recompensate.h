@@ -0,0 +1,194 @@
+#ifndef TOOLS_RECOMPENSATE_BMP280_RECOMPENSATE_H
+#define TOOLS_RECOMPENSATE_BMP280_RECOMPENSATE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "bmp280.h"
+#include "bmp280_compensate.h"
+
+/**
+ * @brief Offline recompensation of archived raw samples on Linux.
+ *
+ * Reprocesses raw sample archives after calibration values were corrected, or after the compensation backend changed.
+ * The archive is memory-mapped and split into chunks of records. Worker threads compensate the chunks with
+ * @ref bmp280_compensate_gather and write the results straight into a memory-mapped columnar output file. Every worker
+ * starts with an equal, contiguous range of chunks, takes chunks from the front of its own range, and steals chunks
+ * from the back of other workers' ranges once its own range is empty. Chunks are independent, so throughput scales
+ * with the number of cores until memory bandwidth runs out.
+ *
+ * Raw archive layout, all multi-byte fields little-endian:
+ * - header (16 bytes): magic "BRAW", version (u16), record size (u16), 8 reserved bytes
+ * - records (BMP280_RAW_ARCHIVE_RECORD_SIZE bytes each): timestamp in ms (u64), sensor id (u32), contents of
+ * registers 0xF7...0xFC (6 bytes), 2 reserved bytes
+ *
+ * Columnar output layout, all multi-byte fields little-endian:
+ * - header (64 bytes): magic "BCOL", version (u16), number of columns (u16), number of records (u64), then the file
+ * offset of each column (u64 each), zero padded
+ * - columns, in this order: timestamp in ms (u64), sensor id (u32), temperature in 0.01 DegC (i32), pressure in Pa in
+ * Q24.8 format (u32), status (u8, one of @ref BMP280RecompStatus)
+ *
+ * Calibration file: one line per sensor, "<sensor id> <48 hex digits>", where the hex digits are the contents of
+ * calibration registers 0x88...0x9F. Empty lines and lines starting with '#' are ignored.
+ */
+
+#define BMP280_RAW_ARCHIVE_HEADER_SIZE 16
+#define BMP280_RAW_ARCHIVE_RECORD_SIZE 20
+#define BMP280_RAW_ARCHIVE_VERSION 1
+#define BMP280_COLUMNS_HEADER_SIZE 64
+#define BMP280_COLUMNS_VERSION 1
+#define BMP280_COLUMNS_NUM_COLUMNS 5
+
+/** Default number of records per chunk. */
+#define BMP280_RECOMP_DEFAULT_CHUNK_RECORDS 65536
+
+/** Maximum number of worker threads. */
+#define BMP280_RECOMP_MAX_THREADS 256
+
+typedef enum {
+    /** Temperature and pressure were compensated. */
+    BMP280_RECOMP_STATUS_OK = 0,
+    /** The calibration file has no entry for the sensor. Temperature and pressure are 0. */
+    BMP280_RECOMP_STATUS_NO_CALIB,
+} BMP280RecompStatus;
+
+/**
+ * @brief Calibration values of all sensors, and a hash table from sensor id to index into the calibration values.
+ *
+ * Memory is allocated by @ref bmp280_recomp_calib_init and freed by @ref bmp280_recomp_calib_deinit.
+ */
+typedef struct {
+    BMP280CalibSoA soa;
+    size_t num_sensors;
+    /** Open addressing hash table, power of two slots. */
+    uint32_t *slot_ids;
+    /** Index into soa of the sensor in each slot, -1 for empty slots. */
+    int32_t *slot_idxs;
+    size_t num_slots;
+} BMP280RecompCalib;
+
+/** Memory-mapped raw archive. */
+typedef struct {
+    const uint8_t *map;
+    size_t map_size;
+    /** First record. */
+    const uint8_t *records;
+    size_t num_records;
+} BMP280RawArchive;
+
+/** Memory-mapped columnar output. */
+typedef struct {
+    uint8_t *map;
+    size_t map_size;
+    uint64_t *timestamps_ms;
+    uint32_t *sensor_ids;
+    int32_t *temperatures;
+    uint32_t *pressures;
+    uint8_t *statuses;
+    size_t num_records;
+} BMP280Columns;
+
+/** Result of @ref bmp280_recomp_run. */
+typedef struct {
+    size_t num_records;
+    size_t num_no_calib;
+    size_t num_chunks;
+    /** Chunks that were compensated by another worker than the one whose range they started in. */
+    size_t num_steals;
+    double seconds;
+} BMP280RecompStats;
+
+/**
+ * @brief Allocate an empty calibration table for up to @p max_sensors sensors.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully allocated @p calib.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG @p calib is NULL or @p max_sensors is 0.
+ * @retval BMP280_RESULT_CODE_NO_MEM Allocation failed.
+ */
+uint8_t bmp280_recomp_calib_init(BMP280RecompCalib *const calib, size_t max_sensors);
+
+/**
+ * @brief Free the memory of @p calib.
+ */
+void bmp280_recomp_calib_deinit(BMP280RecompCalib *const calib);
+
+/**
+ * @brief Add or replace the calibration values of a sensor.
+ *
+ * @param[in] calib Calibration table.
+ * @param[in] sensor_id Sensor id, as in the raw archive.
+ * @param[in] regs Contents of calibration registers 0x88...0x9F, 24 bytes.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully added the sensor.
+ * @retval BMP280_RESULT_CODE_NO_MEM The table already holds max_sensors sensors.
+ */
+uint8_t bmp280_recomp_calib_add(BMP280RecompCalib *const calib, uint32_t sensor_id, const uint8_t *const regs);
+
+/**
+ * @brief Index of the calibration values of @p sensor_id in calib->soa, or -1 if the sensor has none.
+ */
+int32_t bmp280_recomp_calib_find(const BMP280RecompCalib *const calib, uint32_t sensor_id);
+
+/**
+ * @brief Read a calibration file into a new calibration table.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully read the file.
+ * @retval BMP280_RESULT_CODE_IO_ERR The file cannot be read, or a line is malformed.
+ * @retval BMP280_RESULT_CODE_NO_MEM Allocation failed.
+ */
+uint8_t bmp280_recomp_calib_load(BMP280RecompCalib *const calib, const char *path);
+
+/**
+ * @brief Memory-map a raw archive read-only and validate its header.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully mapped the archive.
+ * @retval BMP280_RESULT_CODE_IO_ERR The file cannot be mapped, or is not a raw archive of a supported version.
+ */
+uint8_t bmp280_raw_archive_open(BMP280RawArchive *const archive, const char *path);
+
+void bmp280_raw_archive_close(BMP280RawArchive *const archive);
+
+/**
+ * @brief Create a columnar output file for @p num_records records and memory-map it.
+ *
+ * The header is written, the columns are filled by @ref bmp280_recomp_run.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully created the file.
+ * @retval BMP280_RESULT_CODE_IO_ERR The file cannot be created or mapped.
+ */
+uint8_t bmp280_columns_create(BMP280Columns *const columns, const char *path, size_t num_records);
+
+/**
+ * @brief Unmap @p columns. Its contents are written back to the file by the kernel.
+ */
+void bmp280_columns_close(BMP280Columns *const columns);
+
+/**
+ * @brief Compensate every record of @p archive into @p columns on @p num_threads threads.
+ *
+ * @param[in] archive Raw archive.
+ * @param[in] calib Calibration values.
+ * @param[in] columns Output with as many records as @p archive.
+ * @param[in] num_threads Number of worker threads, 1...BMP280_RECOMP_MAX_THREADS.
+ * @param[in] chunk_records Number of records per chunk, at least 1.
+ * @param[out] stats Statistics of the run.
+ *
+ * @retval BMP280_RESULT_CODE_OK Successfully compensated all records.
+ * @retval BMP280_RESULT_CODE_INVAL_ARG A pointer is NULL, @p num_threads or @p chunk_records is out of range, or the
+ * record counts of @p archive and @p columns differ.
+ * @retval BMP280_RESULT_CODE_NO_MEM Allocation of worker buffers or starting a thread failed.
+ */
+uint8_t bmp280_recomp_run(const BMP280RawArchive *const archive, const BMP280RecompCalib *const calib,
+                          const BMP280Columns *const columns, size_t num_threads, size_t chunk_records,
+                          BMP280RecompStats *const stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOOLS_RECOMPENSATE_BMP280_RECOMPENSATE_H */
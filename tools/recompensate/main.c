@@ -0,0 +1,192 @@
+/**
+ * @brief Command line front end of the offline recompensation tool.
+ *
+ * bmp280_recompensate [-j threads] [-c chunk_records] [-s] CALIB ARCHIVE OUTPUT
+ *   Compensate every record of ARCHIVE with the calibration values in CALIB, and write the results to OUTPUT.
+ *   -s runs with 1, 2, 4, ... threads up to the -j value, and prints the throughput of every run.
+ *
+ * bmp280_recompensate --generate NUM_RECORDS NUM_SENSORS CALIB ARCHIVE
+ *   Write a synthetic calibration file and raw archive for benchmarking.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bmp280_recompensate.h"
+
+/** Calibration registers of the datasheet example, varied per sensor when generating. */
+static const uint8_t datasheet_calib[24] = {0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC, 0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B,
+                                            0x27, 0x0B, 0x8C, 0x00, 0xF9, 0xFF, 0x8C, 0x3C, 0xF8, 0xC6, 0x70, 0x17};
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: bmp280_recompensate [-j threads] [-c chunk_records] [-s] CALIB ARCHIVE OUTPUT\n"
+                    "       bmp280_recompensate --generate NUM_RECORDS NUM_SENSORS CALIB ARCHIVE\n");
+}
+
+static uint32_t xorshift32(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static void put_raw_val(uint8_t *p, uint32_t raw)
+{
+    p[0] = (uint8_t)(raw >> 12);
+    p[1] = (uint8_t)(raw >> 4);
+    p[2] = (uint8_t)((raw & 0xF) << 4);
+}
+
+static int generate(size_t num_records, uint32_t num_sensors, const char *calib_path, const char *archive_path)
+{
+    FILE *calib_file = fopen(calib_path, "w");
+    if (!calib_file) {
+        perror(calib_path);
+        return 1;
+    }
+    uint32_t rng = 0x2545F491;
+    fprintf(calib_file, "# Generated by bmp280_recompensate --generate\n");
+    for (uint32_t id = 0; id < num_sensors; id++) {
+        uint8_t regs[24];
+        memcpy(regs, datasheet_calib, sizeof(regs));
+        /* Vary the low bytes of dig_T1 and dig_P1 (never 0), so that sensors differ like real parts */
+        regs[0] = (uint8_t)xorshift32(&rng);
+        regs[6] = (uint8_t)(xorshift32(&rng) | 1);
+        fprintf(calib_file, "%u ", id);
+        for (size_t i = 0; i < sizeof(regs); i++) {
+            fprintf(calib_file, "%02X", regs[i]);
+        }
+        fprintf(calib_file, "\n");
+    }
+    fclose(calib_file);
+
+    FILE *archive_file = fopen(archive_path, "wb");
+    if (!archive_file) {
+        perror(archive_path);
+        return 1;
+    }
+    uint8_t header[BMP280_RAW_ARCHIVE_HEADER_SIZE] = {'B', 'R', 'A', 'W', BMP280_RAW_ARCHIVE_VERSION, 0,
+                                                      BMP280_RAW_ARCHIVE_RECORD_SIZE, 0};
+    fwrite(header, 1, sizeof(header), archive_file);
+    for (size_t i = 0; i < num_records; i++) {
+        /* Sensors report round robin once per second */
+        uint64_t ts_ms = 1000 * (uint64_t)(i / num_sensors);
+        uint32_t id = (uint32_t)(i % num_sensors);
+        uint8_t rec[BMP280_RAW_ARCHIVE_RECORD_SIZE] = {0};
+        for (size_t b = 0; b < 8; b++) {
+            rec[b] = (uint8_t)(ts_ms >> (8 * b));
+        }
+        for (size_t b = 0; b < 4; b++) {
+            rec[8 + b] = (uint8_t)(id >> (8 * b));
+        }
+        /* Around the raw values of the datasheet example */
+        put_raw_val(&rec[12], 415148 + (xorshift32(&rng) % 4096) - 2048);
+        put_raw_val(&rec[15], 519888 + (xorshift32(&rng) % 4096) - 2048);
+        fwrite(rec, 1, sizeof(rec), archive_file);
+    }
+    if (fclose(archive_file) != 0) {
+        perror(archive_path);
+        return 1;
+    }
+    return 0;
+}
+
+static void print_stats(size_t num_threads, const BMP280RecompStats *stats)
+{
+    double mb = (double)(stats->num_records * BMP280_RAW_ARCHIVE_RECORD_SIZE) / 1e6;
+    printf("threads %3zu: %zu records, %.1f MB in %.3f s, %.2f GB/s, %.1f M records/s, %zu chunks, %zu stolen, "
+           "%zu without calibration\n",
+           num_threads, stats->num_records, mb, stats->seconds, mb / 1e3 / stats->seconds,
+           (double)stats->num_records / 1e6 / stats->seconds, stats->num_chunks, stats->num_steals,
+           stats->num_no_calib);
+}
+
+/** Thread count of the scaling run after @p n threads: doubled, but the last run uses @p max threads. */
+static size_t next_num_threads(size_t n, size_t max)
+{
+    if (n < max && 2 * n > max) {
+        return max;
+    }
+    return 2 * n;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 6 && strcmp(argv[1], "--generate") == 0) {
+        size_t num_sensors = strtoul(argv[3], NULL, 0);
+        if (num_sensors == 0 || num_sensors > UINT32_MAX) {
+            usage();
+            return 2;
+        }
+        return generate(strtoul(argv[2], NULL, 0), (uint32_t)num_sensors, argv[4], argv[5]);
+    }
+
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t num_threads = (num_cpus > 0) ? (size_t)num_cpus : 1;
+    size_t chunk_records = BMP280_RECOMP_DEFAULT_CHUNK_RECORDS;
+    bool scaling = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "j:c:s")) != -1) {
+        switch (opt) {
+        case 'j':
+            num_threads = strtoul(optarg, NULL, 0);
+            break;
+        case 'c':
+            chunk_records = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            scaling = true;
+            break;
+        default:
+            usage();
+            return 2;
+        }
+    }
+    if (argc - optind != 3 || num_threads == 0 || num_threads > BMP280_RECOMP_MAX_THREADS || chunk_records == 0) {
+        usage();
+        return 2;
+    }
+
+    BMP280RecompCalib calib;
+    if (bmp280_recomp_calib_load(&calib, argv[optind]) != BMP280_RESULT_CODE_OK) {
+        fprintf(stderr, "Cannot load calibration file %s\n", argv[optind]);
+        return 1;
+    }
+    BMP280RawArchive archive;
+    if (bmp280_raw_archive_open(&archive, argv[optind + 1]) != BMP280_RESULT_CODE_OK) {
+        fprintf(stderr, "Cannot open raw archive %s\n", argv[optind + 1]);
+        bmp280_recomp_calib_deinit(&calib);
+        return 1;
+    }
+    BMP280Columns columns;
+    if (bmp280_columns_create(&columns, argv[optind + 2], archive.num_records) != BMP280_RESULT_CODE_OK) {
+        fprintf(stderr, "Cannot create output %s\n", argv[optind + 2]);
+        bmp280_raw_archive_close(&archive);
+        bmp280_recomp_calib_deinit(&calib);
+        return 1;
+    }
+
+    int ret = 0;
+    /* With -s: 1, 2, 4, ... threads, and the -j value last */
+    for (size_t n = scaling ? 1 : num_threads; n <= num_threads; n = next_num_threads(n, num_threads)) {
+        BMP280RecompStats stats;
+        if (bmp280_recomp_run(&archive, &calib, &columns, n, chunk_records, &stats) != BMP280_RESULT_CODE_OK) {
+            fprintf(stderr, "Recompensation with %zu threads failed\n", n);
+            ret = 1;
+            break;
+        }
+        print_stats(n, &stats);
+    }
+
+    bmp280_columns_close(&columns);
+    bmp280_raw_archive_close(&archive);
+    bmp280_recomp_calib_deinit(&calib);
+    return ret;
+}